@@ -0,0 +1,77 @@
+// Measures compile_commands.json ingestion throughput on a synthetic database.
+// Usage: compile_commands_benchmark [size_in_mb] [path]
+// With a path, that existing database is measured instead.
+
+#include <chrono>
+#include <filesystem>
+#include <finch/analyzer/compile_database.hpp>
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+fs::path write_synthetic_database(size_t target_bytes) {
+    auto path = fs::temp_directory_path() / "finch_compile_commands_benchmark.json";
+    std::ofstream out(path, std::ios::binary);
+    out << "[\n";
+
+    size_t written = 0;
+    for (size_t i = 0; written < target_bytes; ++i) {
+        std::string target = fmt::format("lib{}", i / 50);
+        std::string entry = fmt::format(
+            R"({{"directory": "/work/build", "command": "/usr/bin/c++ -DFOO=1 -DBAR=\"baz\" )"
+            R"(-I/work/src/include -I/work/build/generated -isystem /opt/deps/include )"
+            R"(-O2 -g -std=c++20 -fPIC -Wall -Wextra -o CMakeFiles/{0}.dir/src/file{1}.cpp.o )"
+            R"(-c /work/src/{0}/file{1}.cpp", "file": "/work/src/{0}/file{1}.cpp", )"
+            R"("output": "CMakeFiles/{0}.dir/src/file{1}.cpp.o"}})",
+            target, i);
+        if (i > 0) {
+            out << ",\n";
+        }
+        out << entry;
+        written += entry.size() + 2;
+    }
+    out << "\n]\n";
+    return path;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 200;
+    bool synthetic = argc <= 2;
+    fs::path path = synthetic ? write_synthetic_database(megabytes << 20) : fs::path(argv[2]);
+    double size_mb = static_cast<double>(fs::file_size(path)) / (1 << 20);
+
+    auto start = std::chrono::steady_clock::now();
+    auto database = CompileDatabase::load(path);
+    auto parsed = std::chrono::steady_clock::now();
+    if (!database.has_value()) {
+        std::cerr << database.error().message() << "\n";
+        return 1;
+    }
+
+    CompileDatabaseAnalyzer analyzer;
+    auto analysis = analyzer.analyze(database.value());
+    auto analyzed = std::chrono::steady_clock::now();
+
+    auto seconds = [](auto from, auto to) { return std::chrono::duration<double>(to - from).count(); };
+    std::cout << fmt::format("{:.1f} MB, {} entries, {} targets\n", size_mb,
+                             database.value().entries().size(), analysis.targets.size());
+    std::cout << fmt::format("JSON scan:      {:.3f} s ({:.2f} GB/s)\n", seconds(start, parsed),
+                             size_mb / 1024 / seconds(start, parsed));
+    std::cout << fmt::format("Target grouping: {:.3f} s\n", seconds(parsed, analyzed));
+    std::cout << fmt::format("Total:          {:.3f} s ({:.2f} GB/s)\n", seconds(start, analyzed),
+                             size_mb / 1024 / seconds(start, analyzed));
+
+    if (synthetic) {
+        fs::remove(path);
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Times the first recursive glob over a wide tree against the overlapping
+// globs that follow it and are answered from the snapshot.
+// Usage: directory_snapshot_benchmark [modules]
+
+#include <chrono>
+#include <filesystem>
+#include <finch/analyzer/directory_snapshot.hpp>
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace finch::analyzer;
+namespace fs = std::filesystem;
+
+namespace {
+
+double microseconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// modules of 3 levels, 25 files each
+fs::path write_tree(size_t modules) {
+    auto root = fs::temp_directory_path() / "finch_directory_snapshot_benchmark";
+    fs::remove_all(root);
+    for (size_t module = 0; module < modules; ++module) {
+        auto directory = root / fmt::format("modules/m{}", module);
+        for (size_t level = 0; level < 3; ++level) {
+            fs::create_directories(directory);
+            for (size_t i = 0; i < 25; ++i) {
+                std::ofstream(directory / fmt::format("file{}.{}", i, i % 2 ? "cpp" : "h"));
+            }
+            directory /= fmt::format("d{}", level);
+        }
+    }
+    return root;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t modules = argc > 1 ? std::stoul(argv[1]) : 400;
+    auto root = write_tree(modules);
+
+    DirectorySnapshot snapshot;
+    DirectorySnapshot::Options recurse{.recurse = true, .list_directories = false};
+    auto start = std::chrono::steady_clock::now();
+    auto first = snapshot.glob(root / "modules/*.cpp", recurse);
+    double first_us = microseconds_since(start);
+    auto read = snapshot.stats().directories_read;
+
+    // One glob per module, then one across all of them
+    size_t matched = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t module = 0; module < modules; ++module) {
+        matched += snapshot.glob(root / fmt::format("modules/m{}/*.h", module), recurse).size();
+    }
+    matched += snapshot.glob(root / "modules/*/d0/*.cpp", recurse).size();
+    double rest_us = microseconds_since(start);
+
+    std::cout << fmt::format("{} modules, {} files\n", modules, modules * 3 * 25);
+    std::cout << fmt::format("First glob:  {:10.0f} us  {} matches, {} directories read\n",
+                             first_us, first.size(), read);
+    std::cout << fmt::format("Cached glob: {:10.1f} us  {} matches over {} globs, {} more read\n",
+                             rest_us / static_cast<double>(modules + 1), matched, modules + 1,
+                             snapshot.stats().directories_read - read);
+    fs::remove_all(root);
+    return 0;
+}
@@ -0,0 +1,193 @@
+// Compares KeywordSchema::partition() with the per-keyword rescans it replaced
+// on argument-heavy calls.
+// Usage: keyword_schema_benchmark [items] [rounds]
+
+#include <chrono>
+#include <cstdlib>
+#include <finch/parser/keyword_schema.hpp>
+#include <fmt/format.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace finch::parser;
+
+namespace {
+
+constexpr KeywordSchema<21> ADD_PACKAGE_SCHEMA({{
+    {"NAME", KeywordKind::OneValue},
+    {"FORCE", KeywordKind::OneValue},
+    {"VERSION", KeywordKind::OneValue},
+    {"GIT_TAG", KeywordKind::OneValue},
+    {"DOWNLOAD_ONLY", KeywordKind::OneValue},
+    {"GITHUB_REPOSITORY", KeywordKind::OneValue},
+    {"GITLAB_REPOSITORY", KeywordKind::OneValue},
+    {"BITBUCKET_REPOSITORY", KeywordKind::OneValue},
+    {"GIT_REPOSITORY", KeywordKind::OneValue},
+    {"SOURCE_DIR", KeywordKind::OneValue},
+    {"FIND_PACKAGE_ARGUMENTS", KeywordKind::OneValue},
+    {"NO_CACHE", KeywordKind::OneValue},
+    {"SYSTEM", KeywordKind::OneValue},
+    {"GIT_SHALLOW", KeywordKind::OneValue},
+    {"EXCLUDE_FROM_ALL", KeywordKind::OneValue},
+    {"SOURCE_SUBDIR", KeywordKind::OneValue},
+    {"CUSTOM_CACHE_KEY", KeywordKind::OneValue},
+    {"URL", KeywordKind::MultiValue},
+    {"OPTIONS", KeywordKind::MultiValue},
+    {"DOWNLOAD_COMMAND", KeywordKind::MultiValue},
+    {"PATCHES", KeywordKind::MultiValue},
+}});
+
+constexpr KeywordSchema<3> USAGE_SCHEMA({{
+    {"PUBLIC", KeywordKind::MultiValue},
+    {"PRIVATE", KeywordKind::MultiValue},
+    {"INTERFACE", KeywordKind::MultiValue},
+}});
+
+// The word as the old parser read it: get_string_value() returned a copy
+std::string string_value(const std::string& word) {
+    return word;
+}
+
+// The old find_argument(): a scan of every argument per keyword looked up
+const std::string* find_argument(const std::vector<std::string>& args, const std::string& name) {
+    for (const auto& arg : args) {
+        if (string_value(arg) == name) {
+            return &arg;
+        }
+    }
+    return nullptr;
+}
+
+// The old collect_arguments_after(): everything after the keyword
+std::vector<std::string> collect_arguments_after(const std::vector<std::string>& args,
+                                                 const std::string& key) {
+    std::vector<std::string> result;
+    bool found_key = false;
+    for (const auto& arg : args) {
+        if (found_key) {
+            result.push_back(arg);
+        } else if (string_value(arg) == key) {
+            found_key = true;
+        }
+    }
+    return result;
+}
+
+// What CPMAddPackage() and CPMDeclarePackage() read before partition(): a
+// lookup per keyword, then the values after OPTIONS up to the next keyword
+size_t rescan_add_package(const std::vector<std::string>& args) {
+    static const char* keywords[] = {
+        "NAME",
+        "VERSION",
+        "GIT_TAG",
+        "GITHUB_REPOSITORY",
+        "GIT_REPOSITORY",
+        "URL",
+        "OPTIONS",
+        "SOURCE_DIR",
+        "DOWNLOAD_ONLY",
+        "EXCLUDE_FROM_ALL",
+        "SYSTEM",
+        "NO_CACHE",
+        "GIT_SHALLOW",
+    };
+    size_t found = 0;
+    for (const char* keyword : keywords) {
+        if (find_argument(args, keyword) != nullptr) {
+            ++found;
+        }
+    }
+    size_t options = 0;
+    for (const auto& value : collect_arguments_after(args, "OPTIONS")) {
+        if (value == "DOWNLOAD_ONLY" || value == "EXCLUDE_FROM_ALL" || value == "SYSTEM" ||
+            value == "NO_CACHE") {
+            break;
+        }
+        ++options;
+    }
+    return found + options;
+}
+
+size_t partition_add_package(const std::vector<std::string>& args) {
+    auto parsed = ADD_PACKAGE_SCHEMA.partition(args);
+    size_t found = 0;
+    for (size_t slot = 0; slot < ADD_PACKAGE_SCHEMA.size(); ++slot) {
+        if (parsed.has(slot)) {
+            ++found;
+        }
+    }
+    return found + parsed.values(ADD_PACKAGE_SCHEMA.slot("OPTIONS")).size();
+}
+
+// What target_link_libraries() did before partition(): a string comparison
+// per word against every visibility keyword
+size_t compare_usage(const std::vector<std::string>& args) {
+    size_t items = 0;
+    for (size_t i = 1; i < args.size(); ++i) {
+        const auto& word = args[i];
+        if (word != "PUBLIC" && word != "PRIVATE" && word != "INTERFACE") {
+            ++items;
+        }
+    }
+    return items;
+}
+
+size_t partition_usage(const std::vector<std::string>& args) {
+    return USAGE_SCHEMA.partition(args, 1).values({0, 1, 2}).size();
+}
+
+template <typename Read>
+double ns_per_word(const std::vector<std::string>& args, size_t rounds, size_t expected,
+                   Read&& read) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; ++round) {
+        if (read(args) != expected) {
+            std::cerr << "readers disagree\n";
+            std::exit(1);
+        }
+    }
+    auto elapsed =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+    return elapsed.count() / static_cast<double>(rounds * args.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t items = argc > 1 ? std::stoul(argv[1]) : 50000;
+    size_t rounds = argc > 2 ? std::stoul(argv[2]) : 20;
+
+    // CPMAddPackage(NAME ... VERSION ... GITHUB_REPOSITORY ... OPTIONS <items> SYSTEM YES)
+    std::vector<std::string> add_package = {
+        "NAME", "fmt", "VERSION", "10.2.1", "GITHUB_REPOSITORY", "fmtlib/fmt", "OPTIONS"};
+    for (size_t i = 0; i < items; ++i) {
+        add_package.push_back(fmt::format("FMT_OPTION_{}=ON", i));
+    }
+    add_package.insert(add_package.end(), {"SYSTEM", "YES"});
+
+    // target_link_libraries(app PUBLIC ... PRIVATE ... INTERFACE ...)
+    std::vector<std::string> usage = {"app"};
+    const char* visibilities[] = {"PUBLIC", "PRIVATE", "INTERFACE"};
+    for (size_t i = 0; i < items; ++i) {
+        if (i % 100 == 0) {
+            usage.emplace_back(visibilities[(i / 100) % 3]);
+        }
+        usage.push_back(fmt::format("lib{}", i));
+    }
+
+    auto add_expected = partition_add_package(add_package);
+    double add_rescan = ns_per_word(add_package, rounds, add_expected, rescan_add_package);
+    double add_partition = ns_per_word(add_package, rounds, add_expected, partition_add_package);
+    double usage_compare = ns_per_word(usage, rounds, items, compare_usage);
+    double usage_partition = ns_per_word(usage, rounds, items, partition_usage);
+
+    std::cout << fmt::format("{} items, {} rounds\n", items, rounds);
+    std::cout << fmt::format("CPMAddPackage         rescans: {:6.1f} ns/word  partition: {:6.1f} "
+                             "ns/word  ({:.1f}x)\n",
+                             add_rescan, add_partition, add_rescan / add_partition);
+    std::cout << fmt::format("target_link_libraries compare: {:6.1f} ns/word  partition: {:6.1f} "
+                             "ns/word  ({:.1f}x)\n",
+                             usage_compare, usage_partition, usage_compare / usage_partition);
+    return 0;
+}
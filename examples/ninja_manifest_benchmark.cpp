@@ -0,0 +1,102 @@
+// Measures build.ninja ingestion throughput on a synthetic CMake-style manifest.
+// Usage: ninja_manifest_benchmark [size_in_mb] [path]
+// With a path, that existing manifest (and whatever it includes) is measured instead.
+
+#include <chrono>
+#include <filesystem>
+#include <finch/analyzer/ninja_manifest.hpp>
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Mirrors what CMake's Ninja generator writes: per-target rules in a
+// separate rules.ninja, one compile edge per source and one link edge
+fs::path write_synthetic_manifest(size_t target_bytes) {
+    auto dir = fs::temp_directory_path() / "finch_ninja_benchmark";
+    fs::create_directories(dir);
+    std::ofstream rules(dir / "rules.ninja", std::ios::binary);
+    std::ofstream out(dir / "build.ninja", std::ios::binary);
+    out << "ninja_required_version = 1.5\nCONFIGURATION = Release\ninclude rules.ninja\n\n";
+
+    size_t written = 0;
+    for (size_t t = 0; written < target_bytes; ++t) {
+        rules << fmt::format(
+            "rule CXX_COMPILER__lib{0}_Release\n"
+            "  depfile = $DEP_FILE\n  deps = gcc\n"
+            "  command = ${{LAUNCHER}}${{CODE_CHECK}}/usr/bin/c++ $DEFINES $INCLUDES $FLAGS "
+            "-MD -MT $out -MF $DEP_FILE -o $out -c $in\n"
+            "rule CXX_STATIC_LIBRARY_LINKER__lib{0}_Release\n"
+            "  command = $PRE_LINK && ar qc $TARGET_FILE $LINK_FLAGS $in && $POST_BUILD\n",
+            t);
+
+        std::string objects;
+        for (size_t i = 0; i < 50; ++i) {
+            std::string object = fmt::format("src/lib{0}/CMakeFiles/lib{0}.dir/file{1}.cpp.o", t, i);
+            std::string edge = fmt::format(
+                "build {2}: CXX_COMPILER__lib{0}_Release /work/src/lib{0}/file{1}.cpp || "
+                "cmake_object_order_depends_target_lib{0}\n"
+                "  DEFINES = -DFOO=1 -DLIB{0}_EXPORTS\n"
+                "  DEP_FILE = {2}.d\n"
+                "  FLAGS = -O2 -g -std=c++20 -fPIC -Wall -Wextra\n"
+                "  INCLUDES = -I/work/src/include -I/work/build/generated -isystem /opt/deps/include\n"
+                "  OBJECT_DIR = src/lib{0}/CMakeFiles/lib{0}.dir\n"
+                "  OBJECT_FILE_DIR = src/lib{0}/CMakeFiles/lib{0}.dir\n\n",
+                t, i, object);
+            out << edge;
+            written += edge.size();
+            objects += " " + object;
+        }
+        std::string link = fmt::format(
+            "build src/lib{0}/liblib{0}.a: CXX_STATIC_LIBRARY_LINKER__lib{0}_Release{1}\n"
+            "  OBJECT_DIR = src/lib{0}/CMakeFiles/lib{0}.dir\n"
+            "  POST_BUILD = :\n  PRE_LINK = :\n"
+            "  TARGET_FILE = src/lib{0}/liblib{0}.a\n\n",
+            t, objects);
+        out << link;
+        written += link.size();
+    }
+    return dir / "build.ninja";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? std::stoul(argv[1]) : 100;
+    bool synthetic = argc <= 2;
+    fs::path path = synthetic ? write_synthetic_manifest(megabytes << 20) : fs::path(argv[2]);
+    double size_mb = static_cast<double>(fs::file_size(path)) / (1 << 20);
+
+    auto start = std::chrono::steady_clock::now();
+    auto manifest = NinjaManifest::load(path);
+    auto parsed = std::chrono::steady_clock::now();
+    if (!manifest.has_value()) {
+        std::cerr << manifest.error().message() << "\n";
+        return 1;
+    }
+
+    NinjaManifestAnalyzer analyzer;
+    auto analysis = analyzer.analyze(manifest.value());
+    auto analyzed = std::chrono::steady_clock::now();
+
+    auto seconds = [](auto from, auto to) { return std::chrono::duration<double>(to - from).count(); };
+    std::cout << fmt::format("{:.1f} MB, {} edges, {} interned paths, {} targets\n", size_mb,
+                             manifest.value().edges().size(), manifest.value().interned_paths(),
+                             analysis.targets.size());
+    std::cout << fmt::format("Manifest parse:  {:.3f} s ({:.0f} MB/s)\n", seconds(start, parsed),
+                             size_mb / seconds(start, parsed));
+    std::cout << fmt::format("Target recovery: {:.3f} s\n", seconds(parsed, analyzed));
+    std::cout << fmt::format("Total:           {:.3f} s ({:.0f} MB/s)\n", seconds(start, analyzed),
+                             size_mb / seconds(start, analyzed));
+
+    if (synthetic) {
+        fs::remove_all(path.parent_path());
+    }
+    return 0;
+}
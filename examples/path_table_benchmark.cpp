@@ -0,0 +1,64 @@
+// Measures interning a large project's source paths into the shared
+// PathTable, looking them up again, and the memory they take against the
+// std::string spellings.
+// Usage: path_table_benchmark [files] [directories]
+
+#include <chrono>
+#include <finch/core/path_table.hpp>
+#include <fmt/format.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace finch;
+
+namespace {
+
+double nanoseconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t files = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t directories = argc > 2 ? std::stoul(argv[2]) : 400;
+
+    std::vector<std::string> spellings;
+    spellings.reserve(files);
+    for (size_t i = 0; i < files; ++i) {
+        spellings.push_back(fmt::format("/work/monorepo/components/module{}/src/detail/file{}.cpp",
+                                        i % directories, i));
+    }
+    size_t string_bytes = 0;
+    for (const auto& spelling : spellings) {
+        string_bytes += sizeof(std::string) + spelling.capacity() + 1;
+    }
+    auto before = PathTable::shared().stats();
+
+    auto start = std::chrono::steady_clock::now();
+    PathList sources(spellings.begin(), spellings.end());
+    double intern = nanoseconds_since(start);
+    auto after = PathTable::shared().stats();
+
+    start = std::chrono::steady_clock::now();
+    PathList again(spellings.begin(), spellings.end());
+    double lookup = nanoseconds_since(start);
+    if (again != sources) {
+        std::cerr << "interning is not stable\n";
+        return 1;
+    }
+
+    size_t interned_bytes = sources.size() * sizeof(PathId) + after.table_bytes - before.table_bytes;
+    double count = static_cast<double>(files);
+    std::cout << fmt::format("{} files over {} directories; {}\n", files, directories,
+                             after.to_string());
+    std::cout << fmt::format("Intern: {:6.0f} ns/path\n", intern / count);
+    std::cout << fmt::format("Lookup: {:6.0f} ns/path\n", lookup / count);
+    std::cout << fmt::format("Memory: {} bytes as strings, {} interned ({:.2f}x)\n", string_bytes,
+                             interned_bytes,
+                             static_cast<double>(string_bytes) /
+                                 static_cast<double>(interned_bytes));
+    return 0;
+}
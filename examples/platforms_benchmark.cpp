@@ -0,0 +1,101 @@
+// Compares evaluating a project for linux, macos and windows in one pass with
+// evaluating it once per platform.
+// Usage: platforms_benchmark [modules] [rounds]
+
+#include <chrono>
+#include <cstdlib>
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/platforms.hpp>
+#include <finch/parser/parser.hpp>
+#include <fmt/format.h>
+#include <iostream>
+#include <string>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace {
+
+// Every fourth module has a platform-specific source, every fifth a
+// platform-specific library, and every tenth exists on Windows only
+std::string synthetic_project(size_t modules) {
+    std::string code = "project(big)\n";
+    for (size_t i = 0; i < modules; ++i) {
+        code += fmt::format("set(M{0}_SOURCES src/m{0}/a.cpp src/m{0}/b.cpp)\n", i);
+        if (i % 4 == 0) {
+            code += fmt::format("if(WIN32)\n  list(APPEND M{0}_SOURCES src/m{0}/win.cpp)\n"
+                                "elseif(APPLE)\n  list(APPEND M{0}_SOURCES src/m{0}/mac.mm)\n"
+                                "else()\n  list(APPEND M{0}_SOURCES src/m{0}/linux.cpp)\n"
+                                "endif()\n",
+                                i);
+        }
+        code += fmt::format("add_library(m{0} ${{M{0}_SOURCES}})\n", i);
+        code += fmt::format("target_compile_definitions(m{0} PRIVATE M{0}=1)\n", i);
+        if (i > 0) {
+            code += fmt::format("target_link_libraries(m{} PUBLIC m{})\n", i, i - 1);
+        }
+        if (i % 5 == 0) {
+            code += fmt::format("if(UNIX)\n  target_link_libraries(m{} PRIVATE dl)\nendif()\n", i);
+        }
+        if (i % 10 == 0) {
+            code += fmt::format("if(CMAKE_SYSTEM_NAME STREQUAL \"Windows\")\n"
+                                "  add_executable(tool{0} tools/tool{0}.cpp)\nendif()\n",
+                                i);
+        }
+    }
+    return code;
+}
+
+// Seconds to evaluate the file for the platforms, and the targets it found
+std::pair<double, size_t> evaluate(const ast::File& file, const PlatformSet& platforms) {
+    CMakeFileEvaluator evaluator;
+    evaluator.set_platforms(&platforms);
+    auto start = std::chrono::steady_clock::now();
+    auto analysis = evaluator.analyze(file);
+    double elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!analysis.has_value()) {
+        std::cerr << analysis.error().message() << "\n";
+        std::exit(1);
+    }
+    return {elapsed, analysis.value().targets.size()};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t modules = argc > 1 ? std::stoul(argv[1]) : 200;
+    size_t rounds = argc > 2 ? std::stoul(argv[2]) : 10;
+
+    parser::Parser parser(synthetic_project(modules), "CMakeLists.txt");
+    auto file = parser.parse_file();
+    if (!file.has_value()) {
+        std::cerr << file.error().size() << " parse errors\n";
+        return 1;
+    }
+    auto all = PlatformSet::from_names({"linux", "macos", "windows"});
+    if (!all.has_value()) {
+        std::cerr << all.error().message() << "\n";
+        return 1;
+    }
+
+    double one_pass = 0;
+    double separate = 0;
+    size_t targets = 0;
+    for (size_t round = 0; round < rounds; ++round) {
+        auto [elapsed, found] = evaluate(*file.value(), all.value());
+        one_pass += elapsed;
+        targets = found;
+        for (size_t p = 0; p < all.value().size(); ++p) {
+            auto single = PlatformSet::from_names({all.value()[p].name});
+            separate += evaluate(*file.value(), single.value()).first;
+        }
+    }
+
+    double per_round = 1e3 / static_cast<double>(rounds);
+    std::cout << fmt::format("{} modules, {} targets, {} rounds\n", modules, targets, rounds);
+    std::cout << fmt::format("One pass:     {:8.2f} ms\n", one_pass * per_round);
+    std::cout << fmt::format("Three passes: {:8.2f} ms ({:.2f}x)\n", separate * per_round,
+                             separate / one_pass);
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Counts the heap allocations and time of evaluating many add_subdirectory()
+// scopes, and of the same variable-table work on plain tables against tables
+// backed by a per-scope pool resource or a per-scope monotonic arena.
+// Usage: scope_allocation_benchmark [scopes]
+
+#include <chrono>
+#include <cstdlib>
+#include <finch/analyzer/evaluation_context.hpp>
+#include <fmt/format.h>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace finch::analyzer;
+
+namespace {
+
+size_t allocations = 0;
+
+double milliseconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+Value sources() {
+    return std::vector<std::string>{"src/a.cpp", "src/b.cpp", "src/c.cpp"};
+}
+
+// Each scope sets 80 variables, unsets 10 and hands one to its parent
+void evaluate_scopes(size_t scopes) {
+    EvaluationContext root;
+    for (size_t i = 0; i < 200; ++i) {
+        root.set_variable(fmt::format("PROJECT_OPTION_{}", i), std::string("ON"));
+    }
+    for (size_t d = 0; d < scopes; ++d) {
+        auto scope = root.create_directory_scope();
+        for (size_t v = 0; v < 40; ++v) {
+            scope->set_variable(fmt::format("MODULE_{}_SOURCES", v), sources());
+            scope->set_variable(fmt::format("M{}", v), std::string("x"));
+        }
+        for (size_t v = 0; v < 40; v += 4) {
+            scope->unset_variable(fmt::format("M{}", v));
+        }
+        scope->set_parent_scope_variable(fmt::format("EXPORT_{}", d % 10),
+                                         EvaluatedValue{std::string("1"), Confidence::Certain});
+        root.merge_directory(*scope);
+    }
+}
+
+// The same work on one bare table; what the parent gets is copied into its
+// own table, as a pmr container never adopts another resource
+template <typename Table>
+void fill_table(Table& table, std::unordered_map<std::string, EvaluatedValue>& parent,
+                size_t scope) {
+    for (size_t v = 0; v < 40; ++v) {
+        table.insert_or_assign(fmt::format("MODULE_{}_SOURCES", v),
+                               EvaluatedValue{sources(), Confidence::Certain});
+        table.insert_or_assign(fmt::format("M{}", v),
+                               EvaluatedValue{std::string("x"), Confidence::Certain});
+    }
+    for (size_t v = 0; v < 40; v += 4) {
+        table.erase(fmt::format("M{}", v));
+    }
+    parent.insert_or_assign(fmt::format("EXPORT_{}", scope % 10), table.at("MODULE_0_SOURCES"));
+}
+
+// Allocations and milliseconds of one run
+template <typename Run> std::pair<size_t, double> measure(Run run) {
+    size_t before = allocations;
+    auto start = std::chrono::steady_clock::now();
+    run();
+    return {allocations - before, milliseconds_since(start)};
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char** argv) {
+    size_t scopes = argc > 1 ? std::stoul(argv[1]) : 2000;
+
+    auto [context_allocations, context_ms] = measure([&] { evaluate_scopes(scopes); });
+    auto [plain_allocations, plain_ms] = measure([&] {
+        std::unordered_map<std::string, EvaluatedValue> parent;
+        for (size_t scope = 0; scope < scopes; ++scope) {
+            std::unordered_map<std::string, EvaluatedValue> table;
+            fill_table(table, parent, scope);
+        }
+    });
+    auto [pool_allocations, pool_ms] = measure([&] {
+        std::unordered_map<std::string, EvaluatedValue> parent;
+        for (size_t scope = 0; scope < scopes; ++scope) {
+            std::pmr::unsynchronized_pool_resource pool;
+            std::pmr::unordered_map<std::string, EvaluatedValue> table(&pool);
+            fill_table(table, parent, scope);
+        }
+    });
+    // Nothing is given back until the scope ends and the arena is released
+    auto [arena_allocations, arena_ms] = measure([&] {
+        std::unordered_map<std::string, EvaluatedValue> parent;
+        for (size_t scope = 0; scope < scopes; ++scope) {
+            std::pmr::monotonic_buffer_resource arena;
+            std::pmr::unordered_map<std::string, EvaluatedValue> table(&arena);
+            fill_table(table, parent, scope);
+        }
+    });
+
+    std::cout << fmt::format("{} scopes of 80 variables\n", scopes);
+    std::cout << fmt::format("EvaluationContext: {:8} allocations {:8.1f} ms\n",
+                             context_allocations, context_ms);
+    std::cout << fmt::format("Plain tables:      {:8} allocations {:8.1f} ms\n",
+                             plain_allocations, plain_ms);
+    std::cout << fmt::format("Pool tables:       {:8} allocations {:8.1f} ms\n",
+                             pool_allocations, pool_ms);
+    std::cout << fmt::format("Arena tables:      {:8} allocations {:8.1f} ms\n",
+                             arena_allocations, arena_ms);
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Measures string() on a string-heavy script rewriting every source path of a
+// large project, and REPLACE on one long string.
+// Usage: string_command_benchmark [files]
+
+#include <chrono>
+#include <finch/analyzer/cmake_regex.hpp>
+#include <finch/analyzer/string_command.hpp>
+#include <fmt/format.h>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace finch::analyzer;
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool run(EvaluationContext& context, const std::vector<std::string>& args) {
+    auto result = StringCommand::evaluate(context, args, Confidence::Certain);
+    if (!result.has_value()) {
+        std::cerr << result.error().message() << "\n";
+    }
+    return result.has_value();
+}
+
+std::string string_of(const EvaluationContext& context, const std::string& name) {
+    auto value = context.get_variable(name);
+    return value ? value_helpers::to_string(value->value) : "";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t files = argc > 1 ? std::stoul(argv[1]) : 50000;
+
+    // What the script's string() calls do per file, with ${SRC} expanded
+    EvaluationContext context;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < files; ++i) {
+        auto source = fmt::format("src/module{}/file{}.cpp", i % 50, i);
+        if (!run(context, {"REPLACE", "src/", "/work/src/", "SRC_PATH", source}) ||
+            !run(context, {"REGEX", "REPLACE", "\\.cpp$", ".o", "OBJECT", source}) ||
+            !run(context, {"REGEX", "MATCH", "module([0-9]+)", "MODULE", source}) ||
+            !run(context, {"TOUPPER", string_of(context, "CMAKE_MATCH_1"), "MODULE_ID"}) ||
+            !run(context, {"APPEND", "OBJECTS", string_of(context, "OBJECT") + ";"})) {
+            return 1;
+        }
+    }
+    double script = seconds_since(start);
+
+    // Replacing in one long string is a single pass
+    std::string haystack;
+    for (size_t i = 0; i < 200000; ++i) {
+        haystack += "src/file.cpp;";
+    }
+    start = std::chrono::steady_clock::now();
+    if (!run(context, {"REPLACE", ".cpp", ".o", "LONG", haystack})) {
+        return 1;
+    }
+    double replace = seconds_since(start);
+    double mebibytes = static_cast<double>(haystack.size()) / (1 << 20);
+
+    std::cout << fmt::format("{} files; {}\n", files, CMakeRegex::stats().to_string());
+    std::cout << fmt::format("Script:       {:.3f} s ({:.2f} us/file)\n", script,
+                             script * 1e6 / static_cast<double>(files));
+    std::cout << fmt::format("Long REPLACE: {:.1f} MiB in {:.4f} s ({:.0f} MiB/s)\n", mebibytes,
+                             replace, mebibytes / replace);
+    return 0;
+}
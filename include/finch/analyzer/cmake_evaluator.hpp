@@ -1,12 +1,18 @@
 #pragma once
 
+#include <filesystem>
 #include <finch/analyzer/evaluation_context.hpp>
+#include <finch/analyzer/feature_probes.hpp>
+#include <finch/analyzer/intrinsics.hpp>
+#include <finch/analyzer/program_slice.hpp>
 #include <finch/analyzer/project_analysis.hpp>
 #include <finch/core/error.hpp>
 #include <finch/core/result.hpp>
 #include <finch/parser/ast/visitor.hpp>
+#include <optional>
 #include <regex>
 #include <string>
+#include <vector>
 
 namespace finch::analyzer {
 
@@ -15,16 +21,46 @@ class CMakeEvaluator : public ast::ASTVisitor {
     EvaluationContext& context_;
     Result<EvaluatedValue, AnalysisError> result_;
 
+    // Statements outside the slice are skipped; null evaluates everything
+    const ProgramSlice* slice_ = nullptr;
+
     // Stack for tracking recursive evaluations
     std::vector<std::string> evaluation_stack_;
     const size_t max_recursion_depth_ = 100;
 
+    // The files of directories add_subdirectory() enters are sliced for
+    // this cone when set, and how many directories deep this evaluator is
+    const TargetCone* subdirectory_cone_ = nullptr;
+    size_t directory_depth_ = 0;
+
+    // Statements whose evaluation failed, here and in the directories added
+    size_t failed_statements_ = 0;
+
+    // A directory add_subdirectory() enters
+    struct Subdirectory;
+
   public:
     explicit CMakeEvaluator(EvaluationContext& context) : context_(context) {}
 
     // Evaluate an AST node
     Result<EvaluatedValue, AnalysisError> evaluate(const ast::ASTNode& node);
 
+    // Only evaluate statements the slice keeps
+    void set_slice(const ProgramSlice* slice) {
+        slice_ = slice;
+    }
+
+    // Slice the CMakeLists.txt of each directory add_subdirectory() enters
+    // for this cone; without one they are evaluated whole
+    void set_subdirectory_cone(const TargetCone* cone) {
+        subdirectory_cone_ = cone;
+    }
+
+    // Statements that failed to evaluate; evaluation goes on past them
+    [[nodiscard]] size_t failed_statements() const {
+        return failed_statements_;
+    }
+
     // Visitor methods for literals
     void visit(const ast::StringLiteral& node) override;
     void visit(const ast::NumberLiteral& node) override;
@@ -64,6 +100,18 @@ class CMakeEvaluator : public ast::ASTVisitor {
     void visit(const ast::CPMDeclarePackage& node) override;
 
   private:
+    // A statement of a file, block or if() branch, unless the slice drops it;
+    // once per group of platforms when they disagree on what it reads
+    void evaluate_statement(const ast::ASTNode& statement);
+    // Evaluate one statement, logging and counting a failure
+    void evaluate_counted(const ast::ASTNode& statement);
+    void evaluate_per_platform(const ast::ASTNode& statement,
+                               const std::vector<PlatformMask>& groups);
+
+    // The statements of a file or block; add_subdirectory() calls that
+    // follow each other are evaluated together
+    void evaluate_statements(const ast::ASTNodeList& statements);
+
     // Command evaluators
     Result<EvaluatedValue, AnalysisError> evaluate_set_command(const ast::CommandCall& cmd);
 
@@ -92,6 +140,74 @@ class CMakeEvaluator : public ast::ASTVisitor {
     Result<EvaluatedValue, AnalysisError>
     evaluate_target_compile_definitions_command(const ast::CommandCall& cmd);
 
+    Result<EvaluatedValue, AnalysisError>
+    evaluate_set_target_properties_command(const ast::CommandCall& cmd);
+
+    // find_package() against the context's package index
+    Result<EvaluatedValue, AnalysisError> evaluate_find_package_command(const ast::CommandCall& cmd);
+
+    // pkg_check_modules(), or pkg_search_module() when first_found is set
+    Result<EvaluatedValue, AnalysisError> evaluate_pkg_config_command(const ast::CommandCall& cmd,
+                                                                      bool first_found);
+
+    // check_include_file(), check_symbol_exists(), try_compile() and the
+    // other configure checks, answered through the context's probe executor
+    Result<EvaluatedValue, AnalysisError>
+    evaluate_feature_check_command(const ast::CommandCall& cmd);
+    std::optional<FeatureProbe> try_compile_probe(const std::vector<std::string>& words);
+    std::vector<std::string> required_probe_flags() const;
+
+    // Record a CPMAddPackage() or CPMFindPackage() declaration, pinned by a
+    // package lock if one declares it, and set the variables CPM sets for it
+    void declare_cpm_package(CPMPackage package);
+
+    // list(), on the list variable's elements in place
+    Result<EvaluatedValue, AnalysisError> evaluate_list_command(const ast::CommandCall& cmd);
+
+    // string(), building each result in one pass
+    Result<EvaluatedValue, AnalysisError> evaluate_string_command(const ast::CommandCall& cmd);
+
+    // file(GLOB) and file(GLOB_RECURSE) against the context's directory
+    // snapshot; the other subcommands are not evaluated
+    Result<EvaluatedValue, AnalysisError> evaluate_file_command(const ast::CommandCall& cmd);
+
+    // add_subdirectory(). Sibling directories are evaluated concurrently,
+    // each in a scope reading this one as it was before the first of them,
+    // and merged in the order they were added; a directory writing the cache
+    // or its parent's variables is merged before those after it are started.
+    // A directory that fails is not merged; its error is returned in place.
+    Result<EvaluatedValue, AnalysisError>
+    evaluate_add_subdirectory_command(const ast::CommandCall& cmd);
+    std::vector<std::optional<AnalysisError>>
+    evaluate_subdirectories(const std::vector<const ast::CommandCall*>& calls);
+    static void parse_subdirectory(Subdirectory& directory);
+    // Evaluated, or restored from its snapshot, in a scope starting from
+    // the given state hash
+    void evaluate_subdirectory(Subdirectory& directory, uint64_t state) const;
+
+    // CMAKE_CURRENT_SOURCE_DIR once known, else the working directory
+    std::filesystem::path current_source_directory() const;
+
+    // include() of a module or script with a native intrinsic
+    Result<EvaluatedValue, AnalysisError> evaluate_include_command(const ast::CommandCall& cmd);
+
+    // A command implemented natively by the intrinsic registry
+    Result<EvaluatedValue, AnalysisError>
+    evaluate_intrinsic_command(const ast::CommandCall& cmd,
+                               const IntrinsicRegistry::Handler& handler);
+
+    // Arguments as strings; confidence drops to the least certain argument
+    std::vector<std::string> evaluate_arguments(const ast::CommandCall& cmd,
+                                                Confidence& confidence);
+
+    // Arguments as CMake passes them to a command: unquoted list values
+    // expand into one argument per element
+    std::vector<std::string> expand_arguments(const ast::CommandCall& cmd,
+                                              Confidence& confidence);
+
+    // Seed target properties from CMAKE_<PROP> initializer variables
+    void initialize_target_properties(Target& target) const;
+
     // Condition evaluation
     Result<bool, AnalysisError> evaluate_condition(const ast::ASTNode& condition);
 
@@ -129,6 +245,8 @@ class CMakeEvaluator : public ast::ASTVisitor {
 class CMakeFileEvaluator {
   private:
     EvaluationContext context_;
+    bool slicing_ = false;
+    TargetCone target_cone_;
 
   public:
     CMakeFileEvaluator();
@@ -139,6 +257,59 @@ class CMakeFileEvaluator {
     // Analyze a parsed CMake file and return ProjectAnalysis
     Result<ProjectAnalysis, AnalysisError> analyze(const ast::File& file);
 
+    // Resolve find_package() and pkg_check_modules() against installed
+    // packages; without an index their results are left unknown
+    void set_package_index(const PackageIndex* index) {
+        context_.set_package_index(index);
+    }
+
+    // Answer configure checks with the local compiler; unanswered probes are
+    // queued on the executor and stay unknown until it has run
+    void set_probe_executor(ProbeExecutor* executor) {
+        context_.set_probe_executor(executor);
+    }
+
+    // Share parsed package-lock files with other evaluators; without a cache
+    // each CPMUsePackageLock() parses its lock file again
+    void set_package_lock_cache(CPMPackageLockCache* cache) {
+        context_.set_package_lock_cache(cache);
+    }
+
+    // Match file(GLOB) patterns against a snapshot shared with other
+    // evaluators; without one each glob reads the directories it needs
+    void set_directory_snapshot(DirectorySnapshot* snapshot) {
+        context_.set_directory_snapshot(snapshot);
+    }
+
+    // Evaluate for these platforms in one pass, recording what differs
+    // between them in each target's platform_variants; without a set, for
+    // the host alone
+    void set_platforms(const PlatformSet* platforms) {
+        context_.set_platforms(platforms);
+    }
+
+    // The project's top directory and the directory of the file evaluated,
+    // which relative paths such as file(GLOB) patterns resolve against
+    void set_source_directories(const std::filesystem::path& top,
+                                const std::filesystem::path& current);
+
+    // Evaluate only the program slice affecting targets, packages and the
+    // project name; the variables reported are then limited to those
+    void set_slicing(bool enabled) {
+        slicing_ = enabled;
+    }
+
+    // With slicing, only the statements affecting these targets
+    void set_target_cone(TargetCone cone) {
+        target_cone_ = std::move(cone);
+    }
+
+    // Restore files and the directories they add from snapshots of earlier
+    // runs where nothing they read has changed, and save those evaluated
+    void set_snapshot_store(EvaluationSnapshotStore* store) {
+        context_.set_snapshot_store(store);
+    }
+
     // Get the evaluation context
     EvaluationContext& context() {
         return context_;
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <finch/core/error.hpp>
+#include <finch/core/result.hpp>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// CMake regular expressions, run by std::regex. CMake's dialect is narrower
+/// than ECMAScript: braces are literal, a backslash makes the next character
+/// literal (\d is a "d"), and bracket expressions have no escapes. A pattern
+/// is translated and compiled once per thread; later string(REGEX) and
+/// list(FILTER|TRANSFORM) calls with it reuse the compiled automaton.
+class CMakeRegex {
+  public:
+    struct Stats {
+        size_t compiled = 0;
+        size_t hits = 0;
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    /// The compiled pattern, owned by this thread's cache
+    static Result<const std::regex*, AnalysisError> compile(std::string_view pattern);
+
+    /// The ECMAScript pattern std::regex compiles for a CMake one
+    static std::string translate(std::string_view pattern);
+
+    /// This thread's cache counters
+    static Stats stats();
+};
+
+/// The replace expression of string(REGEX REPLACE) and list(TRANSFORM
+/// REPLACE): \0 to \9 insert a group of the match, \n a newline and \\ a
+/// backslash. Parsed once, then applied to every match.
+class RegexReplacement {
+  public:
+    static Result<RegexReplacement, AnalysisError> parse(std::string_view expression);
+
+    /// Appends input to output with every match replaced, in one pass. ^
+    /// only matches at the start of input, and an empty match copies the
+    /// next character. last is the last match; false if there was none.
+    bool replace_all(std::string_view input, const std::regex& regex, std::string& output,
+                     std::cmatch& last) const;
+
+  private:
+    struct Piece {
+        std::string text;
+        int group = -1; // Inserted instead of text when set
+    };
+    std::vector<Piece> pieces_;
+};
+
+} // namespace finch::analyzer
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <deque>
+#include <filesystem>
+#include <finch/analyzer/project_analysis.hpp>
+#include <finch/core/error.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <finch/core/parallel.hpp>
+#include <finch/core/result.hpp>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// In-memory view of a compile_commands.json file. Entries reference the
+/// mapped file directly; only strings containing JSON escapes are copied.
+class CompileDatabase {
+  public:
+    struct Entry {
+        std::string_view directory;
+        std::string_view file;
+        std::string_view output;
+        std::string_view command;                // Set when the entry uses "command"
+        std::vector<std::string_view> arguments; // Set when the entry uses "arguments"
+    };
+
+    /// Memory-map and parse a compile_commands.json file
+    static Result<CompileDatabase, ParseError> load(const std::filesystem::path& path);
+
+    /// Parse JSON text; entries reference json, which must outlive the database
+    static Result<CompileDatabase, ParseError> parse(std::string_view json);
+
+    [[nodiscard]] const std::vector<Entry>& entries() const noexcept {
+        return entries_;
+    }
+
+    /// Split a shell command line the way CMake's Makefile/Ninja generators quote it
+    static std::vector<std::string> tokenize_command(std::string_view command);
+
+  private:
+    class Scanner;
+
+    std::unique_ptr<MappedFile> file_;
+    std::deque<std::string> unescaped_; // Stable storage for strings that had escapes
+    std::vector<Entry> entries_;
+};
+
+/// Analysis backend that derives targets from the compile commands a project
+/// already produces instead of evaluating its CMake code. Translation units are
+/// grouped into targets by their CMake object directory (CMakeFiles/<t>.dir/).
+class CompileDatabaseAnalyzer {
+  public:
+    explicit CompileDatabaseAnalyzer(size_t max_threads = default_concurrency());
+
+    Result<ProjectAnalysis, AnalysisError> analyze(const std::filesystem::path& database) const;
+    ProjectAnalysis analyze(const CompileDatabase& database) const;
+
+    /// Group compile commands obtained elsewhere (e.g. from a build.ninja)
+    ProjectAnalysis analyze(const std::vector<CompileDatabase::Entry>& entries) const;
+
+    /// Differences between evaluator-derived and database-derived targets
+    static std::vector<std::string> cross_check(const ProjectAnalysis& evaluated,
+                                                const ProjectAnalysis& observed);
+
+    /// Take target kinds and link libraries, which compile commands cannot
+    /// show, from matching evaluator-derived targets
+    static void reconcile(ProjectAnalysis& observed, const ProjectAnalysis& evaluated);
+
+  private:
+    size_t max_threads_;
+};
+
+} // namespace finch::analyzer
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <finch/analyzer/project_analysis.hpp>
+#include <finch/core/error.hpp>
+#include <finch/core/result.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace finch::ast {
+class CPMDeclarePackage;
+}
+
+namespace finch::analyzer {
+
+/// The CPMDeclarePackage() declarations of a package-lock.cmake, indexed by
+/// package name. A lock is immutable once parsed, so the files that use it
+/// share one table and CPMAddPackage(NAME x) looks x up in O(1) instead of
+/// evaluating the lock script again.
+class CPMPackageLock {
+  public:
+    /// Parse a lock file's content; only its CPMDeclarePackage() calls count
+    static Result<CPMPackageLock, AnalysisError> parse(std::string_view content,
+                                                       const std::string& path);
+
+    /// The package a CPMDeclarePackage() call declares
+    static CPMPackage declaration_of(const ast::CPMDeclarePackage& node);
+
+    /// The last declaration of name, as CPM keeps the last one too
+    [[nodiscard]] const CPMPackage* find(std::string_view name) const;
+
+    [[nodiscard]] const std::vector<CPMPackage>& declarations() const {
+        return declarations_;
+    }
+
+    [[nodiscard]] uint64_t content_hash() const {
+        return content_hash_;
+    }
+
+    /// FNV-1a of a lock file's bytes
+    static uint64_t hash_content(std::string_view content);
+
+  private:
+    std::vector<CPMPackage> declarations_;
+    std::unordered_map<std::string, size_t> by_name_;
+    uint64_t content_hash_ = 0;
+};
+
+/// Lock files parsed once per migration. Every CPMUsePackageLock() of the
+/// same file gets the same table; a load rereads and hashes the file and
+/// only parses it again when its content hash changed.
+class CPMPackageLockCache {
+  public:
+    struct Stats {
+        size_t loads = 0;
+        size_t parsed = 0;
+        size_t reused = 0;
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    /// The lock at path; nullptr when it does not exist or cannot be parsed,
+    /// in which case CPM does not use it either
+    std::shared_ptr<const CPMPackageLock> load(const std::filesystem::path& path);
+
+    [[nodiscard]] Stats stats() const;
+
+  private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const CPMPackageLock>> locks_;
+    Stats stats_;
+};
+
+} // namespace finch::analyzer
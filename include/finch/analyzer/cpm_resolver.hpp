@@ -0,0 +1,56 @@
+#pragma once
+
+#include <finch/analyzer/project_analysis.hpp>
+#include <finch/analyzer/version.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// Resolves the packages CPMAddPackage() and CPMFindPackage() declare across
+/// a project the way CPM does: the first declaration of a name adds the
+/// package and later ones reuse it, whatever version they ask for. A later
+/// declaration asking for a newer version than the one added is reported
+/// as a conflict, as CPM warns about it. Each declaration is a hash lookup,
+/// so resolving is linear in the number of declarations.
+class CPMResolver {
+  public:
+    struct Conflict {
+        std::string name;
+        std::string version;           // Of the package that was added
+        std::string requested_version; // By the later declaration
+        std::string declared_in;
+        std::string requested_in;
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    /// Declarations are expected in evaluation order
+    void add(const CPMPackage& declaration);
+
+    /// One package per name, in the order they were first declared
+    [[nodiscard]] const std::vector<CPMPackage>& packages() const {
+        return packages_;
+    }
+
+    [[nodiscard]] const std::vector<Conflict>& conflicts() const {
+        return conflicts_;
+    }
+
+    /// The version CPM records for a declaration: its VERSION, else the
+    /// version in its git tag ("v1.2.3"), else 0
+    static Version version_of(const CPMPackage& package);
+
+    /// Replace analysis.cpm_packages by the resolved packages, reporting
+    /// conflicts as warnings
+    static void resolve(ProjectAnalysis& analysis);
+
+  private:
+    std::vector<CPMPackage> packages_;
+    std::vector<Version> versions_; // Parsed once per package
+    std::unordered_map<std::string, size_t> index_;
+    std::vector<Conflict> conflicts_;
+};
+
+} // namespace finch::analyzer
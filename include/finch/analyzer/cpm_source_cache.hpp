@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <finch/analyzer/project_analysis.hpp>
+#include <finch/core/error.hpp>
+#include <finch/core/parallel.hpp>
+#include <finch/core/result.hpp>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// What a populated CPM_SOURCE_CACHE holds, so http_archive rules can get
+/// their sha256 without network access. CPM keeps each package under
+/// <cache>/<lowercase name>/: source trees it checked out in hashed
+/// subdirectories, and archives placed beside them (<name>-<ref>.tar.gz,
+/// <ref>.zip, or the basename of a URL source). Archives are hashed on a
+/// thread pool; a saved index keeps their hashes keyed by path, size and
+/// modification time, so a later run only hashes archives that changed.
+class CPMSourceCache {
+  public:
+    struct Entry {
+        enum class Kind { Archive, Source };
+
+        std::string name; // Directory under the cache root
+        Kind kind = Kind::Archive;
+        std::filesystem::path path;
+        std::vector<std::string> refs; // Tags or versions the entry holds
+        uint64_t size = 0;             // Archives only
+        int64_t mtime = 0;             // Archives only
+        std::string sha256;            // Archives only
+    };
+
+    struct Stats {
+        size_t archives = 0;
+        size_t sources = 0;
+        size_t hashed = 0; // Archives read this run
+        size_t reused = 0; // Hashes taken from the saved index
+        uint64_t bytes_hashed = 0;
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    CPMSourceCache() = default;
+
+    /// Scan root; archives unchanged since previous was built keep its hashes
+    static CPMSourceCache build(const std::filesystem::path& root,
+                                const CPMSourceCache* previous = nullptr,
+                                size_t max_threads = default_concurrency());
+
+    /// Read an index saved by save()
+    static Result<CPMSourceCache, IOError> load(const std::filesystem::path& index_file);
+
+    /// build() root reusing the index saved in index_file, then save it again
+    static CPMSourceCache update(const std::filesystem::path& root,
+                                 const std::filesystem::path& index_file,
+                                 size_t max_threads = default_concurrency());
+
+    Result<void, IOError> save(const std::filesystem::path& index_file) const;
+
+    /// cpm-source-cache.json in finch's cache directory
+    static std::filesystem::path default_index_file();
+
+    /// $CPM_SOURCE_CACHE, if set
+    static std::optional<std::filesystem::path> default_root();
+
+    /// The cached archive of a package's name and version, tag or URL,
+    /// else its cached source tree; nullptr when neither is cached
+    [[nodiscard]] const Entry* find(const CPMPackage& package) const;
+
+    /// Set the sha256 of every package with a cached archive. Returns a
+    /// warning for each package only cached as a source tree.
+    std::vector<std::string> fill(std::vector<CPMPackage>& packages) const;
+
+    [[nodiscard]] const std::vector<Entry>& entries() const {
+        return entries_;
+    }
+
+    [[nodiscard]] const Stats& stats() const {
+        return stats_;
+    }
+
+  private:
+    void add(Entry entry);
+
+    std::string root_;
+    std::vector<Entry> entries_;
+    std::unordered_map<std::string, std::vector<size_t>> by_name_; // Lowercase name
+    Stats stats_;
+};
+
+} // namespace finch::analyzer
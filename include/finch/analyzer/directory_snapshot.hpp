@@ -0,0 +1,100 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// One component of a glob: *, ? and [...] classes ([!...] or [^...]
+/// negated), none of which match a '/'. A component without them is a
+/// literal name and is looked up instead of matched.
+class GlobMatcher {
+  public:
+    explicit GlobMatcher(std::string_view pattern);
+
+    [[nodiscard]] bool matches(std::string_view name) const;
+
+    [[nodiscard]] bool is_literal() const {
+        return literal_;
+    }
+
+    [[nodiscard]] const std::string& pattern() const {
+        return pattern_;
+    }
+
+  private:
+    struct Token {
+        enum class Kind : uint8_t { Text, Any, Star, Class } kind;
+        std::string text;         // Text
+        std::bitset<256> members; // Class, already negated if it was
+    };
+
+    std::string pattern_;
+    std::vector<Token> tokens_;
+    bool literal_ = true;
+};
+
+/// The file system as file(GLOB) and file(GLOB_RECURSE) see it during one
+/// migration. Paths are a trie of components; a directory is read the first
+/// time a glob enters it and its sorted entries are kept, so overlapping
+/// globs over the same tree read each directory once between them and later
+/// globs never touch the file system. Changes made after a directory was
+/// read are not seen, as with CMake, which globs once per configure.
+class DirectorySnapshot {
+  public:
+    struct Options {
+        bool recurse = false;
+        bool list_directories = true;
+        bool follow_symlinks = false;
+    };
+
+    struct Stats {
+        size_t globs = 0;
+        size_t directories_read = 0;
+        size_t entries = 0;
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    DirectorySnapshot();
+
+    /// The paths an absolute glob pattern matches, sorted, as CMake returns
+    /// them. GLOB_RECURSE matches the last component against the entries of
+    /// every directory below the ones the other components match.
+    std::vector<std::string> glob(const std::filesystem::path& pattern, const Options& options);
+
+    [[nodiscard]] Stats stats() const;
+
+  private:
+    static constexpr uint32_t no_node = UINT32_MAX;
+
+    struct Node {
+        std::string name;
+        uint32_t parent = no_node;
+        bool directory = false;
+        bool symlink = false;
+        bool listed = false;
+        std::vector<uint32_t> children; // Sorted by name once listed
+    };
+
+    // The root node of a path's root ("/", "C:/"), created on first use
+    uint32_t root_of(const std::filesystem::path& root);
+    // A directory's entries, read on first use
+    const std::vector<uint32_t>& list(uint32_t directory);
+    uint32_t child_named(uint32_t directory, std::string_view name);
+    std::string path_of(uint32_t node) const;
+
+    void walk(uint32_t directory, const GlobMatcher& last, const Options& options,
+              std::vector<uint32_t>& found, size_t depth);
+
+    mutable std::mutex mutex_;
+    std::vector<Node> nodes_; // nodes_[0] holds the roots
+    Stats stats_;
+};
+
+} // namespace finch::analyzer
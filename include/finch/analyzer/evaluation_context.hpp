@@ -1,15 +1,27 @@
 #pragma once
 
+#include <filesystem>
+#include <finch/analyzer/platforms.hpp>
 #include <finch/analyzer/project_analysis.hpp>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <variant>
 #include <vector>
 
 namespace finch::analyzer {
 
+class CPMPackageLock;
+class CPMPackageLockCache;
+class DirectorySnapshot;
+class EvaluationSnapshotStore;
+class PackageIndex;
+class ProbeExecutor;
+
 // Value types that can be stored in CMake
 using Value = std::variant<std::string, bool, double, std::vector<std::string>>;
 
@@ -34,12 +46,26 @@ struct EvaluatedValue {
     }
 };
 
+// A file(GLOB) evaluation used, with the paths it matched
+struct GlobInput {
+    std::string pattern; // Absolute
+    bool recurse = false;
+    bool list_directories = true;
+    bool follow_symlinks = false;
+    std::vector<std::string> matched;
+};
+
 // CMake evaluation context
 class EvaluationContext {
   private:
     // Variable storage
     std::unordered_map<std::string, EvaluatedValue> variables_;
 
+    // Variables whose value depends on the platform, one slot per platform
+    // (empty where this scope does not set it); set_variable() replaces them
+    std::unordered_map<std::string, std::vector<std::optional<EvaluatedValue>>>
+        platform_variables_;
+
     // Cache variables
     std::unordered_map<std::string, EvaluatedValue> cache_variables_;
 
@@ -49,9 +75,131 @@ class EvaluationContext {
     // Targets discovered during evaluation
     std::vector<Target> targets_;
 
+    // Installed packages find_package() resolves against, and those it found
+    const PackageIndex* package_index_ = nullptr;
+    std::vector<ExternalPackage> external_packages_;
+
+    // CPMAddPackage() and CPMFindPackage() declarations, in evaluation order
+    std::vector<CPMPackage> cpm_packages_;
+
+    // Package locks CPMUsePackageLock() read and packages CPMDeclarePackage()
+    // declared, each numbered in evaluation order so a later lock overrides
+    // an earlier declaration and vice versa
+    CPMPackageLockCache* package_lock_cache_ = nullptr;
+    std::vector<std::pair<size_t, std::shared_ptr<const CPMPackageLock>>> cpm_locks_;
+    std::unordered_map<std::string, std::pair<size_t, CPMPackage>> cpm_declarations_;
+    size_t cpm_declaration_order_ = 0;
+
+    // Compiles configure checks whose answers are not known yet
+    ProbeExecutor* probe_executor_ = nullptr;
+
+    // The source tree file(GLOB) matches against
+    DirectorySnapshot* directory_snapshot_ = nullptr;
+
+    // Where evaluated directories are saved between runs
+    EvaluationSnapshotStore* snapshot_store_ = nullptr;
+
+    // The platforms evaluated, and those the current statement is evaluated for
+    const PlatformSet* platforms_ = nullptr;
+    PlatformMask active_platforms_ = 1;
+
+    // What this scope held before the changes being recorded, innermost
+    // last; see begin_platform_changes()
+    struct PlatformJournal {
+        std::unordered_map<std::string, std::optional<EvaluatedValue>> variables;
+        std::unordered_map<std::string, std::optional<std::vector<std::optional<EvaluatedValue>>>>
+            platform_variables;
+        std::unordered_map<size_t, Target> targets;
+        size_t target_count = 0;
+        std::optional<std::vector<ExternalPackage>> external_packages;
+        size_t cpm_package_count = 0;
+    };
+    std::vector<PlatformJournal> journals_;
+
     // Parent context for scoping
     EvaluationContext* parent_ = nullptr;
 
+    // A directory add_subdirectory() entered, with what it writes to its
+    // parent's scope (an empty value unsets) for the platforms written, and
+    // whether it wrote state a sibling directory may read: the cache, its
+    // parent's variables or a target another directory created
+    bool directory_scope_ = false;
+    std::vector<std::tuple<std::string, PlatformMask, std::optional<EvaluatedValue>>>
+        parent_scope_writes_;
+    bool writes_outside_ = false;
+
+    // Targets of other directories find_target() copied into this scope
+    std::unordered_set<std::string> copied_targets_;
+
+    // Targets this directory looked for and did not find; one a sibling
+    // evaluated alongside it creates means it must be evaluated again
+    std::unordered_set<std::string> missed_targets_;
+    void note_missed_target(const std::string& name);
+
+    // CMakeLists.txt files of the directories entered below this one
+    std::vector<std::filesystem::path> subdirectory_files_;
+
+    // What evaluating this scope read besides the state it started from:
+    // other files, such as package locks, and file(GLOB) results. A scope
+    // that asked the machine (configure checks, installed packages) cannot
+    // be restored from a snapshot.
+    std::vector<std::filesystem::path> input_files_;
+    std::vector<GlobInput> glob_inputs_;
+    bool machine_dependent_ = false;
+
+    // What EvaluationSnapshotStore::state_hash() last hashed of this scope:
+    // a hash per variable and per target, summed so table order does not
+    // matter, and one of the smaller tables (cache, checks, CPM
+    // declarations and locks). Once valid, changes mark what they touched
+    // and only that is hashed again.
+    struct StateDigest {
+        bool valid = false;
+        uint64_t sum = 0;
+        uint64_t tables = 0;
+        std::unordered_map<std::string, uint64_t> variables;
+        std::vector<uint64_t> targets;
+        std::unordered_set<std::string> changed_variables;
+        std::unordered_set<size_t> changed_targets;
+        bool tables_changed = false;
+    };
+    mutable StateDigest digest_;
+    void variable_changed(const std::string& name) {
+        if (digest_.valid) {
+            digest_.changed_variables.insert(name);
+        }
+    }
+    void target_changed(size_t index) {
+        if (digest_.valid) {
+            digest_.changed_targets.insert(index);
+        }
+    }
+    void tables_changed() {
+        digest_.tables_changed = true;
+    }
+
+    // Saves and restores the state above
+    friend class EvaluationSnapshotStore;
+
+    // Save a variable or target before the first change being recorded,
+    // and mark it changed in the state digest
+    void record_variable(const std::string& name);
+    void record_target(size_t index);
+
+    // A variable's value in this scope as each platform sees it
+    std::optional<EvaluatedValue> platform_value(const std::string& name, size_t platform) const;
+
+    // The binding a platform sees, looked up through the parent scopes
+    const EvaluatedValue* find_variable(const std::string& name, size_t platform) const;
+
+    // Bind a variable to a value per platform (empty where unset), as a
+    // plain variable when the given platforms agree on it
+    void bind_platform_values(const std::string& name,
+                              std::vector<std::optional<EvaluatedValue>> values,
+                              PlatformMask platforms);
+
+    // Builtin variables of the platforms evaluated
+    void initialize_platform_variables();
+
   public:
     EvaluationContext() = default;
     explicit EvaluationContext(EvaluationContext* parent) : parent_(parent) {}
@@ -62,6 +210,20 @@ class EvaluationContext {
 
     std::optional<EvaluatedValue> get_variable(const std::string& name) const;
 
+    // The visible binding without copying it, or nullptr
+    const EvaluatedValue* find_variable(const std::string& name) const;
+
+    // The current scope's binding, created from the visible value (or as an
+    // empty list) when only a parent scope has one; for commands that update
+    // a variable in place, such as list(APPEND)
+    EvaluatedValue& local_variable(const std::string& name);
+
+    // unset(); only the current scope's binding is removed
+    void unset_variable(const std::string& name);
+
+    // set(<variable> ... PARENT_SCOPE); an empty value unsets it there
+    void set_parent_scope_variable(const std::string& name, std::optional<EvaluatedValue> value);
+
     // Cache variable operations
     void set_cache_variable(const std::string& name, Value value,
                             Confidence confidence = Confidence::Certain);
@@ -76,6 +238,132 @@ class EvaluationContext {
     void add_target(const Target& target);
     const std::vector<Target>& get_targets() const;
 
+    // External packages
+    void set_package_index(const PackageIndex* index) {
+        package_index_ = index;
+    }
+    const PackageIndex* package_index() const;
+    void add_external_package(const ExternalPackage& package);
+    const std::vector<ExternalPackage>& get_external_packages() const;
+
+    // CPM declarations; every one is kept for CPMResolver
+    void add_cpm_package(const CPMPackage& package);
+    const std::vector<CPMPackage>& get_cpm_packages() const;
+
+    // Package locks and CPMDeclarePackage(); the declaration of a name that
+    // CPMAddPackage(NAME <name>) uses, or nullptr
+    void set_package_lock_cache(CPMPackageLockCache* cache) {
+        package_lock_cache_ = cache;
+    }
+    CPMPackageLockCache* package_lock_cache() const;
+    void use_cpm_package_lock(std::shared_ptr<const CPMPackageLock> lock);
+    void declare_cpm_package(const CPMPackage& package);
+    const CPMPackage* find_cpm_declaration(const std::string& name) const;
+
+    // Configure checks
+    void set_probe_executor(ProbeExecutor* executor) {
+        probe_executor_ = executor;
+    }
+    ProbeExecutor* probe_executor() const;
+
+    // file(GLOB) and file(GLOB_RECURSE)
+    void set_directory_snapshot(DirectorySnapshot* snapshot) {
+        directory_snapshot_ = snapshot;
+    }
+    DirectorySnapshot* directory_snapshot() const;
+
+    // Evaluation snapshots; without a store every directory is evaluated
+    void set_snapshot_store(EvaluationSnapshotStore* store) {
+        snapshot_store_ = store;
+    }
+    EvaluationSnapshotStore* snapshot_store() const;
+
+    // What a snapshot of this scope depends on; merge_directory() adds a
+    // directory's to its parent's
+    void add_input_file(std::filesystem::path file) {
+        input_files_.push_back(std::move(file));
+    }
+    void add_glob_input(GlobInput glob) {
+        glob_inputs_.push_back(std::move(glob));
+    }
+    void mark_machine_dependent() {
+        machine_dependent_ = true;
+    }
+    bool machine_dependent() const {
+        return machine_dependent_;
+    }
+
+    // Platforms evaluated in one pass; without any, the host's. The
+    // platforms' builtin variables are set again.
+    void set_platforms(const PlatformSet* platforms);
+    const PlatformSet& platforms() const;
+
+    // Reads see the first active platform's value of a platform variable;
+    // CMakeEvaluator narrows the active platforms to a group agreeing on
+    // every variable a statement reads
+    PlatformMask active_platforms() const {
+        return active_platforms_;
+    }
+    void set_active_platforms(PlatformMask platforms) {
+        active_platforms_ = platforms;
+    }
+
+    // True when the active platforms disagree on the variable's value
+    bool depends_on_platform(const std::string& name) const;
+
+    // The active platforms grouped by the values they see for these names;
+    // a single group when they agree on all of them
+    std::vector<PlatformMask> platform_groups(const std::vector<std::string_view>& names) const;
+
+    // What evaluating a statement for a group of platforms changed in this
+    // scope: the variables it wrote with their values per platform (empty
+    // where unset), the targets it updated by index, and what it added
+    struct PlatformChanges {
+        std::unordered_map<std::string, std::vector<std::optional<EvaluatedValue>>> variables;
+        std::unordered_map<size_t, Target> targets;
+        std::vector<Target> added_targets;
+        std::optional<std::vector<ExternalPackage>> external_packages;
+        std::vector<CPMPackage> added_cpm_packages;
+    };
+
+    // Start recording changes for the active platforms; undo_platform_changes()
+    // returns them and puts the scope back as it was, so each group starts
+    // from the same state without the scope being copied
+    void begin_platform_changes();
+    PlatformChanges undo_platform_changes();
+
+    // Apply the changes the groups of active platforms made: what they agree
+    // on is kept as is, variables they disagree on get a value per platform,
+    // and targets are merged by merge_platform_targets()
+    void merge_platform_changes(std::vector<std::pair<PlatformMask, PlatformChanges>> changes);
+
+    // A target to update in place, or nullptr. In a directory scope, a
+    // target another directory created is copied in and replaces the
+    // original when the scope is merged.
+    Target* find_target(const std::string& name);
+
+    // if(TARGET <name>): whether this scope or one it is evaluated in has
+    // created the target
+    bool has_target(const std::string& name);
+
+    // add_subdirectory(): a scope reading this one's variables, which must
+    // not change until merge_directory() has added what the directory did
+    std::unique_ptr<EvaluationContext> create_directory_scope();
+    void merge_directory(EvaluationContext& directory);
+    bool writes_outside() const {
+        return writes_outside_;
+    }
+    // Names of the targets a directory created, not those it copied in
+    std::vector<std::string> created_targets() const;
+    // Whether the directory looked for one of these targets and missed it
+    bool missed_any_target(const std::vector<std::string>& names) const;
+    void add_subdirectory_file(std::filesystem::path file) {
+        subdirectory_files_.push_back(std::move(file));
+    }
+    const std::vector<std::filesystem::path>& subdirectory_files() const {
+        return subdirectory_files_;
+    }
+
     // Scope management
     std::unique_ptr<EvaluationContext> create_child_scope();
 
@@ -109,6 +397,9 @@ std::optional<double> to_double(const Value& value);
 // Convert value to list (single string becomes one-element list)
 std::vector<std::string> to_list(const Value& value);
 
+// Text outside $<...> generator expressions, which may nest
+std::string strip_generator_expressions(std::string_view text);
+
 } // namespace value_helpers
 
 } // namespace finch::analyzer
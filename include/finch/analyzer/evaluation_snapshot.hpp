@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <finch/analyzer/evaluation_context.hpp>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json_fwd.hpp>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace finch::analyzer {
+
+class DirectorySnapshot;
+
+/// What evaluating a CMakeLists.txt left in its scope, saved between runs
+/// at directory-scope boundaries: each directory add_subdirectory() enters
+/// and each file the pipeline evaluates alone. A snapshot is found by the
+/// list file, its binary directory and the migration options, and records
+/// a hash of the state the scope started from and every file and
+/// file(GLOB) result evaluation read. Restoring it replaces parsing and
+/// evaluating the directory and everything below it, so a later run only
+/// evaluates the subtrees that changed. Scopes that ran configure checks or
+/// resolved installed packages depend on the machine and are not saved.
+class EvaluationSnapshotStore {
+  public:
+    struct Options {
+        std::filesystem::path directory = default_directory();
+        // The migration options that change what evaluation produces, in
+        // any stable spelling; snapshots of other options are not used
+        std::string evaluation_options;
+    };
+
+    struct Stats {
+        size_t lookups = 0;
+        size_t restored = 0;
+        size_t stale = 0; // Found, but an input or the starting state changed
+        size_t saved = 0;
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    /// A saved scope whose files and globs are unchanged
+    struct Snapshot {
+        uint64_t state_hash = 0;
+        std::shared_ptr<const EvaluationContext> scope;
+    };
+
+    EvaluationSnapshotStore();
+    explicit EvaluationSnapshotStore(Options options);
+
+    /// The snapshot of list_file evaluated into binary_directory, unless
+    /// there is none or a file or glob it read has changed. Globs are
+    /// matched again against directories, or the file system without one.
+    std::optional<Snapshot> load(const std::filesystem::path& list_file,
+                                 const std::filesystem::path& binary_directory,
+                                 DirectorySnapshot* directories);
+
+    /// Give scope the state a snapshot saved, if it was taken from the same
+    /// starting state; false otherwise. Safe to call concurrently, as are
+    /// load() and save().
+    bool restore(const Snapshot& snapshot, uint64_t state_hash, EvaluationContext& scope);
+
+    /// Save scope once list_file has been evaluated in it, starting from
+    /// state_hash; machine-dependent scopes are skipped
+    void save(const std::filesystem::path& list_file,
+              const std::filesystem::path& binary_directory, uint64_t state_hash,
+              const EvaluationContext& scope);
+
+    /// Hash of what a scope evaluated in scope sees: variables, cache,
+    /// checks, targets and package declarations, through its parents. Each
+    /// scope keeps a digest of its own state, so a call only hashes what
+    /// changed since the last one.
+    static uint64_t state_hash(const EvaluationContext& scope);
+
+    [[nodiscard]] Stats stats() const;
+
+    /// snapshots/ in finch's cache directory
+    static std::filesystem::path default_directory();
+
+  private:
+    // A scope's own state
+    static nlohmann::json scope_to_json(const EvaluationContext& scope);
+    static void scope_from_json(const nlohmann::json& object, EvaluationContext& scope);
+    // The scope's digest brought up to date
+    static uint64_t own_state_hash(const EvaluationContext& scope);
+
+    std::filesystem::path file_of(const std::filesystem::path& list_file,
+                                  const std::filesystem::path& binary_directory) const;
+    // FNV-1a of a file's bytes, nullopt when it cannot be read; each file
+    // is hashed once per run
+    std::optional<uint64_t> file_hash(const std::filesystem::path& file);
+
+    Options options_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::optional<uint64_t>> file_hashes_;
+    Stats stats_;
+};
+
+} // namespace finch::analyzer
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <finch/core/parallel.hpp>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// A configure-time check (check_include_file, check_cxx_source_compiles,
+/// check_symbol_exists, try_compile, ...) reduced to the source CMake would
+/// generate for it and the flags it would be compiled with
+struct FeatureProbe {
+    enum class Language { C, Cxx };
+
+    std::string result_variable;
+    Language language = Language::C;
+    std::string source;
+    std::vector<std::string> flags;
+    bool link = true; // Header checks only need to compile
+
+    static FeatureProbe include_files(std::string result_variable,
+                                      const std::vector<std::string>& headers, Language language);
+    static FeatureProbe source_compiles(std::string result_variable, std::string source,
+                                        Language language);
+    static FeatureProbe symbol_exists(std::string result_variable, const std::string& symbol,
+                                      const std::vector<std::string>& headers, Language language);
+    static FeatureProbe function_exists(std::string result_variable, const std::string& function);
+};
+
+/// Answers feature probes with the local compiler. Probes met during
+/// evaluation are queued, then compiled all at once on a thread pool instead
+/// of one after another as CMake does. Answers are kept in a persistent cache
+/// keyed by probe source, flags, compiler identity (path and version banner)
+/// and the platform the compiler builds for, so migrating the same project
+/// again compiles nothing. GCC-style
+/// drivers and MSVC's (cl, clang-cl) are both understood.
+class ProbeExecutor {
+  public:
+    struct Options {
+        std::string c_compiler = "cc";
+        std::string cxx_compiler = "c++";
+        // The PlatformSet name of what the compilers build for; empty is the host
+        std::string platform;
+        std::optional<std::filesystem::path> cache_file;
+        size_t max_threads = default_concurrency();
+    };
+
+    struct Stats {
+        size_t probes = 0;     // Distinct probes looked up
+        size_t cache_hits = 0; // Answered without compiling
+        size_t compiled = 0;
+        size_t succeeded = 0;
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    ProbeExecutor();
+    explicit ProbeExecutor(Options options);
+
+    /// The answer to probe if it is already known. Without a working compiler
+    /// for its language no answer is ever known. Safe to call from the
+    /// threads evaluating sibling directories, as is enqueue().
+    std::optional<bool> lookup(const FeatureProbe& probe);
+
+    /// The platform answers hold for; evaluations for other platforms must
+    /// not use them
+    [[nodiscard]] const std::string& platform() const {
+        return options_.platform;
+    }
+
+    /// Queue an unanswered probe for run(); the same probe is queued once
+    void enqueue(FeatureProbe probe);
+
+    [[nodiscard]] bool has_pending() const {
+        return !pending_.empty();
+    }
+
+    /// Compile all queued probes concurrently, remember their answers and
+    /// write them to the cache, merged with what other runs wrote there
+    Stats run();
+
+    [[nodiscard]] const Stats& stats() const {
+        return stats_;
+    }
+
+    /// probe-results.json in finch's cache directory
+    static std::filesystem::path default_cache_file();
+
+  private:
+    struct Compiler {
+        std::string command;
+        std::string identity; // Empty when the compiler cannot be run
+        bool msvc = false;    // cl.exe or clang-cl
+    };
+
+    const Compiler& compiler(FeatureProbe::Language language);
+    std::optional<uint64_t> key_of(const FeatureProbe& probe);
+    // The compiler invocation for probe, its outputs named output plus an extension
+    std::string command_line(const FeatureProbe& probe, const std::filesystem::path& source,
+                             const std::filesystem::path& output);
+    std::unordered_map<uint64_t, bool> read_cache() const;
+    void save_cache() const;
+
+    Options options_;
+    std::optional<Compiler> compilers_[2];
+    std::unordered_map<uint64_t, bool> answers_;
+    std::unordered_set<uint64_t> seen_;
+    std::vector<std::pair<uint64_t, FeatureProbe>> pending_;
+    Stats stats_;
+    std::mutex mutex_; // Guards the above during evaluation
+};
+
+} // namespace finch::analyzer
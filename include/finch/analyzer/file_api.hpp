@@ -0,0 +1,38 @@
+#pragma once
+
+#include <filesystem>
+#include <finch/analyzer/project_analysis.hpp>
+#include <finch/core/error.hpp>
+#include <finch/core/parallel.hpp>
+#include <finch/core/result.hpp>
+#include <optional>
+#include <string>
+
+namespace finch::analyzer {
+
+/// Analysis backend that reads the CMake File API codemodel-v2 reply of an
+/// already configured build tree. CMake reports exact targets, sources, flags
+/// and dependencies there, so the resulting targets are marked
+/// Target::Confidence::Certain. Only the reply JSON is read; no cmake binary is
+/// needed, so checked-in reply fixtures work as well as live build trees.
+class FileApiReader {
+  public:
+    explicit FileApiReader(size_t max_threads = default_concurrency());
+
+    /// Load the newest reply under path, which may be a build directory, its
+    /// .cmake/api/v1 directory or the reply directory itself. configuration
+    /// selects a multi-config generator's configuration; the first is used
+    /// otherwise.
+    Result<ProjectAnalysis, AnalysisError>
+    read(const std::filesystem::path& path,
+         const std::optional<std::string>& configuration = std::nullopt) const;
+
+    /// Locate the reply directory for path, as accepted by read()
+    static std::optional<std::filesystem::path>
+    find_reply_directory(const std::filesystem::path& path);
+
+  private:
+    size_t max_threads_;
+};
+
+} // namespace finch::analyzer
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace finch::analyzer {
+
+/// How much of a CMake file the pipeline has to process
+enum class FileClass {
+    Skip,    // No command that sets state or produces targets
+    Shallow, // Sets variables or defines functions, but produces no targets
+    Full     // May create targets, packages or the project
+};
+
+const char* to_string(FileClass file_class);
+
+/// Classifies CMake files by the command names they contain before they are
+/// lexed, so toolchain files, find-modules and packaging scripts need not go
+/// through the parser and evaluator. A command is a name followed by '(';
+/// comments are skipped, and anything that looks like a command inside a
+/// quoted or bracket argument counts, which keeps the classification
+/// conservative.
+class FilePrefilter {
+  public:
+    struct Stats {
+        size_t skipped = 0;
+        size_t shallow = 0;
+        size_t full = 0;
+        size_t bytes_scanned = 0;
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    static FileClass classify(std::string_view content);
+
+    /// Classify the file at path. A file that cannot be read is Full, so
+    /// the error is reported where it is processed.
+    FileClass classify_file(const std::filesystem::path& path);
+
+    [[nodiscard]] const Stats& stats() const {
+        return stats_;
+    }
+
+  private:
+    Stats stats_;
+};
+
+} // namespace finch::analyzer
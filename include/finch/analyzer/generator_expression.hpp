@@ -0,0 +1,95 @@
+#pragma once
+
+#include <finch/analyzer/platforms.hpp>
+#include <finch/analyzer/project_analysis.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// A string with $<...> generator expressions, parsed into the expressions
+/// finch can decide: PLATFORM_ID, CONFIG, BOOL, AND, OR, NOT,
+/// TARGET_PROPERTY, BUILD_INTERFACE, INSTALL_INTERFACE, LINK_ONLY and
+/// $<cond:value>.
+/// Any other expression is kept as its text and never decided.
+struct GenexNode {
+    enum class Kind {
+        Text,        // text
+        Concat,      // children one after another
+        Conditional, // children[0] is the condition, children[1] the value
+        PlatformId,
+        Config,
+        Bool,
+        And,
+        Or,
+        Not,
+        TargetProperty,
+        BuildInterface,
+        InstallInterface,
+        LinkOnly,
+        Unsupported // text is the whole $<...>
+    };
+
+    Kind kind = Kind::Text;
+    std::string text;
+    // Arguments, split at top-level commas where the expression takes several
+    std::vector<GenexNode> children;
+};
+
+/// Parse text, which need not contain a generator expression
+GenexNode parse_generator_expression(std::string_view text);
+
+/// What a generator expression is evaluated against. Whatever is left
+/// unset cannot be decided, and nor can anything depending on it.
+struct GenexContext {
+    std::optional<std::string> platform_id; // CMAKE_SYSTEM_NAME: Linux, Darwin, Windows
+    std::optional<std::string> config;
+    // A target's property; the target is "" for the one being evaluated
+    std::function<std::optional<std::string>(std::string_view target, std::string_view property)>
+        target_property;
+};
+
+/// The value of an expression, or nullopt when it cannot be decided. AND
+/// and OR are decided by one false or true argument even when others are not.
+std::optional<std::string> evaluate_generator_expression(const GenexNode& node,
+                                                         const GenexContext& context);
+
+/// Parsed generator expressions by their text, so each unique string is
+/// parsed once however many lists and targets it appears in. Safe to use
+/// concurrently.
+class GenexCache {
+  public:
+    /// The table shared by the whole process
+    static GenexCache& shared();
+
+    std::shared_ptr<const GenexNode> parse(std::string_view text);
+
+    [[nodiscard]] size_t size() const;
+
+  private:
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<const GenexNode>> parsed_;
+};
+
+/// True when text holds a generator expression
+inline bool has_generator_expression(std::string_view text) {
+    return text.find("$<") != std::string_view::npos;
+}
+
+/// True when any list of target, or of its platform variants, has one
+bool has_generator_expressions(const Target& target);
+
+/// target with the generator expressions in its lists lowered for
+/// platforms: items every platform evaluates alike are folded into the
+/// common lists, the rest into each platform's variant, and items that
+/// cannot be decided (CONFIG, unknown expressions) are dropped, with one
+/// warning per target listing them. Items without $< are left as they are.
+Target lower_generator_expressions(const Target& target, const PlatformSet& platforms);
+
+} // namespace finch::analyzer
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <finch/analyzer/project_analysis.hpp>
+#include <finch/core/error.hpp>
+#include <finch/core/parallel.hpp>
+#include <finch/core/result.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// Scans target sources for #include directives to work out which headers
+/// each target really owns and which dependencies are missing. Files are
+/// scanned in parallel; directives are cached by path (with mtime and size)
+/// and by content hash, so rescanning an unchanged tree reads nothing. The
+/// cache can be saved and loaded again by the next run.
+class IncludeScanner {
+  public:
+    struct Directive {
+        std::string path;
+        bool angled = false; // <path> rather than "path"
+    };
+
+    struct Stats {
+        size_t files_scanned = 0;
+        size_t bytes_scanned = 0;
+        size_t cache_hits = 0;
+        size_t unresolved_includes = 0; // Mostly system headers
+        size_t headers_assigned = 0;
+        size_t missing_dependencies = 0;
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    explicit IncludeScanner(size_t max_threads = default_concurrency());
+
+    /// #include, #include_next and #import directives in text. Comments,
+    /// string and character literals (including raw strings) are skipped;
+    /// conditional blocks are not evaluated, so every branch counts.
+    static std::vector<Directive> extract_includes(std::string_view text);
+
+    /// Follow the includes of every target's sources, add each reached header
+    /// to the headers of the target that owns it, and warn when a target
+    /// includes another library's headers without linking it
+    Stats scan(ProjectAnalysis& analysis);
+
+    /// Take the directives an earlier run saved; files changed since are
+    /// read again
+    Result<void, IOError> load(const std::filesystem::path& cache_file);
+
+    /// Write the directives of every file scanned so far; not while scan() runs
+    Result<void, IOError> save(const std::filesystem::path& cache_file) const;
+
+    /// include-directives.json in finch's cache directory
+    static std::filesystem::path default_cache_file();
+
+  private:
+    using Directives = std::shared_ptr<const std::vector<Directive>>;
+
+    struct CachedFile {
+        std::filesystem::file_time_type modified;
+        uintmax_t size = 0;
+        uint64_t hash = 0; // Of the content
+        Directives directives;
+    };
+
+    // Safe to call concurrently; cached is set when the file was not read
+    Directives directives_for(const std::string& path, size_t& bytes_read, bool& cached);
+
+    size_t max_threads_;
+    std::mutex cache_mutex_;
+    std::unordered_map<std::string, CachedFile> by_path_;
+    std::unordered_map<uint64_t, Directives> by_hash_;
+};
+
+} // namespace finch::analyzer
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <finch/analyzer/evaluation_context.hpp>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// Native implementations of standard CMake modules and the commands they
+/// define. include(GNUInstallDirs) or FetchContent_Declare(...) runs a C++
+/// handler that sets the variables the module would, instead of interpreting
+/// the module's CMake code.
+class IntrinsicRegistry {
+  public:
+    /// Receives the command's arguments with unquoted lists expanded (for
+    /// include() intrinsics, the included name is the first argument) and
+    /// returns how certain the variables it set are
+    using Handler =
+        std::function<Confidence(EvaluationContext& context, const std::vector<std::string>& args)>;
+
+    IntrinsicRegistry();
+
+    /// A module included by name, e.g. include(GNUInstallDirs)
+    void register_module(std::string name, Handler handler);
+
+    /// A script included by path, matched on its file name without .cmake;
+    /// CPM_<version>.cmake matches the script registered as CPM
+    void register_script(std::string stem, Handler handler);
+
+    /// A command; names are matched case-insensitively, as CMake does
+    void register_command(std::string name, Handler handler);
+
+    const Handler* find_include(std::string_view name_or_path) const;
+    const Handler* find_command(std::string_view name) const;
+
+    void register_default_intrinsics();
+
+    /// The registry with every default intrinsic, shared by all evaluators
+    static const IntrinsicRegistry& builtin();
+
+  private:
+    std::unordered_map<std::string, Handler> modules_;
+    std::unordered_map<std::string, Handler> scripts_;
+    std::unordered_map<std::string, Handler> commands_;
+};
+
+} // namespace finch::analyzer
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <finch/analyzer/evaluation_context.hpp>
+#include <finch/core/error.hpp>
+#include <finch/core/result.hpp>
+#include <string>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// list(), evaluated on a variable's element vector. A list still stored as
+/// an "a;b;c" string is split once, by the first list() call that modifies
+/// it; after that APPEND is amortized O(1) per element, SORT is a stable
+/// O(n log n) sort, and every other subcommand is one O(n) pass, so a source
+/// list grown by thousands of list(APPEND) calls is never joined and split
+/// again. REMOVE_ITEM and REMOVE_DUPLICATES look elements up in a hash set.
+class ListCommand {
+  public:
+    /// list(<subcommand> <list> ...), with the arguments expanded as CMake
+    /// passes them. The variables it sets get the arguments' confidence, or
+    /// the list's own when that is lower.
+    static Result<void, AnalysisError> evaluate(EvaluationContext& context,
+                                                const std::vector<std::string>& args,
+                                                Confidence confidence);
+};
+
+} // namespace finch::analyzer
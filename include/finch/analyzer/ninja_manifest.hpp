@@ -0,0 +1,104 @@
+#pragma once
+
+#include <filesystem>
+#include <finch/analyzer/project_analysis.hpp>
+#include <finch/core/error.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <finch/core/parallel.hpp>
+#include <finch/core/result.hpp>
+#include <forward_list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// Streaming reader for build.ninja manifests. Files (including those pulled
+/// in by include and subninja) are memory-mapped and parsed in a single pass;
+/// values without $-escapes stay views into the mapping. Paths are interned,
+/// so the same file named by several edges has one string_view.
+class NinjaManifest {
+  public:
+    using Binding = std::pair<std::string_view, std::string_view>;
+
+    struct Rule {
+        std::string_view name;
+        std::vector<Binding> bindings; // Unexpanded; evaluated per edge
+    };
+
+    struct Scope;
+
+    struct Edge {
+        const Rule* rule = nullptr;
+        const Scope* scope = nullptr;
+        std::vector<std::string_view> outputs; // Explicit outputs, then implicit ones
+        std::vector<std::string_view> inputs;  // Explicit, implicit, then order-only
+        uint32_t explicit_outputs = 0;
+        uint32_t explicit_inputs = 0;
+        std::vector<Binding> bindings; // Already expanded in the enclosing scope
+    };
+
+    /// Parse path and everything it includes; relative include paths are
+    /// resolved against path's directory, which ninja runs in
+    static Result<NinjaManifest, ParseError> load(const std::filesystem::path& path);
+
+    /// Parse manifest text; text must outlive the manifest
+    static Result<NinjaManifest, ParseError>
+    parse(std::string_view text, const std::filesystem::path& build_directory);
+
+    NinjaManifest(NinjaManifest&&) noexcept;
+    NinjaManifest& operator=(NinjaManifest&&) noexcept;
+    ~NinjaManifest();
+
+    [[nodiscard]] const std::vector<Edge>& edges() const noexcept {
+        return edges_;
+    }
+
+    [[nodiscard]] const std::filesystem::path& build_directory() const noexcept {
+        return build_directory_;
+    }
+
+    /// Value of variable as seen by edge: the edge's own bindings, then its
+    /// rule's bindings (with $in and $out), then the enclosing scopes
+    [[nodiscard]] std::string evaluate(const Edge& edge, std::string_view variable) const;
+
+    /// Value of a variable in the top-level scope
+    [[nodiscard]] std::string_view variable(std::string_view name) const;
+
+    [[nodiscard]] size_t interned_paths() const noexcept {
+        return paths_.size();
+    }
+
+  private:
+    class Parser;
+
+    NinjaManifest();
+    std::string_view own(std::string value);
+
+    std::filesystem::path build_directory_;
+    std::vector<std::unique_ptr<MappedFile>> files_;
+    std::vector<std::unique_ptr<Scope>> scopes_;
+    std::vector<std::unique_ptr<Rule>> rules_;
+    std::forward_list<std::string> owned_; // Values that needed $-expansion
+    std::unordered_set<std::string_view> paths_;
+    std::vector<Edge> edges_;
+};
+
+/// Analysis backend over the build.ninja written by CMake's Ninja generator.
+/// Compile edges are expanded into compile commands and grouped like a
+/// compile_commands.json; link edges supply target kinds and link inputs.
+class NinjaManifestAnalyzer {
+  public:
+    explicit NinjaManifestAnalyzer(size_t max_threads = default_concurrency());
+
+    Result<ProjectAnalysis, AnalysisError> analyze(const std::filesystem::path& manifest) const;
+    ProjectAnalysis analyze(const NinjaManifest& manifest) const;
+
+  private:
+    size_t max_threads_;
+};
+
+} // namespace finch::analyzer
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <filesystem>
+#include <finch/analyzer/project_analysis.hpp>
+#include <finch/core/error.hpp>
+#include <finch/core/parallel.hpp>
+#include <finch/core/result.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// Packages installed under a set of prefixes, as find_package() and
+/// pkg-config would see them. The prefixes are scanned once, in parallel, for
+/// CMake package configuration files (<prefix>/lib/cmake/<dir>/<Name>Config.cmake
+/// and the other locations of CMake's search procedure) and for pkg-config
+/// .pc files; lookups afterwards are hash table probes. Nothing is executed
+/// and nothing is fetched, so an index only ever describes local prefixes.
+class PackageIndex {
+  public:
+    PackageIndex() = default;
+
+    /// Scan prefixes; earlier prefixes win when a package is found twice
+    static PackageIndex build(const std::vector<std::filesystem::path>& prefixes,
+                              size_t max_threads = default_concurrency());
+
+    /// Read an index saved by save(). Fails when the cache is missing,
+    /// malformed, was built for other prefixes, or any scanned directory has
+    /// changed since.
+    static Result<PackageIndex, IOError> load(const std::filesystem::path& cache_file,
+                                              const std::vector<std::filesystem::path>& prefixes);
+
+    /// load() the cache if it is still valid, otherwise build() and save it
+    static PackageIndex load_or_build(const std::filesystem::path& cache_file,
+                                      const std::vector<std::filesystem::path>& prefixes,
+                                      size_t max_threads = default_concurrency());
+
+    Result<void, IOError> save(const std::filesystem::path& cache_file) const;
+
+    /// package-index.json in finch's cache directory
+    static std::filesystem::path default_cache_file();
+
+    /// The package find_package(<name>) would resolve: a CMake package
+    /// configuration file first, then a pkg-config module of the same name.
+    /// Names match case-insensitively, like the <name>-config.cmake spelling.
+    [[nodiscard]] const ExternalPackage* find_package(std::string_view name) const;
+
+    /// The pkg-config module <module>.pc
+    [[nodiscard]] const ExternalPackage* find_module(std::string_view module) const;
+
+    /// The package defining an imported target such as fmt::fmt
+    [[nodiscard]] const ExternalPackage* find_imported_target(std::string_view target) const;
+
+    [[nodiscard]] const std::vector<ExternalPackage>& packages() const {
+        return packages_;
+    }
+
+    /// Whether this index came from a valid cache rather than a scan
+    [[nodiscard]] bool from_cache() const {
+        return from_cache_;
+    }
+
+  private:
+    // Stamp of every scanned directory and package file, keyed by path
+    using Stamps = std::unordered_map<std::string, int64_t>;
+
+    void add(ExternalPackage package);
+
+    std::vector<std::string> prefixes_;
+    Stamps stamps_;
+    std::vector<ExternalPackage> packages_;
+    std::unordered_map<std::string, size_t> configs_;  // Lowercase name -> package
+    std::unordered_map<std::string, size_t> modules_;  // Lowercase .pc name -> package
+    std::unordered_map<std::string, size_t> imported_; // Imported target -> package
+    bool from_cache_ = false;
+};
+
+} // namespace finch::analyzer
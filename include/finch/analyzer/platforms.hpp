@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <finch/analyzer/project_analysis.hpp>
+#include <finch/core/error.hpp>
+#include <finch/core/result.hpp>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace finch::ast {
+class ASTNode;
+} // namespace finch::ast
+
+namespace finch::analyzer {
+
+/// A platform finch migrates for, with the variables CMake defines when
+/// configuring for it
+struct Platform {
+    std::string name;       // As given to --platform: linux, macos or windows
+    std::string constraint; // The Buck2 constraint select() keys on
+    // Every platform lists the same names, unset ones as ""
+    std::vector<std::pair<std::string, std::string>> variables;
+};
+
+/// The platforms of one evaluation, a bit each in a PlatformMask
+using PlatformMask = uint32_t;
+
+/// The platforms evaluated together. Evaluation runs once for all of them:
+/// variables they disagree on (WIN32, CMAKE_SYSTEM_NAME, ...) hold a value
+/// per platform, and only statements reading one are evaluated once per
+/// group of platforms agreeing on what they read.
+class PlatformSet {
+  public:
+    static constexpr size_t max_platforms = 32;
+
+    /// The platform finch runs on, as CMake itself would configure
+    static const PlatformSet& host();
+
+    /// Every platform finch knows
+    static const PlatformSet& known();
+
+    /// Known platforms by name; none means the host
+    static Result<PlatformSet, AnalysisError> from_names(const std::vector<std::string>& names);
+
+    /// A known platform, or nullptr
+    static const Platform* find(std::string_view name);
+
+    [[nodiscard]] size_t size() const {
+        return platforms_.size();
+    }
+    [[nodiscard]] const Platform& operator[](size_t index) const {
+        return platforms_[index];
+    }
+    [[nodiscard]] PlatformMask all() const {
+        return size() == max_platforms ? ~PlatformMask{0} : (PlatformMask{1} << size()) - 1;
+    }
+
+  private:
+    std::vector<Platform> platforms_;
+};
+
+/// The names a statement may read the value of: variable references and,
+/// because list(APPEND X ...) and if(WIN32) name variables by bare words,
+/// every literal word. Only if() conditions count, not branch bodies.
+std::vector<std::string_view> statement_reads(const ast::ASTNode& statement);
+
+/// One target out of the versions platforms ended up with, indexed by
+/// platform; null where a platform has none, and only those in active are
+/// looked at. Contents every platform has stay in the target's own lists;
+/// the rest moves to platform_variants, and platforms lists who defines it
+/// when not everyone does. Properties cannot vary by platform; the first
+/// platform setting one wins, with a warning when another disagrees.
+Target merge_platform_targets(const std::vector<const Target*>& versions, PlatformMask active,
+                              const PlatformSet& platforms);
+
+} // namespace finch::analyzer
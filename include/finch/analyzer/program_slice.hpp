@@ -0,0 +1,72 @@
+#pragma once
+
+#include <finch/analyzer/project_analysis.hpp>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace finch::ast {
+class ASTNode;
+class File;
+} // namespace finch::ast
+
+namespace finch::analyzer {
+
+/// Names of the targets to migrate; nullopt stands for every target
+using TargetCone = std::optional<std::unordered_set<std::string>>;
+
+/// The statements of a CMake file that can affect what finch extracts:
+/// targets, found packages and the project name. A static def-use pass
+/// keeps every statement creating or changing a wanted target, every
+/// statement that may define a variable a kept statement reads, and the
+/// if() statements kept statements are nested in. message(), install(),
+/// CPack settings and unused configuration are left out of evaluation.
+///
+/// The slice is relative to what CMakeEvaluator models: commands it does
+/// not evaluate have no effect and are never kept, and definitions are
+/// matched by name regardless of order, which keeps the slice conservative.
+class ProgramSlice {
+  public:
+    /// Slice for the targets in cone, or for all targets
+    static ProgramSlice compute(const ast::File& file, const TargetCone& cone = std::nullopt);
+
+    [[nodiscard]] bool contains(const ast::ASTNode& statement) const {
+        return kept_.contains(&statement);
+    }
+
+    [[nodiscard]] size_t statement_count() const {
+        return statement_count_;
+    }
+    [[nodiscard]] size_t kept_count() const {
+        return kept_.size();
+    }
+
+  private:
+    std::unordered_set<const ast::ASTNode*> kept_;
+    size_t statement_count_ = 0;
+};
+
+/// Which targets link which, gathered statically from add_library(),
+/// add_executable() and target_link_libraries() across a project's files
+class TargetGraph {
+  public:
+    void add_file(const ast::File& file);
+
+    /// The roots and every target they link, directly or transitively.
+    /// nullopt when a target name or link item is only known after
+    /// evaluation, in which case any target may be part of the cone.
+    [[nodiscard]] TargetCone cone(const std::vector<std::string>& roots) const;
+
+  private:
+    std::unordered_map<std::string, std::vector<std::string>> links_;
+    bool dynamic_ = false;
+};
+
+/// Drop every target the roots do not link, directly or transitively.
+/// Returns the roots that name no target.
+std::vector<std::string> restrict_to_targets(ProjectAnalysis& analysis,
+                                             const std::vector<std::string>& roots);
+
+} // namespace finch::analyzer
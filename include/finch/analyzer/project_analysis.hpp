@@ -1,6 +1,8 @@
 #pragma once
 
 #include <filesystem>
+#include <finch/core/path_table.hpp>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -18,16 +20,85 @@ struct Target {
         Unknown
     };
 
+    // How the target's contents were obtained
+    enum class Confidence {
+        Inferred,  // Reconstructed from build outputs such as compile commands
+        Evaluated, // Evaluated from CMake source by finch
+        Certain    // Reported by CMake itself after configuring
+    };
+
     std::string name;
     Type type = Type::Unknown;
-    std::filesystem::path source_directory;
-    std::vector<std::string> sources;
-    std::vector<std::string> headers;
-    std::vector<std::string> include_directories;
+    Confidence confidence = Confidence::Evaluated;
+    // Interned, so the paths of large projects cost an id each
+    PathId source_directory;
+    PathList sources;
+    PathList headers;
+    PathList include_directories;
     std::vector<std::string> compile_definitions;
     std::vector<std::string> compile_options;
     std::vector<std::string> link_libraries;
+    // Libraries outside the project as the linker takes them, -lfoo or a
+    // library file; link_libraries above names targets
+    std::vector<std::string> link_flags;
     std::unordered_map<std::string, std::string> properties;
+
+    // What some platforms add to the lists above, when evaluated for several
+    struct PlatformVariant {
+        PathList sources;
+        PathList headers;
+        PathList include_directories;
+        std::vector<std::string> compile_definitions;
+        std::vector<std::string> compile_options;
+        std::vector<std::string> link_libraries;
+
+        bool operator==(const PlatformVariant&) const = default;
+    };
+    // Keyed by platform name
+    std::map<std::string, PlatformVariant> platform_variants;
+    // The platforms defining the target, when only some do
+    std::vector<std::string> platforms;
+
+    bool operator==(const Target&) const = default;
+};
+
+// A package installed outside the project, resolved by find_package() or
+// pkg_check_modules() against local install prefixes
+struct ExternalPackage {
+    enum class Source {
+        CMakeConfig, // <Name>Config.cmake or <name>-config.cmake
+        PkgConfig    // <name>.pc
+    };
+
+    std::string name;
+    std::string version;
+    Source source = Source::CMakeConfig;
+    std::filesystem::path prefix;
+    std::filesystem::path location; // Directory of the config file, or the .pc file
+    std::vector<std::string> imported_targets;
+    std::vector<std::string> include_directories;
+    std::vector<std::string> libraries; // Library files, or -L/-l flags for pkg-config
+    std::vector<std::string> dependencies;
+};
+
+// A dependency declared with CPMAddPackage() or CPMFindPackage(), to be
+// downloaded rather than found installed
+struct CPMPackage {
+    enum class SourceType {
+        None,   // Only a name, e.g. a package CPMFindPackage() may find installed
+        GitHub, // owner/repo
+        Git,    // Repository URL
+        URL,    // Archive URL
+        Local   // Source directory
+    };
+
+    std::string name;
+    SourceType source_type = SourceType::None;
+    std::string source;
+    std::string version; // As declared; may be empty
+    std::string git_tag;
+    std::string declared_in; // file:line of the declaration
+    std::string sha256;      // Of its archive, when CPM_SOURCE_CACHE holds one
 };
 
 // Represents the analysis results for a CMake project
@@ -35,8 +106,13 @@ struct ProjectAnalysis {
     std::string project_name;
     std::string project_version;
     std::vector<Target> targets;
+    std::vector<ExternalPackage> external_packages;
+    // In declaration order until resolved, then one entry per package
+    std::vector<CPMPackage> cpm_packages;
     std::unordered_map<std::string, std::string> global_variables;
     std::unordered_map<std::string, std::string> cache_variables;
+    // The CMakeLists.txt files of the directories add_subdirectory() entered
+    std::vector<std::filesystem::path> subdirectory_files;
     std::vector<std::string> warnings;
 };
 
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <finch/analyzer/evaluation_context.hpp>
+#include <finch/core/error.hpp>
+#include <finch/core/result.hpp>
+#include <string>
+#include <vector>
+
+namespace finch::analyzer {
+
+/// string(), for the subcommands scripts use to rewrite paths and versions:
+/// FIND, REPLACE, REGEX MATCH|MATCHALL|REPLACE, APPEND, PREPEND, CONCAT,
+/// JOIN, TOLOWER, TOUPPER, LENGTH, SUBSTRING, STRIP, GENEX_STRIP, REPEAT,
+/// COMPARE, MAKE_C_IDENTIFIER and SHA256. Every result is built in one pass
+/// over its input; substring search runs on memmem() and regexes come
+/// compiled from CMakeRegex's cache. REGEX subcommands set CMAKE_MATCH_<n>
+/// and CMAKE_MATCH_COUNT as CMake does.
+class StringCommand {
+  public:
+    /// string(<subcommand> ...), with the arguments expanded as CMake passes
+    /// them. The variables it sets get the arguments' confidence.
+    static Result<void, AnalysisError> evaluate(EvaluationContext& context,
+                                                const std::vector<std::string>& args,
+                                                Confidence confidence);
+};
+
+} // namespace finch::analyzer
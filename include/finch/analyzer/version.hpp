@@ -0,0 +1,46 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace finch::analyzer {
+
+/// A version compared the way CMake's VERSION_LESS, VERSION_EQUAL, ... and
+/// CPM compare them: component by component as integers, with missing
+/// components counting as zero. Up to four components are kept, packed
+/// into two integers when parsed, so a comparison is two integer compares.
+class Version {
+  public:
+    static constexpr size_t max_components = 4;
+
+    Version() = default;
+
+    /// Each '.'-separated component is its leading digits (zero when there
+    /// are none, saturating at 2^32 - 1); anything after the fourth
+    /// component is ignored. Every string parses, as in CMake.
+    static Version parse(std::string_view text);
+
+    [[nodiscard]] uint32_t component(size_t index) const;
+
+    /// The components that were given, e.g. "1.2" for "1.2rc1"
+    [[nodiscard]] std::string to_string() const;
+
+    friend bool operator==(const Version& a, const Version& b) {
+        return a.high_ == b.high_ && a.low_ == b.low_;
+    }
+    friend std::strong_ordering operator<=>(const Version& a, const Version& b) {
+        if (auto order = a.high_ <=> b.high_; order != 0) {
+            return order;
+        }
+        return a.low_ <=> b.low_;
+    }
+
+  private:
+    uint64_t high_ = 0; // major << 32 | minor
+    uint64_t low_ = 0;  // patch << 32 | tweak
+    uint8_t components_ = 0;
+};
+
+} // namespace finch::analyzer
@@ -31,6 +31,23 @@ class Application {
         std::vector<std::string> platforms = {"linux", "macos", "windows"};
         bool overwrite = false;
         std::optional<std::string> template_dir;
+        std::optional<std::string> compile_commands;
+        std::optional<std::string> file_api_build_dir;
+        std::optional<std::string> ninja_manifest;
+        bool skip_include_scan = false;
+        std::optional<std::string> include_cache;
+        std::vector<std::string> package_prefixes;
+        std::optional<std::string> package_cache;
+        bool skip_feature_probes = false;
+        std::optional<std::string> probe_cache;
+        std::optional<std::string> cpm_source_cache;
+        std::optional<std::string> cpm_cache_index;
+        bool full_evaluation = false;
+        std::vector<std::string> targets;
+        bool no_prefilter = false;
+        bool validate_prefilter = false;
+        bool no_snapshots = false;
+        std::optional<std::string> snapshot_dir;
     };
 
     int run(int argc, char** argv);
@@ -4,17 +4,31 @@
 #include <filesystem>
 #include <finch/core/error.hpp>
 #include <finch/core/result.hpp>
+#include <functional>
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace finch::parser {
 class Parser;
 }
 
+namespace finch::ast {
+class File;
+class SubtreeSharingMeter;
+}
+
 namespace finch::analyzer {
+enum class FileClass;
 class CMakeFileEvaluator;
+class CPMPackageLockCache;
+class DirectorySnapshot;
+class EvaluationSnapshotStore;
+class PackageIndex;
+class PlatformSet;
+class ProbeExecutor;
 struct ProjectAnalysis;
 } // namespace finch::analyzer
 
@@ -75,6 +89,51 @@ class MigrationPipeline {
         bool dry_run;
         bool interactive;
         std::optional<std::string> config_file;
+        // Derive targets from this compile_commands.json instead of CMake
+        // evaluation; evaluated targets are then only used for cross-checking
+        std::optional<std::string> compile_commands;
+        // Take targets from the CMake File API reply of this configured build
+        // directory; they replace the evaluated ones
+        std::optional<std::string> file_api_build_dir;
+        // Take targets from the build.ninja of a tree configured with the
+        // Ninja generator; they replace the evaluated ones
+        std::optional<std::string> ninja_manifest;
+        // Follow #include directives to list each library's headers exactly
+        // and to report missing dependencies
+        bool scan_includes = true;
+        // Where the #include directives of scanned files are cached between runs
+        std::optional<std::string> include_cache;
+        // Install prefixes find_package() and pkg_check_modules() resolve
+        // against; packages found there become prebuilt_cxx_library rules
+        std::vector<std::string> package_prefixes;
+        // Where the index of those prefixes is cached between runs
+        std::optional<std::string> package_cache;
+        // Compile check_*() and try_compile() probes with the local compiler
+        // ($CC and $CXX) instead of leaving their results unknown
+        bool run_feature_probes = true;
+        // Where probe answers are cached between runs
+        std::optional<std::string> probe_cache;
+        // A populated CPM_SOURCE_CACHE to take the sha256 of http_archive
+        // rules from; defaults to $CPM_SOURCE_CACHE
+        std::optional<std::string> cpm_source_cache;
+        // Where the hashes of that cache are kept between runs
+        std::optional<std::string> cpm_cache_index;
+        // Evaluate only the statements that can affect targets, skipping
+        // message(), install() and packaging logic
+        bool slice_evaluation = true;
+        // Migrate only these targets and the targets they link
+        std::vector<std::string> targets;
+        // Scan each file for command names first; files that cannot produce
+        // targets are not evaluated, and those without state are not parsed
+        bool prefilter_files = true;
+        // Process the files the prefilter left out anyway and warn about any
+        // that would have produced targets, packages or a project name
+        bool validate_prefilter = false;
+        // Restore directories an earlier run evaluated from the same state
+        // and unchanged files instead of evaluating them again
+        bool evaluation_snapshots = true;
+        // Where those snapshots are kept between runs
+        std::optional<std::string> snapshot_directory;
     };
 
     struct MigrationResult {
@@ -86,16 +145,34 @@ class MigrationPipeline {
     };
 
     explicit MigrationPipeline(const PipelineConfig& config);
+    ~MigrationPipeline();
 
     Result<MigrationResult, MigrationError> execute();
 
   private:
     Result<std::vector<std::filesystem::path>, MigrationError> discover_cmake_files();
 
+    /// Parse a file and hand its AST to use; the AST's strings live in the
+    /// parser, so the AST is only valid during the call
+    Result<void, MigrationError>
+    parse_cmake_file(const std::filesystem::path& cmake_file,
+                     const std::function<void(const ast::File&)>& use);
+
+    /// Parse a file and evaluate it with the run's shared caches; this is the
+    /// evaluated view that --compile-commands cross-checks and reconciles.
+    /// Its AST is measured for subtree sharing when measure_sharing is set.
     Result<analyzer::ProjectAnalysis, MigrationError>
-    process_file(const std::filesystem::path& cmake_file);
+    process_file(const std::filesystem::path& cmake_file, bool measure_sharing);
+
+    /// Evaluate a file the prefilter left out; a warning when it produces
+    /// targets, packages or a project name after all
+    std::optional<std::string> validate_prefilter(const std::filesystem::path& cmake_file,
+                                                  analyzer::FileClass file_class);
 
-    Result<void, MigrationError> generate_buck_files(const analyzer::ProjectAnalysis& analysis);
+    /// Write the BUCK files of the merged analysis through the Generator,
+    /// adding its warnings to result and logging what flag canonicalization did
+    Result<void, MigrationError> generate_buck_files(const analyzer::ProjectAnalysis& analysis,
+                                                     MigrationResult& result);
 
     void merge_analysis(analyzer::ProjectAnalysis& target, const analyzer::ProjectAnalysis& source);
 
@@ -103,6 +180,17 @@ class MigrationPipeline {
     std::unique_ptr<ProgressReporter> progress_;
     std::unique_ptr<parser::Parser> parser_;
     std::unique_ptr<analyzer::CMakeFileEvaluator> analyzer_;
+    std::unique_ptr<analyzer::PackageIndex> package_index_;
+    std::unique_ptr<analyzer::ProbeExecutor> probe_executor_;
+    std::unique_ptr<analyzer::CPMPackageLockCache> package_locks_;
+    std::unique_ptr<analyzer::DirectorySnapshot> directory_snapshot_;
+    std::unique_ptr<analyzer::EvaluationSnapshotStore> snapshot_store_;
+    // Subtrees of the files evaluated, to report what sharing equal ones would save
+    std::unique_ptr<ast::SubtreeSharingMeter> subtree_meter_;
+    // config_.target_platforms, all evaluated in one pass per file
+    std::unique_ptr<analyzer::PlatformSet> platforms_;
+    // Targets statically reachable from config_.targets; nullopt for all
+    std::optional<std::unordered_set<std::string>> target_cone_;
     std::unique_ptr<generator::Generator> generator_;
 };
 
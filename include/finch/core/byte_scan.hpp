@@ -0,0 +1,74 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FINCH_BYTE_SCAN_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define FINCH_BYTE_SCAN_NEON 1
+#endif
+
+namespace finch {
+
+/// First byte in [p, end) equal to one of Bytes, or end. This is what the
+/// hand-written scanners over compile databases, sources and CMake files
+/// spend their time in. SSE2 (baseline on x86-64) and AArch64 NEON compare
+/// sixteen bytes per step; other little-endian targets test eight with the
+/// classic "has zero byte" bit trick, and the tail goes a byte at a time.
+template <char... Bytes>
+inline const char* find_any_byte(const char* p, const char* end) {
+#if defined(FINCH_BYTE_SCAN_SSE2)
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_setzero_si128();
+        ((hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(Bytes)))), ...);
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            return p + std::countr_zero(mask);
+        }
+        p += 16;
+    }
+#elif defined(FINCH_BYTE_SCAN_NEON)
+    while (end - p >= 16) {
+        uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        uint8x16_t hits = vdupq_n_u8(0);
+        ((hits = vorrq_u8(hits, vceqq_u8(chunk, vdupq_n_u8(static_cast<uint8_t>(Bytes))))), ...);
+        // Narrowing shift keeps four bits per byte: a 64-bit mask of the hits
+        uint64_t mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(hits), 4)), 0);
+        if (mask != 0) {
+            return p + (std::countr_zero(mask) >> 2);
+        }
+        p += 16;
+    }
+#else
+    if constexpr (std::endian::native == std::endian::little) {
+        constexpr uint64_t ones = 0x0101010101010101ULL;
+        constexpr uint64_t highs = 0x8080808080808080ULL;
+        // High bit set in each byte of word that is zero, and maybe in bytes
+        // above it; the lowest one is always exact
+        auto zero_bytes = [](uint64_t word) { return (word - ones) & ~word; };
+
+        while (end - p >= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, sizeof(word));
+            uint64_t hits =
+                (zero_bytes(word ^ (ones * static_cast<uint8_t>(Bytes))) | ...) & highs;
+            if (hits != 0) {
+                return p + (std::countr_zero(hits) >> 3);
+            }
+            p += 8;
+        }
+    }
+#endif
+    while (p < end && ((*p != Bytes) && ...)) {
+        ++p;
+    }
+    return p;
+}
+
+} // namespace finch
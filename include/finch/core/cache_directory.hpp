@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdlib>
+#include <filesystem>
+#include <finch/core/error.hpp>
+#include <finch/core/result.hpp>
+#include <string_view>
+
+namespace finch {
+
+/// Where finch keeps state that survives between runs: $XDG_CACHE_HOME/finch,
+/// falling back to ~/.cache/finch and then the temporary directory
+inline std::filesystem::path cache_directory() {
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        return std::filesystem::path(xdg) / "finch";
+    }
+    if (const char* home = std::getenv("HOME"); home && *home) {
+        return std::filesystem::path(home) / ".cache" / "finch";
+    }
+    return std::filesystem::temp_directory_path() / "finch";
+}
+
+/// Write contents to a temporary file beside path and rename it over path,
+/// creating the parent directory; concurrent runs see the old file or the new
+/// one, never a partial write
+Result<void, IOError> replace_file(const std::filesystem::path& path, std::string_view contents);
+
+} // namespace finch
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace finch {
+
+/// FNV-1a, for hashes written to caches and snapshots: stable across runs and
+/// standard libraries, unlike std::hash
+inline constexpr uint64_t fnv_offset_basis = 0xCBF29CE484222325ULL;
+
+/// Fold bytes into an FNV-1a hash started from fnv_offset_basis
+inline void hash_bytes(uint64_t& hash, std::string_view bytes) {
+    for (char c : bytes) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+    }
+}
+
+/// Fold one field of a record, followed by a separator so that adjacent
+/// fields cannot run together
+inline void hash_field(uint64_t& hash, std::string_view bytes) {
+    hash_bytes(hash, bytes);
+    hash = (hash ^ 0xFF) * 0x100000001B3ULL;
+}
+
+} // namespace finch
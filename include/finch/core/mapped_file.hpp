@@ -0,0 +1,43 @@
+#pragma once
+
+#include <filesystem>
+#include <finch/core/error.hpp>
+#include <finch/core/result.hpp>
+#include <string>
+#include <string_view>
+
+namespace finch {
+
+/// Read-only view of a whole file, memory-mapped where the platform allows it.
+/// Large inputs (compile databases, build.ninja, ...) are scanned in place
+/// instead of being copied into a std::string first.
+class MappedFile {
+  public:
+    /// Map the file at path; fails with an IOError if it cannot be opened
+    static Result<MappedFile, IOError> open(const std::filesystem::path& path);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    [[nodiscard]] std::string_view view() const noexcept {
+        return {data_, size_};
+    }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return size_;
+    }
+
+  private:
+    MappedFile() = default;
+    void release() noexcept;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_; // Fallback storage when the file is read instead of mapped
+};
+
+} // namespace finch
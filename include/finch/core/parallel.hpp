@@ -0,0 +1,55 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace finch {
+
+/// Number of worker threads to use for CPU-bound fan-out
+inline size_t default_concurrency() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+/// Run fn(i) for every i in [0, count) on up to max_threads threads.
+/// Work is handed out in small chunks so uneven items balance out; fn must be
+/// safe to call concurrently for distinct indices and must not throw.
+template <typename Fn>
+void parallel_for(size_t count, Fn&& fn, size_t max_threads = default_concurrency()) {
+    const size_t threads = std::min(max_threads, count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    const size_t chunk = std::max<size_t>(1, count / (threads * 8));
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (;;) {
+            size_t begin = next.fetch_add(chunk, std::memory_order_relaxed);
+            if (begin >= count) {
+                return;
+            }
+            size_t end = std::min(count, begin + chunk);
+            for (size_t i = begin; i < end; ++i) {
+                fn(i);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+} // namespace finch
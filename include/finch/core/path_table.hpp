@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace finch {
+
+/// A lexically normal path interned in the process-wide PathTable. It is four
+/// bytes that copy, compare and hash as an integer; converting a string or a
+/// std::filesystem::path normalizes it once ("a/./b/../c/" is "a/c"), after
+/// which parent(), filename() and joins are table lookups, not string parsing.
+/// Equal paths always have equal ids. The default is the empty path.
+/// Text holding an unexpanded "${...}" or generator expression is kept as
+/// written, as a single relative component, until it is expanded or lowered.
+class PathId {
+  public:
+    PathId() = default;
+    PathId(std::string_view path);
+    PathId(const std::string& path) : PathId(std::string_view(path)) {}
+    PathId(const char* path) : PathId(std::string_view(path)) {}
+    PathId(const std::filesystem::path& path);
+
+    [[nodiscard]] std::string str() const;
+    [[nodiscard]] std::filesystem::path path() const;
+
+    [[nodiscard]] bool empty() const {
+        return index_ == 0;
+    }
+
+    [[nodiscard]] bool is_absolute() const;
+
+    /// The directory holding this path; a root is its own parent
+    [[nodiscard]] PathId parent() const;
+    /// Last component, "" for the empty path and roots
+    [[nodiscard]] std::string_view filename() const;
+    /// filename() up to its first '.', as get_filename_component(NAME_WE)
+    [[nodiscard]] std::string_view stem() const;
+    /// From the last '.' of filename() on, as get_filename_component(LAST_EXT)
+    [[nodiscard]] std::string_view extension() const;
+
+    /// True when this path is directory or below it
+    [[nodiscard]] bool is_within(PathId directory) const;
+    /// relative appended to this path, or relative itself when absolute
+    [[nodiscard]] PathId operator/(PathId relative) const;
+    /// This path spelled from base, as lexically_relative(): "../include"
+    /// from "src" for "include", and the empty path for base itself. Paths
+    /// under different roots have no relative spelling and come back as is.
+    [[nodiscard]] PathId relative_to(PathId base) const;
+
+    [[nodiscard]] uint32_t index() const {
+        return index_;
+    }
+
+    friend bool operator==(const PathId&, const PathId&) = default;
+    friend std::ostream& operator<<(std::ostream& os, PathId path);
+
+  private:
+    friend class PathTable;
+    explicit PathId(uint32_t index) : index_(index) {}
+
+    uint32_t index_ = 0;
+};
+
+using PathList = std::vector<PathId>;
+
+/// Interned paths as a trie of components. Each path is one 24-byte node
+/// holding its parent's id and its last component, so the directories a
+/// hundred thousand sources share are stored once and each source costs a
+/// node, its file name and an index slot. One table serves the whole
+/// process; it is safe to use from parallel_for workers, and lookups of
+/// known paths only take a shared lock.
+class PathTable {
+  public:
+    struct Stats {
+        size_t paths = 0;
+        size_t name_bytes = 0;
+        size_t table_bytes = 0; // Nodes, names and index together
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    static PathTable& shared();
+
+    PathId intern(std::string_view path);
+    [[nodiscard]] std::string str(PathId path) const;
+    [[nodiscard]] Stats stats() const;
+
+  private:
+    friend class PathId;
+
+    static constexpr uint32_t empty_node = 0;
+    static constexpr uint32_t missing_node = UINT32_MAX;
+    // Node::depth is 31 bits; deeper paths would need more nodes than ids exist
+    static constexpr uint32_t max_depth = UINT32_MAX >> 1;
+
+    struct Node {
+        const char* name = "";        // In blocks_, which never move
+        uint32_t parent = empty_node; // A root is its own parent
+        uint32_t size = 0;
+        uint32_t depth : 31 = 0; // Components below the root or empty path
+        uint32_t absolute : 1 = 0;
+
+        [[nodiscard]] std::string_view view() const {
+            return {name, size};
+        }
+    };
+
+    PathTable();
+
+    // One normalizing step from current: "." stays, ".." goes up unless
+    // there is nothing to go up to. A const table only looks paths up and
+    // returns missing_node for ones never interned; the caller holds the
+    // matching lock.
+    template <typename Table>
+    static uint32_t step(Table& table, uint32_t current, std::string_view name);
+    template <typename Table> static uint32_t walk(Table& table, std::string_view path);
+    uint32_t child(uint32_t parent, std::string_view name);
+    [[nodiscard]] uint32_t find_child(uint32_t parent, std::string_view name) const;
+    [[nodiscard]] size_t slot_of(uint32_t parent, std::string_view name) const;
+    void grow_index();
+
+    // Locked operations behind PathId
+    Node node(uint32_t index) const;
+    bool within(uint32_t path, uint32_t directory) const;
+    uint32_t join(uint32_t base, uint32_t relative);
+    uint32_t relative(uint32_t path, uint32_t base);
+
+    mutable std::shared_mutex mutex_;
+    std::vector<Node> nodes_;
+    uint32_t root_ = missing_node;
+    // Open addressing over node ids, keyed by (parent, name)
+    std::vector<uint32_t> index_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t block_used_ = 0;
+    size_t block_capacity_ = 0;
+    size_t name_bytes_ = 0;
+    size_t block_bytes_ = 0;
+};
+
+} // namespace finch
+
+template <> struct std::hash<finch::PathId> {
+    size_t operator()(finch::PathId path) const noexcept {
+        return std::hash<uint32_t>{}(path.index());
+    }
+};
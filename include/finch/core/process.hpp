@@ -0,0 +1,23 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace finch {
+
+/// What a command printed to stdout and stderr, and whether it exited with 0
+struct ProcessOutput {
+    bool succeeded = false;
+    std::string output;
+};
+
+/// Quote one argument for run_command(): POSIX shell quoting, or on Windows
+/// the quoting the MSVC runtime splits argv by
+std::string quote_argument(std::string_view argument);
+
+/// Run a command line through the platform's shell (sh, or cmd.exe on
+/// Windows); nullopt when the shell cannot be started
+std::optional<ProcessOutput> run_command(const std::string& command_line);
+
+} // namespace finch
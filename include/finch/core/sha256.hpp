@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace finch {
+
+/// SHA-256 (FIPS 180-4), as Buck2 expects for http_archive(sha256 = ...).
+/// Input is fed incrementally, so large archives can be hashed straight from
+/// a mapping without copying them.
+class Sha256 {
+  public:
+    using Digest = std::array<uint8_t, 32>;
+
+    Sha256();
+
+    void update(std::string_view bytes);
+
+    /// Pad and return the digest; the hasher must not be updated afterwards
+    Digest finish();
+
+    /// Lowercase hexadecimal digest of bytes
+    static std::string hex(std::string_view bytes);
+    static std::string to_hex(const Digest& digest);
+
+  private:
+    void compress(const uint8_t* block);
+
+    std::array<uint32_t, 8> state_;
+    std::array<uint8_t, 64> buffer_{};
+    size_t buffered_ = 0;
+    uint64_t length_ = 0; // Bytes hashed so far
+};
+
+} // namespace finch
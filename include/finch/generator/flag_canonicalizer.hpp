@@ -0,0 +1,49 @@
+#pragma once
+
+#include <finch/generator/target_mapper.hpp>
+#include <string>
+#include <vector>
+
+namespace finch::generator {
+
+// Rewrites the flags of mapped targets into a canonical form so that targets
+// with semantically equal flags produce identical rule attributes (and thus
+// identical Buck2 action keys), and hoists flags shared by every C/C++ target
+// into toolchain-level configuration.
+class FlagCanonicalizer {
+  public:
+    struct Report {
+        size_t targets_considered = 0;
+        size_t distinct_flag_sets_before = 0;
+        size_t distinct_flag_sets_after = 0;
+        size_t flags_removed = 0;
+        std::vector<std::string> hoisted_preprocessor_flags;
+        std::vector<std::string> hoisted_compiler_flags;
+
+        std::string to_string() const;
+    };
+
+    explicit FlagCanonicalizer(bool hoist_common_flags = true);
+
+    // Canonicalize every C/C++ target in place. Hoisted flags are removed from
+    // the targets and recorded in the report for the .buckconfig.
+    Report canonicalize(const std::vector<TargetMapper::MappedTarget*>& targets) const;
+
+    // Join split "-D FOO" style arguments, keep only the effective -D/-U per
+    // macro and sort them by macro name (their relative order is irrelevant)
+    static std::vector<std::string>
+    canonicalize_preprocessor_flags(const std::vector<std::string>& flags);
+
+    // Join split arguments, keep only the last of mutually overriding options
+    // (-O*, -std=, -g*, -f[no-]X switches, -march= and a few other valued
+    // options) and drop exact duplicates. Valued options such as
+    // -ffile-prefix-map= and -fplugin= repeat and are all kept.
+    // Remaining order is preserved since it can be significant.
+    static std::vector<std::string>
+    canonicalize_compiler_flags(const std::vector<std::string>& flags);
+
+  private:
+    bool hoist_common_flags_;
+};
+
+} // namespace finch::generator
@@ -3,18 +3,20 @@
 #include <filesystem>
 #include <finch/core/error.hpp>
 #include <finch/core/result.hpp>
+#include <finch/generator/flag_canonicalizer.hpp>
+#include <finch/generator/target_mapper.hpp>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace finch::analyzer {
+class PlatformSet;
 struct ProjectAnalysis;
 struct Target;
 } // namespace finch::analyzer
 
 namespace finch::generator {
 
-class TargetMapper;
 class StarlarkWriter;
 class TemplateRegistry;
 
@@ -23,15 +25,24 @@ class Generator {
     struct Config {
         std::filesystem::path output_directory;
         std::vector<std::string> target_platforms;
+        // The platforms the analysis was evaluated for, which generator
+        // expressions are lowered for; every known platform when null
+        const analyzer::PlatformSet* platforms = nullptr;
         bool dry_run = false;
         bool preserve_comments = true;
         std::optional<std::filesystem::path> template_directory;
+        // Default batch size for UNITY_BUILD targets without UNITY_BUILD_BATCH_SIZE
+        size_t unity_batch_size = 8;
+        // Normalize and dedupe flags, and hoist flags shared by all targets into .buckconfig
+        bool canonicalize_flags = true;
+        bool hoist_common_flags = true;
     };
 
     struct GenerationResult {
         std::vector<std::filesystem::path> generated_files;
         size_t targets_processed;
         std::vector<std::string> warnings;
+        FlagCanonicalizer::Report flag_report;
     };
 
     explicit Generator(const Config& config);
@@ -44,10 +55,12 @@ class Generator {
     std::unique_ptr<TemplateRegistry> template_registry_;
     Config config_;
 
-    Result<void, GenerationError> generate_buck_file(const std::filesystem::path& output_path,
-                                                     const std::vector<analyzer::Target>& targets);
+    Result<void, GenerationError>
+    generate_buck_file(const std::filesystem::path& output_path,
+                       const std::vector<TargetMapper::MappedTarget>& targets);
 
-    Result<void, GenerationError> generate_buckconfig(const analyzer::ProjectAnalysis& analysis);
+    Result<void, GenerationError> generate_buckconfig(const analyzer::ProjectAnalysis& analysis,
+                                                      const FlagCanonicalizer::Report& flags);
 
     Result<void, GenerationError> write_file(const std::filesystem::path& path,
                                              const std::string& content);
@@ -38,6 +38,30 @@ class CxxTestTemplate : public RuleTemplate {
     }
 };
 
+class GenruleTemplate : public RuleTemplate {
+  public:
+    std::string generate(const TargetMapper::MappedTarget& target) const override;
+    std::string rule_type() const override {
+        return "genrule";
+    }
+};
+
+class PrebuiltCxxLibraryTemplate : public RuleTemplate {
+  public:
+    std::string generate(const TargetMapper::MappedTarget& target) const override;
+    std::string rule_type() const override {
+        return "prebuilt_cxx_library";
+    }
+};
+
+class HttpArchiveTemplate : public RuleTemplate {
+  public:
+    std::string generate(const TargetMapper::MappedTarget& target) const override;
+    std::string rule_type() const override {
+        return "http_archive";
+    }
+};
+
 class TemplateRegistry {
   public:
     TemplateRegistry();
@@ -1,15 +1,21 @@
 #pragma once
 
 #include <finch/core/error.hpp>
+#include <finch/core/path_table.hpp>
 #include <finch/core/result.hpp>
+#include <cstdint>
 #include <map>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace finch::analyzer {
+struct CPMPackage;
+struct ExternalPackage;
+class PlatformSet;
 struct Target;
-}
+} // namespace finch::analyzer
 
 namespace finch::generator {
 
@@ -20,6 +26,7 @@ enum class Buck2RuleType {
     FileGroup,
     PrebuiltCxxLibrary,
     HttpArchive,
+    Genrule,
     Unknown
 };
 
@@ -41,8 +48,17 @@ class TargetMapper {
         std::vector<std::string> srcs;
         std::vector<std::string> headers;
         std::vector<std::string> deps;
+        // Kept as lists until rendering so they can be canonicalized across targets
+        std::vector<std::string> preprocessor_flags;
+        std::vector<std::string> compiler_flags;
         std::map<std::string, std::string> properties;
-        std::optional<PlatformSelect> platform_config;
+        // What only some platforms add to an attribute (srcs, deps,
+        // preprocessor_flags, ...), keyed by attribute name
+        std::map<std::string, PlatformSelect> platform_selects;
+        // Constraints of the platforms defining the target, when not all do
+        std::vector<std::string> compatible_with;
+        // Rules that produce sources for this target (e.g. unity build batches)
+        std::vector<MappedTarget> generated_sources;
     };
 
     TargetMapper();
@@ -50,9 +66,49 @@ class TargetMapper {
 
     Result<MappedTarget, GenerationError> map_cmake_target(const analyzer::Target& cmake_target);
 
+    // Generator expressions are lowered for these platforms, those of the
+    // run; every known platform when unset
+    void set_platforms(const analyzer::PlatformSet* platforms) {
+        platforms_ = platforms;
+    }
+
+    // Imported targets of these packages (fmt::fmt, PkgConfig::GLIB) resolve
+    // to their prebuilt_cxx_library rules under //third_party
+    void set_external_packages(const std::vector<analyzer::ExternalPackage>& packages);
+
+    // A prebuilt_cxx_library exporting an installed package's headers and libraries
+    MappedTarget map_external_package(const analyzer::ExternalPackage& package);
+
+    // Label of the rule map_external_package() produces
+    std::string external_package_label(const analyzer::ExternalPackage& package);
+
+    // An http_archive downloading a CPM package's sources; nullopt when they
+    // do not come from an archive, e.g. a local directory or a git server
+    // other than GitHub
+    std::optional<MappedTarget> map_cpm_package(const analyzer::CPMPackage& package);
+
+    // Batch size used when a unity target does not set UNITY_BUILD_BATCH_SIZE.
+    // Zero puts all sources of a target into a single batch, as in CMake.
+    void set_default_unity_batch_size(size_t batch_size) {
+        default_unity_batch_size_ = batch_size;
+    }
+
+    // Split sources into at most ceil(n / batch_size) batches of at most batch_size
+    // sources each, balancing the total byte size of every batch
+    static std::vector<std::vector<std::string>>
+    partition_unity_batches(const std::vector<std::string>& sources,
+                            const std::vector<uintmax_t>& source_sizes, size_t batch_size);
+
   private:
+    size_t default_unity_batch_size_ = 8; // CMake's UNITY_BUILD_BATCH_SIZE default
+    const analyzer::PlatformSet* platforms_ = nullptr;
+    std::unordered_map<std::string, std::vector<std::string>> external_labels_;
+
+    void map_unity_build(const analyzer::Target& cmake_target, MappedTarget& mapped);
     Buck2RuleType determine_rule_type(const analyzer::Target& target);
-    std::vector<std::string> transform_sources(const std::vector<std::string>& sources);
+    std::vector<std::string> transform_sources(const PathList& sources);
+    // select() clauses for what analyzer::Target::platform_variants adds
+    void map_platform_variants(const analyzer::Target& cmake_target, MappedTarget& mapped);
     std::vector<std::string> resolve_dependencies(const std::vector<std::string>& deps);
     std::string normalize_target_name(const std::string& cmake_name);
 };
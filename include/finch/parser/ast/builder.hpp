@@ -5,6 +5,7 @@
 #include "expressions.hpp"
 #include "literals.hpp"
 #include "node.hpp"
+#include "structural_hash.hpp"
 #include "structure.hpp"
 #include <finch/core/result.hpp>
 #include <memory>
@@ -29,10 +30,19 @@ class ASTBuilder {
         return interner_;
     }
 
-    /// Factory methods for creating nodes
+    /// Factory methods for creating nodes. Children are built first, so
+    /// each node's structural hash is computed from theirs as it is made.
     template <typename T, typename... Args>
     static std::unique_ptr<T> make(Args&&... args) {
-        return std::make_unique<T>(std::forward<Args>(args)...);
+        auto node = std::make_unique<T>(std::forward<Args>(args)...);
+        node->set_structural_hash(compute_structural_hash(*node));
+        return node;
+    }
+
+    /// Hash a node again once the parser has added to it, as elseif() and
+    /// else() branches are added to an if()
+    static void rehash(ASTNode& node) {
+        node.set_structural_hash(compute_structural_hash(node));
     }
 
     /// Create a string literal
@@ -61,9 +71,10 @@ class ASTBuilder {
 
     /// Create a variable reference
     ASTNodePtr makeVariable(SourceLocation loc, std::string_view name,
-                            Variable::VariableType type = Variable::VariableType::Normal) {
+                            Variable::VariableType type = Variable::VariableType::Normal,
+                            bool quoted = false) {
         auto interned = interner_.intern(name);
-        return make<Variable>(std::move(loc), interned, type);
+        return make<Variable>(std::move(loc), interned, type, quoted);
     }
 
     /// Create an identifier
@@ -125,8 +136,9 @@ class ASTBuilder {
     }
 
     /// Create a list expression
-    ASTNodePtr makeList(SourceLocation loc, ASTNodeList elements, char separator = ' ') {
-        return make<ListExpression>(std::move(loc), std::move(elements), separator);
+    ASTNodePtr makeList(SourceLocation loc, ASTNodeList elements, char separator = ' ',
+                        bool quoted = false) {
+        return make<ListExpression>(std::move(loc), std::move(elements), separator, quoted);
     }
 
     /// Create a generator expression
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "node.hpp"
+#include "structural_hash.hpp"
 #include <fmt/format.h>
 #include <optional>
 #include <string>
@@ -9,12 +10,14 @@
 
 namespace finch::ast {
 
+class ElseIfStatement;
+
 /// If statement
 class IfStatement : public ASTNode {
   private:
     ASTNodePtr condition_;
     ASTNodeList then_branch_;
-    ASTNodeList elseif_branches_; // Pairs of condition and body
+    ASTNodeList elseif_branches_; // Each an ElseIfStatement followed by its body
     ASTNodeList else_branch_;     // May be empty
 
   public:
@@ -45,13 +48,7 @@ class IfStatement : public ASTNode {
         return else_branch_;
     }
 
-    void add_elseif(ASTNodePtr condition, ASTNodeList body) {
-        elseif_branches_.push_back(std::move(condition));
-        // Store body elements after condition
-        for (auto& stmt : body) {
-            elseif_branches_.push_back(std::move(stmt));
-        }
-    }
+    void add_elseif(ASTNodePtr condition, ASTNodeList body);
 
     void set_else_branch(ASTNodeList else_body) {
         else_branch_ = std::move(else_body);
@@ -69,11 +66,10 @@ class IfStatement : public ASTNode {
             result += stmt->pretty_print(indent + 2) + "\n";
         }
 
-        // Handle elseif branches (stored as condition, body, condition, body...)
+        // Handle elseif branches (stored as elseif(), body, elseif(), body...)
         for (size_t i = 0; i < elseif_branches_.size();) {
             if (i + 1 < elseif_branches_.size()) {
-                result += std::string(indent, ' ') +
-                          fmt::format("elseif({})\n", elseif_branches_[i]->to_string());
+                result += std::string(indent, ' ') + elseif_branches_[i]->to_string() + "\n";
                 i++; // Skip condition
 
                 // Print body until next condition or end
@@ -262,6 +258,17 @@ class ElseIfStatement : public ASTNode {
     }
 };
 
+inline void IfStatement::add_elseif(ASTNodePtr condition, ASTNodeList body) {
+    // The ElseIfStatement marks where each branch's body starts
+    auto location = condition->location();
+    auto marker = std::make_unique<ElseIfStatement>(std::move(location), std::move(condition));
+    marker->set_structural_hash(compute_structural_hash(*marker));
+    elseif_branches_.push_back(std::move(marker));
+    for (auto& stmt : body) {
+        elseif_branches_.push_back(std::move(stmt));
+    }
+}
+
 /// Else statement (for better AST structure)
 class ElseStatement : public ASTNode {
   public:
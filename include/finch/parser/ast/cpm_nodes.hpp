@@ -312,6 +312,8 @@ class CPMDeclarePackage : public ASTNode {
     std::string version_;
     std::optional<std::string> github_repository_;
     std::optional<std::string> git_repository_;
+    std::optional<std::string> url_;
+    std::optional<std::string> git_tag_;
 
   public:
     CPMDeclarePackage(SourceLocation loc, std::string name)
@@ -339,6 +341,16 @@ class CPMDeclarePackage : public ASTNode {
         return *this;
     }
 
+    CPMDeclarePackage& set_url(std::string url) {
+        url_ = std::move(url);
+        return *this;
+    }
+
+    CPMDeclarePackage& set_git_tag(std::string tag) {
+        git_tag_ = std::move(tag);
+        return *this;
+    }
+
     // Getters
     [[nodiscard]] const std::string& name() const {
         return name_;
@@ -352,6 +364,12 @@ class CPMDeclarePackage : public ASTNode {
     [[nodiscard]] const std::optional<std::string>& git_repository() const {
         return git_repository_;
     }
+    [[nodiscard]] const std::optional<std::string>& url() const {
+        return url_;
+    }
+    [[nodiscard]] const std::optional<std::string>& git_tag() const {
+        return git_tag_;
+    }
 
     [[nodiscard]] std::string to_string() const override {
         return fmt::format("CPMDeclarePackage(name={}, version={})", name_, version_);
@@ -372,6 +390,14 @@ class CPMDeclarePackage : public ASTNode {
             result += ind + fmt::format("git_repository: {}\n", *git_repository_);
         }
 
+        if (url_.has_value()) {
+            result += ind + fmt::format("url: {}\n", *url_);
+        }
+
+        if (git_tag_.has_value()) {
+            result += ind + fmt::format("git_tag: {}\n", *git_tag_);
+        }
+
         result += std::string(indent, ' ') + ")";
         return result;
     }
@@ -382,6 +408,8 @@ class CPMDeclarePackage : public ASTNode {
         cloned->version_ = version_;
         cloned->github_repository_ = github_repository_;
         cloned->git_repository_ = git_repository_;
+        cloned->url_ = url_;
+        cloned->git_tag_ = git_tag_;
         return cloned;
     }
 };
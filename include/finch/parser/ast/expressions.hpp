@@ -13,10 +13,13 @@ class ListExpression : public ASTNode {
   private:
     ASTNodeList elements_;
     char separator_; // ' ' or ';'
+    bool quoted_;    // The parts of one quoted argument, as in "${prefix};lib"
 
   public:
-    ListExpression(SourceLocation loc, ASTNodeList elements, char separator = ' ')
-        : ASTNode(std::move(loc)), elements_(std::move(elements)), separator_(separator) {}
+    ListExpression(SourceLocation loc, ASTNodeList elements, char separator = ' ',
+                   bool quoted = false)
+        : ASTNode(std::move(loc)), elements_(std::move(elements)), separator_(separator),
+          quoted_(quoted) {}
 
     void accept(ASTVisitor& visitor) const override;
     [[nodiscard]] std::unique_ptr<ASTNode> clone() const override;
@@ -33,6 +36,10 @@ class ListExpression : public ASTNode {
         return separator_;
     }
 
+    [[nodiscard]] bool is_quoted() const {
+        return quoted_;
+    }
+
     [[nodiscard]] size_t size() const {
         return elements_.size();
     }
@@ -44,11 +51,11 @@ class ListExpression : public ASTNode {
     [[nodiscard]] std::string to_string() const override {
         std::string result;
         for (size_t i = 0; i < elements_.size(); ++i) {
-            if (i > 0)
+            if (i > 0 && !quoted_)
                 result += separator_;
             result += elements_[i]->to_string();
         }
-        return result;
+        return quoted_ ? fmt::format("\"{}\"", result) : result;
     }
 };
 
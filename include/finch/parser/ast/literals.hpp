@@ -140,11 +140,12 @@ class Variable : public ASTNode {
   private:
     std::string_view name_; // Interned variable name
     VariableType var_type_;
+    bool quoted_; // The whole of a quoted argument, as in "${SOURCES}"
 
   public:
     Variable(SourceLocation loc, std::string_view name,
-             VariableType var_type = VariableType::Normal)
-        : ASTNode(std::move(loc)), name_(name), var_type_(var_type) {}
+             VariableType var_type = VariableType::Normal, bool quoted = false)
+        : ASTNode(std::move(loc)), name_(name), var_type_(var_type), quoted_(quoted) {}
 
     void accept(ASTVisitor& visitor) const override;
 
@@ -168,20 +169,28 @@ class Variable : public ASTNode {
         return var_type_ == VariableType::Cache;
     }
 
+    [[nodiscard]] bool is_quoted() const {
+        return quoted_;
+    }
+
     [[nodiscard]] std::string to_string() const override {
+        std::string reference;
         switch (var_type_) {
         case VariableType::Normal:
-            return fmt::format("${{{}}}", name_);
+            reference = fmt::format("${{{}}}", name_);
+            break;
         case VariableType::Environment:
-            return fmt::format("$ENV{{{}}}", name_);
+            reference = fmt::format("$ENV{{{}}}", name_);
+            break;
         case VariableType::Cache:
-            return fmt::format("$CACHE{{{}}}", name_);
+            reference = fmt::format("$CACHE{{{}}}", name_);
+            break;
         }
-        return ""; // Unreachable
+        return quoted_ ? fmt::format("\"{}\"", reference) : reference;
     }
 
     [[nodiscard]] std::unique_ptr<ASTNode> clone() const override {
-        return std::make_unique<Variable>(location_, name_, var_type_);
+        return std::make_unique<Variable>(location_, name_, var_type_, quoted_);
     }
 };
 
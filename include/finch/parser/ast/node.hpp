@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <finch/core/error.hpp>
 #include <fmt/format.h>
 #include <memory>
@@ -63,7 +64,8 @@ enum class NodeType {
 class ASTNode {
   protected:
     SourceLocation location_;
-    bool is_error_ = false; // For error recovery
+    bool is_error_ = false;        // For error recovery
+    uint64_t structural_hash_ = 0; // Set by ASTBuilder, 0 until then
 
   public:
     explicit ASTNode(SourceLocation location) : location_(std::move(location)) {}
@@ -99,6 +101,15 @@ class ASTNode {
         is_error_ = true;
     }
 
+    /// Hash of this subtree ignoring locations, as compute_structural_hash()
+    /// in structural_hash.hpp; ASTBuilder sets it bottom-up while parsing
+    /// and it is computed on the spot for nodes built some other way
+    [[nodiscard]] uint64_t structural_hash() const;
+
+    void set_structural_hash(uint64_t hash) {
+        structural_hash_ = hash;
+    }
+
     /// Debugging
     [[nodiscard]] virtual std::string to_string() const = 0;
 
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "node.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+
+namespace finch::ast {
+
+/// Hash of a subtree's structure: node types, names, literal text, flags
+/// and the hashes of its children in order. Locations, file paths and the
+/// whitespace and comments the parser drops take no part, so equal blocks
+/// anywhere in any file hash alike. Uses the hashes children already carry.
+[[nodiscard]] uint64_t compute_structural_hash(const ASTNode& node);
+
+/// True when a and b are the same tree but for locations; hashes first
+[[nodiscard]] bool structurally_equal(const ASTNode& a, const ASTNode& b);
+
+/// Bytes the nodes of a subtree and their child lists take, not counting
+/// interned strings
+[[nodiscard]] size_t subtree_bytes(const ASTNode& node);
+
+/// Measures how much memory sharing equal subtrees would save over a
+/// corpus of files: a subtree equal to one measured before counts as shared
+/// whole. Only hashes are kept, never the trees, so files whose parsers are
+/// gone can be measured together. Safe to use concurrently.
+class SubtreeSharingMeter {
+  public:
+    struct Stats {
+        size_t nodes = 0;        // Measured
+        size_t shared_nodes = 0; // Of those, in a subtree equal to an earlier one
+        size_t bytes = 0;
+        size_t bytes_saved = 0; // Had those been shared
+
+        [[nodiscard]] std::string to_string() const;
+    };
+
+    /// Count root's subtrees; equal hashes count as equal subtrees
+    void measure(const ASTNode& root);
+
+    [[nodiscard]] Stats stats() const;
+
+  private:
+    mutable std::mutex mutex_;
+    std::unordered_set<uint64_t> measured_;
+    Stats stats_;
+};
+
+} // namespace finch::ast
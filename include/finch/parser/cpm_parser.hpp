@@ -30,7 +30,7 @@ class CPMParser {
     parse_cpm_add_package(const ast::ASTNodeList& args);
 
     [[nodiscard]] Result<std::unique_ptr<ast::CPMAddPackage>, ParseError>
-    parse_cpm_add_package_shorthand(const std::string& shorthand);
+    parse_cpm_add_package_shorthand(const std::string& shorthand, const SourceLocation& loc);
 
     [[nodiscard]] Result<std::unique_ptr<ast::CPMAddPackage>, ParseError>
     parse_cpm_add_package_full(const ast::ASTNodeList& args);
@@ -51,8 +51,8 @@ class CPMParser {
     [[nodiscard]] Result<ast::CPMVersion, ParseError>
     parse_version_string(const std::string& version_str);
 
-    [[nodiscard]] Result<void, ParseError> parse_options_block(ast::CPMAddPackage& package,
-                                                               const ast::ASTNodeList& options);
+    [[nodiscard]] Result<void, ParseError>
+    parse_options_block(ast::CPMAddPackage& package, const std::vector<std::string>& options);
 
     [[nodiscard]] bool is_github_shorthand(const std::string& str) const;
 
@@ -62,13 +62,13 @@ class CPMParser {
     // Utility to extract string from AST node
     [[nodiscard]] Result<std::string, ParseError> get_string_value(const ast::ASTNode* node) const;
 
-    // Utility to find argument by name
-    [[nodiscard]] const ast::ASTNode* find_argument(const ast::ASTNodeList& args,
-                                                    const std::string& name) const;
+    // Utility to rebuild an argument's text with its ${...} references left
+    // for the evaluator to expand
+    [[nodiscard]] Result<std::string, ParseError> get_unexpanded_text(const ast::ASTNode* node) const;
 
-    // Utility to collect arguments after a key
-    [[nodiscard]] std::vector<const ast::ASTNode*>
-    collect_arguments_after(const ast::ASTNodeList& args, const std::string& key) const;
+    // Utility to read every argument once as the word a KeywordSchema
+    // partitions; arguments that are not literal text read as ""
+    [[nodiscard]] std::vector<std::string> literal_words(const ast::ASTNodeList& args) const;
 };
 
 } // namespace finch::parser
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace finch::parser {
+
+/// How a keyword takes values, as in cmake_parse_arguments()
+enum class KeywordKind : uint8_t {
+    Option,    // Present or not; takes no value
+    OneValue,  // Takes the word after it
+    MultiValue // Takes every word up to the next keyword
+};
+
+struct Keyword {
+    std::string_view name;
+    KeywordKind kind;
+};
+
+/// The words of one call partitioned by a KeywordSchema<N>. Slot i holds the
+/// positions of the words the schema's i-th keyword took; words no keyword
+/// took are positional. Positions index the caller's word list, so AST nodes
+/// and evaluated strings partition the same way.
+template <size_t N> class ParsedArguments {
+  public:
+    /// Whether the keyword in slot occurred at all
+    [[nodiscard]] bool has(size_t slot) const {
+        return seen_[slot] != 0;
+    }
+
+    /// Every value of slot in call order; a repeated multi-value keyword
+    /// accumulates, as cmake_parse_arguments() does
+    [[nodiscard]] std::span<const uint32_t> values(size_t slot) const {
+        return {positions_.data() + offsets_[slot], positions_.data() + offsets_[slot + 1]};
+    }
+
+    /// The value of a one-value keyword; the last one when it is repeated
+    [[nodiscard]] std::optional<size_t> value(size_t slot) const {
+        auto taken = values(slot);
+        return taken.empty() ? std::nullopt : std::optional<size_t>(taken.back());
+    }
+
+    /// Words before the first keyword and words after a one-value keyword's
+    /// value, in call order
+    [[nodiscard]] std::span<const uint32_t> positional() const {
+        return values(N);
+    }
+
+    /// The values of several slots merged back into call order, as for the
+    /// items of target_link_libraries(<target> PUBLIC a PRIVATE b PUBLIC c)
+    [[nodiscard]] std::vector<uint32_t> values(std::initializer_list<size_t> slots) const {
+        std::vector<uint32_t> merged;
+        for (auto slot : slots) {
+            auto middle = merged.size();
+            merged.insert(merged.end(), values(slot).begin(), values(slot).end());
+            std::inplace_merge(merged.begin(), merged.begin() + static_cast<ptrdiff_t>(middle),
+                               merged.end());
+        }
+        return merged;
+    }
+
+    /// The slot that stands for positional words in values()
+    static constexpr size_t positional_slot = N;
+
+  private:
+    template <size_t> friend class KeywordSchema;
+
+    std::array<uint32_t, N> seen_{};
+    std::array<uint32_t, N + 2> offsets_{};
+    std::vector<uint32_t> positions_;
+};
+
+/// A cmake_parse_arguments()-style keyword table, built at compile time:
+///
+///     constexpr KeywordSchema<2> schema({{{"NAME", KeywordKind::OneValue},
+///                                          {"OPTIONS", KeywordKind::MultiValue}}});
+///     constexpr size_t NAME = schema.slot("NAME");
+///
+/// partition() looks every word up once, rejecting most non-keywords by
+/// length and first character before a binary search of the sorted names,
+/// and buckets the words into slots so that callers read each keyword's
+/// values directly instead of rescanning the arguments per keyword.
+template <size_t N> class KeywordSchema {
+    static_assert(N > 0 && N < 255, "a schema has between 1 and 254 keywords");
+
+  public:
+    constexpr explicit KeywordSchema(std::array<Keyword, N> keywords) : keywords_(keywords) {
+        for (size_t i = 0; i < N; ++i) {
+            sorted_[i] = static_cast<uint8_t>(i);
+        }
+        std::sort(sorted_.begin(), sorted_.end(), [&](uint8_t a, uint8_t b) {
+            return keywords_[a].name < keywords_[b].name;
+        });
+        for (size_t i = 0; i < N; ++i) {
+            const auto name = keywords_[sorted_[i]].name;
+            if (name.empty() || (i > 0 && name == keywords_[sorted_[i - 1]].name)) {
+                throw std::logic_error("keyword names must be unique and non-empty");
+            }
+            min_length_ = std::min(min_length_, name.size());
+            max_length_ = std::max(max_length_, name.size());
+            auto first = static_cast<unsigned char>(name[0]);
+            first_chars_[first / 64] |= uint64_t{1} << (first % 64);
+        }
+    }
+
+    [[nodiscard]] static constexpr size_t size() {
+        return N;
+    }
+
+    [[nodiscard]] constexpr const Keyword& keyword(size_t slot) const {
+        return keywords_[slot];
+    }
+
+    /// The slot of a keyword; naming one the schema lacks fails to compile
+    /// when called in a constant expression
+    [[nodiscard]] constexpr size_t slot(std::string_view name) const {
+        auto found = find(name);
+        if (!found) {
+            throw std::logic_error("keyword is not in the schema");
+        }
+        return *found;
+    }
+
+    /// The slot of word when it is a keyword
+    [[nodiscard]] constexpr std::optional<size_t> find(std::string_view word) const {
+        if (word.size() < min_length_ || word.size() > max_length_) {
+            return std::nullopt;
+        }
+        auto first = static_cast<unsigned char>(word[0]);
+        if ((first_chars_[first / 64] & (uint64_t{1} << (first % 64))) == 0) {
+            return std::nullopt;
+        }
+        size_t low = 0;
+        size_t high = N;
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+            auto name = keywords_[sorted_[middle]].name;
+            if (name == word) {
+                return sorted_[middle];
+            }
+            if (name < word) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        return std::nullopt;
+    }
+
+    /// Partition count words in one pass. word(i) gives the text of word i;
+    /// words that are not literal text (an unexpanded ${var}, say) should give
+    /// an empty view, which never matches a keyword. The first `leading`
+    /// words are positional whatever they say, like PARSE_ARGV <N>.
+    template <typename WordAt>
+    [[nodiscard]] ParsedArguments<N> partition(size_t count, WordAt&& word,
+                                               size_t leading = 0) const {
+        constexpr uint8_t positional = N;
+        constexpr uint8_t keyword_word = N + 1;
+
+        ParsedArguments<N> parsed;
+        std::vector<uint8_t> owner(count, positional);
+        std::array<uint32_t, N + 1> counts{};
+        uint8_t current = positional;
+        for (size_t i = 0; i < count; ++i) {
+            if (i >= leading) {
+                if (auto found = find(std::string_view(word(i)))) {
+                    auto slot = static_cast<uint8_t>(*found);
+                    ++parsed.seen_[slot];
+                    owner[i] = keyword_word;
+                    current = keywords_[slot].kind == KeywordKind::Option ? positional : slot;
+                    continue;
+                }
+            }
+            owner[i] = current;
+            ++counts[current];
+            if (current != positional && keywords_[current].kind == KeywordKind::OneValue) {
+                current = positional;
+            }
+        }
+
+        for (size_t slot = 0; slot <= N; ++slot) {
+            parsed.offsets_[slot + 1] = parsed.offsets_[slot] + counts[slot];
+        }
+        parsed.positions_.resize(parsed.offsets_[N + 1]);
+        std::array<uint32_t, N + 1> next{};
+        std::copy(parsed.offsets_.begin(), parsed.offsets_.begin() + N + 1, next.begin());
+        for (size_t i = 0; i < count; ++i) {
+            if (owner[i] != keyword_word) {
+                parsed.positions_[next[owner[i]]++] = static_cast<uint32_t>(i);
+            }
+        }
+        return parsed;
+    }
+
+    /// Partition a list of words
+    template <typename Word>
+    [[nodiscard]] ParsedArguments<N> partition(const std::vector<Word>& words,
+                                               size_t leading = 0) const {
+        return partition(
+            words.size(), [&](size_t i) -> std::string_view { return words[i]; }, leading);
+    }
+
+  private:
+    std::array<Keyword, N> keywords_;
+    std::array<uint8_t, N> sorted_{};
+    std::array<uint64_t, 4> first_chars_{};
+    size_t min_length_ = static_cast<size_t>(-1);
+    size_t max_length_ = 0;
+};
+
+} // namespace finch::parser
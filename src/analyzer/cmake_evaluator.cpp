@@ -1,6 +1,24 @@
 #include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstdlib>
 #include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/cpm_package_lock.hpp>
+#include <finch/analyzer/cpm_resolver.hpp>
+#include <finch/analyzer/directory_snapshot.hpp>
+#include <finch/analyzer/evaluation_snapshot.hpp>
+#include <finch/analyzer/feature_probes.hpp>
+#include <finch/analyzer/generator_expression.hpp>
+#include <finch/analyzer/intrinsics.hpp>
+#include <finch/analyzer/list_command.hpp>
+#include <finch/analyzer/package_index.hpp>
+#include <finch/analyzer/platforms.hpp>
+#include <finch/analyzer/program_slice.hpp>
+#include <finch/analyzer/string_command.hpp>
+#include <finch/analyzer/version.hpp>
 #include <finch/core/logging.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <finch/core/parallel.hpp>
 #include <finch/parser/ast/commands.hpp>
 #include <finch/parser/ast/control_flow.hpp>
 #include <finch/parser/ast/cpm_nodes.hpp>
@@ -8,13 +26,30 @@
 #include <finch/parser/ast/literals.hpp>
 #include <finch/parser/ast/node.hpp>
 #include <finch/parser/ast/structure.hpp>
+#include <finch/parser/keyword_schema.hpp>
+#include <finch/parser/parser.hpp>
 #include <fmt/format.h>
+#include <fstream>
 #include <regex>
+#include <sstream>
 
 namespace finch::analyzer {
 
 using namespace finch::ast;
 
+namespace {
+
+// An unquoted keyword argument such as PARENT_SCOPE
+bool is_word(const ast::ASTNode& node, std::string_view word) {
+    if (const auto* identifier = dynamic_cast<const ast::Identifier*>(&node)) {
+        return identifier->name() == word;
+    }
+    const auto* literal = dynamic_cast<const ast::StringLiteral*>(&node);
+    return literal && !literal->is_quoted() && literal->value() == word;
+}
+
+} // namespace
+
 Result<EvaluatedValue, AnalysisError> CMakeEvaluator::evaluate(const ast::ASTNode& node) {
     result_ = Result<EvaluatedValue, AnalysisError>(std::in_place_index<1>,
                                                     AnalysisError("Not evaluated"));
@@ -22,6 +57,83 @@ Result<EvaluatedValue, AnalysisError> CMakeEvaluator::evaluate(const ast::ASTNod
     return result_;
 }
 
+void CMakeEvaluator::evaluate_statement(const ast::ASTNode& statement) {
+    if (slice_ && !slice_->contains(statement)) {
+        return;
+    }
+    if (std::has_single_bit(context_.active_platforms())) {
+        evaluate_counted(statement);
+        return;
+    }
+    auto groups = context_.platform_groups(statement_reads(statement));
+    if (groups.size() > 1) {
+        evaluate_per_platform(statement, groups);
+    } else {
+        evaluate_counted(statement);
+    }
+}
+
+void CMakeEvaluator::evaluate_counted(const ast::ASTNode& statement) {
+    auto result = evaluate(statement);
+    if (result.has_error()) {
+        ++failed_statements_;
+        LOG_DEBUG("{}:{}: {}", statement.location().file, statement.location().line,
+                  result.error().message());
+    }
+}
+
+void CMakeEvaluator::evaluate_statements(const ast::ASTNodeList& statements) {
+    // A run of add_subdirectory() calls each evaluated for all active platforms
+    auto sibling = [&](size_t i) -> const ast::CommandCall* {
+        const auto* cmd = dynamic_cast<const ast::CommandCall*>(statements[i].get());
+        if (!cmd || cmd->name() != "add_subdirectory" || (slice_ && !slice_->contains(*cmd))) {
+            return nullptr;
+        }
+        bool together = std::has_single_bit(context_.active_platforms()) ||
+                        context_.platform_groups(statement_reads(*cmd)).size() == 1;
+        return together ? cmd : nullptr;
+    };
+
+    for (size_t i = 0; i < statements.size();) {
+        std::vector<const ast::CommandCall*> siblings;
+        for (const ast::CommandCall* cmd;
+             i + siblings.size() < statements.size() && (cmd = sibling(i + siblings.size()));) {
+            siblings.push_back(cmd);
+        }
+        if (siblings.size() > 1) {
+            // Each sibling that fails counts as one failed statement, as
+            // it would evaluated on its own
+            auto errors = evaluate_subdirectories(siblings);
+            for (size_t k = 0; k < siblings.size(); ++k) {
+                if (errors[k]) {
+                    ++failed_statements_;
+                    LOG_DEBUG("{}:{}: {}", siblings[k]->location().file,
+                              siblings[k]->location().line, errors[k]->message());
+                }
+            }
+            i += siblings.size();
+            continue;
+        }
+        evaluate_statement(*statements[i++]);
+    }
+}
+
+void CMakeEvaluator::evaluate_per_platform(const ast::ASTNode& statement,
+                                           const std::vector<PlatformMask>& groups) {
+    // Each group starts from the state before the statement; the changes
+    // they make converge again in the merge
+    auto active = context_.active_platforms();
+    std::vector<std::pair<PlatformMask, EvaluationContext::PlatformChanges>> changes;
+    for (auto group : groups) {
+        context_.set_active_platforms(group);
+        context_.begin_platform_changes();
+        evaluate_counted(statement);
+        changes.emplace_back(group, context_.undo_platform_changes());
+    }
+    context_.set_active_platforms(active);
+    context_.merge_platform_changes(std::move(changes));
+}
+
 void CMakeEvaluator::visit(const ast::StringLiteral& node) {
     // Try to interpolate variables in string
     std::string str_value(node.value());
@@ -51,6 +163,9 @@ void CMakeEvaluator::visit(const ast::BooleanLiteral& node) {
 void CMakeEvaluator::visit(const ast::Variable& node) {
     std::string var_name(node.name()); // Convert string_view to string
     auto value = context_.get_variable(var_name);
+    if (!value) {
+        value = context_.get_cache_variable(var_name);
+    }
     if (value) {
         result_ = Result<EvaluatedValue, AnalysisError>(*value);
     } else {
@@ -92,6 +207,26 @@ void CMakeEvaluator::visit(const ast::CommandCall& node) {
         result_ = evaluate_target_link_libraries_command(node);
     } else if (name == "target_compile_definitions") {
         result_ = evaluate_target_compile_definitions_command(node);
+    } else if (name == "set_target_properties") {
+        result_ = evaluate_set_target_properties_command(node);
+    } else if (name == "find_package") {
+        result_ = evaluate_find_package_command(node);
+    } else if (name == "pkg_check_modules" || name == "pkg_search_module") {
+        result_ = evaluate_pkg_config_command(node, name == "pkg_search_module");
+    } else if (name.starts_with("check_") || name == "try_compile") {
+        result_ = evaluate_feature_check_command(node);
+    } else if (name == "include") {
+        result_ = evaluate_include_command(node);
+    } else if (name == "add_subdirectory") {
+        result_ = evaluate_add_subdirectory_command(node);
+    } else if (name == "list") {
+        result_ = evaluate_list_command(node);
+    } else if (name == "string") {
+        result_ = evaluate_string_command(node);
+    } else if (name == "file") {
+        result_ = evaluate_file_command(node);
+    } else if (const auto* intrinsic = IntrinsicRegistry::builtin().find_command(name)) {
+        result_ = evaluate_intrinsic_command(node, *intrinsic);
     } else {
         // Unknown command - don't evaluate
         LOG_TRACE("Unknown command for evaluation: {}", name);
@@ -118,20 +253,34 @@ CMakeEvaluator::evaluate_set_command(const ast::CommandCall& cmd) {
 
     auto var_name = std::get<std::string>(name_result.value().value);
 
+    // set(<variable> <value>... PARENT_SCOPE) and
+    // set(<variable> <value>... CACHE <type> <docstring> [FORCE])
+    size_t end = args.size();
+    bool parent_scope = is_word(*args.back(), "PARENT_SCOPE");
+    end -= parent_scope ? 1 : 0;
+    std::optional<size_t> cache;
+    for (size_t i = 1; i < end && !cache; ++i) {
+        if (is_word(*args[i], "CACHE")) {
+            cache = i;
+        }
+    }
+    bool force = cache && is_word(*args.back(), "FORCE");
+    end = cache.value_or(end);
+
     // Handle special set() forms
-    if (args.size() == 2) {
+    std::optional<EvaluatedValue> value;
+    if (end == 2) {
         // Single value
         auto value_result = evaluate(*args[1]);
         if (value_result.has_value()) {
-            context_.set_variable(var_name, value_result.value().value,
-                                  value_result.value().confidence);
+            value = value_result.value();
         }
-    } else {
+    } else if (end > 2) {
         // Multiple values - create a list
         std::vector<std::string> list_values;
         Confidence min_confidence = Confidence::Certain;
 
-        for (size_t i = 1; i < args.size(); ++i) {
+        for (size_t i = 1; i < end; ++i) {
             auto value_result = evaluate(*args[i]);
             if (value_result.has_error()) {
                 min_confidence = Confidence::Unknown;
@@ -143,7 +292,18 @@ CMakeEvaluator::evaluate_set_command(const ast::CommandCall& cmd) {
             min_confidence = std::min(min_confidence, value_result.value().confidence);
         }
 
-        context_.set_variable(var_name, list_values, min_confidence);
+        value = EvaluatedValue{list_values, min_confidence};
+    }
+
+    if (cache) {
+        // The cache keeps an existing entry unless forced
+        if (value && (force || !context_.get_cache_variable(var_name))) {
+            context_.set_cache_variable(var_name, std::move(value->value), value->confidence);
+        }
+    } else if (parent_scope) {
+        context_.set_parent_scope_variable(var_name, std::move(value));
+    } else if (value) {
+        context_.set_variable(var_name, std::move(value->value), value->confidence);
     }
 
     return Result<EvaluatedValue, AnalysisError>(
@@ -274,6 +434,76 @@ CMakeEvaluator::expand_variable_reference(const std::string& var_name) {
 }
 
 Result<bool, AnalysisError> CMakeEvaluator::evaluate_condition(const ast::ASTNode& condition) {
+    // A bare name answered by a configure check or a seeded platform check
+    std::optional<std::string> name;
+    if (const auto* identifier = dynamic_cast<const ast::Identifier*>(&condition)) {
+        name = std::string(identifier->name());
+    } else if (const auto* literal = dynamic_cast<const ast::StringLiteral*>(&condition);
+               literal && !literal->is_quoted()) {
+        name = std::string(literal->value());
+    }
+    if (name) {
+        if (auto check = context_.get_platform_check(*name)) {
+            return Result<bool, AnalysisError>(*check);
+        }
+        // if(<variable>) tests the variable's value, not its name
+        if (const auto* value = context_.find_variable(*name)) {
+            return Result<bool, AnalysisError>(value_helpers::is_truthy(value->value));
+        }
+        if (auto cached = context_.get_cache_variable(*name)) {
+            return Result<bool, AnalysisError>(value_helpers::is_truthy(cached->value));
+        }
+    }
+
+    // TARGET <name>, answered by the targets this scope can see
+    if (const auto* list = dynamic_cast<const ast::ListExpression*>(&condition);
+        list && list->elements().size() == 2) {
+        const auto* op = dynamic_cast<const ast::StringLiteral*>(list->elements()[0].get());
+        if (op && !op->is_quoted() && op->value() == "TARGET") {
+            auto target = evaluate(*list->elements()[1]);
+            if (target.has_error()) {
+                return Result<bool, AnalysisError>(std::in_place_index<1>, target.error());
+            }
+            return Result<bool, AnalysisError>(
+                context_.has_target(value_helpers::to_string(target.value().value)));
+        }
+    }
+
+    // <left> VERSION_LESS <right> and the other version comparisons
+    if (const auto* list = dynamic_cast<const ast::ListExpression*>(&condition);
+        list && list->elements().size() == 3) {
+        const auto* op = dynamic_cast<const ast::StringLiteral*>(list->elements()[1].get());
+        if (op && !op->is_quoted() && op->value().starts_with("VERSION_")) {
+            // An unquoted operand naming a variable stands for its value
+            auto operand = [&](const ast::ASTNode& node) -> Result<std::string, AnalysisError> {
+                if (const auto* literal = dynamic_cast<const ast::StringLiteral*>(&node);
+                    literal && !literal->is_quoted()) {
+                    if (auto value = context_.get_variable(std::string(literal->value()))) {
+                        return Result<std::string, AnalysisError>(
+                            value_helpers::to_string(value->value));
+                    }
+                }
+                auto value = evaluate(node);
+                if (value.has_error()) {
+                    return Result<std::string, AnalysisError>(std::in_place_index<1>,
+                                                              value.error());
+                }
+                return Result<std::string, AnalysisError>(
+                    value_helpers::to_string(value.value().value));
+            };
+            auto left = operand(*list->elements()[0]);
+            auto right = operand(*list->elements()[2]);
+            if (left.has_error()) {
+                return Result<bool, AnalysisError>(std::in_place_index<1>, left.error());
+            }
+            if (right.has_error()) {
+                return Result<bool, AnalysisError>(std::in_place_index<1>, right.error());
+            }
+            return evaluate_version_comparison(std::string(op->value()), left.value(),
+                                               right.value());
+        }
+    }
+
     // Evaluate the condition node
     auto result = evaluate(condition);
     if (result.has_error()) {
@@ -284,6 +514,25 @@ Result<bool, AnalysisError> CMakeEvaluator::evaluate_condition(const ast::ASTNod
     return Result<bool, AnalysisError>(value_helpers::is_truthy(result.value().value));
 }
 
+Result<bool, AnalysisError> CMakeEvaluator::evaluate_version_comparison(const std::string& op,
+                                                                        const std::string& left,
+                                                                        const std::string& right) {
+    auto order = Version::parse(left) <=> Version::parse(right);
+    if (op == "VERSION_LESS") {
+        return Result<bool, AnalysisError>(order < 0);
+    } else if (op == "VERSION_GREATER") {
+        return Result<bool, AnalysisError>(order > 0);
+    } else if (op == "VERSION_EQUAL") {
+        return Result<bool, AnalysisError>(order == 0);
+    } else if (op == "VERSION_LESS_EQUAL") {
+        return Result<bool, AnalysisError>(order <= 0);
+    } else if (op == "VERSION_GREATER_EQUAL") {
+        return Result<bool, AnalysisError>(order >= 0);
+    }
+    return Result<bool, AnalysisError>(
+        std::in_place_index<1>, AnalysisError(fmt::format("Unknown version comparison: {}", op)));
+}
+
 Result<bool, AnalysisError> CMakeEvaluator::evaluate_platform_check(const std::string& platform) {
     // Check cached results first
     if (auto cached = context_.get_platform_check(platform)) {
@@ -332,7 +581,7 @@ void CMakeEvaluator::visit(const ast::IfStatement& node) {
     if (cond_result.has_value() && cond_result.value()) {
         // Condition is true - evaluate then branch
         for (const auto& stmt : node.then_branch()) {
-            evaluate(*stmt);
+            evaluate_statement(*stmt);
         }
     } else if (cond_result.has_value() && !cond_result.value()) {
         // Condition is false - check elseif/else branches
@@ -348,7 +597,7 @@ void CMakeEvaluator::visit(const ast::IfStatement& node) {
                     i++; // Skip the condition
                     while (i < node.elseif_branches().size() &&
                            node.elseif_branches()[i]->type() != NodeType::ElseIfStatement) {
-                        evaluate(*node.elseif_branches()[i]);
+                        evaluate_statement(*node.elseif_branches()[i]);
                         i++;
                     }
                     evaluated = true;
@@ -368,7 +617,7 @@ void CMakeEvaluator::visit(const ast::IfStatement& node) {
 
         if (!evaluated && !node.else_branch().empty()) {
             for (const auto& stmt : node.else_branch()) {
-                evaluate(*stmt);
+                evaluate_statement(*stmt);
             }
         }
     }
@@ -418,9 +667,16 @@ void CMakeEvaluator::visit(const ast::ForEachStatement& node) {
 }
 
 void CMakeEvaluator::visit(const ast::GeneratorExpression& node) {
-    // Generator expressions are not evaluated - preserve for Buck2
-    result_ = Result<EvaluatedValue, AnalysisError>(
-        EvaluatedValue{fmt::format("${{{}}}", node.expression()), Confidence::Unknown});
+    // Folded when it does not depend on the platform or configuration;
+    // otherwise kept for the generator to lower into select()
+    auto text = fmt::format("$<{}>", node.expression());
+    if (auto value =
+            evaluate_generator_expression(*GenexCache::shared().parse(text), GenexContext{})) {
+        result_ = Result<EvaluatedValue, AnalysisError>(EvaluatedValue{*value, Confidence::Certain});
+        return;
+    }
+    result_ =
+        Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::move(text), Confidence::Unknown});
 }
 
 void CMakeEvaluator::visit(const ast::BracketExpression& node) {
@@ -446,18 +702,14 @@ void CMakeEvaluator::visit(const ast::FunctionCall& node) {
 
 void CMakeEvaluator::visit(const ast::Block& node) {
     // Evaluate all statements in the block
-    for (const auto& stmt : node.statements()) {
-        evaluate(*stmt);
-    }
+    evaluate_statements(node.statements());
     result_ =
         Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), Confidence::Certain});
 }
 
 void CMakeEvaluator::visit(const ast::File& node) {
     // Evaluate all statements in the file
-    for (const auto& stmt : node.statements()) {
-        evaluate(*stmt);
-    }
+    evaluate_statements(node.statements());
     result_ =
         Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), Confidence::Certain});
 }
@@ -469,23 +721,104 @@ void CMakeEvaluator::visit(const ast::ErrorNode& node) {
 
 // CPM-specific nodes
 void CMakeEvaluator::visit(const ast::CPMAddPackage& node) {
+    CPMPackage package;
+    package.name = node.name();
+    if (!node.source().empty()) {
+        package.source = node.source();
+        switch (node.source_type()) {
+        case ast::CPMSourceType::GitHub:
+            package.source_type = CPMPackage::SourceType::GitHub;
+            break;
+        case ast::CPMSourceType::GitURL:
+            package.source_type = CPMPackage::SourceType::Git;
+            break;
+        case ast::CPMSourceType::URL:
+            package.source_type = CPMPackage::SourceType::URL;
+            break;
+        case ast::CPMSourceType::Local:
+            package.source_type = CPMPackage::SourceType::Local;
+            break;
+        }
+    }
+    if (node.version()) {
+        package.version = node.version()->version;
+        package.git_tag = node.version()->git_tag;
+    }
+    package.declared_in = fmt::format("{}:{}", node.location().file, node.location().line);
+    declare_cpm_package(package);
     result_ =
-        Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), Confidence::Unknown});
+        Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), Confidence::Likely});
 }
 
 void CMakeEvaluator::visit(const ast::CPMFindPackage& node) {
+    CPMPackage package;
+    package.name = node.name();
+    if (node.github_repository()) {
+        package.source_type = CPMPackage::SourceType::GitHub;
+        package.source = *node.github_repository();
+    }
+    package.version = node.version().value_or("");
+    package.git_tag = node.git_tag().value_or("");
+    package.declared_in = fmt::format("{}:{}", node.location().file, node.location().line);
+    declare_cpm_package(package);
     result_ =
-        Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), Confidence::Unknown});
+        Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), Confidence::Likely});
+}
+
+void CMakeEvaluator::declare_cpm_package(CPMPackage package) {
+    // A package lock or CPMDeclarePackage() replaces the arguments of the
+    // packages it declares
+    if (const auto* pinned = context_.find_cpm_declaration(package.name)) {
+        auto declared_in = std::move(package.declared_in);
+        package = *pinned;
+        package.declared_in = std::move(declared_in);
+    }
+
+    // The first declaration of a name is the one CPM adds
+    auto version_variable = "CPM_PACKAGE_" + package.name + "_VERSION";
+    bool added = !context_.get_variable(version_variable).has_value();
+    if (added) {
+        context_.set_variable(version_variable, CPMResolver::version_of(package).to_string());
+    }
+    context_.set_variable(package.name + "_ADDED", std::string(added ? "YES" : "NO"));
+    context_.add_cpm_package(package);
 }
 
 void CMakeEvaluator::visit(const ast::CPMUsePackageLock& node) {
+    auto path_text = interpolate_string(node.lock_file_path());
+    if (path_text.has_error()) {
+        result_ = Result<EvaluatedValue, AnalysisError>(
+            EvaluatedValue{std::string(""), Confidence::Unknown});
+        return;
+    }
+
+    // Relative to the directory of the calling file, and normalized, as CPM
+    // makes it absolute
+    std::filesystem::path path(path_text.value());
+    if (path.is_relative()) {
+        path = std::filesystem::path(node.location().file).parent_path() / path;
+    }
+    path = path.lexically_normal();
+
+    // CPM skips a lock file that does not exist
+    context_.add_input_file(path);
+    std::shared_ptr<const CPMPackageLock> lock;
+    if (auto* cache = context_.package_lock_cache()) {
+        lock = cache->load(path);
+    } else {
+        lock = CPMPackageLockCache().load(path);
+    }
+    if (lock) {
+        context_.use_cpm_package_lock(std::move(lock));
+    }
     result_ =
-        Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), Confidence::Unknown});
+        Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), Confidence::Certain});
 }
 
 void CMakeEvaluator::visit(const ast::CPMDeclarePackage& node) {
+    context_.declare_cpm_package(CPMPackageLock::declaration_of(node));
     result_ =
-        Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), Confidence::Unknown});
+        Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), Confidence::Certain});
 }
 
 // Implement helper methods
@@ -520,63 +853,108 @@ CMakeEvaluator::evaluate_message_command(const ast::CommandCall& cmd) {
         EvaluatedValue{std::string(""), Confidence::Certain});
 }
 
+namespace {
+
+// The keywords of the target commands; target names and items are the
+// words no keyword takes
+constexpr parser::KeywordSchema<10> ADD_LIBRARY_SCHEMA({{
+    {"STATIC", parser::KeywordKind::Option},
+    {"SHARED", parser::KeywordKind::Option},
+    {"MODULE", parser::KeywordKind::Option},
+    {"OBJECT", parser::KeywordKind::Option},
+    {"INTERFACE", parser::KeywordKind::Option},
+    {"UNKNOWN", parser::KeywordKind::Option},
+    {"IMPORTED", parser::KeywordKind::Option},
+    {"GLOBAL", parser::KeywordKind::Option},
+    {"EXCLUDE_FROM_ALL", parser::KeywordKind::Option},
+    {"ALIAS", parser::KeywordKind::OneValue},
+}});
+constexpr size_t LIBRARY_SHARED = ADD_LIBRARY_SCHEMA.slot("SHARED");
+constexpr size_t LIBRARY_INTERFACE = ADD_LIBRARY_SCHEMA.slot("INTERFACE");
+constexpr size_t LIBRARY_ALIAS = ADD_LIBRARY_SCHEMA.slot("ALIAS");
+
+constexpr parser::KeywordSchema<6> ADD_EXECUTABLE_SCHEMA({{
+    {"WIN32", parser::KeywordKind::Option},
+    {"MACOSX_BUNDLE", parser::KeywordKind::Option},
+    {"EXCLUDE_FROM_ALL", parser::KeywordKind::Option},
+    {"IMPORTED", parser::KeywordKind::Option},
+    {"GLOBAL", parser::KeywordKind::Option},
+    {"ALIAS", parser::KeywordKind::OneValue},
+}});
+constexpr size_t EXECUTABLE_ALIAS = ADD_EXECUTABLE_SCHEMA.slot("ALIAS");
+
+// target_include_directories(), target_compile_definitions() and, with the
+// pre-2.8.12 spellings, target_link_libraries()
+constexpr parser::KeywordSchema<9> TARGET_USAGE_SCHEMA({{
+    {"PUBLIC", parser::KeywordKind::MultiValue},
+    {"PRIVATE", parser::KeywordKind::MultiValue},
+    {"INTERFACE", parser::KeywordKind::MultiValue},
+    {"LINK_PUBLIC", parser::KeywordKind::MultiValue},
+    {"LINK_PRIVATE", parser::KeywordKind::MultiValue},
+    {"LINK_INTERFACE_LIBRARIES", parser::KeywordKind::MultiValue},
+    {"SYSTEM", parser::KeywordKind::Option},
+    {"BEFORE", parser::KeywordKind::Option},
+    {"AFTER", parser::KeywordKind::Option},
+}});
+
+constexpr parser::KeywordSchema<1> SET_TARGET_PROPERTIES_SCHEMA(
+    std::array<parser::Keyword, 1>{{{"PROPERTIES", parser::KeywordKind::MultiValue}}});
+constexpr size_t PROPERTIES = SET_TARGET_PROPERTIES_SCHEMA.slot("PROPERTIES");
+
+// The items of a target usage command in call order, whatever their
+// visibility; positional()[0] is the target itself
+std::vector<std::string> usage_items(const std::vector<std::string>& words) {
+    auto parsed = TARGET_USAGE_SCHEMA.partition(words, 1);
+    std::vector<std::string> items;
+    for (auto position : parsed.values({
+             decltype(parsed)::positional_slot,
+             TARGET_USAGE_SCHEMA.slot("PUBLIC"),
+             TARGET_USAGE_SCHEMA.slot("PRIVATE"),
+             TARGET_USAGE_SCHEMA.slot("INTERFACE"),
+             TARGET_USAGE_SCHEMA.slot("LINK_PUBLIC"),
+             TARGET_USAGE_SCHEMA.slot("LINK_PRIVATE"),
+             TARGET_USAGE_SCHEMA.slot("LINK_INTERFACE_LIBRARIES"),
+         })) {
+        if (position != 0) {
+            items.push_back(words[position]);
+        }
+    }
+    return items;
+}
+
+} // namespace
+
 Result<EvaluatedValue, AnalysisError>
 CMakeEvaluator::evaluate_add_library_command(const ast::CommandCall& cmd) {
-    const auto& args = cmd.arguments();
-
-    if (args.empty()) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+    if (words.empty() || words[0].empty()) {
         return Result<EvaluatedValue, AnalysisError>(
             std::in_place_index<1>, AnalysisError("add_library() requires target name"));
     }
 
-    // Get target name
-    auto name_result = evaluate(*args[0]);
-    if (name_result.has_error()) {
-        return Result<EvaluatedValue, AnalysisError>(std::in_place_index<1>, name_result.error());
-    }
-
-    auto target_name = value_helpers::to_string(name_result.value().value);
-
-    // Create target
+    // add_library(<name> [<type>] [EXCLUDE_FROM_ALL] <source>...)
+    auto parsed = ADD_LIBRARY_SCHEMA.partition(words, 1);
     Target target;
-    target.name = target_name;
-    target.type = Target::Type::StaticLibrary; // Default
-
-    // Parse library type and sources
-    size_t source_start = 1;
-    if (args.size() > 1) {
-        auto type_result = evaluate(*args[1]);
-        if (type_result.has_value()) {
-            auto type_str = value_helpers::to_string(type_result.value().value);
-            if (type_str == "SHARED") {
-                target.type = Target::Type::SharedLibrary;
-                source_start = 2;
-            } else if (type_str == "STATIC") {
-                target.type = Target::Type::StaticLibrary;
-                source_start = 2;
-            } else if (type_str == "INTERFACE") {
-                target.type = Target::Type::InterfaceLibrary;
-                source_start = 2;
-            }
-            // If not a type keyword, treat as source file
-        }
+    target.name = words[0];
+    target.type = parsed.has(LIBRARY_SHARED)      ? Target::Type::SharedLibrary
+                  : parsed.has(LIBRARY_INTERFACE) ? Target::Type::InterfaceLibrary
+                                                  : Target::Type::StaticLibrary;
+    for (auto position : parsed.positional().subspan(1)) {
+        target.sources.push_back(words[position]);
     }
 
-    // Extract source files
-    for (size_t i = source_start; i < args.size(); ++i) {
-        auto source_result = evaluate(*args[i]);
-        if (source_result.has_value()) {
-            auto source_path = value_helpers::to_string(source_result.value().value);
-            target.sources.push_back(source_path);
-        }
+    // An alias stands for the target it names
+    if (auto aliased = parsed.value(LIBRARY_ALIAS)) {
+        target.link_libraries.push_back(words[*aliased]);
     }
 
-    // Set source directory to current directory (could be improved)
-    target.source_directory = std::filesystem::current_path();
+    target.source_directory = current_source_directory();
+    initialize_target_properties(target);
 
     // Add target to context
     context_.add_target(target);
-    LOG_DEBUG("Added library target: {}", target_name);
+    LOG_DEBUG("Added library target: {}", target.name);
 
     return Result<EvaluatedValue, AnalysisError>(
         EvaluatedValue{std::string(""), Confidence::Certain});
@@ -584,41 +962,31 @@ CMakeEvaluator::evaluate_add_library_command(const ast::CommandCall& cmd) {
 
 Result<EvaluatedValue, AnalysisError>
 CMakeEvaluator::evaluate_add_executable_command(const ast::CommandCall& cmd) {
-    const auto& args = cmd.arguments();
-
-    if (args.empty()) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+    if (words.empty() || words[0].empty()) {
         return Result<EvaluatedValue, AnalysisError>(
             std::in_place_index<1>, AnalysisError("add_executable() requires target name"));
     }
 
-    // Get target name
-    auto name_result = evaluate(*args[0]);
-    if (name_result.has_error()) {
-        return Result<EvaluatedValue, AnalysisError>(std::in_place_index<1>, name_result.error());
-    }
-
-    auto target_name = value_helpers::to_string(name_result.value().value);
-
-    // Create target
+    // add_executable(<name> [WIN32] [MACOSX_BUNDLE] [EXCLUDE_FROM_ALL] <source>...)
+    auto parsed = ADD_EXECUTABLE_SCHEMA.partition(words, 1);
     Target target;
-    target.name = target_name;
+    target.name = words[0];
     target.type = Target::Type::ExecutableTarget;
-
-    // Extract source files (all args after target name)
-    for (size_t i = 1; i < args.size(); ++i) {
-        auto source_result = evaluate(*args[i]);
-        if (source_result.has_value()) {
-            auto source_path = value_helpers::to_string(source_result.value().value);
-            target.sources.push_back(source_path);
-        }
+    for (auto position : parsed.positional().subspan(1)) {
+        target.sources.push_back(words[position]);
+    }
+    if (auto aliased = parsed.value(EXECUTABLE_ALIAS)) {
+        target.link_libraries.push_back(words[*aliased]);
     }
 
-    // Set source directory to current directory
-    target.source_directory = std::filesystem::current_path();
+    target.source_directory = current_source_directory();
+    initialize_target_properties(target);
 
     // Add target to context
     context_.add_target(target);
-    LOG_DEBUG("Added executable target: {}", target_name);
+    LOG_DEBUG("Added executable target: {}", target.name);
 
     return Result<EvaluatedValue, AnalysisError>(
         EvaluatedValue{std::string(""), Confidence::Certain});
@@ -626,40 +994,42 @@ CMakeEvaluator::evaluate_add_executable_command(const ast::CommandCall& cmd) {
 
 Result<EvaluatedValue, AnalysisError>
 CMakeEvaluator::evaluate_target_include_directories_command(const ast::CommandCall& cmd) {
-    const auto& args = cmd.arguments();
-
-    if (args.size() < 2) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+    if (words.size() < 2) {
         return Result<EvaluatedValue, AnalysisError>(
             std::in_place_index<1>,
             AnalysisError("target_include_directories() requires target and directories"));
     }
 
-    // Get target name
-    auto name_result = evaluate(*args[0]);
-    if (name_result.has_error()) {
-        return Result<EvaluatedValue, AnalysisError>(std::in_place_index<1>, name_result.error());
+    // Find target in context and update it; visibility is not kept yet
+    if (auto* target = context_.find_target(words[0])) {
+        auto directories = usage_items(words);
+        target->include_directories.insert(target->include_directories.end(), directories.begin(),
+                                           directories.end());
+        LOG_DEBUG("Updated include directories for target: {}", target->name);
     }
 
-    auto target_name = value_helpers::to_string(name_result.value().value);
-
-    // Find target in context and update it
-    auto& targets = const_cast<std::vector<Target>&>(context_.get_targets());
-    for (auto& target : targets) {
-        if (target.name == target_name) {
-            // Extract include directories (skip visibility specifiers for now)
-            for (size_t i = 1; i < args.size(); ++i) {
-                auto dir_result = evaluate(*args[i]);
-                if (dir_result.has_value()) {
-                    auto dir_path = value_helpers::to_string(dir_result.value().value);
-                    // Skip visibility keywords
-                    if (dir_path != "PUBLIC" && dir_path != "PRIVATE" && dir_path != "INTERFACE") {
-                        target.include_directories.push_back(dir_path);
-                    }
-                }
-            }
-            LOG_DEBUG("Updated include directories for target: {}", target_name);
-            break;
-        }
+    return Result<EvaluatedValue, AnalysisError>(
+        EvaluatedValue{std::string(""), Confidence::Certain});
+}
+
+Result<EvaluatedValue, AnalysisError>
+CMakeEvaluator::evaluate_target_link_libraries_command(const ast::CommandCall& cmd) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+    if (words.size() < 2) {
+        return Result<EvaluatedValue, AnalysisError>(
+            std::in_place_index<1>,
+            AnalysisError("target_link_libraries() requires target and libraries"));
+    }
+
+    // Find target in context and update it; visibility is not kept yet
+    if (auto* target = context_.find_target(words[0])) {
+        auto libraries = usage_items(words);
+        target->link_libraries.insert(target->link_libraries.end(), libraries.begin(),
+                                      libraries.end());
+        LOG_DEBUG("Updated link libraries for target: {}", target->name);
     }
 
     return Result<EvaluatedValue, AnalysisError>(
@@ -667,103 +1037,918 @@ CMakeEvaluator::evaluate_target_include_directories_command(const ast::CommandCa
 }
 
 Result<EvaluatedValue, AnalysisError>
-CMakeEvaluator::evaluate_target_link_libraries_command(const ast::CommandCall& cmd) {
-    const auto& args = cmd.arguments();
+CMakeEvaluator::evaluate_target_compile_definitions_command(const ast::CommandCall& cmd) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+    if (words.size() < 2) {
+        return Result<EvaluatedValue, AnalysisError>(
+            std::in_place_index<1>,
+            AnalysisError("target_compile_definitions() requires target and definitions"));
+    }
 
-    if (args.size() < 2) {
+    // Find target in context and update it; visibility is not kept yet
+    if (auto* target = context_.find_target(words[0])) {
+        auto definitions = usage_items(words);
+        target->compile_definitions.insert(target->compile_definitions.end(), definitions.begin(),
+                                           definitions.end());
+        LOG_DEBUG("Updated compile definitions for target: {}", target->name);
+    }
+
+    return Result<EvaluatedValue, AnalysisError>(
+        EvaluatedValue{std::string(""), Confidence::Certain});
+}
+
+Result<EvaluatedValue, AnalysisError>
+CMakeEvaluator::evaluate_set_target_properties_command(const ast::CommandCall& cmd) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+
+    // set_target_properties(target1 target2 ... PROPERTIES prop1 value1 prop2 value2 ...)
+    auto parsed = SET_TARGET_PROPERTIES_SCHEMA.partition(words);
+    auto target_names = parsed.positional();
+    auto pairs = parsed.values(PROPERTIES);
+    if (target_names.empty() || !parsed.has(PROPERTIES) || pairs.size() % 2 != 0) {
         return Result<EvaluatedValue, AnalysisError>(
             std::in_place_index<1>,
-            AnalysisError("target_link_libraries() requires target and libraries"));
+            AnalysisError("set_target_properties() requires targets and PROPERTIES pairs"));
     }
 
-    // Get target name
-    auto name_result = evaluate(*args[0]);
-    if (name_result.has_error()) {
-        return Result<EvaluatedValue, AnalysisError>(std::in_place_index<1>, name_result.error());
+    for (auto name : target_names) {
+        if (auto* target = context_.find_target(words[name])) {
+            for (size_t i = 0; i + 1 < pairs.size(); i += 2) {
+                target->properties[words[pairs[i]]] = words[pairs[i + 1]];
+            }
+            LOG_DEBUG("Updated {} properties for target: {}", pairs.size() / 2, target->name);
+        }
+    }
+    if (confidence == Confidence::Unknown) {
+        // The properties are still set, but some of their values are blanks
+        LOG_WARN("{}:{}: set_target_properties() has arguments that could not be evaluated",
+                 cmd.location().file, cmd.location().line);
     }
 
-    auto target_name = value_helpers::to_string(name_result.value().value);
-
-    // Find target in context and update it
-    auto& targets = const_cast<std::vector<Target>&>(context_.get_targets());
-    for (auto& target : targets) {
-        if (target.name == target_name) {
-            // Extract link libraries (skip visibility specifiers for now)
-            for (size_t i = 1; i < args.size(); ++i) {
-                auto lib_result = evaluate(*args[i]);
-                if (lib_result.has_value()) {
-                    auto lib_name = value_helpers::to_string(lib_result.value().value);
-                    // Skip visibility keywords
-                    if (lib_name != "PUBLIC" && lib_name != "PRIVATE" && lib_name != "INTERFACE") {
-                        target.link_libraries.push_back(lib_name);
-                    }
-                }
+    return Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), confidence});
+}
+
+namespace {
+
+// The result variables of find_package() and pkg_check_modules()
+void set_package_variables(EvaluationContext& context, const std::string& prefix,
+                           const ExternalPackage& package) {
+    context.set_variable(prefix + "_FOUND", std::string("TRUE"));
+    if (!package.version.empty()) {
+        context.set_variable(prefix + "_VERSION", package.version);
+    }
+    context.set_variable(prefix + "_INCLUDE_DIRS", package.include_directories);
+    if (package.source == ExternalPackage::Source::PkgConfig) {
+        // pkg-config lists bare library names and keeps the full flags apart
+        std::vector<std::string> names;
+        for (const auto& flag : package.libraries) {
+            if (flag.starts_with("-l")) {
+                names.push_back(flag.substr(2));
             }
-            LOG_DEBUG("Updated link libraries for target: {}", target_name);
-            break;
+        }
+        context.set_variable(prefix + "_LIBRARIES", names);
+        context.set_variable(prefix + "_LDFLAGS", package.libraries);
+    } else {
+        context.set_variable(prefix + "_LIBRARIES", package.libraries);
+        context.set_variable(prefix + "_DIR", package.location.generic_string());
+    }
+}
+
+} // namespace
+
+Result<EvaluatedValue, AnalysisError>
+CMakeEvaluator::evaluate_find_package_command(const ast::CommandCall& cmd) {
+    const auto* index = context_.package_index();
+    const auto& args = cmd.arguments();
+    if (!index || args.empty()) {
+        // Whether the package exists depends on the machine running CMake
+        return Result<EvaluatedValue, AnalysisError>(
+            EvaluatedValue{std::string(""), Confidence::Unknown});
+    }
+
+    // find_package(<name> [version] [EXACT] [QUIET] [REQUIRED] [COMPONENTS ...] ...)
+    context_.mark_machine_dependent();
+    Confidence confidence = Confidence::Certain;
+    auto words = evaluate_arguments(cmd, confidence);
+    const auto& name = words[0];
+    bool has_version = words.size() > 1 && !words[1].empty() &&
+                       std::isdigit(static_cast<unsigned char>(words[1][0]));
+    std::string requested = has_version ? words[1] : "";
+    bool exact = std::find(words.begin(), words.end(), "EXACT") != words.end();
+
+    const auto* package = index->find_package(name);
+    if (package && !requested.empty() && !package->version.empty()) {
+        // As VERSION_EQUAL and VERSION_LESS compare
+        auto order = Version::parse(package->version) <=> Version::parse(requested);
+        if (exact ? order != 0 : order < 0) {
+            LOG_DEBUG("find_package({} {}) rejects installed version {}", name, requested,
+                      package->version);
+            package = nullptr;
         }
     }
 
+    if (!package) {
+        // Only the indexed prefixes were searched; the build machine may differ
+        context_.set_variable(name + "_FOUND", std::string("FALSE"), Confidence::Likely);
+        return Result<EvaluatedValue, AnalysisError>(
+            EvaluatedValue{std::string(""), Confidence::Likely});
+    }
+
+    set_package_variables(context_, name, *package);
+    context_.add_external_package(*package);
+    LOG_DEBUG("find_package({}) resolved to {} {}", name, package->location.string(),
+              package->version);
     return Result<EvaluatedValue, AnalysisError>(
         EvaluatedValue{std::string(""), Confidence::Certain});
 }
 
 Result<EvaluatedValue, AnalysisError>
-CMakeEvaluator::evaluate_target_compile_definitions_command(const ast::CommandCall& cmd) {
+CMakeEvaluator::evaluate_pkg_config_command(const ast::CommandCall& cmd, bool first_found) {
+    const auto* index = context_.package_index();
     const auto& args = cmd.arguments();
-
-    if (args.size() < 2) {
+    if (!index || args.size() < 2) {
         return Result<EvaluatedValue, AnalysisError>(
-            std::in_place_index<1>,
-            AnalysisError("target_compile_definitions() requires target and definitions"));
+            EvaluatedValue{std::string(""), Confidence::Unknown});
     }
 
-    // Get target name
-    auto name_result = evaluate(*args[0]);
-    if (name_result.has_error()) {
-        return Result<EvaluatedValue, AnalysisError>(std::in_place_index<1>, name_result.error());
+    // pkg_check_modules(<prefix> [REQUIRED] [QUIET] [IMPORTED_TARGET [GLOBAL]] <module>...)
+    context_.mark_machine_dependent();
+    Confidence confidence = Confidence::Certain;
+    auto words = evaluate_arguments(cmd, confidence);
+    const auto& prefix = words[0];
+    bool imported_target = false;
+    std::vector<std::string> modules;
+    for (size_t i = 1; i < words.size(); ++i) {
+        const auto& word = words[i];
+        if (word == "IMPORTED_TARGET") {
+            imported_target = true;
+        } else if (word == "REQUIRED" || word == "QUIET" || word == "GLOBAL" ||
+                   word == "NO_CMAKE_PATH" || word == "NO_CMAKE_ENVIRONMENT_PATH") {
+            continue;
+        } else if (word.find_first_of("<>=") == 0) {
+            // A separate "foo >= 1.0" constraint; the version follows the operator
+            if (word.find_first_not_of("<>=") == std::string::npos) {
+                ++i;
+            }
+        } else if (!word.empty()) {
+            modules.push_back(word.substr(0, word.find_first_of("<>=")));
+        }
     }
 
-    auto target_name = value_helpers::to_string(name_result.value().value);
-
-    // Find target in context and update it
-    auto& targets = const_cast<std::vector<Target>&>(context_.get_targets());
-    for (auto& target : targets) {
-        if (target.name == target_name) {
-            // Extract compile definitions (skip visibility specifiers for now)
-            for (size_t i = 1; i < args.size(); ++i) {
-                auto def_result = evaluate(*args[i]);
-                if (def_result.has_value()) {
-                    auto definition = value_helpers::to_string(def_result.value().value);
-                    // Skip visibility keywords
-                    if (definition != "PUBLIC" && definition != "PRIVATE" &&
-                        definition != "INTERFACE") {
-                        target.compile_definitions.push_back(definition);
-                    }
-                }
+    std::vector<const ExternalPackage*> found;
+    for (const auto& module : modules) {
+        if (const auto* package = index->find_module(module)) {
+            found.push_back(package);
+            if (first_found) {
+                break;
             }
-            LOG_DEBUG("Updated compile definitions for target: {}", target_name);
+        } else if (!first_found) {
+            found.clear();
             break;
         }
     }
 
+    if (found.empty()) {
+        context_.set_variable(prefix + "_FOUND", std::string("FALSE"), Confidence::Likely);
+        return Result<EvaluatedValue, AnalysisError>(
+            EvaluatedValue{std::string(""), Confidence::Likely});
+    }
+
+    // Several modules are reported as one package under the prefix
+    ExternalPackage combined = *found.front();
+    for (size_t i = 1; i < found.size(); ++i) {
+        combined.version.clear();
+        const auto& other = *found[i];
+        combined.include_directories.insert(combined.include_directories.end(),
+                                            other.include_directories.begin(),
+                                            other.include_directories.end());
+        combined.libraries.insert(combined.libraries.end(), other.libraries.begin(),
+                                  other.libraries.end());
+    }
+    set_package_variables(context_, prefix, combined);
+
+    for (const auto* package : found) {
+        ExternalPackage recorded = *package;
+        if (imported_target) {
+            recorded.imported_targets.push_back("PkgConfig::" + prefix);
+        }
+        context_.add_external_package(recorded);
+    }
     return Result<EvaluatedValue, AnalysisError>(
         EvaluatedValue{std::string(""), Confidence::Certain});
 }
 
+std::vector<std::string> CMakeEvaluator::evaluate_arguments(const ast::CommandCall& cmd,
+                                                            Confidence& confidence) {
+    std::vector<std::string> words;
+    for (const auto& arg : cmd.arguments()) {
+        auto word = evaluate(*arg);
+        if (word.has_value()) {
+            words.push_back(value_helpers::to_string(word.value().value));
+            confidence = std::max(confidence, word.value().confidence);
+        } else {
+            words.emplace_back();
+            confidence = Confidence::Unknown;
+        }
+    }
+    return words;
+}
+
+std::vector<std::string> CMakeEvaluator::expand_arguments(const ast::CommandCall& cmd,
+                                                          Confidence& confidence) {
+    std::vector<std::string> words;
+    for (const auto& arg : cmd.arguments()) {
+        auto word = evaluate(*arg);
+        if (!word.has_value()) {
+            words.emplace_back();
+            confidence = Confidence::Unknown;
+            continue;
+        }
+        confidence = std::max(confidence, word.value().confidence);
+        const auto* literal = dynamic_cast<const ast::StringLiteral*>(arg.get());
+        const auto* variable = dynamic_cast<const ast::Variable*>(arg.get());
+        if ((literal && literal->is_quoted()) || (variable && variable->is_quoted())) {
+            words.push_back(value_helpers::to_string(word.value().value));
+            continue;
+        }
+
+        // Within an argument the parser's list parts are pieces of one word,
+        // as in ${prefix}/lib
+        auto text = value_helpers::to_string(word.value().value);
+        const auto* parts = dynamic_cast<const ast::ListExpression*>(arg.get());
+        if (parts) {
+            text.clear();
+            for (const auto& part : value_helpers::to_list(word.value().value)) {
+                text += part;
+            }
+            if (parts->is_quoted()) {
+                words.push_back(std::move(text));
+                continue;
+            }
+        }
+        auto elements = value_helpers::to_list(Value{text});
+        words.insert(words.end(), elements.begin(), elements.end());
+    }
+    return words;
+}
+
+Result<EvaluatedValue, AnalysisError>
+CMakeEvaluator::evaluate_list_command(const ast::CommandCall& cmd) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+    auto result = ListCommand::evaluate(context_, words, confidence);
+    if (!result.has_value()) {
+        return Result<EvaluatedValue, AnalysisError>(std::in_place_index<1>, result.error());
+    }
+    return Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), confidence});
+}
+
+Result<EvaluatedValue, AnalysisError>
+CMakeEvaluator::evaluate_string_command(const ast::CommandCall& cmd) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+    auto result = StringCommand::evaluate(context_, words, confidence);
+    if (!result.has_value()) {
+        return Result<EvaluatedValue, AnalysisError>(std::in_place_index<1>, result.error());
+    }
+    return Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), confidence});
+}
+
+namespace {
+
+// file(GLOB|GLOB_RECURSE <variable> ...); the patterns are the other words
+constexpr parser::KeywordSchema<4> FILE_GLOB_SCHEMA({{
+    {"LIST_DIRECTORIES", parser::KeywordKind::OneValue},
+    {"RELATIVE", parser::KeywordKind::OneValue},
+    {"CONFIGURE_DEPENDS", parser::KeywordKind::Option},
+    {"FOLLOW_SYMLINKS", parser::KeywordKind::Option},
+}});
+constexpr size_t GLOB_LIST_DIRECTORIES = FILE_GLOB_SCHEMA.slot("LIST_DIRECTORIES");
+constexpr size_t GLOB_RELATIVE = FILE_GLOB_SCHEMA.slot("RELATIVE");
+constexpr size_t GLOB_FOLLOW_SYMLINKS = FILE_GLOB_SCHEMA.slot("FOLLOW_SYMLINKS");
+
+} // namespace
+
+Result<EvaluatedValue, AnalysisError>
+CMakeEvaluator::evaluate_file_command(const ast::CommandCall& cmd) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+    if (words.empty() || (words[0] != "GLOB" && words[0] != "GLOB_RECURSE")) {
+        // Other subcommands read or write files the migration does not see
+        return Result<EvaluatedValue, AnalysisError>(
+            EvaluatedValue{std::string(""), Confidence::Unknown});
+    }
+    if (words.size() < 2) {
+        return Result<EvaluatedValue, AnalysisError>(
+            std::in_place_index<1>, AnalysisError(fmt::format("file({}) requires a variable",
+                                                              words[0])));
+    }
+
+    auto parsed = FILE_GLOB_SCHEMA.partition(words, 2);
+    DirectorySnapshot::Options options;
+    options.recurse = words[0] == "GLOB_RECURSE";
+    options.list_directories = !options.recurse;
+    if (auto list_directories = parsed.value(GLOB_LIST_DIRECTORIES)) {
+        options.list_directories = value_helpers::is_truthy(words[*list_directories]);
+    }
+    options.follow_symlinks = parsed.has(GLOB_FOLLOW_SYMLINKS);
+
+    // Relative patterns are in the current source directory
+    std::filesystem::path base = std::filesystem::current_path();
+    if (const auto* current = context_.find_variable("CMAKE_CURRENT_SOURCE_DIR")) {
+        base = value_helpers::to_string(current->value);
+        confidence = std::max(confidence, current->confidence);
+    }
+
+    auto* snapshot = context_.directory_snapshot();
+    std::optional<DirectorySnapshot> own_snapshot;
+    if (!snapshot) {
+        snapshot = &own_snapshot.emplace();
+    }
+    std::vector<std::string> paths;
+    for (auto position : parsed.positional().subspan(2)) {
+        std::filesystem::path pattern(words[position]);
+        auto absolute = pattern.is_absolute() ? pattern : base / pattern;
+        auto found = snapshot->glob(absolute, options);
+        context_.add_glob_input(GlobInput{absolute.generic_string(), options.recurse,
+                                          options.list_directories, options.follow_symlinks,
+                                          found});
+        paths.insert(paths.end(), std::make_move_iterator(found.begin()),
+                     std::make_move_iterator(found.end()));
+    }
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+    if (auto relative = parsed.value(GLOB_RELATIVE)) {
+        std::filesystem::path directory(words[*relative]);
+        for (auto& path : paths) {
+            path = std::filesystem::path(path).lexically_relative(directory).generic_string();
+        }
+    }
+    LOG_DEBUG("file({} {}) matched {} paths", words[0], words[1], paths.size());
+    context_.set_variable(words[1], std::move(paths), confidence);
+    return Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), confidence});
+}
+
+namespace {
+
+// Whether a directory's own file writes state the directories added after
+// it read: the cache, or its parent's variables. What the directories it
+// adds in turn write is only known once they are evaluated.
+class OutsideWriteFinder : public ast::RecursiveASTVisitor {
+  public:
+    using ast::RecursiveASTVisitor::visit;
+
+    void visit(const ast::CommandCall& node) override {
+        std::string_view name = node.name();
+        if (name == "option" || name == "include" || name == "try_compile" ||
+            name.starts_with("check_")) {
+            found_ = true;
+        } else if (name == "set" || name == "unset") {
+            found_ = found_ || std::any_of(node.arguments().begin(), node.arguments().end(),
+                                           [](const auto& arg) {
+                                               return is_word(*arg, "PARENT_SCOPE") ||
+                                                      is_word(*arg, "CACHE");
+                                           });
+        }
+    }
+
+    bool found() const {
+        return found_;
+    }
+
+  private:
+    bool found_ = false;
+};
+
+} // namespace
+
+struct CMakeEvaluator::Subdirectory {
+    std::filesystem::path source_directory;
+    std::filesystem::path binary_directory;
+    // The AST's strings live in its parser
+    std::unique_ptr<parser::Parser> parser;
+    std::unique_ptr<ast::File> file;
+    bool writes_outside = false;
+    std::optional<AnalysisError> error;
+    // Replaces parsing and evaluation when taken from the same state
+    std::optional<EvaluationSnapshotStore::Snapshot> snapshot;
+
+    std::unique_ptr<EvaluationContext> scope;
+    std::optional<AnalysisError> evaluation_error;
+    size_t failed_statements = 0;
+};
+
+std::filesystem::path CMakeEvaluator::current_source_directory() const {
+    // The builtin placeholder is uncertain; the pipeline sets the real one
+    const auto* current = context_.find_variable("CMAKE_CURRENT_SOURCE_DIR");
+    if (current && current->is_certain()) {
+        return value_helpers::to_string(current->value);
+    }
+    return std::filesystem::current_path();
+}
+
+Result<EvaluatedValue, AnalysisError>
+CMakeEvaluator::evaluate_add_subdirectory_command(const ast::CommandCall& cmd) {
+    auto errors = evaluate_subdirectories({&cmd});
+    if (errors.front()) {
+        return Result<EvaluatedValue, AnalysisError>(std::in_place_index<1>, *errors.front());
+    }
+    return Result<EvaluatedValue, AnalysisError>(
+        EvaluatedValue{std::string(""), Confidence::Certain});
+}
+
+std::vector<std::optional<AnalysisError>>
+CMakeEvaluator::evaluate_subdirectories(const std::vector<const ast::CommandCall*>& calls) {
+    if (directory_depth_ >= max_recursion_depth_) {
+        return std::vector<std::optional<AnalysisError>>(
+            calls.size(), AnalysisError("add_subdirectory() nested too deeply"));
+    }
+
+    // add_subdirectory(<source_dir> [<binary_dir>] [EXCLUDE_FROM_ALL] [SYSTEM])
+    auto source_directory = current_source_directory();
+    const auto* current_binary = context_.find_variable("CMAKE_CURRENT_BINARY_DIR");
+    std::filesystem::path binary_directory =
+        current_binary ? value_helpers::to_string(current_binary->value) : "/build";
+    std::vector<Subdirectory> directories(calls.size());
+    for (size_t i = 0; i < calls.size(); ++i) {
+        Confidence confidence = Confidence::Certain;
+        auto words = expand_arguments(*calls[i], confidence);
+        auto& directory = directories[i];
+        if (words.empty() || words[0].empty() || confidence == Confidence::Unknown) {
+            directory.error = AnalysisError("add_subdirectory() requires a known source directory");
+            continue;
+        }
+        directory.source_directory = (source_directory / words[0]).lexically_normal();
+        bool binary = words.size() > 1 && words[1] != "EXCLUDE_FROM_ALL" && words[1] != "SYSTEM";
+        directory.binary_directory = (binary_directory / words[binary ? 1 : 0]).lexically_normal();
+    }
+
+    // Files are read and parsed side by side, except those of directories
+    // with a snapshot whose inputs are unchanged
+    auto* store = context_.snapshot_store();
+    parallel_for(directories.size(), [&](size_t i) {
+        auto& directory = directories[i];
+        if (directory.error) {
+            return;
+        }
+        if (store) {
+            directory.snapshot =
+                store->load(directory.source_directory / "CMakeLists.txt",
+                            directory.binary_directory, context_.directory_snapshot());
+            if (directory.snapshot) {
+                directory.writes_outside = directory.snapshot->scope->writes_outside();
+                return;
+            }
+        }
+        parse_subdirectory(directory);
+    });
+
+    // Waves of siblings end after one expected to write outside its scope;
+    // one that does so unexpectedly has those after it evaluated again
+    std::vector<std::optional<AnalysisError>> errors(directories.size());
+    size_t next = 0;
+    while (next < directories.size()) {
+        size_t end = next;
+        while (end < directories.size() && !directories[end].writes_outside) {
+            ++end;
+        }
+        end = std::min(directories.size(), end + 1);
+
+        // The state each directory of the wave starts from
+        uint64_t state = store ? EvaluationSnapshotStore::state_hash(context_) : 0;
+        for (size_t i = next; i < end; ++i) {
+            directories[i].scope = context_.create_directory_scope();
+        }
+        parallel_for(end - next,
+                     [&](size_t k) { evaluate_subdirectory(directories[next + k], state); });
+
+        for (size_t i = next; i < end; ++i) {
+            auto& directory = directories[i];
+            ++next;
+            const auto& error = directory.error ? directory.error : directory.evaluation_error;
+            if (error) {
+                errors[i] = error;
+                continue;
+            }
+            auto created = directory.scope->created_targets();
+            context_.merge_directory(*directory.scope);
+            failed_statements_ += directory.failed_statements;
+            LOG_DEBUG("Evaluated subdirectory {}", directory.source_directory.string());
+            if (directory.scope->writes_outside()) {
+                break;
+            }
+            // Siblings after it that looked for a target it created are
+            // evaluated again, as after a write outside its scope
+            if (!created.empty() &&
+                std::any_of(directories.begin() + static_cast<std::ptrdiff_t>(i + 1),
+                            directories.begin() + static_cast<std::ptrdiff_t>(end),
+                            [&](const Subdirectory& later) {
+                                return later.scope && later.scope->missed_any_target(created);
+                            })) {
+                LOG_DEBUG("Evaluating the siblings after {} again for its targets",
+                          directory.source_directory.string());
+                break;
+            }
+        }
+    }
+
+    return errors;
+}
+
+void CMakeEvaluator::parse_subdirectory(Subdirectory& directory) {
+    auto list_file = directory.source_directory / "CMakeLists.txt";
+    auto content = MappedFile::open(list_file);
+    if (!content.has_value()) {
+        directory.error = AnalysisError("add_subdirectory() given a directory without a "
+                                        "CMakeLists.txt: " +
+                                        directory.source_directory.string());
+        return;
+    }
+    directory.parser =
+        std::make_unique<parser::Parser>(content.value().view(), list_file.string());
+    auto parsed = directory.parser->parse_file();
+    if (!parsed.has_value()) {
+        directory.error =
+            AnalysisError(list_file.string() + ": " +
+                          (parsed.error().empty() ? std::string("parse failed")
+                                                  : parsed.error().front().message()));
+        return;
+    }
+    directory.file = std::move(parsed.value());
+    OutsideWriteFinder finder;
+    directory.file->accept(finder);
+    directory.writes_outside = finder.found();
+}
+
+void CMakeEvaluator::evaluate_subdirectory(Subdirectory& directory, uint64_t state) const {
+    directory.evaluation_error.reset();
+    directory.failed_statements = 0;
+    if (directory.error) {
+        return;
+    }
+    auto& scope = *directory.scope;
+    auto list_file = directory.source_directory / "CMakeLists.txt";
+    scope.set_variable("CMAKE_CURRENT_SOURCE_DIR", directory.source_directory.generic_string());
+    scope.set_variable("CMAKE_CURRENT_BINARY_DIR", directory.binary_directory.generic_string());
+    scope.set_variable("CMAKE_CURRENT_LIST_FILE", list_file.generic_string());
+    scope.set_variable("CMAKE_CURRENT_LIST_DIR", directory.source_directory.generic_string());
+    scope.add_subdirectory_file(list_file);
+
+    auto* store = scope.snapshot_store();
+    if (directory.snapshot && store->restore(*directory.snapshot, state, scope)) {
+        return;
+    }
+    if (!directory.file) {
+        // Its snapshot was taken from another state
+        parse_subdirectory(directory);
+        if (directory.error) {
+            return;
+        }
+    }
+
+    CMakeEvaluator evaluator(scope);
+    evaluator.subdirectory_cone_ = subdirectory_cone_;
+    evaluator.directory_depth_ = directory_depth_ + 1;
+    std::optional<ProgramSlice> slice;
+    if (subdirectory_cone_) {
+        slice = ProgramSlice::compute(*directory.file, *subdirectory_cone_);
+        evaluator.set_slice(&*slice);
+    }
+    auto result = evaluator.evaluate(*directory.file);
+    directory.failed_statements = evaluator.failed_statements_;
+    if (result.has_error()) {
+        directory.evaluation_error = result.error();
+    } else if (store) {
+        store->save(list_file, directory.binary_directory, state, scope);
+    }
+}
+
+Result<EvaluatedValue, AnalysisError>
+CMakeEvaluator::evaluate_include_command(const ast::CommandCall& cmd) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+    if (words.empty() || confidence == Confidence::Unknown) {
+        return Result<EvaluatedValue, AnalysisError>(
+            EvaluatedValue{std::string(""), Confidence::Unknown});
+    }
+
+    // include(<file|module> [OPTIONAL] [RESULT_VARIABLE <var>] [NO_POLICY_SCOPE])
+    std::string result_variable;
+    for (size_t i = 1; i + 1 < words.size(); ++i) {
+        if (words[i] == "RESULT_VARIABLE") {
+            result_variable = words[i + 1];
+        }
+    }
+
+    const auto* intrinsic = IntrinsicRegistry::builtin().find_include(words[0]);
+    if (!intrinsic) {
+        // Other files are not interpreted; whatever they define stays unknown
+        LOG_TRACE("No intrinsic for include({})", words[0]);
+        return Result<EvaluatedValue, AnalysisError>(
+            EvaluatedValue{std::string(""), Confidence::Unknown});
+    }
+
+    confidence = std::max(confidence, (*intrinsic)(context_, words));
+    if (!result_variable.empty()) {
+        // CMake stores the full path of the file it read, which for a module
+        // depends on where CMake is installed
+        context_.set_variable(result_variable, words[0], Confidence::Likely);
+    }
+    return Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), confidence});
+}
+
+Result<EvaluatedValue, AnalysisError>
+CMakeEvaluator::evaluate_intrinsic_command(const ast::CommandCall& cmd,
+                                           const IntrinsicRegistry::Handler& handler) {
+    Confidence confidence = Confidence::Certain;
+    auto words = expand_arguments(cmd, confidence);
+    confidence = std::max(confidence, handler(context_, words));
+    return Result<EvaluatedValue, AnalysisError>(EvaluatedValue{std::string(""), confidence});
+}
+
+std::vector<std::string> CMakeEvaluator::required_probe_flags() const {
+    // The CMAKE_REQUIRED_* variables every check_* module honours
+    auto list = [&](const char* name) {
+        auto value = context_.get_variable(name);
+        return value ? value_helpers::to_list(value->value) : std::vector<std::string>{};
+    };
+
+    std::vector<std::string> flags;
+    if (auto required = context_.get_variable("CMAKE_REQUIRED_FLAGS")) {
+        std::istringstream words(value_helpers::to_string(required->value));
+        for (std::string word; words >> word;) {
+            flags.push_back(word);
+        }
+    }
+    for (const auto& definition : list("CMAKE_REQUIRED_DEFINITIONS")) {
+        flags.push_back(definition);
+    }
+    for (const auto& dir : list("CMAKE_REQUIRED_INCLUDES")) {
+        flags.push_back("-I" + dir);
+    }
+    for (const auto& option : list("CMAKE_REQUIRED_LINK_OPTIONS")) {
+        flags.push_back(option);
+    }
+    for (const auto& library : list("CMAKE_REQUIRED_LIBRARIES")) {
+        bool is_path = library.find('/') != std::string::npos || library.starts_with("-");
+        flags.push_back(is_path ? library : "-l" + library);
+    }
+    return flags;
+}
+
+Result<EvaluatedValue, AnalysisError>
+CMakeEvaluator::evaluate_feature_check_command(const ast::CommandCall& cmd) {
+    using Language = FeatureProbe::Language;
+    const auto& name = cmd.name();
+    auto unknown = [] {
+        return Result<EvaluatedValue, AnalysisError>(
+            EvaluatedValue{std::string(""), Confidence::Unknown});
+    };
+
+    Confidence confidence = Confidence::Certain;
+    auto words = evaluate_arguments(cmd, confidence);
+    if (confidence != Confidence::Certain) {
+        // A probe built from guessed arguments would answer the wrong question
+        return unknown();
+    }
+    auto language_of = [](const std::string& value) {
+        return value == "CXX" ? Language::Cxx : Language::C;
+    };
+
+    std::optional<FeatureProbe> probe;
+    bool cache_result = true;
+    if ((name == "check_include_file" || name == "check_include_file_cxx") && words.size() >= 2) {
+        probe = FeatureProbe::include_files(words[1], {words[0]},
+                                            name == "check_include_file" ? Language::C
+                                                                         : Language::Cxx);
+        if (words.size() > 2) {
+            std::istringstream extra(words[2]);
+            for (std::string flag; extra >> flag;) {
+                probe->flags.push_back(flag);
+            }
+        }
+    } else if (name == "check_include_files" && words.size() >= 2) {
+        bool cxx = words.size() >= 4 && words[2] == "LANGUAGE" && words[3] == "CXX";
+        probe = FeatureProbe::include_files(words[1], value_helpers::to_list(words[0]),
+                                            cxx ? Language::Cxx : Language::C);
+    } else if ((name == "check_c_source_compiles" || name == "check_cxx_source_compiles") &&
+               words.size() >= 2) {
+        probe = FeatureProbe::source_compiles(words[1], words[0],
+                                              name == "check_c_source_compiles" ? Language::C
+                                                                                : Language::Cxx);
+    } else if (name == "check_source_compiles" && words.size() >= 3) {
+        probe = FeatureProbe::source_compiles(words[2], words[1], language_of(words[0]));
+    } else if ((name == "check_symbol_exists" || name == "check_cxx_symbol_exists") &&
+               words.size() >= 3) {
+        probe = FeatureProbe::symbol_exists(words[2], words[0], value_helpers::to_list(words[1]),
+                                            name == "check_symbol_exists" ? Language::C
+                                                                          : Language::Cxx);
+    } else if (name == "check_function_exists" && words.size() >= 2) {
+        probe = FeatureProbe::function_exists(words[1], words[0]);
+    } else if (name == "check_library_exists" && words.size() >= 4) {
+        probe = FeatureProbe::function_exists(words[3], words[1]);
+        if (!words[2].empty()) {
+            probe->flags.push_back("-L" + words[2]);
+        }
+        probe->flags.push_back("-l" + words[0]);
+    } else if (name == "try_compile" && words.size() >= 3) {
+        probe = try_compile_probe(words);
+        cache_result = false;
+    }
+    if (!probe) {
+        LOG_TRACE("Unsupported feature check: {}", name);
+        return unknown();
+    }
+
+    const auto variable = probe->result_variable;
+    auto record = [&](bool answer) {
+        context_.set_platform_check(variable, answer);
+        if (cache_result) {
+            context_.set_cache_variable(variable, std::string(answer ? "1" : ""));
+        } else {
+            context_.set_variable(variable, std::string(answer ? "TRUE" : "FALSE"));
+        }
+        return Result<EvaluatedValue, AnalysisError>(
+            EvaluatedValue{std::string(""), Confidence::Certain});
+    };
+
+    // Like CMake, a check whose result is already known is not repeated
+    if (auto known = context_.get_platform_check(variable)) {
+        return record(*known);
+    }
+    if (cache_result) {
+        if (auto cached = context_.get_cache_variable(variable)) {
+            return record(value_helpers::is_truthy(cached->value));
+        }
+    }
+
+    // The local compiler answers for the platform it builds for only; while
+    // others are evaluated alongside it, the check stays unknown
+    auto* executor = context_.probe_executor();
+    auto active = context_.active_platforms();
+    if (!executor || std::popcount(active) != 1 ||
+        context_.platforms()[static_cast<size_t>(std::countr_zero(active))].name !=
+            executor->platform()) {
+        return unknown();
+    }
+    context_.mark_machine_dependent();
+    auto extra = required_probe_flags();
+    probe->flags.insert(probe->flags.begin(), extra.begin(), extra.end());
+    if (auto answer = executor->lookup(*probe)) {
+        return record(*answer);
+    }
+    executor->enqueue(std::move(*probe));
+    return unknown();
+}
+
+std::optional<FeatureProbe> CMakeEvaluator::try_compile_probe(const std::vector<std::string>& words) {
+    // try_compile(<var> [<bindir>] SOURCES <src> | SOURCE_FROM_CONTENT <name> <content> ...)
+    // or the older try_compile(<var> <bindir> <src> ...); projects and
+    // several sources are not supported
+    auto is_keyword = [](const std::string& word) {
+        return !word.empty() && std::all_of(word.begin(), word.end(), [](char c) {
+            return (c >= 'A' && c <= 'Z') || c == '_';
+        });
+    };
+
+    std::string path;
+    std::string content;
+    size_t i = 1;
+    for (; i < words.size(); ++i) {
+        if (words[i] == "SOURCES") {
+            size_t end = i + 1;
+            while (end < words.size() && !is_keyword(words[end])) {
+                ++end;
+            }
+            if (end != i + 2) {
+                return std::nullopt;
+            }
+            path = words[++i];
+            break;
+        }
+        if (words[i] == "SOURCE_FROM_CONTENT" && i + 2 < words.size()) {
+            path = words[i + 1];
+            content = words[i + 2];
+            i += 2;
+            break;
+        }
+        if (i == 2 && !is_keyword(words[i]) && words[i].find('.') != std::string::npos) {
+            path = words[i];
+            break;
+        }
+    }
+    if (path.empty()) {
+        return std::nullopt;
+    }
+
+    if (content.empty()) {
+        std::filesystem::path source(path);
+        if (source.is_relative()) {
+            if (auto dir = context_.get_variable("CMAKE_CURRENT_SOURCE_DIR")) {
+                source = std::filesystem::path(value_helpers::to_string(dir->value)) / source;
+            }
+        }
+        std::ifstream file(source, std::ios::binary);
+        if (!file) {
+            return std::nullopt;
+        }
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    auto extension = std::filesystem::path(path).extension().string();
+    auto probe = FeatureProbe::source_compiles(
+        words[0], std::move(content),
+        extension == ".c" ? FeatureProbe::Language::C : FeatureProbe::Language::Cxx);
+    std::string keyword;
+    while (++i < words.size()) {
+        if (is_keyword(words[i])) {
+            keyword = words[i];
+        } else if (keyword == "COMPILE_DEFINITIONS" || keyword == "LINK_OPTIONS") {
+            probe.flags.push_back(words[i]);
+        } else if (keyword == "LINK_LIBRARIES") {
+            bool is_path = words[i].find('/') != std::string::npos || words[i].starts_with("-");
+            probe.flags.push_back(is_path ? words[i] : "-l" + words[i]);
+        } else if (keyword == "CXX_STANDARD" || keyword == "C_STANDARD") {
+            probe.flags.push_back(fmt::format("-std={}{}", keyword == "C_STANDARD" ? "c" : "c++",
+                                              words[i]));
+        }
+    }
+    return probe;
+}
+
+void CMakeEvaluator::initialize_target_properties(Target& target) const {
+    // CMake initializes these target properties from CMAKE_<PROP> when the target is created
+    static const std::vector<std::string> initialized_properties = {"UNITY_BUILD",
+                                                                    "UNITY_BUILD_BATCH_SIZE",
+                                                                    "UNITY_BUILD_MODE"};
+
+    for (const auto& property : initialized_properties) {
+        if (auto value = context_.get_variable("CMAKE_" + property)) {
+            target.properties[property] = value_helpers::to_string(value->value);
+        } else if (auto cache_value = context_.get_cache_variable("CMAKE_" + property)) {
+            target.properties[property] = value_helpers::to_string(cache_value->value);
+        }
+    }
+}
+
 // CMakeFileEvaluator implementation
 CMakeFileEvaluator::CMakeFileEvaluator() {
     context_.initialize_builtin_variables();
 }
 
+void CMakeFileEvaluator::set_source_directories(const std::filesystem::path& top,
+                                                const std::filesystem::path& current) {
+    context_.set_variable("CMAKE_SOURCE_DIR", top.generic_string(), Confidence::Certain);
+    context_.set_variable("CMAKE_CURRENT_SOURCE_DIR", current.generic_string(),
+                          Confidence::Certain);
+}
+
 Result<void, AnalysisError> CMakeFileEvaluator::evaluate_file(const ast::File& file) {
+    std::filesystem::path list_file(file.path());
+    if (!file.path().empty()) {
+        context_.set_variable("CMAKE_CURRENT_LIST_FILE", list_file.generic_string());
+        context_.set_variable("CMAKE_CURRENT_LIST_DIR", list_file.parent_path().generic_string());
+    }
+
+    // A file evaluated before from the same state is restored instead
+    auto* store = file.path().empty() ? nullptr : context_.snapshot_store();
+    uint64_t state = 0;
+    std::filesystem::path binary_directory;
+    if (store) {
+        state = EvaluationSnapshotStore::state_hash(context_);
+        if (const auto* binary = context_.find_variable("CMAKE_CURRENT_BINARY_DIR")) {
+            binary_directory = value_helpers::to_string(binary->value);
+        }
+        auto snapshot = store->load(list_file, binary_directory, context_.directory_snapshot());
+        if (snapshot && store->restore(*snapshot, state, context_)) {
+            return Ok<AnalysisError>();
+        }
+    }
+
     CMakeEvaluator evaluator(context_);
+    std::optional<ProgramSlice> slice;
+    if (slicing_) {
+        slice = ProgramSlice::compute(file, target_cone_);
+        evaluator.set_slice(&*slice);
+        evaluator.set_subdirectory_cone(&target_cone_);
+    }
     auto result = evaluator.evaluate(file);
 
     if (result.has_error()) {
         return Result<void, AnalysisError>::error(result.error());
     }
+    if (evaluator.failed_statements() > 0) {
+        LOG_WARN("{}: {} statements could not be evaluated; what they do is missing from the "
+                 "analysis",
+                 list_file.string(), evaluator.failed_statements());
+    }
 
+    if (store) {
+        store->save(list_file, binary_directory, state, context_);
+    }
     return Ok<AnalysisError>();
 }
 
@@ -791,6 +1976,10 @@ Result<ProjectAnalysis, AnalysisError> CMakeFileEvaluator::analyze(const ast::Fi
         analysis.targets.push_back(target);
     }
 
+    analysis.external_packages = context_.get_external_packages();
+    analysis.cpm_packages = context_.get_cpm_packages();
+    analysis.subdirectory_files = context_.subdirectory_files();
+
     // Extract global variables
     for (const auto& var_name : context_.list_variables()) {
         if (auto var_value = context_.get_variable(var_name)) {
@@ -0,0 +1,184 @@
+#include <cctype>
+#include <finch/analyzer/cmake_regex.hpp>
+#include <finch/core/logging.hpp>
+#include <fmt/format.h>
+#include <memory>
+#include <unordered_map>
+
+namespace finch::analyzer {
+
+namespace {
+
+struct PatternHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view pattern) const {
+        return std::hash<std::string_view>{}(pattern);
+    }
+};
+
+// Compiled patterns are never evicted: a caller may hold several at once,
+// and the patterns come from the scripts being analyzed
+struct RegexCache {
+    std::unordered_map<std::string, std::unique_ptr<std::regex>, PatternHash, std::equal_to<>>
+        patterns;
+    CMakeRegex::Stats stats;
+};
+
+RegexCache& regex_cache() {
+    thread_local RegexCache cache;
+    return cache;
+}
+
+bool is_ecmascript_special(char c) {
+    return std::string_view("^$\\.*+?()[]{}|/").find(c) != std::string_view::npos;
+}
+
+} // namespace
+
+std::string CMakeRegex::Stats::to_string() const {
+    return fmt::format("Regex cache: {} patterns compiled, {} hits", compiled, hits);
+}
+
+std::string CMakeRegex::translate(std::string_view pattern) {
+    std::string translated;
+    translated.reserve(pattern.size() + 8);
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char c = pattern[i];
+        if (c == '\\') {
+            if (i + 1 == pattern.size()) {
+                translated += c; // A trailing backslash, which std::regex rejects too
+                break;
+            }
+            char next = pattern[++i];
+            if (is_ecmascript_special(next)) {
+                translated += '\\';
+            }
+            translated += next;
+        } else if (c == '{' || c == '}') {
+            translated += '\\';
+            translated += c;
+        } else if (c == '[') {
+            // Copied up to the closing ']', which may be the first member
+            translated += c;
+            size_t j = i + 1;
+            if (j < pattern.size() && pattern[j] == '^') {
+                translated += '^';
+                ++j;
+            }
+            if (j < pattern.size() && pattern[j] == ']') {
+                translated += "\\]";
+                ++j;
+            }
+            for (; j < pattern.size() && pattern[j] != ']'; ++j) {
+                if (pattern[j] == '\\' || pattern[j] == '[') {
+                    translated += '\\';
+                }
+                translated += pattern[j];
+            }
+            if (j < pattern.size()) {
+                translated += ']';
+            }
+            i = j;
+        } else {
+            translated += c;
+        }
+    }
+    return translated;
+}
+
+Result<const std::regex*, AnalysisError> CMakeRegex::compile(std::string_view pattern) {
+    auto& cache = regex_cache();
+    if (auto cached = cache.patterns.find(pattern); cached != cache.patterns.end()) {
+        ++cache.stats.hits;
+        return Result<const std::regex*, AnalysisError>(cached->second.get());
+    }
+    try {
+        auto compiled = std::make_unique<std::regex>(translate(pattern));
+        const auto* regex = compiled.get();
+        cache.patterns.emplace(std::string(pattern), std::move(compiled));
+        ++cache.stats.compiled;
+        LOG_TRACE("Compiled regex \"{}\"", pattern);
+        return Result<const std::regex*, AnalysisError>(regex);
+    } catch (const std::regex_error&) {
+        return Result<const std::regex*, AnalysisError>(
+            std::in_place_index<1>, AnalysisError(fmt::format("invalid regex \"{}\"", pattern)));
+    }
+}
+
+CMakeRegex::Stats CMakeRegex::stats() {
+    return regex_cache().stats;
+}
+
+Result<RegexReplacement, AnalysisError> RegexReplacement::parse(std::string_view expression) {
+    RegexReplacement replacement;
+    std::string text;
+    for (size_t i = 0; i < expression.size(); ++i) {
+        if (expression[i] != '\\') {
+            text += expression[i];
+            continue;
+        }
+        if (i + 1 == expression.size()) {
+            return Result<RegexReplacement, AnalysisError>(
+                std::in_place_index<1>,
+                AnalysisError(fmt::format("replace expression \"{}\" ends in a backslash",
+                                          expression)));
+        }
+        char next = expression[++i];
+        if (std::isdigit(static_cast<unsigned char>(next))) {
+            if (!text.empty()) {
+                replacement.pieces_.push_back({std::move(text)});
+                text.clear();
+            }
+            replacement.pieces_.push_back({std::string(), next - '0'});
+        } else if (next == 'n') {
+            text += '\n';
+        } else if (next == '\\') {
+            text += '\\';
+        } else {
+            return Result<RegexReplacement, AnalysisError>(
+                std::in_place_index<1>,
+                AnalysisError(fmt::format("unknown escape \"\\{}\" in replace expression", next)));
+        }
+    }
+    if (!text.empty()) {
+        replacement.pieces_.push_back({std::move(text)});
+    }
+    return Result<RegexReplacement, AnalysisError>(std::move(replacement));
+}
+
+bool RegexReplacement::replace_all(std::string_view input, const std::regex& regex,
+                                   std::string& output, std::cmatch& last) const {
+    const char* position = input.data();
+    const char* end = position + input.size();
+    auto flags = std::regex_constants::match_default;
+    bool matched = false;
+    std::cmatch match;
+    while (std::regex_search(position, end, match, regex, flags)) {
+        matched = true;
+        output.append(position, match[0].first);
+        for (const auto& piece : pieces_) {
+            if (piece.group < 0) {
+                output += piece.text;
+            } else if (auto group_index = static_cast<size_t>(piece.group);
+                       group_index < match.size()) {
+                const auto& group = match[group_index];
+                output.append(group.first, group.second);
+            }
+        }
+        position = match[0].second;
+        bool empty = match[0].first == match[0].second;
+        last = std::move(match);
+        if (empty) {
+            if (position == end) {
+                break;
+            }
+            output += *position++;
+        }
+        // Later searches start mid-input, where ^ must not match
+        flags = std::regex_constants::match_prev_avail;
+    }
+    output.append(position, end);
+    return matched;
+}
+
+} // namespace finch::analyzer
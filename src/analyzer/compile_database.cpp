@@ -0,0 +1,892 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <finch/analyzer/compile_database.hpp>
+#include <finch/core/byte_scan.hpp>
+#include <finch/core/logging.hpp>
+#include <fmt/format.h>
+#include <forward_list>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace finch::analyzer {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// First '"' or '\\' in [p, end), or end; compile databases are mostly long
+// command strings, so this is where the parser spends its time.
+const char* find_quote_or_backslash(const char* p, const char* end) {
+    return find_any_byte<'"', '\\'>(p, end);
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+bool is_shell_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Split a POSIX shell command line. Tokens without quotes or escapes (nearly
+// all of them) are views into command; the rest are unquoted into owned.
+void tokenize_into(std::string_view command, std::vector<std::string_view>& tokens,
+                   std::forward_list<std::string>& owned) {
+    size_t i = 0;
+    while (i < command.size()) {
+        while (i < command.size() && is_shell_space(command[i])) {
+            ++i;
+        }
+        if (i >= command.size()) {
+            break;
+        }
+
+        size_t start = i;
+        while (i < command.size() && !is_shell_space(command[i]) && command[i] != '\'' &&
+               command[i] != '"' && command[i] != '\\') {
+            ++i;
+        }
+        if (i >= command.size() || is_shell_space(command[i])) {
+            tokens.push_back(command.substr(start, i - start));
+            continue;
+        }
+
+        std::string& current = owned.emplace_front(command.substr(start, i - start));
+        for (; i < command.size() && !is_shell_space(command[i]); ++i) {
+            char c = command[i];
+            if (c == '\'') {
+                // Single quotes: everything literal up to the closing quote
+                size_t close = command.find('\'', i + 1);
+                if (close == std::string_view::npos) {
+                    close = command.size();
+                }
+                current.append(command.substr(i + 1, close - i - 1));
+                i = close;
+            } else if (c == '"') {
+                // Double quotes: backslash only escapes ", \, $ and `
+                for (++i; i < command.size() && command[i] != '"'; ++i) {
+                    if (command[i] == '\\' && i + 1 < command.size() &&
+                        (command[i + 1] == '"' || command[i + 1] == '\\' ||
+                         command[i + 1] == '$' || command[i + 1] == '`')) {
+                        ++i;
+                    }
+                    current += command[i];
+                }
+            } else if (c == '\\' && i + 1 < command.size()) {
+                current += command[++i];
+            } else {
+                current += c;
+            }
+        }
+        tokens.push_back(current);
+    }
+}
+
+} // namespace
+
+// Streaming scanner for the subset of JSON compile databases use: an array of
+// flat objects whose interesting members are strings or arrays of strings.
+// Anything else is skipped structurally.
+class CompileDatabase::Scanner {
+  public:
+    Scanner(std::string_view json, std::deque<std::string>& storage)
+        : begin_(json.data()), p_(json.data()), end_(json.data() + json.size()),
+          storage_(storage) {}
+
+    Result<std::vector<Entry>, ParseError> run() {
+        std::vector<Entry> entries;
+        // Entries are rarely shorter than ~200 bytes; avoids most regrowth
+        entries.reserve(static_cast<size_t>(end_ - p_) / 512);
+
+        skip_whitespace();
+        if (!expect('[')) {
+            return failure();
+        }
+        skip_whitespace();
+        if (p_ < end_ && *p_ == ']') {
+            ++p_;
+            return Result<std::vector<Entry>, ParseError>(std::move(entries));
+        }
+
+        for (;;) {
+            skip_whitespace();
+            Entry entry;
+            if (!parse_entry(entry)) {
+                return failure();
+            }
+            entries.push_back(std::move(entry));
+
+            skip_whitespace();
+            if (p_ < end_ && *p_ == ',') {
+                ++p_;
+                continue;
+            }
+            if (!expect(']')) {
+                return failure();
+            }
+            break;
+        }
+        return Result<std::vector<Entry>, ParseError>(std::move(entries));
+    }
+
+  private:
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    std::deque<std::string>& storage_;
+    std::string error_;
+
+    Result<std::vector<Entry>, ParseError> failure() {
+        return Result<std::vector<Entry>, ParseError>(
+            std::in_place_index<1>,
+            ParseError(ParseError::Category::InvalidSyntax,
+                       fmt::format("compile database: {} at offset {}", error_,
+                                   static_cast<size_t>(p_ - begin_))));
+    }
+
+    bool fail(const char* message) {
+        if (error_.empty()) {
+            error_ = message;
+        }
+        return false;
+    }
+
+    void skip_whitespace() {
+        while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+            ++p_;
+        }
+    }
+
+    bool expect(char c) {
+        if (p_ >= end_ || *p_ != c) {
+            return fail(c == '[' ? "expected '['" : c == ']' ? "expected ']'" : "unexpected token");
+        }
+        ++p_;
+        return true;
+    }
+
+    bool parse_entry(Entry& entry) {
+        if (!expect('{')) {
+            return false;
+        }
+        skip_whitespace();
+        if (p_ < end_ && *p_ == '}') {
+            ++p_;
+            return true;
+        }
+
+        for (;;) {
+            skip_whitespace();
+            std::string_view key;
+            if (!parse_string(key)) {
+                return false;
+            }
+            skip_whitespace();
+            if (!expect(':')) {
+                return false;
+            }
+            skip_whitespace();
+
+            bool ok = true;
+            if (key == "directory") {
+                ok = parse_string(entry.directory);
+            } else if (key == "file") {
+                ok = parse_string(entry.file);
+            } else if (key == "output") {
+                ok = parse_string(entry.output);
+            } else if (key == "command") {
+                ok = parse_string(entry.command);
+            } else if (key == "arguments") {
+                ok = parse_string_array(entry.arguments);
+            } else {
+                ok = skip_value();
+            }
+            if (!ok) {
+                return false;
+            }
+
+            skip_whitespace();
+            if (p_ < end_ && *p_ == ',') {
+                ++p_;
+                continue;
+            }
+            return expect('}');
+        }
+    }
+
+    bool parse_string(std::string_view& out) {
+        if (p_ >= end_ || *p_ != '"') {
+            return fail("expected string");
+        }
+        const char* start = ++p_;
+        const char* stop = find_quote_or_backslash(p_, end_);
+        if (stop >= end_) {
+            return fail("unterminated string");
+        }
+        if (*stop == '"') {
+            // Common case: no escapes, reference the input directly
+            out = std::string_view(start, static_cast<size_t>(stop - start));
+            p_ = stop + 1;
+            return true;
+        }
+
+        std::string& decoded = storage_.emplace_back(start, stop);
+        p_ = stop;
+        while (p_ < end_) {
+            if (*p_ == '"') {
+                ++p_;
+                out = decoded;
+                return true;
+            }
+            if (*p_ != '\\') {
+                const char* next = find_quote_or_backslash(p_, end_);
+                decoded.append(p_, next);
+                p_ = next;
+                continue;
+            }
+            if (++p_ >= end_) {
+                break;
+            }
+            switch (*p_++) {
+            case '"':
+                decoded += '"';
+                break;
+            case '\\':
+                decoded += '\\';
+                break;
+            case '/':
+                decoded += '/';
+                break;
+            case 'b':
+                decoded += '\b';
+                break;
+            case 'f':
+                decoded += '\f';
+                break;
+            case 'n':
+                decoded += '\n';
+                break;
+            case 'r':
+                decoded += '\r';
+                break;
+            case 't':
+                decoded += '\t';
+                break;
+            case 'u': {
+                uint32_t cp = 0;
+                if (!parse_hex4(cp)) {
+                    return false;
+                }
+                if (cp >= 0xD800 && cp < 0xDC00 && end_ - p_ >= 6 && p_[0] == '\\' &&
+                    p_[1] == 'u') {
+                    const char* next = p_;
+                    p_ += 2;
+                    uint32_t low = 0;
+                    if (!parse_hex4(low)) {
+                        return false;
+                    }
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    } else {
+                        p_ = next; // Not a pair; the next escape stands alone
+                    }
+                }
+                // A surrogate left unpaired is not a character
+                if (cp >= 0xD800 && cp < 0xE000) {
+                    cp = 0xFFFD;
+                }
+                append_utf8(decoded, cp);
+                break;
+            }
+            default:
+                return fail("invalid escape");
+            }
+        }
+        return fail("unterminated string");
+    }
+
+    bool parse_hex4(uint32_t& value) {
+        if (end_ - p_ < 4) {
+            return fail("truncated \\u escape");
+        }
+        for (int i = 0; i < 4; ++i) {
+            char c = *p_++;
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= static_cast<uint32_t>(c - '0');
+            } else if (c >= 'a' && c <= 'f') {
+                value |= static_cast<uint32_t>(c - 'a' + 10);
+            } else if (c >= 'A' && c <= 'F') {
+                value |= static_cast<uint32_t>(c - 'A' + 10);
+            } else {
+                return fail("invalid \\u escape");
+            }
+        }
+        return true;
+    }
+
+    bool parse_string_array(std::vector<std::string_view>& out) {
+        if (!expect('[')) {
+            return false;
+        }
+        skip_whitespace();
+        if (p_ < end_ && *p_ == ']') {
+            ++p_;
+            return true;
+        }
+        for (;;) {
+            skip_whitespace();
+            if (!parse_string(out.emplace_back())) {
+                return false;
+            }
+            skip_whitespace();
+            if (p_ < end_ && *p_ == ',') {
+                ++p_;
+                continue;
+            }
+            return expect(']');
+        }
+    }
+
+    bool skip_value() {
+        if (p_ >= end_) {
+            return fail("unexpected end of input");
+        }
+        if (*p_ == '"') {
+            std::string_view ignored;
+            return parse_string(ignored);
+        }
+        if (*p_ == '[' || *p_ == '{') {
+            const char close = *p_ == '[' ? ']' : '}';
+            ++p_;
+            skip_whitespace();
+            if (p_ < end_ && *p_ == close) {
+                ++p_;
+                return true;
+            }
+            for (;;) {
+                skip_whitespace();
+                if (close == '}') {
+                    std::string_view ignored;
+                    if (!parse_string(ignored)) {
+                        return false;
+                    }
+                    skip_whitespace();
+                    if (!expect(':')) {
+                        return false;
+                    }
+                    skip_whitespace();
+                }
+                if (!skip_value()) {
+                    return false;
+                }
+                skip_whitespace();
+                if (p_ < end_ && *p_ == ',') {
+                    ++p_;
+                    continue;
+                }
+                return expect(close);
+            }
+        }
+        // Number, true, false or null
+        const char* start = p_;
+        while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ']' && *p_ != ' ' &&
+               *p_ != '\n' && *p_ != '\r' && *p_ != '\t') {
+            ++p_;
+        }
+        return p_ != start || fail("expected value");
+    }
+};
+
+Result<CompileDatabase, ParseError> CompileDatabase::load(const fs::path& path) {
+    auto mapped = MappedFile::open(path);
+    if (!mapped.has_value()) {
+        return Result<CompileDatabase, ParseError>(
+            std::in_place_index<1>,
+            ParseError(ParseError::Category::UnexpectedEOF,
+                       "Cannot read compile database: " + path.string()));
+    }
+
+    auto file = std::make_unique<MappedFile>(std::move(mapped.value()));
+    auto parsed = parse(file->view());
+    if (!parsed.has_value()) {
+        return parsed;
+    }
+
+    CompileDatabase database = std::move(parsed.value());
+    database.file_ = std::move(file);
+    LOG_DEBUG("Loaded {} compile commands from {}", database.entries_.size(), path.string());
+    return Result<CompileDatabase, ParseError>(std::move(database));
+}
+
+Result<CompileDatabase, ParseError> CompileDatabase::parse(std::string_view json) {
+    CompileDatabase database;
+    Scanner scanner(json, database.unescaped_);
+    auto entries = scanner.run();
+    if (!entries.has_value()) {
+        return Result<CompileDatabase, ParseError>(std::in_place_index<1>, entries.error());
+    }
+    database.entries_ = std::move(entries.value());
+    return Result<CompileDatabase, ParseError>(std::move(database));
+}
+
+std::vector<std::string> CompileDatabase::tokenize_command(std::string_view command) {
+    std::vector<std::string_view> views;
+    std::forward_list<std::string> owned;
+    tokenize_into(command, views, owned);
+    return {views.begin(), views.end()};
+}
+
+namespace {
+
+// One compile command reduced to what the generator needs. Fields view the
+// database where possible; strings that had to be built live in owned.
+struct TranslationUnit {
+    std::string_view group_key;
+    std::string_view target_name;
+    std::string_view source;
+    std::vector<std::string_view> definitions;
+    std::vector<std::string_view> include_directories;
+    std::vector<std::string_view> options; // A flag and its separate argument joined by '\x1f'
+    std::forward_list<std::string> owned;
+
+    std::string_view own(std::string value) {
+        return owned.emplace_front(std::move(value));
+    }
+};
+
+constexpr char option_separator = '\x1f';
+
+bool takes_separate_argument(std::string_view flag) {
+    static const std::unordered_set<std::string_view> flags = {
+        "-o",       "-MF",       "-MT",      "-MQ",    "-D",       "-U",
+        "-I",       "-isystem",  "-iquote",  "-idirafter", "-include", "-imacros",
+        "-x",       "-Xclang",   "-mllvm",   "-arch",  "-target",  "-isysroot",
+        "--sysroot", "-Xpreprocessor"};
+    return flags.contains(flag);
+}
+
+bool is_dependency_flag(std::string_view flag) {
+    return flag == "-MD" || flag == "-MMD" || flag == "-MP" || flag == "-M" || flag == "-MM" ||
+           flag.starts_with("-MF") || flag.starts_with("-MT") || flag.starts_with("-MQ");
+}
+
+// -o<path>, as opposed to the options that only start with -o, such as
+// clang's -objcmt-*
+bool is_joined_output(std::string_view arg) {
+    if (!arg.starts_with("-o") || arg.size() == 2) {
+        return false;
+    }
+    auto path = arg.substr(2);
+    return path.find('/') != std::string_view::npos || path.ends_with(".o") ||
+           path.ends_with(".obj");
+}
+
+bool is_absolute_path(std::string_view path) {
+    return (!path.empty() && path.front() == '/') ||
+           (path.size() > 2 && path[1] == ':' && (path[2] == '/' || path[2] == '\\'));
+}
+
+// True when a path has nothing lexically_normal() would change
+bool is_clean_path(std::string_view path) {
+    return path.find("//") == std::string_view::npos &&
+           path.find("/./") == std::string_view::npos &&
+           path.find("/../") == std::string_view::npos && !path.ends_with("/.") &&
+           !path.ends_with("/..") && path.find('\\') == std::string_view::npos;
+}
+
+std::string absolute_in(std::string_view directory, std::string_view path) {
+    std::string joined;
+    if (is_absolute_path(path)) {
+        joined = path;
+    } else {
+        joined.reserve(directory.size() + path.size() + 1);
+        joined = directory;
+        if (!joined.empty() && joined.back() != '/') {
+            joined += '/';
+        }
+        joined += path;
+    }
+    if (is_clean_path(joined)) {
+        return joined;
+    }
+    return fs::path(joined).lexically_normal().generic_string();
+}
+
+// Like absolute_in, but returns path itself when it is already absolute and clean
+std::string_view absolute_view(TranslationUnit& unit, std::string_view directory,
+                               std::string_view path) {
+    if (is_absolute_path(path) && is_clean_path(path)) {
+        return path;
+    }
+    return unit.own(absolute_in(directory, path));
+}
+
+std::string_view parent_of(std::string_view path) {
+    auto slash = path.rfind('/');
+    return slash == std::string_view::npos ? std::string_view() : path.substr(0, slash);
+}
+
+// Group by CMake's per-target object directory when present, else by the
+// directory holding the object file
+void assign_group(TranslationUnit& unit, std::string_view object) {
+    auto cmake_files = object.rfind("CMakeFiles/");
+    if (cmake_files != std::string_view::npos) {
+        auto name_start = cmake_files + std::strlen("CMakeFiles/");
+        auto dir_suffix = object.find(".dir/", name_start);
+        if (dir_suffix != std::string_view::npos) {
+            unit.group_key = object.substr(0, dir_suffix);
+            unit.target_name = object.substr(name_start, dir_suffix - name_start);
+            return;
+        }
+    }
+    auto parent = parent_of(object);
+    unit.group_key = parent;
+    unit.target_name = parent.substr(parent.rfind('/') + 1);
+    if (unit.target_name.empty()) {
+        unit.target_name = "objects";
+    }
+}
+
+TranslationUnit classify(const CompileDatabase::Entry& entry) {
+    TranslationUnit unit;
+    unit.source = absolute_view(unit, entry.directory, entry.file);
+
+    std::vector<std::string_view> args;
+    if (!entry.arguments.empty()) {
+        args = entry.arguments;
+    } else {
+        args.reserve(64);
+        tokenize_into(entry.command, args, unit.owned);
+    }
+
+    std::string_view output = entry.output;
+
+    // argv[0] is the compiler itself
+    for (size_t i = 1; i < args.size(); ++i) {
+        std::string_view arg = args[i];
+        std::string_view value;
+        bool separate = takes_separate_argument(arg) && i + 1 < args.size();
+        if (separate) {
+            value = args[++i];
+        }
+
+        if (arg == "-c" || arg == "--" || is_dependency_flag(arg)) {
+            continue;
+        }
+        if (!arg.starts_with("-")) {
+            if (arg == entry.file || absolute_in(entry.directory, arg) == unit.source) {
+                continue;
+            }
+        }
+        if (arg == "-o" || is_joined_output(arg)) {
+            if (output.empty()) {
+                output = separate ? value : arg.substr(2);
+            }
+            continue;
+        }
+        if (arg.starts_with("-D")) {
+            unit.definitions.push_back(separate ? value : arg.substr(2));
+        } else if (arg == "-I" || arg == "-isystem" || arg == "-iquote" ||
+                   (arg.starts_with("-I") && !separate)) {
+            unit.include_directories.push_back(
+                absolute_view(unit, entry.directory, separate ? value : arg.substr(2)));
+        } else if (separate) {
+            std::string option(arg);
+            option += option_separator;
+            option += value;
+            unit.options.push_back(unit.own(std::move(option)));
+        } else {
+            unit.options.push_back(arg);
+        }
+    }
+
+    if (output.empty()) {
+        assign_group(unit, unit.source);
+    } else {
+        assign_group(unit, absolute_view(unit, entry.directory, output));
+    }
+    return unit;
+}
+
+// Items present in every list, in the order of the first list
+std::vector<std::string>
+common_items(const std::vector<const std::vector<std::string_view>*>& lists, size_t& dropped) {
+    std::vector<std::string> common;
+    if (lists.empty()) {
+        return common;
+    }
+    std::unordered_map<std::string_view, size_t> counts;
+    for (const auto* list : lists) {
+        std::unordered_set<std::string_view> seen(list->begin(), list->end());
+        for (const auto& item : seen) {
+            ++counts[item];
+        }
+    }
+    std::unordered_set<std::string_view> emitted;
+    for (const auto& item : *lists.front()) {
+        if (counts[item] == lists.size() && emitted.insert(item).second) {
+            common.emplace_back(item);
+        }
+    }
+    for (const auto& [item, count] : counts) {
+        if (count != lists.size()) {
+            ++dropped;
+        }
+    }
+    return common;
+}
+
+std::string common_directory(const std::vector<const TranslationUnit*>& units) {
+    std::string_view common = parent_of(units.front()->source);
+    for (const auto* unit : units) {
+        std::string_view dir = parent_of(unit->source);
+        while (!common.empty() && !(dir.starts_with(common) &&
+                 (dir.size() == common.size() || dir[common.size()] == '/'))) {
+            common = parent_of(common);
+        }
+    }
+    return std::string(common.empty() ? "/" : common);
+}
+
+std::string relative_to(std::string_view path, std::string_view base) {
+    if (base == "/" && path.starts_with("/")) {
+        return std::string(path.substr(1));
+    }
+    if (path.size() > base.size() && path.starts_with(base) && path[base.size()] == '/') {
+        return std::string(path.substr(base.size() + 1));
+    }
+    return std::string(path);
+}
+
+bool is_compiled_source(PathId path) {
+    auto ext = path.extension();
+    return ext == ".c" || ext == ".cc" || ext == ".cpp" || ext == ".cxx" || ext == ".c++" ||
+           ext == ".C" || ext == ".m" || ext == ".mm";
+}
+
+std::set<std::string> absolute_sources(const Target& target) {
+    std::set<std::string> sources;
+    for (auto src : target.sources) {
+        if (is_compiled_source(src)) {
+            sources.insert((target.source_directory / src).str());
+        }
+    }
+    return sources;
+}
+
+std::string example_of(const std::vector<std::string>& items) {
+    return items.empty() ? std::string() : fmt::format(" (e.g. {})", items.front());
+}
+
+} // namespace
+
+CompileDatabaseAnalyzer::CompileDatabaseAnalyzer(size_t max_threads)
+    : max_threads_(max_threads) {}
+
+Result<ProjectAnalysis, AnalysisError>
+CompileDatabaseAnalyzer::analyze(const fs::path& database) const {
+    auto loaded = CompileDatabase::load(database);
+    if (!loaded.has_value()) {
+        return Result<ProjectAnalysis, AnalysisError>(
+            std::in_place_index<1>,
+            AnalysisError(AnalysisError::Category::InvalidConfiguration,
+                          loaded.error().message()));
+    }
+    return Result<ProjectAnalysis, AnalysisError>(analyze(loaded.value()));
+}
+
+ProjectAnalysis CompileDatabaseAnalyzer::analyze(const CompileDatabase& database) const {
+    return analyze(database.entries());
+}
+
+ProjectAnalysis
+CompileDatabaseAnalyzer::analyze(const std::vector<CompileDatabase::Entry>& entries) const {
+
+    // Tokenizing and classifying command lines dominates; do it in parallel
+    std::vector<TranslationUnit> units(entries.size());
+    parallel_for(
+        entries.size(), [&](size_t i) { units[i] = classify(entries[i]); }, max_threads_);
+
+    // Group translation units into targets, in order of first appearance
+    std::vector<std::string_view> group_order;
+    std::unordered_map<std::string_view, std::vector<const TranslationUnit*>> groups;
+    for (const auto& unit : units) {
+        auto [it, inserted] = groups.try_emplace(unit.group_key);
+        if (inserted) {
+            group_order.push_back(unit.group_key);
+        }
+        it->second.push_back(&unit);
+    }
+
+    ProjectAnalysis analysis;
+    std::unordered_map<std::string, size_t> name_counts;
+    for (const auto& key : group_order) {
+        const auto& members = groups[key];
+
+        Target target;
+        target.name = std::string(members.front()->target_name);
+        if (size_t n = name_counts[target.name]++; n > 0) {
+            target.name += "_" + std::to_string(n);
+        }
+        target.type = Target::Type::StaticLibrary; // Refined by reconcile() when possible
+        target.confidence = Target::Confidence::Inferred;
+        auto source_directory = common_directory(members);
+        target.source_directory = source_directory;
+
+        std::unordered_set<std::string_view> seen_sources;
+        for (const auto* unit : members) {
+            if (seen_sources.insert(unit->source).second) {
+                target.sources.push_back(relative_to(unit->source, source_directory));
+            }
+        }
+
+        // Buck2 attaches flags per target; keep the ones every unit agrees on
+        std::vector<const std::vector<std::string_view>*> definitions;
+        std::vector<const std::vector<std::string_view>*> includes;
+        std::vector<const std::vector<std::string_view>*> options;
+        for (const auto* unit : members) {
+            definitions.push_back(&unit->definitions);
+            includes.push_back(&unit->include_directories);
+            options.push_back(&unit->options);
+        }
+        size_t dropped = 0;
+        target.compile_definitions = common_items(definitions, dropped);
+        for (const auto& dir : common_items(includes, dropped)) {
+            target.include_directories.push_back(relative_to(dir, source_directory));
+        }
+        for (const auto& option : common_items(options, dropped)) {
+            auto separator = option.find(option_separator);
+            target.compile_options.push_back(option.substr(0, separator));
+            if (separator != std::string::npos) {
+                target.compile_options.push_back(option.substr(separator + 1));
+            }
+        }
+        if (dropped > 0) {
+            analysis.warnings.push_back(
+                fmt::format("compile_commands: target '{}' has {} per-file flags that differ "
+                            "between its sources and were not carried over",
+                            target.name, dropped));
+        }
+
+        analysis.targets.push_back(std::move(target));
+    }
+
+    LOG_DEBUG("Derived {} targets from {} compile commands", analysis.targets.size(),
+              entries.size());
+    return analysis;
+}
+
+std::vector<std::string> CompileDatabaseAnalyzer::cross_check(const ProjectAnalysis& evaluated,
+                                                              const ProjectAnalysis& observed) {
+    std::vector<std::string> findings;
+
+    std::unordered_map<std::string, const Target*> observed_by_name;
+    for (const auto& target : observed.targets) {
+        observed_by_name[target.name] = &target;
+    }
+    std::unordered_set<std::string> evaluated_names;
+
+    for (const auto& target : evaluated.targets) {
+        evaluated_names.insert(target.name);
+        if (target.type == Target::Type::InterfaceLibrary ||
+            target.type == Target::Type::CustomTarget) {
+            continue; // Nothing to compile
+        }
+
+        auto it = observed_by_name.find(target.name);
+        if (it == observed_by_name.end()) {
+            findings.push_back(fmt::format(
+                "Target '{}' is defined in CMake but has no compile commands", target.name));
+            continue;
+        }
+        const Target& actual = *it->second;
+
+        auto expected_sources = absolute_sources(target);
+        auto actual_sources = absolute_sources(actual);
+        std::vector<std::string> missing;
+        std::vector<std::string> extra;
+        std::set_difference(expected_sources.begin(), expected_sources.end(),
+                            actual_sources.begin(), actual_sources.end(),
+                            std::back_inserter(missing));
+        std::set_difference(actual_sources.begin(), actual_sources.end(),
+                            expected_sources.begin(), expected_sources.end(),
+                            std::back_inserter(extra));
+        if (!missing.empty()) {
+            findings.push_back(fmt::format("Target '{}': {} sources are not compiled{}",
+                                           target.name, missing.size(), example_of(missing)));
+        }
+        if (!extra.empty()) {
+            findings.push_back(fmt::format("Target '{}': {} compiled sources are not known to "
+                                           "CMake evaluation{}",
+                                           target.name, extra.size(), example_of(extra)));
+        }
+
+        std::set<std::string> expected_defs(target.compile_definitions.begin(),
+                                            target.compile_definitions.end());
+        std::set<std::string> actual_defs(actual.compile_definitions.begin(),
+                                          actual.compile_definitions.end());
+        std::vector<std::string> missing_defs;
+        std::set_difference(expected_defs.begin(), expected_defs.end(), actual_defs.begin(),
+                            actual_defs.end(), std::back_inserter(missing_defs));
+        if (!missing_defs.empty()) {
+            findings.push_back(fmt::format("Target '{}': {} definitions are not passed to the "
+                                           "compiler{}",
+                                           target.name, missing_defs.size(),
+                                           example_of(missing_defs)));
+        }
+    }
+
+    for (const auto& target : observed.targets) {
+        if (!evaluated_names.contains(target.name)) {
+            findings.push_back(fmt::format(
+                "Target '{}' is compiled but was not found by CMake evaluation", target.name));
+        }
+    }
+
+    return findings;
+}
+
+void CompileDatabaseAnalyzer::reconcile(ProjectAnalysis& observed,
+                                        const ProjectAnalysis& evaluated) {
+    std::unordered_map<std::string, const Target*> evaluated_by_name;
+    for (const auto& target : evaluated.targets) {
+        evaluated_by_name[target.name] = &target;
+    }
+
+    for (auto& target : observed.targets) {
+        auto it = evaluated_by_name.find(target.name);
+        if (it == evaluated_by_name.end()) {
+            continue;
+        }
+        target.type = it->second->type;
+        target.link_libraries = it->second->link_libraries;
+        for (const auto& [key, value] : it->second->properties) {
+            target.properties.try_emplace(key, value);
+        }
+    }
+
+    if (observed.project_name.empty()) {
+        observed.project_name = evaluated.project_name;
+        observed.project_version = evaluated.project_version;
+    }
+}
+
+} // namespace finch::analyzer
@@ -0,0 +1,111 @@
+#include <finch/analyzer/cpm_package_lock.hpp>
+#include <finch/core/fnv_hash.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <finch/parser/ast/cpm_nodes.hpp>
+#include <finch/parser/ast/structure.hpp>
+#include <finch/parser/parser.hpp>
+#include <fmt/format.h>
+
+namespace finch::analyzer {
+
+CPMPackage CPMPackageLock::declaration_of(const ast::CPMDeclarePackage& node) {
+    CPMPackage package;
+    package.name = node.name();
+    if (node.github_repository()) {
+        package.source_type = CPMPackage::SourceType::GitHub;
+        package.source = *node.github_repository();
+    } else if (node.git_repository()) {
+        package.source_type = CPMPackage::SourceType::Git;
+        package.source = *node.git_repository();
+    } else if (node.url()) {
+        package.source_type = CPMPackage::SourceType::URL;
+        package.source = *node.url();
+    }
+    package.version = node.version();
+    package.git_tag = node.git_tag().value_or("");
+    package.declared_in = fmt::format("{}:{}", node.location().file, node.location().line);
+    return package;
+}
+
+uint64_t CPMPackageLock::hash_content(std::string_view content) {
+    uint64_t hash = fnv_offset_basis;
+    hash_bytes(hash, content);
+    return hash;
+}
+
+Result<CPMPackageLock, AnalysisError> CPMPackageLock::parse(std::string_view content,
+                                                            const std::string& path) {
+    parser::Parser parser(content, path);
+    auto file = parser.parse_file();
+    if (!file.has_value()) {
+        const auto& errors = file.error();
+        return Result<CPMPackageLock, AnalysisError>(
+            std::in_place_index<1>,
+            AnalysisError(fmt::format("Cannot parse package lock {}: {}", path,
+                                      errors.empty() ? "syntax error" : errors[0].message())));
+    }
+
+    CPMPackageLock lock;
+    lock.content_hash_ = hash_content(content);
+    for (const auto& statement : file.value()->statements()) {
+        const auto* declaration = dynamic_cast<const ast::CPMDeclarePackage*>(statement.get());
+        if (!declaration) {
+            continue;
+        }
+        lock.by_name_[declaration->name()] = lock.declarations_.size();
+        lock.declarations_.push_back(declaration_of(*declaration));
+    }
+    return Result<CPMPackageLock, AnalysisError>(std::move(lock));
+}
+
+const CPMPackage* CPMPackageLock::find(std::string_view name) const {
+    auto it = by_name_.find(std::string(name));
+    return it == by_name_.end() ? nullptr : &declarations_[it->second];
+}
+
+std::string CPMPackageLockCache::Stats::to_string() const {
+    return fmt::format("Package locks: {} loads, {} parsed, {} reused", loads, parsed, reused);
+}
+
+std::shared_ptr<const CPMPackageLock> CPMPackageLockCache::load(const std::filesystem::path& path) {
+    auto file = MappedFile::open(path);
+    if (!file.has_value()) {
+        LOG_DEBUG("Package lock {} not found", path.string());
+        return nullptr;
+    }
+    auto content = file.value().view();
+    auto hash = CPMPackageLock::hash_content(content);
+    auto key = path.lexically_normal().generic_string();
+
+    {
+        std::lock_guard lock(mutex_);
+        ++stats_.loads;
+        auto it = locks_.find(key);
+        if (it != locks_.end() && it->second->content_hash() == hash) {
+            ++stats_.reused;
+            return it->second;
+        }
+    }
+
+    // Parsed outside the lock; two files racing on a new lock both parse it
+    auto parsed = CPMPackageLock::parse(content, path.string());
+    if (!parsed.has_value()) {
+        LOG_DEBUG("{}", parsed.error().message());
+        return nullptr;
+    }
+    auto shared = std::make_shared<const CPMPackageLock>(std::move(parsed.value()));
+    LOG_DEBUG("Package lock {}: {} declarations", path.string(), shared->declarations().size());
+
+    std::lock_guard lock(mutex_);
+    ++stats_.parsed;
+    locks_[key] = shared;
+    return shared;
+}
+
+CPMPackageLockCache::Stats CPMPackageLockCache::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+} // namespace finch::analyzer
@@ -0,0 +1,72 @@
+#include <finch/analyzer/cpm_resolver.hpp>
+#include <finch/core/logging.hpp>
+#include <fmt/format.h>
+
+namespace finch::analyzer {
+
+namespace {
+
+// cpm_get_version_from_git_tag(): a 40 character tag is a commit, anything
+// else is read as an optional 'v' followed by the version
+Version version_from_tag(std::string_view tag) {
+    if (tag.size() == 40) {
+        return Version::parse("0");
+    }
+    if (tag.starts_with('v')) {
+        tag.remove_prefix(1);
+    }
+    return Version::parse(tag);
+}
+
+} // namespace
+
+std::string CPMResolver::Conflict::to_string() const {
+    return fmt::format("CPM: {} requires a newer version ({}) than currently included ({}); "
+                       "first declared at {}, requested at {}",
+                       name, requested_version, version, declared_in, requested_in);
+}
+
+Version CPMResolver::version_of(const CPMPackage& package) {
+    if (!package.version.empty()) {
+        // A GIT_TAG without VERSION is declared as the version too
+        return version_from_tag(package.version);
+    }
+    if (!package.git_tag.empty()) {
+        return version_from_tag(package.git_tag);
+    }
+    return Version::parse("0");
+}
+
+void CPMResolver::add(const CPMPackage& declaration) {
+    auto [it, inserted] = index_.try_emplace(declaration.name, packages_.size());
+    Version version = version_of(declaration);
+    if (inserted) {
+        packages_.push_back(declaration);
+        versions_.push_back(version);
+        return;
+    }
+
+    const auto& added = packages_[it->second];
+    if (versions_[it->second] < version) {
+        conflicts_.push_back({declaration.name, versions_[it->second].to_string(),
+                              version.to_string(), added.declared_in, declaration.declared_in});
+    }
+    LOG_TRACE("CPM package {} already added at {}, reusing it for {}", declaration.name,
+              added.declared_in, declaration.declared_in);
+}
+
+void CPMResolver::resolve(ProjectAnalysis& analysis) {
+    CPMResolver resolver;
+    for (const auto& declaration : analysis.cpm_packages) {
+        resolver.add(declaration);
+    }
+    LOG_DEBUG("CPM: {} declarations resolved to {} packages, {} conflicts",
+              analysis.cpm_packages.size(), resolver.packages_.size(),
+              resolver.conflicts_.size());
+    for (const auto& conflict : resolver.conflicts_) {
+        analysis.warnings.push_back(conflict.to_string());
+    }
+    analysis.cpm_packages = std::move(resolver.packages_);
+}
+
+} // namespace finch::analyzer
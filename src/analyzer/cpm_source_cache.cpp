@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <finch/analyzer/cpm_source_cache.hpp>
+#include <finch/core/cache_directory.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <finch/core/sha256.hpp>
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+namespace finch::analyzer {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using json = nlohmann::json;
+
+constexpr int cache_format_version = 1;
+
+std::string lowercase(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+int64_t stamp_of(const fs::path& path) {
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec);
+    return ec ? -1 : time.time_since_epoch().count();
+}
+
+// The file name without its archive extension, or nullopt for other files
+std::optional<std::string> archive_stem(const std::string& filename) {
+    for (std::string_view extension :
+         {".tar.gz", ".tgz", ".tar.bz2", ".tar.xz", ".tar.zst", ".tar", ".zip"}) {
+        if (filename.size() > extension.size() && filename.ends_with(extension)) {
+            return filename.substr(0, filename.size() - extension.size());
+        }
+    }
+    return std::nullopt;
+}
+
+// Tags of a git checkout: loose refs under .git/refs/tags and packed ones
+std::vector<std::string> git_tags(const fs::path& checkout) {
+    std::vector<std::string> tags;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(checkout / ".git" / "refs" / "tags", ec)) {
+        tags.push_back(entry.path().filename().string());
+    }
+
+    if (auto packed = MappedFile::open(checkout / ".git" / "packed-refs"); packed.has_value()) {
+        constexpr std::string_view prefix = "refs/tags/";
+        auto text = packed.value().view();
+        while (!text.empty()) {
+            auto end = text.find('\n');
+            auto line = text.substr(0, end);
+            text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            // "<sha> refs/tags/<tag>"; '^' lines are peeled annotated tags
+            auto space = line.find(' ');
+            if (line.empty() || line[0] == '#' || line[0] == '^' || space == line.npos ||
+                !line.substr(space + 1).starts_with(prefix)) {
+                continue;
+            }
+            tags.emplace_back(line.substr(space + 1 + prefix.size()));
+        }
+    }
+    std::sort(tags.begin(), tags.end());
+    tags.erase(std::unique(tags.begin(), tags.end()), tags.end());
+    return tags;
+}
+
+// The refs CPM would check out for a package
+std::vector<std::string> wanted_refs(const CPMPackage& package) {
+    std::vector<std::string> refs;
+    if (!package.git_tag.empty()) {
+        refs.push_back(package.git_tag);
+    }
+    if (!package.version.empty()) {
+        refs.push_back(package.version);
+        refs.push_back("v" + package.version);
+    }
+    return refs;
+}
+
+// "fmt-10.0.0" holds ref "10.0.0"; so does "10.0.0" itself
+bool archive_holds(std::string_view stem, std::string_view ref) {
+    return stem == ref || (stem.size() > ref.size() && stem.ends_with(ref) &&
+                           stem[stem.size() - ref.size() - 1] == '-');
+}
+
+const char* kind_name(CPMSourceCache::Entry::Kind kind) {
+    return kind == CPMSourceCache::Entry::Kind::Archive ? "archive" : "source";
+}
+
+} // namespace
+
+std::string CPMSourceCache::Stats::to_string() const {
+    return fmt::format("CPM source cache: {} archives ({} hashed, {} reused, {} bytes read), "
+                       "{} source trees",
+                       archives, hashed, reused, bytes_hashed, sources);
+}
+
+void CPMSourceCache::add(Entry entry) {
+    by_name_[lowercase(entry.name)].push_back(entries_.size());
+    entries_.push_back(std::move(entry));
+}
+
+CPMSourceCache CPMSourceCache::build(const fs::path& root, const CPMSourceCache* previous,
+                                     size_t max_threads) {
+    CPMSourceCache cache;
+    cache.root_ = root.generic_string();
+
+    // Listing is cheap next to hashing, so the cache is always listed again
+    std::error_code ec;
+    std::vector<fs::path> packages;
+    for (const auto& entry : fs::directory_iterator(root, ec)) {
+        if (entry.is_directory(ec)) {
+            packages.push_back(entry.path());
+        }
+    }
+    std::sort(packages.begin(), packages.end());
+
+    for (const auto& package : packages) {
+        std::vector<fs::directory_entry> children;
+        for (const auto& child : fs::directory_iterator(package, ec)) {
+            children.push_back(child);
+        }
+        std::sort(children.begin(), children.end());
+
+        for (const auto& child : children) {
+            Entry entry;
+            entry.name = package.filename().string();
+            entry.path = child.path();
+            if (child.is_directory(ec)) {
+                entry.kind = Entry::Kind::Source;
+                entry.refs = git_tags(child.path());
+                ++cache.stats_.sources;
+            } else if (auto stem = archive_stem(child.path().filename().string());
+                       stem && child.is_regular_file(ec)) {
+                entry.refs.push_back(*stem);
+                entry.size = child.file_size(ec);
+                entry.mtime = stamp_of(child.path());
+                ++cache.stats_.archives;
+            } else {
+                continue;
+            }
+            cache.add(std::move(entry));
+        }
+    }
+
+    // Archives are identified by path, size and modification time
+    std::unordered_map<std::string, const Entry*> known;
+    if (previous && previous->root_ == cache.root_) {
+        for (const auto& entry : previous->entries_) {
+            if (entry.kind == Entry::Kind::Archive && !entry.sha256.empty()) {
+                known.emplace(entry.path.generic_string(), &entry);
+            }
+        }
+    }
+    std::vector<size_t> to_hash;
+    for (size_t i = 0; i < cache.entries_.size(); ++i) {
+        auto& entry = cache.entries_[i];
+        if (entry.kind != Entry::Kind::Archive) {
+            continue;
+        }
+        auto it = known.find(entry.path.generic_string());
+        if (it != known.end() && it->second->size == entry.size &&
+            it->second->mtime == entry.mtime) {
+            entry.sha256 = it->second->sha256;
+            ++cache.stats_.reused;
+        } else {
+            to_hash.push_back(i);
+        }
+    }
+
+    // One archive per task; each is hashed straight from its mapping
+    parallel_for(
+        to_hash.size(),
+        [&](size_t i) {
+            auto& entry = cache.entries_[to_hash[i]];
+            auto file = MappedFile::open(entry.path);
+            if (!file.has_value()) {
+                return;
+            }
+            Sha256 hasher;
+            hasher.update(file.value().view());
+            entry.sha256 = Sha256::to_hex(hasher.finish());
+        },
+        max_threads);
+    for (size_t index : to_hash) {
+        if (!cache.entries_[index].sha256.empty()) {
+            ++cache.stats_.hashed;
+            cache.stats_.bytes_hashed += cache.entries_[index].size;
+        }
+    }
+
+    LOG_DEBUG("{}", cache.stats_.to_string());
+    return cache;
+}
+
+Result<CPMSourceCache, IOError> CPMSourceCache::load(const fs::path& index_file) {
+    auto file = MappedFile::open(index_file);
+    if (!file.has_value()) {
+        return Result<CPMSourceCache, IOError>(std::in_place_index<1>, file.error());
+    }
+    auto text = file.value().view();
+    auto document = json::parse(text.begin(), text.end(), nullptr, false);
+    if (document.is_discarded() || !document.is_object() ||
+        document.value("format", 0) != cache_format_version) {
+        return Result<CPMSourceCache, IOError>(
+            std::in_place_index<1>,
+            IOError(fmt::format("CPM source cache index {}: unreadable or from another version",
+                                index_file.string())));
+    }
+
+    CPMSourceCache cache;
+    cache.root_ = document.value("root", "");
+    auto entries = document.find("entries");
+    if (entries != document.end() && entries->is_array()) {
+        for (const auto& object : *entries) {
+            if (!object.is_object()) {
+                continue;
+            }
+            Entry entry;
+            entry.name = object.value("name", "");
+            entry.kind = object.value("kind", "") == "source" ? Entry::Kind::Source
+                                                              : Entry::Kind::Archive;
+            entry.path = object.value("path", "");
+            entry.refs = object.value("refs", std::vector<std::string>{});
+            entry.size = object.value("size", uint64_t{0});
+            entry.mtime = object.value("mtime", int64_t{0});
+            entry.sha256 = object.value("sha256", "");
+            cache.add(std::move(entry));
+        }
+    }
+    return Result<CPMSourceCache, IOError>(std::move(cache));
+}
+
+CPMSourceCache CPMSourceCache::update(const fs::path& root, const fs::path& index_file,
+                                      size_t max_threads) {
+    auto previous = load(index_file);
+    if (!previous.has_value()) {
+        LOG_DEBUG("Hashing the whole CPM source cache: {}", previous.error().message());
+    }
+    auto cache = build(root, previous.has_value() ? &previous.value() : nullptr, max_threads);
+    if (auto saved = cache.save(index_file); saved.has_error()) {
+        LOG_DEBUG("Not saving CPM source cache index: {}", saved.error().message());
+    }
+    return cache;
+}
+
+Result<void, IOError> CPMSourceCache::save(const fs::path& index_file) const {
+    json entries = json::array();
+    for (const auto& entry : entries_) {
+        entries.push_back({{"name", entry.name},
+                           {"kind", kind_name(entry.kind)},
+                           {"path", entry.path.generic_string()},
+                           {"refs", entry.refs},
+                           {"size", entry.size},
+                           {"mtime", entry.mtime},
+                           {"sha256", entry.sha256}});
+    }
+    json document = {
+        {"format", cache_format_version}, {"root", root_}, {"entries", std::move(entries)}};
+
+    return replace_file(index_file, document.dump());
+}
+
+fs::path CPMSourceCache::default_index_file() {
+    return cache_directory() / "cpm-source-cache.json";
+}
+
+std::optional<fs::path> CPMSourceCache::default_root() {
+    if (const char* root = std::getenv("CPM_SOURCE_CACHE"); root && *root) {
+        return fs::path(root);
+    }
+    return std::nullopt;
+}
+
+const CPMSourceCache::Entry* CPMSourceCache::find(const CPMPackage& package) const {
+    auto it = by_name_.find(lowercase(package.name));
+    if (it == by_name_.end()) {
+        return nullptr;
+    }
+
+    auto refs = wanted_refs(package);
+    std::string url_file;
+    if (package.source_type == CPMPackage::SourceType::URL) {
+        url_file = package.source.substr(package.source.find_last_of('/') + 1);
+        url_file = url_file.substr(0, url_file.find_first_of("?#"));
+    }
+
+    const Entry* source = nullptr;
+    for (size_t index : it->second) {
+        const auto& entry = entries_[index];
+        if (entry.kind == Entry::Kind::Archive) {
+            if (!url_file.empty() && entry.path.filename() == url_file) {
+                return &entry;
+            }
+            for (const auto& ref : refs) {
+                if (!entry.refs.empty() && archive_holds(entry.refs.front(), ref)) {
+                    return &entry;
+                }
+            }
+        } else if (!source) {
+            for (const auto& ref : refs) {
+                if (std::binary_search(entry.refs.begin(), entry.refs.end(), ref)) {
+                    source = &entry;
+                    break;
+                }
+            }
+        }
+    }
+    return source;
+}
+
+std::vector<std::string> CPMSourceCache::fill(std::vector<CPMPackage>& packages) const {
+    using SourceType = CPMPackage::SourceType;
+    std::vector<std::string> warnings;
+    size_t filled = 0;
+    for (auto& package : packages) {
+        if (package.source_type == SourceType::None || package.source_type == SourceType::Local) {
+            continue;
+        }
+        const Entry* entry = find(package);
+        if (!entry) {
+            continue;
+        }
+        if (entry->kind == Entry::Kind::Archive && !entry->sha256.empty()) {
+            package.sha256 = entry->sha256;
+            ++filled;
+        } else if (entry->kind == Entry::Kind::Source) {
+            warnings.push_back(fmt::format("CPM package {} is cached as sources in {} but not as "
+                                           "an archive, so its sha256 is unknown",
+                                           package.name, entry->path.string()));
+        }
+    }
+    LOG_DEBUG("CPM source cache: sha256 of {} of {} packages", filled, packages.size());
+    return warnings;
+}
+
+} // namespace finch::analyzer
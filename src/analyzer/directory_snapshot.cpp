@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <finch/analyzer/directory_snapshot.hpp>
+#include <finch/core/logging.hpp>
+#include <fmt/format.h>
+
+namespace finch::analyzer {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Symlinked directories followed by FOLLOW_SYMLINKS may form a cycle
+constexpr size_t max_walk_depth = 64;
+
+} // namespace
+
+GlobMatcher::GlobMatcher(std::string_view pattern) : pattern_(pattern) {
+    auto text = [&]() -> std::string& {
+        if (tokens_.empty() || tokens_.back().kind != Token::Kind::Text) {
+            tokens_.push_back({Token::Kind::Text, {}, {}});
+        }
+        return tokens_.back().text;
+    };
+
+    for (size_t i = 0; i < pattern.size(); ++i) {
+        char c = pattern[i];
+        if (c == '*') {
+            if (tokens_.empty() || tokens_.back().kind != Token::Kind::Star) {
+                tokens_.push_back({Token::Kind::Star, {}, {}});
+            }
+            literal_ = false;
+        } else if (c == '?') {
+            tokens_.push_back({Token::Kind::Any, {}, {}});
+            literal_ = false;
+        } else if (c == '[') {
+            // A ']' right after the opening (or its negation) is a member
+            size_t j = i + 1;
+            bool negated = j < pattern.size() && (pattern[j] == '!' || pattern[j] == '^');
+            j += negated ? 1 : 0;
+            size_t first = j;
+            if (j < pattern.size() && pattern[j] == ']') {
+                ++j;
+            }
+            while (j < pattern.size() && pattern[j] != ']') {
+                ++j;
+            }
+            if (j == pattern.size()) {
+                text() += c; // No closing ']', so a plain '['
+                continue;
+            }
+            std::bitset<256> members;
+            for (size_t k = first; k < j; ++k) {
+                auto low = static_cast<unsigned char>(pattern[k]);
+                if (k + 2 < j && pattern[k + 1] == '-') {
+                    auto high = static_cast<unsigned char>(pattern[k + 2]);
+                    for (unsigned member = low; member <= high; ++member) {
+                        members.set(member);
+                    }
+                    k += 2;
+                } else {
+                    members.set(low);
+                }
+            }
+            if (negated) {
+                members.flip();
+                members.reset('/');
+            }
+            tokens_.push_back({Token::Kind::Class, {}, members});
+            literal_ = false;
+            i = j;
+        } else {
+            text() += c;
+        }
+    }
+}
+
+bool GlobMatcher::matches(std::string_view name) const {
+    if (literal_) {
+        return name == pattern_;
+    }
+    // Greedy, backtracking to the last '*' on a mismatch
+    size_t token = 0;
+    size_t position = 0;
+    size_t star = tokens_.size();
+    size_t star_position = 0;
+    while (position < name.size() || token < tokens_.size()) {
+        if (token < tokens_.size()) {
+            const auto& current = tokens_[token];
+            switch (current.kind) {
+            case Token::Kind::Star:
+                star = token++;
+                star_position = position;
+                continue;
+            case Token::Kind::Any:
+                if (position < name.size()) {
+                    ++token;
+                    ++position;
+                    continue;
+                }
+                break;
+            case Token::Kind::Class:
+                if (position < name.size() &&
+                    current.members.test(static_cast<unsigned char>(name[position]))) {
+                    ++token;
+                    ++position;
+                    continue;
+                }
+                break;
+            case Token::Kind::Text:
+                if (name.substr(position).starts_with(current.text)) {
+                    ++token;
+                    position += current.text.size();
+                    continue;
+                }
+                break;
+            }
+        }
+        if (star == tokens_.size() || star_position >= name.size()) {
+            return false;
+        }
+        position = ++star_position;
+        token = star + 1;
+    }
+    return true;
+}
+
+std::string DirectorySnapshot::Stats::to_string() const {
+    return fmt::format("Directory snapshot: {} globs, {} directories read ({} entries)", globs,
+                       directories_read, entries);
+}
+
+DirectorySnapshot::DirectorySnapshot() {
+    nodes_.push_back(Node{});
+    nodes_[0].listed = true;
+}
+
+uint32_t DirectorySnapshot::root_of(const fs::path& root) {
+    auto name = root.generic_string();
+    for (auto child : nodes_[0].children) {
+        if (nodes_[child].name == name) {
+            return child;
+        }
+    }
+    auto id = static_cast<uint32_t>(nodes_.size());
+    nodes_.push_back(Node{name, 0, true, false, false, {}});
+    nodes_[0].children.push_back(id);
+    return id;
+}
+
+const std::vector<uint32_t>& DirectorySnapshot::list(uint32_t directory) {
+    if (nodes_[directory].listed) {
+        return nodes_[directory].children;
+    }
+    std::vector<Node> entries;
+    std::error_code ec;
+    for (fs::directory_iterator it(path_of(directory), ec), end; !ec && it != end;
+         it.increment(ec)) {
+        std::error_code status_ec;
+        Node entry;
+        entry.name = it->path().filename().string();
+        entry.parent = directory;
+        entry.symlink = it->is_symlink(status_ec);
+        entry.directory = it->is_directory(status_ec);
+        entries.push_back(std::move(entry));
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const Node& a, const Node& b) { return a.name < b.name; });
+
+    auto first = static_cast<uint32_t>(nodes_.size());
+    std::vector<uint32_t> children(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        children[i] = first + static_cast<uint32_t>(i);
+        nodes_.push_back(std::move(entries[i]));
+    }
+    auto& node = nodes_[directory];
+    node.children = std::move(children);
+    node.listed = true;
+    ++stats_.directories_read;
+    stats_.entries += node.children.size();
+    return node.children;
+}
+
+uint32_t DirectorySnapshot::child_named(uint32_t directory, std::string_view name) {
+    const auto& children = list(directory);
+    auto it = std::lower_bound(children.begin(), children.end(), name,
+                               [&](uint32_t child, std::string_view wanted) {
+                                   return nodes_[child].name < wanted;
+                               });
+    return it != children.end() && nodes_[*it].name == name ? *it : no_node;
+}
+
+std::string DirectorySnapshot::path_of(uint32_t node) const {
+    std::vector<const std::string*> names;
+    for (; node != 0 && node != no_node; node = nodes_[node].parent) {
+        names.push_back(&nodes_[node].name);
+    }
+    std::string path;
+    for (auto it = names.rbegin(); it != names.rend(); ++it) {
+        if (!path.empty() && path.back() != '/') {
+            path += '/';
+        }
+        path += **it;
+    }
+    return path;
+}
+
+void DirectorySnapshot::walk(uint32_t directory, const GlobMatcher& last, const Options& options,
+                             std::vector<uint32_t>& found, size_t depth) {
+    // Listing may grow nodes_, so the children are copied first
+    auto children = list(directory);
+    for (auto child : children) {
+        const auto& node = nodes_[child];
+        bool descend = node.directory && (!node.symlink || options.follow_symlinks);
+        if (!descend) {
+            if (last.matches(node.name)) {
+                found.push_back(child);
+            }
+            continue;
+        }
+        if (options.list_directories) {
+            found.push_back(child);
+        }
+        if (depth < max_walk_depth) {
+            walk(child, last, options, found, depth + 1);
+        }
+    }
+}
+
+std::vector<std::string> DirectorySnapshot::glob(const fs::path& pattern, const Options& options) {
+    std::lock_guard lock(mutex_);
+    ++stats_.globs;
+    auto normal = pattern.lexically_normal();
+    if (!normal.has_root_path()) {
+        return {};
+    }
+    std::vector<GlobMatcher> matchers;
+    for (const auto& part : normal.relative_path()) {
+        auto component = part.generic_string();
+        if (!component.empty() && component != ".") {
+            matchers.emplace_back(component);
+        }
+    }
+    if (matchers.empty()) {
+        return {};
+    }
+
+    // Directories matching every component but the last
+    std::vector<uint32_t> directories = {root_of(normal.root_path())};
+    for (size_t i = 0; i + 1 < matchers.size(); ++i) {
+        const auto& matcher = matchers[i];
+        std::vector<uint32_t> next;
+        for (auto directory : directories) {
+            if (matcher.pattern() == "..") {
+                next.push_back(nodes_[directory].parent == 0 ? directory
+                                                             : nodes_[directory].parent);
+            } else if (matcher.is_literal()) {
+                auto child = child_named(directory, matcher.pattern());
+                if (child != no_node && nodes_[child].directory) {
+                    next.push_back(child);
+                }
+            } else {
+                auto children = list(directory);
+                for (auto child : children) {
+                    if (nodes_[child].directory && matcher.matches(nodes_[child].name)) {
+                        next.push_back(child);
+                    }
+                }
+            }
+        }
+        directories = std::move(next);
+    }
+
+    const auto& last = matchers.back();
+    std::vector<uint32_t> found;
+    for (auto directory : directories) {
+        if (options.recurse) {
+            walk(directory, last, options, found, 0);
+        } else if (last.is_literal()) {
+            auto child = child_named(directory, last.pattern());
+            if (child != no_node && (options.list_directories || !nodes_[child].directory)) {
+                found.push_back(child);
+            }
+        } else {
+            auto children = list(directory);
+            for (auto child : children) {
+                const auto& node = nodes_[child];
+                if ((options.list_directories || !node.directory) && last.matches(node.name)) {
+                    found.push_back(child);
+                }
+            }
+        }
+    }
+
+    std::vector<std::string> paths;
+    paths.reserve(found.size());
+    for (auto node : found) {
+        paths.push_back(path_of(node));
+    }
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    LOG_TRACE("glob {} matched {} paths", pattern.generic_string(), paths.size());
+    return paths;
+}
+
+DirectorySnapshot::Stats DirectorySnapshot::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+} // namespace finch::analyzer
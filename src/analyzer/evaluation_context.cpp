@@ -1,45 +1,131 @@
 #include <algorithm>
+#include <bit>
+#include <cctype>
+#include <finch/analyzer/cpm_package_lock.hpp>
 #include <finch/analyzer/evaluation_context.hpp>
 #include <finch/core/logging.hpp>
+#include <iterator>
 #include <sstream>
+#include <unordered_set>
+#include <utility>
 
 namespace finch::analyzer {
 
+namespace {
+
+bool same_value(const EvaluatedValue* a, const EvaluatedValue* b) {
+    if (!a || !b) {
+        return !a && !b;
+    }
+    return a->value == b->value && a->confidence == b->confidence;
+}
+
+bool same_value(const std::optional<EvaluatedValue>& a, const std::optional<EvaluatedValue>& b) {
+    return same_value(a ? &*a : nullptr, b ? &*b : nullptr);
+}
+
+// CMake's boolean constants are case-insensitive; NOTFOUND is not
+std::string boolean_constant(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return value;
+}
+
+} // namespace
+
 void EvaluationContext::set_variable(const std::string& name, Value value, Confidence confidence) {
+    record_variable(name);
     variables_[name] = EvaluatedValue{std::move(value), confidence};
+    platform_variables_.erase(name);
     LOG_TRACE("Set variable '{}' with confidence {}", name, static_cast<int>(confidence));
 }
 
 std::optional<EvaluatedValue> EvaluationContext::get_variable(const std::string& name) const {
+    if (const auto* value = find_variable(name)) {
+        return *value;
+    }
+    return std::nullopt;
+}
+
+const EvaluatedValue* EvaluationContext::find_variable(const std::string& name) const {
+    return find_variable(name, static_cast<size_t>(std::countr_zero(active_platforms_)));
+}
+
+const EvaluatedValue* EvaluationContext::find_variable(const std::string& name,
+                                                       size_t platform) const {
     // Check current scope first
     if (auto it = variables_.find(name); it != variables_.end()) {
-        return it->second;
+        return &it->second;
+    }
+    if (!platform_variables_.empty()) {
+        if (auto it = platform_variables_.find(name);
+            it != platform_variables_.end() && it->second[platform]) {
+            return &*it->second[platform];
+        }
     }
 
     // Check parent scope
     if (parent_) {
-        return parent_->get_variable(name);
+        return parent_->find_variable(name, platform);
     }
 
-    return std::nullopt;
+    return nullptr;
+}
+
+EvaluatedValue& EvaluationContext::local_variable(const std::string& name) {
+    record_variable(name);
+    if (auto it = variables_.find(name); it != variables_.end()) {
+        return it->second;
+    }
+    const auto* inherited = find_variable(name);
+    auto value = inherited ? *inherited
+                           : EvaluatedValue{std::vector<std::string>{}, Confidence::Certain};
+    platform_variables_.erase(name);
+    return variables_.emplace(name, std::move(value)).first->second;
+}
+
+void EvaluationContext::unset_variable(const std::string& name) {
+    record_variable(name);
+    variables_.erase(name);
+    platform_variables_.erase(name);
+    LOG_TRACE("Unset variable '{}'", name);
+}
+
+void EvaluationContext::set_parent_scope_variable(const std::string& name,
+                                                  std::optional<EvaluatedValue> value) {
+    if (!parent_) {
+        LOG_DEBUG("No parent scope to set '{}' in", name);
+        return;
+    }
+    if (!directory_scope_) {
+        value ? parent_->set_variable(name, std::move(value->value), value->confidence)
+              : parent_->unset_variable(name);
+        return;
+    }
+    // The parent reads its own scope until this directory is merged
+    parent_scope_writes_.emplace_back(name, active_platforms_, std::move(value));
+    writes_outside_ = true;
 }
 
 void EvaluationContext::set_cache_variable(const std::string& name, Value value,
                                            Confidence confidence) {
     cache_variables_[name] = EvaluatedValue{std::move(value), confidence};
+    tables_changed();
+    writes_outside_ = true;
     LOG_TRACE("Set cache variable '{}' with confidence {}", name, static_cast<int>(confidence));
 }
 
 std::optional<EvaluatedValue> EvaluationContext::get_cache_variable(const std::string& name) const {
-    // Cache variables don't inherit from parent scope
+    // The cache is global; a directory scope holds what it set until merged
     if (auto it = cache_variables_.find(name); it != cache_variables_.end()) {
         return it->second;
     }
-    return std::nullopt;
+    return parent_ ? parent_->get_cache_variable(name) : std::nullopt;
 }
 
 void EvaluationContext::set_platform_check(const std::string& check, bool result) {
     platform_checks_[check] = result;
+    tables_changed();
     LOG_TRACE("Set platform check '{}' = {}", check, result);
 }
 
@@ -65,8 +151,546 @@ const std::vector<Target>& EvaluationContext::get_targets() const {
     return targets_;
 }
 
+Target* EvaluationContext::find_target(const std::string& name) {
+    for (size_t i = 0; i < targets_.size(); ++i) {
+        if (targets_[i].name == name) {
+            record_target(i);
+            return &targets_[i];
+        }
+    }
+    if (!directory_scope_) {
+        note_missed_target(name);
+        return nullptr;
+    }
+
+    // Changed on a copy, so sibling directories evaluated alongside this one
+    // keep reading the original
+    for (const auto* scope = parent_; scope; scope = scope->parent_) {
+        for (const auto& target : scope->targets_) {
+            if (target.name == name) {
+                copied_targets_.insert(name);
+                writes_outside_ = true;
+                return &targets_.emplace_back(target);
+            }
+        }
+    }
+    note_missed_target(name);
+    return nullptr;
+}
+
+bool EvaluationContext::has_target(const std::string& name) {
+    for (const auto* scope = this; scope; scope = scope->parent_) {
+        if (std::any_of(scope->targets_.begin(), scope->targets_.end(),
+                        [&](const Target& target) { return target.name == name; })) {
+            return true;
+        }
+    }
+    note_missed_target(name);
+    return false;
+}
+
+void EvaluationContext::note_missed_target(const std::string& name) {
+    // Kept by the directory the lookup ran in, not a function or block in it
+    for (auto* scope = this; scope; scope = scope->parent_) {
+        if (scope->directory_scope_) {
+            scope->missed_targets_.insert(name);
+            return;
+        }
+    }
+}
+
+const PackageIndex* EvaluationContext::package_index() const {
+    if (package_index_ || !parent_) {
+        return package_index_;
+    }
+    return parent_->package_index();
+}
+
+void EvaluationContext::add_external_package(const ExternalPackage& package) {
+    if (!journals_.empty() && !journals_.back().external_packages) {
+        journals_.back().external_packages = external_packages_;
+    }
+    // A package found twice (e.g. by two find_package calls) is recorded once,
+    // keeping every imported target name it was referred to by
+    for (auto& existing : external_packages_) {
+        if (existing.name == package.name && existing.source == package.source) {
+            for (const auto& target : package.imported_targets) {
+                if (std::find(existing.imported_targets.begin(), existing.imported_targets.end(),
+                              target) == existing.imported_targets.end()) {
+                    existing.imported_targets.push_back(target);
+                }
+            }
+            return;
+        }
+    }
+    external_packages_.push_back(package);
+    LOG_TRACE("Added external package '{}' {}", package.name, package.version);
+}
+
+const std::vector<ExternalPackage>& EvaluationContext::get_external_packages() const {
+    return external_packages_;
+}
+
+void EvaluationContext::add_cpm_package(const CPMPackage& package) {
+    cpm_packages_.push_back(package);
+    LOG_TRACE("Declared CPM package '{}' {}", package.name, package.version);
+}
+
+const std::vector<CPMPackage>& EvaluationContext::get_cpm_packages() const {
+    return cpm_packages_;
+}
+
+CPMPackageLockCache* EvaluationContext::package_lock_cache() const {
+    if (package_lock_cache_ || !parent_) {
+        return package_lock_cache_;
+    }
+    return parent_->package_lock_cache();
+}
+
+void EvaluationContext::use_cpm_package_lock(std::shared_ptr<const CPMPackageLock> lock) {
+    cpm_locks_.emplace_back(cpm_declaration_order_++, std::move(lock));
+    tables_changed();
+}
+
+void EvaluationContext::declare_cpm_package(const CPMPackage& package) {
+    cpm_declarations_[package.name] = {cpm_declaration_order_++, package};
+    tables_changed();
+    LOG_TRACE("CPM package '{}' declared as {}", package.name, package.version);
+}
+
+const CPMPackage* EvaluationContext::find_cpm_declaration(const std::string& name) const {
+    const CPMPackage* found = nullptr;
+    size_t order = 0;
+    if (auto it = cpm_declarations_.find(name); it != cpm_declarations_.end()) {
+        order = it->second.first;
+        found = &it->second.second;
+    }
+    // Only a lock used after the declaration overrides it
+    for (auto it = cpm_locks_.rbegin(); it != cpm_locks_.rend(); ++it) {
+        if (found && it->first < order) {
+            break;
+        }
+        if (const auto* declared = it->second->find(name)) {
+            return declared;
+        }
+    }
+    if (found || !parent_) {
+        return found;
+    }
+    return parent_->find_cpm_declaration(name);
+}
+
+ProbeExecutor* EvaluationContext::probe_executor() const {
+    if (probe_executor_ || !parent_) {
+        return probe_executor_;
+    }
+    return parent_->probe_executor();
+}
+
+DirectorySnapshot* EvaluationContext::directory_snapshot() const {
+    if (directory_snapshot_ || !parent_) {
+        return directory_snapshot_;
+    }
+    return parent_->directory_snapshot();
+}
+
+EvaluationSnapshotStore* EvaluationContext::snapshot_store() const {
+    if (snapshot_store_ || !parent_) {
+        return snapshot_store_;
+    }
+    return parent_->snapshot_store();
+}
+
+void EvaluationContext::set_platforms(const PlatformSet* platforms) {
+    platforms_ = platforms;
+    active_platforms_ = this->platforms().all();
+    initialize_platform_variables();
+}
+
+const PlatformSet& EvaluationContext::platforms() const {
+    if (platforms_) {
+        return *platforms_;
+    }
+    return parent_ ? parent_->platforms() : PlatformSet::host();
+}
+
+void EvaluationContext::initialize_platform_variables() {
+    // Variables all platforms agree on are plain ones
+    const auto& set = platforms();
+    for (size_t i = 0; i < set[0].variables.size(); ++i) {
+        const auto& [name, first] = set[0].variables[i];
+        std::vector<std::optional<EvaluatedValue>> values;
+        bool same = true;
+        for (size_t p = 0; p < set.size(); ++p) {
+            const auto& value = set[p].variables[i].second;
+            same = same && value == first;
+            values.emplace_back(EvaluatedValue{value, Confidence::Certain});
+        }
+        if (same) {
+            set_variable(name, first, Confidence::Certain);
+        } else {
+            variable_changed(name);
+            variables_.erase(name);
+            platform_variables_[name] = std::move(values);
+        }
+    }
+}
+
+bool EvaluationContext::depends_on_platform(const std::string& name) const {
+    return platform_groups({name}).size() > 1;
+}
+
+std::vector<PlatformMask>
+EvaluationContext::platform_groups(const std::vector<std::string_view>& names) const {
+    if (std::popcount(active_platforms_) < 2) {
+        return {active_platforms_};
+    }
+    // The names whose nearest binding has a value per platform
+    std::vector<std::string> read;
+    for (auto name : names) {
+        std::string key(name);
+        for (const auto* scope = this; scope; scope = scope->parent_) {
+            if (scope->variables_.contains(key)) {
+                break;
+            }
+            if (scope->platform_variables_.contains(key)) {
+                if (std::find(read.begin(), read.end(), key) == read.end()) {
+                    read.push_back(std::move(key));
+                }
+                break;
+            }
+        }
+    }
+    if (read.empty()) {
+        return {active_platforms_};
+    }
+
+    // Each platform joins the first group whose first platform sees the same values
+    std::vector<PlatformMask> groups;
+    std::vector<size_t> firsts;
+    for (size_t p = 0; p < platforms().size(); ++p) {
+        if (!(active_platforms_ & (PlatformMask{1} << p))) {
+            continue;
+        }
+        auto group = std::find_if(firsts.begin(), firsts.end(), [&](size_t first) {
+            return std::all_of(read.begin(), read.end(), [&](const auto& name) {
+                return same_value(find_variable(name, p), find_variable(name, first));
+            });
+        });
+        if (group == firsts.end()) {
+            firsts.push_back(p);
+            groups.push_back(0);
+            group = firsts.end() - 1;
+        }
+        groups[static_cast<size_t>(group - firsts.begin())] |= PlatformMask{1} << p;
+    }
+    return groups;
+}
+
+void EvaluationContext::record_variable(const std::string& name) {
+    variable_changed(name);
+    if (journals_.empty()) {
+        return;
+    }
+    auto& journal = journals_.back();
+    if (journal.variables.contains(name)) {
+        return;
+    }
+    auto it = variables_.find(name);
+    journal.variables.emplace(name, it == variables_.end() ? std::nullopt
+                                                           : std::optional(it->second));
+    auto platform_it = platform_variables_.find(name);
+    journal.platform_variables.emplace(name, platform_it == platform_variables_.end()
+                                                 ? std::nullopt
+                                                 : std::optional(platform_it->second));
+}
+
+void EvaluationContext::record_target(size_t index) {
+    target_changed(index);
+    if (journals_.empty()) {
+        return;
+    }
+    // Targets added since need no saving; undoing removes them
+    auto& journal = journals_.back();
+    if (index < journal.target_count && !journal.targets.contains(index)) {
+        journal.targets.emplace(index, targets_[index]);
+    }
+}
+
+std::optional<EvaluatedValue> EvaluationContext::platform_value(const std::string& name,
+                                                                size_t platform) const {
+    if (auto it = variables_.find(name); it != variables_.end()) {
+        return it->second;
+    }
+    if (auto it = platform_variables_.find(name); it != platform_variables_.end()) {
+        return it->second[platform];
+    }
+    return std::nullopt;
+}
+
+void EvaluationContext::bind_platform_values(const std::string& name,
+                                             std::vector<std::optional<EvaluatedValue>> values,
+                                             PlatformMask platforms) {
+    std::optional<size_t> first;
+    bool same = true;
+    for (size_t p = 0; p < values.size(); ++p) {
+        if (platforms & (PlatformMask{1} << p)) {
+            same = same && (!first || same_value(values[p], values[*first]));
+            first = first.value_or(p);
+        }
+    }
+    record_variable(name);
+    if (!same) {
+        variables_.erase(name);
+        platform_variables_[name] = std::move(values);
+    } else if (first && values[*first]) {
+        variables_[name] = std::move(*values[*first]);
+        platform_variables_.erase(name);
+    } else {
+        variables_.erase(name);
+        platform_variables_.erase(name);
+    }
+}
+
+void EvaluationContext::begin_platform_changes() {
+    PlatformJournal journal;
+    journal.target_count = targets_.size();
+    journal.cpm_package_count = cpm_packages_.size();
+    journals_.push_back(std::move(journal));
+}
+
+EvaluationContext::PlatformChanges EvaluationContext::undo_platform_changes() {
+    auto journal = std::move(journals_.back());
+    journals_.pop_back();
+    PlatformChanges changes;
+
+    const auto& set = platforms();
+    for (auto& [name, before] : journal.variables) {
+        variable_changed(name);
+        auto& values = changes.variables[name];
+        values.resize(set.size());
+        for (size_t p = 0; p < set.size(); ++p) {
+            if (active_platforms_ & (PlatformMask{1} << p)) {
+                values[p] = platform_value(name, p);
+            }
+        }
+        if (before) {
+            variables_[name] = std::move(*before);
+        } else {
+            variables_.erase(name);
+        }
+        if (auto& platform_before = journal.platform_variables[name]) {
+            platform_variables_[name] = std::move(*platform_before);
+        } else {
+            platform_variables_.erase(name);
+        }
+    }
+
+    for (auto& [index, before] : journal.targets) {
+        target_changed(index);
+        changes.targets.emplace(index, std::exchange(targets_[index], std::move(before)));
+    }
+    // Targets added later in their place are hashed again
+    for (size_t index = journal.target_count; index < targets_.size(); ++index) {
+        target_changed(index);
+    }
+    auto added_targets = targets_.begin() + static_cast<std::ptrdiff_t>(journal.target_count);
+    changes.added_targets.assign(std::make_move_iterator(added_targets),
+                                 std::make_move_iterator(targets_.end()));
+    targets_.resize(journal.target_count);
+
+    if (journal.external_packages) {
+        changes.external_packages =
+            std::exchange(external_packages_, std::move(*journal.external_packages));
+    }
+    auto added_cpm_packages =
+        cpm_packages_.begin() + static_cast<std::ptrdiff_t>(journal.cpm_package_count);
+    changes.added_cpm_packages.assign(std::make_move_iterator(added_cpm_packages),
+                                      std::make_move_iterator(cpm_packages_.end()));
+    cpm_packages_.resize(journal.cpm_package_count);
+    return changes;
+}
+
+void EvaluationContext::merge_platform_changes(
+    std::vector<std::pair<PlatformMask, PlatformChanges>> changes) {
+    const auto& set = platforms();
+    PlatformMask active = 0;
+    std::vector<PlatformChanges*> changes_of(set.size(), nullptr);
+    for (auto& [group, change] : changes) {
+        active |= group;
+        for (size_t p = 0; p < set.size(); ++p) {
+            if (group & (PlatformMask{1} << p)) {
+                changes_of[p] = &change;
+            }
+        }
+    }
+
+    // A platform whose group left a variable alone still sees the old value
+    std::unordered_set<std::string> names;
+    for (const auto& [group, change] : changes) {
+        for (const auto& [name, _] : change.variables) {
+            names.insert(name);
+        }
+    }
+    for (const auto& name : names) {
+        std::vector<std::optional<EvaluatedValue>> values(set.size());
+        for (size_t p = 0; p < set.size(); ++p) {
+            if (!(active & (PlatformMask{1} << p))) {
+                continue;
+            }
+            const auto& written = changes_of[p]->variables;
+            if (auto it = written.find(name); it != written.end()) {
+                values[p] = it->second[p];
+            } else {
+                values[p] = platform_value(name, p);
+            }
+        }
+        bind_platform_values(name, std::move(values), active);
+    }
+
+    // Updated targets; a platform whose group left one alone keeps it as is
+    std::vector<size_t> updated;
+    for (const auto& [group, change] : changes) {
+        for (const auto& [index, _] : change.targets) {
+            if (std::find(updated.begin(), updated.end(), index) == updated.end()) {
+                updated.push_back(index);
+            }
+        }
+    }
+    std::vector<const Target*> versions(set.size());
+    for (auto index : updated) {
+        for (size_t p = 0; p < set.size(); ++p) {
+            versions[p] = &targets_[index];
+            if (changes_of[p]) {
+                const auto& written = changes_of[p]->targets;
+                if (auto it = written.find(index); it != written.end()) {
+                    versions[p] = &it->second;
+                }
+            }
+        }
+        auto merged = merge_platform_targets(versions, active, set);
+        record_target(index);
+        targets_[index] = std::move(merged);
+    }
+
+    // Added targets in the order the first group added them, then those of others
+    std::vector<std::string> order;
+    std::unordered_map<std::string, std::vector<const Target*>> added;
+    for (const auto& [group, change] : changes) {
+        for (const auto& target : change.added_targets) {
+            auto [it, inserted] = added.try_emplace(target.name, set.size(), nullptr);
+            if (inserted) {
+                order.push_back(target.name);
+            }
+            for (size_t p = 0; p < set.size(); ++p) {
+                if (group & (PlatformMask{1} << p)) {
+                    it->second[p] = &target;
+                }
+            }
+        }
+    }
+    for (const auto& name : order) {
+        targets_.push_back(merge_platform_targets(added[name], active, set));
+    }
+
+    // Packages any platform found or declares
+    for (const auto& [group, change] : changes) {
+        if (change.external_packages) {
+            for (const auto& package : *change.external_packages) {
+                add_external_package(package);
+            }
+        }
+        for (const auto& package : change.added_cpm_packages) {
+            if (std::none_of(cpm_packages_.begin(), cpm_packages_.end(), [&](const auto& known) {
+                    return known.name == package.name && known.declared_in == package.declared_in;
+                })) {
+                cpm_packages_.push_back(package);
+            }
+        }
+    }
+}
+
 std::unique_ptr<EvaluationContext> EvaluationContext::create_child_scope() {
-    return std::make_unique<EvaluationContext>(this);
+    auto child = std::make_unique<EvaluationContext>(this);
+    child->active_platforms_ = active_platforms_;
+    return child;
+}
+
+std::unique_ptr<EvaluationContext> EvaluationContext::create_directory_scope() {
+    auto child = create_child_scope();
+    child->directory_scope_ = true;
+    return child;
+}
+
+std::vector<std::string> EvaluationContext::created_targets() const {
+    std::vector<std::string> names;
+    for (const auto& target : targets_) {
+        if (!copied_targets_.contains(target.name)) {
+            names.push_back(target.name);
+        }
+    }
+    return names;
+}
+
+bool EvaluationContext::missed_any_target(const std::vector<std::string>& names) const {
+    return std::any_of(names.begin(), names.end(),
+                       [&](const std::string& name) { return missed_targets_.contains(name); });
+}
+
+void EvaluationContext::merge_directory(EvaluationContext& directory) {
+    // Variables set with PARENT_SCOPE, for the platforms that set them
+    const auto& set = platforms();
+    for (auto& [name, written, value] : directory.parent_scope_writes_) {
+        std::vector<std::optional<EvaluatedValue>> values(set.size());
+        for (size_t p = 0; p < set.size(); ++p) {
+            values[p] = (written & (PlatformMask{1} << p)) ? value : platform_value(name, p);
+        }
+        bind_platform_values(name, std::move(values), active_platforms_);
+    }
+
+    for (auto& [name, value] : directory.cache_variables_) {
+        set_cache_variable(name, std::move(value.value), value.confidence);
+    }
+    platform_checks_.merge(directory.platform_checks_);
+    tables_changed();
+
+    // Targets in the order the directory created them; a copy replaces the
+    // target it was copied from once it reaches the scope that has it
+    for (auto& target : directory.targets_) {
+        if (directory.copied_targets_.contains(target.name)) {
+            auto it = std::find_if(targets_.begin(), targets_.end(),
+                                   [&](const Target& known) { return known.name == target.name; });
+            if (it != targets_.end()) {
+                record_target(static_cast<size_t>(it - targets_.begin()));
+                *it = std::move(target);
+                continue;
+            }
+            copied_targets_.insert(target.name);
+            writes_outside_ = true;
+        }
+        targets_.push_back(std::move(target));
+    }
+
+    // What directories below it missed, this one missed too
+    for (const auto& name : directory.missed_targets_) {
+        note_missed_target(name);
+    }
+
+    for (const auto& package : directory.external_packages_) {
+        add_external_package(package);
+    }
+    for (auto& package : directory.cpm_packages_) {
+        cpm_packages_.push_back(std::move(package));
+    }
+    subdirectory_files_.insert(subdirectory_files_.end(),
+                               std::make_move_iterator(directory.subdirectory_files_.begin()),
+                               std::make_move_iterator(directory.subdirectory_files_.end()));
+    input_files_.insert(input_files_.end(),
+                        std::make_move_iterator(directory.input_files_.begin()),
+                        std::make_move_iterator(directory.input_files_.end()));
+    glob_inputs_.insert(glob_inputs_.end(), std::make_move_iterator(directory.glob_inputs_.begin()),
+                        std::make_move_iterator(directory.glob_inputs_.end()));
+    machine_dependent_ = machine_dependent_ || directory.machine_dependent_;
 }
 
 void EvaluationContext::initialize_builtin_variables() {
@@ -76,27 +700,8 @@ void EvaluationContext::initialize_builtin_variables() {
     set_variable("CMAKE_CURRENT_SOURCE_DIR", "/source", Confidence::Uncertain);
     set_variable("CMAKE_CURRENT_BINARY_DIR", "/build", Confidence::Uncertain);
 
-// Platform variables (will be resolved to Buck2 select())
-#ifdef _WIN32
-    set_variable("WIN32", "1", Confidence::Certain);
-    set_variable("WINDOWS", "1", Confidence::Certain);
-    set_variable("UNIX", "", Confidence::Certain);
-    set_variable("APPLE", "", Confidence::Certain);
-    set_variable("LINUX", "", Confidence::Certain);
-#elif defined(__APPLE__)
-    set_variable("APPLE", "1", Confidence::Certain);
-    set_variable("UNIX", "1", Confidence::Certain);
-    set_variable("DARWIN", "1", Confidence::Certain);
-    set_variable("WIN32", "", Confidence::Certain);
-    set_variable("WINDOWS", "", Confidence::Certain);
-    set_variable("LINUX", "", Confidence::Certain);
-#else
-    set_variable("UNIX", "1", Confidence::Certain);
-    set_variable("LINUX", "1", Confidence::Certain);
-    set_variable("WIN32", "", Confidence::Certain);
-    set_variable("WINDOWS", "", Confidence::Certain);
-    set_variable("APPLE", "", Confidence::Certain);
-#endif
+    // WIN32, APPLE, CMAKE_SYSTEM_NAME, ... of every platform evaluated
+    initialize_platform_variables();
 
     // C++ compiler info (generic)
     set_variable("CMAKE_CXX_COMPILER_ID", "Generic", Confidence::Uncertain);
@@ -193,8 +798,9 @@ bool is_truthy(const Value& value) {
             using T = std::decay_t<decltype(v)>;
             if constexpr (std::is_same_v<T, std::string>) {
                 // CMake considers these false
-                return !v.empty() && v != "0" && v != "OFF" && v != "NO" && v != "FALSE" &&
-                       v != "N" && v != "IGNORE" && v != "NOTFOUND" && !v.ends_with("-NOTFOUND");
+                auto c = boolean_constant(v);
+                return !v.empty() && c != "0" && c != "OFF" && c != "NO" && c != "FALSE" &&
+                       c != "N" && c != "IGNORE" && v != "NOTFOUND" && !v.ends_with("-NOTFOUND");
             } else if constexpr (std::is_same_v<T, bool>) {
                 return v;
             } else if constexpr (std::is_same_v<T, double>) {
@@ -211,11 +817,12 @@ std::optional<bool> to_bool(const Value& value) {
         [](const auto& v) -> std::optional<bool> {
             using T = std::decay_t<decltype(v)>;
             if constexpr (std::is_same_v<T, std::string>) {
-                if (v == "1" || v == "ON" || v == "YES" || v == "TRUE" || v == "Y") {
+                auto c = boolean_constant(v);
+                if (c == "1" || c == "ON" || c == "YES" || c == "TRUE" || c == "Y") {
                     return true;
                 }
-                if (v == "0" || v == "OFF" || v == "NO" || v == "FALSE" || v == "N" ||
-                    v == "IGNORE" || v == "NOTFOUND" || v.ends_with("-NOTFOUND") || v.empty()) {
+                if (c == "0" || c == "OFF" || c == "NO" || c == "FALSE" || c == "N" ||
+                    c == "IGNORE" || v == "NOTFOUND" || v.ends_with("-NOTFOUND") || v.empty()) {
                     return false;
                 }
                 return std::nullopt;
@@ -290,6 +897,22 @@ std::vector<std::string> to_list(const Value& value) {
         value);
 }
 
+std::string strip_generator_expressions(std::string_view text) {
+    std::string stripped;
+    size_t depth = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '$' && i + 1 < text.size() && text[i + 1] == '<') {
+            ++depth;
+            ++i;
+        } else if (depth > 0) {
+            depth -= text[i] == '>' ? 1U : 0U;
+        } else {
+            stripped += text[i];
+        }
+    }
+    return stripped;
+}
+
 } // namespace value_helpers
 
 } // namespace finch::analyzer
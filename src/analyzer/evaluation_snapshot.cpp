@@ -0,0 +1,588 @@
+#include <algorithm>
+#include <finch/analyzer/cpm_package_lock.hpp>
+#include <finch/analyzer/directory_snapshot.hpp>
+#include <finch/analyzer/evaluation_snapshot.hpp>
+#include <finch/core/cache_directory.hpp>
+#include <finch/core/fnv_hash.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+namespace finch::analyzer {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using json = nlohmann::json;
+
+constexpr int snapshot_format_version = 5;
+
+json value_to_json(const EvaluatedValue& value) {
+    json object = {{"confidence", static_cast<int>(value.confidence)}};
+    std::visit([&](const auto& held) { object["value"] = held; }, value.value);
+    return object;
+}
+
+EvaluatedValue value_from_json(const json& object) {
+    EvaluatedValue value{std::string(), static_cast<Confidence>(object.at("confidence").get<int>())};
+    const auto& held = object.at("value");
+    if (held.is_boolean()) {
+        value.value = held.get<bool>();
+    } else if (held.is_number()) {
+        value.value = held.get<double>();
+    } else if (held.is_array()) {
+        value.value = held.get<std::vector<std::string>>();
+    } else {
+        value.value = held.get<std::string>();
+    }
+    return value;
+}
+
+// Per-platform slots; null where unset
+json slots_to_json(const std::vector<std::optional<EvaluatedValue>>& slots) {
+    json array = json::array();
+    for (const auto& slot : slots) {
+        array.push_back(slot ? value_to_json(*slot) : json(nullptr));
+    }
+    return array;
+}
+
+std::vector<std::optional<EvaluatedValue>> slots_from_json(const json& array) {
+    std::vector<std::optional<EvaluatedValue>> slots;
+    for (const auto& slot : array) {
+        slots.push_back(slot.is_null() ? std::nullopt
+                                       : std::optional<EvaluatedValue>(value_from_json(slot)));
+    }
+    return slots;
+}
+
+json paths_to_json(const PathList& paths) {
+    json array = json::array();
+    for (auto path : paths) {
+        array.push_back(path.str());
+    }
+    return array;
+}
+
+PathList paths_from_json(const json& array) {
+    PathList paths;
+    paths.reserve(array.size());
+    for (const auto& path : array) {
+        paths.emplace_back(path.get<std::string>());
+    }
+    return paths;
+}
+
+json target_to_json(const Target& target) {
+    json variants = json::object();
+    for (const auto& [platform, variant] : target.platform_variants) {
+        variants[platform] = {{"sources", paths_to_json(variant.sources)},
+                              {"headers", paths_to_json(variant.headers)},
+                              {"include_directories", paths_to_json(variant.include_directories)},
+                              {"compile_definitions", variant.compile_definitions},
+                              {"compile_options", variant.compile_options},
+                              {"link_libraries", variant.link_libraries}};
+    }
+    return json{{"name", target.name},
+                {"type", static_cast<int>(target.type)},
+                {"confidence", static_cast<int>(target.confidence)},
+                {"source_directory", target.source_directory.str()},
+                {"sources", paths_to_json(target.sources)},
+                {"headers", paths_to_json(target.headers)},
+                {"include_directories", paths_to_json(target.include_directories)},
+                {"compile_definitions", target.compile_definitions},
+                {"compile_options", target.compile_options},
+                {"link_libraries", target.link_libraries},
+                {"link_flags", target.link_flags},
+                {"properties", target.properties},
+                {"platform_variants", std::move(variants)},
+                {"platforms", target.platforms}};
+}
+
+Target target_from_json(const json& object) {
+    Target target;
+    target.name = object.at("name").get<std::string>();
+    target.type = static_cast<Target::Type>(object.at("type").get<int>());
+    target.confidence = static_cast<Target::Confidence>(object.at("confidence").get<int>());
+    target.source_directory = PathId(object.at("source_directory").get<std::string>());
+    target.sources = paths_from_json(object.at("sources"));
+    target.headers = paths_from_json(object.at("headers"));
+    target.include_directories = paths_from_json(object.at("include_directories"));
+    target.compile_definitions = object.at("compile_definitions").get<std::vector<std::string>>();
+    target.compile_options = object.at("compile_options").get<std::vector<std::string>>();
+    target.link_libraries = object.at("link_libraries").get<std::vector<std::string>>();
+    target.link_flags = object.at("link_flags").get<std::vector<std::string>>();
+    target.properties =
+        object.at("properties").get<std::unordered_map<std::string, std::string>>();
+    for (const auto& [platform, variant] : object.at("platform_variants").items()) {
+        auto& into = target.platform_variants[platform];
+        into.sources = paths_from_json(variant.at("sources"));
+        into.headers = paths_from_json(variant.at("headers"));
+        into.include_directories = paths_from_json(variant.at("include_directories"));
+        into.compile_definitions = variant.at("compile_definitions").get<std::vector<std::string>>();
+        into.compile_options = variant.at("compile_options").get<std::vector<std::string>>();
+        into.link_libraries = variant.at("link_libraries").get<std::vector<std::string>>();
+    }
+    target.platforms = object.at("platforms").get<std::vector<std::string>>();
+    return target;
+}
+
+json package_to_json(const ExternalPackage& package) {
+    return json{{"name", package.name},
+                {"version", package.version},
+                {"source", static_cast<int>(package.source)},
+                {"prefix", package.prefix.generic_string()},
+                {"location", package.location.generic_string()},
+                {"imported_targets", package.imported_targets},
+                {"include_directories", package.include_directories},
+                {"libraries", package.libraries},
+                {"dependencies", package.dependencies}};
+}
+
+ExternalPackage package_from_json(const json& object) {
+    ExternalPackage package;
+    package.name = object.at("name").get<std::string>();
+    package.version = object.at("version").get<std::string>();
+    package.source = static_cast<ExternalPackage::Source>(object.at("source").get<int>());
+    package.prefix = object.at("prefix").get<std::string>();
+    package.location = object.at("location").get<std::string>();
+    package.imported_targets = object.at("imported_targets").get<std::vector<std::string>>();
+    package.include_directories = object.at("include_directories").get<std::vector<std::string>>();
+    package.libraries = object.at("libraries").get<std::vector<std::string>>();
+    package.dependencies = object.at("dependencies").get<std::vector<std::string>>();
+    return package;
+}
+
+json cpm_package_to_json(const CPMPackage& package) {
+    return json{{"name", package.name},
+                {"source_type", static_cast<int>(package.source_type)},
+                {"source", package.source},
+                {"version", package.version},
+                {"git_tag", package.git_tag},
+                {"declared_in", package.declared_in},
+                {"sha256", package.sha256}};
+}
+
+CPMPackage cpm_package_from_json(const json& object) {
+    CPMPackage package;
+    package.name = object.at("name").get<std::string>();
+    package.source_type = static_cast<CPMPackage::SourceType>(object.at("source_type").get<int>());
+    package.source = object.at("source").get<std::string>();
+    package.version = object.at("version").get<std::string>();
+    package.git_tag = object.at("git_tag").get<std::string>();
+    package.declared_in = object.at("declared_in").get<std::string>();
+    package.sha256 = object.at("sha256").get<std::string>();
+    return package;
+}
+
+} // namespace
+
+std::string EvaluationSnapshotStore::Stats::to_string() const {
+    return fmt::format("Evaluation snapshots: {} looked up, {} restored, {} stale, {} saved",
+                       lookups, restored, stale, saved);
+}
+
+EvaluationSnapshotStore::EvaluationSnapshotStore() : EvaluationSnapshotStore(Options{}) {}
+
+EvaluationSnapshotStore::EvaluationSnapshotStore(Options options) : options_(std::move(options)) {}
+
+fs::path EvaluationSnapshotStore::default_directory() {
+    return cache_directory() / "snapshots";
+}
+
+EvaluationSnapshotStore::Stats EvaluationSnapshotStore::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+json EvaluationSnapshotStore::scope_to_json(const EvaluationContext& scope) {
+    json variables = json::object();
+    for (const auto& [name, value] : scope.variables_) {
+        variables[name] = value_to_json(value);
+    }
+    json platform_variables = json::object();
+    for (const auto& [name, slots] : scope.platform_variables_) {
+        platform_variables[name] = slots_to_json(slots);
+    }
+    json cache_variables = json::object();
+    for (const auto& [name, value] : scope.cache_variables_) {
+        cache_variables[name] = value_to_json(value);
+    }
+    json targets = json::array();
+    for (const auto& target : scope.targets_) {
+        targets.push_back(target_to_json(target));
+    }
+    json object = {{"variables", std::move(variables)},
+                   {"platform_variables", std::move(platform_variables)},
+                   {"cache_variables", std::move(cache_variables)},
+                   {"platform_checks", scope.platform_checks_},
+                   {"targets", std::move(targets)}};
+
+    json external_packages = json::array();
+    for (const auto& package : scope.external_packages_) {
+        external_packages.push_back(package_to_json(package));
+    }
+    json cpm_packages = json::array();
+    for (const auto& package : scope.cpm_packages_) {
+        cpm_packages.push_back(cpm_package_to_json(package));
+    }
+    json parent_scope_writes = json::array();
+    for (const auto& [name, platforms, value] : scope.parent_scope_writes_) {
+        parent_scope_writes.push_back(
+            {name, platforms, value ? value_to_json(*value) : json(nullptr)});
+    }
+    std::vector<std::string> copied_targets(scope.copied_targets_.begin(),
+                                            scope.copied_targets_.end());
+    std::sort(copied_targets.begin(), copied_targets.end());
+    std::vector<std::string> missed_targets(scope.missed_targets_.begin(),
+                                            scope.missed_targets_.end());
+    std::sort(missed_targets.begin(), missed_targets.end());
+    json subdirectory_files = json::array();
+    for (const auto& file : scope.subdirectory_files_) {
+        subdirectory_files.push_back(file.generic_string());
+    }
+    json input_files = json::array();
+    for (const auto& file : scope.input_files_) {
+        input_files.push_back(file.generic_string());
+    }
+    json glob_inputs = json::array();
+    for (const auto& glob : scope.glob_inputs_) {
+        glob_inputs.push_back({{"pattern", glob.pattern},
+                               {"recurse", glob.recurse},
+                               {"list_directories", glob.list_directories},
+                               {"follow_symlinks", glob.follow_symlinks},
+                               {"matched", glob.matched}});
+    }
+    object["external_packages"] = std::move(external_packages);
+    object["cpm_packages"] = std::move(cpm_packages);
+    object["parent_scope_writes"] = std::move(parent_scope_writes);
+    object["copied_targets"] = std::move(copied_targets);
+    object["missed_targets"] = std::move(missed_targets);
+    object["subdirectory_files"] = std::move(subdirectory_files);
+    object["input_files"] = std::move(input_files);
+    object["glob_inputs"] = std::move(glob_inputs);
+    object["writes_outside"] = scope.writes_outside_;
+    return object;
+}
+
+void EvaluationSnapshotStore::scope_from_json(const json& object, EvaluationContext& scope) {
+    for (const auto& [name, value] : object.at("variables").items()) {
+        scope.variables_.emplace(name, value_from_json(value));
+    }
+    for (const auto& [name, slots] : object.at("platform_variables").items()) {
+        scope.platform_variables_.emplace(name, slots_from_json(slots));
+    }
+    for (const auto& [name, value] : object.at("cache_variables").items()) {
+        scope.cache_variables_.emplace(name, value_from_json(value));
+    }
+    scope.platform_checks_ =
+        object.at("platform_checks").get<std::unordered_map<std::string, bool>>();
+    for (const auto& target : object.at("targets")) {
+        scope.targets_.push_back(target_from_json(target));
+    }
+    for (const auto& package : object.at("external_packages")) {
+        scope.external_packages_.push_back(package_from_json(package));
+    }
+    for (const auto& package : object.at("cpm_packages")) {
+        scope.cpm_packages_.push_back(cpm_package_from_json(package));
+    }
+    for (const auto& write : object.at("parent_scope_writes")) {
+        const auto& value = write.at(2);
+        scope.parent_scope_writes_.emplace_back(
+            write.at(0).get<std::string>(), write.at(1).get<PlatformMask>(),
+            value.is_null() ? std::nullopt : std::optional<EvaluatedValue>(value_from_json(value)));
+    }
+    for (const auto& name : object.at("copied_targets")) {
+        scope.copied_targets_.insert(name.get<std::string>());
+    }
+    for (const auto& name : object.at("missed_targets")) {
+        scope.missed_targets_.insert(name.get<std::string>());
+    }
+    for (const auto& file : object.at("subdirectory_files")) {
+        scope.subdirectory_files_.emplace_back(file.get<std::string>());
+    }
+    for (const auto& file : object.at("input_files")) {
+        scope.input_files_.emplace_back(file.get<std::string>());
+    }
+    for (const auto& glob : object.at("glob_inputs")) {
+        scope.glob_inputs_.push_back(GlobInput{glob.at("pattern").get<std::string>(),
+                                               glob.at("recurse").get<bool>(),
+                                               glob.at("list_directories").get<bool>(),
+                                               glob.at("follow_symlinks").get<bool>(),
+                                               glob.at("matched").get<std::vector<std::string>>()});
+    }
+    scope.writes_outside_ = object.at("writes_outside").get<bool>();
+}
+
+uint64_t EvaluationSnapshotStore::state_hash(const EvaluationContext& scope) {
+    uint64_t hash = fnv_offset_basis;
+    hash_field(hash, std::to_string(scope.active_platforms_));
+    for (const auto* visible = &scope; visible; visible = visible->parent_) {
+        hash_field(hash, std::to_string(own_state_hash(*visible)));
+    }
+    return hash;
+}
+
+uint64_t EvaluationSnapshotStore::own_state_hash(const EvaluationContext& scope) {
+    // Scopes above a wave of directories are not changed while it runs, and
+    // were brought up to date before it started, so siblings only read them
+    auto& digest = scope.digest_;
+    if (!digest.valid) {
+        digest = {};
+        digest.valid = true;
+        for (const auto& [name, value] : scope.variables_) {
+            digest.changed_variables.insert(name);
+        }
+        for (const auto& [name, slots] : scope.platform_variables_) {
+            digest.changed_variables.insert(name);
+        }
+        digest.tables_changed = true;
+    }
+
+    // A variable is bound in one of the two tables, or in neither
+    for (const auto& name : digest.changed_variables) {
+        if (auto it = digest.variables.find(name); it != digest.variables.end()) {
+            digest.sum -= it->second;
+            digest.variables.erase(it);
+        }
+        uint64_t hash = fnv_offset_basis;
+        if (auto it = scope.variables_.find(name); it != scope.variables_.end()) {
+            hash_field(hash, name);
+            hash_field(hash, value_to_json(it->second).dump());
+        } else if (auto slots = scope.platform_variables_.find(name);
+                   slots != scope.platform_variables_.end()) {
+            hash_field(hash, name);
+            hash_field(hash, slots_to_json(slots->second).dump());
+        } else {
+            continue;
+        }
+        digest.sum += hash;
+        digest.variables.emplace(name, hash);
+    }
+    if (!digest.changed_variables.empty()) {
+        digest.changed_variables.clear();
+    }
+
+    // Targets by position; those removed drop out, those added are hashed
+    auto target_hash = [&](size_t index) {
+        uint64_t hash = fnv_offset_basis;
+        hash_field(hash, std::to_string(index));
+        hash_field(hash, target_to_json(scope.targets_[index]).dump());
+        return hash;
+    };
+    while (digest.targets.size() > scope.targets_.size()) {
+        digest.sum -= digest.targets.back();
+        digest.targets.pop_back();
+    }
+    for (auto index : digest.changed_targets) {
+        if (index < digest.targets.size()) {
+            digest.sum -= digest.targets[index];
+            digest.targets[index] = target_hash(index);
+            digest.sum += digest.targets[index];
+        }
+    }
+    if (!digest.changed_targets.empty()) {
+        digest.changed_targets.clear();
+    }
+    while (digest.targets.size() < scope.targets_.size()) {
+        digest.targets.push_back(target_hash(digest.targets.size()));
+        digest.sum += digest.targets.back();
+    }
+
+    // The cache, checks, and what CPMAddPackage(NAME) looks up in the
+    // scopes it runs below
+    if (digest.tables_changed) {
+        json cache_variables = json::object();
+        for (const auto& [name, value] : scope.cache_variables_) {
+            cache_variables[name] = value_to_json(value);
+        }
+        json declarations = json::object();
+        for (const auto& [name, declaration] : scope.cpm_declarations_) {
+            declarations[name] = {declaration.first, cpm_package_to_json(declaration.second)};
+        }
+        json locks = json::array();
+        for (const auto& [order, lock] : scope.cpm_locks_) {
+            locks.push_back({order, lock->content_hash()});
+        }
+        json tables = {{"cache_variables", std::move(cache_variables)},
+                       {"platform_checks", scope.platform_checks_},
+                       {"cpm_declarations", std::move(declarations)},
+                       {"cpm_locks", std::move(locks)}};
+        digest.tables = fnv_offset_basis;
+        hash_field(digest.tables, tables.dump());
+        digest.tables_changed = false;
+    }
+    uint64_t hash = fnv_offset_basis;
+    hash_field(hash, std::to_string(digest.sum));
+    hash_field(hash, std::to_string(digest.tables));
+    return hash;
+}
+
+fs::path EvaluationSnapshotStore::file_of(const fs::path& list_file,
+                                          const fs::path& binary_directory) const {
+    uint64_t hash = fnv_offset_basis;
+    hash_field(hash, options_.evaluation_options);
+    hash_field(hash, list_file.lexically_normal().generic_string());
+    hash_field(hash, binary_directory.lexically_normal().generic_string());
+    return options_.directory / fmt::format("{:016x}.json", hash);
+}
+
+std::optional<uint64_t> EvaluationSnapshotStore::file_hash(const fs::path& file) {
+    auto key = file.lexically_normal().generic_string();
+    {
+        std::lock_guard lock(mutex_);
+        if (auto it = file_hashes_.find(key); it != file_hashes_.end()) {
+            return it->second;
+        }
+    }
+    std::optional<uint64_t> hash;
+    if (auto content = MappedFile::open(file); content.has_value()) {
+        hash = fnv_offset_basis;
+        hash_field(*hash, content.value().view());
+    }
+    std::lock_guard lock(mutex_);
+    file_hashes_.emplace(std::move(key), hash);
+    return hash;
+}
+
+std::optional<EvaluationSnapshotStore::Snapshot>
+EvaluationSnapshotStore::load(const fs::path& list_file, const fs::path& binary_directory,
+                              DirectorySnapshot* directories) {
+    {
+        std::lock_guard lock(mutex_);
+        ++stats_.lookups;
+    }
+    auto snapshot_file = file_of(list_file, binary_directory);
+    auto file = MappedFile::open(snapshot_file);
+    if (!file.has_value()) {
+        return std::nullopt;
+    }
+    auto text = file.value().view();
+    auto document = json::parse(text.begin(), text.end(), nullptr, false);
+    if (document.is_discarded() || !document.is_object() ||
+        document.value("format", 0) != snapshot_format_version) {
+        LOG_DEBUG("Ignoring unreadable evaluation snapshot {}", snapshot_file.string());
+        return std::nullopt;
+    }
+
+    auto stale = [&]([[maybe_unused]] const std::string& input) {
+        LOG_DEBUG("Evaluation snapshot of {} is stale: {} changed", list_file.string(), input);
+        std::lock_guard lock(mutex_);
+        ++stats_.stale;
+    };
+    try {
+        // Every file read must be unchanged and every glob match the same
+        // paths; a file that did not exist must still not exist
+        for (const auto& input : document.at("files")) {
+            auto path = input.at(0).get<std::string>();
+            auto hash = file_hash(path);
+            const auto& recorded = input.at(1);
+            if (recorded.is_null() ? hash.has_value()
+                                   : !hash || *hash != recorded.get<uint64_t>()) {
+                stale(path);
+                return std::nullopt;
+            }
+        }
+        std::optional<DirectorySnapshot> own_directories;
+        if (!directories) {
+            directories = &own_directories.emplace();
+        }
+        for (const auto& glob : document.at("globs")) {
+            DirectorySnapshot::Options options;
+            options.recurse = glob.at("recurse").get<bool>();
+            options.list_directories = glob.at("list_directories").get<bool>();
+            options.follow_symlinks = glob.at("follow_symlinks").get<bool>();
+            auto pattern = glob.at("pattern").get<std::string>();
+            if (directories->glob(pattern, options) !=
+                glob.at("matched").get<std::vector<std::string>>()) {
+                stale("file(GLOB " + pattern + ")");
+                return std::nullopt;
+            }
+        }
+
+        auto scope = std::make_shared<EvaluationContext>();
+        scope_from_json(document.at("scope"), *scope);
+        return Snapshot{document.at("state").get<uint64_t>(), std::move(scope)};
+    } catch (const json::exception& e) {
+        LOG_DEBUG("Ignoring evaluation snapshot {}: {}", snapshot_file.string(), e.what());
+        return std::nullopt;
+    }
+}
+
+bool EvaluationSnapshotStore::restore(const Snapshot& snapshot, uint64_t state_hash,
+                                      EvaluationContext& scope) {
+    std::lock_guard lock(mutex_);
+    if (snapshot.state_hash != state_hash) {
+        ++stats_.stale;
+        return false;
+    }
+    ++stats_.restored;
+
+    // The scope's own state is replaced; what it reads through its parents
+    // is the state the snapshot was taken from
+    const auto& saved = *snapshot.scope;
+    scope.variables_ = saved.variables_;
+    scope.platform_variables_ = saved.platform_variables_;
+    scope.cache_variables_ = saved.cache_variables_;
+    scope.platform_checks_ = saved.platform_checks_;
+    scope.targets_ = saved.targets_;
+    scope.external_packages_ = saved.external_packages_;
+    scope.cpm_packages_ = saved.cpm_packages_;
+    scope.parent_scope_writes_ = saved.parent_scope_writes_;
+    scope.copied_targets_ = saved.copied_targets_;
+    scope.missed_targets_ = saved.missed_targets_;
+    scope.subdirectory_files_ = saved.subdirectory_files_;
+    scope.input_files_ = saved.input_files_;
+    scope.glob_inputs_ = saved.glob_inputs_;
+    scope.writes_outside_ = saved.writes_outside_;
+    scope.digest_ = {};
+    return true;
+}
+
+void EvaluationSnapshotStore::save(const fs::path& list_file, const fs::path& binary_directory,
+                                   uint64_t state_hash, const EvaluationContext& scope) {
+    if (scope.machine_dependent_) {
+        return;
+    }
+
+    // The list file, those of the directories below it and what they read
+    std::vector<std::string> inputs = {list_file.lexically_normal().generic_string()};
+    for (const auto* files : {&scope.subdirectory_files_, &scope.input_files_}) {
+        for (const auto& file : *files) {
+            inputs.push_back(file.lexically_normal().generic_string());
+        }
+    }
+    std::sort(inputs.begin(), inputs.end());
+    inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+    json files = json::array();
+    for (const auto& input : inputs) {
+        auto hash = file_hash(input);
+        files.push_back({input, hash ? json(*hash) : json(nullptr)});
+    }
+    json globs = json::array();
+    for (const auto& glob : scope.glob_inputs_) {
+        globs.push_back({{"pattern", glob.pattern},
+                         {"recurse", glob.recurse},
+                         {"list_directories", glob.list_directories},
+                         {"follow_symlinks", glob.follow_symlinks},
+                         {"matched", glob.matched}});
+    }
+    json document = {{"format", snapshot_format_version},
+                     {"list_file", list_file.generic_string()},
+                     {"state", state_hash},
+                     {"files", std::move(files)},
+                     {"globs", std::move(globs)},
+                     {"scope", scope_to_json(scope)}};
+
+    auto snapshot_file = file_of(list_file, binary_directory);
+    if (auto saved = replace_file(snapshot_file, document.dump()); saved.has_error()) {
+        LOG_DEBUG("Not saving evaluation snapshot: {}", saved.error().message());
+        return;
+    }
+    std::lock_guard lock(mutex_);
+    ++stats_.saved;
+}
+
+} // namespace finch::analyzer
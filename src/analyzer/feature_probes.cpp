@@ -0,0 +1,310 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <finch/analyzer/feature_probes.hpp>
+#include <finch/analyzer/platforms.hpp>
+#include <finch/core/cache_directory.hpp>
+#include <finch/core/fnv_hash.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <finch/core/process.hpp>
+#include <fmt/format.h>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+namespace finch::analyzer {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using json = nlohmann::json;
+
+constexpr int cache_format_version = 2;
+
+// cl.exe and clang-cl take MSVC's options rather than GCC's
+bool is_msvc_driver(const std::string& command) {
+    auto stem = fs::path(command).stem().string();
+    std::transform(stem.begin(), stem.end(), stem.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return stem == "cl" || stem == "clang-cl";
+}
+
+std::string include_lines(const std::vector<std::string>& headers) {
+    std::string lines;
+    for (const auto& header : headers) {
+        lines += "#include <" + header + ">\n";
+    }
+    return lines;
+}
+
+} // namespace
+
+FeatureProbe FeatureProbe::include_files(std::string result_variable,
+                                         const std::vector<std::string>& headers,
+                                         Language language) {
+    FeatureProbe probe;
+    probe.result_variable = std::move(result_variable);
+    probe.language = language;
+    probe.source = include_lines(headers) + "\nint main(void) { return 0; }\n";
+    probe.link = false;
+    return probe;
+}
+
+FeatureProbe FeatureProbe::source_compiles(std::string result_variable, std::string source,
+                                           Language language) {
+    FeatureProbe probe;
+    probe.result_variable = std::move(result_variable);
+    probe.language = language;
+    probe.source = std::move(source);
+    return probe;
+}
+
+FeatureProbe FeatureProbe::symbol_exists(std::string result_variable, const std::string& symbol,
+                                         const std::vector<std::string>& headers,
+                                         Language language) {
+    // The source CheckSymbolExists.cmake generates: macros only need to be
+    // defined, anything else must be addressable
+    FeatureProbe probe;
+    probe.result_variable = std::move(result_variable);
+    probe.language = language;
+    probe.source = include_lines(headers) +
+                   fmt::format("\nint main(int argc, char** argv)\n{{\n  (void)argv;\n"
+                               "#ifndef {0}\n  return ((int*)(&{0}))[argc];\n#else\n"
+                               "  (void)argc;\n  return 0;\n#endif\n}}\n",
+                               symbol);
+    return probe;
+}
+
+FeatureProbe FeatureProbe::function_exists(std::string result_variable,
+                                           const std::string& function) {
+    // As CheckFunctionExists.c: declare the function with a dummy prototype
+    // and let the linker decide
+    FeatureProbe probe;
+    probe.result_variable = std::move(result_variable);
+    probe.language = Language::C;
+    probe.source = fmt::format("char {0}(void);\nint main(void)\n{{\n  {0}();\n  return 0;\n}}\n",
+                               function);
+    return probe;
+}
+
+std::string ProbeExecutor::Stats::to_string() const {
+    return fmt::format("Feature probes: {} distinct, {} from cache, {} compiled ({} succeeded)",
+                       probes, cache_hits, compiled, succeeded);
+}
+
+ProbeExecutor::ProbeExecutor() : ProbeExecutor(Options{}) {}
+
+ProbeExecutor::ProbeExecutor(Options options) : options_(std::move(options)) {
+    if (options_.platform.empty()) {
+        options_.platform = PlatformSet::host()[0].name;
+    }
+    answers_ = read_cache();
+}
+
+fs::path ProbeExecutor::default_cache_file() {
+    return cache_directory() / "probe-results.json";
+}
+
+const ProbeExecutor::Compiler& ProbeExecutor::compiler(FeatureProbe::Language language) {
+    auto& slot = compilers_[language == FeatureProbe::Language::Cxx ? 1 : 0];
+    if (!slot) {
+        Compiler found;
+        found.command = language == FeatureProbe::Language::Cxx ? options_.cxx_compiler
+                                                                : options_.c_compiler;
+        found.msvc = is_msvc_driver(found.command);
+        auto version =
+            run_command(quote_argument(found.command) + (found.msvc ? " /?" : " --version"));
+        if (version && version->succeeded) {
+            found.identity = found.command + "\n" + version->output;
+        } else {
+            LOG_DEBUG("Compiler '{}' cannot be run; its probes stay unknown", found.command);
+        }
+        slot = std::move(found);
+    }
+    return *slot;
+}
+
+std::optional<uint64_t> ProbeExecutor::key_of(const FeatureProbe& probe) {
+    const auto& identity = compiler(probe.language).identity;
+    if (identity.empty()) {
+        return std::nullopt;
+    }
+    uint64_t hash = fnv_offset_basis;
+    hash_field(hash, identity);
+    hash_field(hash, options_.platform);
+    hash_field(hash, probe.source);
+    for (const auto& flag : probe.flags) {
+        hash_field(hash, flag);
+    }
+    hash_field(hash, probe.link ? "link" : "compile");
+    return hash;
+}
+
+std::string ProbeExecutor::command_line(const FeatureProbe& probe, const fs::path& source,
+                                        const fs::path& output) {
+    const auto& found = compiler(probe.language);
+    std::string command = quote_argument(found.command);
+    auto add = [&](const std::string& argument) { command += " " + quote_argument(argument); };
+    if (!found.msvc) {
+        if (!probe.link) {
+            add("-fsyntax-only");
+        }
+        add(source.string());
+        for (const auto& flag : probe.flags) {
+            add(flag);
+        }
+        add("-o");
+        add(output.string() + ".out");
+        return command;
+    }
+
+    // The CMAKE_REQUIRED_* flags are spelled as GCC's; -I and -D mean the
+    // same to cl, libraries and their directories become linker inputs
+    add("/nologo");
+    add(probe.link ? "/Fo" + output.string() + ".obj" : std::string("/Zs"));
+    add(source.string());
+    std::vector<std::string> library_paths;
+    for (const auto& flag : probe.flags) {
+        if (flag.starts_with("-l") && flag.size() > 2) {
+            add(flag.substr(2) + ".lib");
+        } else if (flag.starts_with("-L") && flag.size() > 2) {
+            library_paths.push_back("/LIBPATH:" + flag.substr(2));
+        } else {
+            add(flag);
+        }
+    }
+    if (probe.link) {
+        add("/Fe" + output.string() + ".exe");
+        add("/link");
+        for (const auto& path : library_paths) {
+            add(path);
+        }
+    }
+    return command;
+}
+
+std::optional<bool> ProbeExecutor::lookup(const FeatureProbe& probe) {
+    std::lock_guard lock(mutex_);
+    auto key = key_of(probe);
+    if (!key) {
+        return std::nullopt;
+    }
+    bool first_seen = seen_.insert(*key).second;
+    stats_.probes += first_seen;
+    auto it = answers_.find(*key);
+    if (it == answers_.end()) {
+        return std::nullopt;
+    }
+    stats_.cache_hits += first_seen;
+    return it->second;
+}
+
+void ProbeExecutor::enqueue(FeatureProbe probe) {
+    std::lock_guard lock(mutex_);
+    auto key = key_of(probe);
+    if (!key || answers_.contains(*key)) {
+        return;
+    }
+    for (const auto& [pending_key, pending] : pending_) {
+        if (pending_key == *key) {
+            return;
+        }
+    }
+    seen_.insert(*key);
+    pending_.emplace_back(*key, std::move(probe));
+}
+
+ProbeExecutor::Stats ProbeExecutor::run() {
+    if (pending_.empty()) {
+        return stats_;
+    }
+
+    auto dir = fs::temp_directory_path() /
+               fmt::format("finch-probes-{}",
+                           std::chrono::steady_clock::now().time_since_epoch().count());
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    // Every probe gets its own source and output file, so compilers can run side by side
+    std::vector<char> succeeded(pending_.size(), 0);
+    parallel_for(
+        pending_.size(),
+        [&](size_t i) {
+            const auto& probe = pending_[i].second;
+            bool cxx = probe.language == FeatureProbe::Language::Cxx;
+            auto source = dir / fmt::format("probe{}.{}", i, cxx ? "cpp" : "c");
+            {
+                std::ofstream out(source, std::ios::binary);
+                out << probe.source;
+            }
+            auto command = command_line(probe, source, dir / fmt::format("probe{}", i));
+            auto ran = run_command(command);
+            succeeded[i] = ran && ran->succeeded;
+        },
+        options_.max_threads);
+    fs::remove_all(dir, ec);
+
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        answers_[pending_[i].first] = succeeded[i] != 0;
+        stats_.succeeded += succeeded[i] != 0;
+        LOG_DEBUG("Probe {} = {}", pending_[i].second.result_variable, succeeded[i] != 0);
+    }
+    stats_.compiled += pending_.size();
+    pending_.clear();
+
+    save_cache();
+    LOG_DEBUG("{}", stats_.to_string());
+    return stats_;
+}
+
+std::unordered_map<uint64_t, bool> ProbeExecutor::read_cache() const {
+    std::unordered_map<uint64_t, bool> answers;
+    if (!options_.cache_file) {
+        return answers;
+    }
+    auto file = MappedFile::open(*options_.cache_file);
+    if (!file.has_value()) {
+        return answers;
+    }
+    auto text = file.value().view();
+    auto document = json::parse(text.begin(), text.end(), nullptr, false);
+    if (document.is_discarded() || !document.is_object() ||
+        document.value("format", 0) != cache_format_version) {
+        LOG_DEBUG("Ignoring unreadable probe cache {}", options_.cache_file->string());
+        return answers;
+    }
+    auto entries = document.find("answers");
+    if (entries == document.end() || !entries->is_object()) {
+        return answers;
+    }
+    for (const auto& item : entries->items()) {
+        if (item.value().is_boolean()) {
+            answers[std::strtoull(item.key().c_str(), nullptr, 16)] = item.value().get<bool>();
+        }
+    }
+    return answers;
+}
+
+void ProbeExecutor::save_cache() const {
+    if (!options_.cache_file) {
+        return;
+    }
+    // Another migration may have saved since this one loaded; its answers
+    // are kept, ours win where both have one
+    auto merged = read_cache();
+    for (const auto& [key, answer] : answers_) {
+        merged[key] = answer;
+    }
+    json answers = json::object();
+    for (const auto& [key, answer] : merged) {
+        answers[fmt::format("{:016x}", key)] = answer;
+    }
+    json document = {{"format", cache_format_version}, {"answers", std::move(answers)}};
+    if (auto saved = replace_file(*options_.cache_file, document.dump()); saved.has_error()) {
+        LOG_DEBUG("Not caching probe answers: {}", saved.error().message());
+    }
+}
+
+} // namespace finch::analyzer
@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <finch/analyzer/compile_database.hpp>
+#include <finch/analyzer/file_api.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <fmt/format.h>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace finch::analyzer {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using json = nlohmann::json;
+
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view value) const noexcept {
+        return std::hash<std::string_view>{}(value);
+    }
+};
+
+// Resolves reply paths (relative to the top source directory, or absolute) to
+// normalized absolute paths. The same include directories and source
+// prefixes repeat across thousands of targets, so each distinct spelling is
+// normalized once and the result shared by all workers.
+class PathInterner {
+  public:
+    explicit PathInterner(std::string source_root) : source_root_(std::move(source_root)) {}
+
+    const std::string& resolve(std::string_view raw) {
+        {
+            std::shared_lock lock(mutex_);
+            auto it = paths_.find(raw);
+            if (it != paths_.end()) {
+                return it->second;
+            }
+        }
+
+        fs::path path(raw);
+        if (path.is_relative()) {
+            path = fs::path(source_root_) / path;
+        }
+        auto resolved = path.lexically_normal().generic_string();
+        if (resolved.size() > 1 && resolved.back() == '/') {
+            resolved.pop_back();
+        }
+
+        std::unique_lock lock(mutex_);
+        return paths_.try_emplace(std::string(raw), std::move(resolved)).first->second;
+    }
+
+    [[nodiscard]] size_t size() const {
+        std::shared_lock lock(mutex_);
+        return paths_.size();
+    }
+
+  private:
+    std::string source_root_;
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, std::string, StringHash, std::equal_to<>> paths_;
+};
+
+Result<json, AnalysisError> load_json(const fs::path& path) {
+    auto file = MappedFile::open(path);
+    if (!file.has_value()) {
+        return Result<json, AnalysisError>(
+            std::in_place_index<1>,
+            AnalysisError(AnalysisError::Category::InvalidConfiguration,
+                          fmt::format("File API: cannot read {}", path.string())));
+    }
+    auto text = file.value().view();
+    auto document = json::parse(text.begin(), text.end(), nullptr, false);
+    if (document.is_discarded() || !document.is_object()) {
+        return Result<json, AnalysisError>(
+            std::in_place_index<1>,
+            AnalysisError(AnalysisError::Category::InvalidConfiguration,
+                          fmt::format("File API: malformed JSON in {}", path.string())));
+    }
+    return Result<json, AnalysisError>(std::move(document));
+}
+
+std::string string_at(const json& object, const char* key) {
+    auto it = object.find(key);
+    return it != object.end() && it->is_string() ? it->get<std::string>() : std::string();
+}
+
+const json& array_at(const json& object, const char* key) {
+    static const json empty = json::array();
+    auto it = object.find(key);
+    return it != object.end() && it->is_array() ? *it : empty;
+}
+
+// The codemodel-v2 reply file named by an index file
+std::string codemodel_file(const json& index) {
+    auto reply = index.find("reply");
+    if (reply != index.end() && reply->is_object()) {
+        auto codemodel = reply->find("codemodel-v2");
+        if (codemodel != reply->end() && codemodel->is_object()) {
+            return string_at(*codemodel, "jsonFile");
+        }
+    }
+    // Replies to shared stateless queries are only listed under "objects"
+    for (const auto& object : array_at(index, "objects")) {
+        auto version = object.find("version");
+        if (string_at(object, "kind") == "codemodel" && version != object.end() &&
+            version->value("major", 0) == 2) {
+            return string_at(object, "jsonFile");
+        }
+    }
+    return {};
+}
+
+Target::Type target_type(const std::string& type) {
+    if (type == "EXECUTABLE") {
+        return Target::Type::ExecutableTarget;
+    }
+    if (type == "STATIC_LIBRARY" || type == "OBJECT_LIBRARY") {
+        return Target::Type::StaticLibrary;
+    }
+    if (type == "SHARED_LIBRARY" || type == "MODULE_LIBRARY") {
+        return Target::Type::SharedLibrary;
+    }
+    if (type == "INTERFACE_LIBRARY") {
+        return Target::Type::InterfaceLibrary;
+    }
+    if (type == "UTILITY") {
+        return Target::Type::CustomTarget;
+    }
+    return Target::Type::Unknown;
+}
+
+bool is_header(std::string_view path) {
+    auto dot = path.rfind('.');
+    if (dot == std::string_view::npos) {
+        return false;
+    }
+    auto ext = path.substr(dot);
+    return ext == ".h" || ext == ".hh" || ext == ".hpp" || ext == ".hxx" || ext == ".h++" ||
+           ext == ".inl" || ext == ".ipp" || ext == ".tpp";
+}
+
+std::string relative_to(const std::string& path, const std::string& base) {
+    if (path.size() > base.size() && path.starts_with(base) && path[base.size()] == '/') {
+        return path.substr(base.size() + 1);
+    }
+    if (path == base) {
+        return ".";
+    }
+    return path;
+}
+
+template <typename Item>
+void append_unique(std::vector<Item>& items, std::unordered_set<Item>& seen, Item item) {
+    if (seen.insert(item).second) {
+        items.push_back(std::move(item));
+    }
+}
+
+// Whether path is root or lies below it; nothing lies below an empty root
+bool is_within(std::string_view path, std::string_view root) {
+    return !root.empty() && path.starts_with(root) &&
+           (path.size() == root.size() || root.ends_with('/') || path[root.size()] == '/');
+}
+
+struct ReplyContext {
+    std::string build_root;
+    std::unordered_map<std::string, std::string> names_by_id;
+    PathInterner* paths;
+};
+
+// Map one target reply file. Returns nullopt for targets CMake adds on its own
+// (ALL_BUILD, ZERO_CHECK, ...), which have no Buck2 counterpart.
+std::optional<Target> map_target(const json& reply, const ReplyContext& context) {
+    if (reply.value("isGeneratorProvided", false)) {
+        return std::nullopt;
+    }
+
+    Target target;
+    target.name = string_at(reply, "name");
+    target.type = target_type(string_at(reply, "type"));
+    target.confidence = Target::Confidence::Certain;
+
+    auto paths = reply.find("paths");
+    std::string source_directory =
+        context.paths->resolve(paths != reply.end() ? string_at(*paths, "source") : ".");
+    target.source_directory = source_directory;
+
+    for (const auto& source : array_at(reply, "sources")) {
+        auto path =
+            relative_to(context.paths->resolve(string_at(source, "path")), source_directory);
+        if (source.contains("compileGroupIndex")) {
+            target.sources.push_back(std::move(path));
+        } else if (is_header(path)) {
+            target.headers.push_back(std::move(path));
+        }
+    }
+
+    // Buck2 has one flag set per target; merge the per-language groups
+    std::unordered_set<PathId> seen_includes;
+    std::unordered_set<std::string> seen_definitions, seen_fragments;
+    for (const auto& group : array_at(reply, "compileGroups")) {
+        for (const auto& include : array_at(group, "includes")) {
+            append_unique(target.include_directories, seen_includes,
+                          PathId(relative_to(context.paths->resolve(string_at(include, "path")),
+                                             source_directory)));
+        }
+        for (const auto& define : array_at(group, "defines")) {
+            append_unique(target.compile_definitions, seen_definitions,
+                          string_at(define, "define"));
+        }
+        // Fragments are deduplicated whole so repeated -Xclang style pairs survive
+        for (const auto& fragment : array_at(group, "compileCommandFragments")) {
+            auto text = string_at(fragment, "fragment");
+            if (seen_fragments.insert(text).second) {
+                for (auto& option : CompileDatabase::tokenize_command(text)) {
+                    target.compile_options.push_back(std::move(option));
+                }
+            }
+        }
+    }
+
+    std::unordered_set<std::string> seen_libraries;
+    for (const auto& dependency : array_at(reply, "dependencies")) {
+        auto it = context.names_by_id.find(string_at(dependency, "id"));
+        if (it != context.names_by_id.end()) {
+            append_unique(target.link_libraries, seen_libraries, it->second);
+        }
+    }
+
+    // External libraries; artifacts of other targets are covered by dependencies
+    auto link = reply.find("link");
+    if (link != reply.end() && link->is_object()) {
+        for (const auto& fragment : array_at(*link, "commandFragments")) {
+            if (string_at(fragment, "role") != "libraries") {
+                continue;
+            }
+            for (auto& item : CompileDatabase::tokenize_command(string_at(fragment, "fragment"))) {
+                if (item.starts_with("-l") ||
+                    (fs::path(item).is_absolute() && !is_within(item, context.build_root))) {
+                    append_unique(target.link_flags, seen_libraries, std::move(item));
+                }
+            }
+        }
+    }
+
+    return target;
+}
+
+} // namespace
+
+FileApiReader::FileApiReader(size_t max_threads) : max_threads_(max_threads) {}
+
+std::optional<fs::path> FileApiReader::find_reply_directory(const fs::path& path) {
+    for (const auto& candidate : {path / ".cmake" / "api" / "v1" / "reply", path / "reply", path}) {
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(candidate, ec)) {
+            auto name = entry.path().filename().string();
+            if (name.starts_with("index-") && name.ends_with(".json")) {
+                return candidate;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+Result<ProjectAnalysis, AnalysisError>
+FileApiReader::read(const fs::path& path, const std::optional<std::string>& configuration) const {
+    using AnalysisResult = Result<ProjectAnalysis, AnalysisError>;
+    auto fail = [](std::string message) {
+        return AnalysisResult(
+            std::in_place_index<1>,
+            AnalysisError(AnalysisError::Category::InvalidConfiguration, std::move(message)));
+    };
+
+    auto reply_directory = find_reply_directory(path);
+    if (!reply_directory) {
+        return fail(fmt::format("File API: no reply index found under {}", path.string()));
+    }
+
+    // Index files are named by timestamp; the lexically greatest is the newest
+    fs::path index_path;
+    std::error_code ec;
+    for (fs::directory_iterator it(*reply_directory, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        auto name = it->path().filename().string();
+        if (name.starts_with("index-") && name.ends_with(".json") &&
+            (index_path.empty() || name > index_path.filename().string())) {
+            index_path = it->path();
+        }
+    }
+    if (ec) {
+        return fail(fmt::format("File API: cannot list {}: {}", reply_directory->string(),
+                                ec.message()));
+    }
+
+    auto index = load_json(index_path);
+    if (!index.has_value()) {
+        return AnalysisResult(std::in_place_index<1>, index.error());
+    }
+    auto codemodel_name = codemodel_file(index.value());
+    if (codemodel_name.empty()) {
+        return fail(fmt::format("File API: {} has no codemodel-v2 reply; add a "
+                                "query/codemodel-v2 file and reconfigure",
+                                index_path.string()));
+    }
+    auto codemodel = load_json(*reply_directory / codemodel_name);
+    if (!codemodel.has_value()) {
+        return AnalysisResult(std::in_place_index<1>, codemodel.error());
+    }
+
+    const auto& configurations = array_at(codemodel.value(), "configurations");
+    const json* selected = nullptr;
+    for (const auto& candidate : configurations) {
+        if (!configuration || string_at(candidate, "name") == *configuration) {
+            selected = &candidate;
+            break;
+        }
+    }
+    if (selected == nullptr) {
+        return fail(configuration
+                        ? fmt::format("File API: no configuration named '{}'", *configuration)
+                        : std::string("File API: codemodel has no configurations"));
+    }
+
+    auto model_paths = codemodel.value().find("paths");
+    std::string source_root, build_root;
+    if (model_paths != codemodel.value().end() && model_paths->is_object()) {
+        source_root = string_at(*model_paths, "source");
+        build_root = string_at(*model_paths, "build");
+    }
+    PathInterner paths(source_root);
+
+    ReplyContext context{build_root, {}, &paths};
+    std::vector<std::string> target_files;
+    for (const auto& entry : array_at(*selected, "targets")) {
+        context.names_by_id.emplace(string_at(entry, "id"), string_at(entry, "name"));
+        target_files.push_back(string_at(entry, "jsonFile"));
+    }
+
+    // Parsing the per-target files dominates; each worker owns its slots
+    std::vector<std::optional<Target>> mapped(target_files.size());
+    std::vector<std::string> errors(target_files.size());
+    parallel_for(
+        target_files.size(),
+        [&](size_t i) {
+            auto reply = load_json(*reply_directory / target_files[i]);
+            if (!reply.has_value()) {
+                errors[i] = reply.error().message();
+                return;
+            }
+            try {
+                mapped[i] = map_target(reply.value(), context);
+            } catch (const json::exception& e) {
+                errors[i] = fmt::format("File API: unexpected data in {}: {}", target_files[i],
+                                        e.what());
+            }
+        },
+        max_threads_);
+
+    ProjectAnalysis analysis;
+    const auto& projects = array_at(*selected, "projects");
+    if (!projects.empty()) {
+        analysis.project_name = string_at(projects.front(), "name");
+    }
+    for (size_t i = 0; i < mapped.size(); ++i) {
+        if (!errors[i].empty()) {
+            return fail(std::move(errors[i]));
+        }
+        if (mapped[i]) {
+            analysis.targets.push_back(std::move(*mapped[i]));
+        }
+    }
+
+    LOG_DEBUG("Read {} targets from File API reply {} ({} distinct paths)",
+              analysis.targets.size(), reply_directory->string(), paths.size());
+    return AnalysisResult(std::move(analysis));
+}
+
+} // namespace finch::analyzer
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <finch/analyzer/file_prefilter.hpp>
+#include <finch/core/byte_scan.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <fmt/format.h>
+
+namespace finch::analyzer {
+
+namespace {
+
+// Commands whose evaluation can add to a ProjectAnalysis
+constexpr std::array<std::string_view, 12> full_commands = {
+    "project",                   "add_library",               "add_executable",
+    "add_subdirectory",          "find_package",              "pkg_check_modules",
+    "pkg_search_module",         "set_target_properties",     "cpmaddpackage",
+    "cpmfindpackage",            "fetchcontent_populate",     "fetchcontent_makeavailable"};
+
+// Commands that only change variables, properties or the set of commands
+constexpr std::array<std::string_view, 21> shallow_commands = {
+    "set",                    "unset",                  "option",
+    "list",                   "string",                 "math",
+    "file",                   "include",                "function",
+    "macro",                  "set_property",           "get_property",
+    "configure_file",         "try_compile",            "get_filename_component",
+    "cmake_minimum_required", "cmake_policy",           "cmake_parse_arguments",
+    "fetchcontent_declare",   "cpmusepackagelock",      "cpmdeclarepackage"};
+
+FileClass command_class(std::string_view name) {
+    std::array<char, 32> lowered;
+    if (name.empty() || name.size() > lowered.size()) {
+        return FileClass::Skip;
+    }
+    std::transform(name.begin(), name.end(), lowered.begin(), [](char c) {
+        return static_cast<char>(c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    });
+    std::string_view command(lowered.data(), name.size());
+
+    if (command.starts_with("target_") ||
+        std::find(full_commands.begin(), full_commands.end(), command) != full_commands.end()) {
+        return FileClass::Full;
+    }
+    if (command.starts_with("check_") ||
+        std::find(shallow_commands.begin(), shallow_commands.end(), command) !=
+            shallow_commands.end()) {
+        return FileClass::Shallow;
+    }
+    return FileClass::Skip;
+}
+
+bool is_identifier_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// First byte in [p, end) the scan has to look at: an open parenthesis, a
+// comment, a quote, an escape or a possible bracket
+const char* find_interesting(const char* p, const char* end) {
+    return find_any_byte<'(', '#', '"', '\\', '['>(p, end);
+}
+
+// Past the closing bracket when p is at "[[", "[=[", ...; nullptr otherwise
+const char* skip_bracket(const char* p, const char* end) {
+    const char* q = p + 1;
+    while (q < end && *q == '=') {
+        ++q;
+    }
+    if (q >= end || *q != '[') {
+        return nullptr;
+    }
+    std::string close = "]" + std::string(static_cast<size_t>(q - p - 1), '=') + "]";
+    auto found = std::string_view(q + 1, static_cast<size_t>(end - q - 1)).find(close);
+    return found == std::string_view::npos ? end : q + 1 + found + close.size();
+}
+
+} // namespace
+
+const char* to_string(FileClass file_class) {
+    switch (file_class) {
+    case FileClass::Skip:
+        return "skip";
+    case FileClass::Shallow:
+        return "shallow";
+    case FileClass::Full:
+        return "full";
+    }
+    return "unknown";
+}
+
+std::string FilePrefilter::Stats::to_string() const {
+    return fmt::format("Prefilter: {} files skipped, {} shallow, {} full ({} bytes scanned)",
+                       skipped, shallow, full, bytes_scanned);
+}
+
+FileClass FilePrefilter::classify(std::string_view content) {
+    const char* begin = content.data();
+    const char* end = begin + content.size();
+    const char* p = begin;
+    FileClass result = FileClass::Skip;
+    bool quoted = false;
+
+    while ((p = find_interesting(p, end)) < end) {
+        switch (*p) {
+        case '\\':
+            p += std::min<std::ptrdiff_t>(2, end - p); // The escaped character is never special
+            continue;
+        case '"':
+            quoted = !quoted;
+            break;
+        case '#':
+            if (quoted) {
+                break;
+            }
+            if (p + 1 < end && p[1] == '[') {
+                if (const char* after = skip_bracket(p + 1, end)) {
+                    p = after;
+                    continue;
+                }
+            }
+            if (const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p))) {
+                p = static_cast<const char*>(newline);
+            } else {
+                p = end;
+            }
+            continue;
+        case '[':
+            if (!quoted) {
+                if (const char* after = skip_bracket(p, end)) {
+                    p = after;
+                    continue;
+                }
+            }
+            break;
+        case '(': {
+            const char* name_end = p;
+            while (name_end > begin && (name_end[-1] == ' ' || name_end[-1] == '\t')) {
+                --name_end;
+            }
+            const char* name_begin = name_end;
+            while (name_begin > begin && is_identifier_char(name_begin[-1])) {
+                --name_begin;
+            }
+            FileClass found = command_class(
+                std::string_view(name_begin, static_cast<size_t>(name_end - name_begin)));
+            if (found == FileClass::Full) {
+                return FileClass::Full;
+            }
+            result = std::max(result, found);
+            break;
+        }
+        }
+        ++p;
+    }
+    return result;
+}
+
+FileClass FilePrefilter::classify_file(const std::filesystem::path& path) {
+    FileClass result = FileClass::Full;
+    if (auto file = MappedFile::open(path); file.has_value()) {
+        stats_.bytes_scanned += file.value().size();
+        result = classify(file.value().view());
+    }
+    switch (result) {
+    case FileClass::Skip:
+        ++stats_.skipped;
+        break;
+    case FileClass::Shallow:
+        ++stats_.shallow;
+        break;
+    case FileClass::Full:
+        ++stats_.full;
+        break;
+    }
+    LOG_TRACE("Prefilter: {} is {}", path.string(), analyzer::to_string(result));
+    return result;
+}
+
+} // namespace finch::analyzer
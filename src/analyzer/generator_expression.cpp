@@ -0,0 +1,485 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <finch/analyzer/evaluation_context.hpp>
+#include <finch/analyzer/generator_expression.hpp>
+#include <finch/core/logging.hpp>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
+#include <type_traits>
+
+namespace finch::analyzer {
+
+namespace {
+
+using Kind = GenexNode::Kind;
+
+GenexNode text_node(std::string_view text) {
+    return GenexNode{Kind::Text, std::string(text), {}};
+}
+
+// Index of the '>' closing the "$<" at open, or npos when it is unterminated
+size_t closing_bracket(std::string_view text, size_t open) {
+    int depth = 0;
+    for (size_t i = open; i < text.size(); ++i) {
+        if (text[i] == '$' && i + 1 < text.size() && text[i + 1] == '<') {
+            ++depth;
+            ++i;
+        } else if (text[i] == '>' && --depth == 0) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+// Index of the first separator outside nested $<...>, or npos
+size_t find_top_level(std::string_view text, char separator) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '$' && i + 1 < text.size() && text[i + 1] == '<') {
+            auto close = closing_bracket(text, i);
+            if (close == std::string_view::npos) {
+                return std::string_view::npos;
+            }
+            i = close;
+        } else if (text[i] == separator) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+GenexNode parse_text(std::string_view text);
+
+// The arguments of $<NAME:a,b,...>
+std::vector<GenexNode> parse_arguments(std::string_view text) {
+    std::vector<GenexNode> arguments;
+    while (true) {
+        auto comma = find_top_level(text, ',');
+        arguments.push_back(parse_text(text.substr(0, comma)));
+        if (comma == std::string_view::npos) {
+            return arguments;
+        }
+        text.remove_prefix(comma + 1);
+    }
+}
+
+struct Expression {
+    std::string_view name;
+    Kind kind;
+    bool several_arguments;
+};
+
+constexpr std::array<Expression, 10> expressions = {{
+    {"PLATFORM_ID", Kind::PlatformId, true},
+    {"CONFIG", Kind::Config, true},
+    {"BOOL", Kind::Bool, false},
+    {"AND", Kind::And, true},
+    {"OR", Kind::Or, true},
+    {"NOT", Kind::Not, false},
+    {"TARGET_PROPERTY", Kind::TargetProperty, true},
+    {"BUILD_INTERFACE", Kind::BuildInterface, false},
+    {"INSTALL_INTERFACE", Kind::InstallInterface, false},
+    {"LINK_ONLY", Kind::LinkOnly, false},
+}};
+
+// What is between "$<" and its '>'
+GenexNode parse_expression(std::string_view content) {
+    auto colon = find_top_level(content, ':');
+    auto head = content.substr(0, colon);
+    auto rest = colon == std::string_view::npos ? std::string_view() : content.substr(colon + 1);
+
+    // $<condition:value>, where the condition is 0, 1 or an expression
+    if (colon != std::string_view::npos &&
+        (head == "0" || head == "1" || has_generator_expression(head))) {
+        return GenexNode{Kind::Conditional, "", {parse_text(head), parse_text(rest)}};
+    }
+    if (colon == std::string_view::npos) {
+        if (head == "COMMA") {
+            return text_node(",");
+        }
+        if (head == "SEMICOLON") {
+            return text_node(";");
+        }
+        if (head == "ANGLE-R") {
+            return text_node(">");
+        }
+    }
+    for (const auto& expression : expressions) {
+        if (expression.name != head) {
+            continue;
+        }
+        GenexNode node{expression.kind, "", {}};
+        if (colon != std::string_view::npos) {
+            if (expression.several_arguments) {
+                node.children = parse_arguments(rest);
+            } else {
+                node.children.push_back(parse_text(rest));
+            }
+        }
+        return node;
+    }
+    return GenexNode{Kind::Unsupported, fmt::format("$<{}>", content), {}};
+}
+
+GenexNode parse_text(std::string_view text) {
+    std::vector<GenexNode> parts;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        auto open = text.find("$<", pos);
+        if (open != pos) {
+            parts.push_back(text_node(text.substr(pos, open - pos)));
+        }
+        if (open == std::string_view::npos) {
+            break;
+        }
+        auto close = closing_bracket(text, open);
+        if (close == std::string_view::npos) {
+            // Unterminated, as CMake would reject
+            parts.push_back(GenexNode{Kind::Unsupported, std::string(text.substr(open)), {}});
+            break;
+        }
+        parts.push_back(parse_expression(text.substr(open + 2, close - open - 2)));
+        pos = close + 1;
+    }
+    if (parts.empty()) {
+        return text_node("");
+    }
+    if (parts.size() == 1) {
+        return std::move(parts.front());
+    }
+    return GenexNode{Kind::Concat, "", std::move(parts)};
+}
+
+bool equals_ignoring_case(std::string_view a, std::string_view b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::toupper(static_cast<unsigned char>(x)) ==
+                      std::toupper(static_cast<unsigned char>(y));
+           });
+}
+
+// $<PLATFORM_ID:...> and $<CONFIG:...>: the value itself without
+// arguments, else whether any argument matches it
+std::optional<std::string> match_any(const GenexNode& node, const std::optional<std::string>& value,
+                                     const GenexContext& context, bool ignore_case) {
+    if (!value) {
+        return std::nullopt;
+    }
+    if (node.children.empty()) {
+        return *value;
+    }
+    bool undecided = false;
+    for (const auto& argument : node.children) {
+        auto candidate = evaluate_generator_expression(argument, context);
+        if (!candidate) {
+            undecided = true;
+        } else if (ignore_case ? equals_ignoring_case(*candidate, *value) : *candidate == *value) {
+            return "1";
+        }
+    }
+    return undecided ? std::nullopt : std::optional<std::string>("0");
+}
+
+// $<AND:...> with decisive "0", $<OR:...> with decisive "1"
+std::optional<std::string> logical(const GenexNode& node, const GenexContext& context,
+                                   std::string_view decisive) {
+    bool undecided = false;
+    for (const auto& argument : node.children) {
+        auto value = evaluate_generator_expression(argument, context);
+        if (!value || (*value != "0" && *value != "1")) {
+            undecided = true;
+        } else if (*value == decisive) {
+            return std::string(decisive);
+        }
+    }
+    if (undecided || node.children.empty()) {
+        return std::nullopt;
+    }
+    return decisive == "0" ? "1" : "0";
+}
+
+// A value's list items; "" has none
+std::vector<std::string> list_items(const std::string& value) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= value.size()) {
+        auto end = value.find(';', start);
+        if (end == std::string::npos) {
+            end = value.size();
+        }
+        if (end > start) {
+            items.push_back(value.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return items;
+}
+
+std::string item_text(const PathId& item) {
+    return item.str();
+}
+
+const std::string& item_text(const std::string& item) {
+    return item;
+}
+
+template <typename List> bool list_has_generator_expression(const List& list) {
+    return std::any_of(list.begin(), list.end(), [](const auto& item) {
+        return has_generator_expression(item_text(item));
+    });
+}
+
+} // namespace
+
+GenexNode parse_generator_expression(std::string_view text) {
+    return parse_text(text);
+}
+
+std::optional<std::string> evaluate_generator_expression(const GenexNode& node,
+                                                         const GenexContext& context) {
+    auto argument = [&](size_t index) -> std::optional<std::string> {
+        if (index >= node.children.size()) {
+            return std::string();
+        }
+        return evaluate_generator_expression(node.children[index], context);
+    };
+
+    switch (node.kind) {
+    case Kind::Text:
+        return node.text;
+    case Kind::Concat: {
+        std::string result;
+        for (const auto& part : node.children) {
+            auto value = evaluate_generator_expression(part, context);
+            if (!value) {
+                return std::nullopt;
+            }
+            result += *value;
+        }
+        return result;
+    }
+    case Kind::Conditional: {
+        auto condition = argument(0);
+        if (condition == "1") {
+            return argument(1);
+        }
+        if (condition == "0") {
+            return std::string();
+        }
+        return std::nullopt;
+    }
+    case Kind::PlatformId:
+        return match_any(node, context.platform_id, context, false);
+    case Kind::Config:
+        return match_any(node, context.config, context, true);
+    case Kind::Bool: {
+        auto value = argument(0);
+        if (!value) {
+            return std::nullopt;
+        }
+        return value_helpers::is_truthy(Value(*value)) ? "1" : "0";
+    }
+    case Kind::And:
+        return logical(node, context, "0");
+    case Kind::Or:
+        return logical(node, context, "1");
+    case Kind::Not: {
+        auto value = argument(0);
+        if (value == "0") {
+            return "1";
+        }
+        if (value == "1") {
+            return "0";
+        }
+        return std::nullopt;
+    }
+    case Kind::TargetProperty: {
+        if (!context.target_property || node.children.empty() || node.children.size() > 2) {
+            return std::nullopt;
+        }
+        auto target = node.children.size() == 2 ? argument(0) : std::string();
+        auto property = argument(node.children.size() - 1);
+        if (!target || !property) {
+            return std::nullopt;
+        }
+        return context.target_property(*target, *property);
+    }
+    case Kind::BuildInterface:
+        // finch migrates the build, not the installed package
+        return argument(0);
+    case Kind::InstallInterface:
+        return std::string();
+    case Kind::LinkOnly:
+        // Buck2 deps carry no usage requirements apart from linking
+        return argument(0);
+    case Kind::Unsupported:
+        return std::nullopt;
+    }
+    return std::nullopt;
+}
+
+GenexCache& GenexCache::shared() {
+    static GenexCache cache;
+    return cache;
+}
+
+std::shared_ptr<const GenexNode> GenexCache::parse(std::string_view text) {
+    std::string key(text);
+    {
+        std::lock_guard lock(mutex_);
+        if (auto it = parsed_.find(key); it != parsed_.end()) {
+            return it->second;
+        }
+    }
+    auto node = std::make_shared<const GenexNode>(parse_generator_expression(text));
+    std::lock_guard lock(mutex_);
+    // Another thread may have parsed it meanwhile; either tree will do
+    return parsed_.try_emplace(std::move(key), std::move(node)).first->second;
+}
+
+size_t GenexCache::size() const {
+    std::lock_guard lock(mutex_);
+    return parsed_.size();
+}
+
+bool has_generator_expressions(const Target& target) {
+    auto lists_have = [](const auto& lists) {
+        return list_has_generator_expression(lists.sources) ||
+               list_has_generator_expression(lists.include_directories) ||
+               list_has_generator_expression(lists.compile_definitions) ||
+               list_has_generator_expression(lists.compile_options) ||
+               list_has_generator_expression(lists.link_libraries);
+    };
+    return lists_have(target) ||
+           std::any_of(target.platform_variants.begin(), target.platform_variants.end(),
+                       [&](const auto& variant) { return lists_have(variant.second); });
+}
+
+Target lower_generator_expressions(const Target& target, const PlatformSet& platforms) {
+    Target lowered = target;
+
+    // Each platform's view, for the platforms defining the target
+    std::vector<size_t> present;
+    std::vector<GenexContext> contexts(platforms.size());
+    auto property = [&](std::string_view name,
+                        std::string_view key) -> std::optional<std::string> {
+        if (!name.empty() && name != target.name) {
+            return std::nullopt;
+        }
+        auto it = target.properties.find(std::string(key));
+        return it == target.properties.end() ? std::nullopt
+                                             : std::optional<std::string>(it->second);
+    };
+    for (size_t p = 0; p < platforms.size(); ++p) {
+        for (const auto& [name, value] : platforms[p].variables) {
+            if (name == "CMAKE_SYSTEM_NAME") {
+                contexts[p].platform_id = value;
+            }
+        }
+        contexts[p].target_property = property;
+        if (target.platforms.empty() || std::find(target.platforms.begin(), target.platforms.end(),
+                                                  platforms[p].name) != target.platforms.end()) {
+            present.push_back(p);
+        }
+    }
+    auto platform_index = [&](const std::string& name) -> std::optional<size_t> {
+        for (size_t p = 0; p < platforms.size(); ++p) {
+            if (platforms[p].name == name) {
+                return p;
+            }
+        }
+        return std::nullopt;
+    };
+
+    auto& cache = GenexCache::shared();
+    std::vector<std::string> dropped;
+    auto lower = [&](auto list, auto variant_list) {
+        using List = std::remove_reference_t<decltype(lowered.*list)>;
+        using Item = typename List::value_type;
+        if (!list_has_generator_expression(lowered.*list) &&
+            std::none_of(lowered.platform_variants.begin(), lowered.platform_variants.end(),
+                         [&](const auto& variant) {
+                             return list_has_generator_expression(variant.second.*variant_list);
+                         })) {
+            return;
+        }
+
+        // Variants first, each item for its own platform
+        for (auto& [name, variant] : lowered.platform_variants) {
+            auto p = platform_index(name);
+            List kept;
+            for (const auto& item : variant.*variant_list) {
+                const auto& text = item_text(item);
+                if (!has_generator_expression(text)) {
+                    kept.push_back(item);
+                } else if (auto value = p ? evaluate_generator_expression(*cache.parse(text),
+                                                                          contexts[*p])
+                                          : std::nullopt) {
+                    for (auto& piece : list_items(*value)) {
+                        kept.push_back(Item(std::move(piece)));
+                    }
+                } else {
+                    dropped.push_back(text);
+                }
+            }
+            variant.*variant_list = std::move(kept);
+        }
+
+        // Common items are folded when every platform agrees on them
+        List common;
+        for (const auto& item : lowered.*list) {
+            const auto& text = item_text(item);
+            if (!has_generator_expression(text)) {
+                common.push_back(item);
+                continue;
+            }
+            const auto& node = *cache.parse(text);
+            std::vector<std::optional<std::string>> values;
+            for (auto p : present) {
+                values.push_back(evaluate_generator_expression(node, contexts[p]));
+            }
+            if (std::all_of(values.begin(), values.end(),
+                            [&](const auto& value) { return !value; })) {
+                dropped.push_back(text);
+                continue;
+            }
+            if (std::all_of(values.begin(), values.end(),
+                            [&](const auto& value) { return value == values.front(); })) {
+                for (auto& piece : list_items(*values.front())) {
+                    common.push_back(Item(std::move(piece)));
+                }
+                continue;
+            }
+            for (size_t i = 0; i < present.size(); ++i) {
+                if (!values[i]) {
+                    continue;
+                }
+                auto pieces = list_items(*values[i]);
+                if (pieces.empty()) {
+                    continue;
+                }
+                auto& added = lowered.platform_variants[platforms[present[i]].name].*variant_list;
+                for (auto& piece : pieces) {
+                    added.push_back(Item(std::move(piece)));
+                }
+            }
+        }
+        lowered.*list = std::move(common);
+    };
+    lower(&Target::sources, &Target::PlatformVariant::sources);
+    lower(&Target::include_directories, &Target::PlatformVariant::include_directories);
+    lower(&Target::compile_definitions, &Target::PlatformVariant::compile_definitions);
+    lower(&Target::compile_options, &Target::PlatformVariant::compile_options);
+    lower(&Target::link_libraries, &Target::PlatformVariant::link_libraries);
+
+    // A variant whose items were all undecidable adds nothing
+    std::erase_if(lowered.platform_variants,
+                  [](const auto& variant) { return variant.second == Target::PlatformVariant{}; });
+    if (!dropped.empty()) {
+        LOG_WARN("{}: dropped {} generator expressions finch cannot decide; the target may be "
+                 "incomplete: {}",
+                 target.name, dropped.size(), fmt::join(dropped, " "));
+    }
+    return lowered;
+}
+
+} // namespace finch::analyzer
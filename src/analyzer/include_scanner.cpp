@@ -0,0 +1,550 @@
+#include <algorithm>
+#include <cstring>
+#include <finch/analyzer/include_scanner.hpp>
+#include <finch/core/byte_scan.hpp>
+#include <finch/core/cache_directory.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <fmt/format.h>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <set>
+#include <shared_mutex>
+#include <unordered_set>
+
+namespace finch::analyzer {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using json = nlohmann::json;
+
+constexpr int cache_format_version = 1;
+
+// First byte in [p, end) that may change the scanner state: a newline, the
+// start of a comment, or a string/character literal
+const char* find_interesting(const char* p, const char* end) {
+    return find_any_byte<'\n', '/', '"', '\''>(p, end);
+}
+
+const char* skip_horizontal_space(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+    return p;
+}
+
+const char* end_of_line(const char* p, const char* end) {
+    const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return newline != nullptr ? static_cast<const char*>(newline) : end;
+}
+
+// Past the end of a quoted literal starting after its opening quote; an
+// unterminated literal ends at the newline
+const char* skip_literal(const char* p, const char* end, char quote) {
+    while (p < end && *p != '\n') {
+        char c = *p++;
+        if (c == '\\' && p < end) {
+            ++p;
+        } else if (c == quote) {
+            break;
+        }
+    }
+    return p;
+}
+
+// Past the end of R"delim( ... )delim", starting after the opening quote
+const char* skip_raw_string(const char* p, const char* end) {
+    // The delimiter is at most 16 characters
+    auto window = std::min<size_t>(static_cast<size_t>(end - p), 17);
+    const char* open = static_cast<const char*>(std::memchr(p, '(', window));
+    if (open == nullptr) {
+        return skip_literal(p, end, '"');
+    }
+    std::string closing = ")" + std::string(p, open) + "\"";
+    std::string_view rest(open + 1, static_cast<size_t>(end - open - 1));
+    auto close = rest.find(closing);
+    return close == std::string_view::npos ? end : rest.data() + close + closing.size();
+}
+
+bool is_identifier_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Parse the directive after '#'; returns where scanning should resume
+const char* parse_directive(const char* p, const char* end,
+                            std::vector<IncludeScanner::Directive>& out) {
+    p = skip_horizontal_space(p, end);
+    const char* name = p;
+    while (p < end && is_identifier_char(*p)) {
+        ++p;
+    }
+    std::string_view keyword(name, static_cast<size_t>(p - name));
+    if (keyword != "include" && keyword != "include_next" && keyword != "import") {
+        return p;
+    }
+    p = skip_horizontal_space(p, end);
+    if (p == end || (*p != '<' && *p != '"')) {
+        return p; // Computed include (#include MACRO); cannot be followed
+    }
+    char close = *p == '<' ? '>' : '"';
+    const char* start = ++p;
+    while (p < end && *p != close && *p != '\n') {
+        ++p;
+    }
+    if (p < end && *p == close) {
+        out.push_back({std::string(start, static_cast<size_t>(p - start)), close == '>'});
+        ++p;
+    }
+    return p;
+}
+
+uint64_t content_hash(std::string_view text) {
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ text.size();
+    const char* p = text.data();
+    size_t remaining = text.size();
+    while (remaining >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 32;
+        p += 8;
+        remaining -= 8;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p, remaining);
+    hash = (hash ^ tail) * 0xC4CEB9FE1A85EC53ULL;
+    return hash ^ (hash >> 29);
+}
+
+} // namespace
+
+std::vector<IncludeScanner::Directive> IncludeScanner::extract_includes(std::string_view text) {
+    std::vector<Directive> directives;
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    bool line_start = true;
+    while (p < end) {
+        if (line_start) {
+            p = skip_horizontal_space(p, end);
+            if (p < end && *p == '#') {
+                p = parse_directive(p + 1, end, directives);
+            }
+            line_start = false;
+            continue;
+        }
+
+        p = find_interesting(p, end);
+        if (p == end) {
+            break;
+        }
+        char c = *p++;
+        if (c == '\n') {
+            line_start = true;
+        } else if (c == '/') {
+            if (p < end && *p == '/') {
+                p = end_of_line(p, end);
+            } else if (p < end && *p == '*') {
+                std::string_view rest(p + 1, static_cast<size_t>(end - p - 1));
+                auto close = rest.find("*/");
+                p = close == std::string_view::npos ? end : rest.data() + close + 2;
+            }
+        } else if (c == '"') {
+            bool raw = p - 2 >= text.data() && p[-2] == 'R' &&
+                       (p - 3 < text.data() || !is_identifier_char(p[-3]) || p[-3] == '8' ||
+                        p[-3] == 'u' || p[-3] == 'U' || p[-3] == 'L');
+            p = raw ? skip_raw_string(p, end) : skip_literal(p, end, '"');
+        } else if (c == '\'') {
+            // A quote after a digit is a digit separator (1'000), not a literal
+            bool separator = p - 2 >= text.data() && p[-2] >= '0' && p[-2] <= '9';
+            if (!separator) {
+                p = skip_literal(p, end, '\'');
+            }
+        }
+    }
+    return directives;
+}
+
+IncludeScanner::IncludeScanner(size_t max_threads) : max_threads_(max_threads) {}
+
+IncludeScanner::Directives IncludeScanner::directives_for(const std::string& path,
+                                                          size_t& bytes_read, bool& cached) {
+    bytes_read = 0;
+    cached = false;
+    std::error_code ec;
+    auto modified = fs::last_write_time(path, ec);
+    auto size = ec ? 0 : fs::file_size(path, ec);
+    if (ec) {
+        return nullptr;
+    }
+    {
+        std::lock_guard lock(cache_mutex_);
+        auto it = by_path_.find(path);
+        if (it != by_path_.end() && it->second.modified == modified && it->second.size == size) {
+            cached = true;
+            return it->second.directives;
+        }
+    }
+
+    auto file = MappedFile::open(path);
+    if (!file.has_value()) {
+        return nullptr;
+    }
+    std::string_view text = file.value().view();
+    bytes_read = text.size();
+
+    // Identical content (copies, or a file touched without changes) is scanned once
+    uint64_t hash = content_hash(text);
+    Directives directives;
+    {
+        std::lock_guard lock(cache_mutex_);
+        auto it = by_hash_.find(hash);
+        if (it != by_hash_.end()) {
+            directives = it->second;
+        }
+    }
+    if (!directives) {
+        directives = std::make_shared<const std::vector<Directive>>(extract_includes(text));
+    }
+
+    std::lock_guard lock(cache_mutex_);
+    by_hash_.emplace(hash, directives);
+    by_path_[path] = CachedFile{modified, size, hash, directives};
+    return directives;
+}
+
+namespace {
+
+std::string join_path(std::string_view directory, std::string_view name) {
+    std::string joined;
+    joined.reserve(directory.size() + name.size() + 1);
+    joined = directory;
+    if (!joined.empty() && joined.back() != '/') {
+        joined += '/';
+    }
+    joined += name;
+    if (joined.find("/.") != std::string::npos || joined.find("//") != std::string::npos) {
+        joined = fs::path(joined).lexically_normal().generic_string();
+    }
+    return joined;
+}
+
+std::string parent_of(const std::string& path) {
+    auto slash = path.rfind('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
+
+bool is_library(const Target& target) {
+    return target.type == Target::Type::StaticLibrary ||
+           target.type == Target::Type::SharedLibrary ||
+           target.type == Target::Type::InterfaceLibrary;
+}
+
+// Memoized stat() shared by all workers; header lookups probe the same
+// candidate paths for every target
+class ExistenceCache {
+  public:
+    bool is_file(const std::string& path) {
+        {
+            std::shared_lock lock(mutex_);
+            auto it = known_.find(path);
+            if (it != known_.end()) {
+                return it->second;
+            }
+        }
+        std::error_code ec;
+        bool exists = fs::is_regular_file(path, ec);
+        std::unique_lock lock(mutex_);
+        known_.emplace(path, exists);
+        return exists;
+    }
+
+  private:
+    std::shared_mutex mutex_;
+    std::unordered_map<std::string, bool> known_;
+};
+
+struct TargetState {
+    PathId directory;
+    std::string source_directory;
+    std::vector<std::string> include_directories; // Absolute
+    std::vector<std::string> frontier;
+    std::unordered_set<std::string> visited;
+    std::vector<std::string> reached_headers;
+    size_t unresolved = 0;
+};
+
+} // namespace
+
+IncludeScanner::Stats IncludeScanner::scan(ProjectAnalysis& analysis) {
+    Stats stats;
+    auto& targets = analysis.targets;
+
+    std::vector<TargetState> states(targets.size());
+    std::vector<std::string> all_include_directories;
+    std::unordered_set<std::string> seen_directories;
+    auto current_directory = PathId(fs::current_path());
+    for (size_t t = 0; t < targets.size(); ++t) {
+        auto& state = states[t];
+        // Joined in the path table, which normalizes each path once
+        state.directory = current_directory / targets[t].source_directory;
+        state.source_directory = state.directory.str();
+        for (auto dir : targets[t].include_directories) {
+            auto absolute = (state.directory / dir).str();
+            state.include_directories.push_back(absolute);
+            if (seen_directories.insert(absolute).second) {
+                all_include_directories.push_back(absolute);
+            }
+        }
+        for (const auto* list : {&targets[t].sources, &targets[t].headers}) {
+            for (auto file : *list) {
+                auto absolute = (state.directory / file).str();
+                if (state.visited.insert(absolute).second) {
+                    state.frontier.push_back(std::move(absolute));
+                }
+            }
+        }
+    }
+
+    std::unordered_map<std::string, Directives> scanned;
+    ExistenceCache existence;
+    for (;;) {
+        // Scan every file some target reached in the previous round
+        std::vector<std::string> pending;
+        std::unordered_set<std::string_view> queued;
+        for (const auto& state : states) {
+            for (const auto& file : state.frontier) {
+                if (!scanned.contains(file) && queued.insert(file).second) {
+                    pending.push_back(file);
+                }
+            }
+        }
+        if (pending.empty() &&
+            std::all_of(states.begin(), states.end(),
+                        [](const TargetState& state) { return state.frontier.empty(); })) {
+            break;
+        }
+
+        std::vector<Directives> results(pending.size());
+        std::vector<size_t> bytes(pending.size());
+        std::vector<char> cached(pending.size());
+        parallel_for(
+            pending.size(),
+            [&](size_t i) {
+                bool hit = false;
+                results[i] = directives_for(pending[i], bytes[i], hit);
+                cached[i] = hit;
+            },
+            max_threads_);
+        for (size_t i = 0; i < pending.size(); ++i) {
+            stats.files_scanned += results[i] && !cached[i] ? 1U : 0U;
+            stats.cache_hits += cached[i] ? 1U : 0U;
+            stats.bytes_scanned += bytes[i];
+            scanned.emplace(std::move(pending[i]), std::move(results[i]));
+        }
+
+        // Resolve against each target's own include path; fall back to every
+        // known include directory so undeclared dependencies still show up
+        parallel_for(
+            states.size(),
+            [&](size_t t) {
+                auto& state = states[t];
+                std::vector<std::string> next;
+                for (const auto& file : state.frontier) {
+                    const auto& directives = scanned.at(file);
+                    if (!directives) {
+                        continue;
+                    }
+                    std::string directory = parent_of(file);
+                    for (const auto& directive : *directives) {
+                        std::string resolved;
+                        if (!directive.angled) {
+                            auto candidate = join_path(directory, directive.path);
+                            if (existence.is_file(candidate)) {
+                                resolved = std::move(candidate);
+                            }
+                        }
+                        for (const auto* dirs :
+                             {&state.include_directories, &all_include_directories}) {
+                            for (size_t d = 0; resolved.empty() && d < dirs->size(); ++d) {
+                                auto candidate = join_path((*dirs)[d], directive.path);
+                                if (existence.is_file(candidate)) {
+                                    resolved = std::move(candidate);
+                                }
+                            }
+                        }
+                        if (resolved.empty()) {
+                            ++state.unresolved;
+                        } else if (state.visited.insert(resolved).second) {
+                            state.reached_headers.push_back(resolved);
+                            next.push_back(std::move(resolved));
+                        }
+                    }
+                }
+                state.frontier = std::move(next);
+            },
+            max_threads_);
+    }
+
+    // A header belongs to the target whose include or source directory holds
+    // it most specifically; walk up from the header to the first such directory.
+    // Libraries claim directories first, so an executable built next to a
+    // library, or adding its include path, does not take the library's headers
+    std::unordered_map<std::string, size_t> directory_owners;
+    for (bool libraries : {true, false}) {
+        for (size_t t = 0; t < targets.size(); ++t) {
+            if (targets[t].type == Target::Type::CustomTarget ||
+                is_library(targets[t]) != libraries) {
+                continue;
+            }
+            directory_owners.emplace(states[t].source_directory, t);
+            for (const auto& dir : states[t].include_directories) {
+                directory_owners.emplace(dir, t);
+            }
+        }
+    }
+    auto owner_of = [&](const std::string& header) -> std::optional<size_t> {
+        for (auto dir = parent_of(header); !dir.empty(); dir = parent_of(dir)) {
+            auto it = directory_owners.find(dir);
+            if (it != directory_owners.end()) {
+                return it->second;
+            }
+        }
+        return std::nullopt;
+    };
+
+    std::unordered_map<std::string, size_t> index_by_name;
+    for (size_t t = 0; t < targets.size(); ++t) {
+        index_by_name.emplace(targets[t].name, t);
+    }
+    auto linked_closure = [&](size_t t) {
+        std::unordered_set<size_t> closure;
+        std::vector<size_t> stack{t};
+        while (!stack.empty()) {
+            size_t current = stack.back();
+            stack.pop_back();
+            for (const auto& library : targets[current].link_libraries) {
+                auto it = index_by_name.find(library);
+                if (it != index_by_name.end() && closure.insert(it->second).second) {
+                    stack.push_back(it->second);
+                }
+            }
+        }
+        return closure;
+    };
+
+    std::vector<std::set<std::string>> owned(targets.size());
+    for (size_t t = 0; t < targets.size(); ++t) {
+        stats.unresolved_includes += states[t].unresolved;
+        auto closure = linked_closure(t);
+        std::map<size_t, std::string> missing; // Owner -> example header
+        for (const auto& header : states[t].reached_headers) {
+            auto owner = owner_of(header);
+            if (!owner) {
+                continue;
+            }
+            owned[*owner].insert(header);
+            if (*owner != t && is_library(targets[*owner]) && !closure.contains(*owner)) {
+                missing.emplace(*owner, header);
+            }
+        }
+        for (const auto& [owner, header] : missing) {
+            ++stats.missing_dependencies;
+            analysis.warnings.push_back(fmt::format(
+                "Target '{}' includes headers of '{}' (e.g. {}) but does not link it",
+                targets[t].name, targets[owner].name, header));
+        }
+    }
+
+    for (size_t t = 0; t < targets.size(); ++t) {
+        auto& headers = targets[t].headers;
+        std::unordered_set<PathId> present(headers.begin(), headers.end());
+        for (const auto& header : owned[t]) {
+            auto relative = PathId(header).relative_to(states[t].directory);
+            if (present.insert(relative).second) {
+                headers.push_back(relative);
+                ++stats.headers_assigned;
+            }
+        }
+    }
+
+    LOG_DEBUG("Include scan: {}", stats.to_string());
+    return stats;
+}
+
+Result<void, IOError> IncludeScanner::load(const fs::path& cache_file) {
+    auto file = MappedFile::open(cache_file);
+    if (!file.has_value()) {
+        return Result<void, IOError>::error(file.error());
+    }
+    auto text = file.value().view();
+    auto document = json::parse(text.begin(), text.end(), nullptr, false);
+    if (document.is_discarded() || !document.is_object() ||
+        document.value("format", 0) != cache_format_version || !document["files"].is_array()) {
+        return Result<void, IOError>::error(
+            IOError(fmt::format("Unreadable include cache {}", cache_file.string())));
+    }
+
+    std::lock_guard lock(cache_mutex_);
+    for (const auto& entry : document["files"]) {
+        // An entry with a field missing or of the wrong type is left out
+        auto has = [&](const char* key, bool (json::*is_type)() const noexcept) {
+            auto it = entry.find(key);
+            return it != entry.end() && ((*it).*is_type)();
+        };
+        if (!entry.is_object() || !has("path", &json::is_string) ||
+            !has("includes", &json::is_array) || !has("hash", &json::is_number_unsigned) ||
+            !has("mtime", &json::is_number_integer) || !has("size", &json::is_number_unsigned)) {
+            continue;
+        }
+        auto hash = entry["hash"].get<uint64_t>();
+        auto& directives = by_hash_[hash];
+        if (!directives) {
+            std::vector<Directive> includes;
+            for (const auto& include : entry["includes"]) {
+                if (include.is_array() && include.size() == 2 && include[0].is_string()) {
+                    includes.push_back({include[0].get<std::string>(), include[1] == true});
+                }
+            }
+            directives = std::make_shared<const std::vector<Directive>>(std::move(includes));
+        }
+        auto modified = fs::file_time_type(
+            fs::file_time_type::duration(entry["mtime"].get<int64_t>()));
+        by_path_[entry["path"].get<std::string>()] =
+            CachedFile{modified, entry["size"].get<uintmax_t>(), hash, directives};
+    }
+    return Result<void, IOError>{};
+}
+
+Result<void, IOError> IncludeScanner::save(const fs::path& cache_file) const {
+    json files = json::array();
+    for (const auto& [path, cached] : by_path_) {
+        json includes = json::array();
+        for (const auto& directive : *cached.directives) {
+            includes.push_back({directive.path, directive.angled});
+        }
+        files.push_back({{"path", path},
+                         {"mtime", cached.modified.time_since_epoch().count()},
+                         {"size", cached.size},
+                         {"hash", cached.hash},
+                         {"includes", std::move(includes)}});
+    }
+    json document = {{"format", cache_format_version}, {"files", std::move(files)}};
+    return replace_file(cache_file, document.dump());
+}
+
+fs::path IncludeScanner::default_cache_file() {
+    return cache_directory() / "include-directives.json";
+}
+
+std::string IncludeScanner::Stats::to_string() const {
+    return fmt::format("{} files scanned ({:.1f} MB), {} cache hits, {} unresolved includes, "
+                       "{} headers assigned, {} missing dependencies",
+                       files_scanned, static_cast<double>(bytes_scanned) / (1 << 20), cache_hits,
+                       unresolved_includes, headers_assigned, missing_dependencies);
+}
+
+} // namespace finch::analyzer
@@ -0,0 +1,507 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <finch/analyzer/intrinsics.hpp>
+#include <finch/core/logging.hpp>
+#include <fmt/format.h>
+#include <unordered_set>
+
+namespace finch::analyzer {
+
+namespace {
+
+std::string lowercase(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+std::string uppercase(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    return result;
+}
+
+std::string variable_or(const EvaluationContext& context, const std::string& name,
+                        std::string fallback) {
+    if (auto value = context.get_variable(name)) {
+        return value_helpers::to_string(value->value);
+    }
+    if (auto value = context.get_cache_variable(name)) {
+        return value_helpers::to_string(value->value);
+    }
+    return fallback;
+}
+
+// set(<name> <value> CACHE ...) semantics: an existing cache entry wins, and
+// a normal variable of the same name is left alone
+void set_cache_default(EvaluationContext& context, const std::string& name, Value value,
+                       Confidence confidence = Confidence::Certain) {
+    if (auto existing = context.get_cache_variable(name)) {
+        if (!context.get_variable(name)) {
+            context.set_variable(name, existing->value, existing->confidence);
+        }
+        return;
+    }
+    context.set_cache_variable(name, value, confidence);
+    if (!context.get_variable(name)) {
+        context.set_variable(name, std::move(value), confidence);
+    }
+}
+
+// option() whose default comes from an environment variable, as CPM.cmake does
+void set_env_option(EvaluationContext& context, const std::string& name) {
+    const char* env = std::getenv(name.c_str());
+    set_cache_default(context, name, std::string(env ? env : "OFF"));
+}
+
+// GNUInstallDirs.cmake: relative install directories as cache entries and
+// their CMAKE_INSTALL_FULL_<dir> counterparts under the install prefix
+Confidence gnu_install_dirs(EvaluationContext& context, const std::vector<std::string>&) {
+    auto prefix = variable_or(context, "CMAKE_INSTALL_PREFIX", "/usr/local");
+    while (prefix.size() > 1 && prefix.back() == '/') {
+        prefix.pop_back();
+    }
+
+    // lib64 or a Debian multiarch directory depend on the target distribution,
+    // which is not known here; only lib/<arch> under /usr can be derived
+    auto libdir = std::string("lib");
+    auto libdir_confidence = Confidence::Likely;
+    if (auto arch = variable_or(context, "CMAKE_LIBRARY_ARCHITECTURE", "");
+        !arch.empty() && (prefix == "/usr" || prefix == "/")) {
+        libdir = "lib/" + arch;
+        libdir_confidence = Confidence::Certain;
+    }
+
+    set_cache_default(context, "CMAKE_INSTALL_BINDIR", std::string("bin"));
+    set_cache_default(context, "CMAKE_INSTALL_SBINDIR", std::string("sbin"));
+    set_cache_default(context, "CMAKE_INSTALL_LIBEXECDIR", std::string("libexec"));
+    set_cache_default(context, "CMAKE_INSTALL_SYSCONFDIR", std::string("etc"));
+    set_cache_default(context, "CMAKE_INSTALL_SHAREDSTATEDIR", std::string("com"));
+    set_cache_default(context, "CMAKE_INSTALL_LOCALSTATEDIR", std::string("var"));
+    set_cache_default(context, "CMAKE_INSTALL_LIBDIR", libdir, libdir_confidence);
+    set_cache_default(context, "CMAKE_INSTALL_INCLUDEDIR", std::string("include"));
+    set_cache_default(context, "CMAKE_INSTALL_OLDINCLUDEDIR", std::string("/usr/include"));
+    set_cache_default(context, "CMAKE_INSTALL_DATAROOTDIR", std::string("share"));
+
+    // Directories defaulting to another one are derived after the cache
+    // entries they depend on are settled
+    auto dir = [&](const char* name) {
+        return variable_or(context, fmt::format("CMAKE_INSTALL_{}", name), "");
+    };
+    set_cache_default(context, "CMAKE_INSTALL_RUNSTATEDIR", dir("LOCALSTATEDIR") + "/run");
+    set_cache_default(context, "CMAKE_INSTALL_DATADIR", dir("DATAROOTDIR"));
+    set_cache_default(context, "CMAKE_INSTALL_INFODIR", dir("DATAROOTDIR") + "/info");
+    set_cache_default(context, "CMAKE_INSTALL_LOCALEDIR", dir("DATAROOTDIR") + "/locale");
+    set_cache_default(context, "CMAKE_INSTALL_MANDIR", dir("DATAROOTDIR") + "/man");
+    set_cache_default(context, "CMAKE_INSTALL_DOCDIR",
+                      dir("DATAROOTDIR") + "/doc/" + variable_or(context, "PROJECT_NAME", ""));
+
+    static const char* const dirs[] = {"BINDIR",        "SBINDIR",        "LIBEXECDIR",
+                                       "SYSCONFDIR",    "SHAREDSTATEDIR", "LOCALSTATEDIR",
+                                       "RUNSTATEDIR",   "LIBDIR",         "INCLUDEDIR",
+                                       "OLDINCLUDEDIR", "DATAROOTDIR",    "DATADIR",
+                                       "INFODIR",       "LOCALEDIR",      "MANDIR",
+                                       "DOCDIR"};
+    for (const char* name : dirs) {
+        auto relative = dir(name);
+        std::string full;
+        std::string_view which(name);
+        bool system_state = which == "SYSCONFDIR" || which == "LOCALSTATEDIR" ||
+                            which == "RUNSTATEDIR";
+        if (relative.starts_with('/')) {
+            full = relative;
+        } else if (system_state && prefix == "/usr") {
+            // /usr installs configuration and state under /etc and /var
+            full = "/" + relative;
+        } else if (system_state && prefix.starts_with("/opt/")) {
+            full = "/" + relative + prefix;
+        } else if (prefix == "/") {
+            full = system_state ? "/" + relative : "/usr/" + relative;
+        } else {
+            full = prefix + "/" + relative;
+        }
+        auto confidence = which == "LIBDIR" ? libdir_confidence : Confidence::Certain;
+        context.set_variable(fmt::format("CMAKE_INSTALL_FULL_{}", name), full, confidence);
+    }
+    return Confidence::Certain;
+}
+
+// cmake_parse_arguments(<prefix> <options> <one_value> <multi_value> <args>...)
+// cmake_parse_arguments(PARSE_ARGV <N> <prefix> <options> <one_value> <multi_value>)
+Confidence parse_arguments(EvaluationContext& context, const std::vector<std::string>& args) {
+    if (args.size() < 4) {
+        return Confidence::Unknown;
+    }
+
+    // Keyword lists must be quoted, as in CMake: unquoted they expand into
+    // several arguments and shift the ones after them
+    std::vector<std::string> values;
+    size_t base = 0;
+    Confidence confidence = Confidence::Certain;
+    if (args[0] == "PARSE_ARGV") {
+        if (args.size() < 6) {
+            return Confidence::Unknown;
+        }
+        char* end = nullptr;
+        auto first = std::strtoul(args[1].c_str(), &end, 10);
+        auto argc = context.get_variable("ARGC");
+        if (*end != '\0' || !argc) {
+            return Confidence::Unknown;
+        }
+        auto count = std::strtoul(value_helpers::to_string(argc->value).c_str(), nullptr, 10);
+        for (auto i = first; i < count; ++i) {
+            auto value = context.get_variable(fmt::format("ARGV{}", i));
+            if (!value) {
+                confidence = Confidence::Uncertain;
+                continue;
+            }
+            values.push_back(value_helpers::to_string(value->value));
+            confidence = std::max(confidence, value->confidence);
+        }
+        base = 2;
+    }
+
+    const auto& prefix = args[base];
+    auto split = [](const std::string& list) {
+        return value_helpers::to_list(Value{list});
+    };
+    auto options = split(args[base + 1]);
+    auto one_value = split(args[base + 2]);
+    auto multi_value = base + 3 < args.size() ? split(args[base + 3]) : std::vector<std::string>{};
+    if (base == 0) {
+        values.assign(args.begin() + 4, args.end());
+    }
+
+    enum class Kind { Option, One, Multi };
+    std::unordered_map<std::string, Kind> keywords;
+    for (const auto& keyword : options) {
+        keywords.emplace(keyword, Kind::Option);
+    }
+    for (const auto& keyword : one_value) {
+        keywords.emplace(keyword, Kind::One);
+    }
+    for (const auto& keyword : multi_value) {
+        keywords.emplace(keyword, Kind::Multi);
+    }
+
+    std::unordered_set<std::string> present;
+    std::unordered_map<std::string, std::vector<std::string>> parsed;
+    std::vector<std::string> unparsed;
+    std::vector<std::string> missing_values;
+    const std::string* current = nullptr;
+    Kind current_kind = Kind::Option;
+    bool current_has_value = false;
+
+    auto finish_keyword = [&]() {
+        if (current && current_kind != Kind::Option && !current_has_value) {
+            missing_values.push_back(*current);
+        }
+        current = nullptr;
+    };
+
+    for (const auto& value : values) {
+        if (auto keyword = keywords.find(value); keyword != keywords.end()) {
+            finish_keyword();
+            present.insert(keyword->first);
+            if (keyword->second == Kind::Option) {
+                continue;
+            }
+            current = &keyword->first;
+            current_kind = keyword->second;
+            current_has_value = false;
+            if (current_kind == Kind::One) {
+                parsed[*current].clear(); // The last occurrence wins
+            }
+            continue;
+        }
+        if (!current) {
+            unparsed.push_back(value);
+        } else if (current_kind == Kind::One) {
+            if (current_has_value) {
+                unparsed.push_back(value);
+            } else {
+                parsed[*current].push_back(value);
+                current_has_value = true;
+            }
+        } else {
+            parsed[*current].push_back(value);
+            current_has_value = true;
+        }
+    }
+    finish_keyword();
+
+    // Keywords that were not given, or given without a value, are unset
+    for (const auto& keyword : options) {
+        context.set_variable(prefix + "_" + keyword,
+                             std::string(present.contains(keyword) ? "TRUE" : "FALSE"),
+                             confidence);
+    }
+    for (const auto* keys : {&one_value, &multi_value}) {
+        for (const auto& keyword : *keys) {
+            auto name = prefix + "_" + keyword;
+            auto found = parsed.find(keyword);
+            if (found == parsed.end() || found->second.empty()) {
+                context.unset_variable(name);
+            } else if (keys == &one_value) {
+                context.set_variable(name, found->second.front(), confidence);
+            } else {
+                context.set_variable(name, found->second, confidence);
+            }
+        }
+    }
+    auto set_or_unset = [&](const std::string& name, std::vector<std::string> list) {
+        if (list.empty()) {
+            context.unset_variable(name);
+        } else {
+            context.set_variable(name, std::move(list), confidence);
+        }
+    };
+    set_or_unset(prefix + "_UNPARSED_ARGUMENTS", std::move(unparsed));
+    set_or_unset(prefix + "_KEYWORDS_MISSING_VALUES", std::move(missing_values));
+    return confidence;
+}
+
+// FetchContent keeps declarations and population state in global properties;
+// here they live in internal cache entries named the same way
+std::string fetch_details_key(const std::string& name) {
+    return fmt::format("_FetchContent_{}_savedDetails", lowercase(name));
+}
+
+std::string fetch_populated_key(const std::string& name) {
+    return fmt::format("_FetchContent_{}_populated", lowercase(name));
+}
+
+Confidence fetch_content_module(EvaluationContext& context, const std::vector<std::string>&) {
+    set_cache_default(context, "FETCHCONTENT_BASE_DIR",
+                      variable_or(context, "CMAKE_BINARY_DIR", "/build") + "/_deps");
+    set_cache_default(context, "FETCHCONTENT_QUIET", std::string("ON"));
+    set_cache_default(context, "FETCHCONTENT_FULLY_DISCONNECTED", std::string("OFF"));
+    set_cache_default(context, "FETCHCONTENT_UPDATES_DISCONNECTED", std::string("OFF"));
+    set_cache_default(context, "FETCHCONTENT_TRY_FIND_PACKAGE_MODE", std::string("OPT_IN"));
+    return Confidence::Certain;
+}
+
+Confidence fetch_content_declare(EvaluationContext& context,
+                                 const std::vector<std::string>& args) {
+    if (args.empty()) {
+        return Confidence::Unknown;
+    }
+    // The first declaration of a dependency wins, so parents can override
+    // what their subprojects declare
+    auto key = fetch_details_key(args[0]);
+    if (!context.get_cache_variable(key)) {
+        context.set_cache_variable(key, std::vector<std::string>(args.begin() + 1, args.end()));
+    }
+    return Confidence::Certain;
+}
+
+// The directories FetchContent_Populate() would use for a dependency
+std::pair<std::string, std::string> fetch_directories(const EvaluationContext& context,
+                                                      const std::string& name) {
+    auto lower = lowercase(name);
+    auto base = variable_or(context, "FETCHCONTENT_BASE_DIR",
+                            variable_or(context, "CMAKE_BINARY_DIR", "/build") + "/_deps");
+    auto source_dir = base + "/" + lower + "-src";
+    auto binary_dir = base + "/" + lower + "-build";
+
+    if (auto details = context.get_cache_variable(fetch_details_key(name))) {
+        auto words = value_helpers::to_list(details->value);
+        for (size_t i = 0; i + 1 < words.size(); ++i) {
+            if (words[i] == "SOURCE_DIR") {
+                source_dir = words[i + 1];
+            } else if (words[i] == "BINARY_DIR") {
+                binary_dir = words[i + 1];
+            }
+        }
+    }
+    // A local checkout given on the command line replaces the download
+    auto local = variable_or(context, "FETCHCONTENT_SOURCE_DIR_" + uppercase(name), "");
+    if (!local.empty()) {
+        source_dir = local;
+    }
+    return {source_dir, binary_dir};
+}
+
+void fetch_set_properties(EvaluationContext& context, const std::string& name,
+                          const std::string& source_var, const std::string& binary_var,
+                          const std::string& populated_var) {
+    bool populated = context.get_cache_variable(fetch_populated_key(name)).has_value();
+    if (populated) {
+        auto [source_dir, binary_dir] = fetch_directories(context, name);
+        context.set_variable(source_var, source_dir);
+        context.set_variable(binary_var, binary_dir);
+    }
+    context.set_variable(populated_var, std::string(populated ? "TRUE" : "FALSE"));
+}
+
+Confidence fetch_content_populate(EvaluationContext& context,
+                                  const std::vector<std::string>& args) {
+    if (args.empty()) {
+        return Confidence::Unknown;
+    }
+    auto lower = lowercase(args[0]);
+    context.set_cache_variable(fetch_populated_key(args[0]), std::string("TRUE"));
+    fetch_set_properties(context, args[0], lower + "_SOURCE_DIR", lower + "_BINARY_DIR",
+                         lower + "_POPULATED");
+    return Confidence::Certain;
+}
+
+Confidence fetch_content_get_properties(EvaluationContext& context,
+                                        const std::vector<std::string>& args) {
+    if (args.empty()) {
+        return Confidence::Unknown;
+    }
+    auto lower = lowercase(args[0]);
+    std::string source_var = lower + "_SOURCE_DIR";
+    std::string binary_var = lower + "_BINARY_DIR";
+    std::string populated_var = lower + "_POPULATED";
+    for (size_t i = 1; i + 1 < args.size(); i += 2) {
+        if (args[i] == "SOURCE_DIR") {
+            source_var = args[i + 1];
+        } else if (args[i] == "BINARY_DIR") {
+            binary_var = args[i + 1];
+        } else if (args[i] == "POPULATED") {
+            populated_var = args[i + 1];
+        }
+    }
+    fetch_set_properties(context, args[0], source_var, binary_var, populated_var);
+    return Confidence::Certain;
+}
+
+Confidence fetch_content_make_available(EvaluationContext& context,
+                                        const std::vector<std::string>& args) {
+    // Populates every declared dependency; the targets its own CMakeLists.txt
+    // would add are not known until that source is migrated in turn
+    Confidence confidence = Confidence::Certain;
+    for (const auto& name : args) {
+        if (!context.get_cache_variable(fetch_details_key(name))) {
+            LOG_DEBUG("FetchContent_MakeAvailable({}) without a declaration", name);
+            confidence = Confidence::Uncertain;
+            continue;
+        }
+        fetch_content_populate(context, {name});
+    }
+    return confidence;
+}
+
+// CPM.cmake, or the get_cpm.cmake bootstrap that downloads and includes it
+Confidence cpm_bootstrap(EvaluationContext& context, const std::vector<std::string>& args) {
+    auto confidence = Confidence::Certain;
+    std::string version = variable_or(context, "CPM_DOWNLOAD_VERSION", "");
+    if (!args.empty()) {
+        auto path = args[0];
+        auto stem = path.substr(path.find_last_of('/') + 1);
+        if (stem.starts_with("CPM_") && stem.ends_with(".cmake")) {
+            version = stem.substr(4, stem.size() - 4 - 6);
+        }
+        context.set_variable("CPM_FILE", path);
+        auto slash = path.find_last_of('/');
+        context.set_variable("CPM_DIRECTORY",
+                             slash == std::string::npos ? std::string(".") : path.substr(0, slash));
+    }
+    if (version.empty()) {
+        confidence = Confidence::Likely;
+    } else {
+        context.set_variable("CURRENT_CPM_VERSION", version);
+    }
+
+    for (const char* option :
+         {"CPM_USE_LOCAL_PACKAGES", "CPM_LOCAL_PACKAGES_ONLY", "CPM_DOWNLOAD_ALL",
+          "CPM_DONT_UPDATE_MODULE_PATH", "CPM_DONT_CREATE_PACKAGE_LOCK",
+          "CPM_INCLUDE_ALL_IN_PACKAGE_LOCK", "CPM_USE_NAMED_CACHE_DIRECTORIES"}) {
+        set_env_option(context, option);
+    }
+    const char* source_cache = std::getenv("CPM_SOURCE_CACHE");
+    set_cache_default(context, "CPM_SOURCE_CACHE",
+                      std::string(source_cache && *source_cache ? source_cache : "OFF"));
+    set_cache_default(context, "CPM_PACKAGE_LOCK_FILE",
+                      variable_or(context, "CMAKE_BINARY_DIR", "/build") +
+                          "/cpm-package-lock.cmake");
+    context.set_variable("CPM_INDENT", std::string("CPM:"));
+    context.set_variable("CPM_PACKAGES", std::vector<std::string>{});
+    return confidence;
+}
+
+// Modules whose only effect is defining commands evaluated natively elsewhere
+Confidence defines_commands(EvaluationContext&, const std::vector<std::string>&) {
+    return Confidence::Certain;
+}
+
+} // namespace
+
+IntrinsicRegistry::IntrinsicRegistry() {
+    register_default_intrinsics();
+}
+
+void IntrinsicRegistry::register_module(std::string name, Handler handler) {
+    modules_[std::move(name)] = std::move(handler);
+}
+
+void IntrinsicRegistry::register_script(std::string stem, Handler handler) {
+    scripts_[std::move(stem)] = std::move(handler);
+}
+
+void IntrinsicRegistry::register_command(std::string name, Handler handler) {
+    commands_[lowercase(name)] = std::move(handler);
+}
+
+const IntrinsicRegistry::Handler*
+IntrinsicRegistry::find_include(std::string_view name_or_path) const {
+    // include(<module>) names a module; anything with a directory or the
+    // .cmake extension is a file of the project's own
+    if (!name_or_path.ends_with(".cmake") && name_or_path.find('/') == std::string_view::npos) {
+        auto it = modules_.find(std::string(name_or_path));
+        return it != modules_.end() ? &it->second : nullptr;
+    }
+    auto slash = name_or_path.find_last_of('/');
+    auto stem = slash == std::string_view::npos ? name_or_path : name_or_path.substr(slash + 1);
+    if (!stem.ends_with(".cmake")) {
+        return nullptr;
+    }
+    stem.remove_suffix(6);
+    if (stem.starts_with("CPM_")) {
+        stem = "CPM";
+    }
+    auto it = scripts_.find(std::string(stem));
+    return it != scripts_.end() ? &it->second : nullptr;
+}
+
+const IntrinsicRegistry::Handler* IntrinsicRegistry::find_command(std::string_view name) const {
+    auto it = commands_.find(lowercase(name));
+    return it != commands_.end() ? &it->second : nullptr;
+}
+
+void IntrinsicRegistry::register_default_intrinsics() {
+    register_module("GNUInstallDirs", gnu_install_dirs);
+    register_module("FetchContent", fetch_content_module);
+    register_module("CMakeParseArguments", defines_commands);
+    register_module("CMakePackageConfigHelpers", defines_commands);
+    register_module("WriteBasicConfigVersionFile", defines_commands);
+    for (const char* check :
+         {"CheckIncludeFile", "CheckIncludeFileCXX", "CheckIncludeFiles", "CheckCSourceCompiles",
+          "CheckCXXSourceCompiles", "CheckSourceCompiles", "CheckSymbolExists",
+          "CheckCXXSymbolExists", "CheckFunctionExists", "CheckLibraryExists"}) {
+        register_module(check, defines_commands);
+    }
+    register_script("CPM", cpm_bootstrap);
+    register_script("get_cpm", cpm_bootstrap);
+
+    register_command("cmake_parse_arguments", parse_arguments);
+    register_command("FetchContent_Declare", fetch_content_declare);
+    register_command("FetchContent_Populate", fetch_content_populate);
+    register_command("FetchContent_GetProperties", fetch_content_get_properties);
+    register_command("FetchContent_MakeAvailable", fetch_content_make_available);
+    // Both write files into the build tree and set no variables
+    register_command("write_basic_package_version_file", defines_commands);
+    register_command("configure_package_config_file", defines_commands);
+}
+
+const IntrinsicRegistry& IntrinsicRegistry::builtin() {
+    static const IntrinsicRegistry registry;
+    return registry;
+}
+
+} // namespace finch::analyzer
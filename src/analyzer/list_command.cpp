@@ -0,0 +1,638 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <finch/analyzer/cmake_regex.hpp>
+#include <finch/analyzer/list_command.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/parser/keyword_schema.hpp>
+#include <fmt/format.h>
+#include <optional>
+#include <regex>
+#include <span>
+#include <string_view>
+#include <unordered_set>
+
+namespace finch::analyzer {
+
+namespace {
+
+using Elements = std::vector<std::string>;
+
+// A list as read by a subcommand that does not modify it; a list stored as
+// a string is split into storage, a vector is used where it is
+struct ListReader {
+    const Elements* elements = nullptr;
+    Elements storage;
+    Confidence confidence = Confidence::Certain;
+};
+
+// One list(<subcommand> <list> <args>...) call
+struct Call {
+    EvaluationContext& context;
+    std::string_view subcommand;
+    const std::string& list;
+    std::span<const std::string> args;
+    Confidence confidence;
+
+    [[nodiscard]] AnalysisError error(std::string_view message) const {
+        return AnalysisError(fmt::format("list({} {}) {}", subcommand, list, message));
+    }
+
+    [[nodiscard]] Result<void, AnalysisError> fail(std::string_view message) const {
+        return Result<void, AnalysisError>::error(error(message));
+    }
+
+    // The current scope's elements, split in place the first time
+    [[nodiscard]] Elements& modify() const {
+        auto& binding = context.local_variable(list);
+        if (!std::holds_alternative<Elements>(binding.value)) {
+            binding.value = value_helpers::to_list(binding.value);
+        }
+        binding.confidence = std::max(binding.confidence, confidence);
+        return std::get<Elements>(binding.value);
+    }
+
+    [[nodiscard]] ListReader read() const {
+        ListReader reader;
+        const auto* binding = context.find_variable(list);
+        if (!binding) {
+            reader.elements = &reader.storage;
+            return reader;
+        }
+        reader.confidence = binding->confidence;
+        if (const auto* elements = std::get_if<Elements>(&binding->value)) {
+            reader.elements = elements;
+        } else {
+            reader.storage = value_helpers::to_list(binding->value);
+            reader.elements = &reader.storage;
+        }
+        return reader;
+    }
+
+    void set(const std::string& name, Value value, Confidence list_confidence) const {
+        context.set_variable(name, std::move(value), std::max(confidence, list_confidence));
+    }
+};
+
+// A quoted "a;b" argument adds two elements
+void append_elements(Elements& elements, const std::string& arg) {
+    if (arg.find(';') == std::string::npos) {
+        elements.push_back(arg);
+        return;
+    }
+    for (auto& element : value_helpers::to_list(Value{arg})) {
+        elements.push_back(std::move(element));
+    }
+}
+
+std::optional<long long> parse_integer(std::string_view text) {
+    long long value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// An index into a list of size elements, negative ones counting from the
+// end; INSERT may also name the position after the last element
+std::optional<size_t> resolve_index(std::string_view text, size_t size, bool allow_end = false) {
+    auto index = parse_integer(text);
+    if (!index) {
+        return std::nullopt;
+    }
+    auto signed_size = static_cast<long long>(size);
+    auto resolved = *index < 0 ? *index + signed_size : *index;
+    if (resolved < 0 || resolved > signed_size || (resolved == signed_size && !allow_end)) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(resolved);
+}
+
+Result<const std::regex*, AnalysisError> compile_regex(const Call& call,
+                                                     const std::string& pattern) {
+    auto regex = CMakeRegex::compile(pattern);
+    if (!regex.has_value()) {
+        return Result<const std::regex*, AnalysisError>(std::in_place_index<1>,
+                                                        call.error(regex.error().message()));
+    }
+    return regex;
+}
+
+// SORT's ordering: COMPARE STRING|FILE_BASENAME|NATURAL, CASE, ORDER
+struct SortOrder {
+    bool basename = false;
+    bool natural = false;
+    bool fold_case = false;
+    bool descending = false;
+};
+
+int compare_elements(std::string_view a, std::string_view b, const SortOrder& order) {
+    if (order.basename) {
+        auto basename = [](std::string_view path) {
+            auto slash = path.find_last_of('/');
+            return slash == std::string_view::npos ? path : path.substr(slash + 1);
+        };
+        a = basename(a);
+        b = basename(b);
+    }
+    auto fold = [&](char c) {
+        return order.fold_case ? static_cast<char>(std::tolower(static_cast<unsigned char>(c)))
+                               : c;
+    };
+    auto digit = [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; };
+
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (order.natural && digit(a[i]) && digit(b[j])) {
+            // Digit runs compare as numbers: file9 < file10
+            size_t a_end = i;
+            size_t b_end = j;
+            while (a_end < a.size() && digit(a[a_end])) {
+                ++a_end;
+            }
+            while (b_end < b.size() && digit(b[b_end])) {
+                ++b_end;
+            }
+            auto a_run = a.substr(i, a_end - i);
+            auto b_run = b.substr(j, b_end - j);
+            a_run.remove_prefix(std::min(a_run.find_first_not_of('0'), a_run.size()));
+            b_run.remove_prefix(std::min(b_run.find_first_not_of('0'), b_run.size()));
+            if (a_run.size() != b_run.size()) {
+                return a_run.size() < b_run.size() ? -1 : 1;
+            }
+            if (int run = a_run.compare(b_run); run != 0) {
+                return run;
+            }
+            i = a_end;
+            j = b_end;
+            continue;
+        }
+        char ca = fold(a[i++]);
+        char cb = fold(b[j++]);
+        if (ca != cb) {
+            return static_cast<unsigned char>(ca) < static_cast<unsigned char>(cb) ? -1 : 1;
+        }
+    }
+    if (i == a.size() && j == b.size()) {
+        return 0;
+    }
+    return i == a.size() ? -1 : 1;
+}
+
+// Reading subcommands
+
+Result<void, AnalysisError> list_length(const Call& call) {
+    if (call.args.size() != 1) {
+        return call.fail("requires an output variable");
+    }
+    auto reader = call.read();
+    call.set(call.args[0], std::to_string(reader.elements->size()), reader.confidence);
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_get(const Call& call) {
+    if (call.args.size() < 2) {
+        return call.fail("requires indices and an output variable");
+    }
+    auto reader = call.read();
+    const auto& elements = *reader.elements;
+    Elements values;
+    for (const auto& text : call.args.first(call.args.size() - 1)) {
+        auto index = resolve_index(text, elements.size());
+        if (!index) {
+            return call.fail(fmt::format("index {} is out of range", text));
+        }
+        values.push_back(elements[*index]);
+    }
+    call.set(call.args.back(), std::move(values), reader.confidence);
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_join(const Call& call) {
+    if (call.args.size() != 2) {
+        return call.fail("requires a glue and an output variable");
+    }
+    auto reader = call.read();
+    std::string joined;
+    for (const auto& element : *reader.elements) {
+        if (&element != &reader.elements->front()) {
+            joined += call.args[0];
+        }
+        joined += element;
+    }
+    call.set(call.args[1], std::move(joined), reader.confidence);
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_sublist(const Call& call) {
+    if (call.args.size() != 3) {
+        return call.fail("requires a begin, a length and an output variable");
+    }
+    auto reader = call.read();
+    const auto& elements = *reader.elements;
+    auto begin = parse_integer(call.args[0]);
+    auto length = parse_integer(call.args[1]);
+    if (!begin || !length || *begin < 0 || *begin > static_cast<long long>(elements.size()) ||
+        *length < -1) {
+        return call.fail("has an invalid range");
+    }
+    auto first = static_cast<size_t>(*begin);
+    auto count = *length == -1 ? elements.size() - first
+                               : std::min(static_cast<size_t>(*length), elements.size() - first);
+    call.set(call.args[2],
+             Elements(elements.begin() + static_cast<ptrdiff_t>(first),
+                      elements.begin() + static_cast<ptrdiff_t>(first + count)),
+             reader.confidence);
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_find(const Call& call) {
+    if (call.args.size() != 2) {
+        return call.fail("requires a value and an output variable");
+    }
+    auto reader = call.read();
+    const auto& elements = *reader.elements;
+    auto it = std::find(elements.begin(), elements.end(), call.args[0]);
+    auto index = it == elements.end() ? -1 : static_cast<long long>(it - elements.begin());
+    call.set(call.args[1], std::to_string(index), reader.confidence);
+    return Ok<AnalysisError>();
+}
+
+// Modifying subcommands
+
+Result<void, AnalysisError> list_append(const Call& call) {
+    auto& elements = call.modify();
+    for (const auto& arg : call.args) {
+        append_elements(elements, arg);
+    }
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_prepend(const Call& call) {
+    Elements prepended;
+    for (const auto& arg : call.args) {
+        append_elements(prepended, arg);
+    }
+    auto& elements = call.modify();
+    elements.insert(elements.begin(), std::make_move_iterator(prepended.begin()),
+                    std::make_move_iterator(prepended.end()));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_insert(const Call& call) {
+    if (call.args.empty()) {
+        return call.fail("requires an index");
+    }
+    auto& elements = call.modify();
+    auto index = resolve_index(call.args[0], elements.size(), true);
+    if (!index) {
+        return call.fail(fmt::format("index {} is out of range", call.args[0]));
+    }
+    Elements inserted;
+    for (const auto& arg : call.args.subspan(1)) {
+        append_elements(inserted, arg);
+    }
+    elements.insert(elements.begin() + static_cast<ptrdiff_t>(*index),
+                    std::make_move_iterator(inserted.begin()),
+                    std::make_move_iterator(inserted.end()));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_pop(const Call& call, bool front) {
+    auto& elements = call.modify();
+    auto confidence = call.context.find_variable(call.list)->confidence;
+    size_t count = std::min(std::max<size_t>(call.args.size(), 1), elements.size());
+    for (size_t i = 0; i < call.args.size(); ++i) {
+        if (i >= count) {
+            // Nothing left to pop into it
+            call.context.unset_variable(call.args[i]);
+        } else {
+            auto& popped = front ? elements[i] : elements[elements.size() - 1 - i];
+            call.set(call.args[i], std::move(popped), confidence);
+        }
+    }
+    auto count_offset = static_cast<ptrdiff_t>(count);
+    if (front) {
+        elements.erase(elements.begin(), elements.begin() + count_offset);
+    } else {
+        elements.erase(elements.end() - count_offset, elements.end());
+    }
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_pop_back(const Call& call) {
+    return list_pop(call, false);
+}
+
+Result<void, AnalysisError> list_pop_front(const Call& call) {
+    return list_pop(call, true);
+}
+
+Result<void, AnalysisError> list_remove_item(const Call& call) {
+    if (call.args.empty()) {
+        return call.fail("requires values to remove");
+    }
+    std::unordered_set<std::string_view> removed(call.args.begin(), call.args.end());
+    auto& elements = call.modify();
+    std::erase_if(elements, [&](const std::string& element) { return removed.contains(element); });
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_remove_at(const Call& call) {
+    if (call.args.empty()) {
+        return call.fail("requires indices");
+    }
+    auto& elements = call.modify();
+    std::vector<char> removed(elements.size(), 0);
+    for (const auto& text : call.args) {
+        auto index = resolve_index(text, elements.size());
+        if (!index) {
+            return call.fail(fmt::format("index {} is out of range", text));
+        }
+        removed[*index] = 1;
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < elements.size(); ++i) {
+        if (!removed[i]) {
+            if (kept != i) {
+                elements[kept] = std::move(elements[i]);
+            }
+            ++kept;
+        }
+    }
+    elements.resize(kept);
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_remove_duplicates(const Call& call) {
+    auto& elements = call.modify();
+
+    // Decide first, while the views into the elements are stable, then compact
+    std::vector<char> keep(elements.size(), 0);
+    {
+        std::unordered_set<std::string_view> seen;
+        seen.reserve(elements.size());
+        for (size_t i = 0; i < elements.size(); ++i) {
+            keep[i] = seen.insert(elements[i]).second ? 1 : 0;
+        }
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < elements.size(); ++i) {
+        if (keep[i]) {
+            if (kept != i) {
+                elements[kept] = std::move(elements[i]);
+            }
+            ++kept;
+        }
+    }
+    elements.resize(kept);
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_filter(const Call& call) {
+    if (call.args.size() != 3 || (call.args[0] != "INCLUDE" && call.args[0] != "EXCLUDE") ||
+        call.args[1] != "REGEX") {
+        return call.fail("requires INCLUDE|EXCLUDE REGEX <regex>");
+    }
+    auto regex = compile_regex(call, call.args[2]);
+    if (!regex.has_value()) {
+        return Result<void, AnalysisError>::error(regex.error());
+    }
+    bool include = call.args[0] == "INCLUDE";
+    auto& elements = call.modify();
+    std::erase_if(elements, [&](const std::string& element) {
+        return std::regex_search(element, *regex.value()) != include;
+    });
+    return Ok<AnalysisError>();
+}
+
+constexpr parser::KeywordSchema<4> TRANSFORM_SCHEMA({{
+    {"AT", parser::KeywordKind::MultiValue},
+    {"FOR", parser::KeywordKind::MultiValue},
+    {"REGEX", parser::KeywordKind::OneValue},
+    {"OUTPUT_VARIABLE", parser::KeywordKind::OneValue},
+}});
+constexpr size_t TRANSFORM_AT = TRANSFORM_SCHEMA.slot("AT");
+constexpr size_t TRANSFORM_FOR = TRANSFORM_SCHEMA.slot("FOR");
+constexpr size_t TRANSFORM_REGEX = TRANSFORM_SCHEMA.slot("REGEX");
+constexpr size_t TRANSFORM_OUTPUT = TRANSFORM_SCHEMA.slot("OUTPUT_VARIABLE");
+
+Result<void, AnalysisError> list_transform(const Call& call) {
+    if (call.args.empty()) {
+        return call.fail("requires an action");
+    }
+    const auto& action = call.args[0];
+    size_t arity = action == "APPEND" || action == "PREPEND" ? 1 : action == "REPLACE" ? 2 : 0;
+    if (arity == 0 && action != "TOLOWER" && action != "TOUPPER" && action != "STRIP" &&
+        action != "GENEX_STRIP") {
+        return call.fail(fmt::format("has an unknown action {}", action));
+    }
+    if (call.args.size() < 1 + arity) {
+        return call.fail(fmt::format("{} requires {} arguments", action, arity));
+    }
+    auto parsed = TRANSFORM_SCHEMA.partition(
+        call.args.size(), [&](size_t i) -> std::string_view { return call.args[i]; }, 1 + arity);
+    if (parsed.positional().size() != 1 + arity) {
+        return call.fail("has unexpected arguments");
+    }
+
+    const std::regex* replace = nullptr;
+    std::optional<RegexReplacement> replacement;
+    if (action == "REPLACE") {
+        auto regex = compile_regex(call, call.args[1]);
+        if (!regex.has_value()) {
+            return Result<void, AnalysisError>::error(regex.error());
+        }
+        auto parsed_replacement = RegexReplacement::parse(call.args[2]);
+        if (!parsed_replacement.has_value()) {
+            return call.fail(parsed_replacement.error().message());
+        }
+        replace = regex.value();
+        replacement = std::move(parsed_replacement.value());
+    }
+
+    // Work on the list itself, or on a copy for OUTPUT_VARIABLE
+    auto output = parsed.value(TRANSFORM_OUTPUT);
+    Elements copy;
+    Confidence confidence = call.confidence;
+    Elements* elements = nullptr;
+    if (output) {
+        auto reader = call.read();
+        copy = *reader.elements;
+        confidence = reader.confidence;
+        elements = &copy;
+    } else {
+        elements = &call.modify();
+    }
+
+    // Selected elements; all of them without a selector
+    std::vector<char> selected(elements->size(), 1);
+    if (parsed.has(TRANSFORM_AT) || parsed.has(TRANSFORM_FOR) || parsed.has(TRANSFORM_REGEX)) {
+        std::fill(selected.begin(), selected.end(), 0);
+    }
+    for (auto position : parsed.values(TRANSFORM_AT)) {
+        auto index = resolve_index(call.args[position], elements->size());
+        if (!index) {
+            return call.fail(fmt::format("index {} is out of range", call.args[position]));
+        }
+        selected[*index] = 1;
+    }
+    if (parsed.has(TRANSFORM_FOR)) {
+        auto range = parsed.values(TRANSFORM_FOR);
+        if (range.size() < 2 || range.size() > 3) {
+            return call.fail("has an invalid FOR range");
+        }
+        auto start = resolve_index(call.args[range[0]], elements->size());
+        auto stop = resolve_index(call.args[range[1]], elements->size());
+        auto step = range.size() == 3 ? parse_integer(call.args[range[2]])
+                                      : std::optional<long long>(1);
+        if (!start || !stop || !step || *step <= 0 || *start > *stop) {
+            return call.fail("has an invalid FOR range");
+        }
+        for (size_t i = *start, last = *stop; i <= last; i += static_cast<size_t>(*step)) {
+            selected[i] = 1;
+        }
+    }
+    if (auto pattern = parsed.value(TRANSFORM_REGEX)) {
+        auto regex = compile_regex(call, call.args[*pattern]);
+        if (!regex.has_value()) {
+            return Result<void, AnalysisError>::error(regex.error());
+        }
+        for (size_t i = 0; i < elements->size(); ++i) {
+            selected[i] = std::regex_search((*elements)[i], *regex.value()) ? 1 : 0;
+        }
+    }
+
+    for (size_t i = 0; i < elements->size(); ++i) {
+        if (!selected[i]) {
+            continue;
+        }
+        auto& element = (*elements)[i];
+        if (action == "APPEND") {
+            element += call.args[1];
+        } else if (action == "PREPEND") {
+            element.insert(0, call.args[1]);
+        } else if (action == "TOLOWER" || action == "TOUPPER") {
+            bool lower = action == "TOLOWER";
+            for (auto& c : element) {
+                auto byte = static_cast<unsigned char>(c);
+                c = static_cast<char>(lower ? std::tolower(byte) : std::toupper(byte));
+            }
+        } else if (action == "STRIP") {
+            auto first = element.find_first_not_of(" \t\r\n");
+            auto last = element.find_last_not_of(" \t\r\n");
+            element = first == std::string::npos ? std::string()
+                                                 : element.substr(first, last - first + 1);
+        } else if (action == "GENEX_STRIP") {
+            element = value_helpers::strip_generator_expressions(element);
+        } else {
+            std::string replaced;
+            std::cmatch last;
+            replacement->replace_all(element, *replace, replaced, last);
+            element = std::move(replaced);
+        }
+    }
+
+    if (output) {
+        call.set(call.args[*output], std::move(copy), confidence);
+    }
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> list_reverse(const Call& call) {
+    auto& elements = call.modify();
+    std::reverse(elements.begin(), elements.end());
+    return Ok<AnalysisError>();
+}
+
+constexpr parser::KeywordSchema<3> SORT_SCHEMA({{
+    {"COMPARE", parser::KeywordKind::OneValue},
+    {"CASE", parser::KeywordKind::OneValue},
+    {"ORDER", parser::KeywordKind::OneValue},
+}});
+
+Result<void, AnalysisError> list_sort(const Call& call) {
+    auto parsed = SORT_SCHEMA.partition(
+        call.args.size(), [&](size_t i) -> std::string_view { return call.args[i]; });
+    if (!parsed.positional().empty()) {
+        return call.fail("has unexpected arguments");
+    }
+    auto option = [&](std::string_view keyword) {
+        auto position = parsed.value(SORT_SCHEMA.slot(keyword));
+        return position ? std::string_view(call.args[*position]) : std::string_view();
+    };
+
+    SortOrder order;
+    auto compare = option("COMPARE");
+    order.basename = compare == "FILE_BASENAME";
+    order.natural = compare == "NATURAL";
+    if (!compare.empty() && compare != "STRING" && !order.basename && !order.natural) {
+        return call.fail(fmt::format("has an unknown COMPARE {}", compare));
+    }
+    auto case_option = option("CASE");
+    order.fold_case = case_option == "INSENSITIVE";
+    if (!case_option.empty() && case_option != "SENSITIVE" && !order.fold_case) {
+        return call.fail(fmt::format("has an unknown CASE {}", case_option));
+    }
+    auto order_option = option("ORDER");
+    order.descending = order_option == "DESCENDING";
+    if (!order_option.empty() && order_option != "ASCENDING" && !order.descending) {
+        return call.fail(fmt::format("has an unknown ORDER {}", order_option));
+    }
+
+    auto& elements = call.modify();
+    std::stable_sort(elements.begin(), elements.end(),
+                     [&](const std::string& a, const std::string& b) {
+                         return order.descending ? compare_elements(b, a, order) < 0
+                                                 : compare_elements(a, b, order) < 0;
+                     });
+    return Ok<AnalysisError>();
+}
+
+using Handler = Result<void, AnalysisError> (*)(const Call&);
+
+constexpr std::array<std::pair<std::string_view, Handler>, 17> subcommands = {{
+    {"APPEND", list_append},
+    {"PREPEND", list_prepend},
+    {"INSERT", list_insert},
+    {"LENGTH", list_length},
+    {"GET", list_get},
+    {"JOIN", list_join},
+    {"SUBLIST", list_sublist},
+    {"FIND", list_find},
+    {"POP_BACK", list_pop_back},
+    {"POP_FRONT", list_pop_front},
+    {"REMOVE_ITEM", list_remove_item},
+    {"REMOVE_AT", list_remove_at},
+    {"REMOVE_DUPLICATES", list_remove_duplicates},
+    {"FILTER", list_filter},
+    {"TRANSFORM", list_transform},
+    {"REVERSE", list_reverse},
+    {"SORT", list_sort},
+}};
+
+} // namespace
+
+Result<void, AnalysisError> ListCommand::evaluate(EvaluationContext& context,
+                                                  const std::vector<std::string>& args,
+                                                  Confidence confidence) {
+    if (args.size() < 2) {
+        return Result<void, AnalysisError>::error(
+            AnalysisError("list() requires a subcommand and a list"));
+    }
+    auto handler = std::find_if(subcommands.begin(), subcommands.end(),
+                                [&](const auto& entry) { return entry.first == args[0]; });
+    if (handler == subcommands.end()) {
+        return Result<void, AnalysisError>::error(
+            AnalysisError(fmt::format("list() has an unknown subcommand {}", args[0])));
+    }
+    Call call{context, args[0], args[1], std::span<const std::string>(args).subspan(2),
+              confidence};
+    LOG_TRACE("list({} {}) with {} arguments", args[0], args[1], call.args.size());
+    return handler->second(call);
+}
+
+} // namespace finch::analyzer
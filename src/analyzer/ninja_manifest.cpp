@@ -0,0 +1,701 @@
+#include <algorithm>
+#include <cstring>
+#include <finch/analyzer/compile_database.hpp>
+#include <finch/analyzer/ninja_manifest.hpp>
+#include <finch/core/logging.hpp>
+#include <fmt/format.h>
+#include <unordered_map>
+
+namespace finch::analyzer {
+
+namespace fs = std::filesystem;
+
+struct NinjaManifest::Scope {
+    const Scope* parent = nullptr;
+    std::unordered_map<std::string_view, std::string_view> variables;
+    std::unordered_map<std::string_view, const Rule*> rules;
+
+    [[nodiscard]] std::string_view lookup(std::string_view name) const {
+        for (const Scope* scope = this; scope != nullptr; scope = scope->parent) {
+            auto it = scope->variables.find(name);
+            if (it != scope->variables.end()) {
+                return it->second;
+            }
+        }
+        return {};
+    }
+
+    [[nodiscard]] const Rule* find_rule(std::string_view name) const {
+        for (const Scope* scope = this; scope != nullptr; scope = scope->parent) {
+            auto it = scope->rules.find(name);
+            if (it != scope->rules.end()) {
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+namespace {
+
+bool is_variable_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '_' || c == '-';
+}
+
+bool is_identifier_char(char c) {
+    return is_variable_char(c) || c == '.';
+}
+
+// Expand $-escapes and variable references in raw manifest text. lookup(name,
+// out) appends the value of a variable to out.
+template <typename Lookup>
+void expand_into(std::string_view raw, std::string& out, Lookup&& lookup) {
+    for (size_t i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (c != '$' || i + 1 == raw.size()) {
+            out += c;
+            continue;
+        }
+        char next = raw[++i];
+        if (next == '$' || next == ' ' || next == ':') {
+            out += next;
+        } else if (next == '\n' || next == '\r') {
+            // Line continuation: drop the newline and the next line's indent
+            if (next == '\r' && i + 1 < raw.size() && raw[i + 1] == '\n') {
+                ++i;
+            }
+            while (i + 1 < raw.size() && raw[i + 1] == ' ') {
+                ++i;
+            }
+        } else if (next == '{') {
+            auto close = raw.find('}', i + 1);
+            if (close == std::string_view::npos) {
+                close = raw.size();
+            }
+            lookup(raw.substr(i + 1, close - i - 1), out);
+            i = close;
+        } else if (is_variable_char(next)) {
+            size_t end = i;
+            while (end < raw.size() && is_variable_char(raw[end])) {
+                ++end;
+            }
+            lookup(raw.substr(i, end - i), out);
+            i = end - 1;
+        } else {
+            out += '$';
+            out += next;
+        }
+    }
+}
+
+// Join paths the way ninja substitutes $in and $out into a shell command
+void append_paths(std::string& out, const std::vector<std::string_view>& paths, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (i > 0) {
+            out += ' ';
+        }
+        std::string_view path = paths[i];
+        if (path.find_first_of(" \"'$&;|<>()") == std::string_view::npos) {
+            out += path;
+        } else {
+            out += '\'';
+            for (char c : path) {
+                if (c == '\'') {
+                    out += "'\\''";
+                } else {
+                    out += c;
+                }
+            }
+            out += '\'';
+        }
+    }
+}
+
+} // namespace
+
+// Single-pass recursive-descent parser over one mapped file at a time
+class NinjaManifest::Parser {
+  public:
+    explicit Parser(NinjaManifest& manifest) : manifest_(manifest) {}
+
+    Result<void, ParseError> parse(std::string_view text, std::string_view filename, Scope* scope) {
+        std::string_view saved_text = text_;
+        std::string_view saved_filename = filename_;
+        size_t saved_pos = pos_;
+        text_ = text;
+        filename_ = filename;
+        pos_ = 0;
+
+        auto result = parse_statements(scope);
+
+        text_ = saved_text;
+        filename_ = saved_filename;
+        pos_ = saved_pos;
+        return result;
+    }
+
+  private:
+    Result<void, ParseError> parse_statements(Scope* scope) {
+        while (pos_ < text_.size()) {
+            size_t indent = skip_indent();
+            if (skip_blank_or_comment()) {
+                continue;
+            }
+            if (indent > 0) {
+                return failure("unexpected indentation");
+            }
+
+            std::string_view keyword = read_identifier();
+            if (keyword.empty()) {
+                return failure("expected a declaration");
+            }
+            Result<void, ParseError> status;
+            if (keyword == "build") {
+                status = parse_edge(scope);
+            } else if (keyword == "rule") {
+                status = parse_rule(scope);
+            } else if (keyword == "include" || keyword == "subninja") {
+                status = parse_include(scope, keyword == "subninja");
+            } else if (keyword == "pool") {
+                skip_spaces();
+                read_identifier();
+                status = finish_line();
+                if (status.has_value()) {
+                    std::vector<Binding> ignored;
+                    status = parse_bindings(ignored, nullptr);
+                }
+            } else if (keyword == "default") {
+                read_raw(false);
+                status = finish_line();
+            } else {
+                std::string_view value;
+                status = parse_assignment(value, scope);
+                if (status.has_value()) {
+                    scope->variables[keyword] = value;
+                }
+            }
+            if (!status.has_value()) {
+                return status;
+            }
+        }
+        return Result<void, ParseError>();
+    }
+
+    Result<void, ParseError> parse_rule(Scope* scope) {
+        skip_spaces();
+        std::string_view name = read_identifier();
+        if (name.empty()) {
+            return failure("expected a rule name");
+        }
+        auto status = finish_line();
+        if (!status.has_value()) {
+            return status;
+        }
+
+        auto rule = std::make_unique<Rule>();
+        rule->name = name;
+        status = parse_bindings(rule->bindings, nullptr);
+        if (!status.has_value()) {
+            return status;
+        }
+        if (!scope->rules.emplace(name, rule.get()).second) {
+            return failure(fmt::format("duplicate rule '{}'", name));
+        }
+        manifest_.rules_.push_back(std::move(rule));
+        return status;
+    }
+
+    Result<void, ParseError> parse_edge(Scope* scope) {
+        Edge edge;
+        edge.scope = scope;
+
+        // outputs [| implicit outputs] : rule inputs [| implicit] [|| order-only] [|@ validations]
+        bool implicit = false;
+        for (;;) {
+            skip_spaces();
+            if (peek() == ':') {
+                ++pos_;
+                break;
+            }
+            if (peek() == '|') {
+                ++pos_;
+                implicit = true;
+                continue;
+            }
+            std::string_view raw = read_raw(true);
+            if (raw.empty()) {
+                return failure("expected ':' after build outputs");
+            }
+            edge.outputs.push_back(intern_path(raw, scope));
+            if (!implicit) {
+                ++edge.explicit_outputs;
+            }
+        }
+
+        skip_spaces();
+        std::string_view rule_name = read_identifier();
+        edge.rule = scope->find_rule(rule_name);
+        if (edge.rule == nullptr) {
+            return failure(fmt::format("unknown build rule '{}'", rule_name));
+        }
+
+        bool explicit_inputs = true;
+        bool validations = false;
+        for (;;) {
+            skip_spaces();
+            if (peek() == '|') {
+                ++pos_;
+                if (peek() == '|') {
+                    ++pos_;
+                } else if (peek() == '@') {
+                    ++pos_;
+                    validations = true;
+                }
+                explicit_inputs = false;
+                continue;
+            }
+            std::string_view raw = read_raw(true);
+            if (raw.empty()) {
+                break;
+            }
+            if (validations) {
+                continue; // Validation edges do not feed the build
+            }
+            edge.inputs.push_back(intern_path(raw, scope));
+            if (explicit_inputs) {
+                ++edge.explicit_inputs;
+            }
+        }
+
+        auto status = finish_line();
+        if (status.has_value()) {
+            status = parse_bindings(edge.bindings, scope);
+        }
+        if (status.has_value()) {
+            manifest_.edges_.push_back(std::move(edge));
+        }
+        return status;
+    }
+
+    Result<void, ParseError> parse_include(Scope* scope, bool new_scope) {
+        skip_spaces();
+        std::string_view raw = read_raw(true);
+        if (raw.empty()) {
+            return failure("expected a path");
+        }
+        auto status = finish_line();
+        if (!status.has_value()) {
+            return status;
+        }
+
+        fs::path path(expand(raw, scope));
+        if (path.is_relative()) {
+            path = manifest_.build_directory_ / path;
+        }
+        auto file = MappedFile::open(path);
+        if (!file.has_value()) {
+            return failure(fmt::format("cannot read '{}'", path.string()));
+        }
+        auto mapped = std::make_unique<MappedFile>(std::move(file.value()));
+        std::string_view text = mapped->view();
+        manifest_.files_.push_back(std::move(mapped));
+
+        Scope* target = scope;
+        if (new_scope) {
+            auto child = std::make_unique<Scope>();
+            child->parent = scope;
+            target = child.get();
+            manifest_.scopes_.push_back(std::move(child));
+        }
+        std::string filename = path.filename().string();
+        return parse(text, manifest_.own(std::move(filename)), target);
+    }
+
+    // "= value" after a variable name, expanded in scope
+    Result<void, ParseError> parse_assignment(std::string_view& value, const Scope* scope) {
+        skip_spaces();
+        if (peek() != '=') {
+            return failure("expected '='");
+        }
+        ++pos_;
+        skip_spaces();
+        std::string_view raw = read_raw(false);
+        value = scope != nullptr ? expand(raw, scope) : raw;
+        return finish_line();
+    }
+
+    // Indented "name = value" lines; values are expanded in scope, or kept raw
+    // when scope is null (rule bindings are evaluated per edge)
+    Result<void, ParseError> parse_bindings(std::vector<Binding>& bindings, const Scope* scope) {
+        for (;;) {
+            size_t line_start = pos_;
+            size_t indent = skip_indent();
+            if (indent > 0 && skip_blank_or_comment()) {
+                continue;
+            }
+            if (indent == 0 || pos_ >= text_.size()) {
+                pos_ = line_start;
+                return Result<void, ParseError>();
+            }
+            std::string_view name = read_identifier();
+            if (name.empty()) {
+                return failure("expected a variable name");
+            }
+            std::string_view value;
+            auto status = parse_assignment(value, scope);
+            if (!status.has_value()) {
+                return status;
+            }
+            bindings.emplace_back(name, value);
+        }
+    }
+
+    std::string_view expand(std::string_view raw, const Scope* scope) {
+        if (raw.find('$') == std::string_view::npos) {
+            return raw;
+        }
+        std::string out;
+        expand_into(raw, out, [scope](std::string_view name, std::string& into) {
+            into += scope->lookup(name);
+        });
+        return manifest_.own(std::move(out));
+    }
+
+    std::string_view intern_path(std::string_view raw, const Scope* scope) {
+        return *manifest_.paths_.insert(expand(raw, scope)).first;
+    }
+
+    // Raw text up to the end of the line (or of a path), escapes left intact
+    std::string_view read_raw(bool path) {
+        size_t start = pos_;
+        if (!path) {
+            // Fast path: most values are a plain run of text up to '\n'
+            const char* begin = text_.data() + pos_;
+            size_t remaining = text_.size() - pos_;
+            const void* newline = std::memchr(begin, '\n', remaining);
+            size_t line = newline != nullptr
+                              ? static_cast<size_t>(static_cast<const char*>(newline) - begin)
+                              : remaining;
+            if (std::memchr(begin, '$', line) == nullptr) {
+                pos_ += line;
+                return trim_cr(text_.substr(start, line));
+            }
+        }
+        while (pos_ < text_.size()) {
+            char c = text_[pos_];
+            if (c == '\n' || (path && (c == ' ' || c == ':' || c == '|'))) {
+                break;
+            }
+            if (c == '$' && pos_ + 1 < text_.size()) {
+                ++pos_;
+            }
+            ++pos_;
+        }
+        return trim_cr(text_.substr(start, pos_ - start));
+    }
+
+    static std::string_view trim_cr(std::string_view value) {
+        return !value.empty() && value.back() == '\r' ? value.substr(0, value.size() - 1) : value;
+    }
+
+    std::string_view read_identifier() {
+        size_t start = pos_;
+        while (pos_ < text_.size() && is_identifier_char(text_[pos_])) {
+            ++pos_;
+        }
+        return text_.substr(start, pos_ - start);
+    }
+
+    size_t skip_indent() {
+        size_t start = pos_;
+        while (pos_ < text_.size() && text_[pos_] == ' ') {
+            ++pos_;
+        }
+        return pos_ - start;
+    }
+
+    // Spaces and $-newline continuations inside a line
+    void skip_spaces() {
+        while (pos_ < text_.size()) {
+            if (text_[pos_] == ' ') {
+                ++pos_;
+            } else if (text_[pos_] == '$' && pos_ + 1 < text_.size() &&
+                       (text_[pos_ + 1] == '\n' || text_[pos_ + 1] == '\r')) {
+                // "$\n" or "$\r\n"; a "$\r" that ends the text ends the line
+                pos_ = std::min(pos_ + (text_[pos_ + 1] == '\r' ? 3U : 2U), text_.size());
+            } else {
+                break;
+            }
+        }
+    }
+
+    // Consume the rest of an empty or comment line; false if the line has content
+    bool skip_blank_or_comment() {
+        if (pos_ >= text_.size()) {
+            return true;
+        }
+        char c = text_[pos_];
+        if (c == '#') {
+            auto newline = text_.find('\n', pos_);
+            pos_ = newline == std::string_view::npos ? text_.size() : newline + 1;
+            return true;
+        }
+        if (c == '\n' || c == '\r') {
+            pos_ += c == '\r' && pos_ + 1 < text_.size() && text_[pos_ + 1] == '\n' ? 2U : 1U;
+            return true;
+        }
+        return false;
+    }
+
+    Result<void, ParseError> finish_line() {
+        skip_spaces();
+        if (pos_ < text_.size() && text_[pos_] == '\r') {
+            ++pos_;
+        }
+        if (pos_ < text_.size() && text_[pos_] != '\n') {
+            return failure(fmt::format("unexpected '{}'", text_[pos_]));
+        }
+        ++pos_;
+        return Result<void, ParseError>();
+    }
+
+    char peek() const {
+        return pos_ < text_.size() ? text_[pos_] : '\n';
+    }
+
+    Result<void, ParseError> failure(const std::string& message) const {
+        auto end = text_.begin() + static_cast<std::ptrdiff_t>(std::min(pos_, text_.size()));
+        size_t line = 1 + static_cast<size_t>(std::count(text_.begin(), end, '\n'));
+        return Result<void, ParseError>::error(
+            ParseError(ParseError::Category::InvalidSyntax,
+                       fmt::format("{}:{}: {}", filename_, line, message)));
+    }
+
+    NinjaManifest& manifest_;
+    std::string_view text_;
+    std::string_view filename_;
+    size_t pos_ = 0;
+};
+
+NinjaManifest::NinjaManifest() {
+    auto root = std::make_unique<Scope>();
+    auto phony = std::make_unique<Rule>();
+    phony->name = "phony";
+    root->rules.emplace(phony->name, phony.get());
+    rules_.push_back(std::move(phony));
+    scopes_.push_back(std::move(root));
+}
+
+NinjaManifest::NinjaManifest(NinjaManifest&&) noexcept = default;
+NinjaManifest& NinjaManifest::operator=(NinjaManifest&&) noexcept = default;
+NinjaManifest::~NinjaManifest() = default;
+
+std::string_view NinjaManifest::own(std::string value) {
+    return owned_.emplace_front(std::move(value));
+}
+
+Result<NinjaManifest, ParseError> NinjaManifest::load(const fs::path& path) {
+    auto file = MappedFile::open(path);
+    if (!file.has_value()) {
+        return Result<NinjaManifest, ParseError>(
+            std::in_place_index<1>,
+            ParseError(ParseError::Category::UnexpectedEOF,
+                       fmt::format("cannot read '{}'", path.string())));
+    }
+
+    NinjaManifest manifest;
+    manifest.build_directory_ = path.parent_path();
+    auto mapped = std::make_unique<MappedFile>(std::move(file.value()));
+    std::string_view text = mapped->view();
+    manifest.files_.push_back(std::move(mapped));
+
+    Parser parser(manifest);
+    std::string filename = path.filename().string();
+    auto status =
+        parser.parse(text, manifest.own(std::move(filename)), manifest.scopes_.front().get());
+    if (!status.has_value()) {
+        return Result<NinjaManifest, ParseError>(std::in_place_index<1>, status.error());
+    }
+    return Result<NinjaManifest, ParseError>(std::move(manifest));
+}
+
+Result<NinjaManifest, ParseError> NinjaManifest::parse(std::string_view text,
+                                                       const fs::path& build_directory) {
+    NinjaManifest manifest;
+    manifest.build_directory_ = build_directory;
+
+    Parser parser(manifest);
+    auto status = parser.parse(text, "build.ninja", manifest.scopes_.front().get());
+    if (!status.has_value()) {
+        return Result<NinjaManifest, ParseError>(std::in_place_index<1>, status.error());
+    }
+    return Result<NinjaManifest, ParseError>(std::move(manifest));
+}
+
+namespace {
+
+void append_edge_variable(const NinjaManifest::Edge& edge, std::string_view name,
+                          std::string& out, int depth) {
+    if (name == "in") {
+        append_paths(out, edge.inputs, edge.explicit_inputs);
+        return;
+    }
+    if (name == "out") {
+        append_paths(out, edge.outputs, edge.explicit_outputs);
+        return;
+    }
+    // Later bindings shadow earlier ones
+    for (auto it = edge.bindings.rbegin(); it != edge.bindings.rend(); ++it) {
+        if (it->first == name) {
+            out += it->second;
+            return;
+        }
+    }
+    if (depth < 16) { // Ninja rejects cycles; just stop recursing
+        for (const auto& [key, raw] : edge.rule->bindings) {
+            if (key == name) {
+                expand_into(raw, out, [&](std::string_view inner, std::string& into) {
+                    append_edge_variable(edge, inner, into, depth + 1);
+                });
+                return;
+            }
+        }
+    }
+    out += edge.scope->lookup(name);
+}
+
+} // namespace
+
+std::string NinjaManifest::evaluate(const Edge& edge, std::string_view variable) const {
+    std::string out;
+    append_edge_variable(edge, variable, out, 0);
+    return out;
+}
+
+std::string_view NinjaManifest::variable(std::string_view name) const {
+    return scopes_.front()->lookup(name);
+}
+
+namespace {
+
+// CMake names its per-target rules <LANG>_COMPILER__<target>_<config> and
+// <LANG>_<KIND>_LINKER__<target>_<config>
+bool is_compile_rule(std::string_view rule) {
+    return rule.find("_COMPILER__") != std::string_view::npos;
+}
+
+bool is_link_rule(std::string_view rule) {
+    return rule.find("_LINKER__") != std::string_view::npos;
+}
+
+Target::Type link_type(std::string_view rule) {
+    if (rule.find("_EXECUTABLE_LINKER__") != std::string_view::npos) {
+        return Target::Type::ExecutableTarget;
+    }
+    if (rule.find("_SHARED_LIBRARY_LINKER__") != std::string_view::npos ||
+        rule.find("_MODULE_LIBRARY_LINKER__") != std::string_view::npos) {
+        return Target::Type::SharedLibrary;
+    }
+    return Target::Type::StaticLibrary;
+}
+
+// "sub/CMakeFiles/core.dir" -> "core"
+std::string target_name_of(std::string_view object_dir, std::string_view output) {
+    auto cmake_files = object_dir.rfind("CMakeFiles/");
+    if (cmake_files != std::string_view::npos && object_dir.ends_with(".dir")) {
+        auto start = cmake_files + std::strlen("CMakeFiles/");
+        return std::string(object_dir.substr(start, object_dir.size() - 4 - start));
+    }
+    return fs::path(output).stem().string();
+}
+
+} // namespace
+
+NinjaManifestAnalyzer::NinjaManifestAnalyzer(size_t max_threads) : max_threads_(max_threads) {}
+
+Result<ProjectAnalysis, AnalysisError>
+NinjaManifestAnalyzer::analyze(const fs::path& manifest) const {
+    auto loaded = NinjaManifest::load(manifest);
+    if (!loaded.has_value()) {
+        return Result<ProjectAnalysis, AnalysisError>(
+            std::in_place_index<1>,
+            AnalysisError(AnalysisError::Category::InvalidConfiguration,
+                          loaded.error().message()));
+    }
+    return Result<ProjectAnalysis, AnalysisError>(analyze(loaded.value()));
+}
+
+ProjectAnalysis NinjaManifestAnalyzer::analyze(const NinjaManifest& manifest) const {
+    const auto& edges = manifest.edges();
+    std::vector<const NinjaManifest::Edge*> compile_edges;
+    std::vector<const NinjaManifest::Edge*> link_edges;
+    for (const auto& edge : edges) {
+        if (edge.explicit_outputs == 0) {
+            continue;
+        }
+        if (is_compile_rule(edge.rule->name) && edge.explicit_inputs > 0) {
+            compile_edges.push_back(&edge);
+        } else if (is_link_rule(edge.rule->name)) {
+            link_edges.push_back(&edge);
+        }
+    }
+
+    // Expand every compile edge into the command ninja would run and group
+    // those exactly like compile_commands.json entries
+    std::string build_directory = manifest.build_directory().generic_string();
+    std::vector<std::string> commands(compile_edges.size());
+    parallel_for(
+        compile_edges.size(),
+        [&](size_t i) { commands[i] = manifest.evaluate(*compile_edges[i], "command"); },
+        max_threads_);
+
+    std::vector<CompileDatabase::Entry> entries(compile_edges.size());
+    for (size_t i = 0; i < compile_edges.size(); ++i) {
+        entries[i].directory = build_directory;
+        entries[i].file = compile_edges[i]->inputs.front();
+        entries[i].output = compile_edges[i]->outputs.front();
+        entries[i].command = commands[i];
+    }
+    ProjectAnalysis analysis = CompileDatabaseAnalyzer(max_threads_).analyze(entries);
+
+    // Link edges carry what compile commands cannot: target kinds and link inputs
+    std::unordered_map<std::string_view, std::string> target_by_output;
+    std::vector<std::string> link_names;
+    for (const auto* edge : link_edges) {
+        link_names.push_back(
+            target_name_of(manifest.evaluate(*edge, "OBJECT_DIR"), edge->outputs.front()));
+        target_by_output.emplace(edge->outputs.front(), link_names.back());
+    }
+
+    std::unordered_map<std::string_view, Target*> targets_by_name;
+    for (auto& target : analysis.targets) {
+        targets_by_name.emplace(target.name, &target);
+    }
+    for (size_t i = 0; i < link_edges.size(); ++i) {
+        auto it = targets_by_name.find(link_names[i]);
+        if (it == targets_by_name.end()) {
+            continue;
+        }
+        Target& target = *it->second;
+        target.type = link_type(link_edges[i]->rule->name);
+        target.confidence = Target::Confidence::Certain;
+
+        auto libraries = manifest.evaluate(*link_edges[i], "LINK_LIBRARIES");
+        for (auto& item : CompileDatabase::tokenize_command(libraries)) {
+            if (auto dependency = target_by_output.find(item);
+                dependency != target_by_output.end()) {
+                target.link_libraries.push_back(dependency->second);
+            } else if (item.starts_with("-l") ||
+                       (fs::path(item).is_absolute() && !item.starts_with(build_directory))) {
+                target.link_flags.push_back(std::move(item));
+            }
+        }
+    }
+
+    LOG_DEBUG("Derived {} targets from {} ninja edges ({} interned paths)", analysis.targets.size(),
+              edges.size(), manifest.interned_paths());
+    return analysis;
+}
+
+} // namespace finch::analyzer
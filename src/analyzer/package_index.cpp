@@ -0,0 +1,572 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <finch/analyzer/package_index.hpp>
+#include <finch/core/cache_directory.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/core/mapped_file.hpp>
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <unordered_set>
+
+namespace finch::analyzer {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using json = nlohmann::json;
+
+constexpr int cache_format_version = 2;
+
+std::string lowercase(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+std::string_view trim(std::string_view text) {
+    auto begin = text.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    auto end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+// Last write time and, for a file, size folded into one value
+uint64_t file_stamp(const fs::path& path) {
+    std::error_code ec;
+    auto time = fs::last_write_time(path, ec).time_since_epoch().count();
+    auto size = fs::is_regular_file(path, ec) ? fs::file_size(path, ec) : 0;
+    return (static_cast<uint64_t>(time) * 1099511628211ULL) ^ (ec ? 0 : size);
+}
+
+// Stamp of a scanned path, or -1 when it does not exist. Rewriting a file in
+// place leaves its directory's time alone, so a directory also sums the
+// stamps of the .cmake files directly in it.
+int64_t stamp_of(const fs::path& path) {
+    std::error_code ec;
+    auto status = fs::status(path, ec);
+    if (!fs::exists(status)) {
+        return -1;
+    }
+    uint64_t stamp = file_stamp(path);
+    if (fs::is_directory(status)) {
+        for (const auto& entry : fs::directory_iterator(path, ec)) {
+            if (entry.path().extension() == ".cmake" && entry.is_regular_file(ec)) {
+                stamp += file_stamp(entry.path());
+            }
+        }
+    }
+    return static_cast<int64_t>(stamp);
+}
+
+void dedupe(std::vector<std::string>& items) {
+    std::unordered_set<std::string> seen;
+    std::erase_if(items, [&](const std::string& item) { return !seen.insert(item).second; });
+}
+
+template <typename Fn> void for_each_line(std::string_view text, Fn&& fn) {
+    while (!text.empty()) {
+        auto end = text.find('\n');
+        fn(text.substr(0, end));
+        text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+    }
+}
+
+void replace_all(std::string& text, std::string_view from, std::string_view to) {
+    for (size_t pos = text.find(from); pos != std::string::npos;
+         pos = text.find(from, pos + to.size())) {
+        text.replace(pos, from.size(), to);
+    }
+}
+
+// The quoted value following key on a line, e.g. key "value"
+std::optional<std::string_view> quoted_after(std::string_view line, std::string_view key) {
+    auto pos = line.find(key);
+    if (pos == std::string_view::npos) {
+        return std::nullopt;
+    }
+    pos = line.find_first_not_of(" \t", pos + key.size());
+    if (pos == std::string_view::npos || line[pos] != '"') {
+        return std::nullopt;
+    }
+    auto end = line.find('"', pos + 1);
+    if (end == std::string_view::npos) {
+        return std::nullopt;
+    }
+    return line.substr(pos + 1, end - pos - 1);
+}
+
+// Where a prefix keeps package files. A search root that does not exist yet
+// is still stamped, so installing the first package invalidates the cache.
+struct SearchRoots {
+    std::vector<fs::path> cmake;
+    std::vector<fs::path> pkg_config;
+};
+
+SearchRoots search_roots(const fs::path& prefix) {
+    SearchRoots roots;
+    for (const char* lib : {"lib", "lib64", "share"}) {
+        roots.cmake.push_back(prefix / lib / "cmake");
+        roots.pkg_config.push_back(prefix / lib / "pkgconfig");
+    }
+
+    // Multiarch layouts such as lib/x86_64-linux-gnu/cmake
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(prefix / "lib", ec)) {
+        auto name = entry.path().filename().string();
+        if (!entry.is_directory(ec) || name == "cmake" || name == "pkgconfig" ||
+            name.find('-') == std::string::npos) {
+            continue;
+        }
+        if (fs::is_directory(entry.path() / "cmake", ec)) {
+            roots.cmake.push_back(entry.path() / "cmake");
+        }
+        if (fs::is_directory(entry.path() / "pkgconfig", ec)) {
+            roots.pkg_config.push_back(entry.path() / "pkgconfig");
+        }
+    }
+    return roots;
+}
+
+struct Candidate {
+    fs::path prefix;
+    fs::path path; // Package configuration directory or .pc file
+    ExternalPackage::Source source;
+};
+
+// Imported targets, their include directories and library files, as written
+// by install(EXPORT) into <Name>Targets.cmake and <Name>Targets-<config>.cmake
+void scan_cmake_file(std::string_view text, const std::string& prefix, ExternalPackage& package) {
+    auto resolve = [&](std::string_view value, std::vector<std::string>& out) {
+        size_t start = 0;
+        while (start <= value.size()) {
+            auto end = value.find(';', start);
+            auto item = value.substr(start, end == std::string_view::npos ? end : end - start);
+            // Generator expressions depend on the consumer; skip them
+            if (!item.empty() && item.find("$<") == std::string_view::npos) {
+                std::string resolved(item);
+                replace_all(resolved, "${_IMPORT_PREFIX}", prefix);
+                replace_all(resolved, "${PACKAGE_PREFIX_DIR}", prefix);
+                out.push_back(std::move(resolved));
+            }
+            if (end == std::string_view::npos) {
+                break;
+            }
+            start = end + 1;
+        }
+    };
+
+    for_each_line(text, [&](std::string_view raw) {
+        auto line = trim(raw);
+        if (line.starts_with("add_library(") && line.find(" IMPORTED") != std::string_view::npos) {
+            auto name = line.substr(12);
+            name = name.substr(0, name.find_first_of(" \t)"));
+            if (name.find("::") != std::string_view::npos) {
+                package.imported_targets.emplace_back(name);
+            }
+        } else if (auto includes = quoted_after(line, "INTERFACE_INCLUDE_DIRECTORIES")) {
+            resolve(*includes, package.include_directories);
+        } else if (auto links = quoted_after(line, "INTERFACE_LINK_LIBRARIES")) {
+            std::vector<std::string> items;
+            resolve(*links, items);
+            for (auto& item : items) {
+                if (item.find("::") != std::string::npos) {
+                    package.dependencies.push_back(std::move(item));
+                }
+            }
+        } else if (line.find("IMPORTED_LOCATION") != std::string_view::npos) {
+            // IMPORTED_LOCATION or IMPORTED_LOCATION_<CONFIG>, one per configuration
+            auto key = line.find("IMPORTED_LOCATION");
+            auto value_start = line.find_first_of(" \t", key);
+            if (value_start != std::string_view::npos) {
+                if (auto location = quoted_after(line.substr(value_start), "")) {
+                    resolve(*location, package.libraries);
+                }
+            }
+        }
+    });
+}
+
+std::optional<ExternalPackage> parse_config_directory(const Candidate& candidate) {
+    std::error_code ec;
+    std::string name;
+    std::string dash_name;
+    fs::path version_file;
+    std::vector<fs::path> cmake_files;
+    for (const auto& entry : fs::directory_iterator(candidate.path, ec)) {
+        auto file = entry.path().filename().string();
+        if (!file.ends_with(".cmake") || !entry.is_regular_file(ec)) {
+            continue;
+        }
+        cmake_files.push_back(entry.path());
+        if (file.ends_with("ConfigVersion.cmake") || file.ends_with("-config-version.cmake")) {
+            version_file = entry.path();
+        } else if (file.ends_with("Config.cmake")) {
+            name = file.substr(0, file.size() - 12);
+        } else if (file.ends_with("-config.cmake")) {
+            dash_name = file.substr(0, file.size() - 13);
+        }
+    }
+    if (name.empty()) {
+        name = std::move(dash_name);
+    }
+    if (name.empty()) {
+        return std::nullopt;
+    }
+
+    ExternalPackage package;
+    package.name = std::move(name);
+    package.source = ExternalPackage::Source::CMakeConfig;
+    package.prefix = candidate.prefix;
+    package.location = candidate.path;
+
+    // Files are read in a fixed order so the index is reproducible
+    std::sort(cmake_files.begin(), cmake_files.end());
+    auto prefix = candidate.prefix.generic_string();
+    for (const auto& path : cmake_files) {
+        auto file = MappedFile::open(path);
+        if (!file.has_value()) {
+            continue;
+        }
+        if (path == version_file) {
+            for_each_line(file.value().view(), [&](std::string_view line) {
+                if (auto version = quoted_after(line, "set(PACKAGE_VERSION");
+                    version && package.version.empty()) {
+                    package.version = *version;
+                }
+            });
+        } else {
+            scan_cmake_file(file.value().view(), prefix, package);
+        }
+    }
+
+    dedupe(package.imported_targets);
+    dedupe(package.include_directories);
+    dedupe(package.libraries);
+    dedupe(package.dependencies);
+    std::erase_if(package.dependencies, [&](const std::string& dependency) {
+        return std::find(package.imported_targets.begin(), package.imported_targets.end(),
+                         dependency) != package.imported_targets.end();
+    });
+    return package;
+}
+
+std::vector<std::string> split_whitespace(std::string_view text) {
+    std::vector<std::string> words;
+    size_t pos = 0;
+    while ((pos = text.find_first_not_of(" \t", pos)) != std::string_view::npos) {
+        auto end = text.find_first_of(" \t", pos);
+        words.emplace_back(text.substr(pos, end == std::string_view::npos ? end : end - pos));
+        pos = end;
+    }
+    return words;
+}
+
+std::optional<ExternalPackage> parse_pc_file(const Candidate& candidate) {
+    auto file = MappedFile::open(candidate.path);
+    if (!file.has_value()) {
+        return std::nullopt;
+    }
+
+    // pcfiledir is predefined; every other variable is defined before use
+    std::unordered_map<std::string, std::string> variables = {
+        {"pcfiledir", candidate.path.parent_path().generic_string()}};
+    auto expand = [&](std::string_view value) {
+        std::string result;
+        size_t pos = 0;
+        while (pos < value.size()) {
+            auto ref = value.find("${", pos);
+            auto close = ref == std::string_view::npos ? ref : value.find('}', ref);
+            if (close == std::string_view::npos) {
+                result.append(value.substr(pos));
+                break;
+            }
+            result.append(value.substr(pos, ref - pos));
+            if (auto it = variables.find(std::string(value.substr(ref + 2, close - ref - 2)));
+                it != variables.end()) {
+                result += it->second;
+            }
+            pos = close + 1;
+        }
+        return result;
+    };
+
+    ExternalPackage package;
+    package.name = candidate.path.stem().string();
+    package.source = ExternalPackage::Source::PkgConfig;
+    package.prefix = candidate.prefix;
+    package.location = candidate.path;
+
+    for_each_line(file.value().view(), [&](std::string_view raw) {
+        auto line = trim(raw.substr(0, raw.find('#')));
+        auto separator = line.find_first_of(":=");
+        if (separator == std::string_view::npos) {
+            return;
+        }
+        auto key = trim(line.substr(0, separator));
+        auto value = expand(trim(line.substr(separator + 1)));
+        if (line[separator] == '=') {
+            variables[std::string(key)] = std::move(value);
+            return;
+        }
+
+        auto field = lowercase(key);
+        if (field == "version") {
+            package.version = std::move(value);
+        } else if (field == "cflags") {
+            auto words = split_whitespace(value);
+            for (size_t i = 0; i < words.size(); ++i) {
+                if (words[i] == "-I" && i + 1 < words.size()) {
+                    package.include_directories.push_back(words[++i]);
+                } else if (words[i].starts_with("-I")) {
+                    package.include_directories.push_back(words[i].substr(2));
+                }
+            }
+        } else if (field == "libs") {
+            for (auto& word : split_whitespace(value)) {
+                package.libraries.push_back(std::move(word));
+            }
+        } else if (field == "requires") {
+            // "glib-2.0 >= 2.50, zlib": keep module names, drop version constraints
+            std::replace(value.begin(), value.end(), ',', ' ');
+            auto words = split_whitespace(value);
+            for (size_t i = 0; i < words.size(); ++i) {
+                if (words[i].find_first_of("<>=!") == 0) {
+                    ++i;
+                } else {
+                    package.dependencies.push_back(words[i]);
+                }
+            }
+        }
+    });
+
+    dedupe(package.include_directories);
+    dedupe(package.dependencies);
+    return package;
+}
+
+json to_json(const ExternalPackage& package) {
+    return json{
+        {"name", package.name},
+        {"version", package.version},
+        {"source", package.source == ExternalPackage::Source::PkgConfig ? "pkg-config" : "cmake"},
+        {"prefix", package.prefix.generic_string()},
+        {"location", package.location.generic_string()},
+        {"imported_targets", package.imported_targets},
+        {"include_directories", package.include_directories},
+        {"libraries", package.libraries},
+        {"dependencies", package.dependencies}};
+}
+
+ExternalPackage package_from_json(const json& object) {
+    auto strings = [&](const char* key) {
+        auto it = object.find(key);
+        return it != object.end() && it->is_array() ? it->get<std::vector<std::string>>()
+                                                    : std::vector<std::string>{};
+    };
+    ExternalPackage package;
+    package.name = object.value("name", "");
+    package.version = object.value("version", "");
+    package.source = object.value("source", "") == "pkg-config"
+                         ? ExternalPackage::Source::PkgConfig
+                         : ExternalPackage::Source::CMakeConfig;
+    package.prefix = object.value("prefix", "");
+    package.location = object.value("location", "");
+    package.imported_targets = strings("imported_targets");
+    package.include_directories = strings("include_directories");
+    package.libraries = strings("libraries");
+    package.dependencies = strings("dependencies");
+    return package;
+}
+
+std::vector<std::string> prefix_strings(const std::vector<fs::path>& prefixes) {
+    std::vector<std::string> result;
+    result.reserve(prefixes.size());
+    for (const auto& prefix : prefixes) {
+        result.push_back(prefix.lexically_normal().generic_string());
+    }
+    return result;
+}
+
+} // namespace
+
+void PackageIndex::add(ExternalPackage package) {
+    auto& by_name = package.source == ExternalPackage::Source::PkgConfig ? modules_ : configs_;
+    if (!by_name.try_emplace(lowercase(package.name), packages_.size()).second) {
+        LOG_DEBUG("Package '{}' in {} is shadowed by an earlier prefix", package.name,
+                  package.prefix.string());
+        return;
+    }
+    for (const auto& target : package.imported_targets) {
+        imported_.try_emplace(target, packages_.size());
+    }
+    packages_.push_back(std::move(package));
+}
+
+PackageIndex PackageIndex::build(const std::vector<fs::path>& prefixes, size_t max_threads) {
+    PackageIndex index;
+    index.prefixes_ = prefix_strings(prefixes);
+
+    // Listing the search roots is cheap; reading the package files is not
+    std::vector<Candidate> candidates;
+    for (const auto& prefix : prefixes) {
+        index.stamps_[(prefix / "lib").generic_string()] = stamp_of(prefix / "lib");
+        auto roots = search_roots(prefix);
+        auto list = [&](const std::vector<fs::path>& dirs, ExternalPackage::Source source) {
+            for (const auto& root : dirs) {
+                index.stamps_[root.generic_string()] = stamp_of(root);
+                std::error_code ec;
+                std::vector<fs::path> entries;
+                for (const auto& entry : fs::directory_iterator(root, ec)) {
+                    bool wanted = source == ExternalPackage::Source::CMakeConfig
+                                      ? entry.is_directory(ec)
+                                      : entry.path().extension() == ".pc";
+                    if (wanted) {
+                        entries.push_back(entry.path());
+                    }
+                }
+                std::sort(entries.begin(), entries.end());
+                for (auto& path : entries) {
+                    candidates.push_back({prefix, std::move(path), source});
+                }
+            }
+        };
+        list(roots.cmake, ExternalPackage::Source::CMakeConfig);
+        list(roots.pkg_config, ExternalPackage::Source::PkgConfig);
+    }
+
+    std::vector<std::optional<ExternalPackage>> parsed(candidates.size());
+    std::vector<int64_t> stamps(candidates.size());
+    parallel_for(
+        candidates.size(),
+        [&](size_t i) {
+            stamps[i] = stamp_of(candidates[i].path);
+            parsed[i] = candidates[i].source == ExternalPackage::Source::PkgConfig
+                            ? parse_pc_file(candidates[i])
+                            : parse_config_directory(candidates[i]);
+        },
+        max_threads);
+
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        index.stamps_[candidates[i].path.generic_string()] = stamps[i];
+        if (parsed[i]) {
+            index.add(std::move(*parsed[i]));
+        }
+    }
+
+    LOG_DEBUG("Indexed {} packages from {} candidates under {} prefixes", index.packages_.size(),
+              candidates.size(), prefixes.size());
+    return index;
+}
+
+Result<PackageIndex, IOError> PackageIndex::load(const fs::path& cache_file,
+                                                 const std::vector<fs::path>& prefixes) {
+    auto fail = [&](const std::string& reason) {
+        return Result<PackageIndex, IOError>(
+            std::in_place_index<1>,
+            IOError(fmt::format("Package index cache {}: {}", cache_file.string(), reason)));
+    };
+
+    auto file = MappedFile::open(cache_file);
+    if (!file.has_value()) {
+        return Result<PackageIndex, IOError>(std::in_place_index<1>, file.error());
+    }
+    auto text = file.value().view();
+    auto document = json::parse(text.begin(), text.end(), nullptr, false);
+    if (document.is_discarded() || !document.is_object() ||
+        document.value("format", 0) != cache_format_version) {
+        return fail("unreadable or from another version");
+    }
+
+    PackageIndex index;
+    index.prefixes_ = prefix_strings(prefixes);
+    auto cached_prefixes = document.find("prefixes");
+    if (cached_prefixes == document.end() || !cached_prefixes->is_array() ||
+        cached_prefixes->get<std::vector<std::string>>() != index.prefixes_) {
+        return fail("built for other prefixes");
+    }
+
+    auto stamps = document.find("stamps");
+    if (stamps == document.end() || !stamps->is_object()) {
+        return fail("no directory stamps");
+    }
+    for (const auto& item : stamps->items()) {
+        const auto& stamp = item.value();
+        if (!stamp.is_number_integer() || stamp.get<int64_t>() != stamp_of(item.key())) {
+            return fail(fmt::format("{} changed", item.key()));
+        }
+        index.stamps_[item.key()] = stamp.get<int64_t>();
+    }
+
+    auto packages = document.find("packages");
+    if (packages != document.end() && packages->is_array()) {
+        for (const auto& package : *packages) {
+            if (package.is_object()) {
+                index.add(package_from_json(package));
+            }
+        }
+    }
+    index.from_cache_ = true;
+    return Result<PackageIndex, IOError>(std::move(index));
+}
+
+PackageIndex PackageIndex::load_or_build(const fs::path& cache_file,
+                                         const std::vector<fs::path>& prefixes,
+                                         size_t max_threads) {
+    auto cached = load(cache_file, prefixes);
+    if (cached.has_value()) {
+        return std::move(cached.value());
+    }
+    LOG_DEBUG("Rebuilding package index: {}", cached.error().message());
+
+    auto index = build(prefixes, max_threads);
+    if (auto saved = index.save(cache_file); saved.has_error()) {
+        LOG_DEBUG("Not caching package index: {}", saved.error().message());
+    }
+    return index;
+}
+
+Result<void, IOError> PackageIndex::save(const fs::path& cache_file) const {
+    json packages = json::array();
+    for (const auto& package : packages_) {
+        packages.push_back(to_json(package));
+    }
+    json document = {{"format", cache_format_version},
+                     {"prefixes", prefixes_},
+                     {"stamps", stamps_},
+                     {"packages", std::move(packages)}};
+
+    return replace_file(cache_file, document.dump());
+}
+
+fs::path PackageIndex::default_cache_file() {
+    return cache_directory() / "package-index.json";
+}
+
+const ExternalPackage* PackageIndex::find_package(std::string_view name) const {
+    auto key = lowercase(name);
+    if (auto it = configs_.find(key); it != configs_.end()) {
+        return &packages_[it->second];
+    }
+    if (auto it = modules_.find(key); it != modules_.end()) {
+        return &packages_[it->second];
+    }
+    return nullptr;
+}
+
+const ExternalPackage* PackageIndex::find_module(std::string_view module) const {
+    auto it = modules_.find(lowercase(module));
+    return it != modules_.end() ? &packages_[it->second] : nullptr;
+}
+
+const ExternalPackage* PackageIndex::find_imported_target(std::string_view target) const {
+    auto it = imported_.find(std::string(target));
+    return it != imported_.end() ? &packages_[it->second] : nullptr;
+}
+
+} // namespace finch::analyzer
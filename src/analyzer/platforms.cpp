@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <array>
+#include <finch/analyzer/platforms.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/parser/ast/commands.hpp>
+#include <finch/parser/ast/control_flow.hpp>
+#include <finch/parser/ast/literals.hpp>
+#include <finch/parser/ast/visitor.hpp>
+#include <type_traits>
+#include <unordered_map>
+
+namespace finch::analyzer {
+
+namespace {
+
+// The variables platforms set, and each known platform's values for them
+constexpr std::array<std::string_view, 9> platform_variable_names = {
+    "WIN32", "WINDOWS", "UNIX", "APPLE", "DARWIN", "LINUX", "CMAKE_SYSTEM_NAME",
+    "CMAKE_EXECUTABLE_SUFFIX", "CMAKE_SHARED_LIBRARY_SUFFIX"};
+
+struct KnownPlatform {
+    std::string_view name;
+    std::string_view constraint;
+    std::array<std::string_view, platform_variable_names.size()> values;
+};
+
+constexpr std::array<KnownPlatform, 3> known_platforms = {{
+    {"linux", "config//os:linux", {"", "", "1", "", "", "1", "Linux", "", ".so"}},
+    {"macos", "config//os:macos", {"", "", "1", "1", "1", "", "Darwin", "", ".dylib"}},
+    {"windows", "config//os:windows", {"1", "1", "", "", "", "", "Windows", ".exe", ".dll"}},
+}};
+
+#if defined(_WIN32)
+constexpr std::string_view host_platform = "windows";
+#elif defined(__APPLE__)
+constexpr std::string_view host_platform = "macos";
+#else
+constexpr std::string_view host_platform = "linux";
+#endif
+
+const std::vector<Platform>& platform_table() {
+    static const std::vector<Platform> table = [] {
+        std::vector<Platform> platforms;
+        for (const auto& known : known_platforms) {
+            Platform platform{std::string(known.name), std::string(known.constraint), {}};
+            for (size_t i = 0; i < platform_variable_names.size(); ++i) {
+                platform.variables.emplace_back(platform_variable_names[i], known.values[i]);
+            }
+            platforms.push_back(std::move(platform));
+        }
+        return platforms;
+    }();
+    return table;
+}
+
+// Collects the names statement_reads() reports
+class ReadCollector : public ast::RecursiveASTVisitor {
+  public:
+    explicit ReadCollector(std::vector<std::string_view>& names) : names_(names) {}
+
+    using ast::RecursiveASTVisitor::visit;
+
+    void visit(const ast::Variable& node) override {
+        names_.push_back(node.name());
+    }
+
+    void visit(const ast::Identifier& node) override {
+        names_.push_back(node.name());
+    }
+
+    void visit(const ast::StringLiteral& node) override {
+        auto value = node.value();
+        // ${${prefix}_DIR} adds prefix as well as the partial outer name
+        for (auto start = value.find("${"); start != std::string_view::npos;
+             start = value.find("${", start + 2)) {
+            auto end = value.find('}', start);
+            if (end == std::string_view::npos) {
+                break;
+            }
+            names_.push_back(value.substr(start + 2, end - start - 2));
+        }
+        names_.push_back(value);
+    }
+
+  private:
+    std::vector<std::string_view>& names_;
+};
+
+// Moves the items every list has, in the first list's order, out of the
+// lists and returns them; each list keeps the rest in its own order
+template <typename T> std::vector<T> split_common(std::vector<std::vector<T>>& lists) {
+    std::vector<std::unordered_map<T, size_t>> counts(lists.size());
+    for (size_t i = 1; i < lists.size(); ++i) {
+        for (const auto& item : lists[i]) {
+            ++counts[i][item];
+        }
+    }
+
+    std::vector<T> common;
+    std::vector<T> rest;
+    std::unordered_map<T, size_t> taken;
+    for (auto& item : lists[0]) {
+        bool everywhere = std::all_of(counts.begin() + 1, counts.end(), [&](auto& count) {
+            auto it = count.find(item);
+            return it != count.end() && it->second > 0;
+        });
+        if (!everywhere) {
+            rest.push_back(std::move(item));
+            continue;
+        }
+        for (size_t i = 1; i < counts.size(); ++i) {
+            --counts[i][item];
+        }
+        ++taken[item];
+        common.push_back(std::move(item));
+    }
+    lists[0] = std::move(rest);
+
+    for (size_t i = 1; i < lists.size(); ++i) {
+        auto left = taken;
+        std::erase_if(lists[i], [&](const T& item) {
+            auto it = left.find(item);
+            if (it == left.end() || it->second == 0) {
+                return false;
+            }
+            --it->second;
+            return true;
+        });
+    }
+    return common;
+}
+
+} // namespace
+
+const PlatformSet& PlatformSet::host() {
+    static const PlatformSet set = [] {
+        PlatformSet host;
+        host.platforms_.push_back(*find(host_platform));
+        return host;
+    }();
+    return set;
+}
+
+const PlatformSet& PlatformSet::known() {
+    static const PlatformSet set = [] {
+        PlatformSet known;
+        known.platforms_ = platform_table();
+        return known;
+    }();
+    return set;
+}
+
+Result<PlatformSet, AnalysisError> PlatformSet::from_names(const std::vector<std::string>& names) {
+    if (names.empty()) {
+        return Result<PlatformSet, AnalysisError>(host());
+    }
+    PlatformSet set;
+    for (const auto& name : names) {
+        const auto* platform = find(name);
+        if (!platform) {
+            std::string known;
+            for (const auto& candidate : platform_table()) {
+                known += (known.empty() ? "" : ", ") + candidate.name;
+            }
+            return Result<PlatformSet, AnalysisError>(
+                std::in_place_index<1>,
+                AnalysisError(AnalysisError::Category::PlatformSpecific,
+                              "Unknown platform '" + name + "' (known: " + known + ")"));
+        }
+        if (std::none_of(set.platforms_.begin(), set.platforms_.end(),
+                         [&](const Platform& added) { return added.name == name; })) {
+            set.platforms_.push_back(*platform);
+        }
+    }
+    return Result<PlatformSet, AnalysisError>(std::move(set));
+}
+
+const Platform* PlatformSet::find(std::string_view name) {
+    for (const auto& platform : platform_table()) {
+        if (platform.name == name) {
+            return &platform;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<std::string_view> statement_reads(const ast::ASTNode& statement) {
+    std::vector<std::string_view> names;
+    ReadCollector collector(names);
+    if (const auto* cmd = dynamic_cast<const ast::CommandCall*>(&statement)) {
+        cmd->accept(collector);
+    } else if (const auto* if_statement = dynamic_cast<const ast::IfStatement*>(&statement)) {
+        if_statement->condition()->accept(collector);
+        for (const auto& branch : if_statement->elseif_branches()) {
+            if (const auto* elseif = dynamic_cast<const ast::ElseIfStatement*>(branch.get())) {
+                elseif->condition()->accept(collector);
+            }
+        }
+    }
+    return names;
+}
+
+Target merge_platform_targets(const std::vector<const Target*>& versions, PlatformMask active,
+                              const PlatformSet& platforms) {
+    // A target an earlier branch restricted stays defined only where it was
+    std::vector<size_t> present;
+    bool restricted = false;
+    for (size_t p = 0; p < platforms.size(); ++p) {
+        if (!(active & (PlatformMask{1} << p))) {
+            continue;
+        }
+        const auto* version = versions[p];
+        if (version && (version->platforms.empty() ||
+                        std::find(version->platforms.begin(), version->platforms.end(),
+                                  platforms[p].name) != version->platforms.end())) {
+            present.push_back(p);
+        } else {
+            restricted = true;
+        }
+    }
+    if (present.empty()) {
+        return **std::find_if(versions.begin(), versions.end(), [](auto* v) { return v; });
+    }
+    // Most statements leave most targets alone
+    if (!restricted && std::all_of(present.begin() + 1, present.end(), [&](size_t p) {
+            return *versions[p] == *versions[present.front()];
+        })) {
+        return *versions[present.front()];
+    }
+
+    Target merged = *versions[present.front()];
+    merged.platform_variants.clear();
+    merged.platforms.clear();
+
+    // Each platform's full list, split into what all share and what each adds
+    auto merge = [&](auto list, auto variant_list) {
+        using List = std::remove_reference_t<decltype(merged.*list)>;
+        std::vector<List> lists;
+        for (auto p : present) {
+            const auto& version = *versions[p];
+            List full = version.*list;
+            if (auto it = version.platform_variants.find(platforms[p].name);
+                it != version.platform_variants.end()) {
+                const auto& added = it->second.*variant_list;
+                full.insert(full.end(), added.begin(), added.end());
+            }
+            lists.push_back(std::move(full));
+        }
+        merged.*list = split_common(lists);
+        for (size_t i = 0; i < present.size(); ++i) {
+            if (!lists[i].empty()) {
+                merged.platform_variants[platforms[present[i]].name].*variant_list =
+                    std::move(lists[i]);
+            }
+        }
+    };
+    merge(&Target::sources, &Target::PlatformVariant::sources);
+    merge(&Target::headers, &Target::PlatformVariant::headers);
+    merge(&Target::include_directories, &Target::PlatformVariant::include_directories);
+    merge(&Target::compile_definitions, &Target::PlatformVariant::compile_definitions);
+    merge(&Target::compile_options, &Target::PlatformVariant::compile_options);
+    merge(&Target::link_libraries, &Target::PlatformVariant::link_libraries);
+
+    // Properties are not selected per platform; the first platform setting one wins
+    for (auto p : present) {
+        for (const auto& [key, value] : versions[p]->properties) {
+            auto [it, inserted] = merged.properties.try_emplace(key, value);
+            if (!inserted && it->second != value) {
+                LOG_WARN("{}: platforms disagree on {} ({} on {}); keeping {}", merged.name, key,
+                         value, platforms[p].name, it->second);
+            }
+        }
+    }
+
+    if (restricted) {
+        for (auto p : present) {
+            merged.platforms.push_back(platforms[p].name);
+        }
+    }
+    return merged;
+}
+
+} // namespace finch::analyzer
@@ -0,0 +1,561 @@
+#include <algorithm>
+#include <finch/analyzer/intrinsics.hpp>
+#include <finch/analyzer/program_slice.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/parser/ast/commands.hpp>
+#include <finch/parser/ast/control_flow.hpp>
+#include <finch/parser/ast/cpm_nodes.hpp>
+#include <finch/parser/ast/literals.hpp>
+#include <finch/parser/ast/structure.hpp>
+#include <finch/parser/ast/visitor.hpp>
+#include <functional>
+#include <unordered_map>
+
+namespace finch::analyzer {
+
+namespace {
+
+// Variables intrinsics read without naming them, e.g. GNUInstallDirs reads
+// CMAKE_INSTALL_PREFIX and PROJECT_NAME
+const std::vector<std::string> intrinsic_reads = {"CMAKE_", "PROJECT_", "CPM_", "FETCHCONTENT_",
+                                                  "_FetchContent_", "ARGC", "ARGV"};
+
+const std::unordered_set<std::string_view> link_keywords = {
+    "PUBLIC", "PRIVATE", "INTERFACE", "LINK_PUBLIC", "LINK_PRIVATE", "LINK_INTERFACE_LIBRARIES",
+    "debug",  "optimized", "general"};
+
+// What evaluating a statement reads and writes
+struct Effects {
+    std::vector<std::string> defs;
+    std::vector<std::string> def_prefixes; // e.g. fmt_ for find_package(fmt)
+    bool defines_anything = false;         // The defined name is only known when evaluated
+
+    std::unordered_set<std::string> uses;
+    std::vector<std::string> use_prefixes; // Implicit reads such as CMAKE_REQUIRED_*
+    bool uses_anything = false;
+
+    // Targets created or changed; nullopt for a name only known when evaluated
+    std::vector<std::optional<std::string>> targets;
+    bool always = false; // Its result is reported directly, e.g. project()
+
+    [[nodiscard]] bool defines() const {
+        return defines_anything || !defs.empty() || !def_prefixes.empty();
+    }
+};
+
+// The word an argument stands for when it does not depend on variables
+std::optional<std::string> literal(const ast::ASTNode& node) {
+    if (const auto* string = dynamic_cast<const ast::StringLiteral*>(&node)) {
+        if (string->value().find("${") == std::string_view::npos) {
+            return std::string(string->value());
+        }
+    } else if (const auto* identifier = dynamic_cast<const ast::Identifier*>(&node)) {
+        return std::string(identifier->name());
+    }
+    return std::nullopt;
+}
+
+// Collects the variables an expression reads. In a condition, bare words
+// may name variables too: if(FOO) and if(FOO STREQUAL bar) read FOO.
+class UseCollector : public ast::RecursiveASTVisitor {
+  public:
+    UseCollector(Effects& effects, bool condition) : effects_(effects), condition_(condition) {}
+
+    using ast::RecursiveASTVisitor::visit;
+
+    void visit(const ast::Variable& node) override {
+        add(node.name());
+    }
+
+    void visit(const ast::StringLiteral& node) override {
+        auto value = node.value();
+        for (auto start = value.find("${"); start != std::string_view::npos;
+             start = value.find("${", start + 2)) {
+            auto end = value.find('}', start);
+            if (end == std::string_view::npos) {
+                break;
+            }
+            add(value.substr(start + 2, end - start - 2));
+        }
+        if (condition_ && !node.is_quoted()) {
+            add(value);
+        }
+    }
+
+    void visit(const ast::Identifier& node) override {
+        if (condition_) {
+            add(node.name());
+        }
+    }
+
+  private:
+    void add(std::string_view name) {
+        if (name.starts_with("ENV{")) {
+            return;
+        }
+        if (name.find('$') != std::string_view::npos) {
+            effects_.uses_anything = true; // ${${prefix}_DIR}
+            return;
+        }
+        effects_.uses.emplace(name);
+    }
+
+    Effects& effects_;
+    bool condition_;
+};
+
+void collect_uses(const ast::ASTNode& node, Effects& effects, bool condition) {
+    UseCollector collector(effects, condition);
+    node.accept(collector);
+}
+
+// list() reads its list; the modifying subcommands write it back, and the
+// others write their output variables
+void list_effects(const std::vector<std::optional<std::string>>& words, Effects& effects) {
+    static const std::unordered_set<std::string_view> modifying = {
+        "APPEND",      "PREPEND",   "INSERT",            "POP_BACK", "POP_FRONT", "REMOVE_ITEM",
+        "REMOVE_AT",   "FILTER",    "REMOVE_DUPLICATES", "REVERSE",  "SORT",      "TRANSFORM"};
+    auto define = [&](const std::optional<std::string>& word) {
+        if (word) {
+            effects.defs.push_back(*word);
+        } else {
+            effects.defines_anything = true;
+        }
+    };
+    if (words.size() < 2 || !words[0]) {
+        effects.defines_anything = true;
+        effects.uses_anything = true;
+        return;
+    }
+    if (words[1]) {
+        effects.uses.insert(*words[1]);
+    } else {
+        effects.uses_anything = true;
+    }
+
+    const auto& subcommand = *words[0];
+    if (modifying.contains(subcommand)) {
+        define(words[1]);
+    }
+    if (subcommand == "POP_BACK" || subcommand == "POP_FRONT") {
+        std::for_each(words.begin() + 2, words.end(), define);
+    } else if (subcommand == "TRANSFORM") {
+        auto output = std::find(words.begin() + 2, words.end(), "OUTPUT_VARIABLE");
+        if (output != words.end() && output + 1 != words.end()) {
+            define(*(output + 1));
+        }
+    } else if (!modifying.contains(subcommand) && words.size() > 2) {
+        define(words.back());
+    }
+}
+
+// string() names its output by position; a position behind a word that is
+// not literal may shift, so the output is then unknown
+void string_effects(const std::vector<std::optional<std::string>>& words, Effects& effects) {
+    static const std::unordered_map<std::string_view, size_t> output_positions = {
+        {"APPEND", 1},  {"PREPEND", 1},     {"CONCAT", 1},      {"SHA256", 1},
+        {"JOIN", 2},    {"TOLOWER", 2},     {"TOUPPER", 2},     {"LENGTH", 2},
+        {"STRIP", 2},   {"GENEX_STRIP", 2}, {"MAKE_C_IDENTIFIER", 2},
+        {"FIND", 3},    {"REPLACE", 3},     {"REPEAT", 3},      {"SUBSTRING", 4},
+        {"COMPARE", 4}};
+    if (words.empty() || !words[0]) {
+        effects.defines_anything = true;
+        return;
+    }
+    const auto& subcommand = *words[0];
+    size_t output = 0;
+    if (subcommand == "REGEX") {
+        effects.def_prefixes.push_back("CMAKE_MATCH_");
+        effects.uses.insert("CMAKE_MATCH_COUNT");
+        output = words.size() > 1 && words[1] == "REPLACE" ? 4 : 3;
+    } else if (auto position = output_positions.find(subcommand);
+               position != output_positions.end()) {
+        output = position->second;
+    }
+    auto before_output = static_cast<std::ptrdiff_t>(std::min(output, words.size()));
+    bool shifted = std::any_of(words.begin(), words.begin() + before_output,
+                               [](const auto& word) { return !word.has_value(); });
+    if (output == 0 || output >= words.size() || shifted) {
+        effects.defines_anything = true;
+        return;
+    }
+    effects.defs.push_back(*words[output]);
+    if (subcommand == "APPEND" || subcommand == "PREPEND") {
+        effects.uses.insert(*words[output]);
+    }
+}
+
+Effects command_effects(const ast::CommandCall& cmd) {
+    Effects effects;
+    std::vector<std::optional<std::string>> words;
+    for (const auto& arg : cmd.arguments()) {
+        collect_uses(*arg, effects, false);
+        words.push_back(literal(*arg));
+    }
+    const auto& first = words.empty() ? std::optional<std::string>() : words.front();
+    auto define_first = [&]() {
+        if (first) {
+            effects.defs.push_back(*first);
+        } else {
+            effects.defines_anything = true;
+        }
+    };
+
+    const std::string_view name = cmd.name();
+    if (name == "set" || name == "unset" || name == "option") {
+        define_first();
+        // Other directories read the cache and what a directory sets in its parent
+        effects.always = name == "option" ||
+                         std::any_of(words.begin(), words.end(), [](const auto& word) {
+                             return word == "PARENT_SCOPE" || word == "CACHE";
+                         });
+    } else if (name == "list") {
+        list_effects(words, effects);
+    } else if (name == "string") {
+        string_effects(words, effects);
+    } else if (name == "file") {
+        // Only GLOB and GLOB_RECURSE are evaluated; they define their variable
+        bool glob = words.size() > 1 && (words[0] == "GLOB" || words[0] == "GLOB_RECURSE");
+        if (!words.empty() && (!words[0] || glob)) {
+            effects.uses.insert("CMAKE_CURRENT_SOURCE_DIR");
+            if (glob && words[1]) {
+                effects.defs.push_back(*words[1]);
+            } else {
+                effects.defines_anything = true;
+            }
+        }
+    } else if (name == "cmake_minimum_required") {
+        effects.defs.push_back("CMAKE_MINIMUM_REQUIRED_VERSION");
+    } else if (name == "project") {
+        effects.always = true;
+        effects.defs = {"PROJECT_NAME", "CMAKE_PROJECT_NAME"};
+        effects.def_prefixes = {"PROJECT_", "CMAKE_PROJECT_"};
+        if (first) {
+            effects.def_prefixes.push_back(*first + "_");
+        }
+    } else if (name == "add_library" || name == "add_executable") {
+        effects.targets.push_back(first);
+        effects.use_prefixes.push_back("CMAKE_"); // Target property initializers
+    } else if (name == "set_target_properties") {
+        for (const auto& word : words) {
+            if (word == "PROPERTIES") {
+                break;
+            }
+            effects.targets.push_back(word);
+        }
+    } else if (name.starts_with("target_")) {
+        effects.targets.push_back(first);
+    } else if (name == "find_package" || name == "pkg_check_modules" ||
+               name == "pkg_search_module") {
+        effects.always = true;
+        if (first) {
+            effects.def_prefixes.push_back(*first + "_");
+        } else {
+            effects.defines_anything = true;
+        }
+    } else if (name.starts_with("check_") || name == "try_compile") {
+        // The result variable's position differs between checks; every word
+        // is taken as a possible result
+        for (const auto& word : words) {
+            if (word) {
+                effects.defs.push_back(*word);
+            } else {
+                effects.defines_anything = true;
+            }
+        }
+        effects.use_prefixes.push_back("CMAKE_REQUIRED_");
+    } else if (name == "add_subdirectory") {
+        // The directory reads any variable, reports targets and may set
+        // variables with PARENT_SCOPE
+        effects.always = true;
+        effects.defines_anything = true;
+        effects.uses_anything = true;
+    } else if (name == "include") {
+        if (!first || IntrinsicRegistry::builtin().find_include(*first)) {
+            effects.defines_anything = true;
+            effects.use_prefixes = intrinsic_reads;
+        }
+    } else if (IntrinsicRegistry::builtin().find_command(name)) {
+        effects.defines_anything = true;
+        effects.use_prefixes = intrinsic_reads;
+    }
+    return effects;
+}
+
+// The package a CPMAddPackage() or CPMFindPackage() declaration names
+const std::string* cpm_package_name(const ast::ASTNode& node) {
+    if (const auto* add = dynamic_cast<const ast::CPMAddPackage*>(&node)) {
+        return &add->name();
+    }
+    if (const auto* find = dynamic_cast<const ast::CPMFindPackage*>(&node)) {
+        return &find->name();
+    }
+    return nullptr;
+}
+
+struct Statement {
+    const ast::ASTNode* node;
+    std::vector<size_t> enclosing; // if() and block() statements around it
+    Effects effects;
+};
+
+// Flattens what CMakeEvaluator evaluates: if() branches and blocks are
+// entered, loop and function bodies are never evaluated and are skipped
+void flatten(const ast::ASTNodeList& statements, std::vector<size_t>& enclosing,
+             std::vector<Statement>& out, size_t& count) {
+    for (const auto& statement : statements) {
+        const auto* node = statement.get();
+        if (dynamic_cast<const ast::ElseIfStatement*>(node)) {
+            continue; // Its condition belongs to the enclosing if()
+        }
+        ++count;
+        if (const auto* cmd = dynamic_cast<const ast::CommandCall*>(node)) {
+            out.push_back({node, enclosing, command_effects(*cmd)});
+        } else if (const auto* cpm_name = cpm_package_name(*node)) {
+            // Every declaration is reported for CPMResolver
+            Effects effects;
+            effects.always = true;
+            effects.def_prefixes = {"CPM_PACKAGE_", *cpm_name + "_"};
+            out.push_back({node, enclosing, std::move(effects)});
+        } else if (dynamic_cast<const ast::CPMUsePackageLock*>(node) ||
+                   dynamic_cast<const ast::CPMDeclarePackage*>(node)) {
+            // Pin what later declarations add
+            Effects effects;
+            effects.always = true;
+            out.push_back({node, enclosing, std::move(effects)});
+        } else if (const auto* if_statement = dynamic_cast<const ast::IfStatement*>(node)) {
+            Effects effects;
+            collect_uses(*if_statement->condition(), effects, true);
+            for (const auto& branch : if_statement->elseif_branches()) {
+                if (const auto* elseif = dynamic_cast<const ast::ElseIfStatement*>(branch.get())) {
+                    collect_uses(*elseif->condition(), effects, true);
+                }
+            }
+            enclosing.push_back(out.size());
+            out.push_back({node, {enclosing.begin(), enclosing.end() - 1}, std::move(effects)});
+            flatten(if_statement->then_branch(), enclosing, out, count);
+            flatten(if_statement->elseif_branches(), enclosing, out, count);
+            flatten(if_statement->else_branch(), enclosing, out, count);
+            enclosing.pop_back();
+        } else if (const auto* block = dynamic_cast<const ast::Block*>(node)) {
+            enclosing.push_back(out.size());
+            out.push_back({node, {enclosing.begin(), enclosing.end() - 1}, Effects{}});
+            flatten(block->statements(), enclosing, out, count);
+            enclosing.pop_back();
+        }
+    }
+}
+
+// The variables kept statements read
+struct Needed {
+    std::unordered_set<std::string> names;
+    std::vector<std::string> prefixes;
+    bool anything = false;
+
+    void add(const Effects& effects) {
+        names.insert(effects.uses.begin(), effects.uses.end());
+        for (const auto& prefix : effects.use_prefixes) {
+            if (std::find(prefixes.begin(), prefixes.end(), prefix) == prefixes.end()) {
+                prefixes.push_back(prefix);
+            }
+        }
+        anything = anything || effects.uses_anything;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return names.empty() && prefixes.empty() && !anything;
+    }
+
+    [[nodiscard]] bool defined_by(const Effects& effects) const {
+        if (!effects.defines() || empty()) {
+            return false;
+        }
+        if (anything || effects.defines_anything) {
+            return true;
+        }
+        for (const auto& def : effects.defs) {
+            if (names.contains(def) || std::any_of(prefixes.begin(), prefixes.end(),
+                                                   [&](const auto& p) {
+                                                       return def.starts_with(p);
+                                                   })) {
+                return true;
+            }
+        }
+        for (const auto& def_prefix : effects.def_prefixes) {
+            for (const auto& name : names) {
+                if (name.starts_with(def_prefix)) {
+                    return true;
+                }
+            }
+            for (const auto& prefix : prefixes) {
+                if (prefix.starts_with(def_prefix) || def_prefix.starts_with(prefix)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+void for_each_command(const ast::ASTNodeList& statements,
+                      const std::function<void(const ast::CommandCall&)>& callback) {
+    std::vector<Statement> flat;
+    std::vector<size_t> enclosing;
+    size_t count = 0;
+    flatten(statements, enclosing, flat, count);
+    for (const auto& statement : flat) {
+        if (const auto* cmd = dynamic_cast<const ast::CommandCall*>(statement.node)) {
+            callback(*cmd);
+        }
+    }
+}
+
+} // namespace
+
+ProgramSlice ProgramSlice::compute(const ast::File& file, const TargetCone& cone) {
+    std::vector<Statement> statements;
+    std::vector<size_t> enclosing;
+    ProgramSlice slice;
+    flatten(file.statements(), enclosing, statements, slice.statement_count_);
+
+    std::vector<bool> kept(statements.size(), false);
+    std::vector<size_t> worklist;
+    auto keep = [&](size_t i) {
+        if (!kept[i]) {
+            kept[i] = true;
+            worklist.push_back(i);
+        }
+    };
+
+    // Slicing criteria: the wanted targets and what is reported directly
+    for (size_t i = 0; i < statements.size(); ++i) {
+        const auto& effects = statements[i].effects;
+        bool wanted_target = std::any_of(
+            effects.targets.begin(), effects.targets.end(),
+            [&](const auto& target) { return !cone || !target || cone->contains(*target); });
+        if (effects.always || wanted_target) {
+            keep(i);
+        }
+    }
+
+    // Backwards over def-use and control dependences until nothing changes
+    Needed needed;
+    while (!worklist.empty()) {
+        while (!worklist.empty()) {
+            auto i = worklist.back();
+            worklist.pop_back();
+            needed.add(statements[i].effects);
+            for (auto outer : statements[i].enclosing) {
+                keep(outer);
+            }
+        }
+        for (size_t i = 0; i < statements.size(); ++i) {
+            if (!kept[i] && needed.defined_by(statements[i].effects)) {
+                keep(i);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < statements.size(); ++i) {
+        if (kept[i]) {
+            slice.kept_.insert(statements[i].node);
+        }
+    }
+    LOG_DEBUG("Program slice keeps {} of {} statements", slice.kept_.size(),
+              slice.statement_count_);
+    return slice;
+}
+
+void TargetGraph::add_file(const ast::File& file) {
+    for_each_command(file.statements(), [&](const ast::CommandCall& cmd) {
+        const std::string_view name = cmd.name();
+        bool creates = name == "add_library" || name == "add_executable";
+        if (!creates && name != "target_link_libraries") {
+            return;
+        }
+        const auto& args = cmd.arguments();
+        auto target = args.empty() ? std::nullopt : literal(*args.front());
+        if (!target) {
+            dynamic_ = true;
+            return;
+        }
+        auto& links = links_[*target];
+        if (creates) {
+            // add_library(<alias> ALIAS <target>) links the alias to its target
+            if (args.size() == 3 && literal(*args[1]) == "ALIAS") {
+                if (auto aliased = literal(*args[2])) {
+                    links.push_back(*aliased);
+                } else {
+                    dynamic_ = true;
+                }
+            }
+            return;
+        }
+        for (size_t i = 1; i < args.size(); ++i) {
+            auto word = literal(*args[i]);
+            if (!word) {
+                dynamic_ = true;
+            } else if (!link_keywords.contains(*word)) {
+                links.push_back(*word);
+            }
+        }
+    });
+}
+
+TargetCone TargetGraph::cone(const std::vector<std::string>& roots) const {
+    if (dynamic_) {
+        return std::nullopt;
+    }
+    std::unordered_set<std::string> reached(roots.begin(), roots.end());
+    std::vector<std::string> pending(roots.begin(), roots.end());
+    while (!pending.empty()) {
+        auto name = std::move(pending.back());
+        pending.pop_back();
+        auto it = links_.find(name);
+        if (it == links_.end()) {
+            continue;
+        }
+        for (const auto& linked : it->second) {
+            if (reached.insert(linked).second) {
+                pending.push_back(linked);
+            }
+        }
+    }
+    return reached;
+}
+
+std::vector<std::string> restrict_to_targets(ProjectAnalysis& analysis,
+                                             const std::vector<std::string>& roots) {
+    std::unordered_map<std::string, const Target*> by_name;
+    for (const auto& target : analysis.targets) {
+        by_name.emplace(target.name, &target);
+    }
+
+    std::vector<std::string> missing;
+    std::unordered_set<std::string> reached;
+    std::vector<const Target*> pending;
+    for (const auto& root : roots) {
+        auto it = by_name.find(root);
+        if (it == by_name.end()) {
+            missing.push_back(root);
+        } else if (reached.insert(root).second) {
+            pending.push_back(it->second);
+        }
+    }
+    while (!pending.empty()) {
+        const auto* target = pending.back();
+        pending.pop_back();
+        for (const auto& library : target->link_libraries) {
+            auto it = by_name.find(library);
+            if (it != by_name.end() && reached.insert(library).second) {
+                pending.push_back(it->second);
+            }
+        }
+    }
+
+    std::erase_if(analysis.targets,
+                  [&](const Target& target) { return !reached.contains(target.name); });
+    return missing;
+}
+
+} // namespace finch::analyzer
@@ -0,0 +1,443 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <finch/analyzer/cmake_regex.hpp>
+#include <finch/analyzer/string_command.hpp>
+#include <finch/core/logging.hpp>
+#include <finch/core/sha256.hpp>
+#include <fmt/format.h>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace finch::analyzer {
+
+namespace {
+
+// One string(<subcommand> <args>...) call
+struct Call {
+    EvaluationContext& context;
+    std::string_view subcommand;
+    std::span<const std::string> args;
+    Confidence confidence;
+
+    [[nodiscard]] AnalysisError error(std::string_view message) const {
+        return AnalysisError(fmt::format("string({}) {}", subcommand, message));
+    }
+
+    [[nodiscard]] Result<void, AnalysisError> fail(std::string_view message) const {
+        return Result<void, AnalysisError>::error(error(message));
+    }
+
+    // The inputs from position first on, which CMake concatenates
+    [[nodiscard]] std::string concatenated(size_t first) const {
+        if (args.size() == first + 1) {
+            return args[first];
+        }
+        size_t size = 0;
+        for (size_t i = first; i < args.size(); ++i) {
+            size += args[i].size();
+        }
+        std::string text;
+        text.reserve(size);
+        for (size_t i = first; i < args.size(); ++i) {
+            text += args[i];
+        }
+        return text;
+    }
+
+    void set(const std::string& name, std::string value) const {
+        context.set_variable(name, std::move(value), confidence);
+    }
+};
+
+constexpr size_t npos = std::string_view::npos;
+
+// glibc's memmem() scans with SSE2/AVX2 and a two-way search for longer
+// needles; string_view::find() compares byte by byte after a memchr()
+size_t find_substring(std::string_view text, std::string_view needle, size_t from = 0) {
+    if (from > text.size()) {
+        return npos;
+    }
+#if defined(__GLIBC__) || defined(__APPLE__)
+    if (needle.empty()) {
+        return from;
+    }
+    const void* found =
+        ::memmem(text.data() + from, text.size() - from, needle.data(), needle.size());
+    return found ? static_cast<size_t>(static_cast<const char*>(found) - text.data()) : npos;
+#else
+    return text.find(needle, from);
+#endif
+}
+
+Result<const std::regex*, AnalysisError> compile_regex(const Call& call, std::string_view pattern) {
+    auto regex = CMakeRegex::compile(pattern);
+    if (!regex.has_value()) {
+        return Result<const std::regex*, AnalysisError>(std::in_place_index<1>,
+                                                        call.error(regex.error().message()));
+    }
+    return regex;
+}
+
+// CMAKE_MATCH_<n> of the previous REGEX call are emptied before a new one
+// stores its groups; CMAKE_MATCH_COUNT is the highest non-empty group
+void clear_matches(const Call& call) {
+    long long count = 0;
+    if (const auto* previous = call.context.find_variable("CMAKE_MATCH_COUNT")) {
+        count = static_cast<long long>(
+            std::clamp(value_helpers::to_double(previous->value).value_or(0.0), 0.0, 9.0));
+    }
+    for (long long i = 0; i <= count; ++i) {
+        auto name = fmt::format("CMAKE_MATCH_{}", i);
+        if (call.context.find_variable(name)) {
+            call.set(name, std::string());
+        }
+    }
+    call.set("CMAKE_MATCH_COUNT", "0");
+}
+
+void store_matches(const Call& call, const std::cmatch& match) {
+    size_t highest = 0;
+    for (size_t i = 0; i < std::min<size_t>(match.size(), 10); ++i) {
+        if (match[i].length() > 0) {
+            call.set(fmt::format("CMAKE_MATCH_{}", i), match[i].str());
+            highest = i;
+        }
+    }
+    call.set("CMAKE_MATCH_COUNT", std::to_string(highest));
+}
+
+Result<void, AnalysisError> string_find(const Call& call) {
+    bool reverse = call.args.size() == 4 && call.args[3] == "REVERSE";
+    if (call.args.size() != 3 && !reverse) {
+        return call.fail("requires <string> <substring> <output variable> [REVERSE]");
+    }
+    std::string_view text = call.args[0];
+    std::string_view needle = call.args[1];
+    size_t found = reverse ? text.rfind(needle) : find_substring(text, needle);
+    call.set(call.args[2], found == npos ? "-1" : std::to_string(found));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_replace(const Call& call) {
+    if (call.args.size() < 3) {
+        return call.fail("requires <match> <replace> <output variable> <input>...");
+    }
+    std::string_view match = call.args[0];
+    std::string_view replace = call.args[1];
+    std::string input = call.concatenated(3);
+
+    size_t found = match.empty() ? npos : find_substring(input, match);
+    if (found == npos) {
+        call.set(call.args[2], std::move(input));
+        return Ok<AnalysisError>();
+    }
+    std::string output;
+    output.reserve(input.size());
+    size_t position = 0;
+    std::string_view text = input;
+    while (found != npos) {
+        output.append(text.substr(position, found - position));
+        output.append(replace);
+        position = found + match.size();
+        found = find_substring(text, match, position);
+    }
+    output.append(text.substr(position));
+    call.set(call.args[2], std::move(output));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_regex(const Call& call) {
+    if (call.args.empty()) {
+        return call.fail("requires MATCH, MATCHALL or REPLACE");
+    }
+    const auto& mode = call.args[0];
+    bool replace = mode == "REPLACE";
+    if (mode != "MATCH" && mode != "MATCHALL" && !replace) {
+        return call.fail(fmt::format("has an unknown mode {}", mode));
+    }
+    size_t output = replace ? 3 : 2;
+    if (call.args.size() < output + 1) {
+        return call.fail(fmt::format("{} requires an output variable and an input", mode));
+    }
+    auto regex = compile_regex(call, call.args[1]);
+    if (!regex.has_value()) {
+        return Result<void, AnalysisError>::error(regex.error());
+    }
+    std::string input = call.concatenated(output + 1);
+    clear_matches(call);
+
+    std::cmatch match;
+    if (replace) {
+        auto replacement = RegexReplacement::parse(call.args[2]);
+        if (!replacement.has_value()) {
+            return call.fail(replacement.error().message());
+        }
+        std::string result;
+        result.reserve(input.size());
+        if (replacement.value().replace_all(input, *regex.value(), result, match)) {
+            store_matches(call, match);
+        }
+        call.set(call.args[output], std::move(result));
+        return Ok<AnalysisError>();
+    }
+
+    const char* begin = input.data();
+    const char* end = begin + input.size();
+    if (mode == "MATCH") {
+        std::string found;
+        if (std::regex_search(begin, end, match, *regex.value())) {
+            store_matches(call, match);
+            found = match[0].str();
+        }
+        call.set(call.args[output], std::move(found));
+        return Ok<AnalysisError>();
+    }
+
+    // MATCHALL: every non-overlapping match, as a list
+    std::string matches;
+    std::cmatch last;
+    auto flags = std::regex_constants::match_default;
+    const char* position = begin;
+    while (position < end && std::regex_search(position, end, match, *regex.value(), flags)) {
+        if (match[0].length() == 0) {
+            return call.fail(fmt::format("regex \"{}\" matched an empty string", call.args[1]));
+        }
+        if (!last.empty()) {
+            matches += ';';
+        }
+        matches.append(match[0].first, match[0].second);
+        position = match[0].second;
+        last = match;
+        flags = std::regex_constants::match_prev_avail;
+    }
+    if (!last.empty()) {
+        store_matches(call, last);
+    }
+    call.set(call.args[output], std::move(matches));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_append(const Call& call) {
+    if (call.args.empty()) {
+        return call.fail("requires a variable");
+    }
+    bool prepend = call.subcommand == "PREPEND";
+    auto& binding = call.context.local_variable(call.args[0]);
+    if (!std::holds_alternative<std::string>(binding.value)) {
+        binding.value = value_helpers::to_string(binding.value);
+    }
+    binding.confidence = std::max(binding.confidence, call.confidence);
+    auto& text = std::get<std::string>(binding.value);
+    auto suffix = call.concatenated(1);
+    if (prepend) {
+        text.insert(0, suffix);
+    } else {
+        text += suffix;
+    }
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_concat(const Call& call) {
+    if (call.args.empty()) {
+        return call.fail("requires an output variable");
+    }
+    call.set(call.args[0], call.args.size() > 1 ? call.concatenated(1) : std::string());
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_join(const Call& call) {
+    if (call.args.size() < 2) {
+        return call.fail("requires <glue> <output variable>");
+    }
+    std::string joined;
+    for (size_t i = 2; i < call.args.size(); ++i) {
+        if (i > 2) {
+            joined += call.args[0];
+        }
+        joined += call.args[i];
+    }
+    call.set(call.args[1], std::move(joined));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_case(const Call& call) {
+    if (call.args.size() != 2) {
+        return call.fail("requires <string> <output variable>");
+    }
+    bool lower = call.subcommand == "TOLOWER";
+    std::string text = call.args[0];
+    for (auto& c : text) {
+        auto byte = static_cast<unsigned char>(c);
+        c = static_cast<char>(lower ? std::tolower(byte) : std::toupper(byte));
+    }
+    call.set(call.args[1], std::move(text));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_length(const Call& call) {
+    if (call.args.size() != 2) {
+        return call.fail("requires <string> <output variable>");
+    }
+    call.set(call.args[1], std::to_string(call.args[0].size()));
+    return Ok<AnalysisError>();
+}
+
+std::optional<long long> parse_integer(std::string_view text) {
+    long long value = 0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || end != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+Result<void, AnalysisError> string_substring(const Call& call) {
+    if (call.args.size() != 4) {
+        return call.fail("requires <string> <begin> <length> <output variable>");
+    }
+    std::string_view text = call.args[0];
+    auto begin = parse_integer(call.args[1]);
+    auto length = parse_integer(call.args[2]);
+    if (!begin || *begin < 0 || static_cast<size_t>(*begin) > text.size()) {
+        return call.fail(fmt::format("begin index {} is out of range 0 - {}", call.args[1],
+                                     text.size()));
+    }
+    if (!length || *length < -1) {
+        return call.fail(fmt::format("has an invalid length {}", call.args[2]));
+    }
+    auto count = *length == -1 ? npos : static_cast<size_t>(*length);
+    call.set(call.args[3], std::string(text.substr(static_cast<size_t>(*begin), count)));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_strip(const Call& call) {
+    if (call.args.size() != 2) {
+        return call.fail("requires <string> <output variable>");
+    }
+    std::string_view text = call.args[0];
+    if (call.subcommand == "GENEX_STRIP") {
+        call.set(call.args[1], value_helpers::strip_generator_expressions(text));
+        return Ok<AnalysisError>();
+    }
+    constexpr std::string_view whitespace = " \t\n\v\f\r";
+    auto first = text.find_first_not_of(whitespace);
+    auto last = text.find_last_not_of(whitespace);
+    call.set(call.args[1],
+             first == npos ? std::string() : std::string(text.substr(first, last - first + 1)));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_repeat(const Call& call) {
+    if (call.args.size() != 3) {
+        return call.fail("requires <string> <count> <output variable>");
+    }
+    auto count = parse_integer(call.args[1]);
+    if (!count || *count < 0) {
+        return call.fail(fmt::format("has an invalid count {}", call.args[1]));
+    }
+    std::string repeated;
+    repeated.reserve(call.args[0].size() * static_cast<size_t>(*count));
+    for (long long i = 0; i < *count; ++i) {
+        repeated += call.args[0];
+    }
+    call.set(call.args[2], std::move(repeated));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_compare(const Call& call) {
+    if (call.args.size() != 4) {
+        return call.fail("requires <op> <string1> <string2> <output variable>");
+    }
+    const auto& op = call.args[0];
+    int order = call.args[1].compare(call.args[2]);
+    bool result = false;
+    if (op == "LESS") {
+        result = order < 0;
+    } else if (op == "LESS_EQUAL") {
+        result = order <= 0;
+    } else if (op == "GREATER") {
+        result = order > 0;
+    } else if (op == "GREATER_EQUAL") {
+        result = order >= 0;
+    } else if (op == "EQUAL") {
+        result = order == 0;
+    } else if (op == "NOTEQUAL") {
+        result = order != 0;
+    } else {
+        return call.fail(fmt::format("has an unknown comparison {}", op));
+    }
+    call.set(call.args[3], result ? "1" : "0");
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_make_c_identifier(const Call& call) {
+    if (call.args.size() != 2) {
+        return call.fail("requires <string> <output variable>");
+    }
+    std::string identifier;
+    identifier.reserve(call.args[0].size() + 1);
+    if (!call.args[0].empty() && std::isdigit(static_cast<unsigned char>(call.args[0][0]))) {
+        identifier += '_';
+    }
+    for (char c : call.args[0]) {
+        identifier += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+    }
+    call.set(call.args[1], std::move(identifier));
+    return Ok<AnalysisError>();
+}
+
+Result<void, AnalysisError> string_sha256(const Call& call) {
+    if (call.args.size() != 2) {
+        return call.fail("requires <output variable> <input>");
+    }
+    call.set(call.args[0], Sha256::hex(call.args[1]));
+    return Ok<AnalysisError>();
+}
+
+using Handler = Result<void, AnalysisError> (*)(const Call&);
+
+constexpr std::array<std::pair<std::string_view, Handler>, 17> subcommands = {{
+    {"FIND", string_find},
+    {"REPLACE", string_replace},
+    {"REGEX", string_regex},
+    {"APPEND", string_append},
+    {"PREPEND", string_append},
+    {"CONCAT", string_concat},
+    {"JOIN", string_join},
+    {"TOLOWER", string_case},
+    {"TOUPPER", string_case},
+    {"LENGTH", string_length},
+    {"SUBSTRING", string_substring},
+    {"STRIP", string_strip},
+    {"GENEX_STRIP", string_strip},
+    {"REPEAT", string_repeat},
+    {"COMPARE", string_compare},
+    {"MAKE_C_IDENTIFIER", string_make_c_identifier},
+    {"SHA256", string_sha256},
+}};
+
+} // namespace
+
+Result<void, AnalysisError> StringCommand::evaluate(EvaluationContext& context,
+                                                    const std::vector<std::string>& args,
+                                                    Confidence confidence) {
+    if (args.empty()) {
+        return Result<void, AnalysisError>::error(
+            AnalysisError("string() requires a subcommand"));
+    }
+    auto handler = std::find_if(subcommands.begin(), subcommands.end(),
+                                [&](const auto& entry) { return entry.first == args[0]; });
+    if (handler == subcommands.end()) {
+        return Result<void, AnalysisError>::error(
+            AnalysisError(fmt::format("string() has an unknown subcommand {}", args[0])));
+    }
+    Call call{context, args[0], std::span<const std::string>(args).subspan(1), confidence};
+    LOG_TRACE("string({}) with {} arguments", args[0], call.args.size());
+    return handler->second(call);
+}
+
+} // namespace finch::analyzer
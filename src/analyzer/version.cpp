@@ -0,0 +1,54 @@
+#include <algorithm>
+#include <finch/analyzer/version.hpp>
+#include <limits>
+
+namespace finch::analyzer {
+
+Version Version::parse(std::string_view text) {
+    Version version;
+    uint64_t components[max_components] = {};
+    size_t pos = 0;
+    while (version.components_ < max_components && pos <= text.size()) {
+        uint64_t value = 0;
+        for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+            value = std::min<uint64_t>(value * 10 + static_cast<uint64_t>(text[pos] - '0'),
+                                       std::numeric_limits<uint32_t>::max());
+        }
+        components[version.components_++] = value;
+
+        // Like CMake, skip whatever follows the digits up to the next '.'
+        pos = text.find('.', pos);
+        if (pos == std::string_view::npos) {
+            break;
+        }
+        ++pos;
+    }
+    version.high_ = components[0] << 32 | components[1];
+    version.low_ = components[2] << 32 | components[3];
+    return version;
+}
+
+uint32_t Version::component(size_t index) const {
+    switch (index) {
+    case 0:
+        return static_cast<uint32_t>(high_ >> 32);
+    case 1:
+        return static_cast<uint32_t>(high_);
+    case 2:
+        return static_cast<uint32_t>(low_ >> 32);
+    case 3:
+        return static_cast<uint32_t>(low_);
+    default:
+        return 0;
+    }
+}
+
+std::string Version::to_string() const {
+    std::string result;
+    for (size_t i = 0; i < components_; ++i) {
+        result += (i == 0 ? "" : ".") + std::to_string(component(i));
+    }
+    return result;
+}
+
+} // namespace finch::analyzer
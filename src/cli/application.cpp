@@ -53,6 +53,42 @@ void Application::setup_commands(CLI::App& app) {
         ->default_val(std::vector<std::string>{"linux", "macos", "windows"});
     migrate->add_flag("--overwrite", migrate_opts.overwrite, "Overwrite existing Buck2 files");
     migrate->add_option("--template-dir", migrate_opts.template_dir, "Custom template directory");
+    migrate->add_option("--compile-commands", migrate_opts.compile_commands,
+                        "Derive targets from a compile_commands.json instead of CMake evaluation");
+    migrate->add_option("--file-api", migrate_opts.file_api_build_dir,
+                        "Read targets from the CMake File API reply of a configured build directory");
+    migrate->add_option("--ninja", migrate_opts.ninja_manifest,
+                        "Read targets from the build.ninja of a Ninja-configured build directory");
+    migrate->add_flag("--skip-include-scan", migrate_opts.skip_include_scan,
+                      "Use header globs instead of following #include directives");
+    migrate->add_option("--include-cache", migrate_opts.include_cache,
+                        "Cache file for the #include directives of scanned sources");
+    migrate->add_option("--package-prefix", migrate_opts.package_prefixes,
+                        "Install prefix to resolve find_package() against (can be repeated)");
+    migrate->add_option("--package-cache", migrate_opts.package_cache,
+                        "Cache file for the index of --package-prefix directories");
+    migrate->add_flag("--skip-probes", migrate_opts.skip_feature_probes,
+                      "Leave check_*() and try_compile() results unknown instead of compiling them");
+    migrate->add_option("--probe-cache", migrate_opts.probe_cache,
+                        "Cache file for check_*() and try_compile() results");
+    migrate->add_option("--cpm-source-cache", migrate_opts.cpm_source_cache,
+                        "CPM_SOURCE_CACHE to take http_archive hashes from (default: "
+                        "$CPM_SOURCE_CACHE)");
+    migrate->add_option("--cpm-cache-index", migrate_opts.cpm_cache_index,
+                        "Cache file for the hashes of the --cpm-source-cache archives");
+    migrate->add_flag("--full-evaluation", migrate_opts.full_evaluation,
+                      "Evaluate every statement instead of only those affecting targets");
+    migrate->add_option("--target", migrate_opts.targets,
+                        "Migrate only this target and the targets it links (can be repeated)");
+    migrate->add_flag("--no-prefilter", migrate_opts.no_prefilter,
+                      "Parse and evaluate every file, even those that cannot produce targets");
+    migrate->add_flag("--validate-prefilter", migrate_opts.validate_prefilter,
+                      "Also evaluate the files the prefilter leaves out and warn on differences");
+    migrate->add_flag("--no-snapshots", migrate_opts.no_snapshots,
+                      "Evaluate every directory instead of restoring unchanged ones from "
+                      "earlier runs");
+    migrate->add_option("--snapshot-dir", migrate_opts.snapshot_dir,
+                        "Directory for the evaluation snapshots kept between runs");
 
     migrate->callback([this, migrate_opts]() { handle_migrate(migrate_opts); });
 
@@ -95,7 +131,24 @@ int Application::handle_migrate(const MigrateOptions& opts) {
                                              .target_platforms = opts.platforms,
                                              .dry_run = opts.dry_run,
                                              .interactive = opts.interactive,
-                                             .config_file = global_opts_.config_file};
+                                             .config_file = global_opts_.config_file,
+                                             .compile_commands = opts.compile_commands,
+                                             .file_api_build_dir = opts.file_api_build_dir,
+                                             .ninja_manifest = opts.ninja_manifest,
+                                             .scan_includes = !opts.skip_include_scan,
+                                             .include_cache = opts.include_cache,
+                                             .package_prefixes = opts.package_prefixes,
+                                             .package_cache = opts.package_cache,
+                                             .run_feature_probes = !opts.skip_feature_probes,
+                                             .probe_cache = opts.probe_cache,
+                                             .cpm_source_cache = opts.cpm_source_cache,
+                                             .cpm_cache_index = opts.cpm_cache_index,
+                                             .slice_evaluation = !opts.full_evaluation,
+                                             .targets = opts.targets,
+                                             .prefilter_files = !opts.no_prefilter,
+                                             .validate_prefilter = opts.validate_prefilter,
+                                             .evaluation_snapshots = !opts.no_snapshots,
+                                             .snapshot_directory = opts.snapshot_dir};
 
     // Create and run pipeline
     MigrationPipeline pipeline(config);
@@ -1,12 +1,33 @@
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <filesystem>
 #include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/compile_database.hpp>
+#include <finch/analyzer/cpm_package_lock.hpp>
+#include <finch/analyzer/cpm_resolver.hpp>
+#include <finch/analyzer/cpm_source_cache.hpp>
+#include <finch/analyzer/directory_snapshot.hpp>
+#include <finch/analyzer/evaluation_snapshot.hpp>
+#include <finch/analyzer/feature_probes.hpp>
+#include <finch/analyzer/file_api.hpp>
+#include <finch/analyzer/file_prefilter.hpp>
+#include <finch/analyzer/include_scanner.hpp>
+#include <finch/analyzer/ninja_manifest.hpp>
+#include <finch/analyzer/package_index.hpp>
+#include <finch/analyzer/platforms.hpp>
+#include <finch/analyzer/program_slice.hpp>
 #include <finch/cli/migration_pipeline.hpp>
 #include <finch/cli/progress_reporter.hpp>
 #include <finch/core/logging.hpp>
+#include <finch/core/path_table.hpp>
 #include <finch/core/result.hpp>
 #include <finch/generator/generator.hpp>
+#include <finch/parser/ast/structural_hash.hpp>
+#include <finch/parser/ast/structure.hpp>
 #include <finch/parser/parser.hpp>
+#include <fmt/format.h>
+#include <fmt/ranges.h>
 #include <fstream>
 
 namespace finch::cli {
@@ -14,10 +35,11 @@ namespace finch::cli {
 namespace fs = std::filesystem;
 
 MigrationPipeline::MigrationPipeline(const PipelineConfig& config) : config_(config) {
-    // Initialize components with placeholder implementations
-    // Note: These will be properly initialized when the actual components are ready
+    // The shared caches depend on the configuration and are created by execute()
 }
 
+MigrationPipeline::~MigrationPipeline() = default;
+
 finch::Result<MigrationPipeline::MigrationResult, MigrationError> MigrationPipeline::execute() {
     auto start_time = std::chrono::steady_clock::now();
 
@@ -27,6 +49,16 @@ finch::Result<MigrationPipeline::MigrationResult, MigrationError> MigrationPipel
                            .warnings = {},
                            .duration = std::chrono::milliseconds(0)};
 
+    // Each build-tree backend replaces the evaluated targets; two would
+    // have one silently discard the other
+    if (config_.file_api_build_dir && config_.ninja_manifest) {
+        return finch::Result<MigrationResult, MigrationError>(
+            std::in_place_index<1>,
+            MigrationError(MigrationErrorKind::ConfigurationError,
+                           "--file-api and --ninja both replace the evaluated targets; "
+                           "give only one"));
+    }
+
     // Phase 1: Discovery
     if (progress_) {
         progress_->start_phase(Phase::Discovery, "Discovering CMake files...");
@@ -39,6 +71,17 @@ finch::Result<MigrationPipeline::MigrationResult, MigrationError> MigrationPipel
     }
 
     auto cmake_files = files_result.value();
+
+    // The top CMakeLists.txt goes first; the directories it adds are
+    // evaluated in its scope instead of alone
+    auto list_file_key = [](const fs::path& file) {
+        return fs::absolute(file).lexically_normal().generic_string();
+    };
+    auto top_list_file = list_file_key(fs::path(config_.source_directory) / "CMakeLists.txt");
+    std::stable_partition(cmake_files.begin(), cmake_files.end(), [&](const fs::path& file) {
+        return list_file_key(file) == top_list_file;
+    });
+    bool has_top = !cmake_files.empty() && list_file_key(cmake_files.front()) == top_list_file;
     if (progress_) {
         progress_->finish_phase(true);
     }
@@ -48,29 +91,324 @@ finch::Result<MigrationPipeline::MigrationResult, MigrationError> MigrationPipel
         progress_->start_phase(Phase::Parsing, "Parsing CMake files...");
     }
 
-    analyzer::ProjectAnalysis full_analysis;
-    size_t current_file = 0;
+    auto platforms = analyzer::PlatformSet::from_names(config_.target_platforms);
+    if (!platforms.has_value()) {
+        return finch::Result<MigrationResult, MigrationError>(
+            std::in_place_index<1>, MigrationError(MigrationErrorKind::ConfigurationError,
+                                                   platforms.error().message()));
+    }
+    platforms_ = std::make_unique<analyzer::PlatformSet>(std::move(platforms.value()));
+
+    // Package-lock files are parsed once however many files use them
+    package_locks_ = std::make_unique<analyzer::CPMPackageLockCache>();
+
+    // Every file(GLOB) of the run matches against one read of the tree
+    directory_snapshot_ = std::make_unique<analyzer::DirectorySnapshot>();
+
+    // Index installed packages once; find_package() then resolves in O(1)
+    if (!config_.package_prefixes.empty()) {
+        std::vector<fs::path> prefixes(config_.package_prefixes.begin(),
+                                       config_.package_prefixes.end());
+        auto cache = config_.package_cache ? fs::path(*config_.package_cache)
+                                           : analyzer::PackageIndex::default_cache_file();
+        package_index_ = std::make_unique<analyzer::PackageIndex>(
+            analyzer::PackageIndex::load_or_build(cache, prefixes));
+        LOG_DEBUG("Package index: {} packages ({})", package_index_->packages().size(),
+                  package_index_->from_cache() ? "cached" : "scanned");
+    }
+
+    if (config_.run_feature_probes) {
+        analyzer::ProbeExecutor::Options options;
+        if (const char* cc = std::getenv("CC"); cc && *cc) {
+            options.c_compiler = cc;
+        }
+        if (const char* cxx = std::getenv("CXX"); cxx && *cxx) {
+            options.cxx_compiler = cxx;
+        }
+        options.cache_file = config_.probe_cache ? fs::path(*config_.probe_cache)
+                                                 : analyzer::ProbeExecutor::default_cache_file();
+        probe_executor_ = std::make_unique<analyzer::ProbeExecutor>(std::move(options));
+    }
 
-    for (const auto& cmake_file : cmake_files) {
-        if (progress_) {
-            progress_->update_progress(++current_file, cmake_files.size());
-            progress_->report_file(cmake_file.string());
+    // Most *.cmake files are toolchain files, find-modules and packaging
+    // scripts. Each file add_subdirectory() does not reach is evaluated in
+    // its own scope, so one that creates
+    // no targets is only parsed to report its syntax errors, and one that
+    // does not even set state is not read past the prefilter.
+    std::vector<analyzer::FileClass> file_classes(cmake_files.size(), analyzer::FileClass::Full);
+    if (config_.prefilter_files) {
+        analyzer::FilePrefilter prefilter;
+        for (size_t i = 0; i < cmake_files.size(); ++i) {
+            file_classes[i] = prefilter.classify_file(cmake_files[i]);
+            // Without slicing, the variables such a file sets are part of
+            // the analysis
+            if (file_classes[i] == analyzer::FileClass::Shallow && !config_.slice_evaluation) {
+                file_classes[i] = analyzer::FileClass::Full;
+            }
         }
+        LOG_INFO("{}", prefilter.stats().to_string());
+    }
+
+    // The targets asked for and everything they link, as far as it can be
+    // read from the files without evaluating them
+    if (!config_.targets.empty() && config_.slice_evaluation) {
+        analyzer::TargetGraph graph;
+        std::optional<MigrationError> unparsed;
+        for (size_t i = 0; i < cmake_files.size() && !unparsed; ++i) {
+            if (file_classes[i] != analyzer::FileClass::Full) {
+                continue;
+            }
+            auto parsed = parse_cmake_file(cmake_files[i],
+                                           [&](const ast::File& ast) { graph.add_file(ast); });
+            if (!parsed.has_value()) {
+                unparsed = parsed.error();
+            }
+        }
+        // A file that does not parse may define or link any target
+        if (unparsed) {
+            LOG_WARN("Evaluating every statement, as the target cone is not known: {}",
+                     unparsed->message());
+        } else {
+            target_cone_ = graph.cone(config_.targets);
+        }
+        LOG_DEBUG("Target cone: {}", target_cone_ ? std::to_string(target_cone_->size()) + " targets"
+                                                  : std::string("not statically known"));
+    }
+
+    // Directories an earlier run evaluated are restored when they would be
+    // evaluated from the same state and nothing they read has changed
+    if (config_.evaluation_snapshots) {
+        analyzer::EvaluationSnapshotStore::Options options;
+        if (config_.snapshot_directory) {
+            options.directory = *config_.snapshot_directory;
+        }
+        std::vector<std::string> cone;
+        if (target_cone_) {
+            cone.assign(target_cone_->begin(), target_cone_->end());
+            std::sort(cone.begin(), cone.end());
+        }
+        options.evaluation_options = fmt::format(
+            "platforms={};slice={};cone={};probes={};packages={}",
+            fmt::join(config_.target_platforms, ","), config_.slice_evaluation,
+            target_cone_ ? fmt::format("{}", fmt::join(cone, ",")) : std::string("all"),
+            config_.run_feature_probes, fmt::join(config_.package_prefixes, ","));
+        snapshot_store_ = std::make_unique<analyzer::EvaluationSnapshotStore>(std::move(options));
+    }
 
-        auto file_analysis = process_file(cmake_file);
-        if (!file_analysis.has_value()) {
-            result.errors_encountered++;
+    analyzer::ProjectAnalysis full_analysis;
+    std::vector<std::string> prefilter_misses;
+    // CPM declarations the top CMakeLists.txt made, in evaluation order
+    size_t tree_cpm_packages = 0;
+    auto evaluate_files = [&]() {
+        full_analysis = analyzer::ProjectAnalysis{};
+        prefilter_misses.clear();
+        tree_cpm_packages = 0;
+        result.files_processed = 0;
+        result.errors_encountered = 0;
+        subtree_meter_ = std::make_unique<ast::SubtreeSharingMeter>();
+        size_t current_file = 0;
+        std::unordered_set<std::string> reached;
+
+        for (size_t i = 0; i < cmake_files.size(); ++i) {
+            const auto& cmake_file = cmake_files[i];
             if (progress_) {
-                progress_->report_error(file_analysis.error());
+                progress_->update_progress(++current_file, cmake_files.size());
+                progress_->report_file(cmake_file.string());
             }
-            continue;
+            if (reached.contains(list_file_key(cmake_file))) {
+                result.files_processed++;
+                continue;
+            }
+
+            if (file_classes[i] != analyzer::FileClass::Full) {
+                if (config_.validate_prefilter) {
+                    if (auto missed = validate_prefilter(cmake_file, file_classes[i])) {
+                        prefilter_misses.push_back(std::move(*missed));
+                    }
+                }
+                if (file_classes[i] == analyzer::FileClass::Skip) {
+                    continue;
+                }
+                // Measured like the Full files, with or without validation
+                auto parsed = parse_cmake_file(
+                    cmake_file, [&](const ast::File& ast) { subtree_meter_->measure(ast); });
+                if (!parsed.has_value()) {
+                    result.errors_encountered++;
+                    if (progress_) {
+                        progress_->report_error(parsed.error());
+                    }
+                    continue;
+                }
+                result.files_processed++;
+                continue;
+            }
+
+            auto file_analysis = process_file(cmake_file, true);
+            if (!file_analysis.has_value()) {
+                result.errors_encountered++;
+                if (progress_) {
+                    progress_->report_error(file_analysis.error());
+                }
+                continue;
+            }
+
+            // Merge the file analysis into the full project analysis
+            merge_analysis(full_analysis, file_analysis.value());
+            result.files_processed++;
+            for (const auto& file : file_analysis.value().subdirectory_files) {
+                reached.insert(list_file_key(file));
+            }
+            if (i == 0 && has_top) {
+                tree_cpm_packages = full_analysis.cpm_packages.size();
+            }
+        }
+    };
+    evaluate_files();
+
+    // Configure checks met above are compiled together, then the files are
+    // evaluated again with their answers. A check only reached through an
+    // earlier answer, like check_include_file() inside if(HAVE_FOO), is
+    // queued by that evaluation, so this repeats until none is left. With
+    // every answer cached, the first evaluation already had them and
+    // nothing is compiled.
+    constexpr size_t max_probe_rounds = 8;
+    for (size_t round = 0; probe_executor_ && probe_executor_->has_pending(); ++round) {
+        if (round == max_probe_rounds) {
+            LOG_WARN("Configure checks still pending after {} rounds; they stay unknown",
+                     max_probe_rounds);
+            break;
         }
+        probe_executor_->run();
+        evaluate_files();
+    }
+    if (probe_executor_) {
+        LOG_DEBUG("{}", probe_executor_->stats().to_string());
+    }
+    LOG_DEBUG("{}", package_locks_->stats().to_string());
+    LOG_DEBUG("{}", directory_snapshot_->stats().to_string());
+    if (snapshot_store_) {
+        LOG_DEBUG("{}", snapshot_store_->stats().to_string());
+    }
+    LOG_DEBUG("{}", PathTable::shared().stats().to_string());
+    LOG_INFO("{}", subtree_meter_->stats().to_string());
+    result.warnings.insert(result.warnings.end(), prefilter_misses.begin(),
+                           prefilter_misses.end());
+
+    // CPM adds the first declaration of a package it evaluates. The top
+    // CMakeLists.txt declares in evaluation order through the directories it
+    // adds; of the files evaluated alone, parent directories are evaluated
+    // before the subdirectories they add, so shallower files declare first.
+    auto depth = [](const analyzer::CPMPackage& package) {
+        fs::path file = package.declared_in.substr(0, package.declared_in.rfind(':'));
+        return std::distance(file.begin(), file.end());
+    };
+    auto alone_packages =
+        full_analysis.cpm_packages.begin() + static_cast<std::ptrdiff_t>(tree_cpm_packages);
+    std::stable_sort(alone_packages, full_analysis.cpm_packages.end(),
+                     [&](const auto& a, const auto& b) { return depth(a) < depth(b); });
+    analyzer::CPMResolver::resolve(full_analysis);
+
+    // Build-tree backends replace the evaluated targets but know nothing of
+    // the packages find_package() and CPM resolved
+    auto external_packages = full_analysis.external_packages;
+    auto cpm_packages = full_analysis.cpm_packages;
+
+    // A File API reply is CMake's own view of the configured project
+    if (config_.file_api_build_dir) {
+        analyzer::FileApiReader reader;
+        auto reply = reader.read(fs::path(*config_.file_api_build_dir));
+        if (!reply.has_value()) {
+            return finch::Result<MigrationResult, MigrationError>(
+                std::in_place_index<1>,
+                MigrationError(MigrationErrorKind::AnalysisError, reply.error().message()));
+        }
+        auto project_version = full_analysis.project_version;
+        full_analysis = std::move(reply.value());
+        full_analysis.project_version = project_version; // Not part of the codemodel
+    } else if (config_.ninja_manifest) {
+        analyzer::NinjaManifestAnalyzer ninja_analyzer;
+        auto manifest = ninja_analyzer.analyze(fs::path(*config_.ninja_manifest));
+        if (!manifest.has_value()) {
+            return finch::Result<MigrationResult, MigrationError>(
+                std::in_place_index<1>,
+                MigrationError(MigrationErrorKind::AnalysisError, manifest.error().message()));
+        }
+        manifest.value().project_name = full_analysis.project_name;
+        manifest.value().project_version = full_analysis.project_version;
+        full_analysis = std::move(manifest.value());
+    }
 
-        // Merge the file analysis into the full project analysis
-        merge_analysis(full_analysis, file_analysis.value());
-        result.files_processed++;
+    // Compile commands are ground truth for what is actually built
+    if (config_.compile_commands) {
+        analyzer::CompileDatabaseAnalyzer database_analyzer;
+        auto observed = database_analyzer.analyze(fs::path(*config_.compile_commands));
+        if (!observed.has_value()) {
+            return finch::Result<MigrationResult, MigrationError>(
+                std::in_place_index<1>,
+                MigrationError(MigrationErrorKind::AnalysisError, observed.error().message()));
+        }
+
+        auto observed_analysis = std::move(observed.value());
+        for (auto& finding :
+             analyzer::CompileDatabaseAnalyzer::cross_check(full_analysis, observed_analysis)) {
+            result.warnings.push_back(std::move(finding));
+        }
+        analyzer::CompileDatabaseAnalyzer::reconcile(observed_analysis, full_analysis);
+        full_analysis = std::move(observed_analysis);
+    }
+
+    if (full_analysis.external_packages.empty()) {
+        full_analysis.external_packages = std::move(external_packages);
+    }
+    if (full_analysis.cpm_packages.empty()) {
+        full_analysis.cpm_packages = std::move(cpm_packages);
+    }
+
+    // Archives in the CPM source cache give http_archive rules their sha256
+    // without downloading anything
+    auto cpm_cache_root = config_.cpm_source_cache
+                              ? std::optional<fs::path>(*config_.cpm_source_cache)
+                              : analyzer::CPMSourceCache::default_root();
+    if (cpm_cache_root && !full_analysis.cpm_packages.empty()) {
+        auto index = config_.cpm_cache_index ? fs::path(*config_.cpm_cache_index)
+                                             : analyzer::CPMSourceCache::default_index_file();
+        auto source_cache = analyzer::CPMSourceCache::update(*cpm_cache_root, index);
+        for (auto& warning : source_cache.fill(full_analysis.cpm_packages)) {
+            result.warnings.push_back(std::move(warning));
+        }
     }
 
+    if (!config_.targets.empty()) {
+        auto missing = analyzer::restrict_to_targets(full_analysis, config_.targets);
+        if (!missing.empty()) {
+            std::string names;
+            for (const auto& name : missing) {
+                names += (names.empty() ? "" : ", ") + name;
+            }
+            return finch::Result<MigrationResult, MigrationError>(
+                std::in_place_index<1>, MigrationError(MigrationErrorKind::ConfigurationError,
+                                                       "Unknown target: " + names));
+        }
+    }
+
+    // Directives of files unchanged since the last run are not read again
+    if (config_.scan_includes) {
+        auto cache = config_.include_cache ? fs::path(*config_.include_cache)
+                                           : analyzer::IncludeScanner::default_cache_file();
+        analyzer::IncludeScanner scanner;
+        if (auto loaded = scanner.load(cache); loaded.has_error()) {
+            LOG_DEBUG("Scanning includes without a cache: {}", loaded.error().message());
+        }
+        scanner.scan(full_analysis);
+        if (auto saved = scanner.save(cache); saved.has_error()) {
+            LOG_DEBUG("Not caching include directives: {}", saved.error().message());
+        }
+    }
+
+    result.warnings.insert(result.warnings.end(), full_analysis.warnings.begin(),
+                           full_analysis.warnings.end());
+    result.targets_generated = full_analysis.targets.size();
+
     if (progress_) {
         progress_->finish_phase(result.errors_encountered == 0);
     }
@@ -80,7 +418,7 @@ finch::Result<MigrationPipeline::MigrationResult, MigrationError> MigrationPipel
         progress_->start_phase(Phase::Generation, "Generating Buck2 files...");
     }
 
-    auto gen_result = generate_buck_files(full_analysis);
+    auto gen_result = generate_buck_files(full_analysis, result);
     if (!gen_result.has_value()) {
         return finch::Result<MigrationResult, MigrationError>(std::in_place_index<1>,
                                                               gen_result.error());
@@ -136,31 +474,105 @@ finch::Result<std::vector<fs::path>, MigrationError> MigrationPipeline::discover
     }
 }
 
-finch::Result<analyzer::ProjectAnalysis, MigrationError>
-MigrationPipeline::process_file(const fs::path& cmake_file) {
+finch::Result<void, MigrationError>
+MigrationPipeline::parse_cmake_file(const fs::path& cmake_file,
+                                    const std::function<void(const ast::File&)>& use) {
     // Read file content
     std::ifstream file(cmake_file);
     if (!file.is_open()) {
-        return finch::Result<analyzer::ProjectAnalysis, MigrationError>(
-            std::in_place_index<1>, MigrationError(MigrationErrorKind::FileSystemError,
-                                                   "Cannot open file: " + cmake_file.string()));
+        return finch::Result<void, MigrationError>::error(MigrationError(
+            MigrationErrorKind::FileSystemError, "Cannot open file: " + cmake_file.string()));
     }
 
     std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
     file.close();
 
-    // Create a placeholder implementation for now
-    analyzer::ProjectAnalysis analysis;
-    analysis.project_name = "parsed_project";
-    analysis.project_version = "1.0.0";
+    parser::Parser parser(content, cmake_file.string());
+    auto ast = parser.parse_file();
+    if (!ast.has_value()) {
+        const auto& errors = ast.error();
+        return finch::Result<void, MigrationError>::error(
+            MigrationError(MigrationErrorKind::ParsingError,
+                           cmake_file.string() + ": " +
+                               (errors.empty() ? std::string("parse failed")
+                                               : errors.front().message())));
+    }
+    use(*ast.value());
+    return finch::Result<void, MigrationError>{};
+}
+
+finch::Result<analyzer::ProjectAnalysis, MigrationError>
+MigrationPipeline::process_file(const fs::path& cmake_file, bool measure_sharing) {
+    analyzer::CMakeFileEvaluator evaluator;
+    evaluator.set_package_index(package_index_.get());
+    evaluator.set_probe_executor(probe_executor_.get());
+    evaluator.set_package_lock_cache(package_locks_.get());
+    evaluator.set_directory_snapshot(directory_snapshot_.get());
+    evaluator.set_snapshot_store(snapshot_store_.get());
+    evaluator.set_platforms(platforms_.get());
+    evaluator.set_source_directories(fs::absolute(config_.source_directory),
+                                     fs::absolute(cmake_file).parent_path());
+    evaluator.set_slicing(config_.slice_evaluation);
+    evaluator.set_target_cone(target_cone_);
+
+    std::optional<finch::Result<analyzer::ProjectAnalysis, AnalysisError>> analysis;
+    auto parsed = parse_cmake_file(
+        cmake_file, [&](const ast::File& ast) {
+            if (measure_sharing) {
+                subtree_meter_->measure(ast);
+            }
+            analysis.emplace(evaluator.analyze(ast));
+        });
+    if (!parsed.has_value()) {
+        return finch::Result<analyzer::ProjectAnalysis, MigrationError>(std::in_place_index<1>,
+                                                                        parsed.error());
+    }
+    if (!analysis->has_value()) {
+        return finch::Result<analyzer::ProjectAnalysis, MigrationError>(
+            std::in_place_index<1>,
+            MigrationError(MigrationErrorKind::AnalysisError,
+                           cmake_file.string() + ": " + analysis->error().message()));
+    }
+
+    return finch::Result<analyzer::ProjectAnalysis, MigrationError>{analysis->value()};
+}
 
-    return finch::Result<analyzer::ProjectAnalysis, MigrationError>{analysis};
+std::optional<std::string>
+MigrationPipeline::validate_prefilter(const fs::path& cmake_file, analyzer::FileClass file_class) {
+    auto analysis = process_file(cmake_file, false);
+    if (!analysis.has_value()) {
+        return std::nullopt; // Errors are reported when the file is processed for real
+    }
+    const auto& found = analysis.value();
+    if (found.targets.empty() && found.external_packages.empty() && found.project_name.empty()) {
+        return std::nullopt;
+    }
+    return fmt::format("Prefilter classified {} as {}, but it defines {} targets and {} packages",
+                       cmake_file.string(), analyzer::to_string(file_class), found.targets.size(),
+                       found.external_packages.size());
 }
 
 finch::Result<void, MigrationError>
-MigrationPipeline::generate_buck_files(const analyzer::ProjectAnalysis& analysis) {
-    // Create a placeholder implementation for now
-    // In a real implementation, this would use the generator
+MigrationPipeline::generate_buck_files(const analyzer::ProjectAnalysis& analysis,
+                                       MigrationResult& result) {
+    generator::Generator::Config generator_config;
+    generator_config.output_directory = config_.output_directory;
+    generator_config.target_platforms = config_.target_platforms;
+    generator_config.platforms = platforms_.get();
+    generator_config.dry_run = config_.dry_run;
+
+    generator::Generator generator(generator_config);
+    auto generated = generator.generate(analysis);
+    if (!generated.has_value()) {
+        return finch::Result<void, MigrationError>::error(
+            MigrationError(MigrationErrorKind::GenerationError, generated.error().message()));
+    }
+    const auto& generation = generated.value();
+    result.warnings.insert(result.warnings.end(), generation.warnings.begin(),
+                           generation.warnings.end());
+    if (generation.flag_report.targets_considered > 0) {
+        LOG_INFO("{}", generation.flag_report.to_string());
+    }
 
     return finch::Result<void, MigrationError>{};
 }
@@ -188,6 +600,27 @@ void MigrationPipeline::merge_analysis(analyzer::ProjectAnalysis& target,
         target.cache_variables[key] = value;
     }
 
+    // Merge external packages, once per package
+    for (const auto& package : source.external_packages) {
+        auto existing = std::find_if(
+            target.external_packages.begin(), target.external_packages.end(),
+            [&](const auto& known) { return known.location == package.location; });
+        if (existing == target.external_packages.end()) {
+            target.external_packages.push_back(package);
+            continue;
+        }
+        for (const auto& imported : package.imported_targets) {
+            if (std::find(existing->imported_targets.begin(), existing->imported_targets.end(),
+                          imported) == existing->imported_targets.end()) {
+                existing->imported_targets.push_back(imported);
+            }
+        }
+    }
+
+    // CPM declarations are resolved once every file has been evaluated
+    target.cpm_packages.insert(target.cpm_packages.end(), source.cpm_packages.begin(),
+                               source.cpm_packages.end());
+
     // Merge warnings
     target.warnings.insert(target.warnings.end(), source.warnings.begin(), source.warnings.end());
 }
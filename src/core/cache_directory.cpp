@@ -0,0 +1,39 @@
+#include <chrono>
+#include <finch/core/cache_directory.hpp>
+#include <fmt/format.h>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace finch {
+
+namespace fs = std::filesystem;
+
+Result<void, IOError> replace_file(const fs::path& path, std::string_view contents) {
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    // Unique per writer, so two threads or processes never share one
+    auto temporary = path;
+    temporary += fmt::format(".{}.{}.tmp",
+                             std::chrono::system_clock::now().time_since_epoch().count(),
+                             std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream out(temporary, std::ios::binary);
+        if (!out || !out.write(contents.data(), static_cast<std::streamsize>(contents.size()))) {
+            fs::remove(temporary, ec);
+            return Result<void, IOError>::error(
+                IOError(IOError::Category::PermissionDenied,
+                        fmt::format("Cannot write {}", temporary.string())));
+        }
+    }
+    fs::rename(temporary, path, ec);
+    if (ec) {
+        fs::remove(temporary, ec);
+        return Result<void, IOError>::error(
+            IOError(fmt::format("Cannot replace {}: {}", path.string(), ec.message())));
+    }
+    return Result<void, IOError>{};
+}
+
+} // namespace finch
@@ -97,12 +97,13 @@ void Logger::initialize(const LogConfig& config) {
 
         initialized_ = true;
 
-        LOG_INFO("Logging system initialized (mode: {}, format: {}, level: {})",
-                 config.mode == LogConfig::Mode::Asynchronous ? "async" : "sync",
-                 config.format == LogConfig::Format::JSON   ? "json"
-                 : config.format == LogConfig::Format::Both ? "both"
-                                                            : "text",
-                 spdlog::level::to_string_view(config.console_level));
+        // Through logger_: LOG_INFO would take config_mutex_, held here
+        logger_->info("Logging system initialized (mode: {}, format: {}, level: {})",
+                      config.mode == LogConfig::Mode::Asynchronous ? "async" : "sync",
+                      config.format == LogConfig::Format::JSON   ? "json"
+                      : config.format == LogConfig::Format::Both ? "both"
+                                                                 : "text",
+                      spdlog::level::to_string_view(config.console_level));
 
     } catch (const std::exception& e) {
         // Fallback to console logging
@@ -112,7 +113,7 @@ void Logger::initialize(const LogConfig& config) {
         spdlog::set_default_logger(logger_);
         initialized_ = true;
 
-        LOG_ERROR(
+        logger_->error(
             "Failed to initialize logging with configuration: {}. Using fallback console logging.",
             e.what());
     }
@@ -122,9 +123,8 @@ void Logger::shutdown() {
     std::unique_lock lock(config_mutex_);
 
     if (initialized_) {
-        LOG_INFO("Shutting down logging system");
-
         if (logger_) {
+            logger_->info("Shutting down logging system");
             logger_->flush();
         }
 
@@ -0,0 +1,94 @@
+#include <finch/core/mapped_file.hpp>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace finch {
+
+Result<MappedFile, IOError> MappedFile::open(const std::filesystem::path& path) {
+    MappedFile file;
+
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Result<MappedFile, IOError>(
+            std::in_place_index<1>,
+            IOError(IOError::Category::FileNotFound, "Cannot open file").with_path(path.string()));
+    }
+
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return Result<MappedFile, IOError>(
+            std::in_place_index<1>,
+            IOError(IOError::Category::InvalidPath, "Cannot stat file").with_path(path.string()));
+    }
+
+    if (st.st_size > 0) {
+        void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            ::madvise(data, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            file.data_ = static_cast<const char*>(data);
+            file.size_ = static_cast<size_t>(st.st_size);
+            file.mapped_ = true;
+        }
+    }
+    ::close(fd);
+
+    if (file.mapped_ || st.st_size == 0) {
+        return Result<MappedFile, IOError>(std::move(file));
+    }
+#endif
+
+    // Fall back to reading the whole file (no mmap, or mapping failed)
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        return Result<MappedFile, IOError>(
+            std::in_place_index<1>,
+            IOError(IOError::Category::FileNotFound, "Cannot open file").with_path(path.string()));
+    }
+    file.buffer_.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    file.data_ = file.buffer_.data();
+    file.size_ = file.buffer_.size();
+    return Result<MappedFile, IOError>(std::move(file));
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        mapped_ = other.mapped_;
+        size_ = other.size_;
+        buffer_ = std::move(other.buffer_);
+        data_ = mapped_ ? other.data_ : buffer_.data();
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.mapped_ = false;
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+void MappedFile::release() noexcept {
+#ifndef _WIN32
+    if (mapped_ && data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+}
+
+} // namespace finch
@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <finch/core/path_table.hpp>
+#include <fmt/format.h>
+#include <mutex>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+namespace finch {
+
+namespace {
+
+constexpr std::string_view root_name = "/";
+constexpr size_t block_size = 64 * 1024;
+constexpr size_t initial_index_size = 1024;
+
+size_t hash_of(uint32_t parent, std::string_view name) {
+    return std::hash<std::string_view>{}(name) ^ (parent * size_t{0x9E3779B97F4A7C15});
+}
+
+} // namespace
+
+PathId::PathId(std::string_view path) : index_(PathTable::shared().intern(path).index_) {}
+
+PathId::PathId(const std::filesystem::path& path) : PathId(path.generic_string()) {}
+
+std::string PathId::str() const {
+    return PathTable::shared().str(*this);
+}
+
+std::filesystem::path PathId::path() const {
+    return str();
+}
+
+bool PathId::is_absolute() const {
+    return PathTable::shared().node(index_).absolute;
+}
+
+PathId PathId::parent() const {
+    return PathId(PathTable::shared().node(index_).parent);
+}
+
+std::string_view PathId::filename() const {
+    auto node = PathTable::shared().node(index_);
+    if (node.parent == index_) {
+        return {}; // The empty path or a root
+    }
+    return node.view();
+}
+
+std::string_view PathId::stem() const {
+    auto name = filename();
+    return name.substr(0, name.find('.'));
+}
+
+std::string_view PathId::extension() const {
+    auto name = filename();
+    auto dot = name.rfind('.');
+    return dot == std::string_view::npos ? std::string_view() : name.substr(dot);
+}
+
+bool PathId::is_within(PathId directory) const {
+    return PathTable::shared().within(index_, directory.index_);
+}
+
+PathId PathId::operator/(PathId relative) const {
+    return PathId(PathTable::shared().join(index_, relative.index_));
+}
+
+PathId PathId::relative_to(PathId base) const {
+    return PathId(PathTable::shared().relative(index_, base.index_));
+}
+
+std::ostream& operator<<(std::ostream& os, PathId path) {
+    return os << path.str();
+}
+
+std::string PathTable::Stats::to_string() const {
+    return fmt::format("Path table: {} paths, {} bytes of names, {} KiB in all", paths,
+                       name_bytes, table_bytes / 1024);
+}
+
+PathTable& PathTable::shared() {
+    static PathTable table;
+    return table;
+}
+
+PathTable::PathTable() : nodes_(1), index_(initial_index_size, missing_node) {}
+
+size_t PathTable::slot_of(uint32_t parent, std::string_view name) const {
+    size_t mask = index_.size() - 1;
+    for (size_t slot = hash_of(parent, name) & mask;; slot = (slot + 1) & mask) {
+        auto id = index_[slot];
+        if (id == missing_node || (nodes_[id].parent == parent && nodes_[id].view() == name)) {
+            return slot;
+        }
+    }
+}
+
+uint32_t PathTable::find_child(uint32_t parent, std::string_view name) const {
+    if (parent == empty_node && name == root_name) {
+        return root_;
+    }
+    return index_[slot_of(parent, name)];
+}
+
+void PathTable::grow_index() {
+    std::vector<uint32_t> old(index_.size() * 2, missing_node);
+    old.swap(index_);
+    size_t mask = index_.size() - 1;
+    for (auto id : old) {
+        if (id == missing_node) {
+            continue;
+        }
+        const auto& node = nodes_[id];
+        auto slot = hash_of(node.parent, node.view()) & mask;
+        while (index_[slot] != missing_node) {
+            slot = (slot + 1) & mask;
+        }
+        index_[slot] = id;
+    }
+}
+
+uint32_t PathTable::child(uint32_t parent, std::string_view name) {
+    bool root = parent == empty_node && name == root_name;
+    size_t slot = 0;
+    if (root) {
+        if (root_ != missing_node) {
+            return root_;
+        }
+    } else {
+        slot = slot_of(parent, name);
+        if (index_[slot] != missing_node) {
+            return index_[slot];
+        }
+    }
+
+    // Names are copied into blocks that never move, so views of them stay valid
+    if (name.size() > block_capacity_ - block_used_) {
+        block_capacity_ = std::max(block_size, name.size());
+        block_used_ = 0;
+        blocks_.push_back(std::make_unique<char[]>(block_capacity_));
+        block_bytes_ += block_capacity_;
+    }
+    char* stored = blocks_.back().get() + block_used_;
+    std::copy(name.begin(), name.end(), stored);
+    block_used_ += name.size();
+    name_bytes_ += name.size();
+
+    auto id = static_cast<uint32_t>(nodes_.size());
+    Node node;
+    node.name = stored;
+    node.size = static_cast<uint32_t>(name.size());
+    node.parent = root ? id : parent;
+    node.depth = root ? 0 : (nodes_[parent].depth + 1) & max_depth;
+    node.absolute = root || nodes_[parent].absolute;
+    nodes_.push_back(node);
+
+    if (root) {
+        root_ = id;
+    } else {
+        index_[slot] = id;
+        if (nodes_.size() * 2 > index_.size()) {
+            grow_index();
+        }
+    }
+    return id;
+}
+
+template <typename Table> uint32_t PathTable::step(Table& table, uint32_t current,
+                                                   std::string_view name) {
+    if (name.empty() || name == ".") {
+        return current;
+    }
+    if (name == "..") {
+        const auto& node = table.nodes_[current];
+        if (node.parent == current && current != empty_node) {
+            return current; // Nothing above a root
+        }
+        if (current != empty_node && node.view() != "..") {
+            return node.parent;
+        }
+        // Relative paths keep leading ".." components
+    }
+    if constexpr (std::is_const_v<Table>) {
+        return table.find_child(current, name);
+    } else {
+        return table.child(current, name);
+    }
+}
+
+template <typename Table> uint32_t PathTable::walk(Table& table, std::string_view path) {
+    if (path.find("$<") != std::string_view::npos || path.find("${") != std::string_view::npos) {
+        // Normalizing would rewrite text inside the expression; keep it whole
+        return step(table, empty_node, path);
+    }
+    uint32_t current = empty_node;
+    size_t position = 0;
+    if (path.starts_with('/')) {
+        current = step(table, empty_node, root_name);
+        position = 1;
+    }
+    while (current != missing_node && position < path.size()) {
+        auto end = path.find('/', position);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        current = step(table, current, path.substr(position, end - position));
+        position = end + 1;
+    }
+    return current;
+}
+
+PathId PathTable::intern(std::string_view path) {
+    {
+        // Paths seen before never take the exclusive lock
+        std::shared_lock lock(mutex_);
+        auto found = walk(std::as_const(*this), path);
+        if (found != missing_node) {
+            return PathId(found);
+        }
+    }
+    std::unique_lock lock(mutex_);
+    return PathId(walk(*this, path));
+}
+
+std::string PathTable::str(PathId path) const {
+    std::shared_lock lock(mutex_);
+    // Sized on the way up, then filled from the end on a second climb
+    auto separated = [&](const Node& node) {
+        return node.parent != empty_node && nodes_[node.parent].parent != node.parent;
+    };
+    size_t size = 0;
+    for (auto index = path.index_; index != empty_node;) {
+        const auto& node = nodes_[index];
+        size += node.size + (separated(node) ? 1 : 0);
+        index = node.parent == index ? empty_node : node.parent;
+    }
+    std::string result(size, '/');
+    for (auto index = path.index_; index != empty_node;) {
+        const auto& node = nodes_[index];
+        size -= node.size;
+        result.replace(size, node.size, node.view());
+        size -= separated(node) ? 1U : 0U;
+        index = node.parent == index ? empty_node : node.parent;
+    }
+    return result;
+}
+
+PathTable::Stats PathTable::stats() const {
+    std::shared_lock lock(mutex_);
+    return {nodes_.size(), name_bytes_,
+            nodes_.capacity() * sizeof(Node) + index_.size() * sizeof(uint32_t) + block_bytes_};
+}
+
+PathTable::Node PathTable::node(uint32_t index) const {
+    std::shared_lock lock(mutex_);
+    return nodes_[index];
+}
+
+bool PathTable::within(uint32_t path, uint32_t directory) const {
+    std::shared_lock lock(mutex_);
+    if (nodes_[path].absolute != nodes_[directory].absolute) {
+        return false;
+    }
+    while (nodes_[path].depth > nodes_[directory].depth) {
+        path = nodes_[path].parent;
+    }
+    return path == directory;
+}
+
+uint32_t PathTable::join(uint32_t base, uint32_t relative) {
+    std::unique_lock lock(mutex_);
+    if (nodes_[relative].absolute || relative == empty_node) {
+        return relative == empty_node ? base : relative;
+    }
+    std::vector<uint32_t> components;
+    for (auto index = relative; index != empty_node; index = nodes_[index].parent) {
+        components.push_back(index);
+    }
+    auto current = base;
+    for (auto it = components.rbegin(); it != components.rend(); ++it) {
+        current = step(*this, current, nodes_[*it].view());
+    }
+    return current;
+}
+
+uint32_t PathTable::relative(uint32_t path, uint32_t base) {
+    std::unique_lock lock(mutex_);
+    if (nodes_[path].absolute != nodes_[base].absolute) {
+        return path;
+    }
+    // Climb both to their common ancestor: the path's side is spelled out,
+    // each step on the base's side is a ".."
+    std::vector<uint32_t> tail;
+    size_t ups = 0;
+    auto from = path;
+    while (nodes_[from].depth > nodes_[base].depth) {
+        tail.push_back(from);
+        from = nodes_[from].parent;
+    }
+    while (nodes_[base].depth > nodes_[from].depth) {
+        base = nodes_[base].parent;
+        ++ups;
+    }
+    while (from != base) {
+        if (nodes_[from].depth == 0) {
+            return path; // Different roots
+        }
+        tail.push_back(from);
+        from = nodes_[from].parent;
+        base = nodes_[base].parent;
+        ++ups;
+    }
+
+    uint32_t current = empty_node;
+    for (size_t i = 0; i < ups; ++i) {
+        current = child(current, "..");
+    }
+    for (auto it = tail.rbegin(); it != tail.rend(); ++it) {
+        current = child(current, nodes_[*it].view());
+    }
+    return current;
+}
+
+} // namespace finch
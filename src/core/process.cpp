@@ -0,0 +1,57 @@
+#include <cstdio>
+#include <finch/core/process.hpp>
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#endif
+
+namespace finch {
+
+std::string quote_argument(std::string_view argument) {
+#ifdef _WIN32
+    // Backslashes are literal unless they precede a quote, where each one
+    // and the quote itself must be escaped
+    std::string quoted = "\"";
+    size_t backslashes = 0;
+    for (char c : argument) {
+        if (c == '\\') {
+            ++backslashes;
+            continue;
+        }
+        quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+        quoted += c;
+        backslashes = 0;
+    }
+    quoted.append(backslashes * 2, '\\');
+    return quoted + "\"";
+#else
+    std::string quoted = "'";
+    for (char c : argument) {
+        quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+    }
+    return quoted + "'";
+#endif
+}
+
+std::optional<ProcessOutput> run_command(const std::string& command_line) {
+#ifdef _WIN32
+    // cmd /c drops the first and last quote of a line that starts with one
+    std::string shell_line = "\"" + command_line + " 2>&1\"";
+#else
+    std::string shell_line = command_line + " 2>&1";
+#endif
+    FILE* pipe = popen(shell_line.c_str(), "r");
+    if (!pipe) {
+        return std::nullopt;
+    }
+    ProcessOutput result;
+    char buffer[4096];
+    while (size_t n = fread(buffer, 1, sizeof(buffer), pipe)) {
+        result.output.append(buffer, n);
+    }
+    result.succeeded = pclose(pipe) == 0;
+    return result;
+}
+
+} // namespace finch
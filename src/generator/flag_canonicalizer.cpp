@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <finch/generator/flag_canonicalizer.hpp>
+#include <fmt/format.h>
+#include <map>
+#include <optional>
+#include <set>
+#include <unordered_set>
+
+namespace finch::generator {
+
+namespace {
+
+// A flag together with its separate argument, if it takes one
+using FlagUnit = std::vector<std::string>;
+
+// Flags whose separate argument can be attached without changing meaning
+bool is_joinable_flag(const std::string& flag) {
+    return flag == "-D" || flag == "-U" || flag == "-I";
+}
+
+// Flags that consume the following argument as a separate token
+bool takes_separate_argument(const std::string& flag) {
+    static const std::unordered_set<std::string> flags = {
+        "-isystem", "-iquote", "-idirafter",  "-include",       "-imacros",
+        "-x",       "-Xclang", "-mllvm",      "-Xpreprocessor", "-Xassembler",
+        "-arch",    "-target", "-Xarch_host", "-framework"};
+    return flags.contains(flag);
+}
+
+// Arguments forwarded to another tool; repeating them can be meaningful
+bool is_pass_through(const FlagUnit& unit) {
+    return unit.size() == 2 && (unit[0] == "-Xclang" || unit[0] == "-mllvm" ||
+                                unit[0] == "-Xpreprocessor" || unit[0] == "-Xassembler");
+}
+
+std::vector<FlagUnit> split_units(const std::vector<std::string>& flags) {
+    std::vector<FlagUnit> units;
+    for (size_t i = 0; i < flags.size(); ++i) {
+        const auto& flag = flags[i];
+        if (i + 1 < flags.size() && is_joinable_flag(flag)) {
+            units.push_back({flag + flags[i + 1]});
+            ++i;
+        } else if (i + 1 < flags.size() && takes_separate_argument(flag)) {
+            units.push_back({flag, flags[i + 1]});
+            ++i;
+        } else {
+            units.push_back({flag});
+        }
+    }
+    return units;
+}
+
+std::vector<std::string> flatten_units(const std::vector<FlagUnit>& units) {
+    std::vector<std::string> flags;
+    for (const auto& unit : units) {
+        flags.insert(flags.end(), unit.begin(), unit.end());
+    }
+    return flags;
+}
+
+// Macro name of a -D/-U flag
+std::optional<std::string> macro_name(const FlagUnit& unit) {
+    if (unit.size() != 1 || unit[0].size() <= 2 ||
+        !(unit[0].starts_with("-D") || unit[0].starts_with("-U"))) {
+        return std::nullopt;
+    }
+    auto name = unit[0].substr(2);
+    return name.substr(0, name.find_first_of("=("));
+}
+
+// Options where a later occurrence fully overrides earlier ones share a key
+std::optional<std::string> override_key(const FlagUnit& unit) {
+    if (auto macro = macro_name(unit)) {
+        return "-D" + *macro;
+    }
+    if (unit.size() != 1) {
+        return std::nullopt;
+    }
+
+    const auto& flag = unit[0];
+    if (flag.starts_with("-O")) {
+        return std::string("-O");
+    }
+    if (flag.starts_with("-std=")) {
+        return std::string("-std=");
+    }
+    if (flag == "-g" || (flag.size() == 3 && flag.starts_with("-g") && flag[2] >= '0' &&
+                         flag[2] <= '3')) {
+        return std::string("-g");
+    }
+    // Options taking a value, of which only the last applies. Others with a
+    // value (-ffile-prefix-map=, -fplugin=, -fsanitize=, ...) accumulate.
+    static const std::unordered_set<std::string> valued = {"-fvisibility=", "-march=", "-mtune=",
+                                                           "-mcpu="};
+    if (auto equals = flag.find('='); equals != std::string::npos) {
+        auto name = flag.substr(0, equals + 1);
+        if (valued.contains(name)) {
+            return name;
+        }
+        return std::nullopt;
+    }
+    // -fX and -fno-X toggle the same feature
+    if (flag.starts_with("-f") && flag.size() > 2) {
+        auto name = flag.substr(2);
+        return "-f" + (name.starts_with("no-") ? name.substr(3) : name);
+    }
+    return std::nullopt;
+}
+
+// Flags that may move ahead of a target's own flags into toolchain config
+bool is_hoistable(const FlagUnit& unit) {
+    return unit.size() == 1 && (override_key(unit) || unit[0].starts_with("-W"));
+}
+
+bool is_cxx_rule(Buck2RuleType type) {
+    return type == Buck2RuleType::CxxLibrary || type == Buck2RuleType::CxxBinary ||
+           type == Buck2RuleType::CxxTest;
+}
+
+std::string flag_set_key(const TargetMapper::MappedTarget& target) {
+    std::string key;
+    for (const auto& flag : target.preprocessor_flags) {
+        key += flag + '\x1f';
+    }
+    key += '\x1e';
+    for (const auto& flag : target.compiler_flags) {
+        key += flag + '\x1f';
+    }
+    return key;
+}
+
+// Flags (single-token units) present in every one of the given flag lists
+std::vector<std::string>
+common_hoistable_flags(const std::vector<std::vector<std::string>*>& flag_lists) {
+    std::vector<std::string> common;
+    if (flag_lists.empty()) {
+        return common;
+    }
+
+    std::map<std::string, size_t> occurrences;
+    for (const auto* flags : flag_lists) {
+        std::set<std::string> seen;
+        for (const auto& unit : split_units(*flags)) {
+            if (is_hoistable(unit) && seen.insert(unit[0]).second) {
+                ++occurrences[unit[0]];
+            }
+        }
+    }
+
+    // Keep the order of the first list so the toolchain flags read naturally
+    for (const auto& unit : split_units(*flag_lists.front())) {
+        if (unit.size() == 1 && occurrences[unit[0]] == flag_lists.size()) {
+            common.push_back(unit[0]);
+        }
+    }
+    return common;
+}
+
+void remove_flags(std::vector<std::string>& flags, const std::vector<std::string>& hoisted) {
+    std::set<std::string> hoisted_set(hoisted.begin(), hoisted.end());
+    auto units = split_units(flags);
+    std::erase_if(units, [&](const FlagUnit& unit) {
+        return unit.size() == 1 && hoisted_set.contains(unit[0]);
+    });
+    flags = flatten_units(units);
+}
+
+} // namespace
+
+FlagCanonicalizer::FlagCanonicalizer(bool hoist_common_flags)
+    : hoist_common_flags_(hoist_common_flags) {}
+
+std::vector<std::string>
+FlagCanonicalizer::canonicalize_preprocessor_flags(const std::vector<std::string>& flags) {
+    std::vector<FlagUnit> ordered;
+    std::set<FlagUnit> seen;
+    std::map<std::string, FlagUnit> macros; // last -D/-U per macro wins
+
+    for (auto& unit : split_units(flags)) {
+        if (auto macro = macro_name(unit)) {
+            macros[*macro] = std::move(unit);
+        } else if (is_pass_through(unit) || seen.insert(unit).second) {
+            ordered.push_back(std::move(unit));
+        }
+    }
+
+    // -D/-U are applied before any -include, so they can follow the other flags
+    for (auto& [macro, unit] : macros) {
+        ordered.push_back(std::move(unit));
+    }
+    return flatten_units(ordered);
+}
+
+std::vector<std::string>
+FlagCanonicalizer::canonicalize_compiler_flags(const std::vector<std::string>& flags) {
+    auto units = split_units(flags);
+
+    std::map<std::string, size_t> last_override;
+    for (size_t i = 0; i < units.size(); ++i) {
+        if (auto key = override_key(units[i])) {
+            last_override[*key] = i;
+        }
+    }
+
+    std::vector<FlagUnit> kept;
+    std::set<FlagUnit> seen;
+    for (size_t i = 0; i < units.size(); ++i) {
+        if (auto key = override_key(units[i])) {
+            if (last_override[*key] == i) {
+                kept.push_back(std::move(units[i]));
+            }
+        } else if (is_pass_through(units[i]) || seen.insert(units[i]).second) {
+            kept.push_back(std::move(units[i]));
+        }
+    }
+    return flatten_units(kept);
+}
+
+FlagCanonicalizer::Report
+FlagCanonicalizer::canonicalize(const std::vector<TargetMapper::MappedTarget*>& targets) const {
+    Report report;
+
+    std::vector<TargetMapper::MappedTarget*> cxx_targets;
+    for (auto* target : targets) {
+        if (is_cxx_rule(target->rule_type)) {
+            cxx_targets.push_back(target);
+        }
+    }
+    report.targets_considered = cxx_targets.size();
+
+    std::set<std::string> flag_sets_before;
+    for (auto* target : cxx_targets) {
+        flag_sets_before.insert(flag_set_key(*target));
+
+        size_t flag_count = target->preprocessor_flags.size() + target->compiler_flags.size();
+        target->preprocessor_flags = canonicalize_preprocessor_flags(target->preprocessor_flags);
+        target->compiler_flags = canonicalize_compiler_flags(target->compiler_flags);
+        report.flags_removed +=
+            flag_count - target->preprocessor_flags.size() - target->compiler_flags.size();
+    }
+    report.distinct_flag_sets_before = flag_sets_before.size();
+
+    // Hoisting only pays off (and is only safe to infer) with several targets
+    if (hoist_common_flags_ && cxx_targets.size() > 1) {
+        std::vector<std::vector<std::string>*> preprocessor_lists;
+        std::vector<std::vector<std::string>*> compiler_lists;
+        for (auto* target : cxx_targets) {
+            preprocessor_lists.push_back(&target->preprocessor_flags);
+            compiler_lists.push_back(&target->compiler_flags);
+        }
+
+        for (auto& flag : common_hoistable_flags(preprocessor_lists)) {
+            // Include paths are package-relative; only macros move to the toolchain
+            if (macro_name({flag})) {
+                report.hoisted_preprocessor_flags.push_back(std::move(flag));
+            }
+        }
+        report.hoisted_compiler_flags = common_hoistable_flags(compiler_lists);
+
+        for (auto* target : cxx_targets) {
+            remove_flags(target->preprocessor_flags, report.hoisted_preprocessor_flags);
+            remove_flags(target->compiler_flags, report.hoisted_compiler_flags);
+        }
+    }
+
+    std::set<std::string> flag_sets_after;
+    for (auto* target : cxx_targets) {
+        flag_sets_after.insert(flag_set_key(*target));
+    }
+    report.distinct_flag_sets_after = flag_sets_after.size();
+
+    return report;
+}
+
+std::string FlagCanonicalizer::Report::to_string() const {
+    return fmt::format("Flag canonicalization: {} targets, {} -> {} distinct flag sets, "
+                       "{} redundant flags removed, {} flags hoisted to .buckconfig",
+                       targets_considered, distinct_flag_sets_before, distinct_flag_sets_after,
+                       flags_removed,
+                       hoisted_preprocessor_flags.size() + hoisted_compiler_flags.size());
+}
+
+} // namespace finch::generator
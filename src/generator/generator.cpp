@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <filesystem>
 #include <finch/analyzer/project_analysis.hpp>
 #include <finch/generator/generator.hpp>
@@ -14,7 +15,10 @@ namespace fs = std::filesystem;
 
 Generator::Generator(const Config& config)
     : target_mapper_(std::make_unique<TargetMapper>()),
-      template_registry_(std::make_unique<TemplateRegistry>()), config_(config) {}
+      template_registry_(std::make_unique<TemplateRegistry>()), config_(config) {
+    target_mapper_->set_default_unity_batch_size(config_.unity_batch_size);
+    target_mapper_->set_platforms(config_.platforms);
+}
 
 Generator::~Generator() = default;
 
@@ -23,10 +27,32 @@ Generator::generate(const analyzer::ProjectAnalysis& analysis) {
     GenerationResult result;
     result.targets_processed = 0;
 
-    // Group targets by directory and generate BUCK files
-    std::map<fs::path, std::vector<analyzer::Target>> targets_by_dir;
+    target_mapper_->set_external_packages(analysis.external_packages);
+
+    // Map all targets up front, grouped by directory, so flags can be
+    // canonicalized across the whole project before anything is written
+    std::map<fs::path, std::vector<TargetMapper::MappedTarget>> targets_by_dir;
+    auto current_directory = PathId(fs::current_path());
     for (const auto& target : analysis.targets) {
-        targets_by_dir[target.source_directory].push_back(target);
+        auto mapped_result = target_mapper_->map_cmake_target(target);
+        if (!mapped_result) {
+            return Result<GenerationResult, GenerationError>(std::in_place_index<1>,
+                                                             mapped_result.error());
+        }
+        // Relative to the working directory, spelled once per target
+        auto directory = (current_directory / target.source_directory).relative_to(current_directory);
+        targets_by_dir[directory.path()].push_back(std::move(mapped_result.value()));
+    }
+
+    if (config_.canonicalize_flags) {
+        std::vector<TargetMapper::MappedTarget*> all_targets;
+        for (auto& [dir, targets] : targets_by_dir) {
+            for (auto& target : targets) {
+                all_targets.push_back(&target);
+            }
+        }
+        FlagCanonicalizer canonicalizer(config_.hoist_common_flags);
+        result.flag_report = canonicalizer.canonicalize(all_targets);
     }
 
     // Generate BUCK file for each directory
@@ -34,8 +60,7 @@ Generator::generate(const analyzer::ProjectAnalysis& analysis) {
         fs::path output_path = config_.output_directory / "BUCK";
         if (targets_by_dir.size() > 1) {
             // Multiple directories - create BUCK files in subdirectories
-            fs::path relative_dir = fs::relative(dir, fs::current_path());
-            output_path = config_.output_directory / relative_dir / "BUCK";
+            output_path = config_.output_directory / dir / "BUCK";
         }
 
         auto buck_file_result = generate_buck_file(output_path, targets);
@@ -48,8 +73,44 @@ Generator::generate(const analyzer::ProjectAnalysis& analysis) {
         result.targets_processed += targets.size();
     }
 
+    // Installed packages found by find_package() share one third_party
+    // package with the sources CPM downloads
+    std::vector<TargetMapper::MappedTarget> packages;
+    for (const auto& package : analysis.external_packages) {
+        packages.push_back(target_mapper_->map_external_package(package));
+    }
+    for (const auto& package : analysis.cpm_packages) {
+        // A package found installed is used as is, as CPMFindPackage() does
+        bool installed = std::any_of(
+            analysis.external_packages.begin(), analysis.external_packages.end(),
+            [&](const auto& external) { return external.name == package.name; });
+        if (installed) {
+            continue;
+        }
+        auto archive = target_mapper_->map_cpm_package(package);
+        if (!archive) {
+            result.warnings.push_back("CPM package " + package.name +
+                                      " is not downloaded from an archive; add it by hand");
+            continue;
+        }
+        if (package.sha256.empty()) {
+            result.warnings.push_back("http_archive " + archive->name +
+                                      " has no sha256; add one before building");
+        }
+        packages.push_back(std::move(*archive));
+    }
+    if (!packages.empty()) {
+        fs::path output_path = config_.output_directory / "third_party" / "BUCK";
+        auto buck_file_result = generate_buck_file(output_path, packages);
+        if (!buck_file_result) {
+            return Result<GenerationResult, GenerationError>(std::in_place_index<1>,
+                                                             buck_file_result.error());
+        }
+        result.generated_files.push_back(output_path);
+    }
+
     // Generate .buckconfig
-    auto config_result = generate_buckconfig(analysis);
+    auto config_result = generate_buckconfig(analysis, result.flag_report);
     if (!config_result) {
         return Result<GenerationResult, GenerationError>(std::in_place_index<1>,
                                                          config_result.error());
@@ -62,24 +123,20 @@ Generator::generate(const analyzer::ProjectAnalysis& analysis) {
 
 Result<void, GenerationError>
 Generator::generate_buck_file(const fs::path& output_path,
-                              const std::vector<analyzer::Target>& targets) {
+                              const std::vector<TargetMapper::MappedTarget>& targets) {
     StarlarkWriter writer(true);
 
     // Add load statements - collect all needed symbols
     std::set<std::string> needed_symbols;
-    for (const auto& target : targets) {
-        auto mapped_result = target_mapper_->map_cmake_target(target);
-        if (!mapped_result) {
-            return Result<void, GenerationError>::error(mapped_result.error());
-        }
-
-        const auto& mapped = mapped_result.value();
+    for (const auto& mapped : targets) {
         if (mapped.rule_type == Buck2RuleType::CxxLibrary) {
             needed_symbols.insert("cxx_library");
         } else if (mapped.rule_type == Buck2RuleType::CxxBinary) {
             needed_symbols.insert("cxx_binary");
         } else if (mapped.rule_type == Buck2RuleType::CxxTest) {
             needed_symbols.insert("cxx_test");
+        } else if (mapped.rule_type == Buck2RuleType::PrebuiltCxxLibrary) {
+            needed_symbols.insert("prebuilt_cxx_library");
         }
     }
 
@@ -90,19 +147,24 @@ Generator::generate_buck_file(const fs::path& output_path,
 
     writer.add_blank_line();
 
-    for (const auto& target : targets) {
-        auto mapped_result = target_mapper_->map_cmake_target(target);
-        if (!mapped_result) {
-            return Result<void, GenerationError>::error(mapped_result.error());
-        }
-
-        const auto& mapped = mapped_result.value();
+    for (const auto& mapped : targets) {
         const auto* rule_template = template_registry_->get_template(mapped.rule_type);
         if (!rule_template) {
             return Result<void, GenerationError>::error(GenerationError(
                 GenerationError::Category::MissingTemplate, "No template found for rule type"));
         }
 
+        // Rules producing generated sources must precede the target using them
+        for (const auto& generated : mapped.generated_sources) {
+            const auto* generated_template = template_registry_->get_template(generated.rule_type);
+            if (!generated_template) {
+                return Result<void, GenerationError>::error(
+                    GenerationError(GenerationError::Category::MissingTemplate,
+                                    "No template found for generated source rule type"));
+            }
+            writer.add_rule(generated_template->generate(generated));
+        }
+
         // Use the template to generate the rule
         std::string rule_content = rule_template->generate(mapped);
         writer.add_rule(rule_content);
@@ -113,9 +175,32 @@ Generator::generate_buck_file(const fs::path& output_path,
 }
 
 Result<void, GenerationError>
-Generator::generate_buckconfig(const analyzer::ProjectAnalysis& analysis) {
+Generator::generate_buckconfig(const analyzer::ProjectAnalysis& analysis,
+                               const FlagCanonicalizer::Report& flags) {
     fs::path config_path = config_.output_directory / ".buckconfig";
 
+    // Hoisted flags follow the defaults so they take precedence over them
+    auto join = [](const std::vector<std::string>& items) {
+        std::string joined;
+        for (const auto& item : items) {
+            joined += (joined.empty() ? "" : " ") + item;
+        }
+        return joined;
+    };
+    auto language_flags = [&](std::vector<std::string> base, bool cxx) {
+        for (const auto& flag : flags.hoisted_compiler_flags) {
+            bool cxx_standard = flag.starts_with("-std=c++") || flag.starts_with("-std=gnu++");
+            if (!flag.starts_with("-std=") || cxx_standard == cxx) {
+                base.push_back(flag);
+            }
+        }
+        return join(FlagCanonicalizer::canonicalize_compiler_flags(base));
+    };
+
+    std::vector<std::string> ppflags = {"-Wall", "-Wextra"};
+    ppflags.insert(ppflags.end(), flags.hoisted_preprocessor_flags.begin(),
+                   flags.hoisted_preprocessor_flags.end());
+
     std::string config_content = R"([buildfile]
 name = BUCK
 
@@ -128,9 +213,14 @@ ide = vscode
 
 [cxx]
 default_platform = //toolchains:cxx
-cxxflags = -std=c++20
-cxxppflags = -Wall -Wextra
-
+)";
+    config_content += "cxxflags = " + language_flags({"-std=c++20"}, true) + "\n";
+    config_content += "cxxppflags = " + join(ppflags) + "\n";
+    if (!flags.hoisted_compiler_flags.empty() || !flags.hoisted_preprocessor_flags.empty()) {
+        config_content += "cflags = " + language_flags({}, false) + "\n";
+        config_content += "cppflags = " + join(flags.hoisted_preprocessor_flags) + "\n";
+    }
+    config_content += R"(
 [repositories]
 prelude = buck2/prelude
 toolchains = toolchains
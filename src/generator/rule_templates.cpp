@@ -1,27 +1,92 @@
 #include <finch/generator/rule_templates.hpp>
 #include <finch/generator/target_mapper.hpp>
+#include <map>
 
 namespace finch::generator {
 
+namespace {
+
+std::string render_select(const PlatformSelect& select) {
+    std::string result = "select({";
+    for (const auto& clause : select.clauses) {
+        result += "\"" + clause.condition + "\": " + clause.value + ", ";
+    }
+    result += "\"DEFAULT\": " + select.default_value.value_or("[]") + "})";
+    return result;
+}
+
+// " + select(...)" with what some platforms add to an attribute, or ""
+std::string platform_suffix(const TargetMapper::MappedTarget& target,
+                            const std::string& attribute) {
+    auto it = target.platform_selects.find(attribute);
+    return it == target.platform_selects.end() ? "" : " + " + render_select(it->second);
+}
+
+bool has_attribute(const TargetMapper::MappedTarget& target, const std::vector<std::string>& items,
+                   const std::string& attribute) {
+    return !items.empty() || target.platform_selects.contains(attribute);
+}
+
+// Custom properties plus the (canonicalized) flag lists, ordered by attribute name
+std::map<std::string, std::string> rule_attributes(const TargetMapper::MappedTarget& target) {
+    auto attributes = target.properties;
+
+    auto add_list = [&](const std::string& key, const std::vector<std::string>& items) {
+        if (items.empty()) {
+            return;
+        }
+        std::string value = "[";
+        for (size_t i = 0; i < items.size(); ++i) {
+            value += "\"" + items[i] + "\"";
+            if (i < items.size() - 1) {
+                value += ", ";
+            }
+        }
+        value += "]";
+        attributes[key] = value;
+    };
+    add_list("preprocessor_flags", target.preprocessor_flags);
+    add_list("compiler_flags", target.compiler_flags);
+    add_list("compatible_with", target.compatible_with);
+
+    // srcs and deps are written by the templates themselves
+    for (const auto& [attribute, select] : target.platform_selects) {
+        if (attribute == "srcs" || attribute == "deps") {
+            continue;
+        }
+        auto it = attributes.find(attribute);
+        attributes[attribute] =
+            (it != attributes.end() ? it->second + " + " : "") + render_select(select);
+    }
+
+    return attributes;
+}
+
+} // namespace
+
 // CxxLibraryTemplate implementation
 std::string CxxLibraryTemplate::generate(const TargetMapper::MappedTarget& target) const {
     std::string result = "cxx_library(\n";
     result += "    name = \"" + target.name + "\",\n";
 
     // Add sources with proper formatting
-    if (!target.srcs.empty()) {
+    if (has_attribute(target, target.srcs, "srcs")) {
         result += "    srcs = [\n";
         for (const auto& src : target.srcs) {
             result += "        \"" + src + "\",\n";
         }
-        result += "    ],\n";
+        result += "    ]" + platform_suffix(target, "srcs") + ",\n";
     }
 
-    // Add headers with glob pattern if appropriate
+    // Headers found by the include scanner are exported exactly; otherwise
+    // fall back to a glob
     if (!target.headers.empty()) {
-        result += "    headers = glob([\"**/*.h\", \"**/*.hpp\"]),\n";
+        result += "    exported_headers = [\n";
+        for (const auto& header : target.headers) {
+            result += "        \"" + header + "\",\n";
+        }
+        result += "    ],\n";
     } else {
-        // Even without explicit headers, we often want to include headers
         result += "    headers = glob([\"**/*.h\", \"**/*.hpp\"]),\n";
     }
 
@@ -32,16 +97,16 @@ std::string CxxLibraryTemplate::generate(const TargetMapper::MappedTarget& targe
     result += "    header_namespace = \"" + target.name + "\",\n";
 
     // Add dependencies
-    if (!target.deps.empty()) {
+    if (has_attribute(target, target.deps, "deps")) {
         result += "    deps = [\n";
         for (const auto& dep : target.deps) {
             result += "        \"" + dep + "\",\n";
         }
-        result += "    ],\n";
+        result += "    ]" + platform_suffix(target, "deps") + ",\n";
     }
 
     // Add custom properties
-    for (const auto& [key, value] : target.properties) {
+    for (const auto& [key, value] : rule_attributes(target)) {
         result += "    " + key + " = " + value + ",\n";
     }
 
@@ -55,12 +120,12 @@ std::string CxxBinaryTemplate::generate(const TargetMapper::MappedTarget& target
     result += "    name = \"" + target.name + "\",\n";
 
     // Add sources with proper formatting
-    if (!target.srcs.empty()) {
+    if (has_attribute(target, target.srcs, "srcs")) {
         result += "    srcs = [\n";
         for (const auto& src : target.srcs) {
             result += "        \"" + src + "\",\n";
         }
-        result += "    ],\n";
+        result += "    ]" + platform_suffix(target, "srcs") + ",\n";
     }
 
     // Add headers if present
@@ -73,16 +138,16 @@ std::string CxxBinaryTemplate::generate(const TargetMapper::MappedTarget& target
     }
 
     // Add dependencies
-    if (!target.deps.empty()) {
+    if (has_attribute(target, target.deps, "deps")) {
         result += "    deps = [\n";
         for (const auto& dep : target.deps) {
             result += "        \"" + dep + "\",\n";
         }
-        result += "    ],\n";
+        result += "    ]" + platform_suffix(target, "deps") + ",\n";
     }
 
     // Add custom properties
-    for (const auto& [key, value] : target.properties) {
+    for (const auto& [key, value] : rule_attributes(target)) {
         result += "    " + key + " = " + value + ",\n";
     }
 
@@ -95,14 +160,14 @@ std::string CxxTestTemplate::generate(const TargetMapper::MappedTarget& target)
     std::string result = "cxx_test(\n";
     result += "    name = \"" + target.name + "\",\n";
 
-    if (!target.srcs.empty()) {
+    if (has_attribute(target, target.srcs, "srcs")) {
         result += "    srcs = [";
         for (size_t i = 0; i < target.srcs.size(); ++i) {
             result += "\"" + target.srcs[i] + "\"";
             if (i < target.srcs.size() - 1)
                 result += ", ";
         }
-        result += "],\n";
+        result += "]" + platform_suffix(target, "srcs") + ",\n";
     }
 
     if (!target.headers.empty()) {
@@ -115,17 +180,39 @@ std::string CxxTestTemplate::generate(const TargetMapper::MappedTarget& target)
         result += "],\n";
     }
 
-    if (!target.deps.empty()) {
+    if (has_attribute(target, target.deps, "deps")) {
         result += "    deps = [";
         for (size_t i = 0; i < target.deps.size(); ++i) {
             result += "\"" + target.deps[i] + "\"";
             if (i < target.deps.size() - 1)
                 result += ", ";
         }
-        result += "],\n";
+        result += "]" + platform_suffix(target, "deps") + ",\n";
     }
 
     // Add custom properties
+    for (const auto& [key, value] : rule_attributes(target)) {
+        result += "    " + key + " = " + value + ",\n";
+    }
+
+    result += ")";
+    return result;
+}
+
+// GenruleTemplate implementation
+std::string GenruleTemplate::generate(const TargetMapper::MappedTarget& target) const {
+    std::string result = "genrule(\n";
+    result += "    name = \"" + target.name + "\",\n";
+
+    if (!target.srcs.empty()) {
+        result += "    srcs = [\n";
+        for (const auto& src : target.srcs) {
+            result += "        \"" + src + "\",\n";
+        }
+        result += "    ],\n";
+    }
+
+    // out and cmd are carried as preformatted properties
     for (const auto& [key, value] : target.properties) {
         result += "    " + key + " = " + value + ",\n";
     }
@@ -134,6 +221,41 @@ std::string CxxTestTemplate::generate(const TargetMapper::MappedTarget& target)
     return result;
 }
 
+// PrebuiltCxxLibraryTemplate implementation
+std::string PrebuiltCxxLibraryTemplate::generate(const TargetMapper::MappedTarget& target) const {
+    std::string result = "prebuilt_cxx_library(\n";
+    result += "    name = \"" + target.name + "\",\n";
+    result += "    visibility = [\"PUBLIC\"],\n";
+
+    // Consumers need the headers and link flags of the packages this one uses
+    if (!target.deps.empty()) {
+        result += "    exported_deps = [\n";
+        for (const auto& dep : target.deps) {
+            result += "        \"" + dep + "\",\n";
+        }
+        result += "    ],\n";
+    }
+
+    // Flags are carried as preformatted properties
+    for (const auto& [key, value] : rule_attributes(target)) {
+        result += "    " + key + " = " + value + ",\n";
+    }
+
+    result += ")";
+    return result;
+}
+
+std::string HttpArchiveTemplate::generate(const TargetMapper::MappedTarget& target) const {
+    std::string result = "http_archive(\n";
+    result += "    name = \"" + target.name + "\",\n";
+    for (const auto& [key, value] : rule_attributes(target)) {
+        result += "    " + key + " = " + value + ",\n";
+    }
+    result += "    visibility = [\"PUBLIC\"],\n";
+    result += ")";
+    return result;
+}
+
 // TemplateRegistry implementation
 TemplateRegistry::TemplateRegistry() {
     register_default_templates();
@@ -157,6 +279,10 @@ void TemplateRegistry::register_default_templates() {
     register_template(Buck2RuleType::CxxLibrary, std::make_unique<CxxLibraryTemplate>());
     register_template(Buck2RuleType::CxxBinary, std::make_unique<CxxBinaryTemplate>());
     register_template(Buck2RuleType::CxxTest, std::make_unique<CxxTestTemplate>());
+    register_template(Buck2RuleType::Genrule, std::make_unique<GenruleTemplate>());
+    register_template(Buck2RuleType::PrebuiltCxxLibrary,
+                      std::make_unique<PrebuiltCxxLibraryTemplate>());
+    register_template(Buck2RuleType::HttpArchive, std::make_unique<HttpArchiveTemplate>());
 }
 
 } // namespace finch::generator
@@ -1,38 +1,114 @@
 #include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <finch/analyzer/evaluation_context.hpp>
+#include <finch/analyzer/generator_expression.hpp>
+#include <finch/analyzer/platforms.hpp>
 #include <finch/analyzer/project_analysis.hpp>
 #include <finch/generator/target_mapper.hpp>
+#include <queue>
 
 namespace finch::generator {
 
+namespace {
+
+// Language of a source file for unity grouping; C and C++ sources never share a batch
+std::optional<std::string> unity_language(const std::string& source) {
+    auto ext = std::filesystem::path(source).extension().string();
+    if (ext == ".cpp" || ext == ".cc" || ext == ".cxx" || ext == ".c++" || ext == ".C") {
+        return "cpp";
+    }
+    if (ext == ".c") {
+        return "c";
+    }
+    return std::nullopt;
+}
+
+// CMake definitions are bare (FOO or FOO=1); Buck2 expects compiler syntax
+std::vector<std::string> preprocessor_flags(const std::vector<std::string>& definitions) {
+    std::vector<std::string> flags;
+    for (const auto& definition : definitions) {
+        flags.push_back(definition.starts_with("-") ? definition : "-D" + definition);
+    }
+    return flags;
+}
+
+std::vector<std::string> path_strings(const PathList& paths) {
+    std::vector<std::string> strings;
+    for (auto path : paths) {
+        strings.push_back(path.str());
+    }
+    return strings;
+}
+
+std::string format_string_list(const std::vector<std::string>& items) {
+    std::string result = "[";
+    for (size_t i = 0; i < items.size(); ++i) {
+        result += "\"" + items[i] + "\"";
+        if (i < items.size() - 1) {
+            result += ", ";
+        }
+    }
+    result += "]";
+    return result;
+}
+
+// owner/repo of a GitHub repository URL
+std::optional<std::string> github_repository(std::string_view url) {
+    for (std::string_view host : {"https://github.com/", "http://github.com/", "git@github.com:"}) {
+        if (url.starts_with(host)) {
+            url.remove_prefix(host.size());
+            if (url.ends_with(".git")) {
+                url.remove_suffix(4);
+            }
+            if (url.find('/') != std::string_view::npos) {
+                return std::string(url);
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
 TargetMapper::TargetMapper() = default;
 TargetMapper::~TargetMapper() = default;
 
 Result<TargetMapper::MappedTarget, GenerationError>
-TargetMapper::map_cmake_target(const analyzer::Target& cmake_target) {
+TargetMapper::map_cmake_target(const analyzer::Target& original) {
+    // Generator expressions become select() clauses, or plain items where
+    // every platform agrees on them
+    std::optional<analyzer::Target> lowered;
+    if (analyzer::has_generator_expressions(original)) {
+        lowered = analyzer::lower_generator_expressions(
+            original, platforms_ ? *platforms_ : analyzer::PlatformSet::known());
+    }
+    const auto& cmake_target = lowered ? *lowered : original;
+
     MappedTarget mapped;
     mapped.name = normalize_target_name(cmake_target.name);
     mapped.rule_type = determine_rule_type(cmake_target);
     mapped.srcs = transform_sources(cmake_target.sources);
-    mapped.headers = cmake_target.headers;
-    mapped.deps = resolve_dependencies(cmake_target.link_libraries);
-
-    // Set basic properties
-    if (!cmake_target.compile_definitions.empty()) {
-        std::string defs_str = "[";
-        for (size_t i = 0; i < cmake_target.compile_definitions.size(); ++i) {
-            defs_str += "\"" + cmake_target.compile_definitions[i] + "\"";
-            if (i < cmake_target.compile_definitions.size() - 1) {
-                defs_str += ", ";
+    mapped.headers = path_strings(cmake_target.headers);
+    // Headers are not compiled, so those of every platform are exported
+    for (const auto& [name, variant] : cmake_target.platform_variants) {
+        for (auto& header : path_strings(variant.headers)) {
+            if (std::find(mapped.headers.begin(), mapped.headers.end(), header) ==
+                mapped.headers.end()) {
+                mapped.headers.push_back(std::move(header));
             }
         }
-        defs_str += "]";
-        mapped.properties["preprocessor_flags"] = defs_str;
     }
+    mapped.deps = resolve_dependencies(cmake_target.link_libraries);
+
+    mapped.preprocessor_flags = preprocessor_flags(cmake_target.compile_definitions);
+    mapped.compiler_flags = cmake_target.compile_options;
 
-    if (!cmake_target.include_directories.empty()) {
+    // Explicit header lists are emitted by the rule templates instead
+    if (!cmake_target.include_directories.empty() && mapped.headers.empty()) {
         std::string includes_str = "[";
         for (size_t i = 0; i < cmake_target.include_directories.size(); ++i) {
-            includes_str += "\"" + cmake_target.include_directories[i] + "\"";
+            includes_str += "\"" + cmake_target.include_directories[i].str() + "\"";
             if (i < cmake_target.include_directories.size() - 1) {
                 includes_str += ", ";
             }
@@ -41,33 +117,275 @@ TargetMapper::map_cmake_target(const analyzer::Target& cmake_target) {
         mapped.properties["exported_headers"] = includes_str;
     }
 
-    // Handle compiler options
-    if (!cmake_target.compile_options.empty()) {
-        std::string flags_str = "[";
-        for (size_t i = 0; i < cmake_target.compile_options.size(); ++i) {
-            flags_str += "\"" + cmake_target.compile_options[i] + "\"";
-            if (i < cmake_target.compile_options.size() - 1) {
-                flags_str += ", ";
+    // Libraries outside the project; a library passes them on to what links it
+    if (!cmake_target.link_flags.empty()) {
+        mapped.properties[mapped.rule_type == Buck2RuleType::CxxBinary ? "linker_flags"
+                                                                       : "exported_linker_flags"] =
+            format_string_list(cmake_target.link_flags);
+    }
+
+    map_platform_variants(cmake_target, mapped);
+
+    // Preserve CMake unity builds as generated jumbo sources
+    if (auto it = cmake_target.properties.find("UNITY_BUILD");
+        it != cmake_target.properties.end() &&
+        analyzer::value_helpers::is_truthy(analyzer::Value(it->second)) &&
+        (mapped.rule_type == Buck2RuleType::CxxLibrary ||
+         mapped.rule_type == Buck2RuleType::CxxBinary)) {
+        map_unity_build(cmake_target, mapped);
+    }
+
+    return Ok<TargetMapper::MappedTarget, GenerationError>(std::move(mapped));
+}
+
+void TargetMapper::set_external_packages(const std::vector<analyzer::ExternalPackage>& packages) {
+    external_labels_.clear();
+    for (const auto& package : packages) {
+        for (const auto& target : package.imported_targets) {
+            external_labels_[target].push_back(external_package_label(package));
+        }
+    }
+}
+
+std::string TargetMapper::external_package_label(const analyzer::ExternalPackage& package) {
+    return "//third_party:" + normalize_target_name(package.name);
+}
+
+TargetMapper::MappedTarget
+TargetMapper::map_external_package(const analyzer::ExternalPackage& package) {
+    MappedTarget mapped;
+    mapped.name = normalize_target_name(package.name);
+    mapped.rule_type = Buck2RuleType::PrebuiltCxxLibrary;
+
+    // Installed files live outside the repository, so they are passed as
+    // flags rather than as static_lib/shared_lib sources
+    std::vector<std::string> preprocessor_flags;
+    for (const auto& dir : package.include_directories) {
+        preprocessor_flags.push_back("-isystem" + dir);
+    }
+    if (!preprocessor_flags.empty()) {
+        mapped.properties["exported_preprocessor_flags"] = format_string_list(preprocessor_flags);
+    }
+    if (!package.libraries.empty()) {
+        mapped.properties["exported_linker_flags"] = format_string_list(package.libraries);
+    }
+    mapped.properties["header_only"] = "True";
+
+    // Dependencies on other indexed packages; the rest are left to the linker flags
+    for (const auto& dependency : package.dependencies) {
+        if (auto it = external_labels_.find(dependency); it != external_labels_.end()) {
+            for (const auto& label : it->second) {
+                if (label != external_package_label(package) &&
+                    std::find(mapped.deps.begin(), mapped.deps.end(), label) == mapped.deps.end()) {
+                    mapped.deps.push_back(label);
+                }
+            }
+        }
+    }
+    return mapped;
+}
+
+std::optional<TargetMapper::MappedTarget>
+TargetMapper::map_cpm_package(const analyzer::CPMPackage& package) {
+    MappedTarget mapped;
+    mapped.name = normalize_target_name(package.name);
+    mapped.rule_type = Buck2RuleType::HttpArchive;
+
+    using SourceType = analyzer::CPMPackage::SourceType;
+    if (!package.sha256.empty()) {
+        mapped.properties["sha256"] = "\"" + package.sha256 + "\"";
+    }
+    if (package.source_type == SourceType::URL) {
+        mapped.properties["urls"] = format_string_list({package.source});
+        return mapped;
+    }
+
+    std::optional<std::string> repository;
+    if (package.source_type == SourceType::GitHub) {
+        repository = package.source;
+    } else if (package.source_type == SourceType::Git) {
+        repository = github_repository(package.source);
+    }
+    // Without a tag CPM clones the default branch, which has no archive
+    std::string ref = !package.git_tag.empty()  ? package.git_tag
+                      : !package.version.empty() ? "v" + package.version
+                                                 : "";
+    if (!repository || ref.empty()) {
+        return std::nullopt;
+    }
+
+    // GitHub names the top directory after the tag without its 'v'
+    auto repo = repository->substr(repository->rfind('/') + 1);
+    bool v_tag = ref.size() > 1 && ref[0] == 'v' && std::isdigit(static_cast<unsigned char>(ref[1]));
+    mapped.properties["urls"] =
+        format_string_list({"https://github.com/" + *repository + "/archive/" + ref + ".tar.gz"});
+    mapped.properties["strip_prefix"] = "\"" + repo + "-" + (v_tag ? ref.substr(1) : ref) + "\"";
+    return mapped;
+}
+
+void TargetMapper::map_platform_variants(const analyzer::Target& cmake_target,
+                                         MappedTarget& mapped) {
+    for (const auto& [name, variant] : cmake_target.platform_variants) {
+        const auto* platform = analyzer::PlatformSet::find(name);
+        if (!platform) {
+            continue;
+        }
+        auto add_clause = [&](const std::string& attribute, const std::vector<std::string>& items) {
+            if (items.empty()) {
+                return;
             }
+            auto& select = mapped.platform_selects[attribute];
+            select.clauses.push_back({platform->constraint, format_string_list(items)});
+            select.default_value = "[]";
+        };
+        // The same attributes the common lists map to above
+        add_clause("srcs", transform_sources(variant.sources));
+        add_clause("deps", resolve_dependencies(variant.link_libraries));
+        add_clause("preprocessor_flags", preprocessor_flags(variant.compile_definitions));
+        add_clause("compiler_flags", variant.compile_options);
+        if (mapped.headers.empty()) {
+            add_clause("exported_headers", path_strings(variant.include_directories));
         }
-        flags_str += "]";
-        mapped.properties["compiler_flags"] = flags_str;
     }
 
-    // Handle linker options for executables
-    if (mapped.rule_type == Buck2RuleType::CxxBinary && !cmake_target.link_libraries.empty()) {
-        std::string link_flags = "[";
-        for (size_t i = 0; i < cmake_target.link_libraries.size(); ++i) {
-            link_flags += "\"" + cmake_target.link_libraries[i] + "\"";
-            if (i < cmake_target.link_libraries.size() - 1) {
-                link_flags += ", ";
+    for (const auto& name : cmake_target.platforms) {
+        if (const auto* platform = analyzer::PlatformSet::find(name)) {
+            mapped.compatible_with.push_back(platform->constraint);
+        }
+    }
+}
+
+void TargetMapper::map_unity_build(const analyzer::Target& cmake_target, MappedTarget& mapped) {
+    size_t batch_size = default_unity_batch_size_;
+    if (auto it = cmake_target.properties.find("UNITY_BUILD_BATCH_SIZE");
+        it != cmake_target.properties.end()) {
+        try {
+            batch_size = std::stoul(it->second);
+        } catch (...) {
+            // Keep the default for non-numeric values
+        }
+    }
+
+    // Group unity-eligible sources by language, keeping declaration order
+    std::map<std::string, std::vector<std::string>> sources_by_language;
+    std::vector<std::string> remaining_srcs;
+    for (const auto& src : mapped.srcs) {
+        if (auto language = unity_language(src)) {
+            sources_by_language[*language].push_back(src);
+        } else {
+            remaining_srcs.push_back(src);
+        }
+    }
+
+    std::vector<std::string> unified_sources;
+    std::vector<std::string> batch_labels;
+    for (auto& [language, sources] : sources_by_language) {
+        if (sources.size() < 2) {
+            // A single source gains nothing from aggregation
+            remaining_srcs.insert(remaining_srcs.end(), sources.begin(), sources.end());
+            continue;
+        }
+
+        std::vector<uintmax_t> sizes;
+        sizes.reserve(sources.size());
+        for (const auto& src : sources) {
+            std::error_code ec;
+            auto size = std::filesystem::file_size(cmake_target.source_directory.path() / src, ec);
+            sizes.push_back(ec ? 0 : size);
+        }
+
+        auto batches = partition_unity_batches(sources, sizes, batch_size);
+        for (size_t i = 0; i < batches.size(); ++i) {
+            MappedTarget genrule;
+            genrule.name = mapped.name + "__unity_" + language + "_" + std::to_string(i);
+            genrule.rule_type = Buck2RuleType::Genrule;
+
+            // The batch file only #includes the real sources, which the library
+            // exposes through raw_headers, so the genrule needs no inputs
+            std::string cmd = "printf '#include \\\"%s\\\"\\\\n'";
+            for (const auto& src : batches[i]) {
+                cmd += " '" + src + "'";
             }
+            cmd += " > $OUT";
+            genrule.properties["out"] = "\"" + genrule.name + "." + language + "\"";
+            genrule.properties["cmd"] = "\"" + cmd + "\"";
+
+            batch_labels.push_back(":" + genrule.name);
+            mapped.generated_sources.push_back(std::move(genrule));
         }
-        link_flags += "]";
-        mapped.properties["linker_flags"] = link_flags;
+        unified_sources.insert(unified_sources.end(), sources.begin(), sources.end());
     }
 
-    return Ok<TargetMapper::MappedTarget, GenerationError>(std::move(mapped));
+    if (unified_sources.empty()) {
+        return;
+    }
+
+    remaining_srcs.insert(remaining_srcs.end(), batch_labels.begin(), batch_labels.end());
+    mapped.srcs = std::move(remaining_srcs);
+    mapped.properties["raw_headers"] = format_string_list(unified_sources);
+
+    // The batch files include the sources by their path in the package; the
+    // target's own include directories still have to reach them as well
+    auto include_directories = path_strings(cmake_target.include_directories);
+    if (std::find(include_directories.begin(), include_directories.end(), ".") ==
+        include_directories.end()) {
+        include_directories.push_back(".");
+    }
+    mapped.properties["include_directories"] = format_string_list(include_directories);
+}
+
+std::vector<std::vector<std::string>>
+TargetMapper::partition_unity_batches(const std::vector<std::string>& sources,
+                                      const std::vector<uintmax_t>& source_sizes,
+                                      size_t batch_size) {
+    if (sources.empty()) {
+        return {};
+    }
+    if (batch_size == 0 || batch_size >= sources.size()) {
+        return {sources};
+    }
+
+    const size_t batch_count = (sources.size() + batch_size - 1) / batch_size;
+
+    // Largest sources first, each into the currently lightest batch with room left
+    std::vector<size_t> order(sources.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return source_sizes[a] > source_sizes[b];
+    });
+
+    using BatchLoad = std::pair<uintmax_t, size_t>; // (bytes, batch index)
+    std::priority_queue<BatchLoad, std::vector<BatchLoad>, std::greater<>> lightest;
+    for (size_t b = 0; b < batch_count; ++b) {
+        lightest.emplace(0, b);
+    }
+
+    std::vector<std::vector<size_t>> assignment(batch_count);
+    for (size_t idx : order) {
+        auto [bytes, batch] = lightest.top();
+        lightest.pop();
+        assignment[batch].push_back(idx);
+        if (assignment[batch].size() < batch_size) {
+            lightest.emplace(bytes + source_sizes[idx], batch);
+        }
+    }
+
+    // Keep declaration order inside each batch so output is stable
+    std::vector<std::vector<std::string>> batches;
+    batches.reserve(batch_count);
+    for (auto& indices : assignment) {
+        if (indices.empty()) {
+            continue;
+        }
+        std::sort(indices.begin(), indices.end());
+        auto& batch = batches.emplace_back();
+        for (size_t idx : indices) {
+            batch.push_back(sources[idx]);
+        }
+    }
+    return batches;
 }
 
 Buck2RuleType TargetMapper::determine_rule_type(const analyzer::Target& target) {
@@ -86,14 +404,15 @@ Buck2RuleType TargetMapper::determine_rule_type(const analyzer::Target& target)
     return Buck2RuleType::Unknown;
 }
 
-std::vector<std::string> TargetMapper::transform_sources(const std::vector<std::string>& sources) {
+std::vector<std::string> TargetMapper::transform_sources(const PathList& sources) {
     std::vector<std::string> transformed;
     transformed.reserve(sources.size());
 
-    for (const auto& source : sources) {
-        // Convert relative paths and filter out generated files
+    for (auto path : sources) {
+        auto source = path.str();
+        // Variables and generator expressions left unresolved cannot be built
         if (source.find("${") == std::string::npos && source.find("$<") == std::string::npos) {
-            transformed.push_back(source);
+            transformed.push_back(std::move(source));
         }
     }
 
@@ -106,7 +425,10 @@ std::vector<std::string> TargetMapper::resolve_dependencies(const std::vector<st
 
     for (const auto& dep : deps) {
         // Convert CMake target names to Buck2 target labels
-        if (dep.find("::") != std::string::npos) {
+        if (auto it = external_labels_.find(dep); it != external_labels_.end()) {
+            // Imported target of an installed package
+            resolved.insert(resolved.end(), it->second.begin(), it->second.end());
+        } else if (dep.find("::") != std::string::npos) {
             // External dependency - convert to Buck2 format
             std::string converted = dep;
             std::replace(converted.begin(), converted.end(), ':', '_');
@@ -69,7 +69,8 @@ std::unique_ptr<ASTNode> ListExpression::clone() const {
     for (const auto& elem : elements_) {
         cloned_elements.push_back(elem->clone());
     }
-    return std::make_unique<ListExpression>(location(), std::move(cloned_elements), separator_);
+    return std::make_unique<ListExpression>(location(), std::move(cloned_elements), separator_,
+                                            quoted_);
 }
 
 std::unique_ptr<ASTNode> GeneratorExpression::clone() const {
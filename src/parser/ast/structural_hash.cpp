@@ -0,0 +1,362 @@
+#include <finch/core/fnv_hash.hpp>
+#include <finch/parser/ast/commands.hpp>
+#include <finch/parser/ast/control_flow.hpp>
+#include <finch/parser/ast/cpm_nodes.hpp>
+#include <finch/parser/ast/expressions.hpp>
+#include <finch/parser/ast/literals.hpp>
+#include <finch/parser/ast/structural_hash.hpp>
+#include <finch/parser/ast/structure.hpp>
+#include <finch/parser/ast/visitor.hpp>
+#include <fmt/format.h>
+#include <vector>
+
+namespace finch::ast {
+
+namespace {
+
+void hash_value(uint64_t& hash, uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        hash = (hash ^ ((value >> shift) & 0xFF)) * 0x100000001B3ULL;
+    }
+}
+
+// A node apart from its children: its fields spelled as bytes, its
+// children in order (null where an operand is missing) and the bytes it
+// and its child lists take
+struct Shape {
+    std::string fields;
+    std::vector<const ASTNode*> children;
+    size_t bytes = 0;
+};
+
+class ShapeVisitor : public ASTVisitor {
+  public:
+    explicit ShapeVisitor(Shape& shape) : shape_(shape) {}
+
+    bool visited = false;
+
+    void visit(const StringLiteral& node) override {
+        field(node.value());
+        field(node.is_quoted());
+        size(node);
+    }
+
+    void visit(const NumberLiteral& node) override {
+        // The value is read from the text
+        field(node.text());
+        field(static_cast<int>(node.number_type()));
+        size(node);
+    }
+
+    void visit(const BooleanLiteral& node) override {
+        field(node.value());
+        field(node.original_text());
+        size(node);
+    }
+
+    void visit(const Variable& node) override {
+        field(node.name());
+        field(static_cast<int>(node.variable_type()));
+        field(node.is_quoted());
+        size(node);
+    }
+
+    void visit(const Identifier& node) override {
+        field(node.name());
+        size(node);
+    }
+
+    void visit(const CommandCall& node) override {
+        field(node.name());
+        children(node.arguments());
+        size(node);
+    }
+
+    void visit(const FunctionDef& node) override {
+        field(node.name());
+        names(node.parameters());
+        children(node.body());
+        size(node);
+    }
+
+    void visit(const MacroDef& node) override {
+        field(node.name());
+        names(node.parameters());
+        children(node.body());
+        size(node);
+    }
+
+    void visit(const IfStatement& node) override {
+        child(node.condition());
+        children(node.then_branch());
+        children(node.elseif_branches());
+        children(node.else_branch());
+        size(node);
+    }
+
+    void visit(const ElseIfStatement& node) override {
+        child(node.condition());
+        size(node);
+    }
+
+    void visit(const ElseStatement& node) override {
+        size(node);
+    }
+
+    void visit(const WhileStatement& node) override {
+        child(node.condition());
+        children(node.body());
+        size(node);
+    }
+
+    void visit(const ForEachStatement& node) override {
+        names(node.variables());
+        field(static_cast<int>(node.loop_type()));
+        children(node.items());
+        children(node.body());
+        size(node);
+    }
+
+    void visit(const ListExpression& node) override {
+        char separator = node.separator();
+        field(std::string_view(&separator, 1));
+        field(node.is_quoted());
+        children(node.elements());
+        size(node);
+    }
+
+    void visit(const GeneratorExpression& node) override {
+        field(node.expression());
+        size(node);
+    }
+
+    void visit(const BracketExpression& node) override {
+        field(node.is_quoted());
+        child(node.content());
+        size(node);
+    }
+
+    void visit(const BinaryOp& node) override {
+        field(static_cast<int>(node.op()));
+        child(node.left());
+        child(node.right());
+        size(node);
+    }
+
+    void visit(const UnaryOp& node) override {
+        field(static_cast<int>(node.op()));
+        child(node.operand());
+        size(node);
+    }
+
+    void visit(const FunctionCall& node) override {
+        field(node.name());
+        children(node.arguments());
+        size(node);
+    }
+
+    void visit(const Block& node) override {
+        children(node.statements());
+        size(node);
+    }
+
+    void visit(const File& node) override {
+        // Where the file is, like any location, is not part of it
+        children(node.statements());
+        size(node);
+    }
+
+    void visit(const ErrorNode& node) override {
+        field(node.message());
+        field(static_cast<int>(node.category()));
+        size(node);
+    }
+
+    // CPM nodes are built from a call's arguments after parsing; their
+    // printed form holds every field
+    void visit(const CPMAddPackage& node) override {
+        field(node.pretty_print(0));
+        size(node);
+    }
+
+    void visit(const CPMFindPackage& node) override {
+        field(node.pretty_print(0));
+        size(node);
+    }
+
+    void visit(const CPMUsePackageLock& node) override {
+        field(node.pretty_print(0));
+        size(node);
+    }
+
+    void visit(const CPMDeclarePackage& node) override {
+        field(node.pretty_print(0));
+        size(node);
+    }
+
+  private:
+    void field(std::string_view text) {
+        // Length first, so no two field lists spell the same bytes
+        shape_.fields += fmt::format("{}:", text.size());
+        shape_.fields.append(text);
+    }
+
+    void field(int value) {
+        shape_.fields += fmt::format("{};", value);
+    }
+
+    void field(bool value) {
+        shape_.fields += value ? "1;" : "0;";
+    }
+
+    void names(const std::vector<std::string_view>& names) {
+        field(static_cast<int>(names.size()));
+        for (auto name : names) {
+            field(name);
+        }
+        shape_.bytes += names.capacity() * sizeof(std::string_view);
+    }
+
+    void child(const ASTNode* node) {
+        shape_.children.push_back(node);
+    }
+
+    void children(const ASTNodeList& nodes) {
+        // The count marks where one list of children ends and the next begins
+        field(static_cast<int>(nodes.size()));
+        for (const auto& node : nodes) {
+            shape_.children.push_back(node.get());
+        }
+        shape_.bytes += nodes.capacity() * sizeof(ASTNodePtr);
+    }
+
+    template <typename T>
+    void size(const T&) {
+        shape_.bytes += sizeof(T);
+        visited = true;
+    }
+
+    Shape& shape_;
+};
+
+Shape shape_of(const ASTNode& node) {
+    Shape shape;
+    ShapeVisitor visitor(shape);
+    node.accept(visitor);
+    if (!visitor.visited) {
+        // A node type the visitor interface does not cover
+        shape.fields = node.to_string();
+    }
+    return shape;
+}
+
+struct SubtreeSize {
+    size_t nodes = 0;
+    size_t bytes = 0;
+};
+
+SubtreeSize size_of(const ASTNode& root) {
+    SubtreeSize size;
+    std::vector<const ASTNode*> pending{&root};
+    while (!pending.empty()) {
+        const auto* node = pending.back();
+        pending.pop_back();
+        if (!node) {
+            continue;
+        }
+        auto shape = shape_of(*node);
+        ++size.nodes;
+        size.bytes += shape.bytes;
+        pending.insert(pending.end(), shape.children.begin(), shape.children.end());
+    }
+    return size;
+}
+
+} // namespace
+
+uint64_t compute_structural_hash(const ASTNode& node) {
+    auto shape = shape_of(node);
+    uint64_t hash = fnv_offset_basis;
+    hash_value(hash, static_cast<uint64_t>(node.type()));
+    hash_field(hash, shape.fields);
+    for (const auto* child : shape.children) {
+        hash_value(hash, child ? child->structural_hash() : 0);
+    }
+    // 0 marks a node not hashed yet
+    return hash == 0 ? 1 : hash;
+}
+
+uint64_t ASTNode::structural_hash() const {
+    return structural_hash_ != 0 ? structural_hash_ : compute_structural_hash(*this);
+}
+
+bool structurally_equal(const ASTNode& a, const ASTNode& b) {
+    if (&a == &b) {
+        return true;
+    }
+    if (a.type() != b.type() || a.structural_hash() != b.structural_hash()) {
+        return false;
+    }
+    auto shape_a = shape_of(a);
+    auto shape_b = shape_of(b);
+    if (shape_a.fields != shape_b.fields || shape_a.children.size() != shape_b.children.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < shape_a.children.size(); ++i) {
+        const auto* child_a = shape_a.children[i];
+        const auto* child_b = shape_b.children[i];
+        if (!child_a || !child_b) {
+            if (child_a != child_b) {
+                return false;
+            }
+            continue;
+        }
+        if (!structurally_equal(*child_a, *child_b)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t subtree_bytes(const ASTNode& node) {
+    return size_of(node).bytes;
+}
+
+std::string SubtreeSharingMeter::Stats::to_string() const {
+    return fmt::format("AST subtrees: {} nodes in {} KiB, {} repeated; sharing them would "
+                       "save {} KiB",
+                       nodes, bytes / 1024, shared_nodes, bytes_saved / 1024);
+}
+
+void SubtreeSharingMeter::measure(const ASTNode& root) {
+    std::lock_guard lock(mutex_);
+    // A subtree seen before is shared whole; a new one is kept node by node
+    // and its children looked at in turn
+    std::vector<const ASTNode*> pending{&root};
+    while (!pending.empty()) {
+        const auto* node = pending.back();
+        pending.pop_back();
+        if (!node) {
+            continue;
+        }
+        if (!measured_.insert(node->structural_hash()).second) {
+            auto size = size_of(*node);
+            stats_.nodes += size.nodes;
+            stats_.bytes += size.bytes;
+            stats_.shared_nodes += size.nodes;
+            stats_.bytes_saved += size.bytes;
+            continue;
+        }
+        auto shape = shape_of(*node);
+        ++stats_.nodes;
+        stats_.bytes += shape.bytes;
+        pending.insert(pending.end(), shape.children.begin(), shape.children.end());
+    }
+}
+
+SubtreeSharingMeter::Stats SubtreeSharingMeter::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+} // namespace finch::ast
@@ -1,6 +1,8 @@
 #include <finch/core/logging.hpp>
+#include <finch/parser/ast/expressions.hpp>
 #include <finch/parser/ast/literals.hpp>
 #include <finch/parser/cpm_parser.hpp>
+#include <finch/parser/keyword_schema.hpp>
 #include <fmt/format.h>
 #include <regex>
 
@@ -11,6 +13,82 @@ namespace {
 const std::regex GITHUB_SHORTHAND_REGEX(R"(^(?:gh:)?([^/@#]+)/([^/@#]+)(?:[@#](.+))?$)");
 const std::regex VERSION_EXACT_REGEX(R"(^@(.+)$)");
 const std::regex VERSION_MIN_REGEX(R"(^>=(.+)$)");
+
+// CPMAddPackage()'s own cmake_parse_arguments() keywords; CPMDeclarePackage()
+// forwards the same ones
+constexpr KeywordSchema<21> ADD_PACKAGE_SCHEMA({{
+    {"NAME", KeywordKind::OneValue},
+    {"FORCE", KeywordKind::OneValue},
+    {"VERSION", KeywordKind::OneValue},
+    {"GIT_TAG", KeywordKind::OneValue},
+    {"DOWNLOAD_ONLY", KeywordKind::OneValue},
+    {"GITHUB_REPOSITORY", KeywordKind::OneValue},
+    {"GITLAB_REPOSITORY", KeywordKind::OneValue},
+    {"BITBUCKET_REPOSITORY", KeywordKind::OneValue},
+    {"GIT_REPOSITORY", KeywordKind::OneValue},
+    {"SOURCE_DIR", KeywordKind::OneValue},
+    {"FIND_PACKAGE_ARGUMENTS", KeywordKind::OneValue},
+    {"NO_CACHE", KeywordKind::OneValue},
+    {"SYSTEM", KeywordKind::OneValue},
+    {"GIT_SHALLOW", KeywordKind::OneValue},
+    {"EXCLUDE_FROM_ALL", KeywordKind::OneValue},
+    {"SOURCE_SUBDIR", KeywordKind::OneValue},
+    {"CUSTOM_CACHE_KEY", KeywordKind::OneValue},
+    {"URL", KeywordKind::MultiValue},
+    {"OPTIONS", KeywordKind::MultiValue},
+    {"DOWNLOAD_COMMAND", KeywordKind::MultiValue},
+    {"PATCHES", KeywordKind::MultiValue},
+}});
+constexpr size_t ADD_NAME = ADD_PACKAGE_SCHEMA.slot("NAME");
+constexpr size_t ADD_VERSION = ADD_PACKAGE_SCHEMA.slot("VERSION");
+constexpr size_t ADD_GIT_TAG = ADD_PACKAGE_SCHEMA.slot("GIT_TAG");
+constexpr size_t ADD_GITHUB_REPOSITORY = ADD_PACKAGE_SCHEMA.slot("GITHUB_REPOSITORY");
+constexpr size_t ADD_GIT_REPOSITORY = ADD_PACKAGE_SCHEMA.slot("GIT_REPOSITORY");
+constexpr size_t ADD_URL = ADD_PACKAGE_SCHEMA.slot("URL");
+constexpr size_t ADD_OPTIONS = ADD_PACKAGE_SCHEMA.slot("OPTIONS");
+
+// CPMFindPackage() plus the find_package() words it passes through
+constexpr KeywordSchema<9> FIND_PACKAGE_SCHEMA({{
+    {"NAME", KeywordKind::OneValue},
+    {"VERSION", KeywordKind::OneValue},
+    {"GITHUB_REPOSITORY", KeywordKind::OneValue},
+    {"GIT_REPOSITORY", KeywordKind::OneValue},
+    {"GIT_TAG", KeywordKind::OneValue},
+    {"COMPONENTS", KeywordKind::MultiValue},
+    {"REQUIRED", KeywordKind::Option},
+    {"QUIET", KeywordKind::Option},
+    {"OPTIONAL", KeywordKind::Option},
+}});
+constexpr size_t FIND_NAME = FIND_PACKAGE_SCHEMA.slot("NAME");
+constexpr size_t FIND_VERSION = FIND_PACKAGE_SCHEMA.slot("VERSION");
+constexpr size_t FIND_GITHUB_REPOSITORY = FIND_PACKAGE_SCHEMA.slot("GITHUB_REPOSITORY");
+constexpr size_t FIND_GIT_TAG = FIND_PACKAGE_SCHEMA.slot("GIT_TAG");
+constexpr size_t FIND_COMPONENTS = FIND_PACKAGE_SCHEMA.slot("COMPONENTS");
+
+// The literal value of a one-value keyword, if it has one
+template <size_t N>
+std::optional<std::string> value_of(const ParsedArguments<N>& parsed, size_t slot,
+                                    const std::vector<std::string>& words) {
+    auto position = parsed.value(slot);
+    if (!position || words[*position].empty()) {
+        return std::nullopt;
+    }
+    return words[*position];
+}
+
+// NAME, or else the first word when no keyword claims it
+template <size_t N>
+std::optional<std::string> name_of(const ParsedArguments<N>& parsed, size_t name_slot,
+                                   const std::vector<std::string>& words) {
+    if (auto name = value_of(parsed, name_slot, words)) {
+        return name;
+    }
+    auto positional = parsed.positional();
+    if (positional.empty() || positional[0] != 0 || words[0].empty()) {
+        return std::nullopt;
+    }
+    return words[0];
+}
 } // namespace
 
 Result<ast::ASTNodePtr, ParseError> CPMParser::parse_cpm_command(const std::string& command_name,
@@ -60,7 +138,7 @@ CPMParser::parse_cpm_add_package(const ast::ASTNodeList& args) {
         if (str_result.has_value()) {
             const auto& str = str_result.value();
             if (is_github_shorthand(str)) {
-                return parse_cpm_add_package_shorthand(str);
+                return parse_cpm_add_package_shorthand(str, args[0]->location());
             }
         }
     }
@@ -70,7 +148,8 @@ CPMParser::parse_cpm_add_package(const ast::ASTNodeList& args) {
 }
 
 Result<std::unique_ptr<ast::CPMAddPackage>, ParseError>
-CPMParser::parse_cpm_add_package_shorthand(const std::string& shorthand) {
+CPMParser::parse_cpm_add_package_shorthand(const std::string& shorthand,
+                                           const SourceLocation& loc) {
     LOG_DEBUG("Parsing CPM shorthand: {}", shorthand);
 
     auto gh_result = parse_github_shorthand(shorthand);
@@ -91,12 +170,16 @@ CPMParser::parse_cpm_add_package_shorthand(const std::string& shorthand) {
     std::string owner = repo_spec.substr(0, slash_pos);
     std::string repo = repo_spec.substr(slash_pos + 1);
 
-    auto package = std::make_unique<ast::CPMAddPackage>(SourceLocation{}, repo);
+    auto package = std::make_unique<ast::CPMAddPackage>(loc, repo);
     package->set_source(ast::CPMSourceType::GitHub, repo_spec);
 
     if (!version_str.empty()) {
         auto version = parse_version_string(version_str);
         if (version.has_value()) {
+            // owner/repo#ref names a git tag as is; @version stands for tag v<version>
+            if (shorthand.find('#') != std::string::npos) {
+                version.value().git_tag = version_str;
+            }
             package->set_version(version.value());
         } else {
             return Result<std::unique_ptr<ast::CPMAddPackage>, ParseError>{std::in_place_index<1>,
@@ -109,109 +192,54 @@ CPMParser::parse_cpm_add_package_shorthand(const std::string& shorthand) {
 
 Result<std::unique_ptr<ast::CPMAddPackage>, ParseError>
 CPMParser::parse_cpm_add_package_full(const ast::ASTNodeList& args) {
-    std::string name;
-    std::unique_ptr<ast::CPMAddPackage> package;
     SourceLocation loc = args.empty() ? SourceLocation{} : args[0]->location();
+    auto words = literal_words(args);
+    auto parsed = ADD_PACKAGE_SCHEMA.partition(words);
 
-    size_t i = 0;
-
-    // First, try to find NAME argument
-    auto* name_node = find_argument(args, "NAME");
-    if (name_node) {
-        // Find the value after NAME
-        for (size_t j = 0; j < args.size() - 1; ++j) {
-            if (args[j].get() == name_node) {
-                auto name_result = get_string_value(args[j + 1].get());
-                if (name_result.has_value()) {
-                    name = name_result.value();
-                    package = std::make_unique<ast::CPMAddPackage>(loc, name);
-                    break;
-                }
-            }
-        }
-    } else if (args.size() > 0) {
-        // Try first argument as name
-        auto name_result = get_string_value(args[0].get());
-        if (name_result.has_value() && !name_result.value().empty()) {
-            name = name_result.value();
-            package = std::make_unique<ast::CPMAddPackage>(loc, name);
-            i = 1; // Start processing from next argument
-        }
-    }
-
-    if (!package) {
+    auto name = name_of(parsed, ADD_NAME, words);
+    if (!name) {
         return Err<ParseError, std::unique_ptr<ast::CPMAddPackage>>(
             ParseError("CPMAddPackage requires NAME"));
     }
+    auto package = std::make_unique<ast::CPMAddPackage>(loc, *name);
+
+    if (auto repository = value_of(parsed, ADD_GITHUB_REPOSITORY, words)) {
+        package->set_source(ast::CPMSourceType::GitHub, *repository);
+    } else if (auto git = value_of(parsed, ADD_GIT_REPOSITORY, words)) {
+        package->set_source(ast::CPMSourceType::GitURL, *git);
+    } else if (!parsed.values(ADD_URL).empty() && !words[parsed.values(ADD_URL)[0]].empty()) {
+        // URL lists mirrors; the first one names the archive
+        package->set_source(ast::CPMSourceType::URL, words[parsed.values(ADD_URL)[0]]);
+    }
 
-    // Parse remaining arguments
-    for (; i < args.size(); ++i) {
-        auto key_result = get_string_value(args[i].get());
-        if (!key_result.has_value()) {
-            continue;
+    // GIT_TAG names the ref to fetch and stands in for a missing VERSION
+    std::optional<ast::CPMVersion> version;
+    if (auto text = value_of(parsed, ADD_VERSION, words)) {
+        auto parsed_version = parse_version_string(*text);
+        if (parsed_version.has_value()) {
+            version = parsed_version.value();
         }
+    }
+    if (auto tag = value_of(parsed, ADD_GIT_TAG, words)) {
+        if (!version) {
+            version = ast::CPMVersion{};
+            version->version = *tag;
+        }
+        version->git_tag = *tag;
+    }
+    if (version) {
+        package->set_version(*version);
+    }
 
-        const auto& key = key_result.value();
-
-        if (key == "GITHUB_REPOSITORY" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                package->set_source(ast::CPMSourceType::GitHub, value_result.value());
-                i++;
-            }
-        } else if (key == "GIT_REPOSITORY" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                package->set_source(ast::CPMSourceType::GitURL, value_result.value());
-                i++;
-            }
-        } else if (key == "URL" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                package->set_source(ast::CPMSourceType::URL, value_result.value());
-                i++;
-            }
-        } else if (key == "VERSION" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                auto version = parse_version_string(value_result.value());
-                if (version.has_value()) {
-                    package->set_version(version.value());
-                }
-                i++;
-            }
-        } else if (key == "GIT_TAG" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                ast::CPMVersion version;
-                version.git_tag = value_result.value();
-                version.version = value_result.value();
-                package->set_version(version);
-                i++;
-            }
-        } else if (key == "OPTIONS") {
-            // Collect all arguments until the next keyword
-            ast::ASTNodeList option_args;
-            i++;
-            while (i < args.size()) {
-                auto str_result = get_string_value(args[i].get());
-                if (str_result.has_value()) {
-                    const auto& str = str_result.value();
-                    // Check if this is a CPM keyword
-                    if (str == "DOWNLOAD_ONLY" || str == "EXCLUDE_FROM_ALL" || str == "SYSTEM" ||
-                        str == "NO_CACHE") {
-                        i--; // Back up one
-                        break;
-                    }
-                }
-                option_args.push_back(args[i]->clone());
-                i++;
-            }
-            auto options_result = parse_options_block(*package, option_args);
-            if (!options_result.has_value()) {
-                return Result<std::unique_ptr<ast::CPMAddPackage>, ParseError>{
-                    std::in_place_index<1>, options_result.error()};
-            }
+    if (parsed.has(ADD_OPTIONS)) {
+        std::vector<std::string> options;
+        for (auto position : parsed.values(ADD_OPTIONS)) {
+            options.push_back(words[position]);
+        }
+        auto options_result = parse_options_block(*package, options);
+        if (!options_result.has_value()) {
+            return Result<std::unique_ptr<ast::CPMAddPackage>, ParseError>{
+                std::in_place_index<1>, options_result.error()};
         }
     }
 
@@ -225,76 +253,29 @@ CPMParser::parse_cpm_find_package(const ast::ASTNodeList& args) {
             ParseError("CPMFindPackage requires arguments"));
     }
 
-    std::string name;
     SourceLocation loc = args[0]->location();
+    auto words = literal_words(args);
+    auto parsed = FIND_PACKAGE_SCHEMA.partition(words);
 
-    // First argument should be the package name
-    auto name_result = get_string_value(args[0].get());
-    if (!name_result.has_value()) {
-        // Try NAME keyword
-        auto* name_node = find_argument(args, "NAME");
-        if (name_node) {
-            for (size_t i = 0; i < args.size() - 1; ++i) {
-                if (args[i].get() == name_node) {
-                    name_result = get_string_value(args[i + 1].get());
-                    break;
-                }
-            }
-        }
-    }
-
-    if (!name_result.has_value() || name_result.value().empty()) {
+    auto name = name_of(parsed, FIND_NAME, words);
+    if (!name) {
         return Err<ParseError, std::unique_ptr<ast::CPMFindPackage>>(
             ParseError("CPMFindPackage requires package name"));
     }
+    auto package = std::make_unique<ast::CPMFindPackage>(loc, *name);
 
-    name = name_result.value();
-    auto package = std::make_unique<ast::CPMFindPackage>(loc, name);
-
-    // Parse additional arguments
-    for (size_t i = 1; i < args.size(); ++i) {
-        auto key_result = get_string_value(args[i].get());
-        if (!key_result.has_value()) {
-            continue;
-        }
-
-        const auto& key = key_result.value();
-
-        if (key == "VERSION" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                package->set_version(value_result.value());
-                i++;
-            }
-        } else if (key == "GITHUB_REPOSITORY" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                package->set_github_repository(value_result.value());
-                i++;
-            }
-        } else if (key == "GIT_TAG" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                package->set_git_tag(value_result.value());
-                i++;
-            }
-        } else if (key == "COMPONENTS") {
-            // Collect component names
-            i++;
-            while (i < args.size()) {
-                auto comp_result = get_string_value(args[i].get());
-                if (!comp_result.has_value()) {
-                    break;
-                }
-                const auto& comp = comp_result.value();
-                // Stop if we hit another keyword
-                if (comp == "REQUIRED" || comp == "QUIET" || comp == "OPTIONAL") {
-                    i--;
-                    break;
-                }
-                package->add_component(comp);
-                i++;
-            }
+    if (auto version = value_of(parsed, FIND_VERSION, words)) {
+        package->set_version(*version);
+    }
+    if (auto repository = value_of(parsed, FIND_GITHUB_REPOSITORY, words)) {
+        package->set_github_repository(*repository);
+    }
+    if (auto tag = value_of(parsed, FIND_GIT_TAG, words)) {
+        package->set_git_tag(*tag);
+    }
+    for (auto position : parsed.values(FIND_COMPONENTS)) {
+        if (!words[position].empty()) {
+            package->add_component(words[position]);
         }
     }
 
@@ -308,7 +289,8 @@ CPMParser::parse_cpm_use_package_lock(const ast::ASTNodeList& args) {
             ParseError("CPMUsePackageLock requires a file path"));
     }
 
-    auto path_result = get_string_value(args[0].get());
+    // Usually ${CMAKE_CURRENT_LIST_DIR}/package-lock.cmake
+    auto path_result = get_unexpanded_text(args[0].get());
     if (!path_result.has_value() || path_result.value().empty()) {
         return Err<ParseError, std::unique_ptr<ast::CPMUsePackageLock>>(
             ParseError("CPMUsePackageLock requires a valid file path"));
@@ -325,58 +307,33 @@ CPMParser::parse_cpm_declare_package(const ast::ASTNodeList& args) {
             ParseError("CPMDeclarePackage requires arguments"));
     }
 
-    std::string name;
+    // CPMDeclarePackage(<name> <CPMAddPackage arguments>...), though package
+    // locks repeat the name as NAME too
     SourceLocation loc = args[0]->location();
+    auto words = literal_words(args);
+    auto parsed = ADD_PACKAGE_SCHEMA.partition(words);
 
-    // Find NAME argument
-    auto* name_node = find_argument(args, "NAME");
-    if (name_node) {
-        for (size_t i = 0; i < args.size() - 1; ++i) {
-            if (args[i].get() == name_node) {
-                auto name_result = get_string_value(args[i + 1].get());
-                if (name_result.has_value()) {
-                    name = name_result.value();
-                    break;
-                }
-            }
-        }
-    }
-
-    if (name.empty()) {
+    auto name = name_of(parsed, ADD_NAME, words);
+    if (!name) {
         return Err<ParseError, std::unique_ptr<ast::CPMDeclarePackage>>(
             ParseError("CPMDeclarePackage requires NAME"));
     }
+    auto package = std::make_unique<ast::CPMDeclarePackage>(loc, *name);
 
-    auto package = std::make_unique<ast::CPMDeclarePackage>(loc, name);
-
-    // Parse remaining arguments
-    for (size_t i = 0; i < args.size(); ++i) {
-        auto key_result = get_string_value(args[i].get());
-        if (!key_result.has_value()) {
-            continue;
-        }
-
-        const auto& key = key_result.value();
-
-        if (key == "VERSION" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                package->set_version(value_result.value());
-                i++;
-            }
-        } else if (key == "GITHUB_REPOSITORY" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                package->set_github_repository(value_result.value());
-                i++;
-            }
-        } else if (key == "GIT_REPOSITORY" && i + 1 < args.size()) {
-            auto value_result = get_string_value(args[i + 1].get());
-            if (value_result.has_value()) {
-                package->set_git_repository(value_result.value());
-                i++;
-            }
-        }
+    if (auto version = value_of(parsed, ADD_VERSION, words)) {
+        package->set_version(*version);
+    }
+    if (auto repository = value_of(parsed, ADD_GITHUB_REPOSITORY, words)) {
+        package->set_github_repository(*repository);
+    }
+    if (auto git = value_of(parsed, ADD_GIT_REPOSITORY, words)) {
+        package->set_git_repository(*git);
+    }
+    if (!parsed.values(ADD_URL).empty() && !words[parsed.values(ADD_URL)[0]].empty()) {
+        package->set_url(words[parsed.values(ADD_URL)[0]]);
+    }
+    if (auto tag = value_of(parsed, ADD_GIT_TAG, words)) {
+        package->set_git_tag(*tag);
     }
 
     return Ok<std::unique_ptr<ast::CPMDeclarePackage>, ParseError>(std::move(package));
@@ -414,18 +371,16 @@ CPMParser::parse_version_string(const std::string& version_str) {
 }
 
 Result<void, ParseError> CPMParser::parse_options_block(ast::CPMAddPackage& package,
-                                                        const ast::ASTNodeList& options) {
+                                                        const std::vector<std::string>& options) {
     // OPTIONS are passed as CMake cache entries
     // Format: "VAR_NAME VALUE" or "VAR_NAME:TYPE VALUE"
 
     for (size_t i = 0; i < options.size(); ++i) {
-        auto opt_result = get_string_value(options[i].get());
-        if (!opt_result.has_value()) {
+        const auto& opt_str = options[i];
+        if (opt_str.empty()) {
             continue;
         }
 
-        const auto& opt_str = opt_result.value();
-
         // Try to parse as "KEY VALUE" or "KEY:TYPE VALUE"
         auto space_pos = opt_str.find(' ');
         if (space_pos != std::string::npos) {
@@ -439,13 +394,10 @@ Result<void, ParseError> CPMParser::parse_options_block(ast::CPMAddPackage& pack
             }
 
             package.add_option(key, value);
-        } else if (i + 1 < options.size()) {
+        } else if (i + 1 < options.size() && !options[i + 1].empty()) {
             // Try next element as value
-            auto val_result = get_string_value(options[i + 1].get());
-            if (val_result.has_value()) {
-                package.add_option(opt_str, val_result.value());
-                i++; // Skip value
-            }
+            package.add_option(opt_str, options[i + 1]);
+            i++; // Skip value
         }
     }
 
@@ -487,34 +439,40 @@ Result<std::string, ParseError> CPMParser::get_string_value(const ast::ASTNode*
     return Err<ParseError, std::string>(ParseError("Expected string literal or identifier"));
 }
 
-const ast::ASTNode* CPMParser::find_argument(const ast::ASTNodeList& args,
-                                             const std::string& name) const {
-    for (const auto& arg : args) {
-        auto str_result = get_string_value(arg.get());
-        if (str_result.has_value() && str_result.value() == name) {
-            return arg.get();
+Result<std::string, ParseError> CPMParser::get_unexpanded_text(const ast::ASTNode* node) const {
+    if (auto* variable = dynamic_cast<const ast::Variable*>(node)) {
+        auto form = variable->is_env() ? "$ENV{{{}}}" : variable->is_cache() ? "$CACHE{{{}}}" : "${{{}}}";
+        return Ok<std::string, ParseError>(fmt::format(fmt::runtime(form), variable->name()));
+    }
+    if (auto* list = dynamic_cast<const ast::ListExpression*>(node)) {
+        std::string text;
+        for (const auto& element : list->elements()) {
+            auto part = get_unexpanded_text(element.get());
+            if (!part.has_value()) {
+                return part;
+            }
+            text += part.value();
         }
+        return Ok<std::string, ParseError>(std::move(text));
     }
-    return nullptr;
+    return get_string_value(node);
 }
 
-std::vector<const ast::ASTNode*> CPMParser::collect_arguments_after(const ast::ASTNodeList& args,
-                                                                    const std::string& key) const {
-    std::vector<const ast::ASTNode*> result;
-    bool found_key = false;
-
+std::vector<std::string> CPMParser::literal_words(const ast::ASTNodeList& args) const {
+    std::vector<std::string> words;
+    words.reserve(args.size());
     for (const auto& arg : args) {
-        if (found_key) {
-            result.push_back(arg.get());
+        // Unquoted ON or 1.84 lex as boolean and number literals, still words
+        if (auto* boolean = dynamic_cast<const ast::BooleanLiteral*>(arg.get())) {
+            words.emplace_back(boolean->original_text());
+        } else if (auto* number = dynamic_cast<const ast::NumberLiteral*>(arg.get())) {
+            words.emplace_back(number->text());
         } else {
-            auto str_result = get_string_value(arg.get());
-            if (str_result.has_value() && str_result.value() == key) {
-                found_key = true;
-            }
+            auto word = get_string_value(arg.get());
+            words.push_back(word.has_value() ? std::move(word.value()) : std::string());
         }
     }
-
-    return result;
+    return words;
 }
 
 } // namespace finch::parser
@@ -41,7 +41,7 @@ Result<std::unique_ptr<File>, std::vector<ParseError>> Parser::parse_file() {
     }
 
     // Create the file node
-    auto file = std::make_unique<File>(SourceLocation{filename_, 1, 1},
+    auto file = ASTBuilder::make<File>(SourceLocation{filename_, 1, 1},
                                        builder_.interner().intern(filename_),
                                        std::move(elements_result.value()));
 
@@ -82,23 +82,28 @@ Result<ASTNodePtr, ParseError> Parser::parse_quoted_argument() {
             return Err<ParseError, ASTNodePtr>(std::move(parts_result.error()));
         }
 
+        // A single part stands for the whole quoted argument
+        const auto& parts = parts_result.value();
+        bool whole = parts.size() == 1;
         ASTNodeList nodes;
-        for (const auto& part : parts_result.value()) {
+        for (const auto& part : parts) {
             if (part.type == lexer::InterpolatedPart::Literal) {
-                nodes.push_back(builder_.makeString(part.location, part.value, false));
+                nodes.push_back(builder_.makeString(part.location, part.value, whole));
             } else {
                 // Variable reference
-                nodes.push_back(builder_.makeVariable(part.location, part.value));
+                nodes.push_back(builder_.makeVariable(part.location, part.value,
+                                                      Variable::VariableType::Normal, whole));
             }
         }
 
         // If only one part, return it directly
-        if (nodes.size() == 1) {
+        if (whole) {
             return Ok<ASTNodePtr, ParseError>(std::move(nodes[0]));
         }
 
-        // Otherwise create a list expression
-        return Ok<ASTNodePtr, ParseError>(builder_.makeList(tok.location, std::move(nodes)));
+        // Otherwise create a list expression of the argument's parts
+        return Ok<ASTNodePtr, ParseError>(
+            builder_.makeList(tok.location, std::move(nodes), ' ', true));
     }
 
     // Simple string literal
@@ -145,6 +145,8 @@ Result<ASTNodePtr, ParseError> Parser::parse_if_statement() {
         return Err<ParseError, ASTNodePtr>(std::move(endif_rparen.error()));
     }
 
+    // Its branches were added after it was made
+    ASTBuilder::rehash(*if_stmt);
     return Ok<ASTNodePtr, ParseError>(std::move(if_stmt));
 }
 
@@ -0,0 +1,147 @@
+#include "support/temp_directory.hpp"
+#include <filesystem>
+#include <finch/analyzer/compile_database.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+TEST(CompileDatabaseTest, ParsesCommandAndArgumentsEntries) {
+    const char* json = R"([
+        {"directory": "/build", "command": "c++ -DA -c /src/a.cpp", "file": "/src/a.cpp",
+         "output": "CMakeFiles/core.dir/a.cpp.o"},
+        {"directory": "/build", "arguments": ["c++", "-c", "b.cpp"], "file": "b.cpp",
+         "extra": {"nested": [1, true, null]}}
+    ])";
+
+    auto database = CompileDatabase::parse(json);
+    ASSERT_TRUE(database.has_value());
+
+    const auto& entries = database.value().entries();
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0].command, "c++ -DA -c /src/a.cpp");
+    EXPECT_EQ(entries[0].output, "CMakeFiles/core.dir/a.cpp.o");
+    ASSERT_EQ(entries[1].arguments.size(), 3);
+    EXPECT_EQ(entries[1].arguments[2], "b.cpp");
+}
+
+TEST(CompileDatabaseTest, DecodesEscapedStrings) {
+    const char* json = R"([{"directory": "C:\\build", "file": "a\"b.cpp", "command": "\u0063c"}])";
+
+    auto database = CompileDatabase::parse(json);
+    ASSERT_TRUE(database.has_value());
+
+    const auto& entry = database.value().entries().front();
+    EXPECT_EQ(entry.directory, "C:\\build");
+    EXPECT_EQ(entry.file, "a\"b.cpp");
+    EXPECT_EQ(entry.command, "cc");
+}
+
+TEST(CompileDatabaseTest, DecodesSurrogatePairsAndReplacesLoneHalves) {
+    const char* json = R"([{"directory": "/", "file": "\uD83D\uDE00.cpp",)"
+                       R"( "command": "cc \uD800\u0041 \uDC00"}])";
+
+    auto database = CompileDatabase::parse(json);
+    ASSERT_TRUE(database.has_value());
+
+    const auto& entry = database.value().entries().front();
+    EXPECT_EQ(entry.file, "\xF0\x9F\x98\x80.cpp");
+    EXPECT_EQ(entry.command, "cc \xEF\xBF\xBD" "A \xEF\xBF\xBD");
+}
+
+TEST(CompileDatabaseTest, ReportsMalformedInput) {
+    auto database = CompileDatabase::parse(R"([{"file": "a.cpp")");
+    ASSERT_FALSE(database.has_value());
+    EXPECT_NE(database.error().message().find("offset"), std::string::npos);
+}
+
+TEST(CompileDatabaseTest, TokenizesShellQuoting) {
+    auto tokens = CompileDatabase::tokenize_command(
+        R"(c++ -DNAME=\"x\" "-DMSG=\"hi there\"" '-DRAW=$x' a\ b.cpp)");
+
+    EXPECT_EQ(tokens, (std::vector<std::string>{"c++", "-DNAME=\"x\"", "-DMSG=\"hi there\"",
+                                                "-DRAW=$x", "a b.cpp"}));
+}
+
+TEST(CompileDatabaseTest, GroupsTranslationUnitsByObjectDirectory) {
+    const char* json = R"([
+        {"directory": "/build", "file": "/src/core/a.cpp", "output": "CMakeFiles/core.dir/a.cpp.o",
+         "command": "c++ -DCORE -DONLY_A -I/src/include -O2 -o CMakeFiles/core.dir/a.cpp.o -c /src/core/a.cpp"},
+        {"directory": "/build", "file": "/src/core/sub/b.cpp",
+         "command": "c++ -DCORE -I /src/include -O2 -MD -MF x.d -o CMakeFiles/core.dir/sub/b.cpp.o -c /src/core/sub/b.cpp"},
+        {"directory": "/build/tools", "file": "/src/tools/main.cpp",
+         "command": "c++ -objcmt-migrate-literals -oCMakeFiles/tool.dir/main.cpp.o -c /src/tools/main.cpp"}
+    ])";
+
+    auto database = CompileDatabase::parse(json);
+    ASSERT_TRUE(database.has_value());
+
+    CompileDatabaseAnalyzer analyzer(2);
+    auto analysis = analyzer.analyze(database.value());
+    ASSERT_EQ(analysis.targets.size(), 2);
+
+    const auto& core = analysis.targets[0];
+    EXPECT_EQ(core.name, "core");
+    EXPECT_EQ(core.source_directory, fs::path("/src/core"));
+    EXPECT_EQ(core.sources, (PathList{"a.cpp", "sub/b.cpp"}));
+    EXPECT_EQ(core.compile_definitions, (std::vector<std::string>{"CORE"}));
+    EXPECT_EQ(core.include_directories, (PathList{"/src/include"}));
+    EXPECT_EQ(core.compile_options, (std::vector<std::string>{"-O2"}));
+
+    // -DONLY_A differs between the sources of core
+    ASSERT_EQ(analysis.warnings.size(), 1);
+
+    // -o<path> names the output; other options starting with -o are kept
+    EXPECT_EQ(analysis.targets[1].name, "tool");
+    EXPECT_EQ(analysis.targets[1].compile_options,
+              (std::vector<std::string>{"-objcmt-migrate-literals"}));
+}
+
+TEST(CompileDatabaseTest, CrossCheckAndReconcileWithEvaluatedTargets) {
+    ProjectAnalysis evaluated;
+    Target core;
+    core.name = "core";
+    core.type = Target::Type::SharedLibrary;
+    core.source_directory = "/src/core";
+    core.sources = {"a.cpp", "missing.cpp", "core.h"};
+    core.link_libraries = {"fmt"};
+    evaluated.targets.push_back(core);
+    Target headers;
+    headers.name = "headers";
+    headers.type = Target::Type::InterfaceLibrary;
+    evaluated.targets.push_back(headers);
+
+    ProjectAnalysis observed;
+    Target observed_core;
+    observed_core.name = "core";
+    observed_core.source_directory = "/src/core";
+    observed_core.sources = {"a.cpp"};
+    observed.targets.push_back(observed_core);
+    Target generated;
+    generated.name = "generated";
+    observed.targets.push_back(generated);
+
+    auto findings = CompileDatabaseAnalyzer::cross_check(evaluated, observed);
+    ASSERT_EQ(findings.size(), 2);
+    EXPECT_NE(findings[0].find("missing.cpp"), std::string::npos);
+    EXPECT_NE(findings[1].find("'generated'"), std::string::npos);
+
+    CompileDatabaseAnalyzer::reconcile(observed, evaluated);
+    EXPECT_EQ(observed.targets[0].type, Target::Type::SharedLibrary);
+    EXPECT_EQ(observed.targets[0].link_libraries, (std::vector<std::string>{"fmt"}));
+}
+
+TEST(CompileDatabaseTest, LoadsFromDisk) {
+    test::TempDirectory root("compile_database_test");
+    auto path = root.write("compile_commands.json",
+                           R"([{"directory": "/b", "file": "/s/x.c", "command": "cc -c /s/x.c"}])");
+
+    CompileDatabaseAnalyzer analyzer;
+    auto analysis = analyzer.analyze(path);
+
+    ASSERT_TRUE(analysis.has_value());
+    ASSERT_EQ(analysis.value().targets.size(), 1);
+    EXPECT_EQ(analysis.value().targets[0].sources, (PathList{"x.c"}));
+}
@@ -0,0 +1,141 @@
+#include "support/temp_directory.hpp"
+#include <filesystem>
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/cpm_package_lock.hpp>
+#include <finch/parser/ast/structure.hpp>
+#include <finch/parser/parser.hpp>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// As `cmake --build . --target cpm-update-package-lock` writes it
+std::string lock_file(size_t packages, const std::string& fmt_version) {
+    std::string content = "# CPM Package Lock\n# This file should be committed to version control\n";
+    content += fmt::format(R"(
+# fmt
+CPMDeclarePackage(fmt
+  NAME fmt
+  VERSION {}
+  GITHUB_REPOSITORY fmtlib/fmt
+  SYSTEM YES
+  EXCLUDE_FROM_ALL YES
+)
+)",
+                           fmt_version);
+    for (size_t i = 0; i < packages; ++i) {
+        content += fmt::format("# pkg{0}\nCPMDeclarePackage(pkg{0}\n  VERSION 1.{0}\n"
+                               "  GIT_REPOSITORY https://example.com/pkg{0}.git\n"
+                               "  GIT_TAG release-{0}\n)\n",
+                               i);
+    }
+    return content;
+}
+
+class CPMPackageLockTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        root_.write("package-lock.cmake", lock_file(300, "10.1.1"));
+    }
+
+    // CPM declarations that evaluating source as <root>/<file> reports
+    std::vector<CPMPackage> evaluate(const std::string& source, const std::string& file,
+                                     CPMPackageLockCache* cache) {
+        parser::Parser parser(source, (root_ / file).string());
+        auto ast = parser.parse_file();
+        EXPECT_TRUE(ast.has_value());
+        if (!ast.has_value()) {
+            return {};
+        }
+        CMakeFileEvaluator evaluator;
+        evaluator.set_package_lock_cache(cache);
+        evaluator.set_slicing(true);
+        auto analysis = evaluator.analyze(*ast.value());
+        EXPECT_TRUE(analysis.has_value());
+        return analysis.has_value() ? analysis.value().cpm_packages : std::vector<CPMPackage>{};
+    }
+
+    test::TempDirectory root_{"cpm_package_lock_test"};
+};
+
+} // namespace
+
+TEST_F(CPMPackageLockTest, ParsesDeclarationsIntoAnIndexedTable) {
+    auto lock = CPMPackageLock::parse(lock_file(300, "10.1.1"), "package-lock.cmake");
+    ASSERT_TRUE(lock.has_value());
+    EXPECT_EQ(lock.value().declarations().size(), 301);
+
+    const auto* fmt_lock = lock.value().find("fmt");
+    ASSERT_NE(fmt_lock, nullptr);
+    EXPECT_EQ(fmt_lock->version, "10.1.1");
+    EXPECT_EQ(fmt_lock->source_type, CPMPackage::SourceType::GitHub);
+    EXPECT_EQ(fmt_lock->source, "fmtlib/fmt");
+    EXPECT_EQ(fmt_lock->declared_in, "package-lock.cmake:5");
+
+    const auto* pkg = lock.value().find("pkg299");
+    ASSERT_NE(pkg, nullptr);
+    EXPECT_EQ(pkg->source_type, CPMPackage::SourceType::Git);
+    EXPECT_EQ(pkg->git_tag, "release-299");
+    EXPECT_EQ(lock.value().find("spdlog"), nullptr);
+}
+
+TEST_F(CPMPackageLockTest, LockedDeclarationsPinAddedPackages) {
+    CPMPackageLockCache cache;
+    auto packages = evaluate(R"(
+        CPMUsePackageLock(package-lock.cmake)
+        CPMAddPackage(NAME fmt)
+        CPMAddPackage(NAME pkg7 VERSION 2.0)
+        CPMAddPackage(NAME unlocked VERSION 0.1 GITHUB_REPOSITORY me/unlocked)
+    )",
+                             "CMakeLists.txt", &cache);
+    ASSERT_EQ(packages.size(), 3);
+    EXPECT_EQ(packages[0].version, "10.1.1");
+    EXPECT_EQ(packages[0].source, "fmtlib/fmt");
+    EXPECT_EQ(packages[0].declared_in, (root_ / "CMakeLists.txt").string() + ":3");
+    EXPECT_EQ(packages[1].version, "1.7");
+    EXPECT_EQ(packages[2].version, "0.1");
+
+    // Every subproject pointing at the lock shares the parsed table
+    for (int i = 0; i < 20; ++i) {
+        auto sub = evaluate(R"(
+            CPMUsePackageLock(${CMAKE_CURRENT_LIST_DIR}/../package-lock.cmake)
+            CPMAddPackage(NAME pkg42)
+        )",
+                            fmt::format("sub{}/CMakeLists.txt", i), &cache);
+        ASSERT_EQ(sub.size(), 1);
+        EXPECT_EQ(sub[0].version, "1.42");
+    }
+    EXPECT_EQ(cache.stats().loads, 21);
+    EXPECT_EQ(cache.stats().parsed, 1);
+    EXPECT_EQ(cache.stats().reused, 20);
+
+    // A changed lock is parsed again
+    root_.write("package-lock.cmake", lock_file(300, "11.0.2"));
+    packages = evaluate("CPMUsePackageLock(package-lock.cmake)\nCPMAddPackage(NAME fmt)\n",
+                        "CMakeLists.txt", &cache);
+    ASSERT_EQ(packages.size(), 1);
+    EXPECT_EQ(packages[0].version, "11.0.2");
+    EXPECT_EQ(cache.stats().parsed, 2);
+}
+
+TEST_F(CPMPackageLockTest, LaterDeclarationsOverrideEarlierOnes) {
+    auto packages = evaluate(R"(
+        CPMDeclarePackage(fmt NAME fmt VERSION 9.0.0 GITHUB_REPOSITORY fmtlib/fmt)
+        CPMDeclarePackage(pkg1 NAME pkg1 VERSION 5.0 URL https://example.com/pkg1.zip)
+        CPMUsePackageLock(package-lock.cmake)
+        CPMDeclarePackage(pkg1 NAME pkg1 VERSION 6.0 URL https://example.com/pkg1.zip)
+        CPMUsePackageLock(missing-lock.cmake)
+        CPMAddPackage(NAME fmt)
+        CPMAddPackage(NAME pkg1)
+    )",
+                             "CMakeLists.txt", nullptr);
+    ASSERT_EQ(packages.size(), 2);
+    EXPECT_EQ(packages[0].version, "10.1.1");
+    EXPECT_EQ(packages[1].version, "6.0");
+    EXPECT_EQ(packages[1].source_type, CPMPackage::SourceType::URL);
+}
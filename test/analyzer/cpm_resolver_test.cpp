@@ -0,0 +1,151 @@
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/cpm_resolver.hpp>
+#include <finch/analyzer/version.hpp>
+#include <finch/generator/target_mapper.hpp>
+#include <finch/parser/ast/structure.hpp>
+#include <finch/parser/parser.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace {
+
+CPMPackage declaration(const std::string& name, const std::string& version,
+                       const std::string& declared_in) {
+    CPMPackage package;
+    package.name = name;
+    package.source_type = CPMPackage::SourceType::GitHub;
+    package.source = name + "lib/" + name;
+    package.version = version;
+    package.declared_in = declared_in;
+    return package;
+}
+
+} // namespace
+
+TEST(CPMResolverTest, VersionsCompareComponentsAsIntegers) {
+    EXPECT_LT(Version::parse("1.9"), Version::parse("1.10"));
+    EXPECT_EQ(Version::parse("1.2"), Version::parse("1.2.0.0"));
+    EXPECT_EQ(Version::parse("1.2rc1"), Version::parse("1.2"));
+    EXPECT_LT(Version::parse("20220623.1"), Version::parse("20230802.0"));
+    EXPECT_GT(Version::parse("1.2.3.4"), Version::parse("1.2.3"));
+    EXPECT_EQ(Version::parse("1.2.3.4.5"), Version::parse("1.2.3.4")); // Four components kept
+    EXPECT_EQ(Version::parse("v1.2"), Version::parse("0.2"));            // As in CMake
+    EXPECT_EQ(Version::parse("99999999999").component(0), 4294967295u);
+    EXPECT_EQ(Version::parse("3.20.1").to_string(), "3.20.1");
+    EXPECT_EQ(Version::parse("1.2rc1").to_string(), "1.2");
+}
+
+TEST(CPMResolverTest, VersionConditionsCompareVersions) {
+    parser::Parser parser(R"(
+        set(CMAKE_VERSION 3.20.1)
+        if(CMAKE_VERSION VERSION_LESS 3.21)
+            set(OLD_CMAKE yes)
+        endif()
+        if(${CMAKE_VERSION} VERSION_GREATER_EQUAL 3.9.10)
+            set(NEW_ENOUGH yes)
+        endif()
+        if(1.10 VERSION_GREATER 1.9)
+            set(NUMERIC yes)
+        endif()
+        if("3.20" VERSION_EQUAL 3.20.0)
+            set(PADDED yes)
+        endif()
+    )",
+                          "CMakeLists.txt");
+    auto ast = parser.parse_file();
+    ASSERT_TRUE(ast.has_value());
+
+    CMakeFileEvaluator evaluator;
+    ASSERT_TRUE(evaluator.evaluate_file(*ast.value()).has_value());
+    for (const char* name : {"OLD_CMAKE", "NEW_ENOUGH", "NUMERIC", "PADDED"}) {
+        EXPECT_TRUE(evaluator.get_variable(name).has_value()) << name;
+    }
+}
+
+TEST(CPMResolverTest, FirstDeclarationWinsAndNewerRequestsConflict) {
+    CPMResolver resolver;
+    resolver.add(declaration("fmt", "10.0.0", "CMakeLists.txt:3"));
+    resolver.add(declaration("json", "", "CMakeLists.txt:4"));
+    for (int i = 0; i < 40; ++i) {
+        auto version = i % 4 == 0 ? "10.2.1" : "9.1.0";
+        resolver.add(declaration("fmt", version, fmt::format("sub{}/CMakeLists.txt:1", i)));
+    }
+    auto tagged = declaration("json", "", "lib/CMakeLists.txt:7");
+    tagged.git_tag = "v3.11.2";
+    resolver.add(tagged);
+
+    ASSERT_EQ(resolver.packages().size(), 2);
+    EXPECT_EQ(resolver.packages()[0].version, "10.0.0");
+    EXPECT_EQ(resolver.packages()[0].declared_in, "CMakeLists.txt:3");
+    ASSERT_EQ(resolver.conflicts().size(), 11);
+    const auto& conflict = resolver.conflicts()[0];
+    EXPECT_EQ(conflict.name, "fmt");
+    EXPECT_EQ(conflict.version, "10.0.0");
+    EXPECT_EQ(conflict.requested_version, "10.2.1");
+    EXPECT_EQ(conflict.requested_in, "sub0/CMakeLists.txt:1");
+    EXPECT_EQ(resolver.conflicts().back().name, "json");
+    EXPECT_EQ(resolver.conflicts().back().requested_version, "3.11.2");
+
+    // A commit is version 0 to CPM
+    auto commit = declaration("zlib", "", "");
+    commit.git_tag = std::string(40, 'a');
+    EXPECT_EQ(CPMResolver::version_of(commit), Version::parse("0"));
+
+    // Resolution is linear in the declarations
+    ProjectAnalysis analysis;
+    for (int i = 0; i < 100000; ++i) {
+        analysis.cpm_packages.push_back(
+            declaration(fmt::format("pkg{}", i % 1000), fmt::format("1.{}", i / 1000), ""));
+    }
+    CPMResolver::resolve(analysis);
+    EXPECT_EQ(analysis.cpm_packages.size(), 1000);
+    EXPECT_EQ(analysis.warnings.size(), 99000);
+}
+
+TEST(CPMResolverTest, EvaluatedDeclarationsBecomeHttpArchives) {
+    parser::Parser parser(R"(
+        CPMAddPackage("gh:fmtlib/fmt#10.0.0")
+        CPMAddPackage(NAME nlohmann_json GITHUB_REPOSITORY nlohmann/json VERSION 3.11.2)
+        CPMAddPackage(NAME fmt GIT_REPOSITORY https://github.com/fmtlib/fmt.git GIT_TAG 11.0.0)
+        CPMAddPackage(NAME local SOURCE_DIR /src/local)
+    )",
+                          "CMakeLists.txt");
+    auto ast = parser.parse_file();
+    ASSERT_TRUE(ast.has_value());
+
+    CMakeFileEvaluator evaluator;
+    evaluator.set_slicing(true);
+    auto analysis = evaluator.analyze(*ast.value());
+    ASSERT_TRUE(analysis.has_value());
+    EXPECT_EQ(analysis.value().cpm_packages.size(), 4);
+    EXPECT_EQ(value_helpers::to_string(evaluator.get_variable("CPM_PACKAGE_fmt_VERSION")->value),
+              "10.0.0");
+    EXPECT_EQ(value_helpers::to_string(evaluator.get_variable("fmt_ADDED")->value), "NO");
+    EXPECT_EQ(value_helpers::to_string(evaluator.get_variable("nlohmann_json_ADDED")->value),
+              "YES");
+
+    CPMResolver::resolve(analysis.value());
+    const auto& packages = analysis.value().cpm_packages;
+    ASSERT_EQ(packages.size(), 3);
+    EXPECT_EQ(packages[0].declared_in, "CMakeLists.txt:2");
+    ASSERT_EQ(analysis.value().warnings.size(), 1);
+    EXPECT_NE(analysis.value().warnings[0].find("(11.0.0)"), std::string::npos);
+
+    generator::TargetMapper mapper;
+    auto fmt_archive = mapper.map_cpm_package(packages[0]);
+    ASSERT_TRUE(fmt_archive.has_value());
+    EXPECT_EQ(fmt_archive->rule_type, generator::Buck2RuleType::HttpArchive);
+    EXPECT_EQ(fmt_archive->properties.at("urls"),
+              R"(["https://github.com/fmtlib/fmt/archive/10.0.0.tar.gz"])");
+    EXPECT_EQ(fmt_archive->properties.at("strip_prefix"), R"("fmt-10.0.0")");
+
+    auto json_archive = mapper.map_cpm_package(packages[1]);
+    ASSERT_TRUE(json_archive.has_value());
+    EXPECT_EQ(json_archive->properties.at("urls"),
+              R"(["https://github.com/nlohmann/json/archive/v3.11.2.tar.gz"])");
+    EXPECT_EQ(json_archive->properties.at("strip_prefix"), R"("json-3.11.2")");
+
+    EXPECT_FALSE(mapper.map_cpm_package(packages[2]).has_value());
+}
@@ -0,0 +1,147 @@
+#include "support/temp_directory.hpp"
+#include <filesystem>
+#include <finch/analyzer/cpm_source_cache.hpp>
+#include <finch/core/sha256.hpp>
+#include <finch/generator/target_mapper.hpp>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+CPMPackage github(const std::string& name, const std::string& repository,
+                  const std::string& version, const std::string& git_tag = "") {
+    CPMPackage package;
+    package.name = name;
+    package.source_type = CPMPackage::SourceType::GitHub;
+    package.source = repository;
+    package.version = version;
+    package.git_tag = git_tag;
+    return package;
+}
+
+// A CPM_SOURCE_CACHE holding archives beside the checkouts CPM made
+class CPMSourceCacheTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        root_.write("fmt/fmt-10.0.0.tar.gz", "fmt 10.0.0 archive");
+        root_.write("fmt/fmt-9.1.0.tar.gz", "fmt 9.1.0 archive");
+        root_.write("fmt/README", "not an archive");
+        root_.write("zlib/v1.3.1.zip", "zlib archive");
+        root_.write("nlohmann_json/0123abcd/.git/packed-refs",
+                    "# pack-refs with: peeled fully-peeled sorted\n"
+                    "1111111111111111111111111111111111111111 refs/heads/develop\n"
+                    "2222222222222222222222222222222222222222 refs/tags/v3.11.2\n"
+                    "^3333333333333333333333333333333333333333\n");
+        root_.write("nlohmann_json/0123abcd/.git/refs/tags/v3.11.3", "4444\n");
+        root_.write("nlohmann_json/0123abcd/CMakeLists.txt", "project(json)\n");
+    }
+
+    test::TempDirectory root_{"cpm_source_cache_test"};
+    // The index is kept outside the cache it describes
+    test::TempDirectory scratch_{"cpm_source_cache_index"};
+    fs::path index_ = scratch_ / "index.json";
+};
+
+} // namespace
+
+TEST(Sha256Test, MatchesReferenceDigests) {
+    EXPECT_EQ(Sha256::hex(""),
+              "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(Sha256::hex("abc"),
+              "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ(Sha256::hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+              "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+
+    // Fed in uneven pieces, a million 'a' hash as one input
+    std::string million(1000000, 'a');
+    Sha256 hasher;
+    for (size_t pos = 0, step = 1; pos < million.size(); pos += step, step = step * 3 % 1000 + 1) {
+        hasher.update(std::string_view(million).substr(pos, step));
+    }
+    EXPECT_EQ(Sha256::to_hex(hasher.finish()),
+              "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST_F(CPMSourceCacheTest, MatchesDeclarationsToArchivesAndCheckouts) {
+    auto cache = CPMSourceCache::build(root_.path());
+    EXPECT_EQ(cache.stats().archives, 3);
+    EXPECT_EQ(cache.stats().sources, 1);
+    EXPECT_EQ(cache.stats().hashed, 3);
+
+    const auto* fmt_entry = cache.find(github("fmt", "fmtlib/fmt", "10.0.0"));
+    ASSERT_NE(fmt_entry, nullptr);
+    EXPECT_EQ(fmt_entry->path.filename(), "fmt-10.0.0.tar.gz");
+    EXPECT_EQ(fmt_entry->sha256, Sha256::hex("fmt 10.0.0 archive"));
+
+    // Names match case-insensitively; a 'v' tag matches a VERSION
+    EXPECT_NE(cache.find(github("ZLIB", "madler/zlib", "1.3.1")), nullptr);
+    EXPECT_EQ(cache.find(github("fmt", "fmtlib/fmt", "0.0")), nullptr);
+    EXPECT_EQ(cache.find(github("fmt", "fmtlib/fmt", "", "10.0")), nullptr);
+
+    CPMPackage url;
+    url.name = "zlib";
+    url.source_type = CPMPackage::SourceType::URL;
+    url.source = "https://github.com/madler/zlib/archive/v1.3.1.zip?download=1";
+    EXPECT_NE(cache.find(url), nullptr);
+
+    const auto* json_entry =
+        cache.find(github("nlohmann_json", "nlohmann/json", "", "v3.11.2"));
+    ASSERT_NE(json_entry, nullptr);
+    EXPECT_EQ(json_entry->kind, CPMSourceCache::Entry::Kind::Source);
+    EXPECT_EQ(json_entry->refs, (std::vector<std::string>{"v3.11.2", "v3.11.3"}));
+
+    std::vector<CPMPackage> packages = {github("fmt", "fmtlib/fmt", "10.0.0"),
+                                        github("nlohmann_json", "nlohmann/json", "3.11.3"),
+                                        github("spdlog", "gabime/spdlog", "1.12.0")};
+    auto warnings = cache.fill(packages);
+    ASSERT_EQ(warnings.size(), 1);
+    EXPECT_NE(warnings[0].find("nlohmann_json"), std::string::npos);
+    EXPECT_EQ(packages[0].sha256, fmt_entry->sha256);
+    EXPECT_TRUE(packages[1].sha256.empty());
+
+    generator::TargetMapper mapper;
+    auto archive = mapper.map_cpm_package(packages[0]);
+    ASSERT_TRUE(archive.has_value());
+    EXPECT_EQ(archive->properties.at("sha256"), "\"" + fmt_entry->sha256 + "\"");
+    EXPECT_EQ(mapper.map_cpm_package(packages[2])->properties.count("sha256"), 0);
+}
+
+TEST_F(CPMSourceCacheTest, RepeatRunsOnlyHashChangedArchives) {
+    for (size_t i = 0; i < 64; ++i) {
+        root_.write(fmt::format("pkg{}/pkg{}-1.0.{}.tar.gz", i, i, i),
+                    std::string(4096 + i, static_cast<char>('a' + i % 26)));
+    }
+
+    auto first = CPMSourceCache::update(root_.path(), index_, 4);
+    EXPECT_EQ(first.stats().hashed, 67);
+    EXPECT_EQ(first.stats().reused, 0);
+    auto serial = CPMSourceCache::build(root_.path(), nullptr, 1);
+    ASSERT_EQ(serial.entries().size(), first.entries().size());
+    for (size_t i = 0; i < serial.entries().size(); ++i) {
+        EXPECT_EQ(serial.entries()[i].sha256, first.entries()[i].sha256);
+    }
+
+    auto second = CPMSourceCache::update(root_.path(), index_, 4);
+    EXPECT_EQ(second.stats().hashed, 0);
+    EXPECT_EQ(second.stats().reused, 67);
+
+    // A rewritten archive of another size is hashed again
+    root_.write("fmt/fmt-10.0.0.tar.gz", "fmt 10.0.0 archive, repacked");
+    auto third = CPMSourceCache::update(root_.path(), index_, 4);
+    EXPECT_EQ(third.stats().hashed, 1);
+    EXPECT_EQ(third.stats().reused, 66);
+    EXPECT_EQ(third.find(github("fmt", "fmtlib/fmt", "10.0.0"))->sha256,
+              Sha256::hex("fmt 10.0.0 archive, repacked"));
+
+    // An index saved for another cache is not trusted
+    auto moved = scratch_ / "moved";
+    fs::rename(root_.path(), moved);
+    auto elsewhere = CPMSourceCache::update(moved, index_, 4);
+    EXPECT_EQ(elsewhere.stats().reused, 0);
+    fs::rename(moved, root_.path());
+}
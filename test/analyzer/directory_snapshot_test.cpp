@@ -0,0 +1,158 @@
+#include "support/temp_directory.hpp"
+#include <filesystem>
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/directory_snapshot.hpp>
+#include <finch/parser/parser.hpp>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <iterator>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A project laid out the way globbing CMakeLists.txt files expect
+class DirectorySnapshotTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        root_.write("src/main.cpp");
+        root_.write("src/util.cpp");
+        root_.write("src/util.h");
+        root_.write("src/net/socket.cpp");
+        root_.write("src/net/socket.h");
+        root_.write("src/net/tls/context.cpp");
+        root_.write("src/.hidden.cpp");
+        root_.write("tests/test_1.cpp");
+        root_.write("tests/test_a.cpp");
+        fs::create_directories(root_ / "src/empty.cpp.d");
+    }
+
+    std::vector<std::string> under_root(std::initializer_list<std::string> paths) const {
+        std::vector<std::string> result;
+        for (const auto& path : paths) {
+            result.push_back((root_ / path).generic_string());
+        }
+        return result;
+    }
+
+    PathList paths_under_root(std::initializer_list<std::string> paths) const {
+        auto strings = under_root(paths);
+        return PathList(strings.begin(), strings.end());
+    }
+
+    test::TempDirectory root_{"directory_snapshot_test"};
+};
+
+using Strings = std::vector<std::string>;
+
+} // namespace
+
+TEST(GlobMatcherTest, MatchesOneComponent) {
+    EXPECT_TRUE(GlobMatcher("*.cpp").matches("main.cpp"));
+    EXPECT_TRUE(GlobMatcher("*.cpp").matches(".cpp"));
+    EXPECT_FALSE(GlobMatcher("*.cpp").matches("main.cpp.in"));
+    EXPECT_TRUE(GlobMatcher("*_*.c*").matches("test_unit.cc"));
+    EXPECT_TRUE(GlobMatcher("test_?.cpp").matches("test_1.cpp"));
+    EXPECT_FALSE(GlobMatcher("test_?.cpp").matches("test_10.cpp"));
+    EXPECT_TRUE(GlobMatcher("test_[0-9].cpp").matches("test_1.cpp"));
+    EXPECT_FALSE(GlobMatcher("test_[!0-9].cpp").matches("test_1.cpp"));
+    EXPECT_TRUE(GlobMatcher("test_[!0-9].cpp").matches("test_a.cpp"));
+    EXPECT_TRUE(GlobMatcher("[]x]").matches("]"));
+    EXPECT_TRUE(GlobMatcher("a[b").matches("a[b"));
+    EXPECT_TRUE(GlobMatcher("main.cpp").is_literal());
+    EXPECT_FALSE(GlobMatcher("*").is_literal());
+}
+
+TEST_F(DirectorySnapshotTest, GlobsMatchLikeCMake) {
+    DirectorySnapshot snapshot;
+    DirectorySnapshot::Options files{.recurse = false, .list_directories = false};
+    EXPECT_EQ(snapshot.glob(root_ / "src/*.cpp", files),
+              under_root({"src/.hidden.cpp", "src/main.cpp", "src/util.cpp"}));
+
+    // GLOB lists matching directories by default
+    EXPECT_EQ(snapshot.glob(root_ / "src/*.cpp*", {}),
+              under_root({"src/.hidden.cpp", "src/empty.cpp.d", "src/main.cpp", "src/util.cpp"}));
+
+    // Wildcards in directory components, and a literal last component
+    EXPECT_EQ(snapshot.glob(root_ / "*/net/socket.h", files), under_root({"src/net/socket.h"}));
+
+    DirectorySnapshot::Options recurse{.recurse = true, .list_directories = false};
+    EXPECT_EQ(snapshot.glob(root_ / "src/*.cpp", recurse),
+              under_root({"src/.hidden.cpp", "src/main.cpp", "src/net/socket.cpp",
+                          "src/net/tls/context.cpp", "src/util.cpp"}));
+    recurse.list_directories = true;
+    EXPECT_EQ(snapshot.glob(root_ / "src/net/*.h", recurse),
+              under_root({"src/net/socket.h", "src/net/tls"}));
+
+    EXPECT_TRUE(snapshot.glob(root_ / "missing/*.cpp", recurse).empty());
+}
+
+TEST_F(DirectorySnapshotTest, FileGlobFeedsTargets) {
+    parser::Parser parser(fmt::format(R"cmake(
+        set(CMAKE_CURRENT_SOURCE_DIR "{}")
+        file(GLOB SOURCES CONFIGURE_DEPENDS src/*.cpp src/*.h)
+        file(GLOB_RECURSE ALL_SOURCES RELATIVE ${{CMAKE_CURRENT_SOURCE_DIR}}/src src/*.cpp)
+        file(GLOB TESTS LIST_DIRECTORIES false "${{CMAKE_CURRENT_SOURCE_DIR}}/tests/*.cpp")
+        add_library(core ${{SOURCES}})
+        add_executable(unit_tests ${{TESTS}})
+    )cmake",
+                                      root_.path().generic_string()),
+                          "CMakeLists.txt");
+    auto file = parser.parse_file();
+    ASSERT_TRUE(file.has_value());
+
+    DirectorySnapshot snapshot;
+    CMakeFileEvaluator evaluator;
+    evaluator.set_directory_snapshot(&snapshot);
+    auto analysis = evaluator.analyze(*file.value());
+    ASSERT_TRUE(analysis.has_value());
+
+    ASSERT_EQ(analysis.value().targets.size(), 2);
+    EXPECT_EQ(analysis.value().targets[0].sources,
+              paths_under_root({"src/.hidden.cpp", "src/main.cpp", "src/util.cpp", "src/util.h"}));
+    EXPECT_EQ(analysis.value().targets[1].sources,
+              paths_under_root({"tests/test_1.cpp", "tests/test_a.cpp"}));
+    auto all = evaluator.get_variable("ALL_SOURCES");
+    ASSERT_TRUE(all.has_value());
+    EXPECT_EQ(value_helpers::to_list(all->value),
+              (Strings{".hidden.cpp", "main.cpp", "net/socket.cpp", "net/tls/context.cpp",
+                       "util.cpp"}));
+    EXPECT_EQ(snapshot.stats().globs, 4);
+}
+
+TEST_F(DirectorySnapshotTest, OverlappingRecursiveGlobsReadTheTreeOnce) {
+    // A wide tree: 40 modules of 3 levels, 25 files each
+    for (int module = 0; module < 40; ++module) {
+        for (int level = 0; level < 3; ++level) {
+            fs::path directory = fmt::format("modules/m{}", module);
+            for (int depth = 0; depth < level; ++depth) {
+                directory /= fmt::format("d{}", depth);
+            }
+            for (int i = 0; i < 25; ++i) {
+                root_.write(directory / fmt::format("file{}.{}", i, i % 2 ? "cpp" : "h"));
+            }
+        }
+    }
+
+    DirectorySnapshot snapshot;
+    DirectorySnapshot::Options recurse{.recurse = true, .list_directories = false};
+    auto first = snapshot.glob(root_ / "modules/*.cpp", recurse);
+    auto read = snapshot.stats().directories_read;
+    EXPECT_EQ(first.size(), 40 * 3 * 12);
+    // The directories on the way to the tree are read too, one per component
+    auto ancestors = static_cast<size_t>(std::distance(root_.path().begin(), root_.path().end()));
+    EXPECT_EQ(read, ancestors + 1 + 40 * 3);
+
+    // Dozens more over the same tree read nothing
+    size_t matched = 0;
+    for (int module = 0; module < 40; ++module) {
+        matched += snapshot.glob(root_ / fmt::format("modules/m{}/*.h", module), recurse).size();
+    }
+    matched += snapshot.glob(root_ / "modules/*/d0/*.cpp", recurse).size();
+    EXPECT_EQ(matched, 40 * 3 * 13 + 40 * 2 * 12);
+    EXPECT_EQ(snapshot.stats().directories_read, read);
+    EXPECT_EQ(snapshot.stats().globs, 42);
+}
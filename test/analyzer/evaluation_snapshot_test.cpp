@@ -0,0 +1,170 @@
+#include "support/temp_directory.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/evaluation_snapshot.hpp>
+#include <finch/parser/parser.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Strings = std::vector<std::string>;
+
+// Evaluates a project's top CMakeLists.txt once per run, each run with a
+// fresh evaluator and store sharing one snapshot directory
+class EvaluationSnapshotTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        root_.write("src/CMakeLists.txt", R"cmake(
+            file(GLOB sources ${CMAKE_CURRENT_SOURCE_DIR}/*.cpp)
+            add_library(core ${sources})
+            target_compile_definitions(core PRIVATE LEVEL=${LEVEL})
+        )cmake");
+        root_.write("src/a.cpp");
+        root_.write("app/CMakeLists.txt", R"cmake(
+            add_executable(app main.cpp)
+            target_link_libraries(app PRIVATE core)
+        )cmake");
+        top_ = R"cmake(
+            project(demo)
+            set(LEVEL 1)
+            add_subdirectory(src)
+            add_subdirectory(app)
+        )cmake";
+    }
+
+    ProjectAnalysis run() {
+        root_.write("CMakeLists.txt", top_);
+        parser::Parser parser(top_, (root_ / "CMakeLists.txt").string());
+        auto file = parser.parse_file();
+        EXPECT_TRUE(file.has_value());
+
+        EvaluationSnapshotStore::Options options;
+        options.directory = root_ / "snapshots";
+        options.evaluation_options = "test";
+        EvaluationSnapshotStore store(options);
+        CMakeFileEvaluator evaluator;
+        evaluator.set_snapshot_store(&store);
+        evaluator.set_source_directories(root_.path(), root_.path());
+        auto analysis = evaluator.analyze(*file.value());
+        EXPECT_TRUE(analysis.has_value());
+        stats_ = store.stats();
+        return analysis.has_value() ? analysis.value() : ProjectAnalysis{};
+    }
+
+    static const Target* find_target(const ProjectAnalysis& analysis, const std::string& name) {
+        auto it = std::find_if(analysis.targets.begin(), analysis.targets.end(),
+                               [&](const Target& target) { return target.name == name; });
+        return it == analysis.targets.end() ? nullptr : &*it;
+    }
+
+    test::TempDirectory root_{"evaluation_snapshot_test"};
+    std::string top_;
+    EvaluationSnapshotStore::Stats stats_;
+};
+
+} // namespace
+
+TEST_F(EvaluationSnapshotTest, UnchangedProjectIsRestored) {
+    auto first = run();
+    EXPECT_EQ(stats_.restored, 0);
+    EXPECT_EQ(stats_.saved, 3);
+
+    auto second = run();
+    EXPECT_EQ(stats_.lookups, 1);
+    EXPECT_EQ(stats_.restored, 1);
+    EXPECT_EQ(second.targets, first.targets);
+    EXPECT_EQ(second.project_name, "demo");
+    EXPECT_EQ(second.subdirectory_files, first.subdirectory_files);
+
+    const auto* core = find_target(second, "core");
+    ASSERT_NE(core, nullptr);
+    EXPECT_EQ(core->compile_definitions, Strings{"LEVEL=1"});
+    EXPECT_EQ(core->sources.size(), 1);
+}
+
+TEST_F(EvaluationSnapshotTest, OnlyChangedSubtreesAreEvaluated) {
+    (void)run();
+    root_.write("app/CMakeLists.txt", R"cmake(
+        add_executable(app main.cpp)
+        target_link_libraries(app PRIVATE core extra)
+    )cmake");
+
+    auto analysis = run();
+    // The top file read app/CMakeLists.txt, so it and app are evaluated;
+    // src starts from the same state and is restored
+    EXPECT_EQ(stats_.stale, 2);
+    EXPECT_EQ(stats_.restored, 1);
+    const auto* app = find_target(analysis, "app");
+    ASSERT_NE(app, nullptr);
+    EXPECT_EQ(app->link_libraries, (Strings{"core", "extra"}));
+    ASSERT_NE(find_target(analysis, "core"), nullptr);
+}
+
+TEST_F(EvaluationSnapshotTest, ParentStateChangesInvalidateChildren) {
+    (void)run();
+    top_ = R"cmake(
+        project(demo)
+        set(LEVEL 2)
+        add_subdirectory(src)
+        add_subdirectory(app)
+    )cmake";
+
+    auto analysis = run();
+    EXPECT_EQ(stats_.restored, 0);
+    const auto* core = find_target(analysis, "core");
+    ASSERT_NE(core, nullptr);
+    EXPECT_EQ(core->compile_definitions, Strings{"LEVEL=2"});
+}
+
+TEST_F(EvaluationSnapshotTest, GlobResultsAreInputs) {
+    (void)run();
+    root_.write("src/b.cpp");
+
+    auto analysis = run();
+    const auto* core = find_target(analysis, "core");
+    ASSERT_NE(core, nullptr);
+    EXPECT_EQ(core->sources.size(), 2);
+    // app reads neither the glob nor src's files
+    EXPECT_EQ(stats_.restored, 1);
+}
+
+TEST(EvaluationStateHashTest, UpdatedDigestMatchesAFreshOne) {
+    auto target = [](const std::string& name) {
+        Target made;
+        made.name = name;
+        return made;
+    };
+
+    EvaluationContext parent;
+    parent.set_variable("LEVEL", "1");
+    auto changed = parent.create_directory_scope();
+    changed->set_variable("GONE", "x");
+    changed->add_target(target("old"));
+    auto before = EvaluationSnapshotStore::state_hash(*changed);
+
+    // Changed after the first hash: only these are hashed again
+    changed->unset_variable("GONE");
+    changed->set_variable("KEPT", "y");
+    changed->set_cache_variable("CACHED", "ON");
+    changed->find_target("old")->name = "core";
+    changed->add_target(target("app"));
+    auto after = EvaluationSnapshotStore::state_hash(*changed);
+    EXPECT_NE(after, before);
+
+    auto fresh = parent.create_directory_scope();
+    fresh->set_variable("KEPT", "y");
+    fresh->set_cache_variable("CACHED", "ON");
+    fresh->add_target(target("core"));
+    fresh->add_target(target("app"));
+    EXPECT_EQ(EvaluationSnapshotStore::state_hash(*fresh), after);
+
+    // A parent's change is seen through it
+    parent.set_variable("LEVEL", "2");
+    EXPECT_NE(EvaluationSnapshotStore::state_hash(*fresh), after);
+}
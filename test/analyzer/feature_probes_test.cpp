@@ -0,0 +1,151 @@
+#include "support/temp_directory.hpp"
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/feature_probes.hpp>
+#include <finch/parser/ast/structure.hpp>
+#include <finch/parser/parser.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace {
+
+class FeatureProbesTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        options_.cache_file = root_ / "probes.json";
+        options_.max_threads = 4;
+
+        // The probes need a working C compiler
+        ProbeExecutor compiler_check(ProbeExecutor::Options{});
+        compiler_check.enqueue(FeatureProbe::include_files("X", {}, FeatureProbe::Language::C));
+        if (!compiler_check.has_pending()) {
+            GTEST_SKIP() << "No C compiler available";
+        }
+    }
+
+    test::TempDirectory root_{"feature_probes_test"};
+    ProbeExecutor::Options options_;
+};
+
+} // namespace
+
+TEST_F(FeatureProbesTest, CompilesQueuedProbesAndCachesAnswers) {
+    using Language = FeatureProbe::Language;
+    std::vector<FeatureProbe> probes = {
+        FeatureProbe::include_files("HAVE_STDIO_H", {"stdio.h"}, Language::C),
+        FeatureProbe::include_files("HAVE_MISSING_H", {"finch_missing_header.h"}, Language::C),
+        FeatureProbe::symbol_exists("HAVE_PRINTF", "printf", {"stdio.h"}, Language::C),
+        FeatureProbe::symbol_exists("HAVE_EOF", "EOF", {"stdio.h"}, Language::C),
+        FeatureProbe::function_exists("HAVE_MISSING_FN", "finch_missing_function"),
+        FeatureProbe::source_compiles("HAVE_BROKEN", "int main(void) { return x; }", Language::C),
+    };
+
+    ProbeExecutor executor(options_);
+    for (const auto& probe : probes) {
+        EXPECT_FALSE(executor.lookup(probe).has_value());
+        executor.enqueue(probe);
+        executor.enqueue(probe); // Queued once
+    }
+    auto stats = executor.run();
+    EXPECT_EQ(stats.compiled, probes.size());
+    EXPECT_EQ(stats.succeeded, 3);
+
+    std::vector<bool> expected = {true, false, true, true, false, false};
+    for (size_t i = 0; i < probes.size(); ++i) {
+        EXPECT_EQ(executor.lookup(probes[i]), expected[i]) << probes[i].result_variable;
+    }
+
+    // A later run answers everything from the cache; other flags are a different probe
+    ProbeExecutor again(options_);
+    for (size_t i = 0; i < probes.size(); ++i) {
+        EXPECT_EQ(again.lookup(probes[i]), expected[i]) << probes[i].result_variable;
+    }
+    auto with_flags = probes[0];
+    with_flags.flags.push_back("-DFINCH");
+    EXPECT_FALSE(again.lookup(with_flags).has_value());
+    EXPECT_EQ(again.stats().cache_hits, probes.size());
+}
+
+TEST_F(FeatureProbesTest, ConcurrentRunsMergeTheirAnswersPerPlatform) {
+    using Language = FeatureProbe::Language;
+    auto stdio = FeatureProbe::include_files("HAVE_STDIO_H", {"stdio.h"}, Language::C);
+    auto missing =
+        FeatureProbe::include_files("HAVE_MISSING_H", {"finch_missing_header.h"}, Language::C);
+
+    // Both load the empty cache, then each saves its own answer
+    ProbeExecutor first(options_);
+    ProbeExecutor second(options_);
+    first.enqueue(stdio);
+    first.run();
+    second.enqueue(missing);
+    second.run();
+
+    ProbeExecutor later(options_);
+    EXPECT_EQ(later.lookup(stdio), true);
+    EXPECT_EQ(later.lookup(missing), false);
+
+    // The host compiler's answers are not another platform's
+    auto other = options_;
+    other.platform = later.platform() == "windows" ? "linux" : "windows";
+    ProbeExecutor cross(other);
+    EXPECT_FALSE(cross.lookup(stdio).has_value());
+}
+
+TEST_F(FeatureProbesTest, EvaluatorFeedsAnswersIntoPlatformChecks) {
+    const char* code = R"(
+        check_include_file(stdio.h HAVE_STDIO_H)
+        check_symbol_exists(finch_missing_symbol "stdlib.h" HAVE_MISSING_SYMBOL)
+        set(CMAKE_REQUIRED_DEFINITIONS -DFINCH_PROBE=1)
+        check_c_source_compiles("
+#if FINCH_PROBE != 1
+#error
+#endif
+int main(void) { return 0; }" HAVE_REQUIRED_DEFINITIONS)
+        if(HAVE_MISSING_SYMBOL)
+            set(USES_MISSING_SYMBOL yes)
+        endif()
+    )";
+
+    parser::Parser parser(code, "test.cmake");
+    auto ast = parser.parse_file();
+    ASSERT_TRUE(ast.has_value());
+
+    ProbeExecutor executor(options_);
+    auto evaluate = [&]() {
+        EvaluationContext context;
+        context.initialize_builtin_variables();
+        context.set_probe_executor(&executor);
+        CMakeEvaluator evaluator(context);
+        for (const auto& stmt : ast.value()->statements()) {
+            (void)evaluator.evaluate(*stmt);
+        }
+        return context;
+    };
+
+    // The first pass only collects the probes
+    auto first = evaluate();
+    EXPECT_FALSE(first.get_platform_check("HAVE_STDIO_H").has_value());
+    ASSERT_TRUE(executor.has_pending());
+    EXPECT_EQ(executor.run().compiled, 3);
+
+    auto second = evaluate();
+    EXPECT_EQ(second.get_platform_check("HAVE_STDIO_H"), true);
+    EXPECT_EQ(second.get_platform_check("HAVE_MISSING_SYMBOL"), false);
+    EXPECT_EQ(second.get_platform_check("HAVE_REQUIRED_DEFINITIONS"), true);
+    EXPECT_EQ(std::get<std::string>(second.get_cache_variable("HAVE_STDIO_H")->value), "1");
+    EXPECT_EQ(std::get<std::string>(second.get_cache_variable("HAVE_MISSING_SYMBOL")->value), "");
+    EXPECT_FALSE(second.get_variable("USES_MISSING_SYMBOL").has_value());
+    EXPECT_FALSE(executor.has_pending());
+}
+
+TEST(ProbeExecutorTest, MissingCompilerLeavesProbesUnknown) {
+    ProbeExecutor::Options options;
+    options.c_compiler = "finch-no-such-compiler";
+    ProbeExecutor executor(options);
+
+    auto probe = FeatureProbe::include_files("HAVE_STDIO_H", {"stdio.h"}, FeatureProbe::Language::C);
+    EXPECT_FALSE(executor.lookup(probe).has_value());
+    executor.enqueue(probe);
+    EXPECT_FALSE(executor.has_pending());
+}
@@ -0,0 +1,140 @@
+#include "support/temp_directory.hpp"
+#include <filesystem>
+#include <finch/analyzer/file_api.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const fs::path reply_directory = fs::path(".cmake") / "api" / "v1" / "reply";
+
+void write_project(const test::TempDirectory& tmp, const std::string& app_target,
+                   const std::string& build_root = "/src/build") {
+    tmp.write(reply_directory / "index-2024-01-01T00-00-00-0000.json",
+              R"({"reply": {"codemodel-v2": {"jsonFile": "codemodel.json"}}})");
+    tmp.write(reply_directory / "codemodel.json", R"({
+        "paths": {"source": "/src", "build": ")" + build_root + R"("},
+        "configurations": [
+            {"name": "Debug", "projects": [{"name": "demo"}], "targets": []},
+            {"name": "Release", "projects": [{"name": "demo"}], "targets": [
+                {"name": "core", "id": "core::@1", "jsonFile": "core.json"},
+                {"name": "app", "id": "app::@2", "jsonFile": "app.json"}
+            ]}
+        ]})");
+    tmp.write(reply_directory / "core.json", R"({
+        "name": "core", "id": "core::@1", "type": "SHARED_LIBRARY",
+        "paths": {"source": "lib", "build": "lib"},
+        "sources": [{"path": "lib/a.cpp", "compileGroupIndex": 0},
+                    {"path": "lib/b.c", "compileGroupIndex": 1},
+                    {"path": "lib/CMakeLists.txt"}],
+        "compileGroups": [
+            {"language": "CXX", "includes": [{"path": "/src/lib/./include"}],
+             "defines": [{"define": "CORE"}],
+             "compileCommandFragments": [{"fragment": "-Xclang -a -Xclang -b"}]},
+            {"language": "C", "includes": [{"path": "/src/lib/include"}],
+             "defines": [{"define": "CORE"}]}
+        ]})");
+    tmp.write(reply_directory / "app.json", app_target);
+}
+
+} // namespace
+
+TEST(FileApiReaderTest, ReadsCheckedInFixture) {
+    FileApiReader reader;
+    auto analysis =
+        reader.read(fs::path(FINCH_TEST_PROJECTS_DIR) / "simple-library" / "file-api-reply");
+    ASSERT_TRUE(analysis.has_value()) << analysis.error().message();
+
+    EXPECT_EQ(analysis.value().project_name, "simple-library");
+    ASSERT_EQ(analysis.value().targets.size(), 1); // ZERO_CHECK is generator-provided
+
+    const auto& calculator = analysis.value().targets[0];
+    EXPECT_EQ(calculator.name, "calculator");
+    EXPECT_EQ(calculator.type, Target::Type::StaticLibrary);
+    EXPECT_EQ(calculator.confidence, Target::Confidence::Certain);
+    EXPECT_EQ(calculator.source_directory, fs::path("/work/simple-library"));
+    EXPECT_EQ(calculator.sources, (PathList{"src/calculator.cpp"}));
+    EXPECT_EQ(calculator.headers, (PathList{"include/simple/calculator.hpp"}));
+    EXPECT_EQ(calculator.include_directories, (PathList{"include"}));
+    EXPECT_EQ(calculator.compile_definitions, (std::vector<std::string>{"SIMPLE_CALCULATOR=1"}));
+    EXPECT_EQ(calculator.compile_options, (std::vector<std::string>{"-O3", "-DNDEBUG"}));
+}
+
+TEST(FileApiReaderTest, MapsDependenciesAndSelectsConfiguration) {
+    test::TempDirectory tmp("file_api_test");
+    write_project(tmp, R"({
+        "name": "app", "id": "app::@2", "type": "EXECUTABLE",
+        "paths": {"source": "app", "build": "app"},
+        "sources": [{"path": "app/main.cpp", "compileGroupIndex": 0}],
+        "compileGroups": [{"language": "CXX"}],
+        "dependencies": [{"id": "core::@1"}],
+        "link": {"commandFragments": [
+            {"fragment": "-O2", "role": "flags"},
+            {"fragment": "../lib/libcore.so", "role": "libraries"},
+            {"fragment": "/usr/lib/libz.so", "role": "libraries"},
+            {"fragment": "/src/build/lib/libcore.so", "role": "libraries"},
+            {"fragment": "/src/buildtools/libtool.a", "role": "libraries"},
+            {"fragment": "-lpthread", "role": "libraries"}]}
+    })");
+
+    FileApiReader reader(2);
+    auto analysis = reader.read(tmp.path(), std::string("Release"));
+    ASSERT_TRUE(analysis.has_value()) << analysis.error().message();
+    ASSERT_EQ(analysis.value().targets.size(), 2);
+
+    const auto& core = analysis.value().targets[0];
+    EXPECT_EQ(core.type, Target::Type::SharedLibrary);
+    EXPECT_EQ(core.source_directory, fs::path("/src/lib"));
+    EXPECT_EQ(core.sources, (PathList{"a.cpp", "b.c"}));
+    EXPECT_EQ(core.include_directories, (PathList{"include"}));
+    EXPECT_EQ(core.compile_definitions, (std::vector<std::string>{"CORE"}));
+    EXPECT_EQ(core.compile_options,
+              (std::vector<std::string>{"-Xclang", "-a", "-Xclang", "-b"}));
+
+    const auto& app = analysis.value().targets[1];
+    EXPECT_EQ(app.type, Target::Type::ExecutableTarget);
+    EXPECT_EQ(app.link_libraries, (std::vector<std::string>{"core"}));
+    EXPECT_EQ(app.link_flags, (std::vector<std::string>{"/usr/lib/libz.so",
+                                                        "/src/buildtools/libtool.a", "-lpthread"}));
+}
+
+TEST(FileApiReaderTest, KeepsAbsoluteLibrariesWithoutABuildRoot) {
+    test::TempDirectory tmp("file_api_test");
+    write_project(tmp, R"({
+        "name": "app", "id": "app::@2", "type": "EXECUTABLE",
+        "paths": {"source": "app", "build": "app"},
+        "sources": [{"path": "app/main.cpp", "compileGroupIndex": 0}],
+        "link": {"commandFragments": [
+            {"fragment": "/usr/lib/libz.so", "role": "libraries"}]}
+    })",
+                  "");
+
+    FileApiReader reader;
+    auto analysis = reader.read(tmp.path(), std::string("Release"));
+    ASSERT_TRUE(analysis.has_value()) << analysis.error().message();
+    ASSERT_EQ(analysis.value().targets.size(), 2);
+    EXPECT_EQ(analysis.value().targets[1].link_flags,
+              (std::vector<std::string>{"/usr/lib/libz.so"}));
+}
+
+TEST(FileApiReaderTest, ReportsMissingAndMalformedReplies) {
+    test::TempDirectory tmp("file_api_test");
+    FileApiReader reader;
+
+    auto missing = reader.read(tmp.path());
+    ASSERT_FALSE(missing.has_value());
+    EXPECT_NE(missing.error().message().find("no reply index"), std::string::npos);
+
+    write_project(tmp, "{ not json");
+    auto malformed = reader.read(tmp.path(), std::string("Release"));
+    ASSERT_FALSE(malformed.has_value());
+    EXPECT_NE(malformed.error().message().find("app.json"), std::string::npos);
+
+    auto unknown = reader.read(tmp.path(), std::string("MinSizeRel"));
+    ASSERT_FALSE(unknown.has_value());
+    EXPECT_NE(unknown.error().message().find("MinSizeRel"), std::string::npos);
+}
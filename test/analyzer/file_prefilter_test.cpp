@@ -0,0 +1,75 @@
+#include "support/temp_directory.hpp"
+#include <finch/analyzer/file_prefilter.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+TEST(FilePrefilterTest, ClassifiesByTheCommandsAFileCalls) {
+    EXPECT_EQ(FilePrefilter::classify(""), FileClass::Skip);
+    EXPECT_EQ(FilePrefilter::classify(R"(
+        message(STATUS "Packaging")
+        install(TARGETS core DESTINATION lib)
+        if(WIN32)
+            cpack_add_component(runtime)
+        endif()
+    )"),
+              FileClass::Skip);
+    EXPECT_EQ(FilePrefilter::classify(R"(
+        set(CMAKE_SYSTEM_NAME Linux)
+        SET (CMAKE_C_COMPILER gcc)
+        mark_as_advanced(CMAKE_C_COMPILER)
+    )"),
+              FileClass::Shallow);
+    EXPECT_EQ(FilePrefilter::classify("check_include_file(unistd.h HAVE_UNISTD_H)"),
+              FileClass::Shallow);
+    EXPECT_EQ(FilePrefilter::classify("set(X 1)\nADD_LIBRARY\t(core core.cpp)"), FileClass::Full);
+    EXPECT_EQ(FilePrefilter::classify("target_compile_options(core PRIVATE -Wall)"),
+              FileClass::Full);
+    EXPECT_EQ(FilePrefilter::classify("find_package(ZLIB REQUIRED)"), FileClass::Full);
+}
+
+TEST(FilePrefilterTest, IgnoresCommentsButNotArguments) {
+    // Find-modules document their usage in comments
+    EXPECT_EQ(FilePrefilter::classify(R"(
+#[=======================================================================[.rst:
+FindFoo
+-------
+
+  target_link_libraries(app PRIVATE Foo::Foo)
+#]=======================================================================]
+# add_library(not_a_target) set(
+message("# not a comment") # set(
+    )"),
+              FileClass::Skip);
+
+    // A quoted '#' does not start a comment, and escapes do not end strings
+    EXPECT_EQ(FilePrefilter::classify(R"(message("#" \" "\"") add_library(core x.cpp))"),
+              FileClass::Full);
+    // Anything inside arguments counts, which can only make a file Full
+    EXPECT_EQ(FilePrefilter::classify(R"x(message("add_library(core)"))x"), FileClass::Full);
+    EXPECT_EQ(FilePrefilter::classify("message([[ \" ]])\nproject(demo)"), FileClass::Full);
+    // An escape as the last byte must not step past the end
+    EXPECT_EQ(FilePrefilter::classify("message(hi)\\"), FileClass::Skip);
+}
+
+TEST(FilePrefilterTest, CountsClassifiedFiles) {
+    test::TempDirectory root("file_prefilter_test");
+    root.write("CMakeLists.txt", "project(demo)\nadd_subdirectory(src)\n");
+    root.write("toolchain.cmake", "set(CMAKE_SYSTEM_NAME Linux)\n");
+    root.write("packaging.cmake", "include(CPack)\n");
+    root.write("notes.cmake", "# nothing to see\nmessage(hi)\n");
+
+    FilePrefilter prefilter;
+    EXPECT_EQ(prefilter.classify_file(root / "CMakeLists.txt"), FileClass::Full);
+    EXPECT_EQ(prefilter.classify_file(root / "toolchain.cmake"), FileClass::Shallow);
+    EXPECT_EQ(prefilter.classify_file(root / "packaging.cmake"), FileClass::Shallow);
+    EXPECT_EQ(prefilter.classify_file(root / "notes.cmake"), FileClass::Skip);
+    EXPECT_EQ(prefilter.classify_file(root / "missing.cmake"), FileClass::Full);
+
+    const auto& stats = prefilter.stats();
+    EXPECT_EQ(stats.skipped, 1);
+    EXPECT_EQ(stats.shallow, 2);
+    EXPECT_EQ(stats.full, 2);
+    EXPECT_EQ(stats.bytes_scanned, 36 + 29 + 15 + 29);
+}
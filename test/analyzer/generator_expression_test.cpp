@@ -0,0 +1,144 @@
+#include <finch/analyzer/generator_expression.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace {
+
+using Kind = GenexNode::Kind;
+using Strings = std::vector<std::string>;
+
+std::optional<std::string> evaluate(std::string_view text, const GenexContext& context) {
+    return evaluate_generator_expression(parse_generator_expression(text), context);
+}
+
+GenexContext on(std::string platform_id) {
+    GenexContext context;
+    context.platform_id = std::move(platform_id);
+    return context;
+}
+
+} // namespace
+
+TEST(GeneratorExpressionTest, ParsesNestedExpressions) {
+    auto node = parse_generator_expression("src/$<$<AND:$<PLATFORM_ID:Linux,Darwin>,1>:posix>.cpp");
+    ASSERT_EQ(node.kind, Kind::Concat);
+    ASSERT_EQ(node.children.size(), 3);
+    EXPECT_EQ(node.children[0].text, "src/");
+    EXPECT_EQ(node.children[2].text, ".cpp");
+
+    const auto& conditional = node.children[1];
+    ASSERT_EQ(conditional.kind, Kind::Conditional);
+    const auto& condition = conditional.children[0];
+    ASSERT_EQ(condition.kind, Kind::And);
+    ASSERT_EQ(condition.children.size(), 2);
+    EXPECT_EQ(condition.children[0].kind, Kind::PlatformId);
+    EXPECT_EQ(condition.children[0].children.size(), 2);
+    EXPECT_EQ(conditional.children[1].text, "posix");
+
+    EXPECT_EQ(parse_generator_expression("$<TARGET_FILE:app>").kind, Kind::Unsupported);
+    EXPECT_EQ(parse_generator_expression("plain.cpp").kind, Kind::Text);
+}
+
+TEST(GeneratorExpressionTest, DecidesWhatTheContextKnows) {
+    EXPECT_EQ(evaluate("$<$<PLATFORM_ID:Linux>:a.cpp>", on("Linux")), "a.cpp");
+    EXPECT_EQ(evaluate("$<$<PLATFORM_ID:Linux>:a.cpp>", on("Windows")), "");
+    EXPECT_EQ(evaluate("$<PLATFORM_ID>", on("Darwin")), "Darwin");
+    EXPECT_EQ(evaluate("$<$<NOT:$<BOOL:OFF>>:on>", {}), "on");
+    EXPECT_EQ(evaluate("$<BUILD_INTERFACE:include>$<INSTALL_INTERFACE:share>", {}), "include");
+    EXPECT_EQ(evaluate("a$<COMMA>b$<SEMICOLON>c", {}), "a,b;c");
+
+    // Undecidable without a platform or configuration
+    EXPECT_EQ(evaluate("$<$<PLATFORM_ID:Linux>:a.cpp>", {}), std::nullopt);
+    EXPECT_EQ(evaluate("$<$<CONFIG:Debug>:-g>", on("Linux")), std::nullopt);
+    EXPECT_EQ(evaluate("$<TARGET_FILE:app>", on("Linux")), std::nullopt);
+
+    GenexContext debug;
+    debug.config = "DEBUG";
+    EXPECT_EQ(evaluate("$<$<CONFIG:Debug,RelWithDebInfo>:-g>", debug), "-g");
+}
+
+TEST(GeneratorExpressionTest, OneDecisiveArgumentDecidesAndOr) {
+    auto on_linux = on("Linux");
+    EXPECT_EQ(evaluate("$<AND:$<PLATFORM_ID:Windows>,$<CONFIG:Debug>>", on_linux), "0");
+    EXPECT_EQ(evaluate("$<OR:$<CONFIG:Debug>,$<PLATFORM_ID:Linux>>", on_linux), "1");
+    EXPECT_EQ(evaluate("$<AND:$<PLATFORM_ID:Linux>,$<CONFIG:Debug>>", on_linux), std::nullopt);
+}
+
+TEST(GeneratorExpressionTest, TargetPropertiesComeFromTheResolver) {
+    GenexContext context;
+    context.target_property = [](std::string_view target,
+                                 std::string_view property) -> std::optional<std::string> {
+        if (target.empty() && property == "POSITION_INDEPENDENT_CODE") {
+            return "ON";
+        }
+        return std::nullopt;
+    };
+    EXPECT_EQ(evaluate("$<$<BOOL:$<TARGET_PROPERTY:POSITION_INDEPENDENT_CODE>>:-fPIC>", context),
+              "-fPIC");
+    EXPECT_EQ(evaluate("$<TARGET_PROPERTY:other,TYPE>", context), std::nullopt);
+}
+
+TEST(GeneratorExpressionTest, CacheParsesEachStringOnce) {
+    GenexCache cache;
+    auto first = cache.parse("$<$<PLATFORM_ID:Linux>:a.cpp>");
+    auto second = cache.parse("$<$<PLATFORM_ID:Linux>:a.cpp>");
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(cache.size(), 1);
+}
+
+TEST(GeneratorExpressionTest, LoweringFoldsAgreementAndSplitsTheRest) {
+    Target target;
+    target.name = "lib";
+    target.sources = {"a.cpp", "$<$<PLATFORM_ID:Windows>:win.cpp;win_extra.cpp>",
+                      "$<BUILD_INTERFACE:b.cpp>"};
+    target.compile_definitions = {"$<$<CONFIG:Debug>:DEBUG>", "PLAIN"};
+    target.platform_variants["linux"].compile_options = {"$<$<PLATFORM_ID:Linux>:-pthread>"};
+    ASSERT_TRUE(has_generator_expressions(target));
+
+    auto lowered = lower_generator_expressions(target, PlatformSet::known());
+    EXPECT_FALSE(has_generator_expressions(lowered));
+    EXPECT_EQ(lowered.sources, (PathList{"a.cpp", "b.cpp"}));
+    EXPECT_EQ(lowered.compile_definitions, Strings{"PLAIN"});
+    ASSERT_TRUE(lowered.platform_variants.contains("windows"));
+    EXPECT_EQ(lowered.platform_variants["windows"].sources,
+              (PathList{"win.cpp", "win_extra.cpp"}));
+    EXPECT_EQ(lowered.platform_variants["linux"].compile_options, Strings{"-pthread"});
+    EXPECT_FALSE(lowered.platform_variants.contains("macos"));
+}
+
+TEST(GeneratorExpressionTest, LoweringSeesSourcesAsWritten) {
+    Target target;
+    target.name = "lib";
+    target.sources = {"$<$<BOOL:ON>:sub/../x.cpp>", "$<$<PLATFORM_ID:Linux>:src/./l.cpp>"};
+
+    // Only the expanded paths are normalized
+    auto lowered = lower_generator_expressions(target, PlatformSet::known());
+    EXPECT_EQ(lowered.sources, PathList{"x.cpp"});
+    EXPECT_EQ(lowered.platform_variants["linux"].sources, PathList{"src/l.cpp"});
+}
+
+TEST(GeneratorExpressionTest, LoweringKeepsToTheTargetsPlatforms) {
+    Target target;
+    target.name = "posix_only";
+    target.platforms = {"linux", "macos"};
+    target.sources = {"$<$<PLATFORM_ID:Windows>:win.cpp>", "$<$<PLATFORM_ID:Linux>:linux.cpp>"};
+
+    auto lowered = lower_generator_expressions(target, PlatformSet::known());
+    EXPECT_TRUE(lowered.sources.empty());
+    EXPECT_FALSE(lowered.platform_variants.contains("windows"));
+    EXPECT_EQ(lowered.platform_variants["linux"].sources, PathList{"linux.cpp"});
+}
+
+TEST(GeneratorExpressionTest, LinkOnlyDependenciesAreKept) {
+    Target target;
+    target.name = "app";
+    target.link_libraries = {"$<LINK_ONLY:core>", "$<$<CONFIG:Debug>:debug_heap>",
+                             "$<TARGET_OBJECTS:objs>"};
+
+    // What cannot be decided is still dropped, with a warning
+    auto lowered = lower_generator_expressions(target, PlatformSet::known());
+    EXPECT_EQ(lowered.link_libraries, std::vector<std::string>{"core"});
+    EXPECT_TRUE(lowered.platform_variants.empty());
+}
@@ -0,0 +1,173 @@
+#include "support/temp_directory.hpp"
+#include <finch/analyzer/include_scanner.hpp>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace {
+
+std::vector<std::string> paths_of(const std::vector<IncludeScanner::Directive>& directives) {
+    std::vector<std::string> paths;
+    for (const auto& directive : directives) {
+        paths.push_back((directive.angled ? "<" : "\"") + directive.path);
+    }
+    return paths;
+}
+
+} // namespace
+
+TEST(IncludeScannerTest, ExtractsDirectivesOutsideCommentsAndLiterals) {
+    const char* text = R"(#include <vector>
+  #  include "local.h"
+#include_next <next.h>
+#import "objc.h"
+#include CONFIG_HEADER
+// #include "line_comment.h"
+/* #include "block.h"
+#include "still_block.h" */ int x = 1'000;
+const char* s = "#include \"string.h\" /*";
+const char* r = R"x(
+#include "raw.h"
+)x";
+char c = '"';
+#if 0
+#include "disabled.h"
+#endif
+)";
+
+    auto includes = IncludeScanner::extract_includes(text);
+    EXPECT_EQ(paths_of(includes), (std::vector<std::string>{"<vector", "\"local.h", "<next.h",
+                                                            "\"objc.h", "\"disabled.h"}));
+}
+
+TEST(IncludeScannerTest, AssignsHeadersAndReportsMissingDependencies) {
+    test::TempDirectory root("include_scanner_test");
+    root.write("core/include/core/api.h", "#include \"detail.h\"\n#include <vector>\n");
+    root.write("core/include/core/detail.h", "#pragma once\n");
+    root.write("core/src/core.cpp", "#include <core/api.h>\n#include \"private.h\"\n");
+    root.write("core/src/private.h", "");
+    root.write("util/util.h", "");
+    root.write("util/util.cpp", "#include \"util.h\"\n");
+    root.write("app/main.cpp", "#include <core/api.h>\n#include <util.h>\n");
+
+    ProjectAnalysis analysis;
+    Target core;
+    core.name = "core";
+    core.type = Target::Type::StaticLibrary;
+    core.source_directory = root / "core";
+    core.sources = {"src/core.cpp"};
+    core.include_directories = {"include"};
+    analysis.targets.push_back(core);
+    Target util;
+    util.name = "util";
+    util.type = Target::Type::StaticLibrary;
+    util.source_directory = root / "util";
+    util.sources = {"util.cpp"};
+    util.include_directories = {(root / "util").string()};
+    analysis.targets.push_back(util);
+    Target app;
+    app.name = "app";
+    app.type = Target::Type::ExecutableTarget;
+    app.source_directory = root / "app";
+    app.sources = {"main.cpp"};
+    app.link_libraries = {"core"};
+    analysis.targets.push_back(app);
+
+    IncludeScanner scanner(2);
+    auto stats = scanner.scan(analysis);
+
+    EXPECT_EQ(analysis.targets[0].headers,
+              (PathList{"include/core/api.h", "include/core/detail.h", "src/private.h"}));
+    EXPECT_EQ(analysis.targets[1].headers, (PathList{"util.h"}));
+    EXPECT_TRUE(analysis.targets[2].headers.empty());
+
+    // app reaches util.h only through another target's include path
+    ASSERT_EQ(analysis.warnings.size(), 1);
+    EXPECT_NE(analysis.warnings[0].find("'app' includes headers of 'util'"), std::string::npos);
+    EXPECT_EQ(stats.missing_dependencies, 1);
+    EXPECT_EQ(stats.unresolved_includes, 2); // <vector>, reached from core and app
+    EXPECT_EQ(stats.files_scanned, 7);
+
+    // Unchanged files come from the cache on a second scan
+    ProjectAnalysis again;
+    again.targets = {core, util, app};
+    auto rescan = scanner.scan(again);
+    EXPECT_EQ(rescan.files_scanned, 0);
+    EXPECT_EQ(rescan.cache_hits, 7);
+    EXPECT_EQ(again.targets[0].headers, analysis.targets[0].headers);
+
+    // So do they in a later run that loads the cache this one saved
+    auto cache = root / "cache/include-directives.json";
+    ASSERT_FALSE(scanner.save(cache).has_error());
+    IncludeScanner later(2);
+    ASSERT_FALSE(later.load(cache).has_error());
+    ProjectAnalysis third;
+    third.targets = {core, util, app};
+    auto loaded = later.scan(third);
+    EXPECT_EQ(loaded.files_scanned, 0);
+    EXPECT_EQ(loaded.cache_hits, 7);
+    EXPECT_EQ(third.targets[0].headers, analysis.targets[0].headers);
+}
+
+TEST(IncludeScannerTest, SkipsMalformedCacheEntries) {
+    test::TempDirectory root("include_scanner_test");
+    root.write("lib/a.cpp", "#include \"a.h\"\n");
+    root.write("lib/b.cpp", "");
+    root.write("lib/c.cpp", "");
+    root.write("lib/a.h", "");
+    auto entry = [&](const char* name, const char* fields) {
+        return fmt::format(R"({{"path": "{}", "includes": [], {}}})",
+                           (root / "lib" / name).generic_string(), fields);
+    };
+    auto cache = root.write(
+        "include-directives.json",
+        fmt::format(R"({{"format": 1, "files": [{}, {}, {}]}})",
+                    entry("a.cpp", R"("mtime": "yesterday", "size": 0, "hash": 1)"),
+                    entry("b.cpp", R"("mtime": 0, "size": 0)"),
+                    entry("c.cpp", R"("mtime": 0, "size": -1, "hash": 2)")));
+
+    // The entries are left out rather than failing the load
+    IncludeScanner scanner(2);
+    ASSERT_FALSE(scanner.load(cache).has_error());
+    ProjectAnalysis analysis;
+    Target lib;
+    lib.name = "lib";
+    lib.type = Target::Type::StaticLibrary;
+    lib.source_directory = root / "lib";
+    lib.sources = {"a.cpp", "b.cpp", "c.cpp"};
+    analysis.targets.push_back(lib);
+    auto stats = scanner.scan(analysis);
+    EXPECT_EQ(stats.cache_hits, 0);
+    EXPECT_EQ(analysis.targets[0].headers, PathList{"a.h"});
+}
+
+TEST(IncludeScannerTest, LibrariesOwnHeadersBeforeExecutables) {
+    test::TempDirectory root("include_scanner_owner_test");
+    root.write("lib/lib.h", "");
+    root.write("lib/lib.cpp", "#include \"lib.h\"\n");
+    root.write("lib/tool.cpp", "#include \"lib.h\"\n");
+
+    // The executable comes first and shares the library's directory
+    ProjectAnalysis analysis;
+    Target tool;
+    tool.name = "tool";
+    tool.type = Target::Type::ExecutableTarget;
+    tool.source_directory = root / "lib";
+    tool.sources = {"tool.cpp"};
+    tool.link_libraries = {"lib"};
+    analysis.targets.push_back(tool);
+    Target lib;
+    lib.name = "lib";
+    lib.type = Target::Type::StaticLibrary;
+    lib.source_directory = root / "lib";
+    lib.sources = {"lib.cpp"};
+    analysis.targets.push_back(lib);
+
+    IncludeScanner scanner(2);
+    scanner.scan(analysis);
+    EXPECT_TRUE(analysis.targets[0].headers.empty());
+    EXPECT_EQ(analysis.targets[1].headers, (PathList{"lib.h"}));
+    EXPECT_TRUE(analysis.warnings.empty());
+}
@@ -0,0 +1,133 @@
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/intrinsics.hpp>
+#include <finch/parser/ast/structure.hpp>
+#include <finch/parser/parser.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace {
+
+class IntrinsicsTest : public ::testing::Test {
+  protected:
+    void evaluate(const char* code) {
+        parser::Parser parser(code, "test.cmake");
+        auto ast = parser.parse_file();
+        ASSERT_TRUE(ast.has_value());
+        CMakeEvaluator evaluator(context_);
+        for (const auto& stmt : ast.value()->statements()) {
+            (void)evaluator.evaluate(*stmt);
+        }
+    }
+
+    std::string string_of(const std::string& name) const {
+        auto value = context_.get_variable(name);
+        return value ? value_helpers::to_string(value->value) : "<unset>";
+    }
+
+    EvaluationContext context_;
+};
+
+} // namespace
+
+TEST_F(IntrinsicsTest, GNUInstallDirsSetsRelativeAndFullDirectories) {
+    context_.set_cache_variable("CMAKE_INSTALL_INCLUDEDIR", std::string("include/finch"));
+    evaluate(R"(
+        project(demo)
+        set(CMAKE_INSTALL_PREFIX /usr)
+        include(GNUInstallDirs)
+    )");
+
+    EXPECT_EQ(string_of("CMAKE_INSTALL_BINDIR"), "bin");
+    EXPECT_EQ(string_of("CMAKE_INSTALL_INCLUDEDIR"), "include/finch"); // Cache entry wins
+    EXPECT_EQ(string_of("CMAKE_INSTALL_MANDIR"), "share/man");
+    EXPECT_EQ(string_of("CMAKE_INSTALL_DOCDIR"), "share/doc/demo");
+    EXPECT_EQ(string_of("CMAKE_INSTALL_RUNSTATEDIR"), "var/run");
+    EXPECT_EQ(string_of("CMAKE_INSTALL_FULL_BINDIR"), "/usr/bin");
+    EXPECT_EQ(string_of("CMAKE_INSTALL_FULL_INCLUDEDIR"), "/usr/include/finch");
+    EXPECT_EQ(string_of("CMAKE_INSTALL_FULL_SYSCONFDIR"), "/etc");
+    EXPECT_EQ(string_of("CMAKE_INSTALL_FULL_OLDINCLUDEDIR"), "/usr/include");
+    EXPECT_EQ(context_.get_variable("CMAKE_INSTALL_LIBDIR")->confidence, Confidence::Likely);
+    EXPECT_TRUE(context_.get_cache_variable("CMAKE_INSTALL_DATADIR").has_value());
+}
+
+TEST_F(IntrinsicsTest, ParseArgumentsSplitsKeywords) {
+    evaluate(R"(
+        set(ARG_STALE old)
+        cmake_parse_arguments(ARG "VERBOSE;SHARED" "NAME;VERSION;OUTPUT" "SOURCES"
+                              NAME app SOURCES a.cpp b.cpp VERBOSE OUTPUT stray)
+        set(ARGC 4)
+        set(ARGV0 lib)
+        set(ARGV1 NAME)
+        set(ARGV2 core)
+        set(ARGV3 VERSION)
+        cmake_parse_arguments(PARSE_ARGV 1 FN "" "NAME;VERSION" "")
+    )");
+
+    EXPECT_EQ(string_of("ARG_VERBOSE"), "TRUE");
+    EXPECT_EQ(string_of("ARG_SHARED"), "FALSE");
+    EXPECT_EQ(string_of("ARG_NAME"), "app");
+    EXPECT_EQ(string_of("ARG_VERSION"), "<unset>");
+    EXPECT_EQ(string_of("ARG_OUTPUT"), "stray");
+    EXPECT_EQ(string_of("ARG_SOURCES"), "a.cpp;b.cpp");
+    EXPECT_EQ(string_of("ARG_UNPARSED_ARGUMENTS"), "<unset>");
+    EXPECT_EQ(string_of("ARG_STALE"), "old");
+
+    EXPECT_EQ(string_of("FN_NAME"), "core");
+    EXPECT_EQ(string_of("FN_VERSION"), "<unset>");
+    EXPECT_EQ(string_of("FN_KEYWORDS_MISSING_VALUES"), "VERSION");
+}
+
+TEST_F(IntrinsicsTest, FetchContentPopulatesDeclaredDependencies) {
+    evaluate(R"(
+        include(FetchContent)
+        FetchContent_Declare(googletest
+            GIT_REPOSITORY https://github.com/google/googletest.git
+            GIT_TAG v1.14.0)
+        FetchContent_Declare(GoogleTest URL https://example.com/other.zip)
+        FetchContent_Declare(json SOURCE_DIR /src/json)
+        FetchContent_GetProperties(json)
+        FetchContent_MakeAvailable(googletest json)
+        FetchContent_GetProperties(googletest POPULATED gtest_done)
+    )");
+
+    EXPECT_EQ(string_of("FETCHCONTENT_BASE_DIR"), "/build/_deps");
+    EXPECT_EQ(string_of("googletest_SOURCE_DIR"), "/build/_deps/googletest-src");
+    EXPECT_EQ(string_of("googletest_BINARY_DIR"), "/build/_deps/googletest-build");
+    EXPECT_EQ(string_of("gtest_done"), "TRUE");
+    EXPECT_EQ(string_of("json_SOURCE_DIR"), "/src/json");
+    EXPECT_EQ(string_of("json_POPULATED"), "TRUE");
+
+    // The first declaration of a name is kept
+    auto details = context_.get_cache_variable("_FetchContent_googletest_savedDetails");
+    ASSERT_TRUE(details.has_value());
+    EXPECT_EQ(value_helpers::to_list(details->value).front(), "GIT_REPOSITORY");
+}
+
+TEST_F(IntrinsicsTest, IncludeDispatchesModulesAndCPMBootstrap) {
+    const auto& registry = IntrinsicRegistry::builtin();
+    EXPECT_NE(registry.find_include("GNUInstallDirs"), nullptr);
+    EXPECT_EQ(registry.find_include("cmake/GNUInstallDirs.cmake"), nullptr);
+    EXPECT_NE(registry.find_include("cmake/CPM.cmake"), nullptr);
+    EXPECT_NE(registry.find_include("/build/cmake/CPM_0.38.7.cmake"), nullptr);
+    EXPECT_EQ(registry.find_include("CPM"), nullptr);
+    EXPECT_NE(registry.find_command("FETCHCONTENT_DECLARE"), nullptr);
+
+    // An include path that cannot be evaluated runs nothing
+    evaluate("include(${CPM_DOWNLOAD_LOCATION})");
+    EXPECT_EQ(string_of("CPM_INDENT"), "<unset>");
+
+    context_.initialize_builtin_variables();
+    evaluate(R"(
+        include(${CMAKE_BINARY_DIR}/cmake/CPM_0.38.7.cmake RESULT_VARIABLE cpm_file)
+        include(cmake/Warnings.cmake)
+    )");
+    EXPECT_EQ(string_of("CURRENT_CPM_VERSION"), "0.38.7");
+    EXPECT_EQ(string_of("CPM_FILE"), "/build/cmake/CPM_0.38.7.cmake");
+    EXPECT_EQ(string_of("CPM_DIRECTORY"), "/build/cmake");
+    EXPECT_EQ(string_of("CPM_INDENT"), "CPM:");
+    EXPECT_EQ(string_of("CPM_PACKAGE_LOCK_FILE"), "/build/cpm-package-lock.cmake");
+    EXPECT_TRUE(context_.get_cache_variable("CPM_USE_LOCAL_PACKAGES").has_value());
+    EXPECT_EQ(string_of("cpm_file"), "/build/cmake/CPM_0.38.7.cmake");
+}
@@ -0,0 +1,153 @@
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/list_command.hpp>
+#include <finch/parser/parser.hpp>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace {
+
+class ListCommandTest : public ::testing::Test {
+  protected:
+    void evaluate(const std::string& source) {
+        parser::Parser parser(source, "CMakeLists.txt");
+        auto ast = parser.parse_file();
+        ASSERT_TRUE(ast.has_value());
+        ASSERT_TRUE(evaluator_.evaluate_file(*ast.value()).has_value());
+    }
+
+    std::vector<std::string> list_of(const std::string& name) const {
+        auto value = evaluator_.get_variable(name);
+        return value ? value_helpers::to_list(value->value) : std::vector<std::string>{"<unset>"};
+    }
+
+    std::string string_of(const std::string& name) const {
+        auto value = evaluator_.get_variable(name);
+        return value ? value_helpers::to_string(value->value) : "<unset>";
+    }
+
+    // list() straight on the context, as the evaluator runs it
+    void run(std::vector<std::string> args) {
+        auto result = ListCommand::evaluate(evaluator_.context(), args, Confidence::Certain);
+        ASSERT_TRUE(result.has_value()) << result.error().message();
+    }
+
+    CMakeFileEvaluator evaluator_;
+};
+
+using Strings = std::vector<std::string>;
+
+} // namespace
+
+TEST_F(ListCommandTest, GeneratedSourceListsAreKept) {
+    evaluate(R"(
+        set(SRCS main.cpp util.cpp)
+        set(PLATFORM_SRCS "posix.cpp;win32.cpp")
+        list(APPEND SRCS ${PLATFORM_SRCS} util.cpp gen/b.cpp)
+        list(PREPEND SRCS config.cpp)
+        list(REMOVE_ITEM SRCS win32.cpp)
+        list(REMOVE_DUPLICATES SRCS)
+        list(FILTER SRCS EXCLUDE REGEX "^gen/")
+        list(TRANSFORM SRCS PREPEND src/ OUTPUT_VARIABLE FULL)
+        list(TRANSFORM FULL REPLACE "src/(.*)\\.cpp" "\\1.o" AT 0 -1 OUTPUT_VARIABLE OBJS)
+        list(LENGTH SRCS COUNT)
+        list(GET SRCS 0 -1 ENDS)
+        list(FIND SRCS posix.cpp POSIX_AT)
+        list(JOIN SRCS "," JOINED)
+        list(SUBLIST SRCS 1 2 MIDDLE)
+        add_library(core ${FULL})
+    )");
+
+    EXPECT_EQ(list_of("SRCS"), (Strings{"config.cpp", "main.cpp", "util.cpp", "posix.cpp"}));
+    EXPECT_EQ(list_of("FULL"),
+              (Strings{"src/config.cpp", "src/main.cpp", "src/util.cpp", "src/posix.cpp"}));
+    EXPECT_EQ(list_of("OBJS"),
+              (Strings{"config.o", "src/main.cpp", "src/util.cpp", "posix.o"}));
+    EXPECT_EQ(string_of("COUNT"), "4");
+    EXPECT_EQ(list_of("ENDS"), (Strings{"config.cpp", "posix.cpp"}));
+    EXPECT_EQ(string_of("POSIX_AT"), "3");
+    EXPECT_EQ(string_of("JOINED"), "config.cpp,main.cpp,util.cpp,posix.cpp");
+    EXPECT_EQ(list_of("MIDDLE"), (Strings{"main.cpp", "util.cpp"}));
+
+    const auto& targets = evaluator_.context().get_targets();
+    ASSERT_EQ(targets.size(), 1);
+    EXPECT_EQ(targets[0].sources.size(), 4);
+}
+
+TEST_F(ListCommandTest, OrderingAndPopping) {
+    run({"APPEND", "L", "file10.c", "File2.c", "b/file1.c", "a/file3.c"});
+    run({"SORT", "L"});
+    EXPECT_EQ(list_of("L"), (Strings{"File2.c", "a/file3.c", "b/file1.c", "file10.c"}));
+    run({"SORT", "L", "COMPARE", "FILE_BASENAME", "CASE", "INSENSITIVE"});
+    EXPECT_EQ(list_of("L"), (Strings{"b/file1.c", "file10.c", "File2.c", "a/file3.c"}));
+    run({"SORT", "L", "COMPARE", "NATURAL", "CASE", "INSENSITIVE", "ORDER", "DESCENDING"});
+    EXPECT_EQ(list_of("L"), (Strings{"file10.c", "File2.c", "b/file1.c", "a/file3.c"}));
+    run({"REVERSE", "L"});
+    EXPECT_EQ(list_of("L").front(), "a/file3.c");
+
+    run({"INSERT", "L", "4", "last.c"});
+    run({"REMOVE_AT", "L", "0", "-2"});
+    EXPECT_EQ(list_of("L"), (Strings{"b/file1.c", "File2.c", "last.c"}));
+    run({"POP_FRONT", "L", "FIRST"});
+    run({"POP_BACK", "L", "LAST"});
+    EXPECT_EQ(string_of("FIRST"), "b/file1.c");
+    EXPECT_EQ(string_of("LAST"), "last.c");
+    EXPECT_EQ(list_of("L"), (Strings{"File2.c"}));
+    evaluator_.context().set_variable("NONE", std::string("stale"));
+    run({"POP_FRONT", "EMPTY", "NONE"});
+    EXPECT_EQ(string_of("NONE"), "<unset>");
+
+    run({"TRANSFORM", "L", "GENEX_STRIP"});
+    run({"APPEND", "G", "$<$<CONFIG:Debug>:debug.c>", " plain.c "});
+    run({"TRANSFORM", "G", "GENEX_STRIP"});
+    run({"TRANSFORM", "G", "STRIP"});
+    run({"TRANSFORM", "G", "TOUPPER", "REGEX", "plain"});
+    EXPECT_EQ(list_of("G"), (Strings{"", "PLAIN.C"}));
+
+    auto bad = ListCommand::evaluate(evaluator_.context(), {"GET", "L", "5", "OUT"},
+                                     Confidence::Certain);
+    EXPECT_FALSE(bad.has_value());
+    EXPECT_FALSE(
+        ListCommand::evaluate(evaluator_.context(), {"FROB", "L"}, Confidence::Certain).has_value());
+}
+
+TEST_F(ListCommandTest, ParentScopeListsAreCopiedOnceIntoTheChild) {
+    evaluator_.context().set_variable("SRCS", std::string("a.cpp;b.cpp"), Confidence::Likely);
+    auto child = evaluator_.context().create_child_scope();
+    ASSERT_TRUE(ListCommand::evaluate(*child, {"APPEND", "SRCS", "c.cpp"}, Confidence::Certain)
+                    .has_value());
+    EXPECT_EQ(value_helpers::to_list(child->get_variable("SRCS")->value),
+              (Strings{"a.cpp", "b.cpp", "c.cpp"}));
+    EXPECT_EQ(child->get_variable("SRCS")->confidence, Confidence::Likely);
+    EXPECT_EQ(list_of("SRCS"), (Strings{"a.cpp", "b.cpp"}));
+}
+
+TEST_F(ListCommandTest, FiftyThousandElementListsStayLinear) {
+    // Grown one element per call, as generated CMake does; each APPEND works
+    // on the stored vector instead of joining and splitting the whole list
+    constexpr size_t count = 50000;
+    for (size_t i = 0; i < count; ++i) {
+        run({"APPEND", "SRCS", fmt::format("src/file{}.cpp", i % (count / 2))});
+    }
+    EXPECT_EQ(list_of("SRCS").size(), count);
+
+    run({"REMOVE_DUPLICATES", "SRCS"});
+    EXPECT_EQ(list_of("SRCS").size(), count / 2);
+
+    std::vector<std::string> remove = {"REMOVE_ITEM", "SRCS"};
+    for (size_t i = 0; i < count / 2; i += 2) {
+        remove.push_back(fmt::format("src/file{}.cpp", i));
+    }
+    run(remove);
+    EXPECT_EQ(list_of("SRCS").size(), count / 4);
+
+    run({"SORT", "SRCS", "COMPARE", "NATURAL", "ORDER", "DESCENDING"});
+    EXPECT_EQ(list_of("SRCS").front(), fmt::format("src/file{}.cpp", count / 2 - 1));
+    run({"FILTER", "SRCS", "INCLUDE", "REGEX", "[13579]\\.cpp$"});
+    run({"TRANSFORM", "SRCS", "REPLACE", "\\.cpp$", ".o"});
+    run({"LENGTH", "SRCS", "COUNT"});
+    EXPECT_EQ(string_of("COUNT"), std::to_string(count / 4));
+    EXPECT_EQ(list_of("SRCS").back(), "src/file1.o");
+}
@@ -0,0 +1,136 @@
+#include "support/temp_directory.hpp"
+#include <filesystem>
+#include <finch/analyzer/ninja_manifest.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+TEST(NinjaManifestTest, ParsesEdgesAndExpandsVariables) {
+    const char* text = R"(# comment
+cflags = -O2
+cflags = $cflags -g
+rule cc
+  command = gcc $cflags $extra -c $in -o $out
+  description = CC $out
+
+build a$ b.o | a.d: cc a.c | gen.h || order $
+    other
+  extra = -DX=$$1 ${cflags}
+build all: phony a$ b.o
+)";
+
+    auto manifest = NinjaManifest::parse(text, "/build");
+    ASSERT_TRUE(manifest.has_value()) << manifest.error().message();
+
+    const auto& edges = manifest.value().edges();
+    ASSERT_EQ(edges.size(), 2);
+
+    const auto& compile = edges[0];
+    EXPECT_EQ(compile.rule->name, "cc");
+    EXPECT_EQ(compile.outputs, (std::vector<std::string_view>{"a b.o", "a.d"}));
+    EXPECT_EQ(compile.explicit_outputs, 1);
+    EXPECT_EQ(compile.inputs, (std::vector<std::string_view>{"a.c", "gen.h", "order", "other"}));
+    EXPECT_EQ(compile.explicit_inputs, 1);
+    EXPECT_EQ(manifest.value().evaluate(compile, "command"),
+              "gcc -O2 -g -DX=$1 -O2 -g -c a.c -o 'a b.o'");
+
+    // The same path is interned once
+    EXPECT_EQ(edges[1].inputs.front().data(), compile.outputs.front().data());
+}
+
+TEST(NinjaManifestTest, FollowsIncludeAndSubninjaScopes) {
+    test::TempDirectory dir("ninja_manifest_test");
+    dir.write("rules.ninja", "rule touch\n  command = touch $out $flag\n");
+    dir.write("sub.ninja", "flag = sub\nbuild sub.txt: touch\n");
+    dir.write("build.ninja",
+              "flag = top\ninclude rules.ninja\nsubninja sub.ninja\nbuild top.txt: touch\n");
+
+    auto manifest = NinjaManifest::load(dir / "build.ninja");
+    ASSERT_TRUE(manifest.has_value()) << manifest.error().message();
+
+    const auto& edges = manifest.value().edges();
+    ASSERT_EQ(edges.size(), 2);
+    EXPECT_EQ(manifest.value().evaluate(edges[0], "command"), "touch sub.txt sub");
+    EXPECT_EQ(manifest.value().evaluate(edges[1], "command"), "touch top.txt top");
+    EXPECT_EQ(manifest.value().variable("flag"), "top");
+}
+
+TEST(NinjaManifestTest, ContinuationAtTheEndOfTheTextEndsTheLine) {
+    auto manifest = NinjaManifest::parse("rule cc\n  command = cc\nbuild x.o: cc x.c $\r", "/b");
+    ASSERT_TRUE(manifest.has_value()) << manifest.error().message();
+    ASSERT_EQ(manifest.value().edges().size(), 1);
+    EXPECT_EQ(manifest.value().edges()[0].inputs, (std::vector<std::string_view>{"x.c"}));
+}
+
+TEST(NinjaManifestTest, ReportsErrorsWithLineNumbers) {
+    auto manifest = NinjaManifest::parse("rule cc\n  command = cc\nbuild x.o: link x.c\n", "/b");
+    ASSERT_FALSE(manifest.has_value());
+    EXPECT_NE(manifest.error().message().find("build.ninja:3: unknown build rule 'link'"),
+              std::string::npos);
+}
+
+TEST(NinjaManifestAnalyzerTest, RecoversTargetsFromCMakeManifest) {
+    const char* text = R"(
+rule CXX_COMPILER__core_Release
+  depfile = $DEP_FILE
+  deps = gcc
+  command = ${LAUNCHER}${CODE_CHECK}/usr/bin/c++ $DEFINES $INCLUDES $FLAGS -MD -MT $out -MF $DEP_FILE -o $out -c $in
+rule CXX_COMPILER__app_Release
+  command = /usr/bin/c++ $DEFINES $INCLUDES $FLAGS -o $out -c $in
+rule CXX_STATIC_LIBRARY_LINKER__core_Release
+  command = ar qc $TARGET_FILE $in
+rule CXX_EXECUTABLE_LINKER__app_Release
+  command = /usr/bin/c++ $FLAGS $in -o $TARGET_FILE $LINK_LIBRARIES
+
+build CMakeFiles/core.dir/src/a.cpp.o: CXX_COMPILER__core_Release /src/lib/src/a.cpp
+  DEFINES = -DCORE
+  DEP_FILE = CMakeFiles/core.dir/src/a.cpp.o.d
+  FLAGS = -O3 -std=c++20
+  INCLUDES = -I/src/lib/include
+  OBJECT_DIR = CMakeFiles/core.dir
+build CMakeFiles/core.dir/src/b.cpp.o: CXX_COMPILER__core_Release /src/lib/src/b.cpp
+  DEFINES = -DCORE
+  DEP_FILE = CMakeFiles/core.dir/src/b.cpp.o.d
+  FLAGS = -O3 -std=c++20
+  INCLUDES = -I/src/lib/include
+  OBJECT_DIR = CMakeFiles/core.dir
+build libcore.a: CXX_STATIC_LIBRARY_LINKER__core_Release CMakeFiles/core.dir/src/a.cpp.o CMakeFiles/core.dir/src/b.cpp.o
+  OBJECT_DIR = CMakeFiles/core.dir
+  TARGET_FILE = libcore.a
+
+build app/CMakeFiles/app.dir/main.cpp.o: CXX_COMPILER__app_Release /src/app/main.cpp || libcore.a
+  FLAGS = -O3
+  OBJECT_DIR = app/CMakeFiles/app.dir
+build app/app: CXX_EXECUTABLE_LINKER__app_Release app/CMakeFiles/app.dir/main.cpp.o | libcore.a
+  LINK_LIBRARIES = libcore.a  -lpthread  /usr/lib/libz.so  -Wl,--as-needed
+  OBJECT_DIR = app/CMakeFiles/app.dir
+  TARGET_FILE = app/app
+build all: phony libcore.a app/app
+)";
+
+    auto manifest = NinjaManifest::parse(text, "/build");
+    ASSERT_TRUE(manifest.has_value()) << manifest.error().message();
+
+    NinjaManifestAnalyzer analyzer(2);
+    auto analysis = analyzer.analyze(manifest.value());
+    ASSERT_EQ(analysis.targets.size(), 2);
+
+    const auto& core = analysis.targets[0];
+    EXPECT_EQ(core.name, "core");
+    EXPECT_EQ(core.type, Target::Type::StaticLibrary);
+    EXPECT_EQ(core.confidence, Target::Confidence::Certain);
+    EXPECT_EQ(core.source_directory, fs::path("/src/lib/src"));
+    EXPECT_EQ(core.sources, (PathList{"a.cpp", "b.cpp"}));
+    EXPECT_EQ(core.compile_definitions, (std::vector<std::string>{"CORE"}));
+    EXPECT_EQ(core.include_directories, (PathList{"/src/lib/include"}));
+    EXPECT_EQ(core.compile_options, (std::vector<std::string>{"-O3", "-std=c++20"}));
+
+    const auto& app = analysis.targets[1];
+    EXPECT_EQ(app.name, "app");
+    EXPECT_EQ(app.type, Target::Type::ExecutableTarget);
+    EXPECT_EQ(app.link_libraries, (std::vector<std::string>{"core"}));
+    EXPECT_EQ(app.link_flags, (std::vector<std::string>{"-lpthread", "/usr/lib/libz.so"}));
+}
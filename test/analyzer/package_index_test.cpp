@@ -0,0 +1,186 @@
+#include "support/temp_directory.hpp"
+#include <filesystem>
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/package_index.hpp>
+#include <finch/generator/target_mapper.hpp>
+#include <finch/parser/ast/structure.hpp>
+#include <finch/parser/parser.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A prefix laid out as `cmake --install` and a pkg-config install leave it
+class PackageIndexTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        fs::path fmt_dir = "lib/cmake/fmt";
+        prefix_.write(fmt_dir / "fmt-config.cmake",
+                      "include(${CMAKE_CURRENT_LIST_DIR}/fmt-targets.cmake)\n");
+        prefix_.write(fmt_dir / "fmt-config-version.cmake", "set(PACKAGE_VERSION \"10.1.1\")\n");
+        prefix_.write(fmt_dir / "fmt-targets.cmake", R"(
+add_library(fmt::fmt SHARED IMPORTED)
+set_target_properties(fmt::fmt PROPERTIES
+  INTERFACE_COMPILE_DEFINITIONS "FMT_SHARED"
+  INTERFACE_INCLUDE_DIRECTORIES "${_IMPORT_PREFIX}/include"
+  INTERFACE_LINK_LIBRARIES "$<LINK_ONLY:Threads::Threads>;ZLIB::ZLIB"
+)
+add_library(fmt::fmt-header-only INTERFACE IMPORTED)
+)");
+        prefix_.write(fmt_dir / "fmt-targets-release.cmake", R"(
+set_target_properties(fmt::fmt PROPERTIES
+  IMPORTED_LOCATION_RELEASE "${_IMPORT_PREFIX}/lib/libfmt.so.10.1.1"
+  IMPORTED_SONAME_RELEASE "libfmt.so.10"
+  )
+)");
+        prefix_.write("lib/cmake/ZLIB/ZLIBConfig.cmake",
+                      "add_library(ZLIB::ZLIB UNKNOWN IMPORTED)\n");
+        prefix_.write("lib/pkgconfig/glib-2.0.pc", R"(prefix=/opt/glib
+includedir=${prefix}/include
+libdir=${prefix}/lib
+
+Name: GLib
+Version: 2.78.0
+Requires.private: libpcre2-8 >= 10.32
+Requires: libffi >= 3.0, zlib
+Libs: -L${libdir} -lglib-2.0
+Cflags: -I${includedir}/glib-2.0 -I ${libdir}/glib-2.0/include
+)");
+        prefix_.write("share/cmake/notapackage/README", "");
+    }
+
+    test::TempDirectory prefix_{"package_index_test"};
+};
+
+} // namespace
+
+TEST_F(PackageIndexTest, IndexesCMakeConfigsAndPkgConfigModules) {
+    auto index = PackageIndex::build({prefix_.path()}, 2);
+    ASSERT_EQ(index.packages().size(), 3);
+
+    const auto* fmt = index.find_package("fmt");
+    ASSERT_NE(fmt, nullptr);
+    auto prefix = prefix_.path().generic_string();
+    EXPECT_EQ(fmt->version, "10.1.1");
+    EXPECT_EQ(fmt->source, ExternalPackage::Source::CMakeConfig);
+    EXPECT_EQ(fmt->imported_targets,
+              (std::vector<std::string>{"fmt::fmt", "fmt::fmt-header-only"}));
+    EXPECT_EQ(fmt->include_directories, (std::vector<std::string>{prefix + "/include"}));
+    EXPECT_EQ(fmt->libraries, (std::vector<std::string>{prefix + "/lib/libfmt.so.10.1.1"}));
+    EXPECT_EQ(fmt->dependencies, (std::vector<std::string>{"ZLIB::ZLIB"}));
+    EXPECT_EQ(index.find_imported_target("fmt::fmt-header-only"), fmt);
+
+    // CMake config names match case-insensitively; pkg-config modules are a fallback
+    EXPECT_EQ(index.find_package("zlib"), index.find_imported_target("ZLIB::ZLIB"));
+    const auto* glib = index.find_package("glib-2.0");
+    ASSERT_NE(glib, nullptr);
+    EXPECT_EQ(glib, index.find_module("glib-2.0"));
+    EXPECT_EQ(glib->version, "2.78.0");
+    EXPECT_EQ(glib->include_directories, (std::vector<std::string>{"/opt/glib/include/glib-2.0",
+                                                                   "/opt/glib/lib/glib-2.0/include"}));
+    EXPECT_EQ(glib->libraries, (std::vector<std::string>{"-L/opt/glib/lib", "-lglib-2.0"}));
+    EXPECT_EQ(glib->dependencies, (std::vector<std::string>{"libffi", "zlib"}));
+    EXPECT_EQ(index.find_package("missing"), nullptr);
+}
+
+TEST_F(PackageIndexTest, CacheIsReusedUntilAPrefixChanges) {
+    auto cache = prefix_ / "cache/index.json";
+    auto built = PackageIndex::load_or_build(cache, {prefix_.path()}, 2);
+    EXPECT_FALSE(built.from_cache());
+
+    auto cached = PackageIndex::load_or_build(cache, {prefix_.path()}, 2);
+    EXPECT_TRUE(cached.from_cache());
+    ASSERT_EQ(cached.packages().size(), built.packages().size());
+    ASSERT_NE(cached.find_imported_target("fmt::fmt"), nullptr);
+    EXPECT_EQ(cached.find_imported_target("fmt::fmt")->libraries,
+              built.find_imported_target("fmt::fmt")->libraries);
+
+    // So does a package file rewritten in place, which leaves its directory's time alone
+    auto fmt_dir = prefix_ / "lib/cmake/fmt";
+    auto fmt_dir_time = fs::last_write_time(fmt_dir);
+    prefix_.write("lib/cmake/fmt/fmt-targets-release.cmake", "");
+    fs::last_write_time(fmt_dir, fmt_dir_time);
+    EXPECT_FALSE(PackageIndex::load(cache, {prefix_.path()}).has_value());
+
+    // Other prefixes, or a newly installed package, invalidate the cache
+    EXPECT_FALSE(PackageIndex::load(cache, {prefix_.path(), "/nonexistent"}).has_value());
+    prefix_.write("lib/cmake/spdlog/spdlogConfig.cmake", "");
+    fs::last_write_time(prefix_ / "lib/cmake",
+                        fs::last_write_time(prefix_ / "lib/cmake") + std::chrono::seconds(1));
+    auto rebuilt = PackageIndex::load_or_build(cache, {prefix_.path()}, 2);
+    EXPECT_FALSE(rebuilt.from_cache());
+    EXPECT_NE(rebuilt.find_package("spdlog"), nullptr);
+}
+
+TEST_F(PackageIndexTest, FindPackageResolvesAgainstTheIndex) {
+    auto index = PackageIndex::build({prefix_.path()}, 1);
+
+    const char* code = R"(
+        find_package(fmt 10 REQUIRED)
+        find_package(fmt 11 QUIET)
+        find_package(Boost)
+        pkg_check_modules(GLIB REQUIRED IMPORTED_TARGET glib-2.0>=2.70)
+    )";
+
+    parser::Parser parser(code, "test.cmake");
+    auto ast = parser.parse_file();
+    ASSERT_TRUE(ast.has_value());
+
+    EvaluationContext context;
+    context.set_package_index(&index);
+    CMakeEvaluator evaluator(context);
+    for (const auto& stmt : ast.value()->statements()) {
+        (void)evaluator.evaluate(*stmt);
+    }
+
+    auto fmt_found = context.get_variable("fmt_FOUND");
+    ASSERT_TRUE(fmt_found.has_value());
+    // fmt 10.1.1 does not satisfy the second call
+    EXPECT_EQ(std::get<std::string>(fmt_found->value), "FALSE");
+    EXPECT_EQ(std::get<std::string>(context.get_variable("fmt_VERSION")->value), "10.1.1");
+
+    auto boost_found = context.get_variable("Boost_FOUND");
+    ASSERT_TRUE(boost_found.has_value());
+    EXPECT_EQ(std::get<std::string>(boost_found->value), "FALSE");
+    EXPECT_EQ(boost_found->confidence, Confidence::Likely);
+
+    EXPECT_EQ(std::get<std::string>(context.get_variable("GLIB_FOUND")->value), "TRUE");
+    EXPECT_EQ(std::get<std::vector<std::string>>(context.get_variable("GLIB_LIBRARIES")->value),
+              (std::vector<std::string>{"glib-2.0"}));
+
+    const auto& packages = context.get_external_packages();
+    ASSERT_EQ(packages.size(), 2);
+    EXPECT_EQ(packages[0].name, "fmt");
+    EXPECT_EQ(packages[1].imported_targets, (std::vector<std::string>{"PkgConfig::GLIB"}));
+}
+
+TEST_F(PackageIndexTest, ImportedTargetsMapToPrebuiltLibraries) {
+    auto index = PackageIndex::build({prefix_.path()}, 1);
+    std::vector<ExternalPackage> packages = {*index.find_package("fmt"),
+                                             *index.find_package("ZLIB")};
+
+    generator::TargetMapper mapper;
+    mapper.set_external_packages(packages);
+
+    Target app;
+    app.name = "app";
+    app.type = Target::Type::ExecutableTarget;
+    app.link_libraries = {"fmt::fmt", "Threads::Threads", "core"};
+    auto mapped = mapper.map_cmake_target(app);
+    ASSERT_TRUE(mapped.has_value());
+    EXPECT_EQ(mapped.value().deps,
+              (std::vector<std::string>{"//third_party:fmt", "//Threads__Threads", ":core"}));
+
+    auto prebuilt = mapper.map_external_package(packages[0]);
+    EXPECT_EQ(prebuilt.rule_type, generator::Buck2RuleType::PrebuiltCxxLibrary);
+    EXPECT_EQ(prebuilt.name, "fmt");
+    EXPECT_EQ(prebuilt.deps, (std::vector<std::string>{"//third_party:ZLIB"}));
+    EXPECT_EQ(prebuilt.properties["exported_preprocessor_flags"],
+              "[\"-isystem" + prefix_.path().generic_string() + "/include\"]");
+    EXPECT_EQ(prebuilt.properties["exported_linker_flags"],
+              "[\"" + prefix_.path().generic_string() + "/lib/libfmt.so.10.1.1\"]");
+}
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/platforms.hpp>
+#include <finch/parser/parser.hpp>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace {
+
+using Strings = std::vector<std::string>;
+
+// Evaluates CMake code for a set of platforms
+class PlatformsTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        auto all = PlatformSet::from_names({"linux", "macos", "windows"});
+        ASSERT_TRUE(all.has_value());
+        platforms_ = all.value();
+    }
+
+    ProjectAnalysis analyze(const std::string& code, const PlatformSet* platforms,
+                            CMakeFileEvaluator& evaluator) {
+        parser::Parser parser(code, "CMakeLists.txt");
+        auto file = parser.parse_file();
+        EXPECT_TRUE(file.has_value());
+        evaluator.set_platforms(platforms);
+        auto analysis = evaluator.analyze(*file.value());
+        EXPECT_TRUE(analysis.has_value());
+        return analysis.value();
+    }
+
+    PlatformSet platforms_;
+};
+
+const Target* find_target(const ProjectAnalysis& analysis, const std::string& name) {
+    auto it = std::find_if(analysis.targets.begin(), analysis.targets.end(),
+                           [&](const Target& target) { return target.name == name; });
+    return it == analysis.targets.end() ? nullptr : &*it;
+}
+
+// A target's sources, definitions and libraries as one platform sees them
+Strings contents_for(const Target& target, const std::string& platform) {
+    Strings contents;
+    // Targets and their variants name their lists alike
+    auto add = [&](const auto& lists) {
+        for (auto source : lists.sources) {
+            contents.push_back(source.str());
+        }
+        contents.insert(contents.end(), lists.compile_definitions.begin(),
+                        lists.compile_definitions.end());
+        contents.insert(contents.end(), lists.link_libraries.begin(), lists.link_libraries.end());
+    };
+    add(target);
+    if (auto it = target.platform_variants.find(platform); it != target.platform_variants.end()) {
+        add(it->second);
+    }
+    std::sort(contents.begin(), contents.end());
+    return contents;
+}
+
+} // namespace
+
+TEST(PlatformSetTest, ResolvesNames) {
+    auto set = PlatformSet::from_names({"linux", "windows", "linux"});
+    ASSERT_TRUE(set.has_value());
+    ASSERT_EQ(set.value().size(), 2);
+    EXPECT_EQ(set.value()[1].constraint, "config//os:windows");
+    EXPECT_EQ(set.value().all(), 0b11);
+
+    auto unknown = PlatformSet::from_names({"linux", "beos"});
+    ASSERT_FALSE(unknown.has_value());
+    EXPECT_NE(unknown.error().message().find("known: linux, macos, windows"), std::string::npos);
+
+    auto host = PlatformSet::from_names({});
+    ASSERT_TRUE(host.has_value());
+    EXPECT_EQ(host.value().size(), 1);
+}
+
+TEST_F(PlatformsTest, BranchesBecomePlatformVariants) {
+    CMakeFileEvaluator evaluator;
+    auto analysis = analyze(R"cmake(
+        project(demo)
+        if(WIN32)
+            set(PLATFORM_SOURCES src/win32.cpp)
+            set(PLATFORM_LIBS ws2_32)
+        elseif(APPLE)
+            set(PLATFORM_SOURCES src/darwin.cpp)
+            set(PLATFORM_LIBS dl)
+        else()
+            set(PLATFORM_SOURCES src/posix.cpp)
+            set(PLATFORM_LIBS pthread dl)
+        endif()
+        set(LIB_KIND STATIC)
+        add_library(net ${LIB_KIND} src/net.cpp ${PLATFORM_SOURCES})
+        target_link_libraries(net PRIVATE ${PLATFORM_LIBS})
+        if(UNIX)
+            target_compile_definitions(net PRIVATE HAVE_POSIX=1)
+        endif()
+        if(APPLE)
+            add_executable(bundle_tool tools/bundle.cpp)
+        endif()
+        set(MODULE_SUFFIX ${CMAKE_SHARED_LIBRARY_SUFFIX})
+    )cmake",
+                            &platforms_, evaluator);
+
+    ASSERT_EQ(analysis.targets.size(), 2);
+    const auto& net = analysis.targets[0];
+    EXPECT_EQ(net.name, "net");
+    EXPECT_EQ(net.sources, PathList{"src/net.cpp"});
+    EXPECT_TRUE(net.compile_definitions.empty());
+    // Windows does not link dl, so it is not common to all
+    EXPECT_TRUE(net.link_libraries.empty());
+    EXPECT_TRUE(net.platforms.empty());
+
+    ASSERT_EQ(net.platform_variants.size(), 3);
+    const auto& on_linux = net.platform_variants.at("linux");
+    const auto& on_macos = net.platform_variants.at("macos");
+    const auto& on_windows = net.platform_variants.at("windows");
+    EXPECT_EQ(on_linux.sources, PathList{"src/posix.cpp"});
+    EXPECT_EQ(on_macos.sources, PathList{"src/darwin.cpp"});
+    EXPECT_EQ(on_windows.sources, PathList{"src/win32.cpp"});
+    EXPECT_EQ(on_linux.link_libraries, (Strings{"pthread", "dl"}));
+    EXPECT_EQ(on_macos.link_libraries, Strings{"dl"});
+    EXPECT_EQ(on_windows.link_libraries, Strings{"ws2_32"});
+    EXPECT_EQ(on_linux.compile_definitions, Strings{"HAVE_POSIX=1"});
+    EXPECT_EQ(on_macos.compile_definitions, Strings{"HAVE_POSIX=1"});
+    EXPECT_TRUE(on_windows.compile_definitions.empty());
+
+    const auto& tool = analysis.targets[1];
+    EXPECT_EQ(tool.name, "bundle_tool");
+    EXPECT_EQ(tool.platforms, Strings{"macos"});
+    EXPECT_TRUE(tool.platform_variants.empty());
+
+    // Values converge after the branch where the platforms agree
+    const auto& context = evaluator.context();
+    EXPECT_FALSE(context.depends_on_platform("LIB_KIND"));
+    EXPECT_TRUE(context.depends_on_platform("PLATFORM_SOURCES"));
+    EXPECT_TRUE(context.depends_on_platform("MODULE_SUFFIX"));
+    EXPECT_TRUE(context.depends_on_platform("WIN32"));
+    EXPECT_EQ(analysis.project_name, "demo");
+}
+
+TEST_F(PlatformsTest, HostAloneEvaluatesPlainly) {
+    CMakeFileEvaluator evaluator;
+    auto analysis = analyze(R"cmake(
+        if(WIN32)
+            add_library(net src/win32.cpp)
+        else()
+            add_library(net src/posix.cpp)
+        endif()
+    )cmake",
+                            nullptr, evaluator);
+
+    ASSERT_EQ(analysis.targets.size(), 1);
+    EXPECT_EQ(analysis.targets[0].sources,
+              PathList{PlatformSet::host()[0].name == "windows" ? "src/win32.cpp" : "src/posix.cpp"});
+    EXPECT_TRUE(analysis.targets[0].platform_variants.empty());
+    EXPECT_TRUE(analysis.targets[0].platforms.empty());
+    EXPECT_FALSE(evaluator.context().depends_on_platform("WIN32"));
+    auto system = evaluator.get_variable("CMAKE_SYSTEM_NAME");
+    ASSERT_TRUE(system.has_value());
+    EXPECT_EQ(value_helpers::to_string(system->value),
+              PlatformSet::host()[0].variables[6].second);
+}
+
+TEST_F(PlatformsTest, OnePassMatchesSeparatePasses) {
+    // Every fourth module has a platform-specific source, every fifth a
+    // platform-specific library, and every tenth exists on Windows only
+    std::string code = "project(big)\n";
+    for (int i = 0; i < 200; ++i) {
+        code += fmt::format("set(M{0}_SOURCES src/m{0}/a.cpp src/m{0}/b.cpp)\n", i);
+        if (i % 4 == 0) {
+            code += fmt::format("if(WIN32)\n  list(APPEND M{0}_SOURCES src/m{0}/win.cpp)\n"
+                                "elseif(APPLE)\n  list(APPEND M{0}_SOURCES src/m{0}/mac.mm)\n"
+                                "else()\n  list(APPEND M{0}_SOURCES src/m{0}/linux.cpp)\n"
+                                "endif()\n",
+                                i);
+        }
+        code += fmt::format("add_library(m{0} ${{M{0}_SOURCES}})\n", i);
+        code += fmt::format("target_compile_definitions(m{0} PRIVATE M{0}=1)\n", i);
+        if (i > 0) {
+            code += fmt::format("target_link_libraries(m{} PUBLIC m{})\n", i, i - 1);
+        }
+        if (i % 5 == 0) {
+            code += fmt::format("if(UNIX)\n  target_link_libraries(m{} PRIVATE dl)\nendif()\n", i);
+        }
+        if (i % 10 == 0) {
+            code += fmt::format("if(CMAKE_SYSTEM_NAME STREQUAL \"Windows\")\n"
+                                "  add_executable(tool{0} tools/tool{0}.cpp)\nendif()\n",
+                                i);
+        }
+    }
+
+    CMakeFileEvaluator together;
+    auto merged = analyze(code, &platforms_, together);
+
+    for (size_t p = 0; p < platforms_.size(); ++p) {
+        const auto& name = platforms_[p].name;
+        auto single = PlatformSet::from_names({name});
+        ASSERT_TRUE(single.has_value());
+        CMakeFileEvaluator alone;
+        auto expected = analyze(code, &single.value(), alone);
+
+        size_t defined = 0;
+        for (const auto& target : merged.targets) {
+            if (!target.platforms.empty() &&
+                std::find(target.platforms.begin(), target.platforms.end(), name) ==
+                    target.platforms.end()) {
+                EXPECT_EQ(find_target(expected, target.name), nullptr) << target.name;
+                continue;
+            }
+            ++defined;
+            const auto* reference = find_target(expected, target.name);
+            ASSERT_NE(reference, nullptr) << target.name << " on " << name;
+            EXPECT_EQ(contents_for(target, name), contents_for(*reference, name))
+                << target.name << " on " << name;
+        }
+        EXPECT_EQ(defined, expected.targets.size()) << name;
+    }
+    EXPECT_EQ(merged.targets.size(), 200 + 20);
+}
+
+TEST_F(PlatformsTest, MergeSplitsHeadersAndKeepsTheFirstProperty) {
+    Target on_linux;
+    on_linux.name = "net";
+    on_linux.sources = {"net.cpp", "epoll.cpp"};
+    on_linux.headers = {"net.h", "epoll.h"};
+    on_linux.properties = {{"CXX_STANDARD", "20"}, {"OUTPUT_NAME", "net"}};
+    Target on_macos = on_linux;
+    on_macos.sources = {"net.cpp", "kqueue.cpp"};
+    on_macos.headers = {"net.h", "kqueue.h"};
+    on_macos.properties["OUTPUT_NAME"] = "netmac";
+
+    auto merged = merge_platform_targets({&on_linux, &on_macos, nullptr}, 0b011, platforms_);
+    EXPECT_EQ(merged.sources, PathList{"net.cpp"});
+    EXPECT_EQ(merged.headers, PathList{"net.h"});
+    EXPECT_EQ(merged.platform_variants.at("linux").headers, PathList{"epoll.h"});
+    EXPECT_EQ(merged.platform_variants.at("macos").headers, PathList{"kqueue.h"});
+    EXPECT_EQ(merged.properties.at("CXX_STANDARD"), "20");
+    EXPECT_EQ(merged.properties.at("OUTPUT_NAME"), "net");
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/program_slice.hpp>
+#include <finch/parser/ast/structure.hpp>
+#include <finch/parser/parser.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace {
+
+std::vector<std::string> target_names(const ProjectAnalysis& analysis) {
+    std::vector<std::string> names;
+    for (const auto& target : analysis.targets) {
+        names.push_back(target.name);
+    }
+    return names;
+}
+
+class ProgramSliceTest : public ::testing::Test {
+  protected:
+    /// The AST refers to strings owned by its parser, so both are kept
+    const ast::File* parse(const char* code) {
+        auto& parser = parsers_.emplace_back(std::make_unique<parser::Parser>(code, "CMakeLists.txt"));
+        auto ast = parser->parse_file();
+        EXPECT_TRUE(ast.has_value());
+        if (!ast.has_value()) {
+            return nullptr;
+        }
+        return files_.emplace_back(std::move(ast.value())).get();
+    }
+
+  private:
+    std::vector<std::unique_ptr<parser::Parser>> parsers_;
+    std::vector<std::unique_ptr<ast::File>> files_;
+};
+
+} // namespace
+
+TEST_F(ProgramSliceTest, SkipsStatementsThatCannotAffectTargets) {
+    const auto* file = parse(R"(
+        project(demo)
+        set(CORE_SOURCES core.cpp util.cpp)
+        set(DOCS_DIR docs)
+        option(WITH_TOOLS "Build tools" ON)
+        message(STATUS "Configuring ${PROJECT_NAME}")
+        add_library(core ${CORE_SOURCES})
+        if(WITH_TOOLS)
+            set(TOOL_NAME tool)
+            message(STATUS "Tools enabled")
+            add_executable(${TOOL_NAME} tool.cpp)
+        endif()
+        if(WIN32)
+            set(CPACK_GENERATOR ZIP)
+        endif()
+        install(TARGETS core DESTINATION lib)
+        include(CPack)
+        check_include_file(unistd.h HAVE_UNISTD_H)
+    )");
+    ASSERT_NE(file, nullptr);
+    const auto& statements = file->statements();
+    ASSERT_EQ(statements.size(), 11);
+
+    auto slice = ProgramSlice::compute(*file);
+    std::vector<bool> kept;
+    for (const auto& statement : statements) {
+        kept.push_back(slice.contains(*statement));
+    }
+    EXPECT_EQ(kept, (std::vector<bool>{true, true, false, true, false, true, true, false, false,
+                                       false, false}));
+    const auto* tools = dynamic_cast<const ast::IfStatement*>(statements[6].get());
+    ASSERT_NE(tools, nullptr);
+    EXPECT_TRUE(slice.contains(*tools->then_branch()[0]));
+    EXPECT_FALSE(slice.contains(*tools->then_branch()[1]));
+    EXPECT_EQ(slice.statement_count(), 15);
+
+    // The targets come out exactly as without slicing
+    CMakeFileEvaluator full;
+    CMakeFileEvaluator sliced;
+    sliced.set_slicing(true);
+    auto expected = full.analyze(*file);
+    auto actual = sliced.analyze(*file);
+    ASSERT_TRUE(expected.has_value());
+    ASSERT_TRUE(actual.has_value());
+    EXPECT_EQ(target_names(actual.value()), target_names(expected.value()));
+    EXPECT_EQ(actual.value().targets[0].sources, expected.value().targets[0].sources);
+    EXPECT_EQ(actual.value().project_name, "demo");
+    EXPECT_FALSE(sliced.get_variable("DOCS_DIR").has_value());
+}
+
+TEST_F(ProgramSliceTest, TargetConeFollowsLinkedLibraries) {
+    const auto* file = parse(R"(
+        add_library(core core.cpp)
+        add_library(extra extra.cpp)
+        add_library(core_alias ALIAS core)
+        add_executable(app main.cpp)
+        target_link_libraries(app PRIVATE core_alias)
+        add_executable(bench bench.cpp)
+        target_link_libraries(bench PRIVATE extra core)
+    )");
+    ASSERT_NE(file, nullptr);
+
+    TargetGraph graph;
+    graph.add_file(*file);
+    auto cone = graph.cone({"app"});
+    ASSERT_TRUE(cone.has_value());
+    EXPECT_EQ(*cone, (std::unordered_set<std::string>{"app", "core_alias", "core"}));
+
+    auto slice = ProgramSlice::compute(*file, cone);
+    EXPECT_EQ(slice.kept_count(), 4);
+    EXPECT_FALSE(slice.contains(*file->statements()[1]));
+
+    CMakeFileEvaluator evaluator;
+    evaluator.set_slicing(true);
+    evaluator.set_target_cone(cone);
+    auto analysis = evaluator.analyze(*file);
+    ASSERT_TRUE(analysis.has_value());
+    auto names = target_names(analysis.value());
+    EXPECT_NE(std::find(names.begin(), names.end(), "app"), names.end());
+    EXPECT_NE(std::find(names.begin(), names.end(), "core"), names.end());
+    EXPECT_EQ(std::find(names.begin(), names.end(), "extra"), names.end());
+    EXPECT_EQ(std::find(names.begin(), names.end(), "bench"), names.end());
+
+    // A computed target name could be anything, so no cone is known
+    const auto* dynamic = parse("add_library(${PROJECT_NAME}_impl impl.cpp)");
+    ASSERT_NE(dynamic, nullptr);
+    graph.add_file(*dynamic);
+    EXPECT_FALSE(graph.cone({"app"}).has_value());
+}
+
+TEST_F(ProgramSliceTest, RestrictToTargetsKeepsTheLinkClosure) {
+    ProjectAnalysis analysis;
+    for (const char* name : {"core", "extra", "app", "bench"}) {
+        Target target;
+        target.name = name;
+        analysis.targets.push_back(target);
+    }
+    analysis.targets[2].link_libraries = {"core", "Threads::Threads"};
+    analysis.targets[3].link_libraries = {"extra", "app"};
+
+    auto missing = restrict_to_targets(analysis, {"app", "missing"});
+    EXPECT_EQ(missing, (std::vector<std::string>{"missing"}));
+    EXPECT_EQ(target_names(analysis), (std::vector<std::string>{"core", "app"}));
+}
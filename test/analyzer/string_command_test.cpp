@@ -0,0 +1,158 @@
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/analyzer/cmake_regex.hpp>
+#include <finch/analyzer/string_command.hpp>
+#include <finch/parser/parser.hpp>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace {
+
+class StringCommandTest : public ::testing::Test {
+  protected:
+    void evaluate(const std::string& source) {
+        parser::Parser parser(source, "CMakeLists.txt");
+        auto ast = parser.parse_file();
+        ASSERT_TRUE(ast.has_value());
+        ASSERT_TRUE(evaluator_.evaluate_file(*ast.value()).has_value());
+    }
+
+    std::string string_of(const std::string& name) const {
+        auto value = evaluator_.get_variable(name);
+        return value ? value_helpers::to_string(value->value) : "<unset>";
+    }
+
+    // string() straight on the context, as the evaluator runs it
+    Result<void, AnalysisError> run(std::vector<std::string> args) {
+        return StringCommand::evaluate(evaluator_.context(), args, Confidence::Certain);
+    }
+
+    CMakeFileEvaluator evaluator_;
+};
+
+} // namespace
+
+TEST_F(StringCommandTest, PathsAndVersionsAreRewritten) {
+    evaluate(R"cmake(
+        set(FULL_VERSION "v2.14.3-rc1")
+        string(REGEX MATCH "([0-9]+)\\.([0-9]+)\\.([0-9]+)" VERSION ${FULL_VERSION})
+        set(MAJOR ${CMAKE_MATCH_1})
+        string(REGEX REPLACE "^v([0-9.]+).*$" "\\1" PLAIN ${FULL_VERSION})
+        string(REPLACE "/" "\\" WINDOWS_PATH "src/net/socket.cpp")
+        string(REPLACE "net" "io" IO_PATH "src/net/net.cpp")
+        string(TOUPPER "core" UPPER)
+        string(SUBSTRING "libcore.so" 3 4 STEM)
+        string(FIND "src/net/socket.cpp" "/" LAST_SLASH REVERSE)
+        string(LENGTH "socket" LENGTH)
+        string(JOIN "," JOINED a b c)
+        string(CONCAT CONCATENATED pre "-" post)
+        set(FLAGS -Wall)
+        string(APPEND FLAGS " -Wextra")
+        string(PREPEND FLAGS "-O2 ")
+        string(STRIP "  padded  " STRIPPED)
+        string(COMPARE LESS "abc" "abd" LESS)
+        string(MAKE_C_IDENTIFIER "3rd-party.h" IDENTIFIER)
+        string(REGEX REPLACE "\\.cpp$" ".o" OBJECT "src/net/socket.cpp")
+        add_library(${STEM} ${IO_PATH})
+    )cmake");
+
+    EXPECT_EQ(string_of("VERSION"), "2.14.3");
+    EXPECT_EQ(string_of("MAJOR"), "2");
+    EXPECT_EQ(string_of("CMAKE_MATCH_COUNT"), "0");
+    EXPECT_EQ(string_of("PLAIN"), "2.14.3");
+    EXPECT_EQ(string_of("WINDOWS_PATH"), "src\\net\\socket.cpp");
+    EXPECT_EQ(string_of("IO_PATH"), "src/io/io.cpp");
+    EXPECT_EQ(string_of("UPPER"), "CORE");
+    EXPECT_EQ(string_of("STEM"), "core");
+    EXPECT_EQ(string_of("LAST_SLASH"), "7");
+    EXPECT_EQ(string_of("LENGTH"), "6");
+    EXPECT_EQ(string_of("JOINED"), "a,b,c");
+    EXPECT_EQ(string_of("CONCATENATED"), "pre-post");
+    EXPECT_EQ(string_of("FLAGS"), "-O2 -Wall -Wextra");
+    EXPECT_EQ(string_of("STRIPPED"), "padded");
+    EXPECT_EQ(string_of("LESS"), "1");
+    EXPECT_EQ(string_of("IDENTIFIER"), "_3rd_party_h");
+    EXPECT_EQ(string_of("OBJECT"), "src/net/socket.o");
+
+    const auto& targets = evaluator_.context().get_targets();
+    ASSERT_EQ(targets.size(), 1);
+    EXPECT_EQ(targets[0].name, "core");
+    EXPECT_EQ(targets[0].sources, (PathList{"src/io/io.cpp"}));
+}
+
+TEST_F(StringCommandTest, RegexesFollowCMakesDialect) {
+    // Braces are literal, an escaped letter is the letter, brackets have no escapes
+    EXPECT_EQ(CMakeRegex::translate("a{2}"), "a\\{2\\}");
+    EXPECT_EQ(CMakeRegex::translate("\\d\\."), "d\\.");
+    EXPECT_EQ(CMakeRegex::translate("[]\\.]+"), "[\\]\\\\.]+");
+
+    ASSERT_TRUE(run({"REGEX", "MATCH", "x{2}", "BRACES", "ax{2}b"}).has_value());
+    EXPECT_EQ(string_of("BRACES"), "x{2}");
+
+    // ^ anchors at the start of the input only; an empty match moves on by one
+    ASSERT_TRUE(run({"REGEX", "REPLACE", "^a", "b", "ANCHORED", "aaa"}).has_value());
+    EXPECT_EQ(string_of("ANCHORED"), "baa");
+    ASSERT_TRUE(run({"REGEX", "REPLACE", "x*", "-", "EMPTY", "abc"}).has_value());
+    EXPECT_EQ(string_of("EMPTY"), "-a-b-c-");
+
+    ASSERT_TRUE(
+        run({"REGEX", "MATCHALL", "[a-z]+([0-9])", "ALL", "ab1;cd2 ef3"}).has_value());
+    EXPECT_EQ(string_of("ALL"), "ab1;cd2;ef3");
+    EXPECT_EQ(string_of("CMAKE_MATCH_1"), "3");
+    EXPECT_EQ(string_of("CMAKE_MATCH_COUNT"), "1");
+
+    // A later call empties the groups an earlier one stored
+    ASSERT_TRUE(run({"REGEX", "MATCH", "[a-z]+", "WORD", "abc"}).has_value());
+    EXPECT_EQ(string_of("CMAKE_MATCH_1"), "");
+    EXPECT_EQ(string_of("CMAKE_MATCH_COUNT"), "0");
+
+    EXPECT_FALSE(run({"REGEX", "MATCH", "(unclosed", "OUT", "x"}).has_value());
+    EXPECT_FALSE(run({"REGEX", "REPLACE", "a", "\\q", "OUT", "a"}).has_value());
+    EXPECT_FALSE(run({"SUBSTRING", "abc", "4", "1", "OUT"}).has_value());
+    EXPECT_FALSE(run({"TIMESTAMP", "OUT"}).has_value());
+}
+
+TEST_F(StringCommandTest, RegexesAreCompiledOncePerPattern) {
+    auto first = CMakeRegex::compile("^src/(.*)\\.cpp$");
+    ASSERT_TRUE(first.has_value());
+    auto before = CMakeRegex::stats();
+    auto again = CMakeRegex::compile("^src/(.*)\\.cpp$");
+    ASSERT_TRUE(again.has_value());
+    EXPECT_EQ(first.value(), again.value());
+    EXPECT_EQ(CMakeRegex::stats().compiled, before.compiled);
+    EXPECT_EQ(CMakeRegex::stats().hits, before.hits + 1);
+}
+
+TEST_F(StringCommandTest, StringHeavyScriptsCompileEachPatternOnce) {
+    // A generated script rewriting every source path of a large project;
+    // timings are in examples/string_command_benchmark
+    constexpr size_t files = 5000;
+    std::string source;
+    for (size_t i = 0; i < files; ++i) {
+        source += fmt::format("set(SRC \"src/module{}/file{}.cpp\")\n", i % 50, i);
+        source += "string(REPLACE \"src/\" \"${PROJECT_ROOT}/src/\" SRC_PATH ${SRC})\n";
+        source += "string(REGEX REPLACE \"\\\\.cpp$\" \".o\" OBJECT ${SRC})\n";
+        source += "string(REGEX MATCH \"module([0-9]+)\" MODULE ${SRC})\n";
+        source += "string(TOUPPER ${CMAKE_MATCH_1} MODULE_ID)\n";
+        source += "string(APPEND OBJECTS \"${OBJECT};\")\n";
+    }
+    auto compiled_before = CMakeRegex::stats().compiled;
+    evaluate(source);
+
+    EXPECT_EQ(string_of("OBJECT"), fmt::format("src/module{}/file{}.o", (files - 1) % 50,
+                                               files - 1));
+    EXPECT_EQ(string_of("MODULE_ID"), std::to_string((files - 1) % 50));
+    EXPECT_EQ(value_helpers::to_list(evaluator_.get_variable("OBJECTS")->value).size(), files);
+    // Two patterns, however many calls use them
+    EXPECT_LE(CMakeRegex::stats().compiled - compiled_before, 2);
+
+    // Replacing in one long string
+    std::string haystack;
+    for (size_t i = 0; i < 200000; ++i) {
+        haystack += "src/file.cpp;";
+    }
+    ASSERT_TRUE(run({"REPLACE", ".cpp", ".o", "LONG", haystack}).has_value());
+    EXPECT_EQ(string_of("LONG").size(), haystack.size() - 200000 * 2);
+}
@@ -0,0 +1,223 @@
+#include "support/temp_directory.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/parser/parser.hpp>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::analyzer;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+using Strings = std::vector<std::string>;
+
+// Evaluates a project's top CMakeLists.txt and the directories it adds
+class SubdirectoryTest : public ::testing::Test {
+  protected:
+    ProjectAnalysis analyze(const std::string& code) {
+        root_.write("CMakeLists.txt", code);
+        parser::Parser parser(code, (root_ / "CMakeLists.txt").string());
+        auto file = parser.parse_file();
+        EXPECT_TRUE(file.has_value());
+        evaluator_.set_source_directories(root_.path(), root_.path());
+        auto analysis = evaluator_.analyze(*file.value());
+        EXPECT_TRUE(analysis.has_value());
+        return analysis.has_value() ? analysis.value() : ProjectAnalysis{};
+    }
+
+    std::string variable(const std::string& name) const {
+        auto value = evaluator_.get_variable(name);
+        return value ? value_helpers::to_string(value->value) : "<unset>";
+    }
+
+    test::TempDirectory root_{"subdirectory_test"};
+    CMakeFileEvaluator evaluator_;
+};
+
+const Target* find_target(const ProjectAnalysis& analysis, const std::string& name) {
+    auto it = std::find_if(analysis.targets.begin(), analysis.targets.end(),
+                           [&](const Target& target) { return target.name == name; });
+    return it == analysis.targets.end() ? nullptr : &*it;
+}
+
+} // namespace
+
+TEST_F(SubdirectoryTest, ChildrenReadTheParentScope) {
+    root_.write("lib/CMakeLists.txt", R"cmake(
+        add_library(core ${CORE_KIND} core.cpp)
+        if(WITH_TLS)
+            target_compile_definitions(core PRIVATE HAVE_TLS=1)
+        endif()
+        set(CORE_KIND SHARED)
+        set(LIB_DIR ${CMAKE_CURRENT_SOURCE_DIR})
+    )cmake");
+    auto analysis = analyze(R"cmake(
+        project(demo)
+        option(WITH_TLS "TLS support" ON)
+        set(CORE_KIND STATIC)
+        add_subdirectory(lib)
+    )cmake");
+
+    const auto* core = find_target(analysis, "core");
+    ASSERT_NE(core, nullptr);
+    EXPECT_EQ(core->type, Target::Type::StaticLibrary);
+    EXPECT_EQ(core->compile_definitions, Strings{"HAVE_TLS=1"});
+    EXPECT_EQ(core->source_directory.str(), (root_ / "lib").generic_string());
+
+    // What the child sets stays in its scope
+    EXPECT_EQ(variable("CORE_KIND"), "STATIC");
+    EXPECT_EQ(variable("LIB_DIR"), "<unset>");
+    EXPECT_EQ(variable("CMAKE_CURRENT_SOURCE_DIR"), root_.path().generic_string());
+    ASSERT_EQ(analysis.subdirectory_files.size(), 1);
+    EXPECT_EQ(analysis.subdirectory_files[0], root_ / "lib/CMakeLists.txt");
+}
+
+TEST_F(SubdirectoryTest, ParentScopeAndCacheWritesReachLaterSiblings) {
+    root_.write("config/CMakeLists.txt", R"cmake(
+        set(CONFIG_DEFINES USE_CONFIG=1 PARENT_SCOPE)
+        set(CONFIG_LEVEL 3 CACHE STRING "Level")
+    )cmake");
+    root_.write("app/CMakeLists.txt", R"cmake(
+        add_executable(app main.cpp)
+        target_compile_definitions(app PRIVATE ${CONFIG_DEFINES} LEVEL=${CONFIG_LEVEL})
+    )cmake");
+    auto analysis = analyze(R"cmake(
+        add_subdirectory(config)
+        add_subdirectory(app)
+    )cmake");
+
+    const auto* app = find_target(analysis, "app");
+    ASSERT_NE(app, nullptr);
+    EXPECT_EQ(app->compile_definitions, (Strings{"USE_CONFIG=1", "LEVEL=3"}));
+    EXPECT_EQ(app->source_directory.str(), (root_ / "app").generic_string());
+    EXPECT_EQ(variable("CONFIG_DEFINES"), "USE_CONFIG=1");
+    EXPECT_EQ(analysis.cache_variables.at("CONFIG_LEVEL"), "3");
+}
+
+TEST_F(SubdirectoryTest, SiblingsUpdateTargetsOfOtherDirectories) {
+    root_.write("plugins/CMakeLists.txt", R"cmake(
+        add_library(plugin plugin.cpp)
+        target_link_libraries(core PUBLIC plugin)
+    )cmake");
+    root_.write("tools/CMakeLists.txt", R"cmake(
+        add_executable(tool tool.cpp)
+        target_link_libraries(tool PRIVATE core)
+    )cmake");
+    auto analysis = analyze(R"cmake(
+        add_library(core core.cpp)
+        add_subdirectory(plugins)
+        add_subdirectory(tools)
+        target_compile_definitions(core PRIVATE CORE=1)
+    )cmake");
+
+    ASSERT_EQ(analysis.targets.size(), 3);
+    EXPECT_EQ(analysis.targets[0].name, "core");
+    EXPECT_EQ(analysis.targets[0].link_libraries, Strings{"plugin"});
+    EXPECT_EQ(analysis.targets[0].compile_definitions, Strings{"CORE=1"});
+    EXPECT_EQ(analysis.targets[0].source_directory.str(), root_.path().generic_string());
+    EXPECT_EQ(analysis.targets[1].name, "plugin");
+    EXPECT_EQ(analysis.targets[2].name, "tool");
+    EXPECT_EQ(analysis.targets[2].link_libraries, Strings{"core"});
+}
+
+TEST_F(SubdirectoryTest, LaterSiblingsSeeTargetsEarlierOnesCreate) {
+    root_.write("plugins/CMakeLists.txt", R"cmake(
+        add_library(plugin plugin.cpp)
+    )cmake");
+    root_.write("tools/CMakeLists.txt", R"cmake(
+        add_executable(tool tool.cpp)
+        if(TARGET plugin)
+            target_link_libraries(tool PRIVATE plugin)
+        endif()
+        target_compile_definitions(plugin PUBLIC WITH_TOOLS=1)
+        set_target_properties(plugin PROPERTIES OUTPUT_NAME tools_plugin)
+    )cmake");
+    auto analysis = analyze(R"cmake(
+        add_subdirectory(plugins)
+        add_subdirectory(tools)
+    )cmake");
+
+    // Evaluated alongside plugins/, tools/ missed plugin and ran again
+    ASSERT_EQ(analysis.targets.size(), 2);
+    EXPECT_EQ(analysis.targets[0].name, "plugin");
+    EXPECT_EQ(analysis.targets[0].compile_definitions, Strings{"WITH_TOOLS=1"});
+    EXPECT_EQ(analysis.targets[0].properties.at("OUTPUT_NAME"), "tools_plugin");
+    EXPECT_EQ(analysis.targets[0].source_directory.str(), (root_ / "plugins").generic_string());
+    EXPECT_EQ(analysis.targets[1].name, "tool");
+    EXPECT_EQ(analysis.targets[1].link_libraries, Strings{"plugin"});
+}
+
+TEST_F(SubdirectoryTest, ManySiblingsMergeInDeclarationOrder) {
+    // Nested directories, and every seventh sibling passes a value up
+    std::string code;
+    for (int i = 0; i < 64; ++i) {
+        fs::path directory = fmt::format("m{}", i);
+        std::string list = fmt::format("add_library(m{0} m{0}.cpp)\n"
+                                       "target_compile_definitions(m{0} PRIVATE "
+                                       "BEFORE=${{LAST_PUBLISHED}})\n"
+                                       "add_subdirectory(tests)\n",
+                                       i);
+        if (i % 7 == 0) {
+            list += fmt::format("set(LAST_PUBLISHED {} PARENT_SCOPE)\n", i);
+        }
+        root_.write(directory / "CMakeLists.txt", list);
+        root_.write(directory / "tests/CMakeLists.txt",
+                    fmt::format("add_executable(m{0}_test test.cpp)\n"
+                                "target_link_libraries(m{0}_test PRIVATE m{0})\n",
+                                i));
+        code += fmt::format("add_subdirectory(m{} out/m{})\n", i, i);
+    }
+    auto analysis = analyze("set(LAST_PUBLISHED none)\n" + code);
+
+    ASSERT_EQ(analysis.targets.size(), 128);
+    for (size_t i = 0; i < 64; ++i) {
+        const auto& library = analysis.targets[2 * i];
+        const auto& test = analysis.targets[2 * i + 1];
+        EXPECT_EQ(library.name, fmt::format("m{}", i));
+        EXPECT_EQ(test.name, fmt::format("m{}_test", i));
+        EXPECT_EQ(test.link_libraries, Strings{library.name});
+        EXPECT_EQ(test.source_directory.str(),
+                  (root_ / fmt::format("m{}/tests", i)).generic_string());
+        std::string published = i == 0 ? "none" : std::to_string((i - 1) / 7 * 7);
+        EXPECT_EQ(library.compile_definitions, Strings{"BEFORE=" + published}) << library.name;
+    }
+    EXPECT_EQ(variable("LAST_PUBLISHED"), "63");
+    EXPECT_EQ(analysis.subdirectory_files.size(), 128);
+}
+
+TEST_F(SubdirectoryTest, MissingDirectoryIsSkipped) {
+    root_.write("lib/CMakeLists.txt", "add_library(lib lib.cpp)\n");
+    auto analysis = analyze(R"cmake(
+        add_subdirectory(missing)
+        add_subdirectory(lib)
+        add_executable(app main.cpp)
+    )cmake");
+
+    ASSERT_EQ(analysis.targets.size(), 2);
+    EXPECT_EQ(analysis.targets[0].name, "lib");
+    EXPECT_EQ(analysis.targets[1].name, "app");
+    EXPECT_EQ(analysis.subdirectory_files, std::vector<fs::path>{root_ / "lib/CMakeLists.txt"});
+}
+
+TEST_F(SubdirectoryTest, FailedSiblingsAreCounted) {
+    root_.write("broken/CMakeLists.txt", "add_library(broken\n");
+    root_.write("lib/CMakeLists.txt", "add_library(lib lib.cpp)\n");
+    std::string code = "add_subdirectory(missing)\n"
+                       "add_subdirectory(broken)\n"
+                       "add_subdirectory(lib)\n";
+    parser::Parser parser(code, (root_ / "CMakeLists.txt").string());
+    auto file = parser.parse_file();
+    ASSERT_TRUE(file.has_value());
+
+    EvaluationContext context;
+    context.set_variable("CMAKE_CURRENT_SOURCE_DIR", root_.path().generic_string(),
+                         Confidence::Certain);
+    CMakeEvaluator evaluator(context);
+    EXPECT_TRUE(evaluator.evaluate(*file.value()).has_value());
+    EXPECT_EQ(evaluator.failed_statements(), 2);
+    EXPECT_EQ(context.subdirectory_files(), std::vector<fs::path>{root_ / "lib/CMakeLists.txt"});
+}
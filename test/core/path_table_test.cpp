@@ -0,0 +1,110 @@
+#include <filesystem>
+#include <finch/core/path_table.hpp>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+using namespace finch;
+
+namespace fs = std::filesystem;
+
+TEST(PathTableTest, PathsAreNormalizedOnce) {
+    EXPECT_EQ(PathId("a/./b/../c/").str(), "a/c");
+    EXPECT_EQ(PathId("/usr//include/").str(), "/usr/include");
+    EXPECT_EQ(PathId("../../lib/x.h").str(), "../../lib/x.h");
+    EXPECT_EQ(PathId("/../etc").str(), "/etc");
+    EXPECT_EQ(PathId("a/..").str(), "");
+    EXPECT_EQ(PathId("/").str(), "/");
+
+    // Equal spellings are one id, and std::filesystem::path converts the same way
+    EXPECT_EQ(PathId("src/net/socket.cpp"), PathId("src/./net//socket.cpp"));
+    EXPECT_EQ(PathId(fs::path("/src/core")), PathId("/src/core/"));
+    EXPECT_NE(PathId("src/a.cpp"), PathId("/src/a.cpp"));
+    EXPECT_TRUE(PathId().empty());
+}
+
+TEST(PathTableTest, UnexpandedTextIsKeptAsWritten) {
+    for (const auto* text : {"$<$<BOOL:ON>:sub/../x.cpp>", "$<$<CONFIG:Debug>:src/./d.cpp>",
+                             "${SRC_DIR}/../y.cpp", "$<TARGET_FILE:core>"}) {
+        EXPECT_EQ(PathId(text).str(), text);
+        EXPECT_EQ(PathId(text), PathId(std::string(text)));
+    }
+    EXPECT_EQ((PathId("/work") / "$<$<BOOL:ON>:a/../b.cpp>").str(),
+              "/work/$<$<BOOL:ON>:a/../b.cpp>");
+}
+
+TEST(PathTableTest, ComponentsAreLookups) {
+    PathId source("/work/project/src/net/socket.tar.gz");
+    EXPECT_TRUE(source.is_absolute());
+    EXPECT_FALSE(PathId("src").is_absolute());
+    EXPECT_EQ(source.parent(), PathId("/work/project/src/net"));
+    EXPECT_EQ(source.filename(), "socket.tar.gz");
+    EXPECT_EQ(source.stem(), "socket");
+    EXPECT_EQ(source.extension(), ".gz");
+    EXPECT_EQ(PathId("/").parent(), PathId("/"));
+    EXPECT_EQ(PathId("/").filename(), "");
+    EXPECT_EQ(PathId("Makefile").extension(), "");
+
+    EXPECT_TRUE(source.is_within("/work/project"));
+    EXPECT_TRUE(source.is_within(source));
+    EXPECT_FALSE(source.is_within("/work/proj"));
+    EXPECT_FALSE(PathId("work/project/x").is_within("/work/project"));
+}
+
+TEST(PathTableTest, JoinsAndRelativizes) {
+    PathId root("/work/project");
+    EXPECT_EQ(root / "src/../include", PathId("/work/project/include"));
+    EXPECT_EQ(root / "/usr/include", PathId("/usr/include"));
+    EXPECT_EQ(root / PathId(), root);
+    EXPECT_EQ(PathId("src") / "../../x", PathId("../x"));
+
+    // As lexically_relative()
+    EXPECT_EQ(PathId("/work/project/src/a.cpp").relative_to(root).str(), "src/a.cpp");
+    EXPECT_EQ(PathId("/work/project/include").relative_to("/work/project/src").str(),
+              "../include");
+    EXPECT_EQ(PathId("/work/other/x.h").relative_to("/work/project/src/net").str(),
+              "../../../other/x.h");
+    EXPECT_EQ(root.relative_to(root), PathId());
+    EXPECT_EQ(PathId("include").relative_to("src").str(), "../include");
+    EXPECT_EQ(PathId("include").relative_to(root), PathId("include"));
+
+    for (const auto* path : {"/a/b/c", "/a/x/y/z", "/q", "/a"}) {
+        for (const auto* base : {"/a/b", "/a", "/", "/a/x/y/z/w"}) {
+            EXPECT_EQ(PathId(path).relative_to(base).str(),
+                      fs::path(path).lexically_relative(base).generic_string() == "."
+                          ? ""
+                          : fs::path(path).lexically_relative(base).generic_string())
+                << path << " from " << base;
+        }
+    }
+}
+
+TEST(PathTableTest, LargeSourceListsShareTheirDirectories) {
+    // A project of 100k sources over 400 directories
+    constexpr size_t files = 100000;
+    std::vector<std::string> spellings;
+    spellings.reserve(files);
+    for (size_t i = 0; i < files; ++i) {
+        spellings.push_back(fmt::format("/work/monorepo/components/module{}/src/detail/file{}.cpp",
+                                        i % 400, i));
+    }
+    auto before = PathTable::shared().stats();
+
+    PathList sources(spellings.begin(), spellings.end());
+    auto after = PathTable::shared().stats();
+
+    // One node per file plus the shared directories; names are stored once
+    EXPECT_LE(after.paths - before.paths, files + 3 * 400 + 4);
+    size_t string_bytes = 0;
+    for (const auto& spelling : spellings) {
+        string_bytes += sizeof(std::string) + spelling.capacity() + 1;
+    }
+    size_t interned_bytes = sources.size() * sizeof(PathId) + after.table_bytes - before.table_bytes;
+    EXPECT_LT(interned_bytes * 3, string_bytes * 2);
+
+    // Interning a known path again only looks it up
+    PathList again(spellings.begin(), spellings.end());
+    EXPECT_EQ(again, sources);
+    EXPECT_EQ(PathTable::shared().stats().paths, after.paths);
+    EXPECT_EQ(sources[12345].relative_to("/work/monorepo/components/module345").str(),
+              "src/detail/file12345.cpp");
+}
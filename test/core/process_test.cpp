@@ -0,0 +1,20 @@
+#include <finch/core/process.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+
+#ifndef _WIN32
+TEST(ProcessTest, QuotedArgumentsReachTheCommandUnchanged) {
+    std::string argument = R"(it's "quoted" $HOME \ `x`)";
+    auto ran = run_command("printf %s " + quote_argument(argument));
+    ASSERT_TRUE(ran);
+    EXPECT_TRUE(ran->succeeded);
+    EXPECT_EQ(ran->output, argument);
+}
+#endif
+
+TEST(ProcessTest, FailingCommandsAreReported) {
+    auto ran = run_command(quote_argument("finch-no-such-command"));
+    ASSERT_TRUE(ran);
+    EXPECT_FALSE(ran->succeeded);
+}
@@ -0,0 +1,97 @@
+#include <finch/generator/flag_canonicalizer.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch::generator;
+
+namespace {
+
+TargetMapper::MappedTarget make_target(const std::string& name,
+                                       std::vector<std::string> preprocessor_flags,
+                                       std::vector<std::string> compiler_flags) {
+    TargetMapper::MappedTarget target;
+    target.name = name;
+    target.rule_type = Buck2RuleType::CxxLibrary;
+    target.preprocessor_flags = std::move(preprocessor_flags);
+    target.compiler_flags = std::move(compiler_flags);
+    return target;
+}
+
+} // namespace
+
+TEST(FlagCanonicalizerTest, PreprocessorFlagsAreJoinedDedupedAndSorted) {
+    auto flags = FlagCanonicalizer::canonicalize_preprocessor_flags(
+        {"-DZED", "-D", "ALPHA=1", "-Iinclude", "-DZED", "-I", "include", "-DMID=1", "-DMID=2"});
+
+    EXPECT_EQ(flags, (std::vector<std::string>{"-Iinclude", "-DALPHA=1", "-DMID=2", "-DZED"}));
+}
+
+TEST(FlagCanonicalizerTest, UndefineOverridesEarlierDefine) {
+    auto flags = FlagCanonicalizer::canonicalize_preprocessor_flags({"-DFOO", "-UFOO"});
+    EXPECT_EQ(flags, (std::vector<std::string>{"-UFOO"}));
+}
+
+TEST(FlagCanonicalizerTest, CompilerFlagsKeepLastOverrideAndOrder) {
+    auto flags = FlagCanonicalizer::canonicalize_compiler_flags(
+        {"-O2", "-Wall", "-fno-exceptions", "-Wall", "-O3", "-fexceptions", "-fsanitize=address",
+         "-fsanitize=undefined", "-Xclang", "-add-plugin", "-Xclang", "-add-plugin"});
+
+    EXPECT_EQ(flags, (std::vector<std::string>{"-Wall", "-O3", "-fexceptions",
+                                               "-fsanitize=address", "-fsanitize=undefined",
+                                               "-Xclang", "-add-plugin", "-Xclang",
+                                               "-add-plugin"}));
+}
+
+TEST(FlagCanonicalizerTest, RepeatableValuedFlagsAreAllKept) {
+    std::vector<std::string> input = {"-ffile-prefix-map=/a=.",  "-ffile-prefix-map=/b=.",
+                                      "-fdebug-prefix-map=/a=.", "-fdebug-prefix-map=/b=.",
+                                      "-fmacro-prefix-map=/a=.", "-fmacro-prefix-map=/b=.",
+                                      "-fplugin=one.so",         "-fplugin=two.so",
+                                      "-fplugin-arg-one-x=1",    "-fplugin-arg-one-y=2"};
+    EXPECT_EQ(FlagCanonicalizer::canonicalize_compiler_flags(input), input);
+}
+
+TEST(FlagCanonicalizerTest, OnlyKnownValuedFlagsOverride) {
+    auto flags = FlagCanonicalizer::canonicalize_compiler_flags(
+        {"-fvisibility=default", "-march=x86-64", "-fvisibility=hidden", "-march=native", "-g",
+         "-g3", "-std=c++17", "-std=c++20"});
+    EXPECT_EQ(flags, (std::vector<std::string>{"-fvisibility=hidden", "-march=native", "-g3",
+                                               "-std=c++20"}));
+}
+
+TEST(FlagCanonicalizerTest, FrameworksKeepTheirOperands) {
+    auto flags = FlagCanonicalizer::canonicalize_compiler_flags(
+        {"-framework", "Foundation", "-framework", "Cocoa", "-framework", "Foundation"});
+    EXPECT_EQ(flags,
+              (std::vector<std::string>{"-framework", "Foundation", "-framework", "Cocoa"}));
+}
+
+TEST(FlagCanonicalizerTest, EquivalentTargetsShareOneFlagSet) {
+    auto a = make_target("a", {"-DB", "-DA"}, {"-Wall"});
+    auto b = make_target("b", {"-D", "A", "-DB", "-DA"}, {"-Wall", "-Wall"});
+
+    FlagCanonicalizer canonicalizer(false);
+    auto report = canonicalizer.canonicalize({&a, &b});
+
+    EXPECT_EQ(report.targets_considered, 2);
+    EXPECT_EQ(report.distinct_flag_sets_before, 2);
+    EXPECT_EQ(report.distinct_flag_sets_after, 1);
+    EXPECT_EQ(report.flags_removed, 3);
+    EXPECT_EQ(a.preprocessor_flags, b.preprocessor_flags);
+    EXPECT_EQ(a.compiler_flags, b.compiler_flags);
+}
+
+TEST(FlagCanonicalizerTest, CommonFlagsAreHoisted) {
+    auto a = make_target("a", {"-DSHARED", "-Iinclude", "-DONLY_A"}, {"-O2", "-Wall", "-x", "c++"});
+    auto b = make_target("b", {"-DSHARED", "-Iinclude"}, {"-Wall", "-O2", "-x", "c++"});
+
+    FlagCanonicalizer canonicalizer;
+    auto report = canonicalizer.canonicalize({&a, &b});
+
+    EXPECT_EQ(report.hoisted_preprocessor_flags, (std::vector<std::string>{"-DSHARED"}));
+    EXPECT_EQ(report.hoisted_compiler_flags, (std::vector<std::string>{"-O2", "-Wall"}));
+
+    // Include paths are package-relative and multi-token flags stay with the target
+    EXPECT_EQ(a.preprocessor_flags, (std::vector<std::string>{"-Iinclude", "-DONLY_A"}));
+    EXPECT_EQ(b.preprocessor_flags, (std::vector<std::string>{"-Iinclude"}));
+    EXPECT_EQ(b.compiler_flags, (std::vector<std::string>{"-x", "c++"}));
+}
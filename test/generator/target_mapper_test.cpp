@@ -0,0 +1,167 @@
+#include "support/temp_directory.hpp"
+#include <finch/analyzer/platforms.hpp>
+#include <finch/analyzer/project_analysis.hpp>
+#include <finch/generator/rule_templates.hpp>
+#include <finch/generator/target_mapper.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::generator;
+
+class TargetMapperTest : public ::testing::Test {
+  protected:
+    void write_source(const std::string& name, size_t bytes) {
+        temp_dir_.write(name, std::string(bytes, 'x'));
+    }
+
+    test::TempDirectory temp_dir_{"target_mapper_test"};
+};
+
+TEST_F(TargetMapperTest, PartitionBalancesBatchesBySize) {
+    std::vector<std::string> sources = {"a.cpp", "b.cpp", "c.cpp", "d.cpp"};
+    std::vector<uintmax_t> sizes = {1000, 10, 900, 100};
+
+    auto batches = TargetMapper::partition_unity_batches(sources, sizes, 2);
+    ASSERT_EQ(batches.size(), 2);
+
+    // Largest files end up in different batches
+    EXPECT_EQ(batches[0], (std::vector<std::string>{"a.cpp", "b.cpp"}));
+    EXPECT_EQ(batches[1], (std::vector<std::string>{"c.cpp", "d.cpp"}));
+}
+
+TEST_F(TargetMapperTest, PartitionWithZeroBatchSizeUsesSingleBatch) {
+    std::vector<std::string> sources = {"a.cpp", "b.cpp", "c.cpp"};
+    std::vector<uintmax_t> sizes = {1, 2, 3};
+
+    auto batches = TargetMapper::partition_unity_batches(sources, sizes, 0);
+    ASSERT_EQ(batches.size(), 1);
+    EXPECT_EQ(batches[0].size(), 3);
+}
+
+TEST_F(TargetMapperTest, UnityBuildGeneratesGenruleBatches) {
+    write_source("a.cpp", 500);
+    write_source("b.cpp", 400);
+    write_source("c.cpp", 300);
+    write_source("main.c", 10);
+
+    analyzer::Target target;
+    target.name = "core";
+    target.type = analyzer::Target::Type::StaticLibrary;
+    target.source_directory = temp_dir_.path();
+    target.sources = {"a.cpp", "b.cpp", "c.cpp", "main.c"};
+    target.include_directories = {"include"};
+    target.properties["UNITY_BUILD"] = "on"; // CMake booleans are case-insensitive
+    target.properties["UNITY_BUILD_BATCH_SIZE"] = "2";
+
+    TargetMapper mapper;
+    auto result = mapper.map_cmake_target(target);
+    ASSERT_TRUE(result.has_value());
+
+    const auto& mapped = result.value();
+    ASSERT_EQ(mapped.generated_sources.size(), 2);
+    EXPECT_EQ(mapped.generated_sources[0].name, "core__unity_cpp_0");
+    EXPECT_EQ(mapped.generated_sources[0].rule_type, Buck2RuleType::Genrule);
+
+    // The lone C source is left alone; C++ sources are replaced by batch labels
+    EXPECT_EQ(mapped.srcs, (std::vector<std::string>{"main.c", ":core__unity_cpp_0",
+                                                     ":core__unity_cpp_1"}));
+    EXPECT_EQ(mapped.properties.at("raw_headers"), R"(["a.cpp", "b.cpp", "c.cpp"])");
+    EXPECT_EQ(mapped.properties.at("include_directories"), R"(["include", "."])");
+
+    GenruleTemplate genrule_template;
+    auto rule = genrule_template.generate(mapped.generated_sources[0]);
+    EXPECT_NE(rule.find("genrule("), std::string::npos);
+    EXPECT_NE(rule.find("'a.cpp'"), std::string::npos);
+    EXPECT_NE(rule.find("out = \"core__unity_cpp_0.cpp\""), std::string::npos);
+}
+
+TEST_F(TargetMapperTest, TargetsWithoutUnityBuildAreUnchanged) {
+    analyzer::Target target;
+    target.name = "plain";
+    target.type = analyzer::Target::Type::StaticLibrary;
+    target.sources = {"a.cpp", "b.cpp"};
+    target.properties["UNITY_BUILD"] = "Off";
+
+    TargetMapper mapper;
+    auto result = mapper.map_cmake_target(target);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_TRUE(result.value().generated_sources.empty());
+    EXPECT_EQ(result.value().srcs, (std::vector<std::string>{"a.cpp", "b.cpp"}));
+}
+
+TEST_F(TargetMapperTest, ExternalLibrariesBecomeLinkerFlags) {
+    // As the File API and ninja readers report a target: other targets by
+    // name, system libraries as the linker takes them
+    analyzer::Target app;
+    app.name = "app";
+    app.type = analyzer::Target::Type::ExecutableTarget;
+    app.confidence = analyzer::Target::Confidence::Certain;
+    app.sources = {"main.cpp"};
+    app.link_libraries = {"core"};
+    app.link_flags = {"-lpthread", "/usr/lib/x86_64-linux-gnu/libz.so"};
+
+    TargetMapper mapper;
+    auto result = mapper.map_cmake_target(app);
+    ASSERT_TRUE(result.has_value());
+    EXPECT_EQ(result.value().deps, (std::vector<std::string>{":core"}));
+    EXPECT_EQ(result.value().properties.at("linker_flags"),
+              R"(["-lpthread", "/usr/lib/x86_64-linux-gnu/libz.so"])");
+
+    analyzer::Target core;
+    core.name = "core";
+    core.type = analyzer::Target::Type::StaticLibrary;
+    core.sources = {"core.cpp"};
+    core.link_flags = {"-ldl"};
+
+    auto library = mapper.map_cmake_target(core);
+    ASSERT_TRUE(library.has_value());
+    EXPECT_TRUE(library.value().deps.empty());
+    EXPECT_FALSE(library.value().properties.contains("linker_flags"));
+    EXPECT_EQ(library.value().properties.at("exported_linker_flags"), R"(["-ldl"])");
+}
+
+TEST_F(TargetMapperTest, GeneratorExpressionSourcesBecomeSelects) {
+    analyzer::Target target;
+    target.name = "portable";
+    target.type = analyzer::Target::Type::StaticLibrary;
+    target.sources = {"common.cpp", "$<$<PLATFORM_ID:Linux>:linux.cpp>",
+                      "$<$<NOT:$<PLATFORM_ID:Windows>>:posix.cpp>",
+                      "$<BUILD_INTERFACE:build.cpp>"};
+    target.link_libraries = {"$<INSTALL_INTERFACE:installed>", "$<$<CONFIG:Debug>:debug>"};
+
+    TargetMapper mapper;
+    auto result = mapper.map_cmake_target(target);
+    ASSERT_TRUE(result.has_value());
+    const auto& mapped = result.value();
+    EXPECT_EQ(mapped.srcs, (std::vector<std::string>{"common.cpp", "build.cpp"}));
+    EXPECT_TRUE(mapped.deps.empty());
+
+    ASSERT_TRUE(mapped.platform_selects.contains("srcs"));
+    std::map<std::string, std::string> clauses;
+    for (const auto& clause : mapped.platform_selects.at("srcs").clauses) {
+        clauses[clause.condition] = clause.value;
+    }
+    EXPECT_EQ(clauses, (std::map<std::string, std::string>{
+                           {"config//os:linux", "[\"linux.cpp\", \"posix.cpp\"]"},
+                           {"config//os:macos", "[\"posix.cpp\"]"}}));
+    EXPECT_FALSE(mapped.platform_selects.contains("deps"));
+}
+
+TEST_F(TargetMapperTest, GeneratorExpressionsAreLoweredForTheRunsPlatforms) {
+    analyzer::Target target;
+    target.name = "portable";
+    target.type = analyzer::Target::Type::StaticLibrary;
+    target.sources = {"common.cpp", "$<$<PLATFORM_ID:Windows>:win.cpp>",
+                      "$<$<PLATFORM_ID:Linux>:linux.cpp>"};
+
+    auto platforms = analyzer::PlatformSet::from_names({"linux"});
+    ASSERT_TRUE(platforms.has_value());
+    TargetMapper mapper;
+    mapper.set_platforms(&platforms.value());
+    auto result = mapper.map_cmake_target(target);
+    ASSERT_TRUE(result.has_value());
+
+    // With Linux alone every platform agrees, so nothing is left to select
+    EXPECT_EQ(result.value().srcs, (std::vector<std::string>{"common.cpp", "linux.cpp"}));
+    EXPECT_FALSE(result.value().platform_selects.contains("srcs"));
+}
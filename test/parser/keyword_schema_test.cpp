@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <finch/analyzer/cmake_evaluator.hpp>
+#include <finch/parser/ast/cpm_nodes.hpp>
+#include <finch/parser/ast/structure.hpp>
+#include <finch/parser/keyword_schema.hpp>
+#include <finch/parser/parser.hpp>
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+#include <map>
+
+using namespace finch;
+using namespace finch::parser;
+
+namespace {
+
+constexpr KeywordSchema<4> SCHEMA({{
+    {"QUIET", KeywordKind::Option},
+    {"NAME", KeywordKind::OneValue},
+    {"SOURCES", KeywordKind::MultiValue},
+    {"LIBS", KeywordKind::MultiValue},
+}});
+constexpr size_t QUIET = SCHEMA.slot("QUIET");
+constexpr size_t NAME = SCHEMA.slot("NAME");
+constexpr size_t SOURCES = SCHEMA.slot("SOURCES");
+constexpr size_t LIBS = SCHEMA.slot("LIBS");
+
+static_assert(SCHEMA.find("SOURCES") == SOURCES);
+static_assert(!SCHEMA.find("sources"));
+static_assert(!SCHEMA.find("NAMES"));
+
+std::vector<std::string> words_at(const std::vector<std::string>& words,
+                                  std::span<const uint32_t> positions) {
+    std::vector<std::string> result;
+    for (auto position : positions) {
+        result.push_back(words[position]);
+    }
+    return result;
+}
+
+std::vector<analyzer::Target> evaluate_targets(const std::string& source) {
+    Parser parser(source, "CMakeLists.txt");
+    auto file = parser.parse_file();
+    EXPECT_TRUE(file.has_value());
+    if (!file.has_value()) {
+        return {};
+    }
+    analyzer::CMakeFileEvaluator evaluator;
+    auto analysis = evaluator.analyze(*file.value());
+    EXPECT_TRUE(analysis.has_value());
+    return analysis.has_value() ? analysis.value().targets : std::vector<analyzer::Target>{};
+}
+
+} // namespace
+
+TEST(KeywordSchemaTest, PartitionsLikeCMakeParseArguments) {
+    std::vector<std::string> words = {"first", "NAME",    "x",    "extra", "SOURCES", "a.cpp",
+                                      "b.cpp", "QUIET",   "loose", "LIBS",  "SOURCES", "c.cpp",
+                                      "NAME",  "y"};
+    auto parsed = SCHEMA.partition(words);
+
+    EXPECT_TRUE(parsed.has(QUIET));
+    EXPECT_TRUE(parsed.has(LIBS));
+    EXPECT_TRUE(parsed.values(LIBS).empty());
+    EXPECT_EQ(words[*parsed.value(NAME)], "y");
+    EXPECT_EQ(words_at(words, parsed.values(NAME)), (std::vector<std::string>{"x", "y"}));
+    EXPECT_EQ(words_at(words, parsed.values(SOURCES)),
+              (std::vector<std::string>{"a.cpp", "b.cpp", "c.cpp"}));
+    EXPECT_EQ(words_at(words, parsed.positional()),
+              (std::vector<std::string>{"first", "extra", "loose"}));
+
+    // Call order across slots
+    auto merged = parsed.values({decltype(parsed)::positional_slot, SOURCES});
+    EXPECT_EQ(words_at(words, merged),
+              (std::vector<std::string>{"first", "extra", "a.cpp", "b.cpp", "loose", "c.cpp"}));
+
+    // Leading words are never keywords
+    std::vector<std::string> named = {"NAME", "SOURCES", "a.cpp"};
+    auto leading = SCHEMA.partition(named, 1);
+    EXPECT_FALSE(leading.has(NAME));
+    EXPECT_EQ(words_at(named, leading.positional()), (std::vector<std::string>{"NAME"}));
+    EXPECT_EQ(leading.values(SOURCES).size(), 1);
+}
+
+TEST(KeywordSchemaTest, TargetCommandsReadTheirItemsInCallOrder) {
+    auto targets = evaluate_targets(R"(
+        set(CORE_SOURCES core.cpp util.cpp)
+        add_library(core SHARED EXCLUDE_FROM_ALL ${CORE_SOURCES} extra.cpp)
+        add_library(core_alias ALIAS core)
+        add_library(fmt::fmt UNKNOWN IMPORTED)
+        add_executable(app WIN32 main.cpp)
+        target_link_libraries(app PUBLIC core PRIVATE fmt::fmt PUBLIC z)
+        target_include_directories(app SYSTEM BEFORE PRIVATE include INTERFACE api)
+        target_compile_definitions(app PUBLIC A=1 PRIVATE B)
+        set_target_properties(core app PROPERTIES CXX_STANDARD 20 OUTPUT_NAME "x;y")
+    )");
+    ASSERT_EQ(targets.size(), 4);
+
+    const auto& core = targets[0];
+    EXPECT_EQ(core.type, analyzer::Target::Type::SharedLibrary);
+    EXPECT_EQ(core.sources, (PathList{"core.cpp", "util.cpp", "extra.cpp"}));
+    EXPECT_EQ(core.properties.at("CXX_STANDARD"), "20");
+    EXPECT_TRUE(targets[1].sources.empty());
+    EXPECT_EQ(targets[1].link_libraries, (std::vector<std::string>{"core"}));
+    EXPECT_TRUE(targets[2].sources.empty());
+
+    const auto& app = targets[3];
+    EXPECT_EQ(app.sources, (PathList{"main.cpp"}));
+    EXPECT_EQ(app.link_libraries, (std::vector<std::string>{"core", "fmt::fmt", "z"}));
+    EXPECT_EQ(app.include_directories, (PathList{"include", "api"}));
+    EXPECT_EQ(app.compile_definitions, (std::vector<std::string>{"A=1", "B"}));
+    EXPECT_EQ(app.properties.at("OUTPUT_NAME"), "x;y");
+}
+
+TEST(KeywordSchemaTest, CPMCommandsReadKeywordsFromOnePartition) {
+    Parser parser(R"(
+        CPMAddPackage(
+          NAME fmt
+          GIT_TAG 10.2.1
+          VERSION 10.2.1
+          GITHUB_REPOSITORY fmtlib/fmt
+          OPTIONS "FMT_INSTALL ON" FMT_DOC OFF
+          GIT_SHALLOW TRUE
+          EXCLUDE_FROM_ALL YES)
+        CPMFindPackage(NAME Boost VERSION 1.84 COMPONENTS system filesystem REQUIRED)
+    )",
+                  "CMakeLists.txt");
+    auto file = parser.parse_file();
+    ASSERT_TRUE(file.has_value());
+    const auto& statements = file.value()->statements();
+    ASSERT_EQ(statements.size(), 2);
+
+    const auto* add = dynamic_cast<const ast::CPMAddPackage*>(statements[0].get());
+    ASSERT_NE(add, nullptr);
+    EXPECT_EQ(add->name(), "fmt");
+    EXPECT_EQ(add->source(), "fmtlib/fmt");
+    ASSERT_TRUE(add->version().has_value());
+    EXPECT_EQ(add->version()->version, "10.2.1");
+    EXPECT_EQ(add->version()->git_tag, "10.2.1");
+    EXPECT_EQ(add->options(), (std::map<std::string, std::string>{{"FMT_DOC", "OFF"},
+                                                                 {"FMT_INSTALL", "ON"}}));
+
+    const auto* find = dynamic_cast<const ast::CPMFindPackage*>(statements[1].get());
+    ASSERT_NE(find, nullptr);
+    EXPECT_EQ(find->name(), "Boost");
+    EXPECT_EQ(find->components(), (std::vector<std::string>{"system", "filesystem"}));
+}
+
+TEST(KeywordSchemaTest, ArgumentHeavyCallsKeepEveryItem) {
+    // A generated target_link_libraries() with thousands of items; timings
+    // are in examples/keyword_schema_benchmark
+    constexpr size_t items = 50000;
+    std::vector<std::string> words = {"app"};
+    const char* visibilities[] = {"PUBLIC", "PRIVATE", "INTERFACE"};
+    for (size_t i = 0; i < items; ++i) {
+        if (i % 100 == 0) {
+            words.emplace_back(visibilities[(i / 100) % 3]);
+        }
+        words.push_back(fmt::format("lib{}", i));
+    }
+
+    constexpr KeywordSchema<3> usage({{
+        {"PUBLIC", KeywordKind::MultiValue},
+        {"PRIVATE", KeywordKind::MultiValue},
+        {"INTERFACE", KeywordKind::MultiValue},
+    }});
+    auto parsed = usage.partition(words, 1);
+    auto merged = parsed.values({0, 1, 2});
+    ASSERT_EQ(merged.size(), items);
+    EXPECT_TRUE(std::is_sorted(merged.begin(), merged.end()));
+    EXPECT_EQ(words[merged.back()], fmt::format("lib{}", items - 1));
+
+    // The evaluator reads the same call without rescanning per keyword
+    std::string source = "add_executable(app main.cpp)\ntarget_link_libraries(";
+    for (const auto& word : words) {
+        source += word + " ";
+    }
+    source += ")\n";
+    auto targets = evaluate_targets(source);
+    ASSERT_EQ(targets.size(), 1);
+    EXPECT_EQ(targets[0].link_libraries.size(), items);
+    EXPECT_EQ(targets[0].link_libraries.back(), fmt::format("lib{}", items - 1));
+}
@@ -0,0 +1,134 @@
+#include <finch/parser/ast/builder.hpp>
+#include <finch/parser/ast/structural_hash.hpp>
+#include <finch/parser/parser.hpp>
+#include <gtest/gtest.h>
+
+using namespace finch;
+using namespace finch::ast;
+
+namespace {
+
+// Parses code into a File whose parser, owning its strings, lives as long
+// as the test
+class StructuralHashTest : public ::testing::Test {
+  protected:
+    std::unique_ptr<File> parse(std::string_view code, const std::string& filename) {
+        auto& parser = parsers_.emplace_back(std::make_unique<parser::Parser>(code, filename));
+        auto result = parser->parse_file();
+        EXPECT_TRUE(result.has_value());
+        return result.has_value() ? std::move(result.value()) : nullptr;
+    }
+
+  private:
+    std::vector<std::unique_ptr<parser::Parser>> parsers_;
+};
+
+// add_library(<name> STATIC <source>), built without the parser
+ASTNodePtr make_library(ASTBuilder& builder, SourceLocation loc, std::string_view name,
+                        std::string_view source) {
+    return builder.makeCommand(loc, "add_library",
+                               ASTBuilder::makeList(builder.makeString(loc, name, false),
+                                                    builder.makeIdentifier(loc, "STATIC"),
+                                                    builder.makeString(loc, source, false)));
+}
+
+} // namespace
+
+TEST_F(StructuralHashTest, LocationsAreIgnored) {
+    ASTBuilder builder;
+    auto first = builder.makeFile({"one/CMakeLists.txt", 1, 1}, "one/CMakeLists.txt",
+                                  ASTBuilder::makeList(make_library(
+                                      builder, {"one/CMakeLists.txt", 1, 1}, "core", "a.cpp")));
+    auto second = builder.makeFile({"two/CMakeLists.txt", 1, 1}, "two/CMakeLists.txt",
+                                   ASTBuilder::makeList(make_library(
+                                       builder, {"two/CMakeLists.txt", 9, 3}, "core", "a.cpp")));
+
+    EXPECT_NE(first->structural_hash(), 0);
+    EXPECT_EQ(first->structural_hash(), second->structural_hash());
+    EXPECT_TRUE(structurally_equal(*first, *second));
+}
+
+TEST_F(StructuralHashTest, ContentChangesTheHash) {
+    ASTBuilder builder;
+    SourceLocation loc{"CMakeLists.txt", 1, 1};
+    auto core = make_library(builder, loc, "core", "a.cpp");
+    auto other_source = make_library(builder, loc, "core", "b.cpp");
+    auto quoted = builder.makeCommand(
+        loc, "add_library",
+        ASTBuilder::makeList(builder.makeString(loc, "core", true),
+                             builder.makeIdentifier(loc, "STATIC"),
+                             builder.makeString(loc, "a.cpp", false)));
+
+    EXPECT_NE(core->structural_hash(), other_source->structural_hash());
+    EXPECT_NE(core->structural_hash(), quoted->structural_hash());
+    EXPECT_FALSE(structurally_equal(*core, *other_source));
+}
+
+TEST_F(StructuralHashTest, BuilderHashesMatchAFreshComputation) {
+    auto file = parse(R"cmake(
+        function(add_module name)
+            if(WIN32)
+                add_library(${name} STATIC win.cpp)
+            elseif(APPLE)
+                add_library(${name} STATIC mac.cpp)
+            else()
+                add_library(${name} STATIC posix.cpp)
+            endif()
+        endfunction()
+    )cmake",
+                      "CMakeLists.txt");
+    ASSERT_TRUE(file);
+    ASSERT_EQ(file->statements().size(), 1);
+
+    const auto& function = dynamic_cast<const FunctionDef&>(*file->statements()[0]);
+    ASSERT_EQ(function.body().size(), 1);
+    const auto& branch = *function.body()[0];
+    EXPECT_EQ(branch.structural_hash(), compute_structural_hash(branch));
+    EXPECT_EQ(function.structural_hash(), compute_structural_hash(function));
+    EXPECT_EQ(file->structural_hash(), compute_structural_hash(*file));
+}
+
+TEST_F(StructuralHashTest, ElseIfBranchesAreHashed) {
+    auto apple = parse("if(WIN32)\n  set(A 1)\nelseif(APPLE)\n  set(A 2)\nendif()\n", "a.cmake");
+    auto other = parse("if(WIN32)\n  set(A 1)\nelseif(LINUX)\n  set(A 2)\nendif()\n", "b.cmake");
+    ASSERT_TRUE(apple && other);
+    EXPECT_NE(apple->structural_hash(), other->structural_hash());
+}
+
+TEST_F(StructuralHashTest, EqualSubtreesAreMeasuredAsShared) {
+    ASTBuilder builder;
+    auto first = make_library(builder, {"a/CMakeLists.txt", 3, 1}, "core", "a.cpp");
+    auto second = make_library(builder, {"b/CMakeLists.txt", 7, 5}, "core", "a.cpp");
+    auto other = make_library(builder, {"b/CMakeLists.txt", 8, 5}, "util", "a.cpp");
+
+    SubtreeSharingMeter meter;
+    meter.measure(*first);
+    meter.measure(*second);
+    auto stats = meter.stats();
+    EXPECT_EQ(stats.nodes, 8);
+    EXPECT_EQ(stats.shared_nodes, 4);
+    EXPECT_EQ(stats.bytes_saved, subtree_bytes(*first));
+
+    // Only the command and its name differ; STATIC and a.cpp were seen
+    meter.measure(*other);
+    EXPECT_EQ(meter.stats().nodes, 12);
+    EXPECT_EQ(meter.stats().shared_nodes, 6);
+}
+
+TEST_F(StructuralHashTest, MeasureCountsSharedSubtrees) {
+    auto first = parse("add_library(core STATIC a.cpp)\nset(X 1)\n", "a.cmake");
+    auto second = parse("set(X 1)\nadd_library(core STATIC a.cpp)\n", "b.cmake");
+    ASSERT_TRUE(first && second);
+
+    SubtreeSharingMeter meter;
+    meter.measure(*first);
+    auto before = meter.stats();
+    EXPECT_EQ(before.bytes_saved, 0);
+
+    // Both statements of the second file were seen in the first
+    meter.measure(*second);
+    auto after = meter.stats();
+    EXPECT_EQ(after.shared_nodes, before.nodes - 1);
+    EXPECT_EQ(after.bytes_saved, subtree_bytes(*second->statements()[0]) +
+                                     subtree_bytes(*second->statements()[1]));
+}
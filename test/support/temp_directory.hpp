@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+
+namespace finch::test {
+
+/// A fresh directory under the system temp directory for one test, removed
+/// with its contents when the test ends. Its name ends in a suffix unique to
+/// the process and the object, so concurrent test runs never share one.
+class TempDirectory {
+  public:
+    explicit TempDirectory(std::string_view name) : path_(unique_path(name)) {
+        std::filesystem::create_directories(path_);
+    }
+
+    ~TempDirectory() {
+        std::error_code ignored;
+        std::filesystem::remove_all(path_, ignored);
+    }
+
+    TempDirectory(const TempDirectory&) = delete;
+    TempDirectory& operator=(const TempDirectory&) = delete;
+
+    [[nodiscard]] const std::filesystem::path& path() const {
+        return path_;
+    }
+
+    [[nodiscard]] std::filesystem::path operator/(const std::filesystem::path& relative) const {
+        return path_ / relative;
+    }
+
+    /// Write content to relative, creating its parent directories
+    std::filesystem::path write(const std::filesystem::path& relative,
+                                std::string_view content = "") const {
+        auto path = path_ / relative;
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::binary) << content;
+        return path;
+    }
+
+  private:
+    static std::filesystem::path unique_path(std::string_view name) {
+        static const uint64_t process = std::random_device{}();
+        static std::atomic<uint64_t> counter = 0;
+        return std::filesystem::temp_directory_path() /
+               fmt::format("finch_{}_{:x}_{}", name, process, counter++);
+    }
+
+    std::filesystem::path path_;
+};
+
+} // namespace finch::test